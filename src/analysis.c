@@ -0,0 +1,340 @@
+/**
+ * analysis.c
+ *
+ * Responsibilities:
+ * - Own a second Engine that analyses the position on the board while the user plays.
+ * - Run it on a background thread, restart it whenever the position changes and hand
+ *   every completed iteration to the renderer.
+ *
+ * Notes:
+ * - The analysis uses half of the cores (at least one) unless ANALYSIS_THREADS sets a
+ *   count, and searches up to ANALYSIS_MAX_DEPTH; it runs next to the engine opponent,
+ *   which has its own Engine and table.
+ * - The transposition table is kept between positions: after a move most of what was
+ *   learned about the previous position still applies.
+ *
+ * Implementation Details:
+ * - Cancelling never blocks: SetCurrentPosition and LoadGameFromFEN call CancelAnalysis,
+ *   which only raises the running search's stop flag (SearchLimits.stop). UpdateAnalysis
+ *   joins the thread on a later frame once it has finished and starts the next search.
+ *   Each search gets a freshly cleared flag, so a stop raised while a thread is already
+ *   leaving Search cannot end the next one early.
+ * - Results travel through a lock-free triple buffer: the search thread fills the back
+ *   snapshot and swaps it with the middle one (marking it fresh); the renderer swaps the
+ *   middle one with its front snapshot when it is fresh. Neither side ever waits and the
+ *   renderer always reads a complete snapshot. Only one search thread exists at a time
+ *   and pthread_create/pthread_join order consecutive writers.
+ */
+
+#include "analysis.h"
+#include "hash.h"
+#include "main.h"
+#include "move.h"
+#include "position.h"
+#include "raylib.h"
+#include "search.h"
+#include "settings.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/* Set in MiddleSnapshot when the middle buffer holds a snapshot the renderer has not taken yet */
+#define SNAPSHOT_FRESH 4
+#define SNAPSHOT_INDEX_MASK 3
+
+static Engine AnalysisEngine;
+static bool AnalysisReady = false;
+static bool AnalysisEnabled = false;
+
+/* Background search (see Implementation Details); main thread only unless noted */
+static pthread_t AnalysisThread;
+static bool AnalysisRunning = false;
+static bool AnalysisDone = false;   /* the search of AnalysisRoot ended by itself */
+static atomic_bool AnalysisFinished; /* set by the analysis thread */
+static atomic_bool AnalysisStop;     /* SearchLimits.stop of the running search */
+static Position AnalysisRoot;
+static uint64_t AnalysisHistory[MAX_REPETITION_WINDOW];
+static int AnalysisHistoryCount = 0;
+static SearchResult AnalysisOutput; /* analysis thread only */
+
+/* Triple buffer */
+static AnalysisSnapshot Snapshots[3];
+static atomic_int MiddleSnapshot;
+static int BackSnapshot = 1;  /* analysis thread */
+static int FrontSnapshot = 0; /* main thread */
+
+// Local prototypes
+static void StartAnalysis(void);
+static void *AnalysisThreadMain(void *arg);
+static void PublishIteration(const SearchResult *result, void *userData);
+static void StopAnalysis(void);
+
+/**
+ * InitializeAnalysis
+ *
+ * Returns:
+ *  - false if the engine could not be allocated (the analysis then stays unavailable).
+ */
+bool InitializeAnalysis(void)
+{
+    AnalysisReady = InitializeEngine(&AnalysisEngine, ANALYSIS_TT_MEGABYTES);
+
+    if (!AnalysisReady)
+    {
+        TraceLog(LOG_WARNING, "Failed to allocate the analysis transposition table");
+        return false;
+    }
+
+    int threads = ANALYSIS_THREADS;
+    if (threads <= 0)
+    {
+        threads = AvailableCores() / 2;
+        if (threads < 1)
+        {
+            threads = 1;
+        }
+    }
+
+    if (!SetEngineThreads(&AnalysisEngine, threads))
+    {
+        TraceLog(LOG_WARNING, "Analysis: could not start %d search threads", threads);
+    }
+    SetSearchCallback(&AnalysisEngine, PublishIteration, NULL);
+    atomic_init(&MiddleSnapshot, 2);
+    TraceLog(LOG_INFO, "Analysis: %d search thread(s)", AnalysisEngine.threadCount);
+
+    return true;
+}
+
+/**
+ * FreeAnalysis
+ */
+void FreeAnalysis(void)
+{
+    if (AnalysisReady)
+    {
+        StopAnalysis();
+        FreeEngine(&AnalysisEngine);
+        AnalysisReady = false;
+        AnalysisEnabled = false;
+    }
+}
+
+/**
+ * ToggleAnalysis
+ *
+ * Switching off waits for the search thread (it stops within a few thousand nodes), so
+ * no CPU is spent on hints that are not shown.
+ */
+void ToggleAnalysis(void)
+{
+    if (!AnalysisReady)
+    {
+        return;
+    }
+
+    AnalysisEnabled = !AnalysisEnabled;
+    if (!AnalysisEnabled)
+    {
+        StopAnalysis();
+    }
+
+    TraceLog(LOG_INFO, "Analysis %s", AnalysisEnabled ? "on" : "off");
+}
+
+/**
+ * IsAnalysisEnabled
+ */
+bool IsAnalysisEnabled(void)
+{
+    return AnalysisEnabled;
+}
+
+/**
+ * IsAnalysisSearching
+ *
+ * Notes:
+ *  - Stays true for the frame after the thread ends, so the frame that collects the last
+ *    snapshot is still drawn.
+ */
+bool IsAnalysisSearching(void)
+{
+    return AnalysisRunning;
+}
+
+/**
+ * CancelAnalysis
+ *
+ * Behavior:
+ *  - Raises the stop flag of the running search, if any, and returns immediately.
+ *  - Safe to call at any time, also when the analysis is off or not initialized.
+ */
+void CancelAnalysis(void)
+{
+    if (AnalysisRunning)
+    {
+        atomic_store(&AnalysisStop, true);
+    }
+}
+
+/**
+ * UpdateAnalysis
+ *
+ * Behavior:
+ *  - While a search runs: stops it if the board left its position, otherwise returns.
+ *  - Once it has finished: joins the thread; a search that was not stopped has analysed
+ *    its position to the end (depth limit, forced mate or no legal move) and is not
+ *    started again for the same position.
+ *  - Starts a search of the current position when none is running.
+ */
+void UpdateAnalysis(void)
+{
+    if (!AnalysisReady || !AnalysisEnabled)
+    {
+        return;
+    }
+
+    if (AnalysisRunning)
+    {
+        if (!atomic_load(&AnalysisFinished))
+        {
+            if (AnalysisRoot.key != state.zobristKey)
+            {
+                atomic_store(&AnalysisStop, true);
+            }
+            return;
+        }
+
+        pthread_join(AnalysisThread, NULL);
+        AnalysisRunning = false;
+        AnalysisDone = !atomic_load(&AnalysisStop);
+    }
+
+    if (AnalysisDone && AnalysisRoot.key == state.zobristKey)
+    {
+        return;
+    }
+
+    StartAnalysis();
+}
+
+/**
+ * CurrentAnalysis
+ *
+ * Returns:
+ *  - The newest snapshot if it belongs to the position on the board, otherwise NULL.
+ *    The pointer stays valid until the next call.
+ */
+const AnalysisSnapshot *CurrentAnalysis(void)
+{
+    if (!AnalysisEnabled)
+    {
+        return NULL;
+    }
+
+    if (atomic_load_explicit(&MiddleSnapshot, memory_order_relaxed) & SNAPSHOT_FRESH)
+    {
+        FrontSnapshot = atomic_exchange_explicit(&MiddleSnapshot, FrontSnapshot, memory_order_acq_rel) & SNAPSHOT_INDEX_MASK;
+    }
+
+    const AnalysisSnapshot *snapshot = &Snapshots[FrontSnapshot];
+    if (snapshot->depth == 0 || snapshot->key != state.zobristKey)
+    {
+        return NULL;
+    }
+
+    return snapshot;
+}
+
+/**
+ * StartAnalysis (static)
+ *
+ * Copy the current position and the repetition history for the analysis thread and
+ * start it. If the thread cannot be created the analysis is switched off.
+ */
+static void StartAnalysis(void)
+{
+    AnalysisRoot = CurrentPosition(&state);
+    AnalysisDone = false;
+
+    // The DHA ends with the current position; the search wants only the positions before it
+    int count = (int)state.DHA->size;
+    if (count > 0 && state.DHA->hashArray[count - 1] == AnalysisRoot.key)
+    {
+        count--;
+    }
+
+    AnalysisHistoryCount = (count > MAX_REPETITION_WINDOW) ? MAX_REPETITION_WINDOW : count;
+    memcpy(AnalysisHistory, state.DHA->hashArray + (count - AnalysisHistoryCount), sizeof(uint64_t) * (size_t)AnalysisHistoryCount);
+
+    atomic_store(&AnalysisFinished, false);
+    atomic_store(&AnalysisStop, false);
+    if (pthread_create(&AnalysisThread, NULL, AnalysisThreadMain, NULL) != 0)
+    {
+        TraceLog(LOG_WARNING, "Analysis: could not start the search thread, analysis off");
+        AnalysisEnabled = false;
+        return;
+    }
+
+    AnalysisRunning = true;
+}
+
+/**
+ * AnalysisThreadMain (static)
+ *
+ * Body of the analysis thread: one Search of AnalysisRoot until the depth limit or a stop.
+ */
+static void *AnalysisThreadMain(void *arg)
+{
+    (void)arg;
+    SearchLimits limits = {.depth = ANALYSIS_MAX_DEPTH, .stop = &AnalysisStop};
+
+    Search(&AnalysisEngine, &AnalysisRoot, AnalysisHistory, AnalysisHistoryCount, &limits, &AnalysisOutput);
+    atomic_store(&AnalysisFinished, true);
+
+    return NULL;
+}
+
+/**
+ * PublishIteration (static)
+ *
+ * Search callback (runs on the analysis thread): write the iteration into the back
+ * snapshot and publish it as the fresh middle one.
+ */
+static void PublishIteration(const SearchResult *result, void *userData)
+{
+    (void)userData;
+    AnalysisSnapshot *snapshot = &Snapshots[BackSnapshot];
+
+    snapshot->key = AnalysisRoot.key;
+    snapshot->depth = result->depth;
+    snapshot->score = (AnalysisRoot.side == TEAM_WHITE) ? result->score : -result->score;
+    snapshot->bestMove = result->bestMove;
+    snapshot->pvLength = result->pvLength;
+    memcpy(snapshot->pv, result->pv, sizeof(ChessMove) * (size_t)result->pvLength);
+    snapshot->nodes = result->nodes;
+    snapshot->seconds = result->seconds;
+
+    BackSnapshot = atomic_exchange_explicit(&MiddleSnapshot, BackSnapshot | SNAPSHOT_FRESH, memory_order_acq_rel) & SNAPSHOT_INDEX_MASK;
+}
+
+/**
+ * StopAnalysis (static)
+ *
+ * Stop a running search and wait for its thread.
+ */
+static void StopAnalysis(void)
+{
+    if (!AnalysisRunning)
+    {
+        return;
+    }
+
+    atomic_store(&AnalysisStop, true);
+    pthread_join(AnalysisThread, NULL);
+    AnalysisRunning = false;
+    AnalysisDone = false;
+}
@@ -0,0 +1,66 @@
+/**
+ * analysis.h
+ *
+ * Responsibilities:
+ * - Export the background analysis: a second engine searches whatever position the board
+ *   shows, on its own thread, and reports its best line for the eval bar and the
+ *   best-move arrow (draw.c).
+ * - Every function here is called from the main thread; the renderer reads the latest
+ *   result with CurrentAnalysis once per frame without ever blocking on the search.
+ */
+
+#ifndef ANALYSIS_H
+#define ANALYSIS_H
+
+#include "movegen.h"
+#include "search.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * AnalysisSnapshot
+ *
+ * One completed iteration of the analysis search.
+ *
+ * - key: Zobrist key of the analysed position; compare it with state.zobristKey before
+ *   showing the snapshot, it may describe a position the board has already left.
+ * - score: centipawns from White's point of view (a mate keeps the MATE_SCORE encoding).
+ * - depth: 0 while nothing has been published yet.
+ */
+typedef struct AnalysisSnapshot
+{
+    uint64_t key;
+    int depth;
+    int score;
+    ChessMove bestMove;
+    ChessMove pv[MAX_SEARCH_PLY];
+    int pvLength;
+    uint64_t nodes;
+    double seconds;
+} AnalysisSnapshot;
+
+/* Allocates the analysis engine. Returns false if its transposition table could not be allocated */
+bool InitializeAnalysis(void);
+
+/* Stops the analysis thread and frees the engine */
+void FreeAnalysis(void);
+
+/* Switches the analysis (and the hints drawn from it) on or off */
+void ToggleAnalysis(void);
+
+/* Returns true while the analysis is switched on */
+bool IsAnalysisEnabled(void);
+
+/* Returns true while an analysis search runs or its end has not been collected by UpdateAnalysis yet */
+bool IsAnalysisSearching(void);
+
+/* Tells a running analysis that the position changed; returns at once, the thread ends within a few thousand nodes */
+void CancelAnalysis(void);
+
+/* Restarts the analysis once the board shows a position other than the analysed one (call once per frame) */
+void UpdateAnalysis(void);
+
+/* Latest snapshot of the current position, or NULL if there is none (analysis off, or nothing found yet) */
+const AnalysisSnapshot *CurrentAnalysis(void);
+
+#endif /* ANALYSIS_H */
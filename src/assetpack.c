@@ -0,0 +1,214 @@
+/**
+ * assetpack.c
+ *
+ * Responsibilities:
+ * - Build step of the GUI: decode every asset the game loads at startup and write the
+ *   pixels and samples into one asset pack (see assets.h), which the game maps instead
+ *   of decoding PNG and MP3 files.
+ *
+ * Usage:
+ *   assetpack [OUTPUT]    (default ASSET_PACK_PATH; run from the project root)
+ *
+ * Notes:
+ * - Needs raylib for the decoders but opens no window and no audio device.
+ * - The piece sprites are stored as the composed atlas (BuildPieceAtlasImage), so the
+ *   game uploads one image without composing it.
+ * - The pack is written to OUTPUT.tmp and renamed, so a game starting during the build
+ *   never maps a half-written pack.
+ */
+
+#include "assets.h"
+#include "atlas.h"
+#include "raylib.h"
+#include "settings.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Decoded files, named by their path (also their name in the pack) */
+static const char *const PackedImages[] = {"assets/icon.png"};
+static const char *const PackedWaves[] = {
+    "assets/sound/Capture.mp3",
+    "assets/sound/Check.mp3",
+    "assets/sound/Checkmate.mp3",
+    "assets/sound/Move.mp3",
+};
+
+#define PACKED_IMAGE_COUNT (sizeof PackedImages / sizeof PackedImages[0])
+#define PACKED_WAVE_COUNT (sizeof PackedWaves / sizeof PackedWaves[0])
+#define PACKED_ASSET_COUNT (PACKED_IMAGE_COUNT + 1 + PACKED_WAVE_COUNT)
+
+// Local prototypes
+static bool AddImage(AssetPackEntry *entry, const void **data, const char *name, Image image);
+static bool AddWave(AssetPackEntry *entry, const void **data, const char *name, Wave wave);
+static bool WritePack(const char *path, AssetPackEntry *entries, const void **data, uint32_t count);
+
+int main(int argc, char **argv)
+{
+    const char *output = (argc > 1) ? argv[1] : ASSET_PACK_PATH;
+    AssetPackEntry entries[PACKED_ASSET_COUNT];
+    const void *data[PACKED_ASSET_COUNT];
+    Image images[PACKED_IMAGE_COUNT + 1];
+    Wave waves[PACKED_WAVE_COUNT];
+    uint32_t count = 0;
+    bool ok = true;
+
+    if (argc > 2)
+    {
+        fprintf(stderr, "Usage: %s [OUTPUT]\n", argv[0]);
+        return 1;
+    }
+
+    SetTraceLogLevel(LOG_WARNING);
+    memset(entries, 0, sizeof entries);
+
+    for (size_t i = 0; i < PACKED_IMAGE_COUNT; i++)
+    {
+        images[i] = LoadImage(PackedImages[i]);
+        ok = ok && AddImage(&entries[count], &data[count], PackedImages[i], images[i]);
+        count++;
+    }
+
+    images[PACKED_IMAGE_COUNT] = BuildPieceAtlasImage();
+    ok = ok && AddImage(&entries[count], &data[count], PIECE_ATLAS_ASSET, images[PACKED_IMAGE_COUNT]);
+    count++;
+
+    for (size_t i = 0; i < PACKED_WAVE_COUNT; i++)
+    {
+        // 16-bit samples: half the size of the decoder's floats, converted once by LoadSoundFromWave
+        waves[i] = LoadWave(PackedWaves[i]);
+        if (waves[i].data != NULL && waves[i].sampleSize != 16)
+        {
+            WaveFormat(&waves[i], (int)waves[i].sampleRate, 16, (int)waves[i].channels);
+        }
+        ok = ok && AddWave(&entries[count], &data[count], PackedWaves[i], waves[i]);
+        count++;
+    }
+
+    ok = ok && WritePack(output, entries, data, count);
+
+    for (size_t i = 0; i < PACKED_IMAGE_COUNT + 1; i++)
+    {
+        UnloadImage(images[i]);
+    }
+    for (size_t i = 0; i < PACKED_WAVE_COUNT; i++)
+    {
+        UnloadWave(waves[i]);
+    }
+
+    if (!ok)
+    {
+        return 1;
+    }
+
+    printf("%s: %u assets\n", output, count);
+    return 0;
+}
+
+/**
+ * AddImage (static)
+ *
+ * Describe a decoded image (one mipmap level) in entry.
+ *
+ * Returns:
+ *  - false (reported) if it failed to decode.
+ */
+static bool AddImage(AssetPackEntry *entry, const void **data, const char *name, Image image)
+{
+    if (image.data == NULL || image.mipmaps != 1)
+    {
+        fprintf(stderr, "Cannot decode %s\n", name);
+        return false;
+    }
+
+    snprintf(entry->name, sizeof entry->name, "%s", name);
+    entry->kind = ASSET_IMAGE;
+    entry->params[0] = image.width;
+    entry->params[1] = image.height;
+    entry->params[2] = image.format;
+    entry->params[3] = image.mipmaps;
+    entry->size = (uint64_t)GetPixelDataSize(image.width, image.height, image.format);
+    *data = image.data;
+    return true;
+}
+
+/**
+ * AddWave (static)
+ *
+ * Describe decoded samples in entry.
+ *
+ * Returns:
+ *  - false (reported) if they failed to decode.
+ */
+static bool AddWave(AssetPackEntry *entry, const void **data, const char *name, Wave wave)
+{
+    if (wave.data == NULL || wave.frameCount == 0)
+    {
+        fprintf(stderr, "Cannot decode %s\n", name);
+        return false;
+    }
+
+    snprintf(entry->name, sizeof entry->name, "%s", name);
+    entry->kind = ASSET_WAVE;
+    entry->params[0] = (int32_t)wave.frameCount;
+    entry->params[1] = (int32_t)wave.sampleRate;
+    entry->params[2] = (int32_t)wave.sampleSize;
+    entry->params[3] = (int32_t)wave.channels;
+    entry->size = (uint64_t)wave.frameCount * wave.channels * (wave.sampleSize / 8);
+    *data = wave.data;
+    return true;
+}
+
+/**
+ * WritePack (static)
+ *
+ * Lay the data out after the header and the entries (each at an ASSET_PACK_ALIGNMENT
+ * offset) and write the pack.
+ *
+ * Returns:
+ *  - false (reported) if the file cannot be written.
+ */
+static bool WritePack(const char *path, AssetPackEntry *entries, const void **data, uint32_t count)
+{
+    static const char padding[ASSET_PACK_ALIGNMENT] = {0};
+    uint64_t offset = sizeof(AssetPackHeader) + count * sizeof(AssetPackEntry);
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        offset = (offset + ASSET_PACK_ALIGNMENT - 1) / ASSET_PACK_ALIGNMENT * ASSET_PACK_ALIGNMENT;
+        entries[i].offset = offset;
+        offset += entries[i].size;
+    }
+
+    AssetPackHeader header = {.version = ASSET_PACK_VERSION, .entryCount = count, .fileSize = offset};
+    memcpy(header.magic, ASSET_PACK_MAGIC, sizeof ASSET_PACK_MAGIC);
+
+    char temporary[FILENAME_MAX];
+    snprintf(temporary, sizeof temporary, "%s.tmp", path);
+    FILE *file = fopen(temporary, "wb");
+    if (file == NULL)
+    {
+        fprintf(stderr, "Cannot create %s\n", temporary);
+        return false;
+    }
+
+    bool written = fwrite(&header, sizeof header, 1, file) == 1 && fwrite(entries, sizeof(AssetPackEntry), count, file) == count;
+    uint64_t position = sizeof header + count * sizeof(AssetPackEntry);
+    for (uint32_t i = 0; i < count && written; i++)
+    {
+        size_t gap = (size_t)(entries[i].offset - position);
+        written = fwrite(padding, 1, gap, file) == gap && fwrite(data[i], 1, (size_t)entries[i].size, file) == entries[i].size;
+        position = entries[i].offset + entries[i].size;
+    }
+
+    if (fclose(file) != 0 || !written || rename(temporary, path) != 0)
+    {
+        fprintf(stderr, "Error writing %s\n", path);
+        remove(temporary);
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,370 @@
+/**
+ * assets.c
+ *
+ * Responsibilities:
+ * - Map the asset pack (ASSET_PACK_PATH) and hand out its images and waves without
+ *   copying or decoding them.
+ * - Load the sound effects (and open the audio device) on a background thread so the
+ *   window shows its first frame without waiting for audio.
+ *
+ * Notes:
+ * - A packed Image or Wave points into the mapping: raylib's Unload* must never see it,
+ *   which is why UnloadAssetImage / UnloadAssetWave exist. LoadTextureFromImage and
+ *   LoadSoundFromWave copy the data, so textures and sounds outlive the pack.
+ * - The pack is checked as a whole when it is opened (header, every entry inside the
+ *   file, sizes matching the parameters); a pack that fails is ignored, not half-used.
+ *
+ * Implementation Details:
+ * - The sound thread runs InitAudioDevice, then LoadAssetWave + LoadSoundFromWave for the
+ *   four sounds, and raises SoundsReady. The main thread polls it (CollectSounds), joins
+ *   the thread and copies the sounds into the game; until then the game's sounds are
+ *   zeroed and PlaySound does nothing, so a move played in the first frames is silent
+ *   instead of blocking.
+ */
+
+#include "assets.h"
+#include "main.h"
+#include "raylib.h"
+#include "settings.h"
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const unsigned char *PackData = NULL;
+static size_t PackSize = 0;
+static const AssetPackEntry *PackEntries = NULL;
+static uint32_t PackEntryCount = 0;
+
+/* Sound thread (see Implementation Details) */
+static pthread_t SoundThread;
+static bool SoundThreadRunning = false;
+static bool SoundsCollected = true;
+static atomic_bool SoundsReady;
+static GameSounds LoadedSounds; /* sound thread until SoundsReady */
+
+// Local prototypes
+static const AssetPackEntry *FindAsset(const char *name, AssetKind kind);
+static bool IsPacked(const void *data);
+static bool ValidEntry(const AssetPackEntry *entry);
+static void *SoundThreadMain(void *arg);
+static Sound LoadGameSound(const char *path);
+
+/**
+ * OpenAssetPack
+ *
+ * Returns:
+ *  - false if the file is missing, cannot be mapped or fails a check (a warning is logged
+ *    for a damaged pack; a missing one is normal in a build without it).
+ */
+bool OpenAssetPack(const char *path)
+{
+    CloseAssetPack();
+
+    int fd = open(path, O_RDONLY);
+    struct stat info;
+    if (fd < 0)
+    {
+        TraceLog(LOG_INFO, "Assets: no pack at %s, decoding the asset files", path);
+        return false;
+    }
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(AssetPackHeader))
+    {
+        close(fd);
+        TraceLog(LOG_WARNING, "Assets: %s is not an asset pack", path);
+        return false;
+    }
+
+    size_t size = (size_t)info.st_size;
+    void *mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        TraceLog(LOG_WARNING, "Assets: cannot map %s", path);
+        return false;
+    }
+
+    AssetPackHeader header;
+    memcpy(&header, mapping, sizeof header);
+
+    bool valid = memcmp(header.magic, ASSET_PACK_MAGIC, sizeof ASSET_PACK_MAGIC) == 0 && header.version == ASSET_PACK_VERSION &&
+                 header.fileSize == size && (size - sizeof header) / sizeof(AssetPackEntry) >= header.entryCount;
+
+    PackData = mapping;
+    PackSize = size;
+    PackEntries = (const AssetPackEntry *)(PackData + sizeof header);
+    PackEntryCount = valid ? header.entryCount : 0;
+
+    for (uint32_t i = 0; i < PackEntryCount && valid; i++)
+    {
+        valid = ValidEntry(&PackEntries[i]);
+    }
+    if (!valid)
+    {
+        TraceLog(LOG_WARNING, "Assets: %s is damaged or from another version, decoding the asset files", path);
+        CloseAssetPack();
+        return false;
+    }
+
+    TraceLog(LOG_INFO, "Assets: %u decoded assets mapped from %s", PackEntryCount, path);
+    return true;
+}
+
+/**
+ * CloseAssetPack
+ *
+ * Safe to call when no pack is open.
+ */
+void CloseAssetPack(void)
+{
+    if (PackData != NULL)
+    {
+        munmap((void *)PackData, PackSize);
+    }
+
+    PackData = NULL;
+    PackSize = 0;
+    PackEntries = NULL;
+    PackEntryCount = 0;
+}
+
+/**
+ * HasPackedAsset
+ */
+bool HasPackedAsset(const char *path)
+{
+    return FindAsset(path, ASSET_IMAGE) != NULL || FindAsset(path, ASSET_WAVE) != NULL;
+}
+
+/**
+ * LoadAssetImage
+ *
+ * Parameters:
+ *  - path: the asset file ("assets/icon.png"), also its name in the pack.
+ */
+Image LoadAssetImage(const char *path)
+{
+    const AssetPackEntry *entry = FindAsset(path, ASSET_IMAGE);
+
+    if (entry == NULL)
+    {
+        return LoadImage(path);
+    }
+
+    return (Image){
+        .data = (void *)(PackData + entry->offset),
+        .width = entry->params[0],
+        .height = entry->params[1],
+        .format = entry->params[2],
+        .mipmaps = entry->params[3],
+    };
+}
+
+/**
+ * LoadAssetWave
+ *
+ * Parameters:
+ *  - path: the asset file ("assets/sound/Move.mp3"), also its name in the pack.
+ */
+Wave LoadAssetWave(const char *path)
+{
+    const AssetPackEntry *entry = FindAsset(path, ASSET_WAVE);
+
+    if (entry == NULL)
+    {
+        return LoadWave(path);
+    }
+
+    return (Wave){
+        .data = (void *)(PackData + entry->offset),
+        .frameCount = (unsigned int)entry->params[0],
+        .sampleRate = (unsigned int)entry->params[1],
+        .sampleSize = (unsigned int)entry->params[2],
+        .channels = (unsigned int)entry->params[3],
+    };
+}
+
+/**
+ * UnloadAssetImage
+ */
+void UnloadAssetImage(Image image)
+{
+    if (!IsPacked(image.data))
+    {
+        UnloadImage(image);
+    }
+}
+
+/**
+ * UnloadAssetWave
+ */
+void UnloadAssetWave(Wave wave)
+{
+    if (!IsPacked(wave.data))
+    {
+        UnloadWave(wave);
+    }
+}
+
+/**
+ * StartLoadingSounds
+ *
+ * If the thread cannot be started the sounds are loaded here, before returning.
+ */
+void StartLoadingSounds(void)
+{
+    atomic_init(&SoundsReady, false);
+    SoundsCollected = false;
+
+    SoundThreadRunning = pthread_create(&SoundThread, NULL, SoundThreadMain, NULL) == 0;
+    if (!SoundThreadRunning)
+    {
+        SoundThreadMain(NULL);
+    }
+}
+
+/**
+ * CollectSounds
+ *
+ * Parameters:
+ *  - sounds: receives the four sounds (left alone while they are still loading).
+ */
+bool CollectSounds(GameSounds *sounds)
+{
+    if (SoundsCollected || !atomic_load_explicit(&SoundsReady, memory_order_acquire))
+    {
+        return false;
+    }
+
+    FinishLoadingSounds(sounds);
+    return true;
+}
+
+/**
+ * AreSoundsLoading
+ */
+bool AreSoundsLoading(void)
+{
+    return !SoundsCollected;
+}
+
+/**
+ * FinishLoadingSounds
+ */
+void FinishLoadingSounds(GameSounds *sounds)
+{
+    if (SoundThreadRunning)
+    {
+        pthread_join(SoundThread, NULL);
+        SoundThreadRunning = false;
+    }
+    if (!SoundsCollected)
+    {
+        *sounds = LoadedSounds;
+        SoundsCollected = true;
+    }
+}
+
+/**
+ * FindAsset (static)
+ *
+ * Returns:
+ *  - The pack entry of that name and kind, or NULL (no pack, or not in it).
+ */
+static const AssetPackEntry *FindAsset(const char *name, AssetKind kind)
+{
+    for (uint32_t i = 0; i < PackEntryCount; i++)
+    {
+        if (PackEntries[i].kind == (uint32_t)kind && strcmp(PackEntries[i].name, name) == 0)
+        {
+            return &PackEntries[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * IsPacked (static)
+ *
+ * Returns:
+ *  - true if data points into the mapped pack.
+ */
+static bool IsPacked(const void *data)
+{
+    const unsigned char *bytes = data;
+    return PackData != NULL && bytes >= PackData && bytes < PackData + PackSize;
+}
+
+/**
+ * ValidEntry (static)
+ *
+ * Returns:
+ *  - true if the entry is named, lies inside the pack and holds exactly the bytes its
+ *    parameters describe.
+ */
+static bool ValidEntry(const AssetPackEntry *entry)
+{
+    if (memchr(entry->name, '\0', sizeof entry->name) == NULL || entry->offset % ASSET_PACK_ALIGNMENT != 0 || entry->offset > PackSize ||
+        entry->size > PackSize - entry->offset)
+    {
+        return false;
+    }
+
+    const int32_t *p = entry->params;
+    switch (entry->kind)
+    {
+    case ASSET_IMAGE:
+        return p[0] > 0 && p[1] > 0 && p[3] == 1 && GetPixelDataSize(p[0], p[1], p[2]) == (int)entry->size;
+    case ASSET_WAVE:
+        return p[0] > 0 && p[1] > 0 && (p[2] == 8 || p[2] == 16 || p[2] == 32) && p[3] > 0 &&
+               (uint64_t)p[0] * (uint64_t)p[3] * (uint64_t)(p[2] / 8) == entry->size;
+    default:
+        return false;
+    }
+}
+
+/**
+ * SoundThreadMain (static)
+ */
+static void *SoundThreadMain(void *arg)
+{
+    (void)arg;
+
+    InitAudioDevice();
+    LoadedSounds.capture = LoadGameSound("assets/sound/Capture.mp3");
+    LoadedSounds.check = LoadGameSound("assets/sound/Check.mp3");
+    LoadedSounds.checkMate = LoadGameSound("assets/sound/Checkmate.mp3");
+    LoadedSounds.move = LoadGameSound("assets/sound/Move.mp3");
+
+    atomic_store_explicit(&SoundsReady, true, memory_order_release);
+    return NULL;
+}
+
+/**
+ * LoadGameSound (static)
+ *
+ * Returns:
+ *  - The sound of an asset (packed samples, or the file decoded here); a zeroed Sound,
+ *    which plays nothing, if it cannot be loaded.
+ */
+static Sound LoadGameSound(const char *path)
+{
+    Wave wave = LoadAssetWave(path);
+
+    if (wave.data == NULL)
+    {
+        TraceLog(LOG_WARNING, "Assets: cannot load %s", path);
+        return (Sound){0};
+    }
+
+    Sound sound = LoadSoundFromWave(wave);
+    UnloadAssetWave(wave);
+    return sound;
+}
@@ -0,0 +1,104 @@
+/**
+ * assets.h
+ *
+ * Responsibilities:
+ * - Export the asset pack: the window icon, the piece atlas and the sound effects already
+ *   decoded (pixels and PCM samples) in one file built at compile time by the assetpack
+ *   tool, memory-mapped at startup so nothing is decoded before the first frame.
+ * - Export the background sound loader: the audio device and the four sounds of the game
+ *   are set up on their own thread while the window draws its first frames.
+ *
+ * Notes:
+ * - Every Load* function falls back to the asset file itself (PNG, MP3) when no pack is
+ *   open or the pack lacks the asset, so a build without the pack still runs.
+ * - Pack entries are named after the file they were decoded from ("assets/icon.png");
+ *   the piece atlas is the composed image (PIECE_ATLAS_ASSET), not the 12 sprites.
+ */
+
+#ifndef ASSETS_H
+#define ASSETS_H
+
+#include "main.h"
+#include "raylib.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define ASSET_PACK_MAGIC "CHSPACK"
+#define ASSET_PACK_VERSION 1
+
+/* Byte offset alignment of every asset's data inside the pack */
+#define ASSET_PACK_ALIGNMENT 64
+
+#define MAX_ASSET_NAME_LENGTH 48
+
+/* Name of the composed piece atlas in the pack */
+#define PIECE_ATLAS_ASSET "assets/pieces"
+
+typedef enum AssetKind
+{
+    ASSET_IMAGE = 1, /* params: width, height, PixelFormat, mipmaps */
+    ASSET_WAVE = 2,  /* params: frameCount, sampleRate, sampleSize, channels */
+} AssetKind;
+
+/**
+ * AssetPackHeader
+ *
+ * Start of the pack file, followed by entryCount AssetPackEntry records and the data.
+ * Native byte order: the pack is built on the machine (or the platform) that runs it.
+ */
+typedef struct AssetPackHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t entryCount;
+    uint64_t fileSize;
+} AssetPackHeader;
+
+/**
+ * AssetPackEntry
+ *
+ * One decoded asset: offset/size locate its pixels or samples in the pack.
+ */
+typedef struct AssetPackEntry
+{
+    char name[MAX_ASSET_NAME_LENGTH];
+    uint32_t kind;
+    int32_t params[4];
+    uint64_t offset;
+    uint64_t size;
+} AssetPackEntry;
+
+/* Maps the pack at path. Returns false (assets are then decoded from their files) if it is missing or not a pack of this version */
+bool OpenAssetPack(const char *path);
+
+/* Unmaps the pack; images and waves taken from it must not be used afterwards (textures and sounds made from them may) */
+void CloseAssetPack(void);
+
+/* Returns true if the open pack holds the asset */
+bool HasPackedAsset(const char *path);
+
+/* Packed image of an asset (pixels inside the mapping), or the file decoded now. data is NULL on failure */
+Image LoadAssetImage(const char *path);
+
+/* Packed samples of an asset, or the file decoded now. data is NULL on failure */
+Wave LoadAssetWave(const char *path);
+
+/* Releases an image from LoadAssetImage (nothing to free for a packed one) */
+void UnloadAssetImage(Image image);
+
+/* Releases a wave from LoadAssetWave (nothing to free for a packed one) */
+void UnloadAssetWave(Wave wave);
+
+/* Opens the audio device and loads the game's sounds on a background thread */
+void StartLoadingSounds(void);
+
+/* Hands the loaded sounds over once the thread has finished (call once per frame). Returns true the one time it does */
+bool CollectSounds(GameSounds *sounds);
+
+/* Returns true until CollectSounds has handed the sounds over */
+bool AreSoundsLoading(void);
+
+/* Waits for the sound thread if it still runs (shutdown); its sounds go to sounds unless already collected */
+void FinishLoadingSounds(GameSounds *sounds);
+
+#endif /* ASSETS_H */
@@ -0,0 +1,197 @@
+/**
+ * atlas.c
+ *
+ * Responsibilities:
+ * - Load every piece image once at startup and pack them into a single texture.
+ * - Draw individual sprites out of that texture.
+ *
+ * Implementation Details:
+ * - Layout: one row per team (white on top), one column per piece type in PieceType
+ *   order (king, queen, rook, bishop, knight, pawn). Every sprite is a square of the
+ *   size of the first image loaded; images of another size are resized to match.
+ * - Filenames are generated as "assets/pieces/<piece><W|B>.png" (example: assets/pieces/kingW.png).
+ * - The assetpack tool stores the composed atlas (BuildPieceAtlasImage) in the asset pack,
+ *   so a normal start uploads it straight from the mapped pack.
+ * - A single texture means every piece draw binds the same texture, so raylib can batch
+ *   the whole board into one draw call.
+ */
+
+#include "atlas.h"
+#include "assets.h"
+#include "piece.h"
+#include "raylib.h"
+#include "settings.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+static Texture2D PieceAtlas = {0};
+static int SpriteSize = 0;
+
+// Local prototypes
+static Rectangle SpriteRect(int spriteId);
+
+/**
+ * LoadPieceAtlas
+ *
+ * Upload the atlas texture: the composed image from the asset pack when it has one (no
+ * PNG is decoded), otherwise built from the 12 piece images.
+ *
+ * Returns:
+ *  - true on success; false if any image is missing or not square (the atlas is then
+ *    left unloaded and pieces are not drawn).
+ *
+ * Notes:
+ *  - Safe to call again (e.g. after assets change): the previous atlas is released first.
+ */
+bool LoadPieceAtlas(void)
+{
+    UnloadPieceAtlas();
+
+    Image atlas = HasPackedAsset(PIECE_ATLAS_ASSET) ? LoadAssetImage(PIECE_ATLAS_ASSET) : BuildPieceAtlasImage();
+    if (atlas.data == NULL)
+    {
+        return false;
+    }
+
+    PieceAtlas = LoadTextureFromImage(atlas);
+    int size = atlas.height / TEAM_COUNT;
+    UnloadAssetImage(atlas);
+
+    if (PieceAtlas.id == 0)
+    {
+        TraceLog(LOG_WARNING, "Failed to upload the piece atlas");
+        return false;
+    }
+
+    SpriteSize = size;
+    return true;
+}
+
+/**
+ * BuildPieceAtlasImage
+ *
+ * Decode the 12 piece images and draw them into one atlas image (see the layout above).
+ *
+ * Returns:
+ *  - The atlas image (free it with UnloadImage), or an image whose data is NULL if any
+ *    piece image is missing or not square.
+ */
+Image BuildPieceAtlasImage(void)
+{
+    static const char *pieceNames[PIECE_TYPE_COUNT] = {NULL, "king", "queen", "rook", "bishop", "knight", "pawn"};
+    char path[MAX_PIECE_NAME_BUFFER_SIZE + 1];
+    Image atlas = {0};
+    int size = 0;
+
+    for (int team = 0; team < TEAM_COUNT; team++)
+    {
+        for (int type = PIECE_KING; type < PIECE_TYPE_COUNT; type++)
+        {
+            int length = snprintf(path, sizeof path, "assets/pieces/%s%c.png", pieceNames[type], (team == TEAM_WHITE) ? 'W' : 'B');
+            if (length < 0 || length >= (int)sizeof path)
+            {
+                TraceLog(LOG_WARNING, "Piece filename was truncated: %s", path);
+            }
+
+            Image image = LoadImage(path);
+
+            if (image.data == NULL || image.width == 0 || image.width != image.height)
+            {
+                TraceLog(LOG_WARNING, "Failed to load piece sprite (must be a square image): %s", path);
+                UnloadImage(image);
+                UnloadImage(atlas);
+                return (Image){0};
+            }
+
+            if (size == 0)
+            {
+                size = image.width;
+                atlas = GenImageColor(size * (PIECE_TYPE_COUNT - 1), size * TEAM_COUNT, BLANK);
+            }
+
+            if (image.width != size)
+            {
+                ImageResize(&image, size, size);
+            }
+
+            Rectangle source = {0, 0, (float)size, (float)size};
+            Rectangle destination = {(float)(size * (type - PIECE_KING)), (float)(size * team), (float)size, (float)size};
+            ImageDraw(&atlas, image, source, destination, WHITE);
+            UnloadImage(image);
+        }
+    }
+
+    return atlas;
+}
+
+/**
+ * UnloadPieceAtlas
+ *
+ * Release the atlas texture. Safe to call when nothing is loaded.
+ */
+void UnloadPieceAtlas(void)
+{
+    if (PieceAtlas.id != 0)
+    {
+        UnloadTexture(PieceAtlas);
+    }
+
+    PieceAtlas = (Texture2D){0};
+    SpriteSize = 0;
+}
+
+/**
+ * PieceSpriteId
+ *
+ * Returns:
+ *  - team * 6 + (type - PIECE_KING), i.e. the sprite's index in the atlas, or -1 for PIECE_NONE.
+ */
+int PieceSpriteId(PieceType type, Team team)
+{
+    if (type <= PIECE_NONE || type >= PIECE_TYPE_COUNT)
+    {
+        return -1;
+    }
+
+    return (int)team * (PIECE_TYPE_COUNT - 1) + (type - PIECE_KING);
+}
+
+/**
+ * DrawPieceSprite
+ *
+ * Draw one piece out of the atlas.
+ *
+ * Parameters:
+ *  - type, team: which sprite.
+ *  - pos:        top-left pixel of the destination square.
+ *  - size:       side length in pixels of the destination square.
+ *
+ * Notes:
+ *  - Does nothing for PIECE_NONE or when the atlas failed to load.
+ */
+void DrawPieceSprite(PieceType type, Team team, Vector2 pos, float size)
+{
+    int spriteId = PieceSpriteId(type, team);
+
+    if (spriteId < 0 || PieceAtlas.id == 0)
+    {
+        return;
+    }
+
+    Rectangle destination = {pos.x, pos.y, size, size};
+    DrawTexturePro(PieceAtlas, SpriteRect(spriteId), destination, (Vector2){0, 0}, 0, WHITE);
+}
+
+/**
+ * SpriteRect (static)
+ *
+ * Source rectangle of a sprite inside the atlas.
+ */
+static Rectangle SpriteRect(int spriteId)
+{
+    int column = spriteId % (PIECE_TYPE_COUNT - 1);
+    int row = spriteId / (PIECE_TYPE_COUNT - 1);
+
+    return (Rectangle){(float)(column * SpriteSize), (float)(row * SpriteSize), (float)SpriteSize, (float)SpriteSize};
+}
@@ -0,0 +1,39 @@
+/**
+ * atlas.h
+ *
+ * Responsibilities:
+ * - Own the piece atlas: one GPU texture holding the 12 piece sprites.
+ * - Export a sprite id per (team, piece type) and a helper to draw a sprite.
+ *
+ * Notes:
+ * - Cells do not own textures; a piece's sprite is looked up from its type and team, so
+ *   moving, capturing, undoing or loading a FEN never touches the disk or the GPU.
+ * - LoadPieceAtlas needs an OpenGL context (call it after InitWindow).
+ */
+
+#ifndef ATLAS_H
+#define ATLAS_H
+
+#include "piece.h"
+#include "raylib.h"
+#include <stdbool.h>
+
+/* One sprite per team and non-empty piece type */
+#define PIECE_SPRITE_COUNT (TEAM_COUNT * (PIECE_TYPE_COUNT - 1))
+
+/* Loads the 12 piece images and packs them into the atlas texture. Returns false on failure */
+bool LoadPieceAtlas(void);
+
+/* Decodes the 12 piece images into one atlas image (the asset pack stores it). data is NULL on failure */
+Image BuildPieceAtlasImage(void);
+
+/* Releases the atlas texture */
+void UnloadPieceAtlas(void);
+
+/* Sprite id of a piece (0..PIECE_SPRITE_COUNT-1), or -1 for PIECE_NONE */
+int PieceSpriteId(PieceType type, Team team);
+
+/* Draws a piece sprite scaled to a size x size square with its top-left corner at pos */
+void DrawPieceSprite(PieceType type, Team team, Vector2 pos, float size);
+
+#endif /* ATLAS_H */
@@ -0,0 +1,236 @@
+/**
+ * bench.c
+ *
+ * Responsibilities:
+ * - Command-line search benchmark built on libchesscore (no window, no audio).
+ * - Search a fixed set of positions to a fixed depth and report time-to-depth,
+ *   node counts and nodes per second, so search changes can be compared run to run.
+ *
+ * Usage:
+ *   bench [depth]                    fixed suite (default depth BENCH_DEFAULT_DEPTH)
+ *   bench <depth> <fen>              a single position (FEN quoted or as separate arguments)
+ *   bench smp [depth] [maxThreads]   Lazy SMP scaling: time-to-depth of the suite with
+ *                                    1, 2, 4, ... maxThreads threads (default: all cores)
+ *
+ * Notes:
+ * - Every position starts from an empty transposition table, so results do not depend
+ *   on the order positions are searched in.
+ * - The total node count is a signature of the search: a change that is meant to be a
+ *   pure speed-up must leave it unchanged. This only holds single-threaded (the default);
+ *   with helper threads the search is not deterministic.
+ * - The smp mode reports, per thread count, the time the main thread needs to complete
+ *   the depth over the whole suite and the speed-up relative to one thread.
+ */
+
+#include "chesscore.h"
+#include "movegen.h"
+#include "pgn.h"
+#include "position.h"
+#include "search.h"
+#include "settings.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_DEFAULT_DEPTH 8
+
+/* Opening, middlegame and endgame positions with different branching factors */
+static const char *BenchPositions[] = {
+    STARTING_FEN,
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP1QBPPP/R3KB1R w KQ - 0 9",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1",
+};
+
+#define BENCH_POSITION_COUNT ((int)(sizeof BenchPositions / sizeof BenchPositions[0]))
+
+// Local prototypes
+static void PrintIteration(const SearchResult *result, void *userData);
+static bool BenchPosition(Engine *engine, const char *fen, int depth, uint64_t *nodes, double *seconds);
+static int BenchScaling(Engine *engine, int argc, char **argv);
+
+int main(int argc, char **argv)
+{
+    Engine engine;
+    int depth = BENCH_DEFAULT_DEPTH;
+    uint64_t totalNodes = 0;
+    double totalTime = 0;
+
+    InitChessCore();
+
+    if (argc >= 2 && strcmp(argv[1], "smp") == 0)
+    {
+        if (!InitializeEngine(&engine, DEFAULT_TT_MEGABYTES))
+        {
+            fprintf(stderr, "Failed to allocate the transposition table\n");
+            return 1;
+        }
+
+        int status = BenchScaling(&engine, argc, argv);
+        FreeEngine(&engine);
+        return status;
+    }
+
+    if (argc >= 2)
+    {
+        depth = atoi(argv[1]);
+        if (depth < 1 || depth >= MAX_SEARCH_PLY)
+        {
+            fprintf(stderr, "Usage: %s [depth] [fen] | smp [depth] [maxThreads]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (!InitializeEngine(&engine, DEFAULT_TT_MEGABYTES))
+    {
+        fprintf(stderr, "Failed to allocate the transposition table\n");
+        return 1;
+    }
+    SetSearchCallback(&engine, PrintIteration, NULL);
+
+    bool ok = true;
+    if (argc >= 3)
+    {
+        char fen[MAX_FEN_BUFFER_SIZE + 1] = "";
+        size_t length = 0;
+
+        for (int i = 2; i < argc && length < sizeof fen - 1; i++)
+        {
+            int written = snprintf(fen + length, sizeof fen - length, "%s%s", (i > 2) ? " " : "", argv[i]);
+            length += (written > 0) ? (size_t)written : 0;
+        }
+        ok = BenchPosition(&engine, fen, depth, &totalNodes, &totalTime);
+    }
+    else
+    {
+        for (int i = 0; i < BENCH_POSITION_COUNT && ok; i++)
+        {
+            ok = BenchPosition(&engine, BenchPositions[i], depth, &totalNodes, &totalTime);
+        }
+    }
+
+    if (ok)
+    {
+        printf("\nDepth %d: %llu nodes in %.3f s (%.0f nps)\n", depth, (unsigned long long)totalNodes, totalTime, totalTime > 0 ? (double)totalNodes / totalTime : 0.0);
+    }
+
+    FreeEngine(&engine);
+    return ok ? 0 : 1;
+}
+
+/**
+ * PrintIteration (static)
+ *
+ * Search callback: one line per completed depth (time-to-depth, nodes, nps, score, PV).
+ */
+static void PrintIteration(const SearchResult *result, void *userData)
+{
+    (void)userData;
+
+    printf("  depth %2d  %8.3f s  %12llu nodes  %10.0f nps  score %6d  pv", result->depth, result->seconds, (unsigned long long)result->nodes,
+           result->seconds > 0 ? (double)result->nodes / result->seconds : 0.0, result->score);
+    for (int i = 0; i < result->pvLength && i < 8; i++)
+    {
+        char uci[MAX_UCI_MOVE_LENGTH];
+        MoveToUci(result->pv[i], uci);
+        printf(" %s", uci);
+    }
+    putchar('\n');
+}
+
+/**
+ * BenchPosition (static)
+ *
+ * Search one FEN to depth with a cleared engine and add its nodes/time to the totals.
+ */
+static bool BenchPosition(Engine *engine, const char *fen, int depth, uint64_t *nodes, double *seconds)
+{
+    Position pos;
+    SearchResult result;
+    SearchLimits limits = {.depth = depth};
+
+    if (!PositionFromFEN(&pos, fen))
+    {
+        fprintf(stderr, "Invalid FEN: %s\n", fen);
+        return false;
+    }
+
+    if (engine->onIteration != NULL)
+    {
+        printf("%s\n", fen);
+    }
+    ResetEngine(engine);
+    Search(engine, &pos, NULL, 0, &limits, &result);
+
+    *nodes += result.nodes;
+    *seconds += result.seconds;
+    return true;
+}
+
+/**
+ * BenchScaling (static)
+ *
+ * The smp mode: run the suite at a fixed depth once per thread count (doubling up to
+ * maxThreads, which is always included) and print time-to-depth and speed-up.
+ *
+ * Returns:
+ *  - Process exit status.
+ */
+static int BenchScaling(Engine *engine, int argc, char **argv)
+{
+    int depth = (argc >= 3) ? atoi(argv[2]) : BENCH_DEFAULT_DEPTH;
+    int maxThreads = (argc >= 4) ? atoi(argv[3]) : AvailableCores();
+    double baseline = 0;
+
+    if (depth < 1 || depth >= MAX_SEARCH_PLY || maxThreads < 1 || maxThreads > MAX_SEARCH_THREADS)
+    {
+        fprintf(stderr, "Usage: %s smp [depth 1-%d] [threads 1-%d]\n", argv[0], MAX_SEARCH_PLY - 1, MAX_SEARCH_THREADS);
+        return 1;
+    }
+
+    printf("Lazy SMP scaling, %d positions, depth %d, %d MiB hash\n\n", BENCH_POSITION_COUNT, depth, DEFAULT_TT_MEGABYTES);
+    printf("threads  time-to-depth    speed-up           nodes           nps\n");
+
+    for (int threads = 1;; threads *= 2)
+    {
+        uint64_t nodes = 0;
+        double seconds = 0;
+
+        if (threads > maxThreads)
+        {
+            threads = maxThreads;
+        }
+
+        if (!SetEngineThreads(engine, threads))
+        {
+            fprintf(stderr, "Could not start %d threads\n", threads);
+            return 1;
+        }
+
+        for (int i = 0; i < BENCH_POSITION_COUNT; i++)
+        {
+            BenchPosition(engine, BenchPositions[i], depth, &nodes, &seconds);
+        }
+
+        if (threads == 1)
+        {
+            baseline = seconds;
+        }
+
+        printf("%7d  %11.3f s  %9.2fx  %14llu  %12.0f\n", threads, seconds, seconds > 0 ? baseline / seconds : 0.0, (unsigned long long)nodes,
+               seconds > 0 ? (double)nodes / seconds : 0.0);
+        fflush(stdout);
+
+        if (threads == maxThreads)
+        {
+            break;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,649 @@
+/**
+ * bitboard.c
+ *
+ * Responsibilities:
+ * - Precompute attack tables for the leaper pieces (knight, king, pawn).
+ * - Build "fancy" magic bitboard tables for rook and bishop attacks.
+ * - Maintain the Bitboards masks and answer attack queries for the rule logic.
+ * - Maintain AttackMap (per-square attack sets and per-team attack counts) incrementally.
+ *
+ * Implementation Details:
+ * - The magic numbers are precomputed constants (found offline with a sparse random search
+ *   over this file's square layout), so startup only has to fill the attack tables.
+ * - Each square owns a slice of a shared attack table; the slice size is 2^(relevant bits).
+ * - UpdateAttackMap only recomputes the pieces on the changed squares and the sliders
+ *   whose attack set contains one of them: a slider's rays stop at the first piece, so a
+ *   square outside its attack set cannot change what it attacks. Leapers and pawns
+ *   ignore occupancy and never need an update unless they moved.
+ */
+
+#include "bitboard.h"
+#include "piece.h"
+#include "settings.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/* Sum of 2^(relevant occupancy bits) over all squares */
+#define ROOK_TABLE_SIZE 102400
+#define BISHOP_TABLE_SIZE 5248
+
+/**
+ * Magic
+ *
+ * Per-square data for one slider type.
+ * attacks = table[((occupied & mask) * magic) >> shift]
+ */
+typedef struct Magic
+{
+    Bitboard mask;
+    Bitboard magic;
+    Bitboard *table;
+    unsigned int shift;
+} Magic;
+
+Bitboard KnightAttackTable[SQUARE_COUNT];
+Bitboard KingAttackTable[SQUARE_COUNT];
+Bitboard PawnAttackTable[TEAM_COUNT][SQUARE_COUNT];
+Bitboard BetweenTable[SQUARE_COUNT][SQUARE_COUNT];
+
+static Magic RookMagics[SQUARE_COUNT];
+static Magic BishopMagics[SQUARE_COUNT];
+static Bitboard RookTable[ROOK_TABLE_SIZE];
+static Bitboard BishopTable[BISHOP_TABLE_SIZE];
+
+static const int RookDirections[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+static const int BishopDirections[4][2] = {{1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+
+/* Magic multipliers, indexed by square (a8 = 0). Each maps every occupancy subset of the
+ * square's relevant mask to a table slot without a destructive collision. */
+static const Bitboard RookMagicNumbers[SQUARE_COUNT] = {
+    0x1080004008801020ULL, 0x0840092002C03000ULL, 0x1900200010400900ULL, 0x0880100008000480ULL,
+    0x4200100420080200ULL, 0x8100020100080400ULL, 0x0200040110886200ULL, 0x0200008040220411ULL,
+    0x0404800084400220ULL, 0x0000401000402000ULL, 0x0086001081220440ULL, 0x0408800800100280ULL,
+    0x000A001201040820ULL, 0x8848800200840080ULL, 0x4001000100040200ULL, 0x0442000102105084ULL,
+    0x9080010020804100ULL, 0x0040404000201009ULL, 0x0000808010002009ULL, 0x2200090021D00100ULL,
+    0x0008008008040080ULL, 0x0004004002010040ULL, 0x0011040008015042ULL, 0x00000A0001768104ULL,
+    0x0000800080204009ULL, 0x2010004140002001ULL, 0x9800200280100080ULL, 0x1000100080080080ULL,
+    0x0442000A00049020ULL, 0x2100040080020080ULL, 0x0800120400900148ULL, 0x0010040A00128541ULL,
+    0x2800804000800030ULL, 0x1010002000400041ULL, 0x4000200011004100ULL, 0x0610008410800800ULL,
+    0x0400802402800800ULL, 0xC100020080800400ULL, 0x0002000802000401ULL, 0x0182085882000401ULL,
+    0x0220204000808000ULL, 0x2860100040024022ULL, 0x0001002004110040ULL, 0x99101042000A0020ULL,
+    0x0004080004008080ULL, 0x0010040002008080ULL, 0x2012004881020004ULL, 0x8300842444820011ULL,
+    0x0088403882010200ULL, 0x0820400080210100ULL, 0x0110910040A00300ULL, 0x0801100280080480ULL,
+    0x0242009008200600ULL, 0x1002000489500200ULL, 0x0040800200010080ULL, 0x0091800041000080ULL,
+    0x0000209300488001ULL, 0x04C1002414824001ULL, 0x020020000B001041ULL, 0x7000100004200901ULL,
+    0x8002002004100802ULL, 0x30010002084C0007ULL, 0x0888221800813004ULL, 0x4000002840840112ULL
+};
+
+static const Bitboard BishopMagicNumbers[SQUARE_COUNT] = {
+    0xA010041108003100ULL, 0x006082020A002900ULL, 0x6810010619200000ULL, 0x08281A0520000408ULL,
+    0x0001104001000400ULL, 0x0018901008048400ULL, 0x00040A0210245280ULL, 0x000200210808A402ULL,
+    0x9140048410821200ULL, 0x0800091010820041ULL, 0x20504804832202C0ULL, 0x0100091401081000ULL,
+    0x8021011140000012ULL, 0x0810020804450400ULL, 0x208B0542109008A2ULL, 0x0080084A08040204ULL,
+    0x0040E2A80811244CULL, 0x2505022008008108ULL, 0x0430220100420040ULL, 0x010A040420220040ULL,
+    0x1105000290400000ULL, 0x0093001200822120ULL, 0x4000A62048043004ULL, 0x280120048A015004ULL,
+    0x006090002A020814ULL, 0x44042000240800D0ULL, 0x01102800040A4400ULL, 0x1004080080220040ULL,
+    0x0001001011004024ULL, 0x0010044000805040ULL, 0x0914041200820100ULL, 0x0004821012821480ULL,
+    0x0024040500C05021ULL, 0x0088611002080200ULL, 0x0116080A00040020ULL, 0x4000020080080080ULL,
+    0x2450450140840040ULL, 0x0000880201484100ULL, 0x0222020404020092ULL, 0x8081110600002E00ULL,
+    0x2842101105000801ULL, 0x1100809008001025ULL, 0x00020202221C0400ULL, 0x0422014022009020ULL,
+    0x0210046102100C00ULL, 0xC004008082029102ULL, 0x00AA461801101200ULL, 0x0404080080201108ULL,
+    0x020542108C205002ULL, 0x0410544804100100ULL, 0x0040910841100000ULL, 0x0400200042021100ULL,
+    0x00004204850400C0ULL, 0x0200100410A42102ULL, 0x1040020801210102ULL, 0x0805040410420000ULL,
+    0x2884804130100200ULL, 0x800C262201242000ULL, 0x1058000194108800ULL, 0x0014221054420204ULL,
+    0x0104000012A02200ULL, 0x0200881003300100ULL, 0x0140400202840100ULL, 0x0402020801010201ULL
+};
+
+// Local prototypes
+static bool OnBoard(int row, int col);
+static Bitboard LeaperMask(int square, const int (*offsets)[2], int count);
+static Bitboard SlidingAttacks(int square, Bitboard occupied, const int (*directions)[2]);
+static Bitboard RelevantMask(int square, const int (*directions)[2]);
+static void InitBetween(const int (*directions)[2]);
+static void InitMagics(Magic *magics, Bitboard *table, const Bitboard *magicNumbers, const int (*directions)[2]);
+static void RecountSquare(AttackMap *map, const Bitboards *bb, int square);
+
+/**
+ * InitBitboards
+ *
+ * Fill every lookup table used by the attack queries.
+ * Must run once before any other function in this module (main() does it at startup).
+ */
+void InitBitboards(void)
+{
+    static const int knightOffsets[8][2] = {{2, 1}, {2, -1}, {-2, 1}, {-2, -1}, {1, 2}, {1, -2}, {-1, 2}, {-1, -2}};
+    static const int kingOffsets[8][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}, {1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+    static const int whitePawnOffsets[2][2] = {{-1, -1}, {-1, 1}}; // white captures towards row 0
+    static const int blackPawnOffsets[2][2] = {{1, -1}, {1, 1}};
+
+    for (int square = 0; square < SQUARE_COUNT; square++)
+    {
+        KnightAttackTable[square] = LeaperMask(square, knightOffsets, 8);
+        KingAttackTable[square] = LeaperMask(square, kingOffsets, 8);
+        PawnAttackTable[TEAM_WHITE][square] = LeaperMask(square, whitePawnOffsets, 2);
+        PawnAttackTable[TEAM_BLACK][square] = LeaperMask(square, blackPawnOffsets, 2);
+    }
+
+    InitMagics(RookMagics, RookTable, RookMagicNumbers, RookDirections);
+    InitMagics(BishopMagics, BishopTable, BishopMagicNumbers, BishopDirections);
+
+    memset(BetweenTable, 0, sizeof(BetweenTable));
+    InitBetween(RookDirections);
+    InitBetween(BishopDirections);
+}
+
+/**
+ * ClearBitboards
+ *
+ * Reset every mask to the empty board.
+ */
+void ClearBitboards(Bitboards *bb)
+{
+    memset(bb, 0, sizeof(*bb));
+}
+
+/**
+ * PlacePieceBB
+ *
+ * Set the piece's bit in its type mask, its team mask and the occupancy.
+ */
+void PlacePieceBB(Bitboards *bb, int square, PieceType type, Team team)
+{
+    Bitboard bit = SQUARE_BIT(square);
+    bb->pieces[team][type] |= bit;
+    bb->teams[team] |= bit;
+    bb->occupied |= bit;
+}
+
+/**
+ * RemovePieceBB
+ *
+ * Clear the piece's bit from its type mask, its team mask and the occupancy.
+ */
+void RemovePieceBB(Bitboards *bb, int square, PieceType type, Team team)
+{
+    Bitboard bit = SQUARE_BIT(square);
+    bb->pieces[team][type] &= ~bit;
+    bb->teams[team] &= ~bit;
+    bb->occupied &= ~bit;
+}
+
+/**
+ * PieceTypeAt
+ *
+ * Look up which piece stands on a square.
+ *
+ * Parameters:
+ *  - square: 0..63
+ *  - team:   optional output for the piece's team (untouched when the square is empty)
+ *
+ * Returns:
+ *  - The PieceType on the square, or PIECE_NONE.
+ */
+PieceType PieceTypeAt(const Bitboards *bb, int square, Team *team)
+{
+    Bitboard bit = SQUARE_BIT(square);
+
+    if (!(bb->occupied & bit))
+    {
+        return PIECE_NONE;
+    }
+
+    Team owner = (bb->teams[TEAM_WHITE] & bit) ? TEAM_WHITE : TEAM_BLACK;
+    if (team != NULL)
+    {
+        *team = owner;
+    }
+
+    for (int type = PIECE_KING; type < PIECE_TYPE_COUNT; type++)
+    {
+        if (bb->pieces[owner][type] & bit)
+        {
+            return (PieceType)type;
+        }
+    }
+
+    return PIECE_NONE;
+}
+
+/**
+ * RookAttacks
+ *
+ * Magic lookup of the squares a rook on square attacks (the first blocker in each
+ * direction is included, whatever its team).
+ */
+Bitboard RookAttacks(int square, Bitboard occupied)
+{
+    const Magic *m = &RookMagics[square];
+    return m->table[((occupied & m->mask) * m->magic) >> m->shift];
+}
+
+/**
+ * BishopAttacks
+ *
+ * Magic lookup of the squares a bishop on square attacks.
+ */
+Bitboard BishopAttacks(int square, Bitboard occupied)
+{
+    const Magic *m = &BishopMagics[square];
+    return m->table[((occupied & m->mask) * m->magic) >> m->shift];
+}
+
+/**
+ * QueenAttacks
+ *
+ * Union of the rook and bishop lookups.
+ */
+Bitboard QueenAttacks(int square, Bitboard occupied)
+{
+    return RookAttacks(square, occupied) | BishopAttacks(square, occupied);
+}
+
+/**
+ * PieceAttacks
+ *
+ * Squares attacked (not necessarily movable to) by a piece.
+ * For pawns this is only the two capture diagonals.
+ */
+Bitboard PieceAttacks(PieceType type, Team team, int square, Bitboard occupied)
+{
+    switch (type)
+    {
+    case PIECE_KING:
+        return KingAttackTable[square];
+    case PIECE_QUEEN:
+        return QueenAttacks(square, occupied);
+    case PIECE_ROOK:
+        return RookAttacks(square, occupied);
+    case PIECE_BISHOP:
+        return BishopAttacks(square, occupied);
+    case PIECE_KNIGHT:
+        return KnightAttackTable[square];
+    case PIECE_PAWN:
+        return PawnAttackTable[team][square];
+    default:
+        return 0;
+    }
+}
+
+/**
+ * PieceTargets
+ *
+ * Pseudo-legal destinations for a piece: every attacked square not occupied by a
+ * friendly piece, and for pawns the single/double pushes plus diagonal captures.
+ *
+ * Notes:
+ *  - Castling and en passant depend on GameState rule flags and are added by move.c.
+ *  - Self-check is not filtered here.
+ */
+Bitboard PieceTargets(const Bitboards *bb, int square, PieceType type, Team team)
+{
+    Bitboard empty = ~bb->occupied;
+
+    if (type != PIECE_PAWN)
+    {
+        return PieceAttacks(type, team, square, bb->occupied) & ~bb->teams[team];
+    }
+
+    Bitboard targets = PawnAttackTable[team][square] & bb->teams[team ^ 1];
+    int row = SQUARE_ROW(square);
+
+    if (team == TEAM_WHITE)
+    {
+        Bitboard single = (SQUARE_BIT(square) >> BOARD_SIZE) & empty;
+        targets |= single;
+        if (row == BOARD_SIZE - 2)
+        {
+            targets |= (single >> BOARD_SIZE) & empty;
+        }
+    }
+    else
+    {
+        Bitboard single = (SQUARE_BIT(square) << BOARD_SIZE) & empty;
+        targets |= single;
+        if (row == 1)
+        {
+            targets |= (single << BOARD_SIZE) & empty;
+        }
+    }
+
+    return targets;
+}
+
+/**
+ * AttacksByTeam
+ *
+ * Union of the attack sets of every piece of a team. Squares occupied by either
+ * team are included when attacked, so friendly pieces show up as "defended".
+ */
+Bitboard AttacksByTeam(const Bitboards *bb, Team team)
+{
+    Bitboard attacks = 0;
+    Bitboard occupied = bb->occupied;
+
+    for (int type = PIECE_KING; type < PIECE_TYPE_COUNT; type++)
+    {
+        Bitboard pieces = bb->pieces[team][type];
+        while (pieces)
+        {
+            attacks |= PieceAttacks((PieceType)type, team, PopLowestSquare(&pieces), occupied);
+        }
+    }
+
+    return attacks;
+}
+
+/**
+ * AttackersTo
+ *
+ * Every piece (of both teams) attacking square, assuming the given occupancy.
+ * Passing a modified occupancy lets callers look "through" a piece that is about to move.
+ */
+Bitboard AttackersTo(const Bitboards *bb, int square, Bitboard occupied)
+{
+    Bitboard rookLike = bb->pieces[TEAM_WHITE][PIECE_ROOK] | bb->pieces[TEAM_BLACK][PIECE_ROOK] |
+                        bb->pieces[TEAM_WHITE][PIECE_QUEEN] | bb->pieces[TEAM_BLACK][PIECE_QUEEN];
+    Bitboard bishopLike = bb->pieces[TEAM_WHITE][PIECE_BISHOP] | bb->pieces[TEAM_BLACK][PIECE_BISHOP] |
+                          bb->pieces[TEAM_WHITE][PIECE_QUEEN] | bb->pieces[TEAM_BLACK][PIECE_QUEEN];
+
+    return (PawnAttackTable[TEAM_BLACK][square] & bb->pieces[TEAM_WHITE][PIECE_PAWN]) |
+           (PawnAttackTable[TEAM_WHITE][square] & bb->pieces[TEAM_BLACK][PIECE_PAWN]) |
+           (KnightAttackTable[square] & (bb->pieces[TEAM_WHITE][PIECE_KNIGHT] | bb->pieces[TEAM_BLACK][PIECE_KNIGHT])) |
+           (KingAttackTable[square] & (bb->pieces[TEAM_WHITE][PIECE_KING] | bb->pieces[TEAM_BLACK][PIECE_KING])) |
+           (RookAttacks(square, occupied) & rookLike) |
+           (BishopAttacks(square, occupied) & bishopLike);
+}
+
+/**
+ * IsSquareAttacked
+ *
+ * Returns true if any piece of byTeam attacks square.
+ * Works backwards from the square, so it costs a handful of lookups instead of a board scan.
+ */
+bool IsSquareAttacked(const Bitboards *bb, int square, Team byTeam)
+{
+    const Bitboard *them = bb->pieces[byTeam];
+
+    if (PawnAttackTable[byTeam ^ 1][square] & them[PIECE_PAWN])
+    {
+        return true;
+    }
+    if (KnightAttackTable[square] & them[PIECE_KNIGHT])
+    {
+        return true;
+    }
+    if (KingAttackTable[square] & them[PIECE_KING])
+    {
+        return true;
+    }
+    if (RookAttacks(square, bb->occupied) & (them[PIECE_ROOK] | them[PIECE_QUEEN]))
+    {
+        return true;
+    }
+    return (BishopAttacks(square, bb->occupied) & (them[PIECE_BISHOP] | them[PIECE_QUEEN])) != 0;
+}
+
+/**
+ * KingSquare
+ *
+ * Returns the square of the team's king, or -1 when the position has none
+ * (only possible with hand-made FEN strings).
+ */
+int KingSquare(const Bitboards *bb, Team team)
+{
+    Bitboard king = bb->pieces[team][PIECE_KING];
+    return king ? LowestSquare(king) : -1;
+}
+
+/**
+ * BuildAttackMap
+ *
+ * Clear the map and count the attacks of every piece of bb.
+ */
+void BuildAttackMap(AttackMap *map, const Bitboards *bb)
+{
+    memset(map, 0, sizeof *map);
+    UpdateAttackMap(map, bb, bb->occupied);
+}
+
+/**
+ * UpdateAttackMap
+ *
+ * Parameters:
+ *  - map: the map of the position before the change.
+ *  - bb: the position after the change.
+ *  - changed: every square whose content differs (emptied, filled or replaced); a move
+ *    changes two to four squares.
+ *
+ * Behavior:
+ *  - Recounts the pieces that were or are on a changed square, then every other slider
+ *    whose attack set reaches a changed square (see Implementation Details).
+ */
+void UpdateAttackMap(AttackMap *map, const Bitboards *bb, Bitboard changed)
+{
+    Bitboard sliders = 0;
+    for (int team = 0; team < TEAM_COUNT; team++)
+    {
+        sliders |= bb->pieces[team][PIECE_QUEEN] | bb->pieces[team][PIECE_ROOK] | bb->pieces[team][PIECE_BISHOP];
+    }
+    sliders &= ~changed;
+
+    Bitboard squares = changed;
+    while (squares)
+    {
+        RecountSquare(map, bb, PopLowestSquare(&squares));
+    }
+
+    // Uses the attack sets from before the change: those are the rays the change can cut or extend
+    while (sliders)
+    {
+        int square = PopLowestSquare(&sliders);
+        if (map->from[square] & changed)
+        {
+            RecountSquare(map, bb, square);
+        }
+    }
+}
+
+/**
+ * RecountSquare (static)
+ *
+ * Replace the attacks counted for the piece on square by those of the piece bb has there
+ * now (none if the square is empty).
+ */
+static void RecountSquare(AttackMap *map, const Bitboards *bb, int square)
+{
+    Bitboard bit = SQUARE_BIT(square);
+
+    for (int team = 0; team < TEAM_COUNT; team++)
+    {
+        if (!(map->owners[team] & bit))
+        {
+            continue;
+        }
+
+        Bitboard targets = map->from[square];
+        while (targets)
+        {
+            int target = PopLowestSquare(&targets);
+            if (--map->count[team][target] == 0)
+            {
+                map->byTeam[team] &= ~SQUARE_BIT(target);
+            }
+        }
+        map->owners[team] &= ~bit;
+    }
+
+    Team team = TEAM_WHITE;
+    PieceType type = PieceTypeAt(bb, square, &team);
+    if (type == PIECE_NONE)
+    {
+        map->from[square] = 0;
+        return;
+    }
+
+    Bitboard attacks = PieceAttacks(type, team, square, bb->occupied);
+    map->from[square] = attacks;
+    map->owners[team] |= bit;
+    map->byTeam[team] |= attacks;
+    while (attacks)
+    {
+        map->count[team][PopLowestSquare(&attacks)]++;
+    }
+}
+
+/**
+ * OnBoard (static)
+ *
+ * Returns true if (row, col) lies inside the 8x8 board.
+ */
+static bool OnBoard(int row, int col)
+{
+    return row >= 0 && row < BOARD_SIZE && col >= 0 && col < BOARD_SIZE;
+}
+
+/**
+ * LeaperMask (static)
+ *
+ * Build the attack mask of a non-sliding piece from its (row, col) offsets.
+ */
+static Bitboard LeaperMask(int square, const int (*offsets)[2], int count)
+{
+    Bitboard mask = 0;
+    int row = SQUARE_ROW(square);
+    int col = SQUARE_COL(square);
+
+    for (int i = 0; i < count; i++)
+    {
+        int targetRow = row + offsets[i][0];
+        int targetCol = col + offsets[i][1];
+        if (OnBoard(targetRow, targetCol))
+        {
+            mask |= SQUARE_BIT(SQUARE_INDEX(targetRow, targetCol));
+        }
+    }
+
+    return mask;
+}
+
+/**
+ * SlidingAttacks (static)
+ *
+ * Slow reference ray walk used only while building the magic tables.
+ * Each ray stops on (and includes) the first occupied square.
+ */
+static Bitboard SlidingAttacks(int square, Bitboard occupied, const int (*directions)[2])
+{
+    Bitboard attacks = 0;
+
+    for (int i = 0; i < 4; i++)
+    {
+        int row = SQUARE_ROW(square) + directions[i][0];
+        int col = SQUARE_COL(square) + directions[i][1];
+
+        while (OnBoard(row, col))
+        {
+            Bitboard bit = SQUARE_BIT(SQUARE_INDEX(row, col));
+            attacks |= bit;
+            if (occupied & bit)
+            {
+                break;
+            }
+            row += directions[i][0];
+            col += directions[i][1];
+        }
+    }
+
+    return attacks;
+}
+
+/**
+ * RelevantMask (static)
+ *
+ * The occupancy bits that can change a slider's attack set: the rays without their
+ * last square (a piece on the edge never blocks anything behind it).
+ */
+static Bitboard RelevantMask(int square, const int (*directions)[2])
+{
+    Bitboard mask = 0;
+
+    for (int i = 0; i < 4; i++)
+    {
+        int row = SQUARE_ROW(square) + directions[i][0];
+        int col = SQUARE_COL(square) + directions[i][1];
+
+        while (OnBoard(row + directions[i][0], col + directions[i][1]))
+        {
+            mask |= SQUARE_BIT(SQUARE_INDEX(row, col));
+            row += directions[i][0];
+            col += directions[i][1];
+        }
+    }
+
+    return mask;
+}
+
+/**
+ * InitBetween (static)
+ *
+ * Walk every ray from every square and record, for each square reached, the squares
+ * passed on the way there.
+ */
+static void InitBetween(const int (*directions)[2])
+{
+    for (int square = 0; square < SQUARE_COUNT; square++)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            Bitboard path = 0;
+            int row = SQUARE_ROW(square) + directions[i][0];
+            int col = SQUARE_COL(square) + directions[i][1];
+
+            while (OnBoard(row, col))
+            {
+                int target = SQUARE_INDEX(row, col);
+                BetweenTable[square][target] = path;
+                path |= SQUARE_BIT(target);
+                row += directions[i][0];
+                col += directions[i][1];
+            }
+        }
+    }
+}
+
+/**
+ * InitMagics (static)
+ *
+ * For every square: enumerate all subsets of the relevant mask (Carry-Rippler trick)
+ * and store the ray attacks of each subset at its magic index.
+ *
+ * Parameters:
+ *  - magics:       per-square output entries
+ *  - table:        shared attack table, sliced per square
+ *  - magicNumbers: the precomputed multiplier of each square
+ *  - directions:   the four ray directions of the slider
+ */
+static void InitMagics(Magic *magics, Bitboard *table, const Bitboard *magicNumbers, const int (*directions)[2])
+{
+    Bitboard *slice = table;
+
+    for (int square = 0; square < SQUARE_COUNT; square++)
+    {
+        Magic *m = &magics[square];
+        m->mask = RelevantMask(square, directions);
+        m->magic = magicNumbers[square];
+        m->shift = 64 - (unsigned int)BitCount(m->mask);
+        m->table = slice;
+
+        Bitboard subset = 0;
+        do
+        {
+            m->table[(subset * m->magic) >> m->shift] = SlidingAttacks(square, subset, directions);
+            subset = (subset - m->mask) & m->mask;
+        } while (subset);
+
+        slice += (size_t)1 << BitCount(m->mask);
+    }
+}
@@ -0,0 +1,155 @@
+/**
+ * bitboard.h
+ *
+ * Responsibilities:
+ * - Define the Bitboard type and the Bitboards set (one 64-bit mask per team/piece type).
+ * - Export the precomputed attack tables (knight, king, pawn, between-squares) and magic slider lookups.
+ * - Export attack queries used by the rule logic in move.c.
+ *
+ * Conventions:
+ * - Squares are indexed row-major exactly like GameState.board: square = row * 8 + col,
+ *   so square 0 is a8 (top-left on screen) and square 63 is h1.
+ * - White pawns move towards row 0, black pawns towards row 7.
+ * - This module does not include raylib; it only knows about pieces and squares.
+ */
+
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include "piece.h"
+#include "settings.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef uint64_t Bitboard;
+
+/* Number of squares on the board */
+#define SQUARE_COUNT (BOARD_SIZE * BOARD_SIZE)
+
+/* Square <-> (row, col) helpers */
+#define SQUARE_INDEX(row, col) ((row) * BOARD_SIZE + (col))
+#define SQUARE_ROW(square) ((square) / BOARD_SIZE)
+#define SQUARE_COL(square) ((square) % BOARD_SIZE)
+#define SQUARE_BIT(square) ((Bitboard)1 << (square))
+
+/* Squares where (row + col) is odd, i.e. the dark squares (a8 is light) */
+#define DARK_SQUARES 0x55AA55AA55AA55AAULL
+
+/**
+ * Bitboards
+ *
+ * The logical position as a set of 64-bit masks.
+ *
+ * - pieces[team][type]: every square holding a piece of that team and type
+ *   (the PIECE_NONE slot is always empty).
+ * - teams[team]: union of all pieces of a team.
+ * - occupied: union of both teams.
+ *
+ * The whole struct is 128 bytes, so copying it to simulate a move is cheap.
+ */
+typedef struct Bitboards
+{
+    Bitboard pieces[TEAM_COUNT][PIECE_TYPE_COUNT];
+    Bitboard teams[TEAM_COUNT];
+    Bitboard occupied;
+} Bitboards;
+
+/**
+ * AttackMap
+ *
+ * Who attacks what, kept up to date move by move with UpdateAttackMap instead of being
+ * rebuilt from every piece.
+ *
+ * - from[square]: squares attacked by the piece on square (0 for an empty square).
+ * - count[team][square]: how many pieces of team attack square.
+ * - byTeam[team]: squares team attacks (count > 0); same as AttacksByTeam.
+ * - owners[team]: squares whose from[] is counted for team (the team's pieces as of the
+ *   last update).
+ *
+ * An all-zero map matches an empty board.
+ */
+typedef struct AttackMap
+{
+    Bitboard from[SQUARE_COUNT];
+    uint8_t count[TEAM_COUNT][SQUARE_COUNT];
+    Bitboard byTeam[TEAM_COUNT];
+    Bitboard owners[TEAM_COUNT];
+} AttackMap;
+
+/* Precomputed leaper tables (filled by InitBitboards) */
+extern Bitboard KnightAttackTable[SQUARE_COUNT];
+extern Bitboard KingAttackTable[SQUARE_COUNT];
+extern Bitboard PawnAttackTable[TEAM_COUNT][SQUARE_COUNT];
+
+/* Squares strictly between two squares on a shared rank, file or diagonal (0 if not aligned) */
+extern Bitboard BetweenTable[SQUARE_COUNT][SQUARE_COUNT];
+
+/* Builds the leaper tables and the magic slider tables. Call once at startup */
+void InitBitboards(void);
+
+/* Empties every mask */
+void ClearBitboards(Bitboards *bb);
+
+/* Adds a piece to the masks (square must be empty) */
+void PlacePieceBB(Bitboards *bb, int square, PieceType type, Team team);
+
+/* Removes a piece from the masks */
+void RemovePieceBB(Bitboards *bb, int square, PieceType type, Team team);
+
+/* Returns the piece type on a square (PIECE_NONE if empty) and writes its team to *team if non-NULL */
+PieceType PieceTypeAt(const Bitboards *bb, int square, Team *team);
+
+/* Rook attacks from square given the occupancy */
+Bitboard RookAttacks(int square, Bitboard occupied);
+
+/* Bishop attacks from square given the occupancy */
+Bitboard BishopAttacks(int square, Bitboard occupied);
+
+/* Queen attacks from square given the occupancy */
+Bitboard QueenAttacks(int square, Bitboard occupied);
+
+/* Squares a piece of the given type/team attacks from square */
+Bitboard PieceAttacks(PieceType type, Team team, int square, Bitboard occupied);
+
+/* Pseudo-legal destinations of a piece (pushes, captures; no castling or en passant) */
+Bitboard PieceTargets(const Bitboards *bb, int square, PieceType type, Team team);
+
+/* Every square attacked by the given team */
+Bitboard AttacksByTeam(const Bitboards *bb, Team team);
+
+/* Rebuilds the whole map from the masks */
+void BuildAttackMap(AttackMap *map, const Bitboards *bb);
+
+/* Updates the map after the squares in changed gained, lost or swapped a piece (bb is the new position) */
+void UpdateAttackMap(AttackMap *map, const Bitboards *bb, Bitboard changed);
+
+/* Pieces of both teams attacking square, using a custom occupancy */
+Bitboard AttackersTo(const Bitboards *bb, int square, Bitboard occupied);
+
+/* Returns true if byTeam attacks square */
+bool IsSquareAttacked(const Bitboards *bb, int square, Team byTeam);
+
+/* Square of the team's king, or -1 if it has none */
+int KingSquare(const Bitboards *bb, Team team);
+
+/* Number of set bits */
+static inline int BitCount(Bitboard bb)
+{
+    return __builtin_popcountll(bb);
+}
+
+/* Index of the least significant set bit (bb must be non-zero) */
+static inline int LowestSquare(Bitboard bb)
+{
+    return __builtin_ctzll(bb);
+}
+
+/* Returns the least significant set square and clears it from *bb (*bb must be non-zero) */
+static inline int PopLowestSquare(Bitboard *bb)
+{
+    int square = __builtin_ctzll(*bb);
+    *bb &= *bb - 1;
+    return square;
+}
+
+#endif /* BITBOARD_H */
@@ -0,0 +1,67 @@
+/**
+ * book.h
+ *
+ * Responsibilities:
+ * - Export Polyglot (.bin) opening book support: the Polyglot position key, opening a
+ *   book (memory-mapped) and probing it for the book moves of a position.
+ *
+ * Notes:
+ * - A Polyglot book is a sorted array of 16-byte big-endian entries (key, move, weight,
+ *   learn). Its keys come from the fixed Polyglot Random64 table, not from zobrist.c, so
+ *   PolyglotKey is computed separately from Position.key.
+ * - An open book is read-only: the engine and the GUI may probe it at the same time.
+ * - This module does not include raylib; it is part of libchesscore (see chesscore.h).
+ */
+
+#ifndef BOOK_H
+#define BOOK_H
+
+#include "movegen.h"
+#include "position.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Most book moves ProbeOpeningBook reports for one position */
+#define MAX_BOOK_MOVES 32
+
+/**
+ * BookMove
+ *
+ * A legal move of the probed position found in the book, with its Polyglot weight
+ * (relative frequency: the higher, the more often the move should be played).
+ */
+typedef struct BookMove
+{
+    ChessMove move;
+    uint16_t weight;
+} BookMove;
+
+/**
+ * OpeningBook
+ *
+ * An open (mapped) book of entryCount entries.
+ */
+typedef struct OpeningBook
+{
+    const unsigned char *data;
+    size_t size;
+    size_t entryCount;
+} OpeningBook;
+
+/* Maps the Polyglot book at path. Returns false (book empty) if it cannot be mapped or is not a whole number of entries */
+bool OpenOpeningBook(OpeningBook *book, const char *path);
+
+/* Unmaps the book */
+void CloseOpeningBook(OpeningBook *book);
+
+/* Returns the Polyglot key of pos */
+uint64_t PolyglotKey(const Position *pos);
+
+/* Writes the legal book moves of pos (up to max, in book order) and returns their count */
+int ProbeOpeningBook(const OpeningBook *book, const Position *pos, BookMove *moves, int max);
+
+/* Picks one of count book moves with a probability proportional to its weight; random is any 64-bit random value */
+ChessMove PickBookMove(const BookMove *moves, int count, uint64_t random);
+
+#endif /* BOOK_H */
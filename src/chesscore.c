@@ -0,0 +1,72 @@
+/**
+ * chesscore.c
+ *
+ * Responsibilities:
+ * - One-time initialization of libchesscore.
+ * - The monotonic clock of the core and the tools (MonotonicSeconds).
+ */
+
+// clock_gettime and CLOCK_MONOTONIC are POSIX, not C17
+#define _POSIX_C_SOURCE 200809L
+
+#include "chesscore.h"
+#include "bitboard.h"
+#include "nnue.h"
+#include "psqt.h"
+#include "tablebase.h"
+#include "zobrist.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+/**
+ * InitChessCore
+ *
+ * Fill the bitboard attack tables, the Zobrist key tables, the piece-square tables and
+ * the Syzygy index tables, and pick the NNUE kernels for this CPU.
+ *
+ * Notes:
+ *  - Not thread-safe; call it from the main thread before starting any worker.
+ */
+void InitChessCore(void)
+{
+    static bool initialized = false;
+
+    if (initialized)
+    {
+        return;
+    }
+
+    InitBitboards();
+    InitZobrist();
+    InitPsqt();
+    InitTablebase();
+    InitNnue();
+    initialized = true;
+}
+
+/**
+ * MonotonicNanoseconds
+ *
+ * Nanoseconds since an arbitrary point (CLOCK_MONOTONIC). Time limits and benchmarks use
+ * this clock: a wall clock (TIME_UTC) steps when NTP or the user sets the time, which
+ * could end a search early, let it overrun or make an interval negative.
+ */
+uint64_t MonotonicNanoseconds(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+/**
+ * MonotonicSeconds
+ */
+double MonotonicSeconds(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
@@ -0,0 +1,60 @@
+/**
+ * chesscore.h
+ *
+ * Responsibilities:
+ * - Single public header of libchesscore, the headless rules library.
+ * - Export InitChessCore, which prepares every lookup table the core needs.
+ * - Export the monotonic clock every search limit and tool timing is measured with.
+ *
+ * Library contents:
+ * - position.h: Position, FEN in/out, MakeMove/UnmakeMove.
+ * - movegen.h:  ChessMove encoding, legal move generation, check detection.
+ * - bitboard.h: bitboards and attack tables.
+ * - zobrist.h:  position keys.
+ * - psqt.h:     tapered piece-square tables (kept in Position by MakeMove).
+ * - hash.h:     history of position keys (repetition detection).
+ * - pgn.h:      SAN conversion, streaming PGN reader and PGN writer.
+ * - gamedb.h:   memory-mapped game database with a position index.
+ * - book.h:     Polyglot opening books (memory-mapped, binary search probe).
+ * - tablebase.h: Syzygy endgame tablebases (WDL/DTZ files mapped on first use).
+ *
+ * Notes:
+ * - Nothing in the core includes raylib or touches the GUI's GameState; it links with
+ *   the C library only, so it runs on machines without a display or an audio device.
+ * - The GUI (chess target) links against this library.
+ */
+
+#ifndef CHESSCORE_H
+#define CHESSCORE_H
+
+#include "bitboard.h"
+#include "book.h"
+#include "gamedb.h"
+#include "hash.h"
+#include "movegen.h"
+#include "pgn.h"
+#include "piece.h"
+#include "position.h"
+#include "psqt.h"
+#include "tablebase.h"
+#include "zobrist.h"
+#include <stdint.h>
+#include <stdio.h>
+
+/* Builds the attack, key and piece-square tables. Call once before using any other core function (repeat calls are no-ops) */
+void InitChessCore(void);
+
+/* Seconds on CLOCK_MONOTONIC: only differences are meaningful, and they never jump with the system time */
+double MonotonicSeconds(void);
+
+/* The same clock in nanoseconds */
+uint64_t MonotonicNanoseconds(void);
+
+/* Debug diagnostics of the core modules: stderr in DEBUG builds, compiled out otherwise */
+#ifdef DEBUG
+#define CORE_DEBUG_LOG(...) (fprintf(stderr, __VA_ARGS__), fputc('\n', stderr))
+#else
+#define CORE_DEBUG_LOG(...) ((void)0)
+#endif
+
+#endif /* CHESSCORE_H */
@@ -50,6 +50,14 @@
 // Indicator for valid move destinations (dots/circles)
 #define VALID_MOVE_COLOR CLITERAL(Color){100, 100, 100, 100}
 
+// Valid move destinations that are also opening book moves
+#define BOOK_MOVE_COLOR CLITERAL(Color){0, 158, 47, 170}
+
+// Analysis hints: eval bar halves and best-move arrow
+#define EVAL_BAR_WHITE_COLOR CLITERAL(Color){235, 235, 235, 255}
+#define EVAL_BAR_BLACK_COLOR CLITERAL(Color){40, 40, 40, 255}
+#define ANALYSIS_ARROW_COLOR CLITERAL(Color){0, 121, 241, 160}
+
 #define DEBUG_TEXT_COLOR WHITE
 #define STATUS_TEXT_COLOR WHITE
 
@@ -5,38 +5,44 @@
  * - Compute board layout and cell positions based on current window size.
  * - Render the chess board and pieces, including rank/file annotations.
  * - Manage interactive selection state, highlight borders, and last-move feedback.
- * - Load piece images from disk, convert to Texture2D and assign them to GameBoard cells.
+ * - Draw the pieces of the GameBoard cells from the shared piece atlas (atlas.c); placing
+ *   them (LoadPiece) is part of the game model in move.c.
  * - Render UI overlays for Game Status, Debug Info, and Promotion.
  *
  * Public functions (exported in draw.h):
- * - void DrawBoard(int ColorTheme, bool showFileRank);
+ * - void DrawBoard(int ColorTheme, bool showFileRank, Color background);
  *     Renders the board and all pieces. Should be called each frame inside
- *     BeginDrawing()/EndDrawing(). Computes layout for the current window size
- *     and calls display routines.
- *
- * - void LoadPiece(int row, int col, PieceType type, Team team, LoadPlace place);
- *     Loads a piece image from assets/ and assigns the resulting Texture2D to
- *     GameBoard[row][col].piece.texture. If a texture already exists in that
- *     cell it is UnloadTexture()'d before assignment. Caller must ensure row/col
- *     are in [0,7].
+ *     BeginDrawing()/EndDrawing(). Keeps the layout and the board layer of the
+ *     current window size up to date and draws the pieces.
  *
  * - int ComputeSquareLength(void);
  *     Returns the computed size (in pixels) of a single board square using the
  *     current render width/height. Useful to compute positions/resources from
  *     main after InitWindow() or after a resize event.
  *
+ * - void UnloadBoardLayer(void);
+ *     Releases the cached board layer (GPU render texture) before the window closes.
+ *
  * - void DrawGameStatus(void);
  *     Renders the game over / check status message.
  *
  * - void DrawDebugInfo(void);
  *     Renders debug information overlay.
  *
+ * - void DrawAnalysisHints(void);
+ *     Renders the eval bar and best-move arrow of the background analysis (analysis.c).
+ *
+ * - PROFILE builds: DrawDebugInfo also renders the profiler panel (profile.c), and
+ *   DrawBoard is a timed zone.
+ *
  * Notes / conventions:
- * - Filenames are generated as "assets/<piece><W|B>.png" (example: assets/kingW.png).
- * - TrimTrailingWhitespace removes trailing whitespace (useful if names come from
- *   user input). On Linux trailing spaces are significant in filenames so avoid them.
- * - LoadPiece will log warnings on failure (TraceLog). After LoadPiece returns,
- *   check GameBoard[row][col].piece.texture.id to confirm success (non-zero).
+ * - Piece images are loaded once at startup by LoadPieceAtlas (atlas.c); cells only
+ *   store type/team and every piece is drawn with DrawPieceSprite.
+ * - The layout (square size, centering offsets, cell positions) is recomputed only when
+ *   the render size changes, and the squares with their rank/file labels are rendered
+ *   once into a RenderTexture2D (the board layer) that is rebuilt only when the layout,
+ *   the theme, the labels toggle or the background changes. A frame draws that texture
+ *   and the position-dependent parts (highlights, borders, pieces) on top of it.
  * - This module uses static (file-local) helper functions. None of them are
  *   thread-safe; all operations are expected to be called from the main thread.
  * - Selection helpers (DecideDestination/SmartBorder utilities) store state between
@@ -44,17 +50,22 @@
  */
 
 #include "draw.h"
+#include "analysis.h"
+#include "atlas.h"
 #include "colors.h"
 #include "main.h"
 #include "move.h"
+#include "opponent.h"
+#include "profile.h"
 #include "raylib.h"
 #include "settings.h"
 #include "stack.h"
-#include <ctype.h>
+#include "tablebase.h"
 #include <math.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 /* Used in Make selected and last move borders */
@@ -64,23 +75,43 @@ typedef struct SmartBorder
     Rectangle rect;
 } SmartBorder;
 
+/* Layout of the board for one render size, and the cached board layer drawn with it */
+typedef struct BoardLayer
+{
+    int renderWidth, renderHeight; // render size the layout was computed for (0: none yet)
+    int squareLength;
+    int extraX, extraY; // centering offsets
+    RenderTexture2D texture;
+    bool textureValid;  // texture holds the squares for the fields below
+    bool textureFailed; // no render texture for this render size: draw the squares directly
+    int theme;
+    bool showFileRank;
+    Color background;
+} BoardLayer;
+
 // Local Prototypes
 static int Min2(int num1, int num2);
-static void LoadHelper(char *pieceNameBuffer, int bufferSize, const char *pieceName, Team team, int row, int col, PieceType type, LoadPlace place);
 // CHANGED: Added extraY parameter
 static void InitializeCellsPos(int extraX, int extraY, int squareLength, float spaceText);
-static size_t TrimTrailingWhitespace(char *string);
-static void displayPieces(void);
+static void UpdateBoardLayout(void);
+static void UpdateBoardLayer(int ColorTheme, bool showFileRank, Color background);
+static void DrawBoardSquares(int ColorTheme, bool showFileRank);
+static bool SameColor(Color color1, Color color2);
+static void displayPieces(float squareLength);
 static void DecideDestination(Vector2 topLeft);
 static bool CompareCells(Cell *cell1, Cell *cell2);
 static void swap(int *num1, int *num2);
 static void SetCellBorder(SmartBorder *border, Cell *selectedPiece);
 static void ResetCellBorder(SmartBorder *border);
 static void ResizeCellBorder(SmartBorder *border);
-static void ResetSelection();
 static int Clamp(int num, int max);
 static void HandlePromotionInput(void);
 static void DrawPromotionMenu(void); // <--- ADD THIS PROTOTYPE
+static void DrawEvalBar(int score);
+static void DrawBestMoveArrow(ChessMove move);
+#ifdef PROFILE
+static void DrawProfileInfo(void);
+#endif
 
 // This constant determines How much space is left for the text in terms of squareLength
 #define SPACE_TEXT 0.75f
@@ -100,34 +131,102 @@ Cell imaginaryCell = {.row = -1, .col = -1};
 SmartBorder selectedCellBorder = {.rect.x = -1, .rect.y = -1};
 SmartBorder lastMoveCellBorder = {.rect.x = -1, .rect.y = -1};
 
+static BoardLayer boardLayer = {0};
+
 /**
  * DrawBoard
  *
- * Compute layout based on current render size and draw the board and pieces.
+ * Draw the board and pieces for the current render size.
  *
  * Parameters:
- *  - ColorTheme: index into PALETTE (colors.h)
+ *  - ColorTheme: index into PALETTE (colors.h)
  *  - showFileRank: if true, draws rank (1-8) and file (a-h) labels on the board.
+ *  - background: window background color (the board layer is opaque and covers the
+ *                whole render area).
  *
  * Behavior:
- *  - Calls ComputeSquareLength() to obtain square size (in pixels).
- *  - Initializes cell positions (InitializeCellsPos) using the computed values.
- *  - Draws the 8x8 board using the chosen ColorPair.
- *  - Calls displayPieces() to render piece textures at computed positions.
+ *  - Recomputes the layout and cell positions when the render size changed (UpdateBoardLayout).
+ *  - Draws the board layer, re-rendering it first if its inputs changed (UpdateBoardLayer);
+ *    if no render texture could be created the squares are drawn directly.
+ *  - Handles board clicks, draws the selection and last-move borders, then calls
+ *    displayPieces() to draw the piece sprites at the computed positions.
  */
-void DrawBoard(int ColorTheme, bool showFileRank)
+void DrawBoard(int ColorTheme, bool showFileRank, Color background)
 {
-    ColorPair theme = PALETTE[ColorTheme];
+    PROFILE_SCOPE(PROFILE_DRAW_BOARD);
+
+    UpdateBoardLayout();
+    UpdateBoardLayer(ColorTheme, showFileRank, background);
+
+    int squareLength = boardLayer.squareLength;
+    if (boardLayer.textureValid)
+    {
+        // Render textures are stored bottom-up: flip the source rectangle
+        Rectangle source = {0, 0, (float)boardLayer.texture.texture.width, -(float)boardLayer.texture.texture.height};
+        DrawTextureRec(boardLayer.texture.texture, source, (Vector2){0, 0}, WHITE);
+    }
+    else
+    {
+        DrawBoardSquares(ColorTheme, showFileRank);
+    }
+
+    DecideDestination(GameBoard[0][0].pos);
+
+    if (IsWindowResized())
+    {
+        ResizeCellBorder(&selectedCellBorder);
+        ResizeCellBorder(&lastMoveCellBorder);
+    }
+
+    int borderThickness = (int)round(squareLength / (double)CELL_BORDER_THICKNESS_COEFFICIENT);
+
+    if (selectedCellBorder.rect.x != -1 && selectedCellBorder.rect.y != -1)
+    {
+        DrawRectangleLinesEx(selectedCellBorder.rect, (float)borderThickness, SELECTED_BORDER_COLOR);
+    }
+
+    if (lastMoveCellBorder.rect.x != -1 && lastMoveCellBorder.rect.y != -1)
+    {
+        DrawRectangleLinesEx(lastMoveCellBorder.rect, (float)borderThickness, LAST_MOVE_BORDER_COLOR);
+    }
+
+    displayPieces((float)squareLength);
+
+    // <--- ADD THIS BLOCK AT THE END OF DrawBoard
+    if (state.isPromoting)
+    {
+        DrawPromotionMenu();
+    }
+
+    DrawGameStatus();
+}
+
+/**
+ * UpdateBoardLayout (static)
+ *
+ * Compute the square size, the centering offsets and the cell positions, but only when
+ * the render size differs from the one they were computed for (a resize invalidates the
+ * board layer too).
+ */
+static void UpdateBoardLayout(void)
+{
+    int renderWidth = GetRenderWidth();
+    int renderHeight = GetRenderHeight();
+    if (renderWidth == boardLayer.renderWidth && renderHeight == boardLayer.renderHeight)
+    {
+        return;
+    }
+
     float squareCount = BOARD_SIZE + SPACE_TEXT;
     int squareLength = ComputeSquareLength();
 
     // Horizontal Centering
-    int extraX = (int)((float)GetRenderWidth() - (squareCount * (float)squareLength)) / 2;
+    int extraX = (int)((float)renderWidth - (squareCount * (float)squareLength)) / 2;
 
     // NEW: Vertical Centering
     // Calculate how much vertical space the board + padding actually takes
     float verticalSquares = BOARD_SIZE + SPACE_TEXT + TOP_SECTION_SQUARES;
-    int extraY = (int)((float)GetRenderHeight() - (verticalSquares * (float)squareLength)) / 2;
+    int extraY = (int)((float)renderHeight - (verticalSquares * (float)squareLength)) / 2;
 
     // Safety clamp
     if (extraY < 0)
@@ -138,6 +237,79 @@ void DrawBoard(int ColorTheme, bool showFileRank)
     // Pass both offsets to the initialization function
     InitializeCellsPos(extraX, extraY, squareLength, SPACE_TEXT);
 
+    boardLayer.renderWidth = renderWidth;
+    boardLayer.renderHeight = renderHeight;
+    boardLayer.squareLength = squareLength;
+    boardLayer.extraX = extraX;
+    boardLayer.extraY = extraY;
+    boardLayer.textureValid = false;
+    boardLayer.textureFailed = false;
+}
+
+/**
+ * UpdateBoardLayer (static)
+ *
+ * Re-render the board layer if the layout, the theme, the labels toggle or the
+ * background changed since it was last rendered.
+ *
+ * Behavior:
+ *  - (Re)creates the render texture at the render size when needed; if that fails (or
+ *    the window is minimized) the layer stays invalid until the next resize and DrawBoard
+ *    draws the squares every frame instead.
+ *  - The texture is cleared to the background first, so it is fully opaque and the
+ *    anti-aliased label edges blend exactly as they would on the window.
+ */
+static void UpdateBoardLayer(int ColorTheme, bool showFileRank, Color background)
+{
+    if (boardLayer.textureFailed ||
+        (boardLayer.textureValid && boardLayer.theme == ColorTheme && boardLayer.showFileRank == showFileRank && SameColor(boardLayer.background, background)))
+    {
+        return;
+    }
+
+    RenderTexture2D *texture = &boardLayer.texture;
+    if (texture->id == 0 || texture->texture.width != boardLayer.renderWidth || texture->texture.height != boardLayer.renderHeight)
+    {
+        if (texture->id != 0)
+        {
+            UnloadRenderTexture(*texture);
+            *texture = (RenderTexture2D){0};
+        }
+        if (boardLayer.renderWidth > 0 && boardLayer.renderHeight > 0)
+        {
+            *texture = LoadRenderTexture(boardLayer.renderWidth, boardLayer.renderHeight);
+        }
+        if (texture->id == 0)
+        {
+            TraceLog(LOG_WARNING, "DrawBoard: no %dx%d board layer, drawing the squares every frame", boardLayer.renderWidth, boardLayer.renderHeight);
+            boardLayer.textureValid = false;
+            boardLayer.textureFailed = true;
+            return;
+        }
+    }
+
+    BeginTextureMode(*texture);
+    ClearBackground(background);
+    DrawBoardSquares(ColorTheme, showFileRank);
+    EndTextureMode();
+
+    boardLayer.textureValid = true;
+    boardLayer.theme = ColorTheme;
+    boardLayer.showFileRank = showFileRank;
+    boardLayer.background = background;
+}
+
+/**
+ * DrawBoardSquares (static)
+ *
+ * Draw the 8x8 squares in the theme colors and, if showFileRank, the rank and file
+ * labels, at the positions of the current layout.
+ */
+static void DrawBoardSquares(int ColorTheme, bool showFileRank)
+{
+    ColorPair theme = PALETTE[ColorTheme];
+    int squareLength = boardLayer.squareLength;
+
     // Draw the chess board (row = y, col = x)
     for (int row = 0; row < BOARD_SIZE; row++)
     {
@@ -152,7 +324,7 @@ void DrawBoard(int ColorTheme, bool showFileRank)
     if (showFileRank)
     {
         //  compute once (matches InitializeCellsPos math)
-        float boardLeft = (float)extraX + ((float)squareLength * SPACE_TEXT / 2);
+        float boardLeft = (float)boardLayer.extraX + ((float)squareLength * SPACE_TEXT / 2);
 
         // Draw rank numbers (left) and file letters (bottom), centered in each square.
         int fontSize = (int)((float)squareLength / FONT_SQUARE_LENGTH_COEFFICIENT);
@@ -187,182 +359,29 @@ void DrawBoard(int ColorTheme, bool showFileRank)
             DrawText(fileText, (int)textPosX, (int)textPosY, fontSize, FONT_COLOR);
         }
     }
-
-    DecideDestination(GameBoard[0][0].pos);
-
-    if (IsWindowResized())
-    {
-        ResizeCellBorder(&selectedCellBorder);
-        ResizeCellBorder(&lastMoveCellBorder);
-    }
-
-    int borderThickness = (int)round(squareLength / (double)CELL_BORDER_THICKNESS_COEFFICIENT);
-
-    if (selectedCellBorder.rect.x != -1 && selectedCellBorder.rect.y != -1)
-    {
-        DrawRectangleLinesEx(selectedCellBorder.rect, (float)borderThickness, SELECTED_BORDER_COLOR);
-    }
-
-    if (lastMoveCellBorder.rect.x != -1 && lastMoveCellBorder.rect.y != -1)
-    {
-        DrawRectangleLinesEx(lastMoveCellBorder.rect, (float)borderThickness, LAST_MOVE_BORDER_COLOR);
-    }
-
-    displayPieces();
-
-    // <--- ADD THIS BLOCK AT THE END OF DrawBoard
-    if (state.isPromoting)
-    {
-        DrawPromotionMenu();
-    }
-
-    DrawGameStatus();
 }
 
 /**
- * LoadPiece
- *
- * Public helper to load a piece texture and store it in GameBoard[row][col].
- * It selects the filename by piece type and team and delegates to LoadHelper.
- *
- * Parameters:
- *  - row, col : board coordinates (0..7)
- *  - type     : PieceType enum
- *  - team     : TEAM_WHITE or TEAM_BLACK
- *  - LoadPlace: this allows us to use the function for multiple purposes (it takes an enum)
- *
- * Safety:
- *  - Performs bounds check on row/col.
- *  - LoadHelper handles logging and texture assignment.
+ * SameColor (static)
  */
-void LoadPiece(int row, int col, PieceType type, Team team, LoadPlace place)
+static bool SameColor(Color color1, Color color2)
 {
-    if (place == GAME_BOARD)
-    {
-        if (row < 0 || row >= BOARD_SIZE || col < 0 || col >= BOARD_SIZE)
-        {
-            return;
-        }
-    }
-    else if (place == DEAD_WHITE_PIECES || place == DEAD_BLACK_PIECES)
-    {
-        if (row < 0 || row >= 2 * BOARD_SIZE)
-        {
-            return;
-        }
-    }
-
-    char pieceName[MAX_PIECE_NAME_BUFFER_SIZE + 1];
-
-    switch (type)
-    {
-    case PIECE_PAWN:
-        LoadHelper(pieceName, sizeof pieceName, "pawn", team, row, col, type, place);
-        break;
-    case PIECE_KNIGHT:
-        LoadHelper(pieceName, sizeof pieceName, "knight", team, row, col, type, place);
-        break;
-    case PIECE_BISHOP:
-        LoadHelper(pieceName, sizeof pieceName, "bishop", team, row, col, type, place);
-        break;
-    case PIECE_ROOK:
-        LoadHelper(pieceName, sizeof pieceName, "rook", team, row, col, type, place);
-        break;
-    case PIECE_QUEEN:
-        LoadHelper(pieceName, sizeof pieceName, "queen", team, row, col, type, place);
-        break;
-    case PIECE_KING:
-        LoadHelper(pieceName, sizeof pieceName, "king", team, row, col, type, place);
-        break;
-    default:
-        break;
-    }
+    return color1.r == color2.r && color1.g == color2.g && color1.b == color2.b && color1.a == color2.a;
 }
 
 /**
- * LoadHelper (static)
+ * displayPieces (static)
  *
- * Build filename, load image, resize, create texture, and assign to GameBoard cell.
- * This function logs failures and ensures any existing texture in the target cell
- * is unloaded before assigning the new one.
+ * Draw every piece stored in GameBoard and the dead-piece rows. Cells holding
+ * PIECE_NONE are skipped. Sprites come from the piece atlas and are placed at the
+ * precomputed Cell.pos position (dead pieces are drawn at a quarter of a square).
  *
  * Parameters:
- *  - pieceNameBuffer, bufferSize: output buffer for the generated filename
- *  - pieceName: base name (e.g. "king", "pawn")
- *  - team: TEAM_WHITE/TEAM_BLACK
- *  - squareLength: resize dimension
- *  - row/col: target cell coordinates
- *  - type: PieceType to set on the cell
+ *  - squareLength: square size of the current layout.
  */
-static void LoadHelper(char *pieceNameBuffer, int bufferSize, const char *pieceName, Team team, int row, int col, PieceType type, LoadPlace place)
+static void displayPieces(float squareLength) // and DeadPieces
 {
-    /*This function loads the texture for any given piece correctly and handles errors
-    and puts a new texture if one already exists at this cell*/
-
-    int length = snprintf(pieceNameBuffer, (size_t)bufferSize, "assets/pieces/%s%c.png", pieceName, (team == TEAM_WHITE) ? 'W' : 'B');
-    if (length < 0)
-    {
-        return;
-    }
-    if (length >= bufferSize)
-    {
-        TraceLog(LOG_WARNING, "Filename was truncated: %s", pieceNameBuffer);
-    }
-
-    TrimTrailingWhitespace(pieceNameBuffer);
-
-    Texture2D texture = LoadTexture(pieceNameBuffer);
 
-    if (texture.id == 0 || texture.width == 0 || texture.height == 0)
-    {
-        TraceLog(LOG_WARNING, "Failed to load texture: %s", pieceNameBuffer);
-        return;
-    }
-
-    if (texture.width != texture.height)
-    {
-        TraceLog(LOG_WARNING, "Invalid texture Error, texture's width must equal it's height");
-        return;
-    }
-
-    if (place == GAME_BOARD)
-    {
-        // unload previous texture if present
-        if (GameBoard[row][col].piece.texture.id != 0)
-        {
-            UnloadTexture(GameBoard[row][col].piece.texture);
-        }
-
-        // Add the piece to the GameBoard
-        GameBoard[row][col].piece.texture = texture;
-        GameBoard[row][col].piece.type = type;
-        GameBoard[row][col].piece.team = team;
-    }
-    else if (place == DEAD_WHITE_PIECES)
-    {
-        printf("Loaded a piece in dead white.\n");
-        DeadWhitePieces[row].piece.texture = texture;
-        DeadWhitePieces[row].piece.type = type;
-        DeadWhitePieces[row].piece.team = team;
-    }
-    else if (place == DEAD_BLACK_PIECES)
-    {
-        DeadBlackPieces[row].piece.texture = texture;
-        DeadBlackPieces[row].piece.type = type;
-        DeadBlackPieces[row].piece.team = team;
-    }
-}
-
-/**
- * displayPieces (static)
- *
- * Draw all loaded piece textures stored in GameBoard. If a cell's piece type
- * is PIECE_NONE it is skipped. Uses DrawTextureEx to place the texture at the
- * precomputed GameBoard[row][col].pos position.
- *
- */
-static void displayPieces(void) // and DeadPieces
-{
     // Draw pieces using same row/col ordering
     for (int row = 0; row < BOARD_SIZE; row++)
     {
@@ -370,7 +389,7 @@ static void displayPieces(void) // and DeadPieces
         {
             if (GameBoard[row][col].piece.type != PIECE_NONE)
             {
-                DrawTextureEx(GameBoard[row][col].piece.texture, GameBoard[row][col].pos, 0, (float)ComputeSquareLength() / (float)GameBoard[row][col].piece.texture.width, WHITE);
+                DrawPieceSprite(GameBoard[row][col].piece.type, GameBoard[row][col].piece.team, GameBoard[row][col].pos, squareLength);
             }
         }
     }
@@ -380,7 +399,7 @@ static void displayPieces(void) // and DeadPieces
     {
         if (DeadWhitePieces[row].piece.type != PIECE_NONE)
         {
-            DrawTextureEx(DeadWhitePieces[row].piece.texture, DeadWhitePieces[row].pos, 0, (float)ComputeSquareLength() / (4 * (float)DeadWhitePieces[row].piece.texture.width), WHITE);
+            DrawPieceSprite(DeadWhitePieces[row].piece.type, DeadWhitePieces[row].piece.team, DeadWhitePieces[row].pos, squareLength / 4);
         }
     }
 
@@ -389,7 +408,7 @@ static void displayPieces(void) // and DeadPieces
     {
         if (DeadBlackPieces[row].piece.type != PIECE_NONE)
         {
-            DrawTextureEx(DeadBlackPieces[row].piece.texture, DeadBlackPieces[row].pos, 0, (float)ComputeSquareLength() / (4 * (float)DeadBlackPieces[row].piece.texture.width), WHITE);
+            DrawPieceSprite(DeadBlackPieces[row].piece.type, DeadBlackPieces[row].piece.team, DeadBlackPieces[row].pos, squareLength / 4);
         }
     }
 }
@@ -439,31 +458,6 @@ static void InitializeCellsPos(int extraX, int extraY, int squareLength, float s
     }
 }
 
-/**
- * TrimTrailingWhitespace (static)
- *
- * Remove trailing whitespace from a NUL-terminated C string in-place and return the new length.
- * Whitespace is tested with isspace((unsigned char)c).
- *
- * Returns:
- *  - new length (size_t) after trimming.
- */
-static size_t TrimTrailingWhitespace(char *string)
-{
-    // Check to see if it's an empty sting
-    if (!string)
-    {
-        return 0;
-    }
-    size_t len = strlen(string);
-    while (len > 0 && isspace((unsigned char)string[len - 1]))
-    {
-        len--;
-    }
-    string[len] = '\0';
-    return len;
-}
-
 /**
  * Min2 (static)
  *
@@ -474,23 +468,6 @@ static int Min2(int num1, int num2)
     return num1 < num2 ? num1 : num2;
 }
 
-/**
- * ResetSelection (static)
- *
- * Clears the 'selected' flag for all cells on the board.
- * Used to reset state before processing a new selection.
- */
-static void ResetSelection()
-{
-    for (int i = 0; i < BOARD_SIZE; i++)
-    {
-        for (int j = 0; j < BOARD_SIZE; j++)
-        {
-            GameBoard[i][j].selected = false;
-        }
-    }
-}
-
 /**
  * ComputeSquareLength
  *
@@ -514,106 +491,18 @@ int ComputeSquareLength()
 }
 
 /**
- * InitializeBoard
- *
- * Reset every GameBoard cell to its default coordinates and empty state.
- *
- * Behavior:
- * - Writes the row/col indices into each Cell (used later for lookups).
- * - Calls SetEmptyCell so textures, pieces, and metadata are cleared.
- *
- * Usage:
- * - Call once during startup, or before loading a fresh position.
- * - Textures are not unloaded here; invoke UnloadBoard when replacing assets.
- */
-void InitializeBoard(void)
-{
-    for (int i = 0; i < BOARD_SIZE; i++)
-    {
-        for (int j = 0; j < BOARD_SIZE; j++)
-        {
-            GameBoard[i][j].row = i;
-            GameBoard[i][j].col = j;
-            SetEmptyCell(&GameBoard[i][j]);
-        }
-    }
-}
-
-/**
- * InitializeDeadPieces
- *
- * Initialize the arrays used to track captured pieces (DeadWhitePieces/DeadBlackPieces).
- * Sets all piece types to PIECE_NONE.
- */
-void InitializeDeadPieces(void)
-{
-    for (int row = 0; row < 2 * BOARD_SIZE; row++)
-    {
-        DeadWhitePieces[row].piece.type = PIECE_NONE;
-        DeadBlackPieces[row].piece.type = PIECE_NONE;
-    }
-}
-
-/**
- * UnloadBoard
- *
- * Release all piece textures stored in GameBoard and reset cells to empty.
- *
- * Behavior:
- * - Iterates every cell; if a piece texture is present it is UnloadTexture()'d.
- * - Calls SetEmptyCell afterwards to mark PIECE_NONE and clear metadata.
+ * UnloadBoardLayer
  *
- * Usage:
- * - Invoke when shutting down, reloading themes, or replacing the full board.
- * - Safe to call multiple times; SetEmptyCell handles already-empty cells.
+ * Release the board layer's render texture (call before CloseWindow). The next
+ * DrawBoard recomputes the layout and renders a new layer.
  */
-void UnloadBoard(void)
+void UnloadBoardLayer(void)
 {
-    for (int i = 0; i < BOARD_SIZE; i++)
+    if (boardLayer.texture.id != 0)
     {
-        for (int j = 0; j < BOARD_SIZE; j++)
-        {
-            if (GameBoard[i][j].piece.type != PIECE_NONE)
-            {
-                UnloadTexture(GameBoard[i][j].piece.texture);
-            }
-
-            SetEmptyCell(&GameBoard[i][j]);
-        }
-    }
-}
-
-/**
- * UnloadDeadPieces
- *
- * Release textures associated with captured pieces to free GPU memory.
- * Iterates through DeadWhitePieces and DeadBlackPieces arrays.
- */
-void UnloadDeadPieces(void)
-{
-    for (int row = 0; row < 2 * BOARD_SIZE; row++)
-    {
-        if (DeadWhitePieces[row].piece.type != PIECE_NONE)
-        {
-            UnloadTexture(DeadWhitePieces[row].piece.texture);
-        }
-        else
-        {
-            break;
-        }
-    }
-
-    for (int row = 0; row < 2 * BOARD_SIZE; row++)
-    {
-        if (DeadBlackPieces[row].piece.type != PIECE_NONE)
-        {
-            UnloadTexture(DeadBlackPieces[row].piece.texture);
-        }
-        else
-        {
-            break;
-        }
+        UnloadRenderTexture(boardLayer.texture);
     }
+    boardLayer = (BoardLayer){0};
 }
 
 /**
@@ -635,10 +524,7 @@ void HighlightSquare(int row, int col, int ColorTheme)
     colr.g = Clamp(colr.g + HIGHLIGHT_COLOR_AMOUNT, MAX_VALID_COLOR);
     colr.b = Clamp(colr.b + HIGHLIGHT_COLOR_AMOUNT, MAX_VALID_COLOR);
     DrawRectangleV(GameBoard[row][col].pos, (Vector2){(float)squareLength, (float)squareLength}, colr);
-    if (GameBoard[row][col].piece.texture.id != 0)
-    {
-        DrawTextureEx(GameBoard[row][col].piece.texture, GameBoard[row][col].pos, 0, (float)ComputeSquareLength() / (float)GameBoard[row][col].piece.texture.width, WHITE);
-    }
+    DrawPieceSprite(GameBoard[row][col].piece.type, GameBoard[row][col].piece.team, GameBoard[row][col].pos, (float)squareLength);
 }
 
 /**
@@ -766,6 +652,12 @@ static void DecideDestination(Vector2 topLeft)
         return;
     }
 
+    // The engine opponent moves this side (possibly thinking on its thread right now)
+    if (state.vsEngine && Turn == state.engineTeam)
+    {
+        return;
+    }
+
     // NEW: Intercept input if promoting
     if (state.isPromoting)
     {
@@ -775,13 +667,12 @@ static void DecideDestination(Vector2 topLeft)
 
     bool TurnValidation = false;
 
-    ResetSelection(); // this is to set all the selection values to false
-
     static int CellX = -1;
     static int CellY = -1;
 
     // It's initially equal to imaginaryCell but I can't write it directly
     static Cell selectedPiece = {.row = -1, .col = -1};
+    static bool pieceSelected = false;
 
     IsSelectedPieceEmpty = CompareCells(&selectedPiece, &imaginaryCell);
 
@@ -806,14 +697,13 @@ static void DecideDestination(Vector2 topLeft)
         if (GameBoard[CellX][CellY].piece.type != PIECE_NONE && TurnValidation) // We try to pick a piece in our turn
         {
             selectedPiece = GameBoard[CellX][CellY];
-            selectedPiece.selected = true;
+            pieceSelected = true;
             SetCellBorder(&selectedCellBorder, &selectedPiece);
             TraceLog(LOG_DEBUG, "Selected A new Piece: %d %d", CellX, CellY);
-            PrimaryValidation(selectedPiece.piece.type, CellX, CellY, true); // Renamed Validateanddevalidate to just validate
-            FinalValidation(CellX, CellY, selectedPiece.selected);
+            FinalValidation(&state, CellX, CellY, pieceSelected); // copies the cached legal moves of this square
         }
     }
-    HighlightValidMoves(selectedPiece.selected);
+    HighlightValidMoves(pieceSelected, CellX, CellY);
     // Move the piece if you hold one
     if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT) && !IsSelectedPieceEmpty)
     {
@@ -824,22 +714,22 @@ static void DecideDestination(Vector2 topLeft)
 
         if (NewCellX < 0 || NewCellX > (BOARD_SIZE - 1) || NewCellY < 0 || NewCellY > (BOARD_SIZE - 1))
         {
-            selectedPiece.selected = false;
+            pieceSelected = false;
             ResetCellBorder(&selectedCellBorder);
-            ResetValidation();
-            ResetPrimaryValidation(); // replaced old big function with just reset validation
+            ResetValidation(&state);
+            ResetPrimaryValidation(&state); // replaced old big function with just reset validation
             selectedPiece = imaginaryCell;
             TraceLog(LOG_DEBUG, "Unselected the piece because you tried to move it to an invalid pos");
             return;
         }
 
         // I add this part to unselect a piece if you click on an invalid position
-        if (!GameBoard[NewCellX][NewCellY].isvalid)
+        if (!IsLegalDestination(&state, CellX, CellY, NewCellX, NewCellY))
         {
-            selectedPiece.selected = false;
+            pieceSelected = false;
             ResetCellBorder(&selectedCellBorder);
-            ResetValidation();
-            ResetPrimaryValidation(); // replaced old big function with just reset validation
+            ResetValidation(&state);
+            ResetPrimaryValidation(&state); // replaced old big function with just reset validation
             selectedPiece = imaginaryCell;
             TraceLog(LOG_DEBUG, "Unselected the piece because you tried to move it to an invalid pos");
             return;
@@ -847,23 +737,23 @@ static void DecideDestination(Vector2 topLeft)
 
         if (NewCellX == CellX && NewCellY == CellY)
         {
-            selectedPiece.selected = false;
+            pieceSelected = false;
             ResetCellBorder(&selectedCellBorder);
-            ResetValidation();
-            ResetPrimaryValidation();
+            ResetValidation(&state);
+            ResetPrimaryValidation(&state);
             selectedPiece = imaginaryCell;
             return;
         }
 
-        if (GameBoard[NewCellX][NewCellY].isvalid)
+        if (IsLegalDestination(&state, CellX, CellY, NewCellX, NewCellY))
         {
-            MovePiece(CellX, CellY, NewCellX, NewCellY);
+            MovePiece(&state, CellX, CellY, NewCellX, NewCellY);
             SetCellBorder(&lastMoveCellBorder, &GameBoard[NewCellX][NewCellY]);
             TraceLog(LOG_DEBUG, "%d %d %d %d", CellX, CellY, NewCellX, NewCellY);
             TraceLog(LOG_DEBUG, "Moved the selected piece to the new pos: %d %d", NewCellX, NewCellY);
-            selectedPiece.selected = false;
-            ResetValidation();
-            ResetPrimaryValidation();
+            pieceSelected = false;
+            ResetValidation(&state);
+            ResetPrimaryValidation(&state);
             selectedPiece = imaginaryCell;
         }
     }
@@ -961,54 +851,55 @@ static void ResizeCellBorder(SmartBorder *border)
  *
  * Purpose:
  *  - When a piece is currently selected, render per-frame visual markers on
- *    every board cell that has its `isvalid` flag set. These markers indicate
- *    legal destination squares for the selected piece.
+ *    every legal destination of that piece, read from the per-position cache
+ *    (state.legalMoves) that ResetsAndValidations fills once per move.
  *
  * Behavior:
  *  - If `selected` is false the function does nothing.
  *  - Computes sizes from ComputeSquareLength() so markers scale with the board.
- *  - Iterates the global GameBoard and for each cell with isvalid==true draws
+ *  - Walks the destination bitboard of the source square and for each target draws
  *    a small filled circle centered if the cell is empty in that square using VALID_MOVE_COLOR
  *    otherwise it draws a hollow circle.
+ *  - Destinations that are opening book moves (BookTargets) use BOOK_MOVE_COLOR instead.
  *
  * Parameters:
  *  - selected : boolean indicating whether a piece is selected (only then draw).
+ *  - sourceRow, sourceCol : board coordinates of the selected piece.
  *
  * Notes / Side-effects:
- *  - Uses the globals `row` and `col` as loop indices.
  *  - Relies on GameBoard[*][*].pos being initialized (InitializeCellsPos called).
  *  - Rendering occurs immediately (per-frame); call from DrawBoard() during drawing.
  */
-void HighlightValidMoves(bool selected)
+void HighlightValidMoves(bool selected, int sourceRow, int sourceCol)
 {
-    if (selected)
+    if (selected && sourceRow >= 0 && sourceRow < BOARD_SIZE && sourceCol >= 0 && sourceCol < BOARD_SIZE)
     {
         int halfSquareLength = ComputeSquareLength() / 2;
         int validMoveCircleRadius = (int)round(halfSquareLength / (double)VALID_MOVE_CIRCLE_SQUARE_COEFFICIENT);
         int innerRingRadius = (int)((float)halfSquareLength * (INNER_VALID_MOVE_RADIUS / (float)FULL_VALID_MOVE_RADIUS));
         int outerRingRadius = (int)((float)halfSquareLength * (OUTER_VALID_MOVE_RADIUS / (float)FULL_VALID_MOVE_RADIUS));
 
-        for (int row = 0; row < BOARD_SIZE; row++)
+        Bitboard targets = state.legalMoves.targets[SQUARE_INDEX(sourceRow, sourceCol)];
+        Bitboard bookTargets = BookTargets(SQUARE_INDEX(sourceRow, sourceCol));
+
+        while (targets)
         {
-            for (int col = 0; col < BOARD_SIZE; col++)
+            int target = PopLowestSquare(&targets);
+            const Cell *thisCell = &GameBoard[SQUARE_ROW(target)][SQUARE_COL(target)];
+            Color markerColor = (bookTargets & SQUARE_BIT(target)) ? BOOK_MOVE_COLOR : VALID_MOVE_COLOR;
+
+            Vector2 centerPos = thisCell->pos;
+            centerPos.x += (float)halfSquareLength;
+            centerPos.y += (float)halfSquareLength;
+
+            if (thisCell->piece.type == PIECE_NONE)
             {
-                Cell thisCell = GameBoard[row][col];
-                if (thisCell.isvalid)
-                {
-                    Vector2 centerPos = thisCell.pos;
-                    centerPos.x += (float)halfSquareLength;
-                    centerPos.y += (float)halfSquareLength;
-
-                    if (thisCell.piece.type == PIECE_NONE)
-                    {
-                        DrawCircleV(centerPos, (float)validMoveCircleRadius, VALID_MOVE_COLOR);
-                    }
-                    else
-                    {
-                        DrawRing(centerPos, (float)innerRingRadius, (float)outerRingRadius, 0, FULL_CIRCLE_ANGLE, 25 /*this is the resolution just leave it as is*/, VALID_MOVE_COLOR);
-                        // DrawRingLines(centerPos, innerRingRadius, halfSquareLength, 0, 360, 25, VALID_MOVE_COLOR);
-                    }
-                }
+                DrawCircleV(centerPos, (float)validMoveCircleRadius, markerColor);
+            }
+            else
+            {
+                DrawRing(centerPos, (float)innerRingRadius, (float)outerRingRadius, 0, FULL_CIRCLE_ANGLE, 25 /*this is the resolution just leave it as is*/, markerColor);
+                // DrawRingLines(centerPos, innerRingRadius, halfSquareLength, 0, 360, 25, VALID_MOVE_COLOR);
             }
         }
     }
@@ -1098,19 +989,19 @@ static void HandlePromotionInput(void)
 
     if (CheckCollisionPointRec(mouse, queenRect))
     {
-        PromotePawn(PIECE_QUEEN);
+        PromotePawn(&state, PIECE_QUEEN);
     }
     else if (CheckCollisionPointRec(mouse, rookRect))
     {
-        PromotePawn(PIECE_ROOK);
+        PromotePawn(&state, PIECE_ROOK);
     }
     else if (CheckCollisionPointRec(mouse, bishopRect))
     {
-        PromotePawn(PIECE_BISHOP);
+        PromotePawn(&state, PIECE_BISHOP);
     }
     else if (CheckCollisionPointRec(mouse, knightRect))
     {
-        PromotePawn(PIECE_KNIGHT);
+        PromotePawn(&state, PIECE_KNIGHT);
     }
 }
 
@@ -1237,13 +1128,123 @@ void DrawDebugInfo(void)
     y += step;
 
     DrawText(TextFormat("Dead Black: %d", deadBlackCounter), x, y, fontSize, textColor);
+    y += step;
+
+    y += SPACE_BETWEEN_DEBUG_SECTIONS; // Spacer
+    DrawText("--- ENGINE ---", x, y, fontSize, GREEN);
+    y += step;
+
+    DrawText(TextFormat("Opponent: %s%s", !state.vsEngine ? "OFF" : (state.engineTeam == TEAM_WHITE ? "WHITE" : "BLACK"), IsEngineThinking() ? " (thinking)" : ""), x, y, fontSize,
+             state.vsEngine ? SKYBLUE : textColor);
+    y += step;
+
+    int bookMoves = BookMoveCount();
+    DrawText((bookMoves < 0) ? "Book: none" : TextFormat("Book: %d move(s) here", bookMoves), x, y, fontSize, (bookMoves > 0) ? SKYBLUE : textColor);
+    y += step;
+
+    // Indexed by TablebaseWdl + 2
+    static const char *const VERDICTS[5] = {"loss", "blessed loss", "draw", "cursed win", "win"};
+    const TablebaseResult *tablebase = &state.tablebaseResult;
+    const char *verdict = VERDICTS[tablebase->wdl - TABLEBASE_LOSS];
+    const char *tablebaseText = "Tablebase: -";
+    if (state.hasTablebaseResult)
+    {
+        tablebaseText = (tablebase->dtz > 0) ? TextFormat("Tablebase: %s, DTZ %d", verdict, tablebase->dtz) : TextFormat("Tablebase: %s", verdict);
+    }
+    DrawText(tablebaseText, x, y, fontSize, state.hasTablebaseResult ? SKYBLUE : textColor);
+    y += step;
+
+    const SearchResult *search = LastEngineSearch();
+    double nps = (search->seconds > 0.0) ? (double)search->nodes / search->seconds : 0.0;
+
+    DrawText(TextFormat("Depth: %d  Score: %d cp", search->depth, search->score), x, y, fontSize, textColor);
+    y += step;
+
+    DrawText(TextFormat("Nodes: %llu (%.0f kn/s)", (unsigned long long)search->nodes, nps / 1000.0), x, y, fontSize, textColor);
+    y += step;
+
+    DrawText(TextFormat("Time: %.2f s", search->seconds), x, y, fontSize, textColor);
+    y += step;
+
+    const AnalysisSnapshot *analysis = CurrentAnalysis();
+    if (analysis == NULL)
+    {
+        DrawText(TextFormat("Analysis: %s", IsAnalysisEnabled() ? "ON" : "OFF"), x, y, fontSize, IsAnalysisEnabled() ? SKYBLUE : textColor);
+    }
+    else
+    {
+        double analysisNps = (analysis->seconds > 0.0) ? (double)analysis->nodes / analysis->seconds : 0.0;
+        DrawText(TextFormat("Analysis: d%d %+d cp %.0f kn/s", analysis->depth, analysis->score, analysisNps / 1000.0), x, y, fontSize, SKYBLUE);
+    }
+
+#ifdef PROFILE
+    DrawProfileInfo();
+#endif
+}
+
+#ifdef PROFILE
+/**
+ * DrawProfileInfo (static)
+ *
+ * Renders the profiler panel right of the debug info window: per zone, the min, average
+ * and 99th percentile of its time per frame over the last PROFILE_WINDOW_FRAMES frames
+ * (counting only the frames it ran in) and its calls per frame, then the CSV state.
+ */
+static void DrawProfileInfo(void)
+{
+    int left = DEBUG_INFO_WINDOW_WIDTH;
+    int x = left + 10;
+    int y = 10;
+    int fontSize = DEBUG_MENU_FONT_SIZE;
+    int step = DEBUG_MENU_FONT_SIZE + SPACE_BETWEEN_DEBUG_LINES;
+    int height = 20 + step * (PROFILE_ZONE_COUNT + 3) + SPACE_BETWEEN_DEBUG_SECTIONS;
+    Color textColor = DEBUG_TEXT_COLOR;
+
+    DrawRectangle(left, 0, PROFILE_OVERLAY_WIDTH, height, Fade(BLACK, 0.8F));
+
+    DrawText("--- PROFILE (ms) ---", x, y, fontSize, GREEN);
+    y += step;
+
+    const char *columns[] = {"min", "avg", "p99", "calls"};
+    for (int i = 0; i < 4; i++)
+    {
+        DrawText(columns[i], x + PROFILE_NAME_COLUMN + i * PROFILE_VALUE_COLUMN, y, fontSize, GRAY);
+    }
+    y += step;
+
+    for (int zone = 0; zone < PROFILE_ZONE_COUNT; zone++)
+    {
+        ProfileStats stats;
+        GetProfileStats((ProfileZone)zone, &stats);
+
+        DrawText(ProfileZoneName((ProfileZone)zone), x, y, fontSize, textColor);
+        if (stats.frames == 0)
+        {
+            DrawText("-", x + PROFILE_NAME_COLUMN, y, fontSize, GRAY);
+        }
+        else
+        {
+            int column = x + PROFILE_NAME_COLUMN;
+            DrawText(TextFormat("%.3f", stats.minMs), column, y, fontSize, textColor);
+            DrawText(TextFormat("%.3f", stats.avgMs), column + PROFILE_VALUE_COLUMN, y, fontSize, textColor);
+            DrawText(TextFormat("%.3f", stats.p99Ms), column + 2 * PROFILE_VALUE_COLUMN, y, fontSize, SKYBLUE);
+            DrawText(TextFormat("%.1f", stats.callsPerFrame), column + 3 * PROFILE_VALUE_COLUMN, y, fontSize, textColor);
+        }
+        y += step;
+    }
+
+    y += SPACE_BETWEEN_DEBUG_SECTIONS; // Spacer
+    bool recording = IsProfileCsvRecording();
+    DrawText(recording ? TextFormat("CSV: recording to %s (F6)", PROFILE_CSV_PATH) : "CSV: off (F6 to record)", x, y, fontSize, recording ? RED : textColor);
 }
+#endif
 
 /**
  * DrawGameStatus
  *
  * Checks game state flags (Checkmate, Stalemate, Check, etc.) and renders
- * a status message banner if necessary.
+ * a status message banner if necessary. With nothing else to report, an endgame
+ * the tablebases cover shows its verdict (who wins, or a draw, the fifty-move rule's included).
  */
 void DrawGameStatus(void)
 {
@@ -1289,6 +1290,27 @@ void DrawGameStatus(void)
         bgColor = ORANGE;
         textColor = BLACK;
     }
+    else if (state.hasTablebaseResult)
+    {
+        const TablebaseResult *tablebase = &state.tablebaseResult;
+        if (tablebase->wdl == TABLEBASE_DRAW)
+        {
+            message = "DRAW (TABLEBASE)";
+            bgColor = BLUE;
+        }
+        else if (tablebase->wdl == TABLEBASE_CURSED_WIN || tablebase->wdl == TABLEBASE_BLESSED_LOSS)
+        {
+            // Won on the board, but the fifty-move rule comes first
+            message = "DRAW (TABLEBASE, 50 MOVES)";
+            bgColor = BLUE;
+        }
+        else
+        {
+            bool whiteWins = (tablebase->wdl == TABLEBASE_WIN) == (state.turn == TEAM_WHITE);
+            message = whiteWins ? "WHITE WINS (TABLEBASE)" : "BLACK WINS (TABLEBASE)";
+            bgColor = DARKGREEN;
+        }
+    }
 
     // 2. Draw the UI if there is a message
     if (message != NULL)
@@ -1332,6 +1354,127 @@ void DrawGameStatus(void)
     }
 }
 
+/**
+ * DrawAnalysisHints
+ *
+ * Draw the background analysis of the current position: an eval bar in the margin to
+ * the right of the board and an arrow for the best move.
+ *
+ * Behavior:
+ *  - Draws nothing while the analysis is off or has not finished an iteration of the
+ *    position on the board yet (CurrentAnalysis only returns a matching snapshot).
+ *  - The arrow is hidden while the promotion menu is open so it does not cover it.
+ *  - Only reads the latest published snapshot, so it never waits for the search.
+ */
+void DrawAnalysisHints(void)
+{
+    const AnalysisSnapshot *analysis = CurrentAnalysis();
+
+    if (analysis == NULL)
+    {
+        return;
+    }
+
+    DrawEvalBar(analysis->score);
+
+    if (analysis->bestMove != 0 && !state.isPromoting)
+    {
+        DrawBestMoveArrow(analysis->bestMove);
+    }
+}
+
+/**
+ * DrawEvalBar (static)
+ *
+ * Parameters:
+ *  - score: centipawns from White's point of view (MATE_SCORE encoding for mates).
+ *
+ * Behavior:
+ *  - White's share grows from the bottom along a logistic curve, so the bar moves a lot
+ *    around equality and saturates for decisive leads; EVAL_BAR_SCALE_CP fills three
+ *    quarters of it and a forced mate fills it completely.
+ *  - The score ("+0.35", "M3") is written under the bar.
+ */
+static void DrawEvalBar(int score)
+{
+    float squareLength = (float)ComputeSquareLength();
+    float margin = squareLength * SPACE_TEXT / 2;
+    float width = squareLength / EVAL_BAR_WIDTH_COEFFICIENT;
+    float height = squareLength * BOARD_SIZE;
+    float x = GameBoard[0][BOARD_SIZE - 1].pos.x + squareLength + ((margin - width) / 2);
+    float y = GameBoard[0][0].pos.y;
+
+    float whiteShare;
+    char label[16];
+
+    if (score > MATE_BOUND || score < -MATE_BOUND)
+    {
+        int mateMoves = (MATE_SCORE - abs(score) + 1) / 2;
+        whiteShare = (score > 0) ? 1.0f : 0.0f;
+        snprintf(label, sizeof label, "%sM%d", (score > 0) ? "" : "-", mateMoves);
+    }
+    else
+    {
+        // 1 / (1 + 3^(-score / scale)) is 3/4 at score == scale
+        whiteShare = 1.0f / (1.0f + powf(3.0f, -(float)score / EVAL_BAR_SCALE_CP));
+        snprintf(label, sizeof label, "%+.2f", (double)score / 100.0);
+    }
+
+    float whiteHeight = height * whiteShare;
+
+    DrawRectangleV((Vector2){x, y}, (Vector2){width, height - whiteHeight}, EVAL_BAR_BLACK_COLOR);
+    DrawRectangleV((Vector2){x, y + height - whiteHeight}, (Vector2){width, whiteHeight}, EVAL_BAR_WHITE_COLOR);
+
+    int textWidth = MeasureText(label, EVAL_BAR_FONT_SIZE);
+    DrawText(label, (int)(x + ((width - (float)textWidth) / 2)), (int)(y + height + ((float)EVAL_BAR_FONT_SIZE / 2)), EVAL_BAR_FONT_SIZE, FONT_COLOR);
+}
+
+/**
+ * DrawBestMoveArrow (static)
+ *
+ * Draw an arrow from the centre of move's origin square to the centre of its destination:
+ * a thick line and a triangular head whose tip sits on the destination centre.
+ */
+static void DrawBestMoveArrow(ChessMove move)
+{
+    float squareLength = (float)ComputeSquareLength();
+    float half = squareLength / 2;
+    Cell *from = &GameBoard[SQUARE_ROW(MOVE_FROM(move))][SQUARE_COL(MOVE_FROM(move))];
+    Cell *to = &GameBoard[SQUARE_ROW(MOVE_TO(move))][SQUARE_COL(MOVE_TO(move))];
+
+    Vector2 start = {from->pos.x + half, from->pos.y + half};
+    Vector2 tip = {to->pos.x + half, to->pos.y + half};
+    float dx = tip.x - start.x;
+    float dy = tip.y - start.y;
+    float length = sqrtf((dx * dx) + (dy * dy));
+
+    if (length <= 0.0f)
+    {
+        return;
+    }
+
+    dx /= length;
+    dy /= length;
+
+    float thickness = squareLength / ANALYSIS_ARROW_THICKNESS_COEFFICIENT;
+    float headLength = thickness * 2.2f;
+    float headHalfWidth = thickness * 1.1f;
+    Vector2 headBase = {tip.x - (dx * headLength), tip.y - (dy * headLength)};
+    Vector2 left = {headBase.x + (dy * headHalfWidth), headBase.y - (dx * headHalfWidth)};
+    Vector2 right = {headBase.x - (dy * headHalfWidth), headBase.y + (dx * headHalfWidth)};
+
+    DrawLineEx(start, headBase, thickness, ANALYSIS_ARROW_COLOR);
+
+    // raylib only fills triangles given counter-clockwise (on screen)
+    if (((left.x - tip.x) * (right.y - tip.y)) - ((left.y - tip.y) * (right.x - tip.x)) > 0.0f)
+    {
+        Vector2 swapped = left;
+        left = right;
+        right = swapped;
+    }
+    DrawTriangle(tip, left, right, ANALYSIS_ARROW_COLOR);
+}
+
 /**
  * GetTopButtonRect
  *
@@ -1377,6 +1520,20 @@ Rectangle GetTopButtonRect(int index)
     return (Rectangle){x, y, (float)squareLength * 0.95F, (float)squareLength / 2.0F};
 }
 
+/**
+ * GetHistoryScrubberRect
+ *
+ * Returns the Rectangle of the history slider: the lower half of the row of the top
+ * buttons, across the first seven board columns (the eighth is left for its ply label).
+ */
+Rectangle GetHistoryScrubberRect(void)
+{
+    Rectangle first = GetTopButtonRect(0);
+    float squareLength = (float)ComputeSquareLength();
+
+    return (Rectangle){first.x, first.y + (squareLength * 0.6F), (BOARD_SIZE - 1) * squareLength, squareLength * 0.3F};
+}
+
 /**
  * ResetSelectedPiece
  *
@@ -3,7 +3,6 @@
  *
  * Public drawing/layout API used by main.c.
  * - DrawBoard(theme): render board + pieces (call inside BeginDrawing/EndDrawing).
- * - LoadPiece(r,c,type,team, place): load and assign a piece texture for a cell.
  * - ComputeSquareLength(): compute a consistent square size based on current window.
  *
  * Keep prototypes small and self-explanatory; implementation lives in draw.c.
@@ -14,30 +13,11 @@
 #include "main.h"
 #include <stdbool.h>
 
-typedef enum LoadPlace
-{
-    GAME_BOARD = 0,
-    DEAD_WHITE_PIECES,
-    DEAD_BLACK_PIECES,
-} LoadPlace;
+/* Render board and pieces for the provided color theme index (background: window background color). */
+void DrawBoard(int ColorTheme, bool showFileRank, Color background);
 
-/* Render board and pieces for the provided color theme index. */
-void DrawBoard(int ColorTheme, bool showFileRank);
-
-/* Load a piece texture for cell (row,col). squareLength selects texture size. */
-void LoadPiece(int row, int col, PieceType type, Team team, LoadPlace place);
-
-/* Initialize the chess board to have appropriate starting values */
-void InitializeBoard(void);
-
-/* Initialize the DeadPieces to have appropriate starting values */
-void InitializeDeadPieces(void);
-
-/* Run after the game finishes or you want a new game to prevent memory leaks and flush the board */
-void UnloadBoard(void);
-
-/* Run after the game finishes or you want a new game to prevent memory leaks and flush the DeadPieces */
-void UnloadDeadPieces(void);
+/* Release the cached board layer texture; call before CloseWindow */
+void UnloadBoardLayer(void);
 
 /* Highlight a single square */
 void HighlightSquare(int row, int col, int ColorTheme);
@@ -49,7 +29,7 @@ void HighlightHover(int ColorTheme);
 int ComputeSquareLength(void);
 
 /* Highlight valid moves for the selected piece */
-void HighlightValidMoves(bool selected);
+void HighlightValidMoves(bool selected, int sourceRow, int sourceCol);
 
 /* Updates the border highlight for the destination of the last move made. */
 void UpdateLastMoveHighlight(int row, int col);
@@ -60,9 +40,15 @@ void DrawDebugInfo(void);
 /* NEW: Draws the game status (Check, Mate, Draw, etc.) */
 void DrawGameStatus(void);
 
+/* Draws the eval bar and best-move arrow of the background analysis (nothing while it is off) */
+void DrawAnalysisHints(void);
+
 /* Returns the Rectangle for one of the top buttons */
 Rectangle GetTopButtonRect(int index);
 
+/* Returns the Rectangle of the history scrubber (below the top buttons) */
+Rectangle GetHistoryScrubberRect(void);
+
 /* Clears the visual selection border */
 void ResetSelectedPiece(void);
 
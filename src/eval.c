@@ -0,0 +1,53 @@
+/**
+ * eval.c
+ *
+ * Responsibilities:
+ * - Score a position statically: tapered material and piece-square tables plus a
+ *   bishop pair bonus.
+ *
+ * Implementation Details:
+ * - The piece-square totals are not summed here: MakeMove keeps them in the Position
+ *   (psqt.h), so Evaluate only blends the middlegame and endgame totals by the phase,
+ *   which makes the evaluation cost independent of the number of pieces.
+ * - Every term is White's minus Black's and the result is returned from the side to
+ *   move's point of view, so Evaluate is symmetric by construction.
+ */
+
+#include "eval.h"
+#include "bitboard.h"
+#include "piece.h"
+#include "position.h"
+#include "psqt.h"
+#include "settings.h"
+
+/* Bonus for owning both bishops (centipawns) */
+#define BISHOP_PAIR_BONUS 30
+
+const int PieceValues[PIECE_TYPE_COUNT] = {0, 0, 900, 500, 330, 320, 100};
+
+/**
+ * Evaluate
+ *
+ * Returns:
+ *  - White's score minus Black's score, negated when Black is to move.
+ *
+ * Behavior:
+ *  - The score moves linearly from the middlegame total (phase PHASE_MAX or more, i.e.
+ *    promotions do not push it further) to the endgame total (phase 0).
+ */
+int Evaluate(const Position *pos)
+{
+    int phase = (pos->phase < PHASE_MAX) ? pos->phase : PHASE_MAX;
+    int score = (pos->psqtMidgame * phase + pos->psqtEndgame * (PHASE_MAX - phase)) / PHASE_MAX;
+
+    if (BitCount(pos->bitboards.pieces[TEAM_WHITE][PIECE_BISHOP]) >= 2)
+    {
+        score += BISHOP_PAIR_BONUS;
+    }
+    if (BitCount(pos->bitboards.pieces[TEAM_BLACK][PIECE_BISHOP]) >= 2)
+    {
+        score -= BISHOP_PAIR_BONUS;
+    }
+
+    return (pos->side == TEAM_WHITE) ? score : -score;
+}
@@ -0,0 +1,27 @@
+/**
+ * eval.h
+ *
+ * Responsibilities:
+ * - Export the static evaluation used by the search (search.c).
+ * - Export the material values shared with move ordering.
+ *
+ * Notes:
+ * - Scores are in centipawns from the point of view of the side to move.
+ * - Evaluate reads the piece-square totals MakeMove keeps in the Position, so it needs a
+ *   Position built by the FEN parsers, MakeMove or ComputePsqt (psqt.h).
+ * - Part of libchesscore; this header does not include raylib.
+ */
+
+#ifndef EVAL_H
+#define EVAL_H
+
+#include "piece.h"
+#include "position.h"
+
+/* Material value of each PieceType in centipawns (the king is not counted) */
+extern const int PieceValues[PIECE_TYPE_COUNT];
+
+/* Static score of pos for the side to move */
+int Evaluate(const Position *pos);
+
+#endif /* EVAL_H */
@@ -0,0 +1,491 @@
+/**
+ * fencheck.c
+ *
+ * Responsibilities:
+ * - Command-line validator for FEN/EPD position files built on libchesscore (no window,
+ *   no audio), meant for nightly checks of position dumps with millions of lines.
+ * - Parse every record, check it with ValidatePosition and report the first bad lines,
+ *   the totals and the throughput.
+ *
+ * Usage:
+ *   fencheck [--fen | --epd] [--threads N] [--parse-only] <file>...
+ *   fencheck --self-test
+ *
+ *   --fen / --epd   record format (default: EPD for files ending in ".epd", FEN otherwise)
+ *   --threads N     worker threads (default: one per core)
+ *   --parse-only    only parse, skip ValidatePosition
+ *   --self-test     check the records of FencheckSuite against their expected verdicts
+ *
+ * Notes:
+ * - One record per line; blank lines and lines starting with '#' are skipped, CRLF line
+ *   endings are accepted.
+ * - Exit status is 0 when every record of every file is valid, 1 otherwise (or on bad
+ *   arguments / unreadable files).
+ * - The key checksum (sum of the Zobrist keys of the valid records) does not depend on
+ *   the thread count, so two runs over the same file can be compared.
+ *
+ * Implementation Details:
+ * - The file is memory-mapped read-only and cut into one chunk per thread at line
+ *   boundaries. Each worker parses its lines in place with PositionFromFENSpan /
+ *   PositionFromEPD: no line is copied and nothing is allocated per record.
+ * - Workers count their lines; line numbers of the reported errors are made absolute
+ *   afterwards from the line counts of the preceding chunks.
+ */
+
+#include "chesscore.h"
+#include "position.h"
+#include "search.h"
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Bad lines printed per file (the counts always cover every line) */
+#define MAX_REPORTED_ERRORS 10
+
+/* Characters of a bad line echoed in the report */
+#define MAX_ECHOED_LENGTH 100
+
+typedef enum RecordFormat
+{
+    FORMAT_AUTO = 0,
+    FORMAT_FEN,
+    FORMAT_EPD,
+} RecordFormat;
+
+/**
+ * LineError
+ *
+ * A rejected line: its number (within the chunk until CheckFile makes it absolute), the
+ * line itself (pointing into the mapping) and why it was rejected.
+ */
+typedef struct LineError
+{
+    uint64_t line;
+    const char *text;
+    size_t length;
+    const char *reason;
+} LineError;
+
+typedef enum RecordVerdict
+{
+    VERDICT_VALID = 0,
+    VERDICT_MALFORMED,
+    VERDICT_UNSOUND,
+} RecordVerdict;
+
+/**
+ * FencheckCase
+ *
+ * One record of the self-test and the verdict CheckLine must reach for it.
+ */
+typedef struct FencheckCase
+{
+    const char *record;
+    RecordFormat format;
+    RecordVerdict expected;
+} FencheckCase;
+
+static const FencheckCase FencheckSuite[] = {
+    {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", FORMAT_FEN, VERDICT_VALID},
+    {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq -", FORMAT_FEN, VERDICT_VALID},
+    {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - bm e4; id \"start\";", FORMAT_EPD, VERDICT_VALID},
+    {"r3k2r/8/8/8/8/8/8/R3K2R b Qk - 3 20", FORMAT_FEN, VERDICT_VALID},
+    {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KKkq - 0 1", FORMAT_FEN, VERDICT_MALFORMED},
+    {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkqq - 0 1", FORMAT_FEN, VERDICT_MALFORMED},
+    {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KKkq - bm e4;", FORMAT_EPD, VERDICT_MALFORMED},
+    {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQxq - 0 1", FORMAT_FEN, VERDICT_MALFORMED},
+    {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBN w KQkq - 0 1", FORMAT_FEN, VERDICT_MALFORMED},
+    {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR x KQkq - 0 1", FORMAT_FEN, VERDICT_MALFORMED},
+    {"4k3/8/8/8/8/8/8/4K2R w Q - 0 1", FORMAT_FEN, VERDICT_UNSOUND},
+    {"4k3/8/8/8/8/8/8/P3K3 w - - 0 1", FORMAT_FEN, VERDICT_UNSOUND},
+    {"4k3/8/8/8/8/8/8/4K2R b - - 0 1", FORMAT_FEN, VERDICT_VALID},
+    {"4k2R/8/8/8/8/8/8/4K3 w - - 0 1", FORMAT_FEN, VERDICT_UNSOUND},
+};
+
+#define FENCHECK_SUITE_SIZE ((int)(sizeof FencheckSuite / sizeof FencheckSuite[0]))
+
+/**
+ * CheckChunk
+ *
+ * The lines [begin, end) of a file handled by one worker, and its results.
+ */
+typedef struct CheckChunk
+{
+    const char *begin;
+    const char *end;
+    RecordFormat format;
+    bool validate;
+    pthread_t thread;
+
+    uint64_t lines;   /* every line, skipped ones included (for numbering) */
+    uint64_t records;
+    uint64_t valid;
+    uint64_t malformed;
+    uint64_t unsound;
+    uint64_t keySum;
+    LineError errors[MAX_REPORTED_ERRORS];
+    int errorCount;
+} CheckChunk;
+
+// Local prototypes
+static bool CheckFile(const char *path, RecordFormat format, int threads, bool validate);
+static void *CheckChunkMain(void *arg);
+static void CheckLine(CheckChunk *chunk, const char *line, size_t length);
+static void RecordError(CheckChunk *chunk, const char *line, size_t length, const char *reason);
+static RecordFormat FormatFromPath(const char *path);
+static void PrintUsage(const char *program);
+static int RunSelfTest(void);
+
+int main(int argc, char **argv)
+{
+    RecordFormat format = FORMAT_AUTO;
+    int threads = AvailableCores();
+    bool validate = true;
+    bool allValid = true;
+    int files = 0;
+
+    InitChessCore();
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--fen") == 0)
+        {
+            format = FORMAT_FEN;
+        }
+        else if (strcmp(argv[i], "--epd") == 0)
+        {
+            format = FORMAT_EPD;
+        }
+        else if (strcmp(argv[i], "--parse-only") == 0)
+        {
+            validate = false;
+        }
+        else if (strcmp(argv[i], "--self-test") == 0 && argc == 2)
+        {
+            return RunSelfTest();
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            char *end = NULL;
+            long value = strtol(argv[++i], &end, 10);
+
+            if (end == argv[i] || *end != '\0' || value < 1 || value > MAX_SEARCH_THREADS)
+            {
+                PrintUsage(argv[0]);
+                return 1;
+            }
+            threads = (int)value;
+        }
+        else if (argv[i][0] == '-')
+        {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+        else
+        {
+            RecordFormat fileFormat = (format != FORMAT_AUTO) ? format : FormatFromPath(argv[i]);
+            allValid = CheckFile(argv[i], fileFormat, threads, validate) && allValid;
+            files++;
+        }
+    }
+
+    if (files == 0)
+    {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    return allValid ? 0 : 1;
+}
+
+/**
+ * CheckFile (static)
+ *
+ * Map path, validate its records on threads workers and print the report.
+ *
+ * Returns:
+ *  - true if the file could be read and every record in it is valid.
+ */
+static bool CheckFile(const char *path, RecordFormat format, int threads, bool validate)
+{
+    int fd = open(path, O_RDONLY);
+    struct stat info;
+
+    if (fd < 0 || fstat(fd, &info) != 0)
+    {
+        fprintf(stderr, "%s: cannot open\n", path);
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        return false;
+    }
+
+    size_t size = (size_t)info.st_size;
+    const char *data = NULL;
+
+    if (size > 0)
+    {
+        void *mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED)
+        {
+            fprintf(stderr, "%s: cannot map\n", path);
+            close(fd);
+            return false;
+        }
+        data = mapping;
+    }
+    close(fd);
+
+    // Small files are not worth a thread per core
+    if ((size_t)threads > size / 4096 + 1)
+    {
+        threads = (int)(size / 4096) + 1;
+    }
+
+    CheckChunk *chunks = calloc((size_t)threads, sizeof *chunks);
+    if (chunks == NULL)
+    {
+        fprintf(stderr, "%s: out of memory\n", path);
+        if (data != NULL)
+        {
+            munmap((void *)data, size);
+        }
+        return false;
+    }
+
+    // Cut at line boundaries: every chunk but the first starts just after a newline
+    const char *fileEnd = data + size;
+    const char *cursor = data;
+    for (int i = 0; i < threads; i++)
+    {
+        const char *end = (i == threads - 1) ? fileEnd : data + (size / (size_t)threads) * (size_t)(i + 1);
+
+        if (end < cursor)
+        {
+            end = cursor;
+        }
+        if (end < fileEnd && end > data && end[-1] != '\n')
+        {
+            const char *newline = memchr(end, '\n', (size_t)(fileEnd - end));
+            end = (newline != NULL) ? newline + 1 : fileEnd;
+        }
+
+        chunks[i].begin = cursor;
+        chunks[i].end = end;
+        chunks[i].format = format;
+        chunks[i].validate = validate;
+        cursor = end;
+    }
+
+    double start = MonotonicSeconds();
+    int started = 0;
+    for (int i = 1; i < threads; i++)
+    {
+        if (pthread_create(&chunks[i].thread, NULL, CheckChunkMain, &chunks[i]) != 0)
+        {
+            break;
+        }
+        started++;
+    }
+
+    // Chunks without a thread (creation failed) are checked here, after chunk 0
+    CheckChunkMain(&chunks[0]);
+    for (int i = started + 1; i < threads; i++)
+    {
+        CheckChunkMain(&chunks[i]);
+    }
+    for (int i = 1; i <= started; i++)
+    {
+        pthread_join(chunks[i].thread, NULL);
+    }
+    double seconds = MonotonicSeconds() - start;
+
+    CheckChunk total = {0};
+    uint64_t lineOffset = 0;
+    int reported = 0;
+
+    for (int i = 0; i < threads; i++)
+    {
+        total.records += chunks[i].records;
+        total.valid += chunks[i].valid;
+        total.malformed += chunks[i].malformed;
+        total.unsound += chunks[i].unsound;
+        total.keySum += chunks[i].keySum;
+
+        for (int e = 0; e < chunks[i].errorCount && reported < MAX_REPORTED_ERRORS; e++, reported++)
+        {
+            const LineError *error = &chunks[i].errors[e];
+            size_t length = error->length;
+
+            while (length > 0 && (error->text[length - 1] == '\r' || error->text[length - 1] == ' '))
+            {
+                length--;
+            }
+
+            printf("%s:%llu: %s: %.*s%s\n", path, (unsigned long long)(lineOffset + error->line), error->reason,
+                   (int)((length > MAX_ECHOED_LENGTH) ? MAX_ECHOED_LENGTH : length), error->text, (length > MAX_ECHOED_LENGTH) ? "..." : "");
+        }
+
+        lineOffset += chunks[i].lines;
+    }
+
+    double rate = (seconds > 0.0) ? (double)total.records / seconds : 0.0;
+    printf("%s: %llu records (%s), %llu valid, %llu malformed, %llu unsound; key checksum %016llx\n", path, (unsigned long long)total.records,
+           (format == FORMAT_EPD) ? "EPD" : "FEN", (unsigned long long)total.valid, (unsigned long long)total.malformed,
+           (unsigned long long)total.unsound, (unsigned long long)total.keySum);
+    printf("%s: %.3f s on %d thread(s), %.0f records/s\n", path, seconds, threads, rate);
+
+    free(chunks);
+    if (data != NULL)
+    {
+        munmap((void *)data, size);
+    }
+
+    return total.valid == total.records;
+}
+
+/**
+ * CheckChunkMain (static)
+ *
+ * Worker body: check every line of the chunk.
+ */
+static void *CheckChunkMain(void *arg)
+{
+    CheckChunk *chunk = arg;
+    const char *line = chunk->begin;
+
+    while (line < chunk->end)
+    {
+        const char *newline = memchr(line, '\n', (size_t)(chunk->end - line));
+        const char *lineEnd = (newline != NULL) ? newline : chunk->end;
+
+        chunk->lines++;
+        CheckLine(chunk, line, (size_t)(lineEnd - line));
+        line = (newline != NULL) ? newline + 1 : chunk->end;
+    }
+
+    return NULL;
+}
+
+/**
+ * CheckLine (static)
+ *
+ * Parse one line in place and classify it (skipped, valid, malformed or unsound).
+ */
+static void CheckLine(CheckChunk *chunk, const char *line, size_t length)
+{
+    size_t first = 0;
+    while (first < length && (line[first] == ' ' || line[first] == '\t' || line[first] == '\r'))
+    {
+        first++;
+    }
+
+    if (first == length || line[first] == '#')
+    {
+        return;
+    }
+
+    Position pos;
+    bool parsed = (chunk->format == FORMAT_EPD) ? PositionFromEPD(&pos, line, length) : PositionFromFENSpan(&pos, line, length);
+
+    chunk->records++;
+    if (!parsed)
+    {
+        chunk->malformed++;
+        RecordError(chunk, line, length, "malformed record");
+        return;
+    }
+
+    const char *problem = chunk->validate ? ValidatePosition(&pos) : NULL;
+    if (problem != NULL)
+    {
+        chunk->unsound++;
+        RecordError(chunk, line, length, problem);
+        return;
+    }
+
+    chunk->valid++;
+    chunk->keySum += pos.key;
+}
+
+/**
+ * RecordError (static)
+ *
+ * Keep the first MAX_REPORTED_ERRORS rejected lines of the chunk for the report.
+ */
+static void RecordError(CheckChunk *chunk, const char *line, size_t length, const char *reason)
+{
+    if (chunk->errorCount < MAX_REPORTED_ERRORS)
+    {
+        chunk->errors[chunk->errorCount++] = (LineError){chunk->lines, line, length, reason};
+    }
+}
+
+/**
+ * FormatFromPath (static)
+ *
+ * EPD for names ending in ".epd", FEN otherwise.
+ */
+static RecordFormat FormatFromPath(const char *path)
+{
+    size_t length = strlen(path);
+
+    return (length >= 4 && strcmp(path + length - 4, ".epd") == 0) ? FORMAT_EPD : FORMAT_FEN;
+}
+
+/**
+ * PrintUsage (static)
+ */
+static void PrintUsage(const char *program)
+{
+    fprintf(stderr,
+            "Usage:\n"
+            "  %s [--fen | --epd] [--threads N] [--parse-only] <file>...\n"
+            "      validate one FEN/EPD record per line (format from the extension unless given)\n"
+            "  %s --self-test\n"
+            "      check the built-in records against their expected verdicts\n",
+            program, program);
+}
+
+/**
+ * RunSelfTest (static)
+ *
+ * Run every FencheckSuite record through CheckLine (the path of a file's lines) and
+ * compare the verdict it reaches with the expected one.
+ *
+ * Returns:
+ *  - 0 if every verdict matches, 1 otherwise (exit status).
+ */
+static int RunSelfTest(void)
+{
+    static const char *const VerdictNames[] = {"valid", "malformed", "unsound"};
+    int failures = 0;
+
+    for (int i = 0; i < FENCHECK_SUITE_SIZE; i++)
+    {
+        const FencheckCase *test = &FencheckSuite[i];
+        CheckChunk chunk = {.format = test->format, .validate = true};
+
+        CheckLine(&chunk, test->record, strlen(test->record));
+
+        RecordVerdict verdict = (chunk.malformed > 0) ? VERDICT_MALFORMED : (chunk.unsound > 0) ? VERDICT_UNSOUND : VERDICT_VALID;
+        bool passed = verdict == test->expected;
+
+        printf("%-4s %-3s %-9s %s\n", passed ? "ok" : "FAIL", (test->format == FORMAT_EPD) ? "epd" : "fen", VerdictNames[verdict], test->record);
+        if (!passed)
+        {
+            failures++;
+        }
+    }
+
+    printf("%d of %d records as expected\n", FENCHECK_SUITE_SIZE - failures, FENCHECK_SUITE_SIZE);
+    return (failures == 0) ? 0 : 1;
+}
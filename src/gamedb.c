@@ -0,0 +1,822 @@
+/**
+ * gamedb.c
+ *
+ * Responsibilities:
+ * - Build a game database file from replayed games (BeginGameDatabase, AddDatabaseGame,
+ *   FinishGameDatabase).
+ * - Map a database and answer "which games reach this position" (OpenGameDatabase,
+ *   FindPositionGames) and read single games back (ReadDatabaseGame).
+ *
+ * File layout (all offsets in bytes from the start of the file, sections 8-aligned):
+ *   GameDbHeader                       64 bytes, written last
+ *   game records                       one per game, in insertion order:
+ *     GameDbRecord                     8 bytes (plies, result, tag bytes)
+ *     tags                             7 NUL-terminated strings: Event, Site, Date, Round,
+ *                                      White, Black, start FEN ("" for the standard start)
+ *     moves                            uint16_t ChessMove per ply (2-aligned)
+ *   game table                         uint64_t record offset per game
+ *   position index                     GameDbPosition per (game, ply), sorted
+ *
+ * Implementation Details:
+ * - Every position of every game (start included) is indexed, so a query is a binary
+ *   search for the first entry of the key followed by a scan of its range; the range is
+ *   sorted by game and ply, so each game's first hit comes first.
+ * - The builder writes records as games arrive. Index entries go to an in-memory run;
+ *   a full run is radix-sorted and spilled to its own tmpfile(); at the end the runs are
+ *   merged through a binary heap into the index section (read sequentially, no seeking).
+ * - Games read back are checked move by move against GenerateLegalMoves, so a damaged
+ *   file yields an error rather than an inconsistent Position.
+ */
+
+#include "gamedb.h"
+#include "movegen.h"
+#include "pgn.h"
+#include "position.h"
+#include "settings.h"
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define GAME_DB_MAGIC "CHESSGDB"
+#define GAME_DB_VERSION 1
+
+/* Written as a number, read back as one: a file from the other byte order does not match */
+#define GAME_DB_BYTE_ORDER 0x01020304u
+
+/* Tag strings of a record, in file order */
+#define GAME_DB_TAG_COUNT 7
+
+/* Entries read from a run at once while merging */
+#define MERGE_BUFFER_POSITIONS 4096
+
+/**
+ * GameDbHeader
+ *
+ * First 64 bytes of the file.
+ */
+typedef struct GameDbHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t gameCount;
+    uint32_t reserved;
+    uint64_t positionCount;
+    uint64_t gameTableOffset;
+    uint64_t positionIndexOffset;
+    uint64_t fileSize;
+    uint64_t padding;
+} GameDbHeader;
+
+/**
+ * GameDbRecord
+ *
+ * Fixed part of a game record; the tags and the moves follow it.
+ */
+typedef struct GameDbRecord
+{
+    uint16_t plyCount;
+    uint8_t result;
+    uint8_t reserved;
+    uint16_t tagBytes;
+    uint16_t padding;
+} GameDbRecord;
+
+/* GameDbRecord.result */
+typedef enum
+{
+    GAME_DB_RESULT_UNKNOWN = 0,
+    GAME_DB_RESULT_WHITE_WINS,
+    GAME_DB_RESULT_BLACK_WINS,
+    GAME_DB_RESULT_DRAW
+} GameDbResult;
+
+static const char *RESULT_TAGS[] = {"*", "1-0", "0-1", "1/2-1/2"};
+
+/**
+ * RunReader
+ *
+ * Sequential reader of one sorted run while merging.
+ */
+typedef struct RunReader
+{
+    FILE *file;
+    GameDbPosition buffer[MERGE_BUFFER_POSITIONS];
+    size_t length;
+    size_t cursor;
+} RunReader;
+
+// Local prototypes
+static bool WriteBytes(GameDatabaseWriter *writer, const void *bytes, size_t size);
+static bool WritePadding(GameDatabaseWriter *writer, size_t alignment);
+static bool AddPosition(GameDatabaseWriter *writer, uint64_t key, uint32_t game, uint32_t ply);
+static bool SpillRun(GameDatabaseWriter *writer);
+static bool MergeRuns(GameDatabaseWriter *writer);
+static bool NextRunPosition(RunReader *reader);
+static void SiftDown(RunReader **heap, size_t count, size_t at);
+static void SortRun(GameDatabaseWriter *writer);
+static bool PositionLess(const GameDbPosition *a, const GameDbPosition *b);
+static void FreeWriter(GameDatabaseWriter *writer);
+static uint8_t ResultCode(const char *result);
+static const char *TagAt(const PgnGame *game, int tag);
+
+/**
+ * BeginGameDatabase
+ *
+ * Parameters:
+ *  - writer: state to initialize.
+ *  - path:   database file to create (an existing file is replaced).
+ *
+ * Returns:
+ *  - false if the file cannot be created or the first run cannot be allocated.
+ */
+bool BeginGameDatabase(GameDatabaseWriter *writer, const char *path)
+{
+    memset(writer, 0, sizeof *writer);
+
+    writer->file = fopen(path, "wb");
+    writer->run = malloc(sizeof(GameDbPosition) * GAME_DB_RUN_POSITIONS);
+    writer->scratch = malloc(sizeof(GameDbPosition) * GAME_DB_RUN_POSITIONS);
+    if (writer->file == NULL || writer->run == NULL || writer->scratch == NULL)
+    {
+        FreeWriter(writer);
+        return false;
+    }
+
+    // Placeholder header, rewritten by FinishGameDatabase
+    GameDbHeader header = {0};
+    return WriteBytes(writer, &header, sizeof header);
+}
+
+/**
+ * AddDatabaseGame
+ *
+ * Parameters:
+ *  - game: the game to store (tags, start, plyCount moves); its end position is not used.
+ *
+ * Returns:
+ *  - false on a write or allocation error (the writer is then failed: FinishGameDatabase
+ *    reports it and removes nothing, the caller decides what to do with the file).
+ *
+ * Behavior:
+ *  - Replays the moves from start to index every position the game reaches.
+ */
+bool AddDatabaseGame(GameDatabaseWriter *writer, const PgnGame *game)
+{
+    if (writer->failed || game->plyCount < 0 || game->plyCount > UINT16_MAX || writer->gameCount == UINT32_MAX)
+    {
+        writer->failed = true;
+        return false;
+    }
+
+    if (writer->gameCount == writer->gameCapacity)
+    {
+        uint32_t capacity = (writer->gameCapacity == 0) ? 1024 : writer->gameCapacity * 2;
+        uint64_t *grown = realloc(writer->gameOffsets, sizeof(uint64_t) * capacity);
+        if (grown == NULL)
+        {
+            writer->failed = true;
+            return false;
+        }
+        writer->gameOffsets = grown;
+        writer->gameCapacity = capacity;
+    }
+
+    // Tags: the start FEN is stored only for a non-standard start
+    char fen[MAX_POSITION_FEN_LENGTH];
+    const char *tags[GAME_DB_TAG_COUNT];
+    size_t tagBytes = 0;
+
+    PositionToFEN(&game->start, fen, sizeof fen);
+    for (int tag = 0; tag < GAME_DB_TAG_COUNT; tag++)
+    {
+        tags[tag] = (tag < GAME_DB_TAG_COUNT - 1) ? TagAt(game, tag) : (strcmp(fen, STARTING_FEN) == 0 ? "" : fen);
+        tagBytes += strlen(tags[tag]) + 1;
+    }
+
+    GameDbRecord record = {
+        .plyCount = (uint16_t)game->plyCount,
+        .result = ResultCode(game->result),
+        .tagBytes = (uint16_t)tagBytes,
+    };
+
+    uint32_t index = writer->gameCount;
+    writer->gameOffsets[writer->gameCount++] = writer->offset;
+    WriteBytes(writer, &record, sizeof record);
+    for (int tag = 0; tag < GAME_DB_TAG_COUNT; tag++)
+    {
+        WriteBytes(writer, tags[tag], strlen(tags[tag]) + 1);
+    }
+    WritePadding(writer, sizeof(uint16_t));
+    WriteBytes(writer, game->moves, sizeof(ChessMove) * (size_t)game->plyCount);
+    WritePadding(writer, sizeof(uint64_t));
+
+    Position pos = game->start;
+    AddPosition(writer, pos.key, index, 0);
+    for (int ply = 0; ply < game->plyCount; ply++)
+    {
+        UndoInfo undo;
+        MakeMove(&pos, game->moves[ply], &undo);
+        AddPosition(writer, pos.key, index, (uint32_t)ply + 1);
+    }
+
+    return !writer->failed;
+}
+
+/**
+ * FinishGameDatabase
+ *
+ * Returns:
+ *  - true if the whole database was written; false if any step since BeginGameDatabase
+ *    failed (the file is then incomplete and should be deleted by the caller).
+ *
+ * Behavior:
+ *  - Writes the game table and the sorted position index, then the header, closes the
+ *    file and frees every buffer (also on failure).
+ */
+bool FinishGameDatabase(GameDatabaseWriter *writer)
+{
+    GameDbHeader header = {0};
+
+    memcpy(header.magic, GAME_DB_MAGIC, sizeof header.magic);
+    header.version = GAME_DB_VERSION;
+    header.byteOrder = GAME_DB_BYTE_ORDER;
+    header.gameCount = writer->gameCount;
+    header.positionCount = writer->positionCount;
+
+    WritePadding(writer, sizeof(uint64_t));
+    header.gameTableOffset = writer->offset;
+    WriteBytes(writer, writer->gameOffsets, sizeof(uint64_t) * writer->gameCount);
+
+    header.positionIndexOffset = writer->offset;
+    if (writer->runCount == 0)
+    {
+        // Everything fits in one run: sort it and write it straight out
+        SortRun(writer);
+        WriteBytes(writer, writer->run, sizeof(GameDbPosition) * writer->runLength);
+    }
+    else if (!SpillRun(writer) || !MergeRuns(writer))
+    {
+        writer->failed = true;
+    }
+    header.fileSize = writer->offset;
+
+    if (!writer->failed && (fseek(writer->file, 0, SEEK_SET) != 0 || fwrite(&header, sizeof header, 1, writer->file) != 1))
+    {
+        writer->failed = true;
+    }
+
+    bool written = !writer->failed;
+    if (fclose(writer->file) != 0)
+    {
+        written = false;
+    }
+    writer->file = NULL;
+    FreeWriter(writer);
+
+    return written;
+}
+
+/**
+ * OpenGameDatabase
+ *
+ * Parameters:
+ *  - db:   receives the mapping.
+ *  - path: database file built by FinishGameDatabase.
+ *
+ * Returns:
+ *  - false if the file cannot be mapped, is not a database of this version and byte
+ *    order, or its sections do not fit in it.
+ */
+bool OpenGameDatabase(GameDatabase *db, const char *path)
+{
+    memset(db, 0, sizeof *db);
+
+    int fd = open(path, O_RDONLY);
+    struct stat info;
+    if (fd < 0)
+    {
+        return false;
+    }
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(GameDbHeader))
+    {
+        close(fd);
+        return false;
+    }
+
+    size_t size = (size_t)info.st_size;
+    void *mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        return false;
+    }
+
+    GameDbHeader header;
+    memcpy(&header, mapping, sizeof header);
+
+    bool valid = memcmp(header.magic, GAME_DB_MAGIC, sizeof header.magic) == 0 &&
+                 header.version == GAME_DB_VERSION && header.byteOrder == GAME_DB_BYTE_ORDER &&
+                 header.fileSize == size &&
+                 header.gameTableOffset % sizeof(uint64_t) == 0 && header.positionIndexOffset % sizeof(uint64_t) == 0 &&
+                 header.gameTableOffset <= size && (size - header.gameTableOffset) / sizeof(uint64_t) >= header.gameCount &&
+                 header.positionIndexOffset <= size && (size - header.positionIndexOffset) / sizeof(GameDbPosition) >= header.positionCount;
+    if (!valid)
+    {
+        munmap(mapping, size);
+        return false;
+    }
+
+    db->data = mapping;
+    db->size = size;
+    db->gameCount = header.gameCount;
+    db->positionCount = header.positionCount;
+    db->gameOffsets = (const uint64_t *)(db->data + header.gameTableOffset);
+    db->positions = (const GameDbPosition *)(db->data + header.positionIndexOffset);
+    return true;
+}
+
+/**
+ * CloseGameDatabase
+ */
+void CloseGameDatabase(GameDatabase *db)
+{
+    if (db->data != NULL)
+    {
+        munmap((void *)db->data, db->size);
+    }
+    memset(db, 0, sizeof *db);
+}
+
+/**
+ * ReadDatabaseGame
+ *
+ * Parameters:
+ *  - db:    open database.
+ *  - index: game number (0 .. gameCount - 1, insertion order).
+ *  - game:  receives the game; end is the position after the last move.
+ *
+ * Returns:
+ *  - false if index is out of range, the record does not decode to a legal game or it has
+ *    more than MAX_PGN_PLIES moves.
+ */
+bool ReadDatabaseGame(const GameDatabase *db, uint32_t index, PgnGame *game)
+{
+    if (index >= db->gameCount || db->gameOffsets[index] > db->size - sizeof(GameDbRecord))
+    {
+        return false;
+    }
+
+    const unsigned char *record = db->data + db->gameOffsets[index];
+    GameDbRecord header;
+    memcpy(&header, record, sizeof header);
+
+    size_t tagsOffset = (size_t)(record - db->data) + sizeof header;
+    size_t movesOffset = (tagsOffset + header.tagBytes + 1) & ~(size_t)1;
+    if (header.tagBytes == 0 || header.tagBytes > db->size - tagsOffset || record[sizeof header + header.tagBytes - 1] != '\0' ||
+        movesOffset > db->size || (db->size - movesOffset) / sizeof(ChessMove) < header.plyCount || header.plyCount > MAX_PGN_PLIES ||
+        header.result >= sizeof RESULT_TAGS / sizeof RESULT_TAGS[0])
+    {
+        return false;
+    }
+
+    ClearPgnGame(game);
+
+    // Seven consecutive strings; a record with fewer is damaged
+    char *fields[GAME_DB_TAG_COUNT - 1] = {game->event, game->site, game->date, game->round, game->white, game->black};
+    const char *tag = (const char *)db->data + tagsOffset;
+    const char *tagsEnd = tag + header.tagBytes;
+    for (int i = 0; i < GAME_DB_TAG_COUNT; i++)
+    {
+        const char *terminator = memchr(tag, '\0', (size_t)(tagsEnd - tag));
+        if (terminator == NULL)
+        {
+            return false;
+        }
+        size_t length = (size_t)(terminator - tag);
+
+        if (i < GAME_DB_TAG_COUNT - 1)
+        {
+            size_t kept = (length < MAX_PGN_TAG_LENGTH) ? length : MAX_PGN_TAG_LENGTH - 1;
+            memcpy(fields[i], tag, kept);
+            fields[i][kept] = '\0';
+        }
+        else if (length > 0 && !PositionFromFENSpan(&game->start, tag, length))
+        {
+            return false;
+        }
+        tag += length + 1;
+    }
+    memcpy(game->result, RESULT_TAGS[header.result], strlen(RESULT_TAGS[header.result]) + 1);
+
+    // Moves, each checked against the legal moves of the position it is played in
+    memcpy(game->moves, db->data + movesOffset, sizeof(ChessMove) * header.plyCount);
+    game->plyCount = header.plyCount;
+    game->end = game->start;
+    for (int ply = 0; ply < game->plyCount; ply++)
+    {
+        MoveList list;
+        bool legal = false;
+
+        GenerateLegalMoves(&game->end, &list);
+        for (int i = 0; i < list.count && !legal; i++)
+        {
+            legal = (list.moves[i] == game->moves[ply]);
+        }
+        if (!legal)
+        {
+            return false;
+        }
+
+        UndoInfo undo;
+        MakeMove(&game->end, game->moves[ply], &undo);
+    }
+
+    return true;
+}
+
+/**
+ * FindPositionGames
+ *
+ * Parameters:
+ *  - db:   open database.
+ *  - key:  Zobrist key of the position (Position.key, GameState.zobristKey).
+ *  - hits: receives up to max games, in game-number order, each with the first ply at
+ *          which it reaches the position (may be NULL if max is 0).
+ *
+ * Returns:
+ *  - The number of distinct games reaching the position (can be larger than max).
+ *
+ * Notes:
+ *  - Matching is by key only; a 64-bit key collision is not checked for.
+ */
+size_t FindPositionGames(const GameDatabase *db, uint64_t key, GameDbHit *hits, size_t max)
+{
+    size_t low = 0;
+    size_t high = (size_t)db->positionCount;
+
+    // First entry with a key >= key
+    while (low < high)
+    {
+        size_t middle = low + (high - low) / 2;
+        if (db->positions[middle].key < key)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    size_t games = 0;
+    for (size_t i = low; i < db->positionCount && db->positions[i].key == key; i++)
+    {
+        // Entries of one game are adjacent, lowest ply first
+        if (i > low && db->positions[i - 1].key == key && db->positions[i - 1].game == db->positions[i].game)
+        {
+            continue;
+        }
+
+        if (games < max)
+        {
+            hits[games] = (GameDbHit){db->positions[i].game, db->positions[i].ply};
+        }
+        games++;
+    }
+
+    return games;
+}
+
+/**
+ * WriteBytes (static)
+ *
+ * Append size bytes to the database file; a short write fails the writer.
+ */
+static bool WriteBytes(GameDatabaseWriter *writer, const void *bytes, size_t size)
+{
+    if (writer->failed)
+    {
+        return false;
+    }
+
+    if (size > 0 && fwrite(bytes, 1, size, writer->file) != size)
+    {
+        writer->failed = true;
+        return false;
+    }
+
+    writer->offset += size;
+    return true;
+}
+
+/**
+ * WritePadding (static)
+ *
+ * Append zero bytes up to the next multiple of alignment (at most 8).
+ */
+static bool WritePadding(GameDatabaseWriter *writer, size_t alignment)
+{
+    static const unsigned char ZEROS[8] = {0};
+    size_t remainder = (size_t)(writer->offset % alignment);
+
+    return remainder == 0 || WriteBytes(writer, ZEROS, alignment - remainder);
+}
+
+/**
+ * AddPosition (static)
+ *
+ * Append one index entry to the current run, spilling the run first when it is full.
+ */
+static bool AddPosition(GameDatabaseWriter *writer, uint64_t key, uint32_t game, uint32_t ply)
+{
+    if (writer->runLength == GAME_DB_RUN_POSITIONS && !SpillRun(writer))
+    {
+        writer->failed = true;
+        return false;
+    }
+
+    writer->run[writer->runLength++] = (GameDbPosition){key, game, ply};
+    writer->positionCount++;
+    return true;
+}
+
+/**
+ * SpillRun (static)
+ *
+ * Sort the current run and write it to a new temporary file.
+ */
+static bool SpillRun(GameDatabaseWriter *writer)
+{
+    if (writer->runCount == writer->runCapacity)
+    {
+        size_t capacity = (writer->runCapacity == 0) ? 16 : writer->runCapacity * 2;
+        FILE **grown = realloc(writer->runFiles, sizeof(FILE *) * capacity);
+        if (grown == NULL)
+        {
+            return false;
+        }
+        writer->runFiles = grown;
+        writer->runCapacity = capacity;
+    }
+
+    FILE *file = tmpfile();
+    if (file == NULL)
+    {
+        return false;
+    }
+    writer->runFiles[writer->runCount++] = file;
+
+    SortRun(writer);
+    if (fwrite(writer->run, sizeof(GameDbPosition), writer->runLength, file) != writer->runLength || fflush(file) != 0)
+    {
+        return false;
+    }
+
+    writer->runLength = 0;
+    return true;
+}
+
+/**
+ * MergeRuns (static)
+ *
+ * Merge the sorted runs into the index section of the database file. The heap holds one
+ * reader per run that still has entries, ordered by its current entry.
+ */
+static bool MergeRuns(GameDatabaseWriter *writer)
+{
+    RunReader *readers = calloc(writer->runCount, sizeof *readers);
+    RunReader **heap = calloc(writer->runCount, sizeof *heap);
+    size_t count = 0;
+    bool merged = (readers != NULL && heap != NULL);
+
+    for (size_t i = 0; merged && i < writer->runCount; i++)
+    {
+        readers[i].file = writer->runFiles[i];
+        rewind(readers[i].file);
+        if (NextRunPosition(&readers[i]))
+        {
+            heap[count++] = &readers[i];
+        }
+    }
+
+    for (size_t i = count / 2; merged && i-- > 0;)
+    {
+        SiftDown(heap, count, i);
+    }
+
+    // The run buffer is free now and collects the output
+    size_t output = 0;
+    while (merged && count > 0)
+    {
+        RunReader *top = heap[0];
+
+        writer->run[output++] = top->buffer[top->cursor++];
+        if (output == GAME_DB_RUN_POSITIONS)
+        {
+            merged = WriteBytes(writer, writer->run, sizeof(GameDbPosition) * output);
+            output = 0;
+        }
+
+        if (!NextRunPosition(top))
+        {
+            heap[0] = heap[--count];
+        }
+        SiftDown(heap, count, 0);
+    }
+
+    if (merged && output > 0)
+    {
+        merged = WriteBytes(writer, writer->run, sizeof(GameDbPosition) * output);
+    }
+
+    free(heap);
+    free(readers);
+    return merged;
+}
+
+/**
+ * NextRunPosition (static)
+ *
+ * Make sure reader has a current entry, refilling its buffer from the run file.
+ *
+ * Returns:
+ *  - false once the run is exhausted.
+ */
+static bool NextRunPosition(RunReader *reader)
+{
+    if (reader->cursor < reader->length)
+    {
+        return true;
+    }
+
+    reader->length = fread(reader->buffer, sizeof(GameDbPosition), MERGE_BUFFER_POSITIONS, reader->file);
+    reader->cursor = 0;
+    return reader->length > 0;
+}
+
+/**
+ * SiftDown (static)
+ *
+ * Restore the min-heap order below heap[at].
+ */
+static void SiftDown(RunReader **heap, size_t count, size_t at)
+{
+    for (;;)
+    {
+        size_t smallest = at;
+        size_t left = 2 * at + 1;
+        size_t right = left + 1;
+
+        if (left < count && PositionLess(&heap[left]->buffer[heap[left]->cursor], &heap[smallest]->buffer[heap[smallest]->cursor]))
+        {
+            smallest = left;
+        }
+        if (right < count && PositionLess(&heap[right]->buffer[heap[right]->cursor], &heap[smallest]->buffer[heap[smallest]->cursor]))
+        {
+            smallest = right;
+        }
+        if (smallest == at)
+        {
+            return;
+        }
+
+        RunReader *swap = heap[at];
+        heap[at] = heap[smallest];
+        heap[smallest] = swap;
+        at = smallest;
+    }
+}
+
+/**
+ * SortRun (static)
+ *
+ * Sort the current run by key, then game, then ply. Entries are appended in game and ply
+ * order, so a stable sort on the key alone gives the full order: an LSD radix sort, one
+ * pass per key byte through the scratch buffer (a pass whose byte is the same for every
+ * entry is skipped).
+ */
+static void SortRun(GameDatabaseWriter *writer)
+{
+    GameDbPosition *from = writer->run;
+    GameDbPosition *to = writer->scratch;
+    size_t length = writer->runLength;
+
+    for (int shift = 0; shift < 64; shift += 8)
+    {
+        size_t counts[256] = {0};
+        for (size_t i = 0; i < length; i++)
+        {
+            counts[(from[i].key >> shift) & 0xFF]++;
+        }
+        if (length == 0 || counts[(from[0].key >> shift) & 0xFF] == length)
+        {
+            continue;
+        }
+
+        size_t offset = 0;
+        for (int bucket = 0; bucket < 256; bucket++)
+        {
+            size_t count = counts[bucket];
+            counts[bucket] = offset;
+            offset += count;
+        }
+        for (size_t i = 0; i < length; i++)
+        {
+            to[counts[(from[i].key >> shift) & 0xFF]++] = from[i];
+        }
+
+        GameDbPosition *swap = from;
+        from = to;
+        to = swap;
+    }
+
+    // An odd number of passes leaves the result in the scratch buffer
+    if (from != writer->run)
+    {
+        memcpy(writer->run, from, sizeof(GameDbPosition) * length);
+    }
+}
+
+/**
+ * PositionLess (static)
+ */
+static bool PositionLess(const GameDbPosition *a, const GameDbPosition *b)
+{
+    if (a->key != b->key)
+    {
+        return a->key < b->key;
+    }
+    if (a->game != b->game)
+    {
+        return a->game < b->game;
+    }
+    return a->ply < b->ply;
+}
+
+/**
+ * FreeWriter (static)
+ *
+ * Release every buffer and temporary file of the writer (and the database file if it is
+ * still open).
+ */
+static void FreeWriter(GameDatabaseWriter *writer)
+{
+    if (writer->file != NULL)
+    {
+        fclose(writer->file);
+        writer->file = NULL;
+    }
+
+    for (size_t i = 0; i < writer->runCount; i++)
+    {
+        fclose(writer->runFiles[i]);
+    }
+
+    free(writer->runFiles);
+    free(writer->gameOffsets);
+    free(writer->run);
+    free(writer->scratch);
+    writer->runFiles = NULL;
+    writer->gameOffsets = NULL;
+    writer->run = NULL;
+    writer->scratch = NULL;
+    writer->runCount = 0;
+}
+
+/**
+ * ResultCode (static)
+ *
+ * GameDbResult of a PGN result tag.
+ */
+static uint8_t ResultCode(const char *result)
+{
+    for (uint8_t code = 1; code < sizeof RESULT_TAGS / sizeof RESULT_TAGS[0]; code++)
+    {
+        if (strcmp(result, RESULT_TAGS[code]) == 0)
+        {
+            return code;
+        }
+    }
+
+    return GAME_DB_RESULT_UNKNOWN;
+}
+
+/**
+ * TagAt (static)
+ *
+ * The tag strings of a record in file order (Event .. Black).
+ */
+static const char *TagAt(const PgnGame *game, int tag)
+{
+    const char *tags[GAME_DB_TAG_COUNT - 1] = {game->event, game->site, game->date, game->round, game->white, game->black};
+
+    return tags[tag];
+}
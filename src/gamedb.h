@@ -0,0 +1,120 @@
+/**
+ * gamedb.h
+ *
+ * Responsibilities:
+ * - Define the binary game database: games stored as 16-bit moves with a small header,
+ *   plus an index from Zobrist position key to the games (and plies) reaching it.
+ * - Export the builder (fed with replayed PgnGames, e.g. from ReadPgnGame) and the
+ *   memory-mapped reader with its position query.
+ *
+ * Notes:
+ * - A database is one file; OpenGameDatabase maps it read-only and only checks its
+ *   header, so opening costs the same for ten games or ten million and the pages of
+ *   games and index are read from disk when a query touches them.
+ * - The file is written in the byte order of the machine that built it; another byte
+ *   order is rejected when the database is opened.
+ * - This module does not include raylib; it is part of libchesscore (see chesscore.h).
+ */
+
+#ifndef GAMEDB_H
+#define GAMEDB_H
+
+#include "movegen.h"
+#include "pgn.h"
+#include "position.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/* Positions the builder sorts in memory before spilling them to a temporary run */
+#define GAME_DB_RUN_POSITIONS (1u << 21)
+
+/**
+ * GameDbHit
+ *
+ * One game reaching a queried position: the game number and the first ply at which the
+ * position appears (0 = the game's start position).
+ */
+typedef struct GameDbHit
+{
+    uint32_t game;
+    uint32_t ply;
+} GameDbHit;
+
+/**
+ * GameDbPosition
+ *
+ * Index entry (16 bytes). The index is one array of them sorted by key, then game,
+ * then ply, so all games reaching a position are one contiguous range.
+ */
+typedef struct GameDbPosition
+{
+    uint64_t key;
+    uint32_t game;
+    uint32_t ply;
+} GameDbPosition;
+
+/**
+ * GameDatabase
+ *
+ * An open (mapped) database. Read-only and never modified, so any number of threads
+ * may query it at once.
+ */
+typedef struct GameDatabase
+{
+    const unsigned char *data;
+    size_t size;
+    uint32_t gameCount;
+    uint64_t positionCount;
+    const uint64_t *gameOffsets;       /* gameCount record offsets */
+    const GameDbPosition *positions;   /* positionCount sorted entries */
+} GameDatabase;
+
+/**
+ * GameDatabaseWriter
+ *
+ * State of a database being built (BeginGameDatabase .. FinishGameDatabase). Games are
+ * written to the file as they are added; their positions are collected, sorted in runs
+ * of GAME_DB_RUN_POSITIONS and merged into the index at the end, so memory stays bounded
+ * by two run buffers (64 MB) plus 8 bytes per game.
+ */
+typedef struct GameDatabaseWriter
+{
+    FILE *file;
+    uint64_t offset;
+    uint64_t *gameOffsets;
+    uint32_t gameCount;
+    uint32_t gameCapacity;
+    GameDbPosition *run;
+    GameDbPosition *scratch;   /* radix sort buffer, GAME_DB_RUN_POSITIONS entries */
+    size_t runLength;
+    FILE **runFiles;
+    size_t runCount;
+    size_t runCapacity;
+    uint64_t positionCount;
+    bool failed;
+} GameDatabaseWriter;
+
+/* Creates the database file at path. Returns false if it cannot be created or memory is short */
+bool BeginGameDatabase(GameDatabaseWriter *writer, const char *path);
+
+/* Appends a game (its tags, start and moves; the moves must be legal in sequence). Returns false on an I/O or memory error */
+bool AddDatabaseGame(GameDatabaseWriter *writer, const PgnGame *game);
+
+/* Writes the index and the header and closes the file. Returns false if anything failed since BeginGameDatabase */
+bool FinishGameDatabase(GameDatabaseWriter *writer);
+
+/* Maps the database at path. Returns false (db empty) if it cannot be opened or is not a valid database */
+bool OpenGameDatabase(GameDatabase *db, const char *path);
+
+/* Unmaps the database */
+void CloseGameDatabase(GameDatabase *db);
+
+/* Fills game with game number index (tags, start, moves, end replayed). Returns false if index is out of range or the record is damaged */
+bool ReadDatabaseGame(const GameDatabase *db, uint32_t index, PgnGame *game);
+
+/* Finds the games reaching the position with key; writes up to max hits (by game number) and returns how many games there are in total */
+size_t FindPositionGames(const GameDatabase *db, uint64_t key, GameDbHit *hits, size_t max);
+
+#endif /* GAMEDB_H */
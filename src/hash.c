@@ -2,23 +2,25 @@
  * hash.c
  *
  * Responsibilities:
- * - Manage a dynamic array of game state hashes (DynamicHashArray).
- * - Compute the hash of the current game state (using FEN and MD5).
- * - Check for threefold repetition by comparing the current hash against history.
+ * - Manage a dynamic array of position keys (DynamicHashArray).
+ * - Check for threefold repetition by comparing the current key against the positions
+ *   since the last irreversible move (CountRepetitions in hash.h).
  *
  * Implementation Details:
  * - Uses a dynamic array (DHA) that auto-expands when full.
- * - Hashes are 128-bit values (stored as 4 uint32_t) derived from MD5.
- * - The hash computation relies on the FEN string generated by save.c.
+ * - Keys are the 64-bit Zobrist keys maintained incrementally by move.c, so recording a
+ *   position is a single store and comparing two positions is a single integer compare.
+ * - The whole game is kept: Undo truncates, Redo pushes again, and the half-move clock
+ *   bounds each check, so nothing has to be cleared or rebuilt on irreversible moves.
+ * - Part of libchesscore: allocation failures are reported with CORE_DEBUG_LOG, not TraceLog.
  */
 
 #include "hash.h"
-#include "raylib.h"
-#include "save.h"
+#include "chesscore.h"
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
-#include <string.h>
 
 // Local prototype
 static bool ExpandDHA(DynamicHashArray *DHA, size_t expandFactor);
@@ -45,15 +47,15 @@ DynamicHashArray *InitializeDHA(size_t capacity)
 
     if (DHA == NULL)
     {
-        TraceLog(LOG_DEBUG, "Failed to create space for DynamicHashArray.");
+        CORE_DEBUG_LOG("Failed to create space for DynamicHashArray.");
         return NULL;
     }
 
-    DHA->hashArray = malloc(sizeof(Hash) * capacity);
+    DHA->hashArray = malloc(sizeof(uint64_t) * capacity);
 
     if (DHA->hashArray == NULL)
     {
-        TraceLog(LOG_DEBUG, "Failed to create space for hashArray.");
+        CORE_DEBUG_LOG("Failed to create space for hashArray.");
         free(DHA);
         return NULL;
     }
@@ -94,13 +96,13 @@ void ClearDHA(DynamicHashArray *DHA)
 /**
  * PushDHA
  *
- * Adds a new hash to the end of the array.
+ * Adds a new key to the end of the array.
  * Automatically expands the array if capacity is reached.
  *
  * Returns:
  *  - true if successful, false if expansion failed.
  */
-bool PushDHA(DynamicHashArray *DHA, Hash hash)
+bool PushDHA(DynamicHashArray *DHA, uint64_t key)
 {
     if (DHA->size >= DHA->capacity)
     {
@@ -110,27 +112,40 @@ bool PushDHA(DynamicHashArray *DHA, Hash hash)
         }
     }
 
-    DHA->hashArray[DHA->size++] = hash;
+    DHA->hashArray[DHA->size++] = key;
     return true;
 }
 
 /**
  * PopDHA
  *
- * Removes and returns the last hash added to the array.
+ * Removes and returns the last key added to the array.
  * Used when undoing moves.
  *
  * Returns:
- *  - The removed Hash, or a zeroed Hash if empty.
+ *  - The removed key, or 0 if empty.
  */
-Hash PopDHA(DynamicHashArray *DHA)
+uint64_t PopDHA(DynamicHashArray *DHA)
 {
     if (DHA->size == 0)
     {
-        return (Hash){0};
+        return 0;
     }
 
-    return DHA->hashArray[DHA->size--];
+    return DHA->hashArray[--DHA->size];
+}
+
+/**
+ * TruncateDHA
+ *
+ * Keeps the first 'size' keys (all of them if there are fewer).
+ */
+void TruncateDHA(DynamicHashArray *DHA, size_t size)
+{
+    if (size < DHA->size)
+    {
+        DHA->size = size;
+    }
 }
 
 /**
@@ -140,100 +155,34 @@ Hash PopDHA(DynamicHashArray *DHA)
  */
 static bool ExpandDHA(DynamicHashArray *DHA, size_t expandFactor)
 {
-    Hash *temp = realloc(DHA->hashArray, sizeof(Hash) * DHA->capacity * expandFactor);
+    uint64_t *temp = realloc(DHA->hashArray, sizeof(uint64_t) * DHA->capacity * expandFactor);
 
     if (temp == NULL)
     {
-        TraceLog(LOG_DEBUG, "Failed to expand the DHA.");
+        CORE_DEBUG_LOG("Failed to expand the DHA.");
         return false;
     }
 
     DHA->hashArray = temp;
     DHA->capacity *= expandFactor;
-    TraceLog(LOG_DEBUG, "Expanded the DHA to new capacity:%zu", DHA->capacity);
+    CORE_DEBUG_LOG("Expanded the DHA to new capacity:%zu", DHA->capacity);
     return true;
 }
 
 /**
  * IsRepeated3times
  *
- * Checks if the provided 'currentHash' appears at least 2 times in the history.
- * (2 times in history + 1 current occurrence = 3 repetitions).
+ * Checks if the current position (the last key) appears at least 2 more times in the
+ * history (2 earlier occurrences + the current one = 3 repetitions).
  *
  * Parameters:
- *  - DHA: The history of previous game states.
- *  - currentHash: The hash of the board state right now.
+ *  - DHA: The history of the game, current position last.
+ *  - halfMoveClock: Plies since the last irreversible move; only those positions are scanned.
  *
  * Returns:
  *  - true if the position has occurred 3 times total.
  */
-bool IsRepeated3times(DynamicHashArray *DHA, Hash currentHash)
-{
-    int count = 1; // 1 for the current position we are holding
-
-    // Optimization: If history is tiny, it can't be a repetition yet
-    if (DHA->size < 2) // Need at least 2 previous occurrences to make 3
-    {
-        return false;
-    }
-
-    for (size_t i = 0; i < DHA->size; i++)
-    {
-        if (memcmp(&DHA->hashArray[i], &currentHash, sizeof(Hash)) == 0)
-        {
-            if (++count >= 3)
-            {
-                return true;
-            }
-        }
-    }
-
-    return false;
-}
-
-/**
- * CurrentGameStateHash
- *
- * Generates a unique hash for the current board state.
- *
- * Mechanism:
- * 1. Calls SaveFEN() to get the board string.
- * 2. Truncates the FEN to remove move counters (halfmove/fullmove clocks)
- *    because repetition depends only on piece placement, turn, castling, and en passant.
- * 3. Computes MD5 hash of this string.
- *
- * Returns:
- *  - A Hash struct containing the 128-bit MD5 signature.
- */
-Hash CurrentGameStateHash(void)
+bool IsRepeated3times(const DynamicHashArray *DHA, int halfMoveClock)
 {
-    unsigned char *currentState = SaveFEN();
-    int spaceCount = 0;
-
-    // We only care about the first 4 fields of FEN for repetition:
-    // 1. Piece placement
-    // 2. Active color
-    // 3. Castling availability
-    // 4. En passant target square
-    // The 5th and 6th fields (halfmove clock, fullmove number) are irrelevant for 3-fold repetition.
-    int counter;
-    for (counter = 0; spaceCount < 4; spaceCount += currentState[counter++] == ' ')
-    {
-        ;
-    }
-
-    currentState[counter - 1] = '\0';
-
-    int dataSize = (int)strlen((const char *)currentState);
-    unsigned int *array = ComputeMD5(currentState, dataSize);
-
-    free(currentState);
-    Hash hash = {0};
-
-    if (array)
-    {
-        memcpy(hash.data, array, sizeof(Hash));
-    }
-
-    return hash;
+    return CountRepetitions(DHA->hashArray, DHA->size, halfMoveClock, 2) >= 2;
 }
@@ -2,9 +2,16 @@
  * hash.h
  *
  * Responsibilities:
- * - Define the Hash structure used to uniquely identify game states.
  * - Define the DynamicHashArray structure for storing history (for 3-fold repetition).
- * - Export functions to manage the hash history and compute current state hashes.
+ * - Export functions to manage the history of position keys.
+ *
+ * Notes:
+ * - The stored values are the 64-bit Zobrist keys kept in GameState.zobristKey (see zobrist.h).
+ * - The history holds one key per ply of the game, the current position last; it is never
+ *   cleared on irreversible moves. Repetition checks (CountRepetitions) only look at the
+ *   last halfMoveClock keys and, among those, only every second one (same side to move).
+ * - CountRepetitions works on any key path ending with the current position, so the
+ *   search uses it on its own per-thread key stack as well.
  */
 
 #ifndef HASH_H
@@ -14,28 +21,18 @@
 #include <stddef.h>
 #include <stdint.h>
 
-/**
- * Hash
- *
- * Represents a 128-bit hash value (MD5 result).
- * Used to compare board states efficiently.
- */
-typedef struct
-{
-    uint32_t data[4];
-} Hash;
-
 /**
  * DynamicHashArray
  *
- * A resizable array container for Hash objects.
- * Used to store the history of all board positions in the current game.
+ * A resizable array container for position keys.
+ * Used to store the history of all board positions in the current game:
+ * hashArray[i] is the key after i plies, hashArray[size - 1] the current position.
  */
 typedef struct
 {
-    Hash *hashArray; // Pointer to the heap-allocated array
-    size_t size;     // Current number of elements
-    size_t capacity; // Total allocated slots
+    uint64_t *hashArray; // Pointer to the heap-allocated array of keys
+    size_t size;         // Current number of elements
+    size_t capacity;     // Total allocated slots
 } DynamicHashArray;
 
 /* Allocates and initializes a new DynamicHashArray */
@@ -47,16 +44,53 @@ void FreeDHA(DynamicHashArray *DHA);
 /* Resets the count to 0 (does not free memory) */
 void ClearDHA(DynamicHashArray *DHA);
 
-/* Checks if 'currentHash' exists at least twice in the history */
-bool IsRepeated3times(DynamicHashArray *DHA, Hash currentHash);
+/* Drops the keys after the first 'size' ones (Undo/jumping back); never grows the array */
+void TruncateDHA(DynamicHashArray *DHA, size_t size);
+
+/* Checks if the current (last) key occurred twice before within the last halfMoveClock positions */
+bool IsRepeated3times(const DynamicHashArray *DHA, int halfMoveClock);
+
+/* Adds a key to the history, expanding if necessary */
+bool PushDHA(DynamicHashArray *DHA, uint64_t key);
+
+/* Removes the last key (for undo operations) */
+uint64_t PopDHA(DynamicHashArray *DHA);
+
+/**
+ * CountRepetitions
+ *
+ * Number of earlier occurrences (at most limit) of keys[count - 1], the current position,
+ * among the positions since the last irreversible move.
+ *
+ * Parameters:
+ *  - keys/count:    key path of the game (or search), current position last.
+ *  - halfMoveClock: plies since the last capture or pawn move; older keys cannot repeat.
+ *  - limit:         stop counting here (1 for a search draw, 2 for a threefold repetition).
+ *
+ * Notes:
+ *  - Only keys with the same side to move are compared (every second one), starting 4
+ *    plies back: each side needs two moves to restore a position.
+ */
+static inline int CountRepetitions(const uint64_t *keys, size_t count, int halfMoveClock, int limit)
+{
+    if (count == 0 || halfMoveClock < 4)
+    {
+        return 0;
+    }
 
-/* Adds a hash to the history, expanding if necessary */
-bool PushDHA(DynamicHashArray *DHA, Hash hash);
+    size_t last = count - 1;
+    size_t window = ((size_t)halfMoveClock < last) ? (size_t)halfMoveClock : last;
+    int found = 0;
 
-/* Removes the last hash (for undo operations) */
-Hash PopDHA(DynamicHashArray *DHA);
+    for (size_t back = 4; back <= window; back += 2)
+    {
+        if (keys[last - back] == keys[last] && ++found >= limit)
+        {
+            break;
+        }
+    }
 
-/* Computes the hash of the current game state */
-Hash CurrentGameStateHash(void);
+    return found;
+}
 
 #endif
\ No newline at end of file
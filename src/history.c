@@ -0,0 +1,192 @@
+/**
+ * history.c
+ *
+ * Responsibilities:
+ * - Implement the HistorySnapshots arena of position checkpoints.
+ *
+ * Notes:
+ * - The arena grows automatically (doubles in capacity) like MoveStack; a checkpoint is
+ *   a Position plus two counters, so even a long game keeps only a few kilobytes.
+ * - The caller keeps the checkpoints consistent with the game line: record one whenever
+ *   the line reaches a multiple of HISTORY_SNAPSHOT_INTERVAL and truncate when a new move
+ *   replaces the rest of the line (CommitMove and ReplayHistory in move.c).
+ * - Uses Raylib's TraceLog for error reporting.
+ */
+
+#include "history.h"
+#include "position.h"
+#include "raylib.h"
+#include "settings.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+static bool ExpandSnapshots(HistorySnapshots *snapshots, size_t capacity);
+
+/**
+ * InitializeSnapshots
+ *
+ * Parameters:
+ *  - initialCapacity: checkpoints allocated up front (at least one).
+ *
+ * Returns:
+ *  - Pointer to the allocated arena, or NULL if allocation fails.
+ */
+HistorySnapshots *InitializeSnapshots(size_t initialCapacity)
+{
+    if (initialCapacity < 1)
+    {
+        initialCapacity = 1;
+    }
+
+    HistorySnapshots *snapshots = malloc(sizeof(HistorySnapshots));
+
+    if (snapshots == NULL)
+    {
+        TraceLog(LOG_DEBUG, "Failed to create space for the history snapshots.\n");
+        return NULL;
+    }
+
+    snapshots->data = malloc(initialCapacity * sizeof(HistorySnapshot));
+
+    if (snapshots->data == NULL)
+    {
+        TraceLog(LOG_DEBUG, "Failed to create space for the data of the history snapshots.\n");
+        free(snapshots);
+        return NULL;
+    }
+
+    snapshots->count = 0;
+    snapshots->capacity = initialCapacity;
+
+    return snapshots;
+}
+
+/**
+ * FreeSnapshots
+ *
+ * Parameters:
+ *  - snapshots: the arena to free. Safe to pass NULL.
+ */
+void FreeSnapshots(HistorySnapshots *snapshots)
+{
+    if (snapshots == NULL)
+    {
+        return;
+    }
+
+    free(snapshots->data);
+    free(snapshots);
+}
+
+/**
+ * ClearSnapshots
+ *
+ * Logically clears the arena; the memory is kept for the next game.
+ */
+void ClearSnapshots(HistorySnapshots *snapshots)
+{
+    snapshots->count = 0;
+}
+
+/**
+ * RecordSnapshot
+ *
+ * Parameters:
+ *  - ply: ply of position in the game line.
+ *  - position, deadWhite, deadBlack: the game at that ply.
+ *
+ * Behavior:
+ *  - Only the ply of the next checkpoint (count * HISTORY_SNAPSHOT_INTERVAL) is stored;
+ *    any other ply is ignored, so callers can offer every ply they reach.
+ *
+ * Returns:
+ *  - false if the arena could not grow (the checkpoint is lost; later plies are then
+ *    restored from the previous one with more replays).
+ */
+bool RecordSnapshot(HistorySnapshots *snapshots, size_t ply, const Position *position, int deadWhite, int deadBlack)
+{
+    if (ply != snapshots->count * HISTORY_SNAPSHOT_INTERVAL)
+    {
+        return true;
+    }
+
+    if (snapshots->count >= snapshots->capacity)
+    {
+        if (!ExpandSnapshots(snapshots, 2 * snapshots->capacity))
+        {
+            return false;
+        }
+    }
+
+    snapshots->data[snapshots->count++] = (HistorySnapshot){
+        .position = *position,
+        .deadWhite = (unsigned char)deadWhite,
+        .deadBlack = (unsigned char)deadBlack};
+    return true;
+}
+
+/**
+ * TruncateSnapshots
+ *
+ * Keeps the checkpoints of plies 0..ply; the ones after it described moves that are no
+ * longer part of the line.
+ */
+void TruncateSnapshots(HistorySnapshots *snapshots, size_t ply)
+{
+    size_t keep = ply / HISTORY_SNAPSHOT_INTERVAL + 1;
+
+    if (snapshots->count > keep)
+    {
+        snapshots->count = keep;
+    }
+}
+
+/**
+ * NearestSnapshot
+ *
+ * Returns:
+ *  - The checkpoint with the largest ply not above ply (*snapshotPly receives that ply),
+ *    or NULL if the arena is empty.
+ */
+const HistorySnapshot *NearestSnapshot(const HistorySnapshots *snapshots, size_t ply, size_t *snapshotPly)
+{
+    if (snapshots->count == 0)
+    {
+        return NULL;
+    }
+
+    size_t index = ply / HISTORY_SNAPSHOT_INTERVAL;
+    if (index >= snapshots->count)
+    {
+        index = snapshots->count - 1;
+    }
+
+    *snapshotPly = index * HISTORY_SNAPSHOT_INTERVAL;
+    return &snapshots->data[index];
+}
+
+/**
+ * ExpandSnapshots (static)
+ *
+ * Internal helper to resize the checkpoint array.
+ *
+ * Returns:
+ *  - true if realloc succeeded.
+ *  - false if realloc failed.
+ */
+static bool ExpandSnapshots(HistorySnapshots *snapshots, size_t capacity)
+{
+    HistorySnapshot *temp = realloc(snapshots->data, sizeof(HistorySnapshot) * capacity);
+
+    if (temp == NULL)
+    {
+        TraceLog(LOG_DEBUG, "Failed to expand the history snapshots.\n");
+        return false;
+    }
+
+    snapshots->data = temp;
+    snapshots->capacity = capacity;
+    TraceLog(LOG_DEBUG, "Expanded the history snapshots to new capacity:%zu", snapshots->capacity);
+    return true;
+}
@@ -0,0 +1,63 @@
+/**
+ * history.h
+ *
+ * Responsibilities:
+ * - Define the HistorySnapshots arena: a copy of the position every
+ *   HISTORY_SNAPSHOT_INTERVAL plies of the game line (the moves of the Undo stack
+ *   followed by those of the Redo stack).
+ * - Export functions to record, forget and look up those checkpoints (JumpToPly in move.c
+ *   restores any ply from the nearest one).
+ */
+
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include "position.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * HistorySnapshot
+ *
+ * The game at one checkpoint ply: the position and the number of dead pieces of each
+ * team (the dead-piece slots themselves are filled in capture order along the line).
+ */
+typedef struct HistorySnapshot
+{
+    Position position;
+    unsigned char deadWhite;
+    unsigned char deadBlack;
+} HistorySnapshot;
+
+/**
+ * HistorySnapshots
+ *
+ * data[i] is the checkpoint of ply i * HISTORY_SNAPSHOT_INTERVAL; data[0] is the start
+ * position of the game once it has been recorded.
+ */
+typedef struct HistorySnapshots
+{
+    HistorySnapshot *data;
+    size_t count;
+    size_t capacity;
+} HistorySnapshots;
+
+/* Allocates an empty arena */
+HistorySnapshots *InitializeSnapshots(size_t initialCapacity);
+
+/* Frees the arena and its data */
+void FreeSnapshots(HistorySnapshots *snapshots);
+
+/* Forgets every checkpoint */
+void ClearSnapshots(HistorySnapshots *snapshots);
+
+/* Records the checkpoint of ply if ply is the next multiple of HISTORY_SNAPSHOT_INTERVAL; returns false only if memory ran out */
+bool RecordSnapshot(HistorySnapshots *snapshots, size_t ply, const Position *position, int deadWhite, int deadBlack);
+
+/* Forgets the checkpoints after ply (the line changed there) */
+void TruncateSnapshots(HistorySnapshots *snapshots, size_t ply);
+
+/* Latest checkpoint at or before ply (its ply is written to *snapshotPly), or NULL if there is none */
+const HistorySnapshot *NearestSnapshot(const HistorySnapshots *snapshots, size_t ply, size_t *snapshotPly);
+
+#endif /* HISTORY_H */
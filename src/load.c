@@ -2,328 +2,89 @@
  * load.c
  *
  * Responsibilities:
- * - Parse a FEN (Forsyth–Edwards Notation) piece placement string and populate
- *   the global GameBoard with the corresponding pieces using LoadPiece().
- * - Interpret digits as empty squares, '/' as rank separators, and letters as
- *   piece identifiers (uppercase = white, lowercase = black).
+ * - Load a FEN (Forsyth–Edwards Notation) record into the game: parse it into a Position
+ *   (core PositionFromFENSpan) and populate the GameBoard and GameState from it.
  *
  * Conventions / Notes:
- * - This parser treats the first FEN rank as rank 0 (top of the board). If the
- *   project's board origin differs (row 0 at bottom), adjust the rank mapping.
- * - Only piece placement is parsed; other FEN fields (active color, castling,
- *   en passant, halfmove/fullmove) are ignored by this function.
- * - Out-of-range files/ranks are clamped/ignored to avoid writes outside GameBoard.
+ * - Parsing and population are separate steps: ReadFEN with testInputStringOnly only
+ *   parses, LoadPosition only populates, so a record is fully validated before the game
+ *   is touched. Neither step copies the input or loads any resource (cells hold no
+ *   textures), so both also run headless.
+ * - The first FEN rank is row 0 (top of the board), like everywhere else in the project.
  */
 
-#include "draw.h"
+#define NO_GLOBAL_GAME_STATE
+
+#include "load.h"
 #include "hash.h"
 #include "main.h"
-#include "settings.h"
-#include <ctype.h>
+#include "move.h"
+#include "position.h"
 #include <stdbool.h>
 #include <stddef.h>
-
-#include <stdio.h>
-
-static void ZeroRights(void);
-static bool charInSequence(unsigned char chr);
+#include <string.h>
 
 /**
  * ReadFEN
  *
- * Parse the piece-placement portion of a FEN string and place pieces on GameBoard.
+ * Parse a FEN record and optionally load it into the game.
  *
  * Parameters:
- *  - FENstring : pointer to a NUL-terminated or length-limited FEN substring.
+ *  - FENstring : pointer to a NUL-terminated or length-limited FEN record.
  *  - size      : maximum number of characters to read from FENstring.
  *  - testInputStringOnly: if true, validates the FEN string without modifying game state.
  *
- * Behavior:
- *  - Reads up to 'size' characters or until a NUL terminator is encountered.
- *  - Interprets digits '1'..'8' as that many consecutive empty squares (files).
- *  - '/' advances to the next rank (increments internal rank counter).
- *  - Letters map to piece types: p, r, n, b, q, k (case-insensitive). Uppercase
- *    letters are treated as TEAM_WHITE, lowercase as TEAM_BLACK.
- *  - Calls LoadPiece(row, col, PieceType, Team) for each piece placed.
+ * Returns:
+ *  - true if the record is a valid FEN (see PositionFromFEN; the move counters may be
+ *    omitted), false otherwise. Nothing is changed on failure.
  *
- * Safety:
- *  - If computed file index exceeds 8 it is clamped to 8 and parsing continues.
- *  - If computed row/col are outside [0,7], the character is skipped and parsing
- *    continues without writing to GameBoard.
+ * Behavior:
+ *  - Reads up to 'size' characters or until a NUL terminator is encountered, in place.
+ *  - On success, unless testing only, loads the position with LoadPosition.
  */
-bool ReadFEN(const char *FENstring, size_t size, bool testInputStringOnly) // It returns true if this a valid or semi-valid FEN-string false otherwise
+bool ReadFEN(GameState *game, const char *FENstring, size_t size, bool testInputStringOnly)
 {
-    int row;
-    int col;
-    int rank = 0; /* 0 = top rank (FEN first rank). Use 7 and decrement if your row0 is bottom */
-    int file = 0; /* 0 = a-file (left) */
-
-    size_t i;
-
-    // --- 1. PIECE PLACEMENT ---
-    for (i = 0; i < size && FENstring[i] != '\0' && FENstring[i] != ' '; i++)
-    {
-        unsigned char chr = FENstring[i];
-
-        if (chr == '/')
-        {
-            rank++;
-            file = 0;
-            if (rank >= BOARD_SIZE)
-            {
-                break;
-            }
-            continue;
-        }
-
-        if (isdigit((unsigned char)chr))
-        {
-            file += chr - '0';
-            if (file > BOARD_SIZE)
-            {
-                file = BOARD_SIZE;
-            }
-            continue;
-        }
-
-        if (!isalpha((unsigned char)chr))
-        {
-            return false;
-        }
-
-        Team color = islower(chr) ? TEAM_BLACK : TEAM_WHITE;
-        unsigned char piece = tolower(chr);
-
-        row = rank;
-        col = file;
-
-        if (row < 0 || row >= BOARD_SIZE || col < 0 || col >= BOARD_SIZE)
-        {
-            file++;
-            continue;
-        }
-
-        // ONLY Load pieces if we are NOT just testing
-        if (!testInputStringOnly)
-        {
-            switch (piece)
-            {
-            case 'r':
-                LoadPiece(row, col, PIECE_ROOK, color, GAME_BOARD);
-                break;
-            case 'n':
-                LoadPiece(row, col, PIECE_KNIGHT, color, GAME_BOARD);
-                break;
-            case 'b':
-                LoadPiece(row, col, PIECE_BISHOP, color, GAME_BOARD);
-                break;
-            case 'q':
-                LoadPiece(row, col, PIECE_QUEEN, color, GAME_BOARD);
-                break;
-            case 'k':
-                LoadPiece(row, col, PIECE_KING, color, GAME_BOARD);
-                break;
-            case 'p':
-                LoadPiece(row, col, PIECE_PAWN, color, GAME_BOARD);
-                break;
-            default:
-                break;
-            }
-        }
-        file++;
-    }
-
-    // --- 2. ACTIVE COLOR ---
-
-    // Safe whitespace skip
-    while (i < size && FENstring[i] != '\0' && isblank((unsigned char)FENstring[i]))
-    {
-        i++;
-    }
-    if (i >= size || FENstring[i] == '\0')
-    {
-        return false;
-    }
+    Position position;
 
-    unsigned char chr = tolower((unsigned char)FENstring[i++]);
-    if (chr != 'w' && chr != 'b')
+    if (FENstring == NULL)
     {
         return false;
     }
 
-    if (!testInputStringOnly)
-    {
-        state.turn = (chr == 'w') ? TEAM_WHITE : TEAM_BLACK;
-    }
-
-    // Read the CastlingRights
-
-    // FIX: Safe loop that doesn't overrun buffer or swallow the first char
-    while (i < size && isblank((unsigned char)FENstring[i]))
-    {
-        i++;
-    }
-    if (i >= size)
-    {
-        return false;
-    }
-    chr = (unsigned char)FENstring[i++];
+    const char *terminator = memchr(FENstring, '\0', size);
+    size_t length = (terminator != NULL) ? (size_t)(terminator - FENstring) : size;
 
-    if (chr != '-' && tolower(chr) != 'k' && tolower(chr) != 'q')
+    if (!PositionFromFENSpan(&position, FENstring, length))
     {
         return false;
     }
 
     if (!testInputStringOnly)
     {
-        ZeroRights();
-    }
-
-    if (chr == '-')
-    {
-        ; // Just leave it that way it's good enough
-    }
-    else
-    {
-        do
-        {
-            if (!testInputStringOnly) // <--- Added check
-            {
-                switch (chr)
-                {
-                case 'K':
-                    state.whiteKingSide = true;
-                    break;
-                case 'k':
-                    state.blackKingSide = true;
-                    break;
-                case 'Q':
-                    state.whiteQueenSide = true;
-                    break;
-                case 'q':
-                    state.blackQueenSide = true;
-                    break;
-                default:
-                    break;
-                }
-            }
-
-            // Check bounds and stop IF next char is space (don't consume the space yet)
-            if (i >= size || FENstring[i] == '\0' || isblank((unsigned char)FENstring[i]))
-            {
-                break;
-            }
-
-            chr = (unsigned char)FENstring[i++];
-
-        } while (true);
-    }
-
-    // FIX: Safe loop for En Passant
-    while (i < size && isblank((unsigned char)FENstring[i]))
-    {
-        i++;
-    }
-    if (i >= size)
-    {
-        return false;
-    }
-
-    chr = (unsigned char)FENstring[i++];
-
-    if (!charInSequence(chr))
-    {
-        return false;
-    }
-
-    if (chr == '-')
-    {
-        if (!testInputStringOnly)
-        {
-            state.enPassantCol = -1;
-        }
-    }
-    else
-    {
-        int num = tolower(chr) - 'a';
-        if (!testInputStringOnly)
-        {
-            state.enPassantCol = num;
-        }
-
-        if (i >= size)
-        {
-            return false;
-        }
-
-        chr = (unsigned char)FENstring[i++];
-        num = chr - '0';
-
-        if (num < 1 || num > BOARD_SIZE)
-        {
-            return false;
-        }
-    }
-
-    // FIX: Use local variables so we don't corrupt state during validation
-    int halfMove = 0;
-    int fullMove = 1;
-
-    if (sscanf(FENstring + i, "%d %d", &halfMove, &fullMove) != 2)
-    {
-        return false;
-    }
-
-    if (!testInputStringOnly) // <--- Added check
-    {
-        state.halfMoveClock = halfMove;
-        state.fullMoveNumber = fullMove;
-    }
-
-    if (!testInputStringOnly)
-    {
-        if (state.DHA != NULL)
-        {
-            ClearDHA(state.DHA);
-        }
-
-        // Push the starting position
-        PushDHA(state.DHA, CurrentGameStateHash());
+        LoadPosition(game, &position);
     }
     return true;
 }
 
 /**
- * ZeroRights (static)
+ * LoadPosition
  *
- * Resets all castling rights flags in the global state to false.
- */
-static void ZeroRights(void)
-{
-    state.whiteKingSide = false;
-    state.whiteQueenSide = false;
-    state.blackKingSide = false;
-    state.blackQueenSide = false;
-}
-
-/**
- * charInSequence (static)
- *
- * Helper to validate if a character is a valid en passant target file or '-'.
- *
- * Parameters:
- *  - chr: The character to check.
+ * Population step of loading a game: write position into the GameState and the board
+ * cells and restart the repetition history from it.
  *
- * Returns:
- *  - true if chr is '-' or 'a'-'h' (case-insensitive).
+ * Notes:
+ *  - Does not reset the history stacks, dead pieces or flags; LoadGameFromFEN (utils.c)
+ *    does that around it.
  */
-static bool charInSequence(unsigned char chr)
+void LoadPosition(GameState *game, const Position *position)
 {
-    // '-' or file letter a-h/A-H
-    if (chr == '-')
+    SetCurrentPosition(game, position);
+
+    if (game->DHA != NULL)
     {
-        return true;
+        ClearDHA(game->DHA);
+
+        // Push the starting position
+        PushDHA(game->DHA, game->zobristKey);
     }
-    unsigned char lower = tolower(chr);
-    return (lower >= 'a' && lower <= 'h');
 }
@@ -2,16 +2,23 @@
  * load.h
  *
  * Responsibilities:
- * - Export the FEN parsing functionality.
+ * - Export the FEN loading functionality: parse-only validation and the board
+ *   population step.
  */
 
 #ifndef LOAD_H
 #define LOAD_H
 
+#include "position.h"
 #include <stdbool.h>
 #include <stddef.h>
 
-/* Parses a FEN string and optionally loads the game state */
-bool ReadFEN(const char *FENstring, size_t size, bool testInputStringOnly);
+typedef struct GameState GameState;
 
-#endif /* LOAD_H */
\ No newline at end of file
+/* Parses a FEN string in place and optionally loads the game state */
+bool ReadFEN(GameState *game, const char *FENstring, size_t size, bool testInputStringOnly);
+
+/* Writes a parsed position into the game (board cells, state, repetition history) */
+void LoadPosition(GameState *game, const Position *position);
+
+#endif /* LOAD_H */
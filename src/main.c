@@ -16,15 +16,19 @@
 #define MAIN_C
 #define RAYGUI_IMPLEMENTATION
 
-#ifdef DEBUG
-#include <stdio.h>
-#endif
+#include "analysis.h"
+#include "assets.h"
+#include "atlas.h"
+#include "chesscore.h"
 #include "colors.h"
 #include "draw.h"
 #include "hash.h"
+#include "history.h"
 #include "load.h"
 #include "main.h"
 #include "move.h"
+#include "opponent.h"
+#include "profile.h"
 
 // --- IGNORE RAYGUI WARNINGS ---
 #pragma GCC diagnostic push
@@ -44,12 +48,14 @@
 
 #include "raylib.h"
 #include "save.h"
+#include "saves.h"
 #include "settings.h"
 #include "stack.h"
 #include "utils.h"
 #include <setjmp.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -62,9 +68,17 @@ static char saveFileName[MAX_FILE_NAME_LENGTH] = {0};
 static bool showLoadFileDialog = false;
 static int loadFileScrollIndex = 0;
 static int loadFileActiveIndex = -1;
-// TODO add infinite string buffer
-static char loadFileListBuffer[MAX_LOAD_FILES_TOTAL_LENGTH] = {0}; // Buffer to hold "file1.fen;file2.fen;..."
-static FilePathList loadFilePaths = {0};                           // Raylib struct to hold directory info
+static double savesRefreshTime = 0;                        // when the open popup last asked for a scan of saves/
+static char savesSelectedName[MAX_FILE_NAME_LENGTH] = {0}; // selected save, kept by name while the index changes
+
+// Game database browsing in the Load popup (0 = saves, 1 = games reaching the current position)
+static GameDatabase gameDatabase = {0};
+static bool gameDatabaseOpen = false;
+static int loadSourceIndex = 0;
+static GameDbHit databaseHits[MAX_LISTED_DATABASE_GAMES];
+static size_t databaseHitCount = 0;
+static char databaseListBuffer[MAX_LISTED_DATABASE_GAMES * DATABASE_LIST_ROW_LENGTH] = {0};
+static PgnGame databaseGame; // Too large for the stack
 
 // NEW: Local state for FEN Input UI
 static bool showFenInputPopup = false;
@@ -82,6 +96,11 @@ static bool themeEditMode = false;
 static jmp_buf exit_env;
 
 void HandleGui(void);
+static void QueueGameSave(void);
+static void DrawSavesList(Rectangle bounds);
+static void FillDatabaseList(void);
+static bool IsIdleFrame(void);
+static double MillisecondsSince(double start);
 
 // State initialization
 GameState state;
@@ -92,16 +111,29 @@ GameState state;
  * The application entry point.
  *
  * Workflow:
- * 1. Sets up Raylib window, audio, and GUI styles.
- * 2. Initializes game subsystems (Board, DeadPieces, Hash, Stacks).
- * 3. Loads the initial game state (FEN).
- * 4. Enters the main loop:
+ * 1. Sets up Raylib window and GUI styles, maps the asset pack (decoded icon, piece atlas
+ *    and sounds; the asset files are decoded instead without it) and starts the thread
+ *    that opens the audio device and loads the sound effects.
+ * 2. Initializes game subsystems and the GUI's game `state` (InitializeGame: board,
+ *    dead pieces, repetition history, stacks, start position).
+ * 3. Enters the main loop:
+ *    - Hands the sound effects to the game once their thread is done (the first frames
+ *      are drawn without waiting for audio).
  *    - Polls keyboard input (shortcuts).
  *    - Draws the board and UI.
- * 5. Handles clean exit via setjmp/longjmp pattern to ensure resources are freed.
+ * 4. Handles clean exit via setjmp/longjmp pattern to ensure resources are freed.
+ *
+ * Options:
+ *  - --startup-bench: print the time to the first frame and to loaded sounds, then exit
+ *    (make run-startup-bench runs it several times).
  */
-int main(void)
+int main(int argc, char **argv)
 {
+    double startupStart = MonotonicSeconds();
+    bool startupBench = argc > 1 && strcmp(argv[1], "--startup-bench") == 0;
+    volatile double firstFrameMs = 0; // volatile: set inside the setjmp block below
+    volatile double soundsReadyMs = 0;
+
     // Initialize the game window
     SetConfigFlags(FLAG_WINDOW_RESIZABLE);
 #ifdef DEBUG
@@ -116,30 +148,54 @@ int main(void)
     SetExitKey(KEY_NULL);
 
     SetWindowMinSize(MIN_SCREEN_WIDTH, MIN_SCREEN_WIDTH);
-    Image icon = LoadImage("assets/icon.png");
-    SetWindowIcon(icon);
     SetTargetFPS(FPS);
-    InitAudioDevice();
+
+    // Decoded assets are mapped, not decoded; audio comes up on its own thread meanwhile
+    OpenAssetPack(ASSET_PACK_PATH);
+    StartLoadingSounds();
+
+    Image icon = LoadAssetImage("assets/icon.png");
+    SetWindowIcon(icon);
+    UnloadAssetImage(icon);
+
+    // Load every piece sprite once (all pieces are drawn from this single texture)
+    LoadPieceAtlas();
 
     // Initialize the Game
-    InitializeBoard();
-    InitializeDeadPieces();
+    InitChessCore();
+    int tablebases = SetTablebasePath(TABLEBASE_PATH);
+    if (tablebases > 0)
+    {
+        TraceLog(LOG_INFO, "Tablebases: %d Syzygy tables, up to %d pieces (%s)", tablebases, TablebaseMaxPieces(), TABLEBASE_PATH);
+    }
+    InitializeOpponent();
+    InitializeAnalysis();
+    if (!InitializeGame(&state))
+    {
+        TraceLog(LOG_ERROR, "Cannot allocate the game");
+        FreeAnalysis();
+        FreeOpponent();
+        UnloadPieceAtlas();
+        FinishLoadingSounds(&state.sounds);
+        CloseAudioDevice();
+        CloseAssetPack();
+        CloseWindow();
+        return 1;
+    }
+    state.isOnScreen = true; // the game the GUI shows (sounds, highlights, analysis)
 
-    state.DHA = InitializeDHA(INITIAL_DYNAMIC_HASH_ARRAY_SIZE);
-    state.undoStack = InitializeStack(INITAL_UNDO_REDO_STACK_SIZE);
-    state.redoStack = InitializeStack(INITAL_UNDO_REDO_STACK_SIZE);
+    // Lists and parses saves/ on the I/O thread while the first frames are drawn
+    InitializeSaves();
 
     bool showDebugMenu = false;
     bool showFileRank = true;
 
-    // sound effects
-    // CHANGED: Load sounds into state
-    state.sounds.capture = LoadSound("assets/sound/Capture.mp3");
-    state.sounds.check = LoadSound("assets/sound/Check.mp3");
-    state.sounds.checkMate = LoadSound("assets/sound/Checkmate.mp3");
-    state.sounds.move = LoadSound("assets/sound/Move.mp3");
-
-    LoadGameFromFEN(STARTING_FEN);
+    // Mapping costs the same for any database size; pages are read when a query needs them
+    gameDatabaseOpen = OpenGameDatabase(&gameDatabase, GAME_DATABASE_PATH);
+    if (gameDatabaseOpen)
+    {
+        TraceLog(LOG_INFO, "Game database: %u games (%s)", gameDatabase.gameCount, GAME_DATABASE_PATH);
+    }
 
 #ifdef DEBUG
     for (int i = 0; i < BOARD_SIZE; i++)
@@ -164,6 +220,15 @@ int main(void)
     {
         while (!WindowShouldClose())
         {
+            PROFILE_BEGIN(frame);
+
+            // Sound effects of the game, once the loader thread has them
+            if (CollectSounds(&state.sounds))
+            {
+                soundsReadyMs = MillisecondsSince(startupStart);
+                TraceLog(LOG_INFO, "Startup: sounds ready after %.1f ms", soundsReadyMs);
+            }
+
             // Keyboard responses
 
             if (IsKeyPressed(KEY_F5))
@@ -171,15 +236,31 @@ int main(void)
                 showDebugMenu = !showDebugMenu;
             }
 
+#ifdef PROFILE
+            // Per-frame profiler samples to PROFILE_CSV_PATH
+            if (IsKeyPressed(KEY_F6))
+            {
+                ToggleProfileCsv();
+            }
+#endif
+
             if (IsKeyDown(KEY_LEFT_CONTROL))
             {
                 if (IsKeyDown(KEY_LEFT_SHIFT) && IsKeyPressed(KEY_Z))
                 {
-                    RedoMove();
+                    RedoPlayerMove();
                 }
                 else if (IsKeyPressed(KEY_Z))
                 {
-                    UndoMove();
+                    UndoPlayerMove();
+                }
+                else if (IsKeyPressed(KEY_E))
+                {
+                    ToggleEngineOpponent();
+                }
+                else if (IsKeyPressed(KEY_A))
+                {
+                    ToggleAnalysis();
                 }
                 else if (IsKeyPressed(KEY_S))
                 {
@@ -191,11 +272,10 @@ int main(void)
                 }
                 else if (IsKeyPressed(KEY_C))
                 {
-                    unsigned char *currentFen = SaveFEN();
-                    if (currentFen)
+                    char currentFen[MAX_POSITION_FEN_LENGTH];
+                    if (SaveFENInto(&state, currentFen, sizeof currentFen))
                     {
-                        SetClipboardText((const char *)currentFen);
-                        free(currentFen);
+                        SetClipboardText(currentFen);
                     }
                 }
                 else if (IsKeyPressed(KEY_R))
@@ -204,10 +284,14 @@ int main(void)
                 }
             }
 
+            // Index of saves/ from the I/O thread (the Load popup reads it)
+            UpdateSaves();
+
             BeginDrawing();
 
             // CHANGED: Use the style's background color instead of custom BACKGROUND
-            ClearBackground(GetColor(GuiGetStyle(DEFAULT, BACKGROUND_COLOR)));
+            Color background = GetColor(GuiGetStyle(DEFAULT, BACKGROUND_COLOR));
+            ClearBackground(background);
 
             // CHANGED: Use the selected theme from the spinner
             // We cast the int index to ColorTheme enum
@@ -215,8 +299,9 @@ int main(void)
             {
                 currentThemeIndex = THEME_COUNT - 1;
             }
-            DrawBoard((ColorTheme)currentThemeIndex, showFileRank);
+            DrawBoard((ColorTheme)currentThemeIndex, showFileRank, background);
             HighlightHover((ColorTheme)currentThemeIndex);
+            DrawAnalysisHints();
 
             // --- REPLACED OLD UI BLOCK WITH THIS ---
             DrawGameStatus();
@@ -230,28 +315,71 @@ int main(void)
                 DrawDebugInfo();
             }
 
+            // Starts the engine's search on its thread or plays its finished move
+            // (the frame is already drawn: a move played here shows in the next one)
+            UpdateEngineOpponent();
+
+            // Restarts the background analysis when the position on the board changed
+            UpdateAnalysis();
+
+            // Nothing will change before the next input event: let EndDrawing sleep until one
+            // arrives instead of redrawing the same frame FPS times a second
+            if (IsIdleFrame())
+            {
+                EnableEventWaiting();
+            }
+            else
+            {
+                DisableEventWaiting();
+            }
+
+            PROFILE_END(frame, PROFILE_FRAME);
+            PROFILE_BEGIN(present);
             EndDrawing();
+            PROFILE_END(present, PROFILE_PRESENT);
+
+            if (firstFrameMs == 0)
+            {
+                firstFrameMs = MillisecondsSince(startupStart);
+                TraceLog(LOG_INFO, "Startup: first frame after %.1f ms", firstFrameMs);
+            }
+            PROFILE_END_FRAME();
+
+            if (startupBench && !AreSoundsLoading())
+            {
+                printf("startup: first frame %.1f ms, sounds ready %.1f ms\n", firstFrameMs, soundsReadyMs);
+                break;
+            }
         }
 
         // Deinitialize and Free Memory
 
-        UnloadBoard();
+        FreeGame(&state);
+        UnloadBoardLayer();
 
-        FreeDHA(state.DHA);
+        // Waits for saves still being written
+        FreeSaves();
 
-        FreeStack(state.undoStack);
-        FreeStack(state.redoStack);
+        FreeOpponent();
+        FreeAnalysis();
 
-        UnloadDeadPieces();
+#ifdef PROFILE
+        CloseProfile();
+#endif
 
-        UnloadImage(icon);
+        CloseGameDatabase(&gameDatabase);
 
+        // Sounds still loading are waited for, so they can be released
+        FinishLoadingSounds(&state.sounds);
         UnloadSound(state.sounds.capture);
         UnloadSound(state.sounds.check);
         UnloadSound(state.sounds.checkMate);
         UnloadSound(state.sounds.move);
 
+        UnloadPieceAtlas();
+
         CloseAudioDevice();
+        CloseAssetPack();
 
         CloseWindow();
 
@@ -267,7 +395,8 @@ int main(void)
  * Responsibilities:
  * - Checks for Game Over conditions and draws the end-game modal.
  * - Handles the ESC key for closing popups or triggering exit confirmation.
- * - Draws the top toolbar buttons (Restart, Save, Load, FEN, Theme, Undo, Redo, Copy).
+ * - Draws the top toolbar buttons (Restart, Save, Load, FEN, Theme, Undo, Redo, Copy)
+ *   and, once moves have been played, the history scrubber.
  * - Manages state and rendering for all modal popups:
  *   - Save Game (Text Input)
  *   - Overwrite Confirmation
@@ -278,11 +407,7 @@ int main(void)
 void HandleGui(void)
 {
     // --- CHECK FOR GAME OVER ---
-    bool isGameOver = state.isCheckmate ||
-                      state.isStalemate ||
-                      state.isRepeated3times ||
-                      state.isInsufficientMaterial ||
-                      (state.halfMoveClock >= 100);
+    bool isGameOver = IsGameOver(&state);
 
     if (isGameOver)
     {
@@ -343,7 +468,7 @@ void HandleGui(void)
         // New Game Button
         if (GuiButton((Rectangle){winRect.x + 20, winRect.y + winRect.height - 50, 120, 30}, "New Game"))
         {
-            RestartGame();
+            RestartGame(&state);
             // RestartGame resets flags, so isGameOver becomes false next frame
         }
 
@@ -403,7 +528,7 @@ void HandleGui(void)
     // --- BUTTON 0: RESTART ---
     if (GuiButton(GetTopButtonRect(0), GuiIconText(ICON_RESTART, "Restart")))
     {
-        RestartGame();
+        RestartGame(&state);
     }
 
     // --- BUTTON 1: SAVE GAME ---
@@ -422,49 +547,14 @@ void HandleGui(void)
         state.isInputLocked = true;
         loadFileActiveIndex = -1;
         loadFileScrollIndex = 0;
+        savesSelectedName[0] = '\0';
 
-        // 1. Ensure "saves/" directory exists
-        if (!DirectoryExists("saves"))
-        {
-            MakeDirectory("saves");
-        }
+        // The list comes from the saves index; the I/O thread checks saves/ for changes
+        RefreshSaves();
+        savesRefreshTime = GetTime();
 
-        // 2. Load files from "saves/" directory
-        if (DirectoryExists("saves"))
-        {
-            // Reload the folder
-            if (loadFilePaths.count > 0)
-            {
-                UnloadDirectoryFiles(loadFilePaths);
-            }
-            loadFilePaths = LoadDirectoryFiles("saves");
-
-            // 3. Format string for GuiListView (items separated by semicolons)
-            // e.g., "game1.fen;game2.fen;cool_save.fen"
-            memset(loadFileListBuffer, 0, sizeof(loadFileListBuffer));
-
-            for (size_t i = 0; i < loadFilePaths.count; i++)
-            {
-                // Only show .fen files
-                if (IsFileExtension(loadFilePaths.paths[i], ".fen"))
-                {
-                    const char *fileName = GetFileName(loadFilePaths.paths[i]);
-                    strcat(loadFileListBuffer, fileName);
-
-                    /* Add a semicolon separator between file names for GuiListView
-                       (GuiListView expects items separated by ';'), but avoid adding
-                       a trailing semicolon after the last item. */
-                    if (i < loadFilePaths.count - 1)
-                    {
-                        strcat(loadFileListBuffer, ";");
-                    }
-                }
-            }
-        }
-        else
-        {
-            TextCopy(loadFileListBuffer, "No saves directory found");
-        }
+        // Games of the database that reach the position on the board
+        FillDatabaseList();
     }
 
     // --- BUTTON 3: PASTE FEN ---
@@ -485,23 +575,38 @@ void HandleGui(void)
     // We check if the stack has items to visually indicate availability (optional logic)
     if (GuiButton(GetTopButtonRect(5), GuiIconText(ICON_UNDO, NULL)))
     {
-        UndoMove();
+        UndoPlayerMove();
     }
 
     // --- BUTTON 6: REDO MOVE ---
     if (GuiButton(GetTopButtonRect(6), GuiIconText(ICON_REDO, NULL)))
     {
-        RedoMove();
+        RedoPlayerMove();
+    }
+
+    // --- HISTORY SCRUBBER: any ply of the game in one jump ---
+    size_t gameLength = GameLength(&state);
+    if (gameLength > 0)
+    {
+        size_t currentPly = StackSize(state.undoStack);
+        float scrubberPly = (float)currentPly;
+
+        GuiSlider(GetHistoryScrubberRect(), NULL, TextFormat("%zu/%zu", currentPly, gameLength), &scrubberPly, 0.0F, (float)gameLength);
+
+        size_t targetPly = (size_t)(scrubberPly + 0.5F);
+        if (targetPly != currentPly)
+        {
+            JumpPlayerToPly(targetPly);
+        }
     }
 
     // --- BUTTON 7: COPY FEN TO CLIPBOARD ---
     if (GuiButton(GetTopButtonRect(7), GuiIconText(ICON_FILE_COPY, "Copy")))
     {
-        unsigned char *currentFen = SaveFEN();
-        if (currentFen)
+        char currentFen[MAX_POSITION_FEN_LENGTH];
+        if (SaveFENInto(&state, currentFen, sizeof currentFen))
         {
-            SetClipboardText((const char *)currentFen);
-            free(currentFen);
+            SetClipboardText(currentFen);
         }
     }
 
@@ -529,17 +634,8 @@ void HandleGui(void)
 
         if (result == 1) // Save clicked
         {
-            // NEW: Ensure "saves/" directory exists before checking/writing
-            if (!DirectoryExists("saves"))
-            {
-                MakeDirectory("saves");
-            }
-
-            // Check if file exists
-            char fullPath[MAX_FILE_NAME_LENGTH + 11 /*for the saves part of the of the path*/];
-            TextCopy(fullPath, TextFormat("saves/%s.fen", saveFileName));
-
-            if (FileExists(fullPath))
+            // Check if file exists (the saves index knows without asking the disk)
+            if (FindSave(saveFileName) != NULL)
             {
                 // File exists, switch to overwrite dialog
                 showSaveTextInput = false;
@@ -547,10 +643,8 @@ void HandleGui(void)
             }
             else
             {
-                // File doesn't exist, save immediately
-                unsigned char *fenString = SaveFEN();
-                SaveFileText(fullPath, (char *)fenString);
-                free(fenString);
+                // File doesn't exist, save immediately (written on the I/O thread)
+                QueueGameSave();
 
                 showSaveTextInput = false;
                 state.isInputLocked = false; // Unfreeze
@@ -582,12 +676,7 @@ void HandleGui(void)
 
         if (result == 1) // Yes
         {
-            char fullPath[MAX_FILE_NAME_LENGTH + 11];
-            TextCopy(fullPath, TextFormat("saves/%s.fen", saveFileName));
-
-            unsigned char *fenString = SaveFEN();
-            SaveFileText(fullPath, (char *)fenString);
-            free(fenString);
+            QueueGameSave();
 
             showOverwriteDialog = false;
             state.isInputLocked = false; // Unfreeze
@@ -620,37 +709,79 @@ void HandleGui(void)
             state.isInputLocked = false;
         }
 
-        // File List View
+        // Saves / Database switch (only when a database is open)
         Rectangle listRect = {winRect.x + 10, winRect.y + 30, winRect.width - 20, winRect.height - 80};
-        GuiListView(listRect, loadFileListBuffer, &loadFileScrollIndex, &loadFileActiveIndex);
+        if (gameDatabaseOpen)
+        {
+            int previousSource = loadSourceIndex;
+            GuiToggleGroup((Rectangle){winRect.x + 10, winRect.y + 30, (winRect.width - 22) / 2, 24}, "Saves;Database", &loadSourceIndex);
+            if (loadSourceIndex != previousSource)
+            {
+                loadFileActiveIndex = -1;
+                loadFileScrollIndex = 0;
+                savesSelectedName[0] = '\0';
+            }
+
+            listRect.y += 30;
+            listRect.height -= 30;
+        }
+        else
+        {
+            loadSourceIndex = 0;
+        }
+
+        // Saves list (only the visible rows are drawn), or the database games
+        if (loadSourceIndex == 1)
+        {
+            GuiListView(listRect, databaseListBuffer, &loadFileScrollIndex, &loadFileActiveIndex);
+        }
+        else
+        {
+            // Files added or edited outside the game show up while the popup is open
+            if (GetTime() - savesRefreshTime >= SAVES_REFRESH_SECONDS)
+            {
+                RefreshSaves();
+                savesRefreshTime = GetTime();
+            }
+            DrawSavesList(listRect);
+        }
 
         // Load Button
         if (GuiButton((Rectangle){winRect.x + 10, winRect.y + winRect.height - 40, 80, 30}, GuiIconText(ICON_FILE_OPEN, "Load")))
         {
-            if (loadFileActiveIndex >= 0 && loadFileActiveIndex < (int)loadFilePaths.count)
+            if (loadSourceIndex == 1)
             {
-                // 1. Construct full path
-                // Note: GuiListView index matches the filtered list.
-                // For simplicity here assuming all files in folder are .fen or list matches index.
-                // A safer way is to rebuild the path from the selected text, but using the array is faster.
-                const char *selectedPath = loadFilePaths.paths[loadFileActiveIndex];
-
-                if (FileExists(selectedPath))
+                // The game is loaded at the position on the board: Undo and Redo walk through the rest of it
+                if (loadFileActiveIndex >= 0 && loadFileActiveIndex < (int)databaseHitCount)
                 {
-                    // 2. Read FEN from file
-                    char *loadedFen = LoadFileText(selectedPath);
+                    GameDbHit hit = databaseHits[loadFileActiveIndex];
 
-                    if (loadedFen != NULL)
+                    if (ReadDatabaseGame(&gameDatabase, hit.game, &databaseGame))
                     {
-                        // 3. Reset & Load using the shared helper
-                        LoadGameFromFEN(loadedFen);
+                        LoadGameFromHistory(&state, &databaseGame.start, databaseGame.moves, databaseGame.plyCount, (int)hit.ply);
 
-                        UnloadFileText(loadedFen);
-
-                        // Close Popup
                         showLoadFileDialog = false;
                         state.isInputLocked = false;
                     }
+                    else
+                    {
+                        TraceLog(LOG_WARNING, "Game database: game %u is damaged", hit.game);
+                    }
+                }
+            }
+            else
+            {
+                size_t saveCount;
+                const SaveEntry *saves = SaveEntries(&saveCount);
+
+                // The FEN was read and checked when saves/ was scanned: nothing to read now
+                if (loadFileActiveIndex >= 0 && loadFileActiveIndex < (int)saveCount && saves[loadFileActiveIndex].valid)
+                {
+                    LoadGameFromFEN(&state, saves[loadFileActiveIndex].fen);
+
+                    // Close Popup
+                    showLoadFileDialog = false;
+                    state.isInputLocked = false;
                 }
             }
         }
@@ -686,10 +817,10 @@ void HandleGui(void)
         if (result == 1) // Load clicked
         {
             // Validate using ReadFEN with 'true' as the last argument
-            if (ReadFEN(fenInputBuffer, strlen(fenInputBuffer), true))
+            if (ReadFEN(&state, fenInputBuffer, strlen(fenInputBuffer), true))
             {
                 // Valid FEN: Load it properly using the helper
-                LoadGameFromFEN(fenInputBuffer);
+                LoadGameFromFEN(&state, fenInputBuffer);
 
                 showFenInputPopup = false;
                 state.isInputLocked = false;
@@ -758,3 +889,239 @@ void HandleGui(void)
         }
     }
 }
+
+/**
+ * QueueGameSave (static)
+ *
+ * Hands the game on the board to the saves I/O thread as saves/<saveFileName>.fen and,
+ * with the move history, saves/<saveFileName>.pgn. Only the records are built here; the
+ * files are written off the render thread.
+ */
+static void QueueGameSave(void)
+{
+    char fenString[MAX_POSITION_FEN_LENGTH];
+    if (!SaveFENInto(&state, fenString, sizeof fenString))
+    {
+        return;
+    }
+
+    // The move history goes next to it as PGN (about 33 KB, freed by the I/O thread)
+    PgnGame *pgn = malloc(sizeof(PgnGame));
+    if (pgn != NULL && !BuildPGN(&state, pgn))
+    {
+        free(pgn);
+        pgn = NULL;
+    }
+
+    QueueSave(saveFileName, fenString, pgn);
+}
+
+/**
+ * DrawSavesList (static)
+ *
+ * The saves of the Load popup: one row per save with a board preview, the name, the side
+ * to move and the move number.
+ *
+ * Behavior:
+ *  - Only the rows in view are drawn, so a frame costs the same for ten saves or ten
+ *    thousand. loadFileScrollIndex is the first row shown: the mouse wheel and the scroll
+ *    bar move it.
+ *  - A click selects a row (loadFileActiveIndex). The selection follows the save by name
+ *    when a scan adds or removes files above it.
+ *  - Files that do not hold a FEN are listed but cannot be loaded.
+ */
+static void DrawSavesList(Rectangle bounds)
+{
+    size_t count;
+    const SaveEntry *saves = SaveEntries(&count);
+    int rows = (int)(bounds.height / SAVES_ROW_HEIGHT);
+    int maxScroll = ((int)count > rows) ? (int)count - rows : 0;
+    Vector2 mouse = GetMousePosition();
+    bool hovered = CheckCollisionPointRec(mouse, bounds);
+    int fontSize = GuiGetStyle(DEFAULT, TEXT_SIZE);
+    Color textColor = GetColor(GuiGetStyle(LISTVIEW, TEXT_COLOR_NORMAL));
+
+    if (savesSelectedName[0] != '\0')
+    {
+        const SaveEntry *selected = FindSave(savesSelectedName);
+        loadFileActiveIndex = (selected != NULL) ? (int)(selected - saves) : -1;
+    }
+
+    if (hovered)
+    {
+        loadFileScrollIndex -= (int)GetMouseWheelMove();
+    }
+
+    // Scroll bar: the thumb shows the rows in view; pressing the track jumps there
+    Rectangle track = {bounds.x + bounds.width - SAVES_SCROLLBAR_WIDTH, bounds.y, SAVES_SCROLLBAR_WIDTH, bounds.height};
+    if (maxScroll > 0 && IsMouseButtonDown(MOUSE_BUTTON_LEFT) && CheckCollisionPointRec(mouse, track))
+    {
+        loadFileScrollIndex = (int)(((mouse.y - track.y) / track.height) * (float)count) - (rows / 2);
+    }
+    if (loadFileScrollIndex > maxScroll)
+    {
+        loadFileScrollIndex = maxScroll;
+    }
+    if (loadFileScrollIndex < 0)
+    {
+        loadFileScrollIndex = 0;
+    }
+
+    DrawRectangleRec(bounds, GetColor(GuiGetStyle(DEFAULT, BACKGROUND_COLOR)));
+    DrawRectangleLinesEx(bounds, 1, GetColor(GuiGetStyle(LISTVIEW, BORDER_COLOR_NORMAL)));
+
+    if (count == 0)
+    {
+        DrawTextEx(GuiGetFont(), IsSavesBusy() ? "Reading saves..." : "No saves yet", (Vector2){bounds.x + 10, bounds.y + 10}, (float)fontSize,
+                   (float)GuiGetStyle(DEFAULT, TEXT_SPACING), textColor);
+        return;
+    }
+
+    float rowWidth = bounds.width - 2 - ((maxScroll > 0) ? SAVES_SCROLLBAR_WIDTH : 0);
+    float square = (float)SAVES_THUMBNAIL_SIZE / BOARD_SIZE;
+    ColorPair theme = PALETTE[currentThemeIndex];
+
+    for (int row = 0; row < rows && loadFileScrollIndex + row < (int)count; row++)
+    {
+        int index = loadFileScrollIndex + row;
+        const SaveEntry *save = &saves[index];
+        Rectangle rowRect = {bounds.x + 1, bounds.y + 1 + (float)(row * SAVES_ROW_HEIGHT), rowWidth, SAVES_ROW_HEIGHT};
+        bool rowHovered = hovered && CheckCollisionPointRec(mouse, rowRect);
+
+        if (rowHovered && IsMouseButtonPressed(MOUSE_BUTTON_LEFT))
+        {
+            loadFileActiveIndex = index;
+            TextCopy(savesSelectedName, save->name);
+        }
+
+        bool selected = index == loadFileActiveIndex;
+        if (selected || rowHovered)
+        {
+            DrawRectangleRec(rowRect, GetColor(GuiGetStyle(LISTVIEW, selected ? BASE_COLOR_PRESSED : BASE_COLOR_FOCUSED)));
+        }
+        Color rowText = GetColor(GuiGetStyle(LISTVIEW, selected ? TEXT_COLOR_PRESSED : TEXT_COLOR_NORMAL));
+
+        // Board preview, from the pieces parsed when saves/ was scanned
+        Vector2 origin = {rowRect.x + 4, rowRect.y + ((SAVES_ROW_HEIGHT - SAVES_THUMBNAIL_SIZE) / 2.0F)};
+        for (int i = 0; i < BOARD_SIZE * BOARD_SIZE && save->valid; i++)
+        {
+            Vector2 corner = {origin.x + ((float)SQUARE_COL(i) * square), origin.y + ((float)SQUARE_ROW(i) * square)};
+            DrawRectangleV(corner, (Vector2){square, square}, ((SQUARE_ROW(i) + SQUARE_COL(i)) % 2 == 0) ? theme.white : theme.black);
+            DrawPieceSprite(SAVE_PREVIEW_TYPE(save->preview[i]), SAVE_PREVIEW_TEAM(save->preview[i]), corner, square);
+        }
+
+        float textX = origin.x + SAVES_THUMBNAIL_SIZE + 8;
+        const char *details = save->valid ? TextFormat("%s to move, move %d", (save->side == TEAM_WHITE) ? "White" : "Black", save->fullMoveNumber)
+                                          : "Not a FEN file";
+        DrawTextEx(GuiGetFont(), save->name, (Vector2){textX, rowRect.y + 4}, (float)fontSize, (float)GuiGetStyle(DEFAULT, TEXT_SPACING), rowText);
+        DrawTextEx(GuiGetFont(), details, (Vector2){textX, rowRect.y + 6 + (float)fontSize}, (float)fontSize, (float)GuiGetStyle(DEFAULT, TEXT_SPACING),
+                   Fade(rowText, 0.7F));
+    }
+
+    if (maxScroll > 0)
+    {
+        float thumbHeight = track.height * (float)rows / (float)count;
+        if (thumbHeight < SAVES_SCROLLBAR_WIDTH)
+        {
+            thumbHeight = SAVES_SCROLLBAR_WIDTH;
+        }
+        float thumbY = track.y + ((track.height - thumbHeight) * (float)loadFileScrollIndex / (float)maxScroll);
+
+        DrawRectangleRec(track, GetColor(GuiGetStyle(SCROLLBAR, BASE_COLOR_NORMAL)));
+        DrawRectangleRec((Rectangle){track.x + 2, thumbY, track.width - 4, thumbHeight}, GetColor(GuiGetStyle(SCROLLBAR, BORDER_COLOR_NORMAL)));
+    }
+}
+
+/**
+ * FillDatabaseList (static)
+ *
+ * Query the game database for the position on the board and format the games reaching
+ * it for GuiListView ("White - Black Result", separated by ';').
+ *
+ * Behavior:
+ *  - Lists at most MAX_LISTED_DATABASE_GAMES games (the first by game number); the
+ *    matching hits are kept in databaseHits for the Load button.
+ *  - Tag values are cut to fit a row, and a ';' in them is shown as ','.
+ */
+static void FillDatabaseList(void)
+{
+    databaseHitCount = 0;
+    databaseListBuffer[0] = '\0';
+
+    if (!gameDatabaseOpen)
+    {
+        return;
+    }
+
+    size_t total = FindPositionGames(&gameDatabase, state.zobristKey, databaseHits, MAX_LISTED_DATABASE_GAMES);
+    databaseHitCount = (total < MAX_LISTED_DATABASE_GAMES) ? total : MAX_LISTED_DATABASE_GAMES;
+
+    size_t length = 0;
+    for (size_t i = 0; i < databaseHitCount; i++)
+    {
+        char row[DATABASE_LIST_ROW_LENGTH];
+
+        if (ReadDatabaseGame(&gameDatabase, databaseHits[i].game, &databaseGame))
+        {
+            snprintf(row, sizeof row, "%.24s - %.24s %.7s", databaseGame.white, databaseGame.black, databaseGame.result);
+        }
+        else
+        {
+            snprintf(row, sizeof row, "Game %u (damaged)", databaseHits[i].game);
+        }
+
+        for (char *c = row; *c != '\0'; c++)
+        {
+            if (*c == ';')
+            {
+                *c = ',';
+            }
+        }
+
+        length += (size_t)snprintf(databaseListBuffer + length, sizeof databaseListBuffer - length, "%s%s", (i > 0) ? ";" : "", row);
+    }
+
+    if (databaseHitCount == 0)
+    {
+        TextCopy(databaseListBuffer, "No game reaches this position");
+    }
+}
+
+/**
+ * IsIdleFrame (static)
+ *
+ * Decides whether the frame being drawn can stay on screen until the next input event
+ * (mouse, keyboard, resize, focus), i.e. whether its EndDrawing may wait for events
+ * instead of the main loop running at FPS.
+ *
+ * Returns:
+ *  - false while something changes without input: the engine thinking (its move arrives
+ *    from another thread), a running analysis (new snapshots), the saves I/O thread at
+ *    work (a new index for the Load popup), the sounds still loading, an open text box
+ *    (its cursor blinks), and for the frame after every position change.
+ *  - false for the frame after a wait as well: what an event changed after the board was
+ *    drawn (a game loaded or a popup opened by a button in HandleGui) shows up in it.
+ */
+static bool IsIdleFrame(void)
+{
+    static uint64_t lastKey = 0;
+    static bool waited = false; // the previous EndDrawing waited for an event
+
+    bool busy = (state.zobristKey != lastKey) || IsEngineThinking() || IsAnalysisSearching() || IsSavesBusy() || AreSoundsLoading() ||
+                showSaveTextInput || showFenInputPopup;
+    lastKey = state.zobristKey;
+
+    waited = !busy && !waited;
+    return waited;
+}
+
+/**
+ * MillisecondsSince (static)
+ *
+ * Returns:
+ *  - Milliseconds elapsed since start, a MonotonicSeconds time (startup timing).
+ */
+static double MillisecondsSince(double start)
+{
+    return (MonotonicSeconds() - start) * 1000.0;
+}
@@ -3,8 +3,11 @@
  *
  * Responsibilities:
  * - Define core data structures used throughout the game (Piece, Cell, GameState).
+ * - PieceType/Team live in piece.h so the raylib-free bitboard core can share them.
  * - Define the Move structure for history tracking.
- * - Export the global `state` variable.
+ * - Export the global `state` variable (the GUI's game) and the shorthand macros for it;
+ *   model code (move.c, load.c, save.c, utils.c) defines NO_GLOBAL_GAME_STATE and works
+ *   on the GameState pointer it is given instead.
  *
  * VERY IMPORTANT NOTE:
  * ! I added an extra bit for the enums because wether its signed or unsigned is implementation defined an extra bit will make us guarantee that it works as intended
@@ -13,32 +16,16 @@
 #ifndef MAIN_H
 #define MAIN_H
 
+#include "bitboard.h"
 #include "hash.h"
+#include "movegen.h"
+#include "piece.h"
 #include "raylib.h"
 #include "settings.h"
+#include "tablebase.h"
 
 typedef struct MoveStack MoveStack;
-
-/* PieceType
- * - PIECE_NONE == 0 so zero-initialized memory means "empty cell".
- */
-typedef enum
-{
-    PIECE_NONE = 0, /* empty square */
-    PIECE_KING,
-    PIECE_QUEEN,
-    PIECE_ROOK,
-    PIECE_BISHOP,
-    PIECE_KNIGHT,
-    PIECE_PAWN
-} PieceType;
-
-/* Team (side/color) */
-typedef enum
-{
-    TEAM_WHITE = 0,
-    TEAM_BLACK
-} Team;
+typedef struct HistorySnapshots HistorySnapshots;
 
 /*We need 4 bits to store castle rights in game state think of it in binary*/
 // 1111 all rights are reserved
@@ -48,41 +35,37 @@ typedef enum
  * Represents a single chess piece and its small state.
  *
  * Notes:
- * - `type` and `team` identify the piece.
- * - `hasMoved` / `enPassant` are small flags (0/1).
- * - `spriteId` is an optional index you can use for atlases.
- * - `texture` is a GPU texture (Texture2D). The module that replaces a texture
- *   is responsible for UnloadTexture() on the old texture to avoid GPU leaks.
+ * - `type` and `team` identify the piece; the whole Piece packs into one 4-byte word.
+ * - Whether a piece has moved is not tracked here: castling rights and the en passant
+ *   file in GameState carry everything the rules need.
+ * - The sprite is not stored: it is derived from (team, type) with PieceSpriteId
+ *   and drawn from the shared piece atlas (atlas.c), so cells own no GPU resources.
  */
 typedef struct Piece
 {
-    Texture2D texture;  /* put large/aligned field first to avoid padding gaps */
     PieceType type : 4; // I added an extra bit for the enums because wether its signed or unsigned is implementation defined an extra bit will make us guarantee that it works as intended
     Team team : 2;
-    unsigned char hasMoved : 1; /* single byte; now sits after other 4-byte fields */
     // Saved 8 bytes with these bitfields and it will also help us debug errors
 } Piece;
 
 /* Cell
- * Single board square with logical coords, render position, and stored piece.
+ * Render view of a single board square: where it is drawn and what is drawn on it.
  *
  * - row/col: board indices (0..7)
  * - pos: top-left pixel position for drawing (use DrawTexturePro to scale)
- * - piece: content of the square
+ * - piece: content of the square, a copy of GameState.bitboards kept in sync by
+ *   LoadPiece/SetEmptyCell/SyncCells so drawing does not have to search the bitboards
+ *
+ * Notes:
+ * - The rules never read cells: they work on GameState.bitboards, and the per-square
+ *   highlight flags are bitboards of GameState too (primaryValidSquares, validSquares),
+ *   so a Cell is 16 bytes of render data and a flag reset is a single store.
  */
 typedef struct Cell
 {
-    Piece piece;                   /* piece occupying the cell (PIECE_NONE if empty) */
+    Piece piece;                   /* piece drawn on the cell (PIECE_NONE if empty) */
     Vector2 pos;                   /* pixel position for rendering (top-left) */
     unsigned int row : 5, col : 5; /* board coordinates (0..7) */
-    bool primaryValid : 1;         // This is a primary validation geometrically
-    bool isvalid : 1;              // Final validation of moves FINAL_VALIDATION
-    bool selected : 1;             // will also need this
-    bool vulnerable : 1;           // what pieces are under attack on my team this will help in EASY_MODE
-    bool hasMoved : 1;
-    bool PawnMovedTwo : 1;
-    bool JustMoved : 1;
-    // Saved 8 bytes with these bitfields and it will also help us debug errors
 } Cell;
 
 /**
@@ -96,7 +79,6 @@ typedef struct Player
     Team team : 2;
     bool Checked : 1;
     bool Checkmated : 1;
-    bool SimChecked : 1;
     bool Stalemate : 1;
 
     // Saved 1 byte with these bitfields and it will also help us debug errors
@@ -119,47 +101,18 @@ typedef struct
 /**
  * Move
  *
- * Represents a single move in the game history.
- * Packed to minimize memory usage for the undo/redo stacks.
- * Stores source/dest, captured pieces, promotion details, and previous board state flags
- * (en passant, castling rights) to allow full state restoration.
+ * Represents a single move in the game history (Undo/Redo stacks).
+ *
+ * - move: the 16-bit core move (from, to, flags; see movegen.h). Castling, en passant and
+ *         the promotion piece are all in the flags.
+ * - undo: what UnmakeMove needs to take it back (captured piece, previous castling rights,
+ *         en passant file, half-move clock and key; see position.h). Filled by MakeMove
+ *         every time the move is played, so Redo re-creates it.
  */
-typedef struct __attribute__((packed))
+typedef struct
 {
-    // Done a very good job packing all this info in 6 bytes actually 44 bits
-
-    // Squares
-    unsigned int initialRow : 4, initialCol : 4;
-    unsigned int finalRow : 4, finalCol : 4;
-
-    // Piece info
-    PieceType pieceMovedType : 4;
-    Team pieceMovedTeam : 1;
-    PieceType pieceCapturedType : 4; // this should be PIECE_NONE if I didn't capture any piece
-    // We don't need pieceCapturedTeam because it must be the opposite of PieceMovedTeam
-
-    // Promotion
-    PieceType promotionType : 4; // If my piece was pawn and it got promoted what is its new type so that I can undo it **** this should be PIECE_NONE if the pawn didn't promote in this move
-
-    // En-Passant
-    unsigned int wasEnPassant : 1;
-    signed int previousEnPassantCol : 4;
-    // This is why we don't need the previousEnPassantRow
-    // if (sideToMove == WHITE)
-    //     enPassantRow = 2;
-    // else
-    //     enPassantRow = 5;
-
-    // Castling
-    unsigned int wasCastling : 1;
-    unsigned char whiteKingSide : 1;
-    unsigned char whiteQueenSide : 1;
-    unsigned char blackKingSide : 1;
-    unsigned char blackQueenSide : 1;
-
-    // Draw
-    unsigned int halfMove : 7;
-
+    ChessMove move;
+    UndoInfo undo;
 } Move;
 
 /**
@@ -168,11 +121,19 @@ typedef struct __attribute__((packed))
  * The monolithic state object for the entire game.
  * Contains the board, player info, rules state (castling, en passant),
  * history stacks, and UI flags.
+ *
+ * Notes:
+ * - Any number of games may exist (InitializeGame/FreeGame in utils.h); the move, load and
+ *   save APIs take the game they work on. `state` is the one the GUI shows.
  */
-typedef struct
+typedef struct GameState
 {
     // Physical board info
-    Cell board[BOARD_SIZE][BOARD_SIZE];
+    Cell board[BOARD_SIZE][BOARD_SIZE]; // render data (positions and the piece drawn on each square)
+    Bitboards bitboards;                // logical position, kept in sync by LoadPiece/SetEmptyCell
+    AttackMap attacks;                  // attacks of both teams, updated with bitboards (RefreshAttackMap); replaces per-cell vulnerable flags
+    Bitboard primaryValidSquares;       // geometric targets marked by PrimaryValidation / MoveValidation
+    Bitboard validSquares;              // legal targets of the selected piece (FinalValidation)
     Cell DeadWhitePieces[2 * BOARD_SIZE];
     Cell DeadBlackPieces[2 * BOARD_SIZE];
 
@@ -192,6 +153,13 @@ typedef struct
     int halfMoveClock;
     int fullMoveNumber;
 
+    // Zobrist key of the position (pieces, side to move, castling rights, en passant file),
+    // updated incrementally on every board change; see zobrist.h
+    uint64_t zobristKey;
+
+    // Legal moves of the side to move, rebuilt once per position by ResetsAndValidations
+    LegalMoveCache legalMoves;
+
     // Game Status
     bool isCheckmate;
     bool isStalemate;
@@ -201,17 +169,23 @@ typedef struct
     // NEW: Insufficient Material Flag
     bool isInsufficientMaterial;
 
+    // Exact outcome of the position when the Syzygy tablebases cover it (ResetsAndValidations)
+    bool hasTablebaseResult;
+    TablebaseResult tablebaseResult;
+
     // Promotion State
     bool isPromoting;
     PieceType promotionType;
     int promotionRow;
     int promotionCol;
+    ChessMove pendingPromotion; // the promotion (right squares) waiting for the piece choice; PromotePawn picks the matching one
 
-    // this is used for detecting threefold repetition
+    // history of zobristKey values, used for detecting threefold repetition
     DynamicHashArray *DHA;
 
     MoveStack *undoStack;
     MoveStack *redoStack;
+    HistorySnapshots *snapshots; // position every HISTORY_SNAPSHOT_INTERVAL plies of the game line (JumpToPly)
 
     GameSounds sounds;
 
@@ -221,9 +195,17 @@ typedef struct
     // NEW: Flag to freeze board interaction when a popup is open
     bool isInputLocked;
 
+    // Play vs engine mode (opponent.c): the engine moves whenever it is engineTeam's turn
+    bool vsEngine;
+    Team engineTeam;
+
+    // Set on the game the GUI shows: only that one plays sounds, cancels the analysis and
+    // touches the highlight/selection state when its position changes
+    bool isOnScreen;
+
 } GameState;
 
-#ifndef MAIN_C
+#if !defined(MAIN_C) && !defined(NO_GLOBAL_GAME_STATE)
 extern GameState state;
 
 #define GameBoard (state.board) // This is the best line to de a ton of very tedious textual replaces that could lead to errors and it's very clear how we updated our code
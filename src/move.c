@@ -2,60 +2,97 @@
  * move.c
  *
  * Responsibilities:
- * - Execute piece movement between cells on the GameBoard.
- * - Provide a helper to clear a cell's piece data and release associated texture.
+ * - Execute piece movement between cells on the board of a game.
+ * - Provide helpers to place a piece (LoadPiece) and clear a cell's piece data, and to
+ *   set up or empty a whole board.
  * - Implement move validation logic (primary geometric checks and final legal checks).
  * - Handle special moves: Castling, En Passant, Promotion.
  * - Manage game history (Undo/Redo) and state updates (Turn, Check, Mate).
  *
  * Notes:
- * - These functions operate directly on the global GameBoard array (declared in main.c).
- * - Textures are managed with raylib's LoadTexture/UnloadTexture APIs; callers must ensure
- *   proper sizing/assignment (LoadPiece is used to place textures on destination squares).
- * - All operations are intended to be called from the main thread.
+ * - Rule evaluation (targets, attacks, check, mate) runs on game->bitboards; the board
+ *   cells only receive the resulting highlight flags for rendering.
+ * - game->attacks (AttackMap) follows every change of game->bitboards: SetCurrentPosition,
+ *   SetEmptyCell and LoadPiece pass the changed squares to RefreshAttackMap, which only
+ *   recomputes the pieces a change can affect. Check detection and the vulnerable-square
+ *   queries read it directly.
+ * - Legal moves come from the generator in movegen.c, fed with a Position snapshot
+ *   of the current state (CurrentPosition).
+ * - Moves are played by the core MakeMove (position.c) on that snapshot (or on a history
+ *   checkpoint), which is then written back with SetCurrentPosition. MovePiece/UndoMove/RedoMove add
+ *   the GUI side: history stacks, dead pieces, repetition history, sounds and highlights.
+ * - The game line is the Undo stack (oldest move first) followed by the Redo stack (next
+ *   move on top); every record in it carries its UndoInfo. game->snapshots holds the
+ *   position every HISTORY_SNAPSHOT_INTERVAL plies of the line, so JumpToPly (and
+ *   Undo/Redo through it) restores any ply with one copy and a few MakeMove calls.
+ * - Every function works on the GameState it is passed (the GUI passes &state), so
+ *   several games can be kept and played independently. The GUI side effects (sounds,
+ *   cancelling the analysis, last-move highlight, selection) only happen for the game
+ *   with isOnScreen set; the rest is identical for every game.
+ * - Cells hold no textures; LoadPiece/SetEmptyCell only write logical data and the
+ *   renderer draws sprites from the shared piece atlas.
+ * - Calls on the same game must not overlap; different games may be used from
+ *   different threads, except for the isOnScreen game, which belongs to the main thread.
  */
 
+#define NO_GLOBAL_GAME_STATE
+
 #include "move.h"
+#include "analysis.h"
+#include "bitboard.h"
 #include "draw.h"
 #include "hash.h"
+#include "history.h"
 #include "main.h"
+#include "movegen.h"
+#include "position.h"
+#include "profile.h"
+#include "psqt.h"
 #include "raylib.h"
 #include "settings.h"
 #include "stack.h"
+#include "tablebase.h"
+#include "zobrist.h"
 #include <stdbool.h>
-#include <stdlib.h>
-
-bool checked = false, flag = false;
-
-// NEW: Temporary storage for the move while waiting for promotion selection
-static Move pendingMove;
 
 // NEW: Helper function to play sounds based on move result
-static void PlayGameSound(Move move)
+static void PlayGameSound(GameState *game, Move move)
 {
-    if (state.isCheckmate)
+    if (!game->isOnScreen)
+    {
+        return;
+    }
+
+    if (game->isCheckmate)
     {
-        PlaySound(state.sounds.checkMate);
+        PlaySound(game->sounds.checkMate);
     }
-    else if (state.whitePlayer.Checked || state.blackPlayer.Checked)
+    else if (game->whitePlayer.Checked || game->blackPlayer.Checked)
     {
-        PlaySound(state.sounds.check);
+        PlaySound(game->sounds.check);
     }
-    else if (move.pieceCapturedType != PIECE_NONE)
+    else if (move.undo.captured != PIECE_NONE)
     {
-        PlaySound(state.sounds.capture);
+        PlaySound(game->sounds.capture);
     }
     else
     {
-        PlaySound(state.sounds.move);
+        PlaySound(game->sounds.move);
     }
 }
 
 /* Add prototypes near the top of the file (below includes) */
-static void RaycastRook(int CellX, int CellY, Team team);
-static void RaycastBishop(int CellX, int CellY, Team team);
-void CheckInsufficientMaterial(void);
-Move RecordMove(int initialRow, int initialCol, int finalRow, int finalCol);
+static Team Opponent(Team team);
+static Bitboard CastlingTargets(GameState *game, Team team);
+static Bitboard EnPassantTarget(GameState *game, int square, Team team);
+static ChessMove FindLegalMove(GameState *game, int from, int to, PieceType promotionType);
+static void CommitMove(GameState *game, ChessMove move);
+static void ApplyMove(GameState *game, Move *record);
+static void PlayRecordedMove(GameState *game, Move *record);
+static Bitboard SyncCells(GameState *game, const Bitboards *before);
+static Move *LineMove(GameState *game, size_t ply);
+static void LoadDeadPiece(GameState *game, int *counter, PieceType type, Team team);
+void CheckInsufficientMaterial(GameState *game);
 
 /**
  * MovePiece
@@ -63,23 +100,20 @@ Move RecordMove(int initialRow, int initialCol, int finalRow, int finalCol);
  * Move a piece from an initial board square to a final board square.
  *
  * Behavior / Side effects:
- * - Loads the moving piece's texture into the destination cell via LoadPiece().
- * - Marks the destination piece as having moved (hasMoved = 1).
- * - Clears the source cell by calling SetEmptyCell(), which also unloads any texture
- *   that remained on the source.
- * - Updates game clocks (halfmove/fullmove).
- * - Handles special moves (Castling, En Passant, Promotion).
- * - Updates game history (Undo stack, DHA).
- * - Plays appropriate sound effects.
+ * - Looks the move up in the cached legal moves (game->legalMoves) and plays it with the
+ *   core MakeMove, which handles captures, castling, en passant, rights, clocks and the key.
+ * - A promotion only opens the promotion menu; PromotePawn plays it once a piece is chosen.
+ * - Otherwise the move is recorded on the Undo stack (the Redo stack is cleared), the
+ *   repetition history is updated and the move sound is played (see ApplyMove).
  *
  * Parameters:
  *  - initialRow, initialCol : source coordinates (0..7)
  *  - finalRow, finalCol     : destination coordinates (0..7)
  *
  * Preconditions / Safety:
- * - This function assumes GameBoard[initialRow][initialCol].piece.type is valid.
+ * - Illegal moves are rejected with a warning and change nothing.
  */
-void MovePiece(int initialRow, int initialCol, int finalRow, int finalCol)
+void MovePiece(GameState *game, int initialRow, int initialCol, int finalRow, int finalCol)
 {
     /* Bounds checking */
     if (initialRow < 0 || initialRow >= BOARD_SIZE || initialCol < 0 || initialCol >= BOARD_SIZE ||
@@ -90,7 +124,7 @@ void MovePiece(int initialRow, int initialCol, int finalRow, int finalCol)
     }
 
     /* Ensure there is a piece at the source */
-    if (GameBoard[initialRow][initialCol].piece.type == PIECE_NONE)
+    if (game->board[initialRow][initialCol].piece.type == PIECE_NONE)
     {
         TraceLog(LOG_WARNING, "MovePiece: no piece at source (%d,%d)", initialRow, initialCol);
         return;
@@ -101,572 +135,233 @@ void MovePiece(int initialRow, int initialCol, int finalRow, int finalCol)
         return;
     }
 
-    // --- UPDATE CLOCKS ---
-    // Fullmove number increments after Black's move
-    if (Turn == TEAM_BLACK)
-    {
-        state.fullMoveNumber++;
-    }
-
-    // Halfmove clock resets on Pawn move or Capture
-    if (GameBoard[initialRow][initialCol].piece.type == PIECE_PAWN ||
-        GameBoard[finalRow][finalCol].piece.type != PIECE_NONE)
-    {
-        state.halfMoveClock = 0;
-        ClearDHA(state.DHA);
-    }
-    else
-    {
-        state.halfMoveClock++;
-    }
-
-    // before loading piece save the move in struct Move
-
-    // --- ADDED: Update Castling Rights on Rook Capture ---
-    // If we capture a rook, the opponent loses castling rights on that side.
-    if (GameBoard[finalRow][finalCol].piece.type == PIECE_ROOK)
-    {
-        if (GameBoard[finalRow][finalCol].piece.team == TEAM_WHITE)
-        {
-            if (finalRow == WHITE_BACK_RANK && finalCol == ROOK_QS_COL)
-            {
-                state.whiteQueenSide = false;
-            }
-            if (finalRow == WHITE_BACK_RANK && finalCol == ROOK_KS_COL)
-            {
-                state.whiteKingSide = false;
-            }
-        }
-        else if (GameBoard[finalRow][finalCol].piece.team == TEAM_BLACK)
-        {
-            if (finalRow == BLACK_BACK_RANK && finalCol == ROOK_QS_COL)
-            {
-                state.blackQueenSide = false;
-            }
-            if (finalRow == BLACK_BACK_RANK && finalCol == ROOK_KS_COL)
-            {
-                state.blackKingSide = false;
-            }
-        }
-    }
-
-    // 1. CAPTURE MOVE DETAILS BEFORE BOARD CHANGES
-    // We must do this here because LoadPiece will overwrite the captured piece
-    // and SetEmptyCell will clear the source piece.
-    Move currentMove = RecordMove(initialRow, initialCol, finalRow, finalCol);
-
-    state.enPassantCol = -1;
-
-    // DeadPiece Handling
-    if (Turn == TEAM_WHITE)
-    {
-        if (GameBoard[finalRow][finalCol].piece.type != PIECE_NONE && GameBoard[finalRow][finalCol].piece.team == TEAM_BLACK)
-        {
-            // FIX: Prevent array overflow
-            if (deadBlackCounter < (BOARD_SIZE * 2))
-            {
-                LoadPiece(deadBlackCounter++, 1, GameBoard[finalRow][finalCol].piece.type, TEAM_BLACK, DEAD_BLACK_PIECES);
-            }
-        }
-    }
-    else
-    {
-        if (GameBoard[finalRow][finalCol].piece.type != PIECE_NONE && GameBoard[finalRow][finalCol].piece.team == TEAM_WHITE)
-        {
-            // FIX: Prevent array overflow
-            if (deadWhiteCounter < (BOARD_SIZE * 2))
-            {
-                LoadPiece(deadWhiteCounter++, 1, GameBoard[finalRow][finalCol].piece.type, TEAM_WHITE, DEAD_WHITE_PIECES);
-            }
-        }
-    }
-
-    // --- CHANGED: Castling Logic ---
-    // We now detect castling by checking if the King moved 2 squares horizontally.
-
-    PieceType movingPieceType = GameBoard[initialRow][initialCol].piece.type;
-    ResetJustMoved();
-    GameBoard[finalRow][finalCol].JustMoved = true;
-
-    if (movingPieceType == PIECE_KING && abs(finalCol - initialCol) == 2)
-    {
-        if (Turn == TEAM_WHITE)
-        {
-            if (finalRow == WHITE_BACK_RANK && finalCol == CASTLE_KS_KING_COL) // White King Side (g1)
-            {
-                PushStack(state.undoStack, currentMove);
-                PlayGameSound(currentMove);
-                ClearStack(state.redoStack);
-                state.whiteKingSide = false;
-                state.whiteQueenSide = false;
-                LoadPiece(WHITE_BACK_RANK, CASTLE_KS_KING_COL, PIECE_KING, Turn, GAME_BOARD);
-                SetEmptyCell(&GameBoard[WHITE_BACK_RANK][KING_START_COL]);
-                LoadPiece(WHITE_BACK_RANK, CASTLE_KS_ROOK_COL, PIECE_ROOK, Turn, GAME_BOARD);
-                SetEmptyCell(&GameBoard[WHITE_BACK_RANK][ROOK_KS_COL]);
-                ResetsAndValidations();
-                return;
-            }
-            if (finalRow == WHITE_BACK_RANK && finalCol == CASTLE_QS_KING_COL) // White Queen Side (c1)
-            {
-                PushStack(state.undoStack, currentMove);
-                PlayGameSound(currentMove);
-                ClearStack(state.redoStack);
-                state.whiteKingSide = false;
-                state.whiteQueenSide = false;
-                LoadPiece(WHITE_BACK_RANK, CASTLE_QS_KING_COL, PIECE_KING, Turn, GAME_BOARD);
-                SetEmptyCell(&GameBoard[WHITE_BACK_RANK][KING_START_COL]);
-                LoadPiece(WHITE_BACK_RANK, CASTLE_QS_ROOK_COL, PIECE_ROOK, Turn, GAME_BOARD);
-                SetEmptyCell(&GameBoard[WHITE_BACK_RANK][ROOK_QS_COL]);
-
-                ResetsAndValidations();
-                return;
-            }
-        }
-        else if (Turn == TEAM_BLACK)
-        {
-            if (finalRow == BLACK_BACK_RANK && finalCol == CASTLE_KS_KING_COL) // Black King Side (g8)
-            {
-                PushStack(state.undoStack, currentMove);
-                PlayGameSound(currentMove);
-                ClearStack(state.redoStack);
-                state.blackKingSide = false;
-                state.blackQueenSide = false;
-                LoadPiece(BLACK_BACK_RANK, CASTLE_KS_KING_COL, PIECE_KING, Turn, GAME_BOARD);
-                SetEmptyCell(&GameBoard[BLACK_BACK_RANK][KING_START_COL]);
-                LoadPiece(BLACK_BACK_RANK, CASTLE_KS_ROOK_COL, PIECE_ROOK, Turn, GAME_BOARD);
-                SetEmptyCell(&GameBoard[BLACK_BACK_RANK][ROOK_KS_COL]);
-                ResetsAndValidations();
-                return;
-            }
-            if (finalRow == BLACK_BACK_RANK && finalCol == CASTLE_QS_KING_COL) // Black Queen Side (c8)
-            {
-                PushStack(state.undoStack, currentMove);
-                PlayGameSound(currentMove);
-                ClearStack(state.redoStack);
-                state.blackKingSide = false;
-                state.blackQueenSide = false;
-                LoadPiece(BLACK_BACK_RANK, CASTLE_QS_KING_COL, PIECE_KING, Turn, GAME_BOARD);
-                SetEmptyCell(&GameBoard[BLACK_BACK_RANK][KING_START_COL]);
-                LoadPiece(BLACK_BACK_RANK, CASTLE_QS_ROOK_COL, PIECE_ROOK, Turn, GAME_BOARD);
-                SetEmptyCell(&GameBoard[BLACK_BACK_RANK][ROOK_QS_COL]);
-                ResetsAndValidations();
-                return;
-            }
-        }
-    }
-
-    if (state.enPassantCol != -1)
-    {
-        if (Turn == TEAM_WHITE)
-        {
-            if (movingPieceType == PIECE_PAWN && finalRow == 2 && finalCol == initialCol - 1)
-            {
-                LoadPiece(finalRow, finalCol, PIECE_PAWN, Turn, GAME_BOARD);
-                SetEmptyCell(&GameBoard[initialRow][initialCol]);
-                SetEmptyCell(&GameBoard[initialRow][initialCol - 1]);
-            }
-            if (movingPieceType == PIECE_PAWN && finalRow == 2 && finalCol == initialCol + 1)
-            {
-                LoadPiece(finalRow, finalCol, PIECE_PAWN, Turn, GAME_BOARD);
-                SetEmptyCell(&GameBoard[initialRow][initialCol]);
-                SetEmptyCell(&GameBoard[initialRow][initialCol + 1]);
-            }
-        }
-        else
-        {
-            if (movingPieceType == PIECE_PAWN && finalRow == 5 && finalCol == initialCol - 1)
-            {
-                LoadPiece(finalRow, finalCol, PIECE_PAWN, Turn, GAME_BOARD);
-                SetEmptyCell(&GameBoard[initialRow][initialCol]);
-                SetEmptyCell(&GameBoard[initialRow][initialCol - 1]);
-            }
-            if (movingPieceType == PIECE_PAWN && finalRow == 5 && finalCol == initialCol + 1)
-            {
-                LoadPiece(finalRow, finalCol, PIECE_PAWN, Turn, GAME_BOARD);
-                SetEmptyCell(&GameBoard[initialRow][initialCol]);
-                SetEmptyCell(&GameBoard[initialRow][initialCol + 1]);
-            }
-        }
-    }
-
-    // --- Update Castling Rights Flags ---
-    // If King or Rook moves normally, we lose castling rights.
-    if (movingPieceType == PIECE_KING)
-    {
-        if (Turn == TEAM_WHITE)
-        {
-            state.whiteKingSide = false;
-            state.whiteQueenSide = false;
-        }
-        else
-        {
-            state.blackKingSide = false;
-            state.blackQueenSide = false;
-        }
-    }
-    else if (movingPieceType == PIECE_ROOK)
-    {
-        if (Turn == TEAM_WHITE)
-        {
-            if (initialRow == WHITE_BACK_RANK && initialCol == ROOK_QS_COL)
-            {
-                state.whiteQueenSide = false;
-            }
-            if (initialRow == WHITE_BACK_RANK && initialCol == ROOK_KS_COL)
-            {
-                state.whiteKingSide = false;
-            }
-        }
-        else
-        {
-            if (initialRow == BLACK_BACK_RANK && initialCol == ROOK_QS_COL)
-            {
-                state.blackQueenSide = false;
-            }
-            if (initialRow == BLACK_BACK_RANK && initialCol == ROOK_KS_COL)
-            {
-                state.blackKingSide = false;
-            }
-        }
-    }
-    // Update implementing PawnMovedTwoFlag
-    if (GameBoard[initialRow][initialCol].piece.type == PIECE_PAWN && abs(finalRow - initialRow) == 2)
-    {
-        GameBoard[finalRow][finalCol].PawnMovedTwo = true;
-    }
-
-    // 1. Move the piece
-    LoadPiece(finalRow, finalCol, GameBoard[initialRow][initialCol].piece.type, GameBoard[initialRow][initialCol].piece.team, GAME_BOARD);
-    GameBoard[finalRow][finalCol].piece.hasMoved = 1;
-    SetEmptyCell(&GameBoard[initialRow][initialCol]);
-
-    // FIX: Execute En Passant Capture
-    // We must do this explicitly here because we reset state.enPassantCol to -1 earlier.
-    if (currentMove.wasEnPassant)
+    ChessMove move = FindLegalMove(game, SQUARE_INDEX(initialRow, initialCol), SQUARE_INDEX(finalRow, finalCol), PIECE_NONE);
+    if (move == 0)
     {
-        // The captured pawn is at [initialRow][finalCol]
-        SetEmptyCell(&GameBoard[initialRow][finalCol]);
+        TraceLog(LOG_WARNING, "MovePiece: illegal move (%d,%d)->(%d,%d)", initialRow, initialCol, finalRow, finalCol);
+        return;
     }
 
     // --- NEW: Check for Promotion ---
-    bool isPromoting = false;
-
-    if (GameBoard[finalRow][finalCol].piece.type == PIECE_PAWN)
-    {
-        // White reaches row 0, Black reaches row 7 (assuming 0 is top)
-        if ((GameBoard[finalRow][finalCol].piece.team == TEAM_WHITE && finalRow == 0) ||
-            (GameBoard[finalRow][finalCol].piece.team == TEAM_BLACK && finalRow == BOARD_SIZE - 1))
-        {
-            isPromoting = true;
-        }
-    }
-
-    if (isPromoting)
+    if (MOVE_IS_PROMOTION(move))
     {
-        state.isPromoting = true;
-        state.promotionRow = finalRow;
-        state.promotionCol = finalCol;
+        game->isPromoting = true;
+        game->promotionRow = finalRow;
+        game->promotionCol = finalCol;
 
         // SAVE THE MOVE FOR LATER
-        pendingMove = currentMove;
+        game->pendingPromotion = move;
 
         // RETURN EARLY: Pause the game, wait for input
         return;
     }
 
-    state.promotionType = PIECE_NONE;
-    PushStack(state.undoStack, currentMove);
-    ClearStack(state.redoStack);
-
-    ResetsAndValidations();
-
-    // --- HISTORY HANDLING ---
-    Hash currentHash = CurrentGameStateHash();
-
-    // 1. Check for Draw (only if reversible move)
-    if (state.halfMoveClock > 0)
-    {
-        if (IsRepeated3times(state.DHA, currentHash))
-        {
-            state.isRepeated3times = true;
-        }
-    }
-
-    // 2. Record the move
-    PushDHA(state.DHA, currentHash);
-
-    // NEW: Play sound for normal moves
-    PlayGameSound(currentMove);
+    game->promotionType = PIECE_NONE;
+    CommitMove(game, move);
 }
 
 /**
  * SetEmptyCell
  *
- * Clear a Cell to represent an empty square and release any associated texture.
+ * Clear a Cell to represent an empty square.
  *
  * Behavior / Side effects:
- * - Sets piece.type to PIECE_NONE and resets piece-related flags (hasMoved, enPassant).
+ * - Sets piece.type to PIECE_NONE.
  * - Resets piece.team to TEAM_WHITE as a neutral default.
- * - If a Texture2D is present (texture.id != 0) it is UnloadTexture()'d to free GPU memory.
+ * - Removes the piece from game->bitboards (and game->attacks) and its term from game->zobristKey.
  *
  * Parameters:
  *  - cell: pointer to the Cell to clear (must be non-NULL).
  *
  * Notes:
- * - Safe to call on already-empty cells; UnloadTexture will not be called when texture.id == 0.
+ * - Safe to call on already-empty cells.
  */
-void SetEmptyCell(Cell *cell)
+void SetEmptyCell(GameState *game, Cell *cell)
 {
+    if (cell->piece.type != PIECE_NONE)
+    {
+        int square = SQUARE_INDEX(cell->row, cell->col);
+        RemovePieceBB(&game->bitboards, square, cell->piece.type, cell->piece.team);
+        game->zobristKey ^= ZobristPieceKeys[cell->piece.team][cell->piece.type][square];
+        RefreshAttackMap(game, SQUARE_BIT(square));
+    }
+
     cell->piece.type = PIECE_NONE;
-    cell->piece.hasMoved = 0;
     cell->piece.team = TEAM_WHITE;
-    // cell->piece.texture.id = 0; // Unload texture function was causing very weird behaviour had to replace it with this
-    UnloadTexture(cell->piece.texture);
 }
 
 /**
- * MoveValidation
+ * LoadPiece
  *
- * Compute primary (geometric) move/raytrace candidates for a piece located at (CellX,CellY).
+ * Public helper to place a piece in game->board[row][col] or in a dead-piece slot.
  *
  * Parameters:
- *  - CellX, CellY : coordinates of the piece to validate.
- *  - type         : PieceType identifying movement rules to apply.
- *  - team         : the piece's Team.
- *  - moved        : whether the piece has moved before (affects pawn and castling logic).
+ *  - game     : the game to place the piece in
+ *  - row, col : board coordinates (0..7); for dead pieces row is the slot index and col is ignored
+ *  - type     : PieceType enum
+ *  - team     : TEAM_WHITE or TEAM_BLACK
+ *  - LoadPlace: this allows us to use the function for multiple purposes (it takes an enum)
  *
- * Behavior:
- *  - Marks GameBoard squares' primaryValid or vulnerable flags according to geometric reachability
- *    (does not perform final king-checking validation).
- *  - Delegates to piece-specific helpers: rook/bishop/queen cast rays, pawns/knights/kings use helpers.
+ * Safety:
+ *  - Performs bounds check on row/col and ignores PIECE_NONE.
  *
- * Side effects:
- *  - Mutates GameBoard[*][*].primaryValid and/or .vulnerable.
+ * Notes:
+ *  - Only logical data is written (type/team plus the bitboards and Zobrist key for
+ *    GAME_BOARD); the sprite comes from the atlas at draw time, so this never touches
+ *    the disk or the GPU and cannot fail halfway through a move.
  */
-void MoveValidation(int CellX, int CellY, PieceType type, Team team, bool moved)
+void LoadPiece(GameState *game, int row, int col, PieceType type, Team team, LoadPlace place)
 {
-    if (type == PIECE_ROOK)
-    {
-        RaycastRook(CellX, CellY, team);
-    }
-
-    if (type == PIECE_BISHOP)
-    {
-        RaycastBishop(CellX, CellY, team);
-    }
-
-    if (type == PIECE_QUEEN)
-    {
-        /* reuse rook + bishop raycasts */
-        RaycastRook(CellX, CellY, team);
-        RaycastBishop(CellX, CellY, team);
-    }
+    PROFILE_SCOPE(PROFILE_LOAD_PIECE);
 
-    if (type == PIECE_PAWN)
+    if (type <= PIECE_NONE || type >= PIECE_TYPE_COUNT)
     {
-        HandlePawnMove(CellX, CellY, team, moved);
-    }
-
-    if (type == PIECE_KNIGHT)
-    {
-        HandleKnightMove(CellX, CellY, team);
-    }
-
-    if (type == PIECE_KING)
-    {
-        HandleKingMove(CellX, CellY, team);
+        return;
     }
-}
 
-/**
- * RaycastRook
- *
- * Cast rook-like rays from (CellX,CellY) to mark reachable squares.
- *
- * Parameters:
- *  - CellX, CellY : source coordinates.
- *  - team         : team of the sliding piece.
- *
- * Behavior:
- *  - Iterates in four orthogonal directions (up/down/left/right) until the board edge
- *    or a blocking piece is reached. For each inspected square calls HandleLinearSquare()
- *    which sets primaryValid or vulnerable and returns whether the ray must stop.
- *
- * Side effects:
- *  - Mutates GameBoard[*][*].primaryValid / vulnerable via HandleLinearSquare.
- */
-static void RaycastRook(int CellX, int CellY, Team team)
-{
-    int i;
-    for (i = CellX + 1; i < BOARD_SIZE; i++)
-    {
-        if (HandleLinearSquare(i, CellY, team))
-        {
-            break;
-        }
-    }
-    for (i = CellX - 1; i >= 0; i--)
+    if (place == GAME_BOARD)
     {
-        if (HandleLinearSquare(i, CellY, team))
+        if (row < 0 || row >= BOARD_SIZE || col < 0 || col >= BOARD_SIZE)
         {
-            break;
+            return;
         }
-    }
-    for (i = CellY + 1; i < BOARD_SIZE; i++)
-    {
-        if (HandleLinearSquare(CellX, i, team))
+
+        // Keep the bitboards and the Zobrist key in sync with the cell being overwritten
+        int square = SQUARE_INDEX(row, col);
+        if (game->board[row][col].piece.type != PIECE_NONE)
         {
-            break;
+            RemovePieceBB(&game->bitboards, square, game->board[row][col].piece.type, game->board[row][col].piece.team);
+            game->zobristKey ^= ZobristPieceKeys[game->board[row][col].piece.team][game->board[row][col].piece.type][square];
         }
+        PlacePieceBB(&game->bitboards, square, type, team);
+        game->zobristKey ^= ZobristPieceKeys[team][type][square];
+        RefreshAttackMap(game, SQUARE_BIT(square));
+
+        // Add the piece to the board
+        game->board[row][col].piece.type = type;
+        game->board[row][col].piece.team = team;
     }
-    for (i = CellY - 1; i >= 0; i--)
+    else if (place == DEAD_WHITE_PIECES || place == DEAD_BLACK_PIECES)
     {
-        if (HandleLinearSquare(CellX, i, team))
+        if (row < 0 || row >= 2 * BOARD_SIZE)
         {
-            break;
+            return;
         }
+
+        Cell *slot = (place == DEAD_WHITE_PIECES) ? &game->DeadWhitePieces[row] : &game->DeadBlackPieces[row];
+        slot->piece.type = type;
+        slot->piece.team = team;
     }
 }
 
 /**
- * RaycastBishop
- *
- * Cast bishop-like diagonal rays from (CellX,CellY) to mark reachable squares.
+ * InitializeBoard
  *
- * Parameters:
- *  - CellX, CellY : source coordinates.
- *  - team         : team of the sliding piece.
+ * Reset every board cell of game to its default coordinates and empty state.
  *
  * Behavior:
- *  - Iterates along the four diagonals until the board edge or a blocking piece.
- *    Uses HandleLinearSquare() for each square which sets primaryValid/vulnerable
- *    and returns whether the ray must stop.
+ * - Writes the row/col indices into each Cell (used later for lookups).
+ * - Calls SetEmptyCell so pieces and metadata are cleared.
  *
- * Side effects:
- *  - Mutates GameBoard[*][*].primaryValid / vulnerable via HandleLinearSquare.
+ * Usage:
+ * - Call once during startup, or before loading a fresh position.
  */
-static void RaycastBishop(int CellX, int CellY, Team team)
+void InitializeBoard(GameState *game)
 {
-    int i;
-    for (i = 1; CellX + i < BOARD_SIZE && CellY + i < BOARD_SIZE; i++)
-    {
-        if (HandleLinearSquare(CellX + i, CellY + i, team))
-        {
-            break;
-        }
-    }
-    for (i = 1; CellX + i < BOARD_SIZE && CellY - i >= 0; i++)
-    {
-        if (HandleLinearSquare(CellX + i, CellY - i, team))
-        {
-            break;
-        }
-    }
-    for (i = 1; CellX - i >= 0 && CellY + i < BOARD_SIZE; i++)
-    {
-        if (HandleLinearSquare(CellX - i, CellY + i, team))
-        {
-            break;
-        }
-    }
-    for (i = 1; CellX - i >= 0 && CellY - i >= 0; i++)
+    for (int i = 0; i < BOARD_SIZE; i++)
     {
-        if (HandleLinearSquare(CellX - i, CellY - i, team))
+        for (int j = 0; j < BOARD_SIZE; j++)
         {
-            break;
+            game->board[i][j].row = i;
+            game->board[i][j].col = j;
+            SetEmptyCell(game, &game->board[i][j]);
         }
     }
 }
 
 /**
- * ResetValidation
- *
- * Clear the per-square final-validation flag (isvalid) across the entire board.
+ * InitializeDeadPieces
  *
- * Behavior:
- *  - Sets GameBoard[i][j].isvalid = false for all squares.
+ * Initialize the arrays game uses to track captured pieces (DeadWhitePieces/DeadBlackPieces).
+ * Sets all piece types to PIECE_NONE.
  */
-void ResetValidation()
+void InitializeDeadPieces(GameState *game)
 {
-    for (int row = 0; row < BOARD_SIZE; row++)
+    for (int row = 0; row < 2 * BOARD_SIZE; row++)
     {
-        for (int col = 0; col < BOARD_SIZE; col++)
-        {
-            GameBoard[row][col].isvalid = false;
-        }
+        game->DeadWhitePieces[row].piece.type = PIECE_NONE;
+        game->DeadBlackPieces[row].piece.type = PIECE_NONE;
     }
 }
 
 /**
- * ResetVulnerable
+ * UnloadBoard
  *
- * Clear the per-square vulnerable flag across the entire board.
+ * Reset every board cell of game to empty.
  *
  * Behavior:
- *  - Sets GameBoard[i][j].vulnerable = false for all squares.
+ * - Calls SetEmptyCell on every cell to mark PIECE_NONE and clear metadata
+ *   (also removes the pieces from the bitboards and the Zobrist key).
+ *
+ * Usage:
+ * - Invoke when shutting down or replacing the full board.
+ * - Safe to call multiple times; SetEmptyCell handles already-empty cells.
+ * - Piece sprites are owned by the atlas; release them with UnloadPieceAtlas.
  */
-void ResetVulnerable()
+void UnloadBoard(GameState *game)
 {
-    for (int row = 0; row < BOARD_SIZE; row++)
+    for (int i = 0; i < BOARD_SIZE; i++)
     {
-        for (int col = 0; col < BOARD_SIZE; col++)
+        for (int j = 0; j < BOARD_SIZE; j++)
         {
-            GameBoard[row][col].vulnerable = false;
+            SetEmptyCell(game, &game->board[i][j]);
         }
     }
 }
 
 /**
- * ResetPrimaryValidation
+ * MoveValidation
  *
- * Clear the per-square primary validation flag (primaryValid) for the whole board.
+ * Mark the primary (geometric) targets of a piece of the side to move located at (CellX,CellY).
+ *
+ * Parameters:
+ *  - CellX, CellY : coordinates of the piece to validate.
+ *  - type         : PieceType identifying movement rules to apply.
+ *  - team         : the piece's Team.
  *
  * Behavior:
- *  - Sets GameBoard[i][j].primaryValid = false for all squares.
+ *  - Adds every pseudo-legal destination (PieceTargets) to game->primaryValidSquares;
+ *    castling and en passant are added by PrimaryValidation.
+ *  - An opponent's piece marks nothing: the squares it attacks are in game->attacks.
  */
-void ResetPrimaryValidation()
+void MoveValidation(GameState *game, int CellX, int CellY, PieceType type, Team team)
 {
-    for (int row = 0; row < BOARD_SIZE; row++)
+    int square = SQUARE_INDEX(CellX, CellY);
+
+    if (team == game->turn)
     {
-        for (int col = 0; col < BOARD_SIZE; col++)
-        {
-            GameBoard[row][col].primaryValid = false;
-        }
+        game->primaryValidSquares |= PieceTargets(&game->bitboards, square, type, team);
     }
 }
 
 /**
- * ResetMovedStatus
+ * ResetValidation
  *
- * Resets the 'hasMoved' flag for all pieces on the board.
- * Used when loading a new game or resetting state.
+ * Clear the final-validation squares (game->validSquares) of the whole board.
  */
-void ResetMovedStatus()
+void ResetValidation(GameState *game)
 {
-    for (int row = 0; row < BOARD_SIZE; row++)
-    {
-        for (int col = 0; col < BOARD_SIZE; col++)
-        {
-            GameBoard[row][col].hasMoved = false;
-        }
-    }
+    game->validSquares = 0;
 }
 
 /**
- * ResetJustMoved
+ * ResetPrimaryValidation
  *
- * Resets the 'JustMoved' flag for all pieces.
- * This flag is used to track the last moved piece for En Passant logic.
+ * Clear the primary validation squares (game->primaryValidSquares) of the whole board.
  */
-void ResetJustMoved()
+void ResetPrimaryValidation(GameState *game)
 {
-    for (int row = 0; row < BOARD_SIZE; row++)
-    {
-        for (int col = 0; col < BOARD_SIZE; col++)
-        {
-            GameBoard[row][col].JustMoved = false;
-        }
-    }
+    game->primaryValidSquares = 0;
 }
 
 /**
@@ -680,720 +375,518 @@ void ResetJustMoved()
  *  - selected : true if the piece is currently selected (triggers special checks like castling).
  *
  * Behavior:
- *  - Looks up whether the piece has moved and its team, then delegates to MoveValidation.
- *  - Does no simulation/king-check filtering; primaryValid flags represent raw reachable squares.
+ *  - Looks up the piece's team on the bitboards, then delegates to MoveValidation.
+ *  - Does no king-check filtering; game->primaryValidSquares holds raw reachable squares.
  */
-void PrimaryValidation(PieceType Piece, int CellX, int CellY, bool selected)
+void PrimaryValidation(GameState *game, PieceType Piece, int CellX, int CellY, bool selected)
 {
-    bool moved = GameBoard[CellX][CellY].piece.hasMoved;
-    Team team = GameBoard[CellX][CellY].piece.team;
+    Team team = TEAM_WHITE;
 
-    switch (Piece)
+    if (PieceTypeAt(&game->bitboards, SQUARE_INDEX(CellX, CellY), &team) != Piece || Piece == PIECE_NONE)
     {
-    case PIECE_KING:
-        MoveValidation(CellX, CellY, PIECE_KING, team, moved);
-        if (selected)
-        {
-            PrimaryCastlingValidation();
-        }
+        return;
+    }
 
-        break;
-    case PIECE_QUEEN:
-        MoveValidation(CellX, CellY, PIECE_QUEEN, team, moved);
-        break;
-    case PIECE_ROOK:
-        MoveValidation(CellX, CellY, PIECE_ROOK, team, moved);
-        break;
-    case PIECE_BISHOP:
-        MoveValidation(CellX, CellY, PIECE_BISHOP, team, moved);
-        break;
-    case PIECE_KNIGHT:
-        MoveValidation(CellX, CellY, PIECE_KNIGHT, team, moved);
-        break;
-    case PIECE_PAWN:
-        MoveValidation(CellX, CellY, PIECE_PAWN, team, moved);
-        if (selected)
-        {
-            PrimaryEnpassantValidation(CellX, CellY);
-        }
+    MoveValidation(game, CellX, CellY, Piece, team);
 
-        break;
-    case PIECE_NONE:
-        break;
+    if (selected && Piece == PIECE_KING)
+    {
+        PrimaryCastlingValidation(game);
+    }
+
+    if (selected && Piece == PIECE_PAWN)
+    {
+        PrimaryEnpassantValidation(game, CellX, CellY);
     }
 }
 
 /**
- * ScanEnemyMoves
+ * RefreshAttackMap
  *
- * Compute primary move/vulnerability maps for all opponent pieces (non-Turn).
+ * Bring game->attacks up to date after the squares in changed were modified on
+ * game->bitboards (see UpdateAttackMap).
  *
- * Behavior:
- *  - Iterates the board and runs MoveValidation for every non-empty cell whose team != Turn.
- *  - Results populate primaryValid/vulnerable flags that other code uses for checks.
- *
- * Notes:
- *  - Skips empty squares and pieces on the current Turn side.
+ * Parameters:
+ *  - changed: squares that were emptied, filled or given another piece.
  */
-void ScanEnemyMoves()
+void RefreshAttackMap(GameState *game, Bitboard changed)
 {
-    for (int row = 0; row < BOARD_SIZE; row++)
-    {
-        for (int col = 0; col < BOARD_SIZE; col++)
-        {
-            Piece thisPiece = GameBoard[row][col].piece;
+    PROFILE_SCOPE(PROFILE_UPDATE_ATTACK_MAP);
 
-            if (thisPiece.team == Turn || thisPiece.type == PIECE_NONE)
-            {
-                continue;
-            }
+    UpdateAttackMap(&game->attacks, &game->bitboards, changed);
+}
 
-            MoveValidation(row, col, thisPiece.type, thisPiece.team, thisPiece.hasMoved);
-        }
+/**
+ * IsSquareVulnerable
+ *
+ * Returns true if the opponent of the side to move attacks (row, col), i.e. a piece of
+ * Turn standing there is under attack (one lookup in game->attacks).
+ */
+bool IsSquareVulnerable(GameState *game, int row, int col)
+{
+    if (row < 0 || row >= BOARD_SIZE || col < 0 || col >= BOARD_SIZE)
+    {
+        return false;
     }
+
+    return (game->attacks.byTeam[Opponent(game->turn)] & SQUARE_BIT(SQUARE_INDEX(row, col))) != 0;
 }
 
 /**
  * ScanFriendlyMoves
  *
- * Compute primary move maps for all friendly pieces (currently on Turn).
- *
- * Behavior:
- *  - Iterates the board and runs MoveValidation for every non-empty cell whose team == Turn.
- *  - Useful for determining legal moves available to the current player.
+ * Add the legal destinations of every friendly piece (currently on Turn) to game->primaryValidSquares.
  *
  * Note:
  *  - This function is currently unused in the codebase but kept for completeness.
  */
-void ScanFriendlyMoves()
+void ScanFriendlyMoves(GameState *game)
 {
-    int row;
-    int col;
-
-    for (row = 0; row < BOARD_SIZE; row++)
+    for (int square = 0; square < SQUARE_COUNT; square++)
     {
-        for (col = 0; col < BOARD_SIZE; col++)
-        {
-            Piece thisPiece = GameBoard[row][col].piece;
-
-            if (thisPiece.team != Turn || thisPiece.type == PIECE_NONE)
-            {
-                continue;
-            }
-
-            MoveValidation(row, col, thisPiece.type, thisPiece.team, thisPiece.hasMoved);
-        }
+        game->primaryValidSquares |= game->legalMoves.targets[square];
     }
 }
 
 /**
- * HandleLinearSquare
+ * CheckValidation
  *
- * Helper used by sliding pieces (rook/bishop/queen) to process one square along a ray.
+ * Determine whether the current player's king is under attack and set Player.Checked.
  *
- * Parameters:
- *  - row, col : coordinates of the square being inspected.
- *  - team     : team of the sliding piece casting the ray.
+ * Behavior:
+ *  - Clears the opponent's Checked flag, then looks the king of Turn up in the
+ *    opponent's attack map (game->attacks).
+ */
+void CheckValidation(GameState *game)
+{
+    (game->turn == TEAM_WHITE) ? (game->blackPlayer.Checked = false) : (game->whitePlayer.Checked = false);
+
+    int king = KingSquare(&game->bitboards, game->turn);
+    bool checked = king != -1 && (game->attacks.byTeam[Opponent(game->turn)] & SQUARE_BIT(king));
+
+    (game->turn == TEAM_WHITE) ? (game->whitePlayer.Checked = checked) : (game->blackPlayer.Checked = checked);
+}
+
+/**
+ * FinalValidation
  *
- * Returns:
- *  - true  : the ray should stop after this square (square occupied).
- *  - false : the ray may continue (square empty).
+ * Compute the final legal moves (game->validSquares) of the selected piece.
  *
- * Side effects:
- *  - Sets GameBoard[row][col].primaryValid if the square is a valid destination for the given team.
- *  - Sets GameBoard[row][col].vulnerable when evaluating vulnerability from the opponent perspective.
+ * Parameters:
+ *  - CellX, CellY : coordinates of the selected piece.
+ *  - selected     : whether a piece is currently selected (only then do final validation).
+ *
+ * Behavior:
+ *  - Copies the destinations cached for this square by ResetsAndValidations
+ *    (game->legalMoves), so selecting a piece does not generate anything.
  */
-bool HandleLinearSquare(int row, int col, Team team)
+void FinalValidation(GameState *game, int CellX, int CellY, bool selected)
 {
-    Cell thisCell = GameBoard[row][col];
-    if (thisCell.piece.type == PIECE_NONE)
-    {
-        if (Turn == team)
-        {
-            GameBoard[row][col].primaryValid = true;
-        }
-        else
-        {
-            GameBoard[row][col].vulnerable = true;
-        }
-        return false;
-    }
+    PROFILE_SCOPE(PROFILE_FINAL_VALIDATION);
 
-    if (thisCell.piece.team != team)
+    if (!selected)
     {
-        if (Turn == team)
-        {
-            GameBoard[row][col].primaryValid = true;
-        }
-        else
-        {
-            GameBoard[row][col].vulnerable = true;
-        }
-
-        return true;
+        return;
     }
 
-    if (Turn != team)
+    game->validSquares |= game->legalMoves.targets[SQUARE_INDEX(CellX, CellY)];
+}
+
+/**
+ * IsLegalDestination
+ *
+ * Returns true if the piece on (fromRow, fromCol) may legally move to (toRow, toCol)
+ * in the current position (reads game->legalMoves).
+ */
+bool IsLegalDestination(GameState *game, int fromRow, int fromCol, int toRow, int toCol)
+{
+    if (fromRow < 0 || fromRow >= BOARD_SIZE || fromCol < 0 || fromCol >= BOARD_SIZE ||
+        toRow < 0 || toRow >= BOARD_SIZE || toCol < 0 || toCol >= BOARD_SIZE)
     {
-        GameBoard[row][col].vulnerable = true;
+        return false;
     }
 
-    return true;
+    return (game->legalMoves.targets[SQUARE_INDEX(fromRow, fromCol)] & SQUARE_BIT(SQUARE_INDEX(toRow, toCol))) != 0;
 }
 
 /**
- * HandlePawnMove
- *
- * Compute pawn move targets (forward moves and captures) for a pawn at (CellX,CellY).
+ * CheckmateValidation
  *
- * Parameters:
- *  - CellX, CellY : pawn coordinates.
- *  - team         : pawn's team.
- *  - moved        : whether the pawn has moved before (affects two-square advance).
+ * Run a full search to determine whether a checked player has any legal escapes.
  *
  * Behavior:
- *  - Marks forward destinations as primaryValid when empty.
- *  - Marks diagonal capture squares as primaryValid (if enemy present) or vulnerable when evaluating opponent threats.
- *
- * Notes:
- *  - Does not handle en-passant or promotions specially; en-passant may be handled elsewhere.
+ *  - If a player's Checked flag is set, calls CheckmateFlagCheck for that player and sets Player.Checkmated and global Checkmate.
  */
-void HandlePawnMove(int CellX, int CellY, Team team, bool moved)
+void CheckmateValidation(GameState *game)
 {
-    if (team == TEAM_BLACK && CellX + 1 < BOARD_SIZE)
+    if (game->whitePlayer.Checked)
     {
-        if (GameBoard[CellX + 1][CellY].piece.type == PIECE_NONE)
-        {
-            if (Turn == team)
-            {
-                GameBoard[CellX + 1][CellY].primaryValid = true;
-            }
-
-            if (!moved && CellX + 2 < BOARD_SIZE)
-            {
-                if (GameBoard[CellX + 2][CellY].piece.type == PIECE_NONE)
-                {
-                    if (Turn == team)
-                    {
-                        GameBoard[CellX + 2][CellY].primaryValid = true;
-                    }
-                }
-            }
-        }
-
-        if (CellY + 1 < BOARD_SIZE)
+        game->whitePlayer.Checkmated = CheckmateFlagCheck(game, TEAM_WHITE);
+        if (game->whitePlayer.Checkmated)
         {
-            if (GameBoard[CellX + 1][CellY + 1].piece.team != team)
-            {
-                if (Turn == team && GameBoard[CellX + 1][CellY + 1].piece.type != PIECE_NONE)
-                {
-                    GameBoard[CellX + 1][CellY + 1].primaryValid = true;
-                }
-                else if (Turn != team)
-                {
-                    GameBoard[CellX + 1][CellY + 1].vulnerable = true;
-                }
-            }
-        }
-
-        if (CellY - 1 >= 0)
-        {
-            if (GameBoard[CellX + 1][CellY - 1].piece.team != team)
-            {
-                if (Turn == team && GameBoard[CellX + 1][CellY - 1].piece.type != PIECE_NONE)
-                {
-                    GameBoard[CellX + 1][CellY - 1].primaryValid = true;
-                }
-                else if (Turn != team)
-                {
-                    GameBoard[CellX + 1][CellY - 1].vulnerable = true;
-                }
-            }
+            game->isCheckmate = true;
         }
     }
-    else if (team == TEAM_WHITE && CellX - 1 >= 0)
+    if (game->blackPlayer.Checked)
     {
-        if (GameBoard[CellX - 1][CellY].piece.type == PIECE_NONE)
+        game->blackPlayer.Checkmated = CheckmateFlagCheck(game, TEAM_BLACK);
+        if (game->blackPlayer.Checkmated)
         {
-            if (Turn == team)
-            {
-                GameBoard[CellX - 1][CellY].primaryValid = true;
-            }
-            if (!moved && CellX - 2 >= 0)
-            {
-                if (GameBoard[CellX - 2][CellY].piece.type == PIECE_NONE)
-                {
-                    if (Turn == team)
-                    {
-                        GameBoard[CellX - 2][CellY].primaryValid = true;
-                    }
-                }
-            }
-        }
-
-        if (CellY - 1 >= 0)
-        {
-            if (GameBoard[CellX - 1][CellY - 1].piece.team != team)
-            {
-                if (Turn == team && GameBoard[CellX - 1][CellY - 1].piece.type != PIECE_NONE)
-                {
-                    GameBoard[CellX - 1][CellY - 1].primaryValid = true;
-                }
-                else if (Turn != team)
-                {
-                    GameBoard[CellX - 1][CellY - 1].vulnerable = true;
-                }
-            }
-        }
-
-        if (CellY + 1 < BOARD_SIZE)
-        {
-            if (GameBoard[CellX - 1][CellY + 1].piece.team != team)
-            {
-                if (Turn == team && GameBoard[CellX - 1][CellY + 1].piece.type != PIECE_NONE)
-                {
-                    GameBoard[CellX - 1][CellY + 1].primaryValid = true;
-                }
-                else if (Turn != team)
-                {
-                    GameBoard[CellX - 1][CellY + 1].vulnerable = true;
-                }
-            }
+            game->isCheckmate = true;
         }
     }
 }
 
 /**
- * HandleKnightSquare
+ * CheckmateFlagCheck
  *
- * Helper to mark a single target square for a knight move.
+ * Determine whether playerTeam has any legal move.
  *
  * Parameters:
- *  - x,y  : target coordinates to consider.
- *  - team : team of the knight performing the move.
+ *  - playerTeam : the Team to analyze.
+ *
+ * Returns:
+ *  - true  : the player has no legal move (checkmate if in check, stalemate otherwise).
+ *  - false : the player has at least one legal move.
  *
  * Behavior:
- *  - If inside the board and target square is empty or enemy, mark primaryValid when evaluating the current player's moves,
- *    otherwise mark vulnerable when evaluating opponent's threats.
+ *  - For the side to move this is the size of the cached move list (game->legalMoves).
+ *  - For the other side the generator runs on a snapshot with playerTeam to move; the
+ *    en passant file only applies to the side to move, so it is dropped.
  */
-void HandleKnightSquare(int row, int col, Team team)
+bool CheckmateFlagCheck(GameState *game, Team playerTeam) // Will also use for stalemate
 {
-    if (row >= 0 && row < BOARD_SIZE && col >= 0 && col < BOARD_SIZE)
+    PROFILE_SCOPE(PROFILE_CHECKMATE_CHECK);
+
+    if (playerTeam == game->turn)
     {
-        if (GameBoard[row][col].piece.team != team || GameBoard[row][col].piece.type == PIECE_NONE)
-        {
-            if (Turn == team)
-            {
-                (GameBoard[row][col].primaryValid = true);
-            }
-            else // --- FIX: Removed type check here --- this looks a lot like an AI fix :)
-            {
-                (GameBoard[row][col].vulnerable = true);
-            }
-        }
+        return game->legalMoves.list.count == 0;
     }
+
+    Position position = CurrentPosition(game);
+    MoveList moves;
+
+    position.side = playerTeam;
+    position.enPassantCol = -1;
+
+    return GenerateLegalMoves(&position, &moves) == 0;
 }
 
 /**
- * HandleKnightMove
+ * CurrentPosition
  *
- * Generate knight move candidates from (CellX,CellY).
+ * Snapshot of the logical game state (pieces, turn, rights, clocks, key) as a Position.
+ * The GameState does not track the piece-square totals, so they are computed here.
+ */
+Position CurrentPosition(GameState *game)
+{
+    PROFILE_SCOPE(PROFILE_CURRENT_POSITION);
+
+    Position position;
+
+    position.bitboards = game->bitboards;
+    position.side = game->turn;
+    position.castlingRights = CastlingRightsMask(game->whiteKingSide, game->whiteQueenSide, game->blackKingSide, game->blackQueenSide);
+    position.enPassantCol = game->enPassantCol;
+    position.halfMoveClock = game->halfMoveClock;
+    position.fullMoveNumber = game->fullMoveNumber;
+    position.key = game->zobristKey;
+    ComputePsqt(&position.bitboards, &position.psqtMidgame, &position.psqtEndgame, &position.phase);
+
+    return position;
+}
+
+/**
+ * SetCurrentPosition
  *
- * Parameters:
- *  - CellX, CellY : knight coordinates.
- *  - team         : knight's team.
+ * Write a Position back into the game state: bitboards, turn, castling flags, en passant
+ * file, clocks and Zobrist key, and the board cells (only the squares whose content
+ * changed are touched).
  *
- * Behavior:
- *  - Calls HandleKnightSquare for all eight knight destinations.
+ * Notes:
+ *  - Does not run the rule checks; call ResetsAndValidations afterwards.
+ *  - Every move, undo and redo passes here, so this is also where a background analysis
+ *    of the old position is told to stop (CancelAnalysis does not wait for it).
  */
-void HandleKnightMove(int CellX, int CellY, Team team)
+void SetCurrentPosition(GameState *game, const Position *position)
 {
-    int row1 = CellX + 2;
-    int row2 = CellX - 2;
-    int col1 = CellY + 2;
-    int col2 = CellY - 2;
-
-    HandleKnightSquare(row1, col2 + 1, team);
-    HandleKnightSquare(row1, col1 - 1, team);
-    HandleKnightSquare(row2, col2 + 1, team);
-    HandleKnightSquare(row2, col1 - 1, team);
-    HandleKnightSquare(row2 + 1, col1, team);
-    HandleKnightSquare(row1 - 1, col1, team);
-    HandleKnightSquare(row2 + 1, col2, team);
-    HandleKnightSquare(row1 - 1, col2, team);
+    Bitboards before = game->bitboards;
+
+    if (game->isOnScreen)
+    {
+        CancelAnalysis();
+    }
+
+    game->bitboards = position->bitboards;
+    game->turn = position->side;
+    game->whiteKingSide = (position->castlingRights & CASTLE_WHITE_KING_SIDE) != 0;
+    game->whiteQueenSide = (position->castlingRights & CASTLE_WHITE_QUEEN_SIDE) != 0;
+    game->blackKingSide = (position->castlingRights & CASTLE_BLACK_KING_SIDE) != 0;
+    game->blackQueenSide = (position->castlingRights & CASTLE_BLACK_QUEEN_SIDE) != 0;
+    game->enPassantCol = position->enPassantCol;
+    game->halfMoveClock = position->halfMoveClock;
+    game->fullMoveNumber = position->fullMoveNumber;
+    game->zobristKey = position->key;
+
+    RefreshAttackMap(game, SyncCells(game, &before));
 }
 
 /**
- * HandleKingMove
+ * Opponent (static)
  *
- * Generate king move candidates from (CellX,CellY), respecting vulnerable squares.
+ * Returns the other team.
+ */
+static Team Opponent(Team team)
+{
+    return (team == TEAM_WHITE) ? TEAM_BLACK : TEAM_WHITE;
+}
+
+/**
+ * CastlingTargets (static)
  *
- * Parameters:
- *  - CellX, CellY : king coordinates.
- *  - team         : king's team.
+ * King destinations of every castle currently available to team.
  *
- * Behavior:
- *  - Examines all adjacent squares; if the square is not marked vulnerable it may be marked primaryValid
- *    (or vulnerable when scanning enemy coverage).
+ * Conditions checked for each side:
+ *  - The GameState right is still set (persistent flags, see MovePiece).
+ *  - King and rook stand on their starting squares.
+ *  - The squares between them are empty.
+ *  - The king is not in check and does not pass through or land on an attacked square.
  */
-void HandleKingMove(int CellX, int CellY, Team team)
+static Bitboard CastlingTargets(GameState *game, Team team)
 {
-    for (int row = CellX - 1; row <= CellX + 1; row++)
+    const Bitboards *bb = &game->bitboards;
+    int rank = (team == TEAM_WHITE) ? WHITE_BACK_RANK : BLACK_BACK_RANK;
+    bool kingSide = (team == TEAM_WHITE) ? game->whiteKingSide : game->blackKingSide;
+    bool queenSide = (team == TEAM_WHITE) ? game->whiteQueenSide : game->blackQueenSide;
+    Team enemy = Opponent(team);
+    Bitboard targets = 0;
+
+    int kingSquare = SQUARE_INDEX(rank, KING_START_COL);
+    if (!(bb->pieces[team][PIECE_KING] & SQUARE_BIT(kingSquare)) || IsSquareAttacked(bb, kingSquare, enemy))
     {
-        for (int col = CellY - 1; col <= CellY + 1; col++)
+        return 0;
+    }
+
+    // King Side (Short Castling): f and g must be empty and safe
+    if (kingSide && (bb->pieces[team][PIECE_ROOK] & SQUARE_BIT(SQUARE_INDEX(rank, ROOK_KS_COL))))
+    {
+        Bitboard path = SQUARE_BIT(SQUARE_INDEX(rank, CASTLE_KS_ROOK_COL)) | SQUARE_BIT(SQUARE_INDEX(rank, CASTLE_KS_KING_COL));
+        if (!(bb->occupied & path) &&
+            !IsSquareAttacked(bb, SQUARE_INDEX(rank, CASTLE_KS_ROOK_COL), enemy) &&
+            !IsSquareAttacked(bb, SQUARE_INDEX(rank, CASTLE_KS_KING_COL), enemy))
         {
-            if (row >= 0 && row < BOARD_SIZE && col >= 0 && col < BOARD_SIZE && (row != CellX || col != CellY))
-            {
-                if (!GameBoard[row][col].vulnerable)
-                {
-                    if (GameBoard[row][col].piece.team != team || GameBoard[row][col].piece.type == PIECE_NONE)
-                    {
-                        if (Turn == team)
-                        {
-                            (GameBoard[row][col].primaryValid = true);
-                        }
-                        else // --- FIX: Removed type check here ---
-                        {
-                            (GameBoard[row][col].vulnerable = true);
-                        }
-                    }
-                }
-            }
+            targets |= SQUARE_BIT(SQUARE_INDEX(rank, CASTLE_KS_KING_COL));
+        }
+    }
+
+    // Queen Side (Long Castling): b, c and d must be empty; only c and d must be safe
+    if (queenSide && (bb->pieces[team][PIECE_ROOK] & SQUARE_BIT(SQUARE_INDEX(rank, ROOK_QS_COL))))
+    {
+        Bitboard path = SQUARE_BIT(SQUARE_INDEX(rank, ROOK_QS_COL + 1)) | SQUARE_BIT(SQUARE_INDEX(rank, CASTLE_QS_KING_COL)) |
+                        SQUARE_BIT(SQUARE_INDEX(rank, CASTLE_QS_ROOK_COL));
+        if (!(bb->occupied & path) &&
+            !IsSquareAttacked(bb, SQUARE_INDEX(rank, CASTLE_QS_ROOK_COL), enemy) &&
+            !IsSquareAttacked(bb, SQUARE_INDEX(rank, CASTLE_QS_KING_COL), enemy))
+        {
+            targets |= SQUARE_BIT(SQUARE_INDEX(rank, CASTLE_QS_KING_COL));
         }
     }
+
+    return targets;
 }
 
 /**
- * CheckValidation
+ * EnPassantTarget (static)
  *
- * Determine whether the current player's king is under attack and set Player.Checked.
+ * The en passant destination for a pawn of team on square, or 0 if none.
  *
  * Behavior:
- *  - Clears the opponent's Checked flag for the current turn, then locates the current player's king.
- *  - If the king's square has the vulnerable flag set, marks the corresponding Player.Checked.
+ *  - game->enPassantCol holds the file of a pawn that just moved two squares (-1 if none).
+ *  - The target is the square behind that pawn (row 2 for White to capture, row 5 for Black),
+ *    and it must be diagonally attacked by the capturing pawn.
  */
-void CheckValidation()
+static Bitboard EnPassantTarget(GameState *game, int square, Team team)
 {
-    (Turn == TEAM_WHITE) ? (Player2.Checked = false) : (Player1.Checked = false);
-
-    for (int row = 0; row < BOARD_SIZE; row++)
+    if (game->enPassantCol < 0 || game->enPassantCol >= BOARD_SIZE || team != game->turn)
     {
-        for (int col = 0; col < BOARD_SIZE; col++)
-        {
-            Cell thisCell = GameBoard[row][col];
+        return 0;
+    }
 
-            if (thisCell.piece.team == Turn && thisCell.piece.type == PIECE_KING)
-            {
-                if (thisCell.vulnerable)
-                {
-                    (Turn == TEAM_WHITE) ? (Player1.Checked = true) : (Player2.Checked = true);
-                }
+    int targetRow = (team == TEAM_WHITE) ? 2 : 5;
+    int victimRow = (team == TEAM_WHITE) ? 3 : 4;
+    int target = SQUARE_INDEX(targetRow, game->enPassantCol);
 
-                return;
-            }
-        }
+    if (!(PawnAttackTable[team][square] & SQUARE_BIT(target)) ||
+        !(game->bitboards.pieces[Opponent(team)][PIECE_PAWN] & SQUARE_BIT(SQUARE_INDEX(victimRow, game->enPassantCol))))
+    {
+        return 0;
     }
+
+    return SQUARE_BIT(target);
 }
 
 /**
- * FinalValidation
+ * FindLegalMove (static)
  *
- * From primaryValid candidates compute final legal moves (isvalid) by simulating moves
- * and rejecting those that leave the player's king in check.
+ * Look a move up in the cached legal moves of the side to move.
  *
  * Parameters:
- *  - CellX, CellY : coordinates of the selected piece.
- *  - selected     : whether a piece is currently selected (only then do final validation).
- *
- * Behavior:
- *  - Iterates primaryValid squares, simulates each move, re-scans enemy moves and checks for simulated check.
- *  - Sets GameBoard[i][j].isvalid true only for moves that do not result in self-check.
+ *  - from, to:      squares of the move.
+ *  - promotionType: piece of a promotion; PIECE_NONE accepts any move between the squares
+ *                   (for a promotion, the first of the four).
  *
- * Side effects:
- *  - Mutates GameBoard[*][*].isvalid and uses MoveSimulation/UndoSimulation repeatedly.
+ * Returns:
+ *  - The ChessMove, or 0 if it is not legal.
  */
-void FinalValidation(int CellX, int CellY, bool selected)
+static ChessMove FindLegalMove(GameState *game, int from, int to, PieceType promotionType)
 {
-    PieceType piece1;
-    PieceType piece2;
-    Team team2;
-    Player1.SimChecked = false;
-    Player2.SimChecked = false;
+    const LegalMoveCache *cache = &game->legalMoves;
 
-    if (selected)
+    if (!(cache->targets[from] & SQUARE_BIT(to)))
     {
-        piece1 = GameBoard[CellX][CellY].piece.type;
-        for (int row = 0; row < BOARD_SIZE; row++)
-        {
-            for (int col = 0; col < BOARD_SIZE; col++)
-            {
-                Cell thisCell = GameBoard[row][col];
-
-                if (thisCell.primaryValid)
-                {
-                    piece2 = thisCell.piece.type;
-                    team2 = thisCell.piece.team;
-                    MoveSimulation(CellX, CellY, row, col, piece1);
-                    ResetVulnerable();
-                    ScanEnemyMoves();
-                    SimCheckValidation(); // simulation checkvalidation
-                    if (Turn == TEAM_WHITE)
-                    {
-                        if (Player1.SimChecked)
-                        {
-                            GameBoard[row][col].isvalid = false;
-                        }
-                        else
-                        {
-                            GameBoard[row][col].isvalid = true;
-                            // Removed global flag setting (KingSide/QueenSide)
-                        }
-                    }
-                    else
-                    {
-                        if (Player2.SimChecked)
-                        {
-                            GameBoard[row][col].isvalid = false;
-                        }
-                        else
-                        {
-                            GameBoard[row][col].isvalid = true;
-                            // Removed global flag setting (KingSide/QueenSide)
-                        }
-                    }
-
-                    UndoSimulation(CellX, CellY, row, col, piece1, piece2, team2);
-                    ResetVulnerable();
-                    ScanEnemyMoves();
-                    Player1.SimChecked = false;
-                    Player2.SimChecked = false;
-                }
-            }
-        }
-        if (Turn == TEAM_WHITE)
-        {
-            // FIX: Check CellY - 1 >= 0
-            if (piece1 == PIECE_PAWN && CellY - 1 >= 0 &&
-                GameBoard[CellX - 1][CellY - 1].isvalid &&
-                GameBoard[CellX - 1][CellY - 1].piece.type == PIECE_NONE)
-            {
-                state.enPassantCol = CellY - 1;
-            }
-            // FIX: Check CellY + 1 < BOARD_SIZE
-            else if (piece1 == PIECE_PAWN && CellY + 1 < BOARD_SIZE &&
-                     GameBoard[CellX - 1][CellY + 1].isvalid &&
-                     GameBoard[CellX - 1][CellY + 1].piece.type == PIECE_NONE)
-            {
-                state.enPassantCol = CellY + 1;
-            }
-        }
-        else
+        return 0;
+    }
+
+    for (int i = cache->start[from]; i < cache->start[from + 1]; i++)
+    {
+        ChessMove move = cache->list.moves[i];
+
+        if (MOVE_TO(move) == to && (promotionType == PIECE_NONE || MovePromotionType(move) == promotionType))
         {
-            // FIX: Check CellY - 1 >= 0
-            if (piece1 == PIECE_PAWN && CellY - 1 >= 0 &&
-                GameBoard[CellX + 1][CellY - 1].isvalid &&
-                GameBoard[CellX + 1][CellY - 1].piece.type == PIECE_NONE)
-            {
-                state.enPassantCol = CellY - 1;
-            }
-            // FIX: Check CellY + 1 < BOARD_SIZE
-            else if (piece1 == PIECE_PAWN && CellY + 1 < BOARD_SIZE &&
-                     GameBoard[CellX + 1][CellY + 1].isvalid &&
-                     GameBoard[CellX + 1][CellY + 1].piece.type == PIECE_NONE)
-            {
-                state.enPassantCol = CellY + 1;
-            }
+            return move;
         }
     }
+
+    return 0;
 }
 
 /**
- * MoveSimulation
- *
- * Perform a lightweight in-place move of piece type between two squares for simulation purposes.
+ * CommitMove (static)
  *
- * Parameters:
- *  - CellX1, CellY1 : source coordinates.
- *  - CellX2, CellY2 : destination coordinates.
- *  - piece           : PieceType being moved.
- *
- * Notes:
- *  - Only updates piece.type and piece.team; does not touch textures or hasMoved.
- *  - Intended for short-lived simulations that will be undone by UndoSimulation.
+ * Play a new move (from MovePiece or PromotePawn) and record it: Undo stack gets it,
+ * the Redo stack and its checkpoints are forgotten, and the new ply is offered to the
+ * checkpoint arena.
  */
-void MoveSimulation(int CellX1, int CellY1, int CellX2, int CellY2, PieceType piece)
+static void CommitMove(GameState *game, ChessMove move)
 {
-    GameBoard[CellX2][CellY2].piece.team = GameBoard[CellX1][CellY1].piece.team;
-    GameBoard[CellX1][CellY1].piece.type = PIECE_NONE;
-    GameBoard[CellX2][CellY2].piece.type = piece;
+    Move record = {.move = move};
+
+    // The rest of the line (Redo stack) is replaced by this move: so are its checkpoints
+    if (game->snapshots != NULL)
+    {
+        TruncateSnapshots(game->snapshots, StackSize(game->undoStack));
+    }
+
+    ApplyMove(game, &record);
+    PushStack(game->undoStack, record);
+    ClearStack(game->redoStack);
+
+    if (game->snapshots != NULL)
+    {
+        Position position = CurrentPosition(game);
+        RecordSnapshot(game->snapshots, StackSize(game->undoStack), &position, game->deadWhiteCounter, game->deadBlackCounter);
+    }
 }
 
 /**
- * UndoSimulation
+ * ApplyMove (static)
  *
- * Restore board state after a MoveSimulation.
- *
- * Parameters:
- *  - CellX1, CellY1 : source coordinates prior to simulation.
- *  - CellX2, CellY2 : destination coordinates used in simulation.
- *  - piece1          : original source PieceType before simulation.
- *  - piece2          : original destination PieceType before simulation.
- *  - team2           : original destination Team before simulation.
+ * Play record->move on the game state (new moves).
  *
  * Behavior:
- *  - Restores piece types and team for the two involved squares.
+ *  - Plays and records the move (PlayRecordedMove), then runs ResetsAndValidations and
+ *    plays the move sound.
  */
-void UndoSimulation(int CellX1, int CellY1, int CellX2, int CellY2, PieceType piece1, PieceType piece2, Team team2)
+static void ApplyMove(GameState *game, Move *record)
 {
-    GameBoard[CellX1][CellY1].piece.type = piece1;
-    GameBoard[CellX2][CellY2].piece.type = piece2;
-    GameBoard[CellX2][CellY2].piece.team = team2;
+    PlayRecordedMove(game, record);
+    ResetsAndValidations(game);
+    PlayGameSound(game, *record);
 }
 
 /**
- * CheckmateValidation
+ * PlayRecordedMove (static)
  *
- * Run a full search to determine whether a checked player has any legal escapes.
+ * The state changes of a move without the rule checks and the sound (ApplyMove and
+ * ReplayHistory).
  *
  * Behavior:
- *  - If a player's Checked flag is set, calls CheckmateFlagCheck for that player and sets Player.Checkmated and global Checkmate.
+ *  - MakeMove on the CurrentPosition snapshot (fills record->undo), written back with
+ *    SetCurrentPosition.
+ *  - A captured piece goes to the dead-piece list of its team.
+ *  - The new key is recorded and checked for a threefold repetition among the positions
+ *    since the last irreversible move (the history itself is never cleared).
  */
-void CheckmateValidation()
+static void PlayRecordedMove(GameState *game, Move *record)
 {
-    if (Player1.Checked)
+    Position position = CurrentPosition(game);
+
+    MakeMove(&position, record->move, &record->undo);
+    SetCurrentPosition(game, &position);
+
+    // DeadPiece Handling: the captured piece belongs to the side that is now to move
+    if (record->undo.captured != PIECE_NONE)
     {
-        Player1.Checkmated = CheckmateFlagCheck(TEAM_WHITE);
-        if (Player1.Checkmated)
+        if (game->turn == TEAM_BLACK)
         {
-            Checkmate = true;
+            // FIX: Prevent array overflow
+            if (game->deadBlackCounter < (BOARD_SIZE * 2))
+            {
+                LoadPiece(game, game->deadBlackCounter++, 1, record->undo.captured, TEAM_BLACK, DEAD_BLACK_PIECES);
+            }
         }
-    }
-    if (Player2.Checked)
-    {
-        Player2.Checkmated = CheckmateFlagCheck(TEAM_BLACK);
-        if (Player2.Checkmated)
+        else
         {
-            Checkmate = true;
+            if (game->deadWhiteCounter < (BOARD_SIZE * 2))
+            {
+                LoadPiece(game, game->deadWhiteCounter++, 1, record->undo.captured, TEAM_WHITE, DEAD_WHITE_PIECES);
+            }
         }
     }
-}
 
-/**
- * CheckmateFlagCheck
- *
- * Determine whether playerTeam has any legal move that avoids check.
- *
- * Parameters:
- *  - playerTeam : the Team to analyze.
- *
- * Returns:
- *  - true  : the player has no legal moves that avoid check (checkmate / no legal escape).
- *  - false : the player has at least one legal move that avoids check.
- *
- * Behavior:
- *  - For each piece of playerTeam, computes primaryValid moves, simulates each, and checks whether any move leads
- *    to a position where the king is not in check (using SimCheckValidation).
- */
-bool CheckmateFlagCheck(Team playerTeam) // Will also use for stalemate
-{
-    // I won't change these four variables to row/col I will let it as so
-    int i, j, k, l;
-    PieceType piece1;
-    PieceType piece2;
-    bool falsecheck = false;
-    Team team1;
-    Team team2;
-    ResetPrimaryValidation();
-    for (i = 0; i < BOARD_SIZE; i++)
-    {
-        for (j = 0; j < BOARD_SIZE; j++)
-        {
-            /* code */
-            piece1 = GameBoard[i][j].piece.type;
-            team1 = GameBoard[i][j].piece.team;
+    // --- HISTORY HANDLING ---
+    // Record the position, then check for a draw (the half-move clock bounds the scan)
+    PushDHA(game->DHA, game->zobristKey);
 
-            if (team1 == playerTeam && piece1 != PIECE_NONE)
-            {
-                PrimaryValidation(piece1, i, j, false);
-                for (k = 0; k < BOARD_SIZE; k++)
-                {
-                    for (l = 0; l < BOARD_SIZE; l++)
-                    {
-                        if (GameBoard[k][l].primaryValid)
-                        {
-                            piece2 = GameBoard[k][l].piece.type;
-                            team2 = GameBoard[k][l].piece.team;
-                            MoveSimulation(i, j, k, l, piece1);
-                            ResetVulnerable();
-                            ScanEnemyMoves();
-                            SimCheckValidation();
-                            if (Turn == TEAM_WHITE)
-                            {
-                                if (!Player1.SimChecked)
-                                {
-                                    falsecheck = true;
-                                }
-                            }
-                            else
-                            {
-                                if (!Player2.SimChecked)
-                                {
-                                    falsecheck = true;
-                                }
-                            }
-
-                            UndoSimulation(i, j, k, l, piece1, piece2, team2);
-                            ResetVulnerable();
-                            ScanEnemyMoves();
-                            Player1.SimChecked = false;
-                            Player2.SimChecked = false;
-
-                            if (falsecheck)
-                            {
-                                ResetPrimaryValidation();
-                                return false;
-                            }
-                        }
-                    }
-                }
-                ResetPrimaryValidation();
-            }
-        }
+    if (IsRepeated3times(game->DHA, game->halfMoveClock))
+    {
+        game->isRepeated3times = true;
     }
-    ResetPrimaryValidation();
-    return true;
 }
 
 /**
- * SimCheckValidation
- *
- * After simulating moves and scanning enemy coverage, determine if the current player's king is in check.
+ * SyncCells (static)
  *
- * Behavior:
- *  - Iterates the board and sets Player1.SimChecked or Player2.SimChecked if the king of Turn is vulnerable.
+ * Copy the pieces of game->bitboards into the board cells whose content differs from
+ * before (cells only: the bitboards and the key are already up to date).
  *
- * Side effects:
- *  - Updates Player*.SimChecked flags used by simulation logic.
+ * Returns:
+ *  - the squares whose content changed.
  */
-void SimCheckValidation()
+static Bitboard SyncCells(GameState *game, const Bitboards *before)
 {
-    for (int row = 0; row < BOARD_SIZE; row++)
+    Bitboard changed = 0;
+
+    for (int team = 0; team < TEAM_COUNT; team++)
     {
-        for (int col = 0; col < BOARD_SIZE; col++)
+        for (int type = PIECE_KING; type < PIECE_TYPE_COUNT; type++)
         {
-            Cell thisCell = GameBoard[row][col];
+            changed |= before->pieces[team][type] ^ game->bitboards.pieces[team][type];
+        }
+    }
 
-            if (thisCell.piece.team != Turn)
-            {
-                continue;
-            }
+    Bitboard squares = changed;
+    while (squares)
+    {
+        int square = PopLowestSquare(&squares);
+        Cell *cell = &game->board[SQUARE_ROW(square)][SQUARE_COL(square)];
+        Team team = TEAM_WHITE;
 
-            if (thisCell.piece.type == PIECE_KING && thisCell.vulnerable)
-            {
-                Turn == TEAM_WHITE ? (Player1.SimChecked = true) : (Player2.SimChecked = true);
-            }
-        }
+        cell->piece.type = PieceTypeAt(&game->bitboards, square, &team);
+        cell->piece.team = team;
     }
+
+    return changed;
 }
 
 /**
@@ -1406,29 +899,29 @@ void SimCheckValidation()
  *  - If no legal move exists and the side is not in check, sets Player.Stalemate and global Stalemate.
  */
 
-void StalemateValidation()
+void StalemateValidation(GameState *game)
 {
-    state.whitePlayer.Stalemate = false;
-    state.blackPlayer.Stalemate = false;
-    if (Turn == TEAM_WHITE)
+    game->whitePlayer.Stalemate = false;
+    game->blackPlayer.Stalemate = false;
+    if (game->turn == TEAM_WHITE)
     {
         /* code */
 
-        if (!Player1.Checked)
+        if (!game->whitePlayer.Checked)
         {
-            Player1.Stalemate = CheckmateFlagCheck(TEAM_WHITE);
-            if (Player1.Stalemate)
+            game->whitePlayer.Stalemate = CheckmateFlagCheck(game, TEAM_WHITE);
+            if (game->whitePlayer.Stalemate)
             {
-                state.isStalemate = true;
+                game->isStalemate = true;
             }
         }
     }
-    else if (!Player2.Checked)
+    else if (!game->blackPlayer.Checked)
     {
-        Player2.Stalemate = CheckmateFlagCheck(TEAM_BLACK);
-        if (Player2.Stalemate)
+        game->blackPlayer.Stalemate = CheckmateFlagCheck(game, TEAM_BLACK);
+        if (game->blackPlayer.Stalemate)
         {
-            state.isStalemate = true;
+            game->isStalemate = true;
         }
     }
 }
@@ -1436,49 +929,67 @@ void StalemateValidation()
 /**
  * ResetsAndValidations
  *
- * The central update routine called after a move is made or undone.
+ * The central update routine called after the position changed (move made or undone,
+ * game loaded). The turn, clocks and key are already those of the new position.
  *
  * Responsibilities:
- * 1. Flips the turn (White <-> Black).
- * 2. Clears previous validation flags (isvalid, primaryValid).
- * 3. Re-calculates board state:
- *    - Resets vulnerability map.
- *    - Scans enemy moves to update threats.
+ * 1. Generates the legal moves of the new position once (game->legalMoves).
+ * 2. Clears previous validation squares (validSquares, primaryValidSquares).
+ * 3. Re-calculates board state (the attack map, game->attacks, is already up to date):
  *    - Checks if the current player is in Check.
  *    - Checks for Stalemate or Checkmate.
  *    - Checks for Insufficient Material.
+ *    - Probes the Syzygy tablebases (game->tablebaseResult).
  */
-void ResetsAndValidations()
+void ResetsAndValidations(GameState *game)
 {
-    Turn = (Turn == TEAM_WHITE) ? TEAM_BLACK : TEAM_WHITE; // Added turns
+    PROFILE_SCOPE(PROFILE_RESETS_AND_VALIDATIONS);
+
+    // Every rule query below (and every click until the next move) reads this cache
+    Position position = CurrentPosition(game);
+    BuildLegalMoveCache(&position, &game->legalMoves);
 
     // --- FIX: Clear validation flags ---
     // This ensures that any "valid moves" calculated for the previous state
     // (e.g. a selected piece) are wiped out when the state changes via Undo/Redo.
-    ResetValidation();
-    ResetPrimaryValidation();
+    ResetValidation(game);
+    ResetPrimaryValidation(game);
     // -----------------------------------
 
-    ResetVulnerable(); // Reset the curent piece that are in danger
-    ScanEnemyMoves();  // Added vulnerability function checker
-    CheckValidation();
-    StalemateValidation();
-    if (Player1.Checked)
+#ifdef DEBUG
+    for (int team = 0; team < TEAM_COUNT; team++)
     {
-        if (Turn == TEAM_WHITE)
+        if (game->attacks.byTeam[team] != AttacksByTeam(&game->bitboards, (Team)team))
         {
-            CheckmateValidation();
+            TraceLog(LOG_WARNING, "Attack map of team %d out of sync with the board", team);
         }
     }
-    else if (Player2.Checked)
+#endif
+
+    CheckValidation(game);
+    StalemateValidation(game);
+    if (game->whitePlayer.Checked)
     {
-        if (Turn == TEAM_BLACK)
+        if (game->turn == TEAM_WHITE)
         {
-            CheckmateValidation();
+            CheckmateValidation(game);
         }
     }
+    else if (game->blackPlayer.Checked)
+    {
+        if (game->turn == TEAM_BLACK)
+        {
+            CheckmateValidation(game);
+        }
+    }
+
+    CheckInsufficientMaterial(game);
 
-    CheckInsufficientMaterial();
+    // Few enough pieces: the tablebases know who wins (DrawGameStatus shows it), with the
+    // fifty-move rule and the DTZ when the DTZ tables are there, from the WDL tables otherwise
+    ChessMove tablebaseMove;
+    game->hasTablebaseResult = ProbeTablebaseRoot(&position, &tablebaseMove, &game->tablebaseResult) ||
+                               ProbeTablebase(&position, &game->tablebaseResult);
 }
 
 /**
@@ -1490,43 +1001,32 @@ void ResetsAndValidations()
  *  - selectedType: The piece type chosen by the user (Queen, Rook, Bishop, Knight).
  *
  * Behavior:
- *  - Replaces the pawn at the promotion square with the new piece.
- *  - Records the move in history with the correct promotion type.
- *  - Resumes the game loop (calls ResetsAndValidations).
- *  - Plays the promotion sound.
+ *  - Plays the pending promotion (see MovePiece) with the chosen piece through the same
+ *    path as every other move: history, validations and sound.
+ *  - Does nothing if no promotion is pending.
  */
-void PromotePawn(PieceType selectedType)
+void PromotePawn(GameState *game, PieceType selectedType)
 {
-    int row = state.promotionRow;
-    int col = state.promotionCol;
-
-    if (row == -1 || col == -1)
+    if (!game->isPromoting)
     {
         return;
     }
 
-    Team team = GameBoard[row][col].piece.team;
-
-    // 1. Replace pawn with new piece
-    LoadPiece(row, col, selectedType, team, GAME_BOARD);
-
-    // 2. Clear the promotion state
-    state.isPromoting = false;
-    state.promotionRow = -1;
-    state.promotionCol = -1;
-
-    state.promotionType = selectedType;
+    // 1. Clear the promotion state
+    game->isPromoting = false;
+    game->promotionRow = -1;
+    game->promotionCol = -1;
 
-    // 3. FINALIZE RECORDING THE MOVE
-    pendingMove.promotionType = selectedType;
-    PushStack(state.undoStack, pendingMove);
-    ClearStack(state.redoStack);
-
-    // 4. Resume game
-    ResetsAndValidations();
+    // 2. Play the promotion to the chosen piece
+    ChessMove move = FindLegalMove(game, MOVE_FROM(game->pendingPromotion), MOVE_TO(game->pendingPromotion), selectedType);
+    if (move == 0)
+    {
+        TraceLog(LOG_WARNING, "PromotePawn: cannot promote to piece type %d", selectedType);
+        return;
+    }
 
-    // NEW: Play sound for promotion moves
-    PlayGameSound(pendingMove);
+    game->promotionType = selectedType;
+    CommitMove(game, move);
 }
 
 /**
@@ -1535,91 +1035,11 @@ void PromotePawn(PieceType selectedType)
  * Checks if castling moves are geometrically possible (path clear, not attacked).
  *
  * Behavior:
- *  - Checks global castling rights flags (whiteKingSide, etc.).
- *  - Verifies that squares between King and Rook are empty.
- *  - Verifies that the King does not pass through or land on an attacked square.
- *  - Sets primaryValid on the King's destination square if valid.
+ *  - Marks the king destination of every available castle as primary-valid (see CastlingTargets).
  */
-void PrimaryCastlingValidation()
+void PrimaryCastlingValidation(GameState *game)
 {
-    // We use the GameState flags (whiteKingSide, etc.) which are persistent.
-    // This fixes the bug where moving a rook away and back would reset its 'hasMoved' status.
-
-    if (Turn == TEAM_WHITE)
-    {
-        // Check King is present and not in check
-        if (GameBoard[WHITE_BACK_RANK][KING_START_COL].piece.type == PIECE_KING && !Player1.Checked)
-        {
-            // Queen Side (Long Castling)
-            if (state.whiteQueenSide)
-            {
-                // Must be empty: b1, c1, d1
-                if (GameBoard[WHITE_BACK_RANK][1].piece.type == PIECE_NONE && /*This is the b1 square but We don't have macros that match it*/
-                    GameBoard[WHITE_BACK_RANK][CASTLE_QS_KING_COL].piece.type == PIECE_NONE &&
-                    GameBoard[WHITE_BACK_RANK][CASTLE_QS_ROOK_COL].piece.type == PIECE_NONE)
-                {
-                    // King moves from e1 to c1. Passes d1.
-                    if (!GameBoard[WHITE_BACK_RANK][CASTLE_QS_KING_COL].vulnerable &&
-                        !GameBoard[WHITE_BACK_RANK][CASTLE_QS_ROOK_COL].vulnerable)
-                    {
-                        GameBoard[WHITE_BACK_RANK][CASTLE_QS_KING_COL].primaryValid = true;
-                    }
-                }
-            }
-
-            // King Side (Short Castling)
-            if (state.whiteKingSide)
-            {
-                // Must be empty: f1, g1
-                if (GameBoard[WHITE_BACK_RANK][CASTLE_KS_ROOK_COL].piece.type == PIECE_NONE &&
-                    GameBoard[WHITE_BACK_RANK][CASTLE_KS_KING_COL].piece.type == PIECE_NONE)
-                {
-                    // King passes through f1, lands on g1.
-                    if (!GameBoard[WHITE_BACK_RANK][CASTLE_KS_ROOK_COL].vulnerable &&
-                        !GameBoard[WHITE_BACK_RANK][CASTLE_KS_KING_COL].vulnerable)
-                    {
-                        GameBoard[WHITE_BACK_RANK][CASTLE_KS_KING_COL].primaryValid = true;
-                    }
-                }
-            }
-        }
-    }
-    else // BLACK TEAM
-    {
-        if (GameBoard[BLACK_BACK_RANK][KING_START_COL].piece.type == PIECE_KING && !Player2.Checked)
-        {
-            // Queen Side
-            if (state.blackQueenSide)
-            {
-                // Must be empty: b8, c8, d8
-                if (GameBoard[BLACK_BACK_RANK][1].piece.type == PIECE_NONE &&
-                    GameBoard[BLACK_BACK_RANK][CASTLE_QS_KING_COL].piece.type == PIECE_NONE &&
-                    GameBoard[BLACK_BACK_RANK][CASTLE_QS_ROOK_COL].piece.type == PIECE_NONE)
-                {
-                    if (!GameBoard[BLACK_BACK_RANK][CASTLE_QS_KING_COL].vulnerable &&
-                        !GameBoard[BLACK_BACK_RANK][CASTLE_QS_ROOK_COL].vulnerable)
-                    {
-                        GameBoard[BLACK_BACK_RANK][CASTLE_QS_KING_COL].primaryValid = true;
-                    }
-                }
-            }
-
-            // King Side
-            if (state.blackKingSide)
-            {
-                // Must be empty: f8, g8
-                if (GameBoard[BLACK_BACK_RANK][CASTLE_KS_ROOK_COL].piece.type == PIECE_NONE &&
-                    GameBoard[BLACK_BACK_RANK][CASTLE_KS_KING_COL].piece.type == PIECE_NONE)
-                {
-                    if (!GameBoard[BLACK_BACK_RANK][CASTLE_KS_ROOK_COL].vulnerable &&
-                        !GameBoard[BLACK_BACK_RANK][CASTLE_KS_KING_COL].vulnerable)
-                    {
-                        GameBoard[BLACK_BACK_RANK][CASTLE_KS_KING_COL].primaryValid = true;
-                    }
-                }
-            }
-        }
-    }
+    game->primaryValidSquares |= CastlingTargets(game, game->turn);
 }
 
 /**
@@ -1631,586 +1051,293 @@ void PrimaryCastlingValidation()
  *  - row, col: Coordinates of the pawn attempting to capture.
  *
  * Behavior:
- *  - Checks if the pawn is on the correct rank (3 for White, 4 for Black).
- *  - Checks adjacent squares for an enemy pawn that just moved two squares.
- *  - Sets primaryValid on the destination square (behind the captured pawn).
+ *  - Marks the en passant target square (behind the enemy pawn that just moved two squares)
+ *    as primary-valid if the pawn at (row, col) attacks it (see EnPassantTarget).
  */
-void PrimaryEnpassantValidation(int row, int col)
+void PrimaryEnpassantValidation(GameState *game, int row, int col)
 {
-    if (Turn == TEAM_WHITE)
-    {
-        if (GameBoard[row][col].piece.type == PIECE_PAWN && row == 3)
-        {
-            // Check Right: Ensure col + 1 is within bounds
-            if (col + 1 < BOARD_SIZE &&
-                GameBoard[row][col + 1].JustMoved &&
-                GameBoard[row][col + 1].PawnMovedTwo)
-            {
-                GameBoard[row - 1][col + 1].primaryValid = true;
-            }
-
-            // Check Left: Ensure col - 1 is within bounds
-            if (col - 1 >= 0 &&
-                GameBoard[row][col - 1].JustMoved &&
-                GameBoard[row][col - 1].PawnMovedTwo)
-            {
-                GameBoard[row - 1][col - 1].primaryValid = true;
-            }
-        }
-    }
-    else
-    {
-        if (GameBoard[row][col].piece.type == PIECE_PAWN && row == 4)
-        {
-            // Check Right: Ensure col + 1 is within bounds
-            if (col + 1 < BOARD_SIZE &&
-                GameBoard[row][col + 1].JustMoved &&
-                GameBoard[row][col + 1].PawnMovedTwo)
-            {
-                GameBoard[row + 1][col + 1].primaryValid = true;
-            }
-
-            // Check Left: Ensure col - 1 is within bounds
-            if (col - 1 >= 0 &&
-                GameBoard[row][col - 1].JustMoved &&
-                GameBoard[row][col - 1].PawnMovedTwo)
-            {
-                GameBoard[row + 1][col - 1].primaryValid = true;
-            }
-        }
-    }
+    game->primaryValidSquares |= EnPassantTarget(game, SQUARE_INDEX(row, col), game->turn);
 }
 
 /**
  * CheckInsufficientMaterial
  *
- * Checks if the remaining pieces on the board are insufficient to force a checkmate.
- *
- * Scenarios detected:
- * 1. King vs King.
- * 2. King + Minor Piece (Bishop/Knight) vs King.
- * 3. King + Bishop vs King + Bishop (where both bishops are on the same color square).
+ * Checks if the remaining pieces on the board are insufficient to force a checkmate
+ * (see IsInsufficientMaterial in movegen.c for the scenarios detected).
  *
  * Side effects:
- *  - Sets state.isInsufficientMaterial to true if draw condition is met.
+ *  - Sets game->isInsufficientMaterial to true if draw condition is met.
  */
-void CheckInsufficientMaterial(void)
+void CheckInsufficientMaterial(GameState *game)
 {
-    int whiteMinorPieces = 0;
-    int blackMinorPieces = 0;
-
-    // Track bishops specifically for the K+B vs K+B scenario
-    int whiteBishops = 0;
-    int blackBishops = 0;
-    int whiteBishopSquareColor = -1; // 0 for light, 1 for dark
-    int blackBishopSquareColor = -1;
-
-    // Scan the board
-    for (int i = 0; i < BOARD_SIZE; i++)
-    {
-        for (int j = 0; j < BOARD_SIZE; j++)
-        {
-            PieceType type = GameBoard[i][j].piece.type;
-            Team team = GameBoard[i][j].piece.team;
-
-            if (type == PIECE_NONE)
-            {
-                continue;
-            }
-
-            // If there is a Queen, Rook, or Pawn, checkmate is possible.
-            if (type == PIECE_QUEEN || type == PIECE_ROOK || type == PIECE_PAWN)
-            {
-                state.isInsufficientMaterial = false;
-                return;
-            }
-
-            if (type == PIECE_KNIGHT || type == PIECE_BISHOP)
-            {
-                if (team == TEAM_WHITE)
-                {
-                    whiteMinorPieces++;
-                    if (type == PIECE_BISHOP)
-                    {
-                        whiteBishops++;
-                        // Determine square color: (row + col) % 2
-                        whiteBishopSquareColor = (i + j) % 2;
-                    }
-                }
-                else
-                {
-                    blackMinorPieces++;
-                    if (type == PIECE_BISHOP)
-                    {
-                        blackBishops++;
-                        blackBishopSquareColor = (i + j) % 2;
-                    }
-                }
-            }
-        }
-    }
+    game->isInsufficientMaterial = IsInsufficientMaterial(&game->bitboards);
+}
 
-    // SCENARIO 1: King vs King (No minor pieces)
-    if (whiteMinorPieces == 0 && blackMinorPieces == 0)
+/**
+ * UndoMove
+ *
+ * Reverts the last move made in the game.
+ *
+ * Behavior:
+ * - A pending promotion is cancelled instead (the pawn has not left its square yet).
+ * - Otherwise goes back one ply with JumpToPly (the move moves to the Redo stack) and
+ *   plays the move sound.
+ */
+void UndoMove(GameState *game)
+{
+    if (game->isPromoting)
     {
-        state.isInsufficientMaterial = true;
+        game->isPromoting = false;
+        game->promotionRow = -1;
+        game->promotionCol = -1;
         return;
     }
 
-    // SCENARIO 2: King + Minor vs King (One side has 1 minor, other has 0)
-    if ((whiteMinorPieces == 1 && blackMinorPieces == 0) ||
-        (whiteMinorPieces == 0 && blackMinorPieces == 1))
+    if (IsStackEmpty(game->undoStack))
     {
-        state.isInsufficientMaterial = true;
+        // The stack is empty so you can't undo
         return;
     }
 
-    // SCENARIO 3: King + Bishop vs King + Bishop (Same color)
-    // Conditions:
-    // 1. Each side has exactly 1 minor piece.
-    // 2. That minor piece is a Bishop.
-    // 3. Both bishops are on the same square color.
-    if (whiteMinorPieces == 1 && blackMinorPieces == 1 &&
-        whiteBishops == 1 && blackBishops == 1) // <--- FIX: Added "== 1"
-    {
-        if (whiteBishopSquareColor == blackBishopSquareColor)
-        {
-            state.isInsufficientMaterial = true;
-            return;
-        }
-    }
-    state.isInsufficientMaterial = false;
+    Move move = PeekStack(game->undoStack);
+    JumpToPly(game, StackSize(game->undoStack) - 1);
+
+    // NEW: Play move sound on Undo
+    PlayGameSound(game, move);
 }
 
 /**
- * RecordMove
- *
- * Creates a Move structure capturing all details of the current move.
- * Used for history tracking (Undo/Redo).
+ * RedoMove
  *
- * Parameters:
- *  - initialRow, initialCol: Source coordinates.
- *  - finalRow, finalCol: Destination coordinates.
+ * Re-applies a move that was previously undone.
  *
- * Returns:
- *  - A populated Move structure.
+ * Behavior:
+ * - Goes forward one ply with JumpToPly (the move returns to the Undo stack) and plays
+ *   the move sound.
  */
-Move RecordMove(int initialRow, int initialCol, int finalRow, int finalCol)
+void RedoMove(GameState *game)
 {
-    Move move;
-    move.initialRow = initialRow;
-    move.initialCol = initialCol;
-    move.finalRow = finalRow;
-    move.finalCol = finalCol;
-
-    move.pieceMovedType = state.board[initialRow][initialCol].piece.type;
-    move.pieceMovedTeam = state.board[initialRow][initialCol].piece.team;
-
-    move.pieceCapturedType = state.board[finalRow][finalCol].piece.type;
-
-    // The promotion piece type will be recorded in another place in the program
-    move.promotionType = PIECE_NONE;
-
-    if (move.pieceMovedType == PIECE_PAWN &&
-        initialCol != finalCol &&
-        GameBoard[finalRow][finalCol].piece.type == PIECE_NONE)
-    {
-        move.wasEnPassant = true;
-        move.pieceCapturedType = PIECE_PAWN;
-    }
-    else
-    {
-        move.wasEnPassant = false;
-    }
-
-    move.previousEnPassantCol = state.enPassantCol;
-
-    if (state.board[initialRow][initialCol].piece.type == PIECE_KING && abs(finalCol - initialCol) == 2)
-    {
-        move.wasCastling = true;
-    }
-    else
+    if (IsStackEmpty(game->redoStack))
     {
-        move.wasCastling = false;
+        return;
     }
 
-    move.whiteKingSide = state.whiteKingSide;
-    move.whiteQueenSide = state.whiteQueenSide;
-    move.blackKingSide = state.blackKingSide;
-    move.blackQueenSide = state.blackQueenSide;
+    Move move = PeekStack(game->redoStack);
+    JumpToPly(game, StackSize(game->undoStack) + 1);
 
-    move.halfMove = state.halfMoveClock;
+    PlayGameSound(game, move);
+}
 
-    return move;
+/**
+ * GameLength
+ *
+ * Returns the number of plies of the game line (Undo plus Redo stack); the board shows
+ * ply StackSize(game->undoStack) of it.
+ */
+size_t GameLength(GameState *game)
+{
+    return StackSize(game->undoStack) + StackSize(game->redoStack);
 }
 
 /**
- * UndoMove
+ * JumpToPly
  *
- * Reverts the last move made in the game.
+ * Show the position after the first ply moves of the game line.
+ *
+ * Parameters:
+ *  - ply: target ply, clamped to 0..GameLength().
  *
  * Behavior:
- * - Pops the last move from the Undo stack.
- * - Restores board state (pieces, captured pieces, castling rights, en passant).
- * - Pushes the undone move to the Redo stack.
- * - Updates game history (DHA) and visuals.
- * - Plays undo sound.
+ *  - Copies the nearest checkpoint at or before ply (game->snapshots) and replays the
+ *    remaining moves (fewer than HISTORY_SNAPSHOT_INTERVAL) with MakeMove on that copy.
+ *  - Moves the records between the Undo and Redo stacks so the Undo stack holds the
+ *    first ply moves, and writes the position back once with SetCurrentPosition (only
+ *    the changed cells are touched).
+ *  - Restores the dead-piece counters and the repetition history of the target ply (the
+ *    keys of the shared plies are kept, only the difference is popped or pushed), then
+ *    runs ResetsAndValidations once and highlights the last move played.
+ *  - A pending promotion is cancelled. Silent: Undo/Redo add the sound.
  */
-void UndoMove(void)
+void JumpToPly(GameState *game, size_t ply)
 {
-    Move move;
-
-    if (!PopStack(state.undoStack, &move))
+    size_t length = GameLength(game);
+    if (ply > length)
     {
-        // The stack is empty so you can't undo
-        return;
+        ply = length;
     }
 
-    // 1. Restore Global State Flags
-    // Note: We do NOT flip the Turn here manually, because ResetsAndValidations()
-    // at the end will flip it for us.
-
-    state.halfMoveClock = move.halfMove;
-
-    // If we are undoing a move that transitioned to Black, we decrement full moves
-    if (Turn == TEAM_BLACK)
+    size_t snapshotPly = 0;
+    const HistorySnapshot *snapshot = (game->snapshots != NULL) ? NearestSnapshot(game->snapshots, ply, &snapshotPly) : NULL;
+    if (snapshot == NULL)
     {
-        state.fullMoveNumber--;
+        TraceLog(LOG_WARNING, "JumpToPly: no history snapshot, ply %zu not restored", ply);
+        return;
     }
 
-    state.enPassantCol = move.previousEnPassantCol;
-
-    state.whiteKingSide = move.whiteKingSide;
-    state.whiteQueenSide = move.whiteQueenSide;
-    state.blackKingSide = move.blackKingSide;
-    state.blackQueenSide = move.blackQueenSide;
-
-    // Clear flags that might have been set by the "future" state
-    state.isStalemate = false;
-    state.isRepeated3times = false;
-    state.isInsufficientMaterial = false;
-    Checkmate = false;
-    Player1.Checkmated = false;
-    Player2.Checkmated = false;
-
-    // 2. Move the piece back
-    // This handles Un-Promotion automatically because move.pieceMovedType
-    // stores the original piece (PAWN), not the promoted one.
-    LoadPiece(move.initialRow, move.initialCol, move.pieceMovedType, move.pieceMovedTeam, GAME_BOARD);
-
-    // Clear the destination square (unless it was a capture, which we handle next)
-    SetEmptyCell(&GameBoard[move.finalRow][move.finalCol]);
-
-    // 3. Restore Captured Piece
-    if (move.pieceCapturedType != PIECE_NONE)
+    // 1. One snapshot copy plus the moves after it
+    Position position = snapshot->position;
+    int deadWhite = snapshot->deadWhite;
+    int deadBlack = snapshot->deadBlack;
+    for (size_t i = snapshotPly; i < ply; i++)
     {
-        Team capturedTeam = (move.pieceMovedTeam == TEAM_WHITE) ? TEAM_BLACK : TEAM_WHITE;
-
-        if (move.wasEnPassant)
-        {
-            // En Passant Special Case:
-            // The captured pawn was NOT at the destination (finalRow, finalCol).
-            // ! It was at (initialRow, finalCol).
-            LoadPiece(move.initialRow, move.finalCol, move.pieceCapturedType, capturedTeam, GAME_BOARD);
-        }
-        else
-        {
-            // Normal Capture:
-            // Put the captured piece back at the destination square.
-            LoadPiece(move.finalRow, move.finalCol, move.pieceCapturedType, capturedTeam, GAME_BOARD);
-        }
+        Move *record = LineMove(game, i);
+        MakeMove(&position, record->move, &record->undo);
 
-        if (capturedTeam == TEAM_WHITE && deadWhiteCounter > 0)
+        // The captured piece belongs to the side that is now to move
+        if (record->undo.captured != PIECE_NONE)
         {
-            deadWhiteCounter--;
-        }
-        if (capturedTeam == TEAM_BLACK && deadBlackCounter > 0)
-        {
-            deadBlackCounter--;
+            (position.side == TEAM_WHITE) ? deadWhite++ : deadBlack++;
         }
     }
 
-    // 4. Restore Castling (Move the Rook back) the king was handled by section 2 Move the piece back
-    if (move.wasCastling)
+    // 2. Split the line at ply
+    Move record;
+    while (StackSize(game->undoStack) > ply && PopStack(game->undoStack, &record))
     {
-        // White King Side
-        if (move.finalRow == WHITE_BACK_RANK && move.finalCol == CASTLE_KS_KING_COL)
-        {
-            // Move Rook from f1 back to h1
-            LoadPiece(WHITE_BACK_RANK, ROOK_KS_COL, PIECE_ROOK, TEAM_WHITE, GAME_BOARD);
-            SetEmptyCell(&GameBoard[WHITE_BACK_RANK][CASTLE_KS_ROOK_COL]);
-        }
-        // White Queen Side
-        else if (move.finalRow == WHITE_BACK_RANK && move.finalCol == CASTLE_QS_KING_COL)
-        {
-            // Move Rook from d1 back to a1
-            LoadPiece(WHITE_BACK_RANK, ROOK_QS_COL, PIECE_ROOK, TEAM_WHITE, GAME_BOARD);
-            SetEmptyCell(&GameBoard[WHITE_BACK_RANK][CASTLE_QS_ROOK_COL]);
-        }
-        // Black King Side
-        else if (move.finalRow == BLACK_BACK_RANK && move.finalCol == CASTLE_KS_KING_COL)
-        {
-            // Move Rook from f8 back to h8
-            LoadPiece(BLACK_BACK_RANK, ROOK_KS_COL, PIECE_ROOK, TEAM_BLACK, GAME_BOARD);
-            SetEmptyCell(&GameBoard[BLACK_BACK_RANK][CASTLE_KS_ROOK_COL]);
-        }
-        // Black Queen Side
-        else if (move.finalRow == BLACK_BACK_RANK && move.finalCol == CASTLE_QS_KING_COL)
-        {
-            // Move Rook from d8 back to a8
-            LoadPiece(BLACK_BACK_RANK, ROOK_QS_COL, PIECE_ROOK, TEAM_BLACK, GAME_BOARD);
-            SetEmptyCell(&GameBoard[BLACK_BACK_RANK][CASTLE_QS_ROOK_COL]);
-        }
+        PushStack(game->redoStack, record);
+    }
+    while (StackSize(game->undoStack) < ply && PopStack(game->redoStack, &record))
+    {
+        PushStack(game->undoStack, record);
     }
 
-    PopDHA(state.DHA); // It's safe to call this function even if the DHA is empty. anyways an empty DHA shouldn't be reachable here it should be caught at the beginning of the code if PopStack fails.
+    game->isPromoting = false;
+    game->promotionRow = -1;
+    game->promotionCol = -1;
 
-    // 6. Push the move we have just undone to the Redo stack
+    SetCurrentPosition(game, &position);
 
-    PushStack(state.redoStack, move);
+    // The dead-piece slots hold the captures in line order; only the counts change
+    game->deadWhiteCounter = (deadWhite < 2 * BOARD_SIZE) ? deadWhite : 2 * BOARD_SIZE;
+    game->deadBlackCounter = (deadBlack < 2 * BOARD_SIZE) ? deadBlack : 2 * BOARD_SIZE;
 
-    // When we undo, we restore the state where an En Passant capture might be possible.
-    // We must mark the specific pawn as having "JustMoved" and "PawnMovedTwo".
-    if (state.enPassantCol != -1) // It was EnPassant.
-    {
-        // If we undid a White move, it's White's turn, so the target is a Black pawn at row 3.
-        // If we undid a Black move, it's Black's turn, so the target is a White pawn at row 4.
-        int row = (move.pieceMovedTeam == TEAM_WHITE) ? 3 : 4;
+    // Clear flags that might have been set by another ply
+    game->isStalemate = false;
+    game->isRepeated3times = false;
+    game->isInsufficientMaterial = false;
+    game->isCheckmate = false;
+    game->whitePlayer.Checkmated = false;
+    game->blackPlayer.Checkmated = false;
 
-        // Ensure we are accessing valid bounds
-        if (row >= 0 && row < BOARD_SIZE && state.enPassantCol >= 0 && state.enPassantCol < BOARD_SIZE)
-        {
-            GameBoard[row][state.enPassantCol].JustMoved = true;
-            GameBoard[row][state.enPassantCol].PawnMovedTwo = true;
-        }
+    // 3. Repetition history: DHA[i] is the key after i plies of the line (before move i)
+    TruncateDHA(game->DHA, ply);
+    for (size_t i = game->DHA->size; i < ply; i++)
+    {
+        PushDHA(game->DHA, LineMove(game, i)->undo.key);
+    }
+    PushDHA(game->DHA, game->zobristKey);
+    if (IsRepeated3times(game->DHA, game->halfMoveClock))
+    {
+        game->isRepeated3times = true;
     }
 
-    // 7. Recalculate Valid Moves for the restored state
-    // This function flips the turn, scans enemy moves, and checks for check/mate.
-    ResetsAndValidations();
+    // 4. Rule checks of the target ply only
+    ResetsAndValidations(game);
 
-    // 8. Restore SmartBorders (Visuals)
-    // We need to highlight the move that is NOW at the top of the stack (the one before the undo).
-    if (state.undoStack->size > 0)
+    if (!game->isOnScreen)
     {
-        // Peek at the previous move without popping it
-        Move previousMove = state.undoStack->data[state.undoStack->size - 1];
+        return;
+    }
 
-        // Update the visual border to point to that move's destination
-        UpdateLastMoveHighlight(previousMove.finalRow, previousMove.finalCol);
+    if (ply > 0)
+    {
+        int to = MOVE_TO(LineMove(game, ply - 1)->move);
+        UpdateLastMoveHighlight(SQUARE_ROW(to), SQUARE_COL(to));
     }
     else
     {
-        // No moves left in history, clear the border
         UpdateLastMoveHighlight(-1, -1);
     }
 
     ResetSelectedPiece();
-
-    // NEW: Play move sound on Undo
-    PlayGameSound(move);
 }
 
 /**
- * RedoMove
+ * ReplayHistory
  *
- * Re-applies a move that was previously undone.
+ * Play a recorded game onto the freshly loaded start position (see LoadGameFromHistory).
+ *
+ * Parameters:
+ *  - moves: the game's moves, legal in sequence from the current position.
+ *  - count: number of moves.
+ *  - ply:   how many of them to play (0..count); the rest can be replayed with Redo.
  *
  * Behavior:
- * - Pops the move from the Redo stack.
- * - Re-executes the move on the board (including captures, castling, promotion).
- * - Pushes the move back to the Undo stack.
- * - Updates game history and visuals.
- * - Plays move sound.
+ *  - The whole game becomes the line (Redo stack first), then one pass of MakeMove over
+ *    a Position copy fills every record's UndoInfo, loads the captured pieces into the
+ *    dead-piece slots and records the checkpoints.
+ *  - JumpToPly then shows ply: the rule checks run once, on the position reached.
  */
-void RedoMove(void)
+void ReplayHistory(GameState *game, const ChessMove *moves, int count, int ply)
 {
-    Move move;
-
-    if (!PopStack(state.redoStack, &move))
+    ClearStack(game->undoStack);
+    ClearStack(game->redoStack);
+    ClearDHA(game->DHA); // the line starts at the current position (ply 0)
+    PushDHA(game->DHA, game->zobristKey);
+    for (int i = count - 1; i >= 0; i--)
     {
-        return;
+        PushStack(game->redoStack, (Move){.move = moves[i]});
     }
 
-    // 1. Push to Undo Stack
-    PushStack(state.undoStack, move);
-
-    // 2. Update Clocks
-    if (move.pieceMovedTeam == TEAM_BLACK)
+    Position position = CurrentPosition(game);
+    int deadWhite = 0;
+    int deadBlack = 0;
+    for (int i = 0; i < count; i++)
     {
-        state.fullMoveNumber++;
-    }
+        Move *record = LineMove(game, (size_t)i);
+        MakeMove(&position, record->move, &record->undo);
 
-    if (move.pieceMovedType == PIECE_PAWN || move.pieceCapturedType != PIECE_NONE)
-    {
-        state.halfMoveClock = 0;
-        ClearDHA(state.DHA);
-    }
-    else
-    {
-        state.halfMoveClock++;
-    }
-
-    // 3. Execute Move on Board
-    // If promotionType is set, use it. Otherwise use the original piece type.
-    PieceType typeToPlace = (move.promotionType != PIECE_NONE) ? move.promotionType : move.pieceMovedType;
-
-    LoadPiece(move.finalRow, move.finalCol, typeToPlace, move.pieceMovedTeam, GAME_BOARD);
-    GameBoard[move.finalRow][move.finalCol].piece.hasMoved = 1;
-    SetEmptyCell(&GameBoard[move.initialRow][move.initialCol]);
-
-    // 4. Handle Special Moves
-
-    // En Passant Capture
-    if (move.wasEnPassant)
-    {
-        SetEmptyCell(&GameBoard[move.initialRow][move.finalCol]); // ! see a note in this weird thing in UndoMove
-    }
-
-    // Castling (Move the Rook)  the king was handled by section 3
-    if (move.wasCastling)
-    {
-        if (move.pieceMovedTeam == TEAM_WHITE)
-        {
-            if (move.finalCol == CASTLE_KS_KING_COL) // KS
-            {
-                LoadPiece(WHITE_BACK_RANK, CASTLE_KS_ROOK_COL, PIECE_ROOK, TEAM_WHITE, GAME_BOARD);
-                SetEmptyCell(&GameBoard[WHITE_BACK_RANK][ROOK_KS_COL]);
-            }
-            else // QS
-            {
-                LoadPiece(WHITE_BACK_RANK, CASTLE_QS_ROOK_COL, PIECE_ROOK, TEAM_WHITE, GAME_BOARD);
-                SetEmptyCell(&GameBoard[WHITE_BACK_RANK][ROOK_QS_COL]);
-            }
-        }
-        else
+        if (record->undo.captured != PIECE_NONE)
         {
-            if (move.finalCol == CASTLE_KS_KING_COL) // KS
+            if (position.side == TEAM_WHITE)
             {
-                LoadPiece(BLACK_BACK_RANK, CASTLE_KS_ROOK_COL, PIECE_ROOK, TEAM_BLACK, GAME_BOARD);
-                SetEmptyCell(&GameBoard[BLACK_BACK_RANK][ROOK_KS_COL]);
+                LoadDeadPiece(game, &deadWhite, record->undo.captured, TEAM_WHITE);
             }
-            else // QS
+            else
             {
-                LoadPiece(BLACK_BACK_RANK, CASTLE_QS_ROOK_COL, PIECE_ROOK, TEAM_BLACK, GAME_BOARD);
-                SetEmptyCell(&GameBoard[BLACK_BACK_RANK][ROOK_QS_COL]);
+                LoadDeadPiece(game, &deadBlack, record->undo.captured, TEAM_BLACK);
             }
         }
-    }
 
-    // 5. Update Castling Rights
-    // If King moved
-    if (move.pieceMovedType == PIECE_KING)
-    {
-        if (move.pieceMovedTeam == TEAM_WHITE)
+        if (game->snapshots != NULL)
         {
-            state.whiteKingSide = false;
-            state.whiteQueenSide = false;
-        }
-        else
-        {
-            state.blackKingSide = false;
-            state.blackQueenSide = false;
-        }
-    }
-    // If Rook moved
-    if (move.pieceMovedType == PIECE_ROOK)
-    {
-        if (move.pieceMovedTeam == TEAM_WHITE)
-        {
-            if (move.initialRow == WHITE_BACK_RANK && move.initialCol == ROOK_QS_COL)
-            {
-                state.whiteQueenSide = false;
-            }
-            if (move.initialRow == WHITE_BACK_RANK && move.initialCol == ROOK_KS_COL)
-            {
-                state.whiteKingSide = false;
-            }
-        }
-        else
-        {
-            if (move.initialRow == BLACK_BACK_RANK && move.initialCol == ROOK_QS_COL)
-            {
-                state.blackQueenSide = false;
-            }
-            if (move.initialRow == BLACK_BACK_RANK && move.initialCol == ROOK_KS_COL)
-            {
-                state.blackKingSide = false;
-            }
-        }
-    }
-    // If Rook captured
-    if (move.pieceCapturedType == PIECE_ROOK)
-    {
-        if (move.pieceMovedTeam == TEAM_WHITE) // White captured Black Rook
-        {
-            if (move.finalRow == BLACK_BACK_RANK && move.finalCol == ROOK_QS_COL)
-            {
-                state.blackQueenSide = false;
-            }
-            if (move.finalRow == BLACK_BACK_RANK && move.finalCol == ROOK_KS_COL)
-            {
-                state.blackKingSide = false;
-            }
-        }
-        else // Black captured White Rook
-        {
-            if (move.finalRow == WHITE_BACK_RANK && move.finalCol == ROOK_QS_COL)
-            {
-                state.whiteQueenSide = false;
-            }
-            if (move.finalRow == WHITE_BACK_RANK && move.finalCol == ROOK_KS_COL)
-            {
-                state.whiteKingSide = false;
-            }
+            RecordSnapshot(game->snapshots, (size_t)i + 1, &position, deadWhite, deadBlack);
         }
     }
 
-    // 6. Update En Passant Flag
-    state.enPassantCol = -1;
-    if (move.pieceMovedType == PIECE_PAWN && abs(move.finalRow - move.initialRow) == 2)
-    {
-        state.enPassantCol = move.finalCol;
-        GameBoard[move.finalRow][move.finalCol].PawnMovedTwo = true;
-    }
+    JumpToPly(game, (size_t)((ply < 0) ? 0 : ply));
+}
 
-    // 7. Dead Pieces
-    if (move.pieceCapturedType != PIECE_NONE)
+/**
+ * LineMove (static)
+ *
+ * Returns the record of the move played at ply (0-based) of the game line: the Undo
+ * stack holds plies 0..size-1, the Redo stack the following ones from its top down.
+ * ply must be below GameLength().
+ */
+static Move *LineMove(GameState *game, size_t ply)
+{
+    size_t played = StackSize(game->undoStack);
+
+    if (ply < played)
     {
-        if (move.pieceMovedTeam == TEAM_WHITE)
-        {
-            if (deadBlackCounter < (BOARD_SIZE * 2))
-            {
-                LoadPiece(deadBlackCounter++, 1, move.pieceCapturedType, TEAM_BLACK, DEAD_BLACK_PIECES);
-            }
-        }
-        else
-        {
-            if (deadWhiteCounter < (BOARD_SIZE * 2))
-            {
-                LoadPiece(deadWhiteCounter++, 1, move.pieceCapturedType, TEAM_WHITE, DEAD_WHITE_PIECES);
-            }
-        }
+        return &game->undoStack->data[ply];
     }
 
-    // 8. History & Validation
-    ResetsAndValidations();
+    return &game->redoStack->data[StackSize(game->redoStack) - 1 - (ply - played)];
+}
 
-    Hash currentHash = CurrentGameStateHash();
-    if (state.halfMoveClock > 0)
+/**
+ * LoadDeadPiece (static)
+ *
+ * Put a captured piece into the next dead-piece slot of its team (*counter counts the
+ * slots used so far; captures past the last slot are counted but not shown).
+ */
+static void LoadDeadPiece(GameState *game, int *counter, PieceType type, Team team)
+{
+    if (*counter < 2 * BOARD_SIZE)
     {
-        if (IsRepeated3times(state.DHA, currentHash))
-        {
-            state.isRepeated3times = true;
-        }
+        LoadPiece(game, *counter, 1, type, team, (team == TEAM_WHITE) ? DEAD_WHITE_PIECES : DEAD_BLACK_PIECES);
     }
-
-    PushDHA(state.DHA, currentHash);
-
-    // 9. Visuals
-    UpdateLastMoveHighlight(move.finalRow, move.finalCol);
-
-    // 10. Play Sounds
-
-    PlayGameSound(move);
+    (*counter)++;
 }
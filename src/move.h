@@ -3,102 +3,115 @@
  *
  * Responsibilities:
  * - Export functions for moving pieces, validating moves, and managing game state.
- * - Includes prototypes for move execution, validation, simulation, and undo/redo.
+ * - Includes prototypes for move execution, validation, and undo/redo.
+ * - Export the board setup helpers (LoadPiece, InitializeBoard, InitializeDeadPieces,
+ *   UnloadBoard).
+ * - Every function works on the GameState it is passed, so any number of games can be
+ *   played side by side; the GUI passes &state.
  */
 
 #ifndef MOVE_H
 #define MOVE_H
 
 #include "main.h"
+#include "position.h"
+#include <stddef.h>
 
-/* Executes a move on the board, handling captures and special rules */
-void MovePiece(int initialRow, int initialCol, int finalRow, int finalCol);
+typedef enum LoadPlace
+{
+    GAME_BOARD = 0,
+    DEAD_WHITE_PIECES,
+    DEAD_BLACK_PIECES,
+} LoadPlace;
 
-/* Clears a cell and unloads its texture */
-void SetEmptyCell(Cell *cell);
+/* Place a piece in cell (row,col) of the selected LoadPlace (sprites come from atlas.c at draw time) */
+void LoadPiece(GameState *game, int row, int col, PieceType type, Team team, LoadPlace place);
 
-/* Computes raw geometric moves for a piece (primary validation) */
-void PrimaryValidation(PieceType Piece, int CellX, int CellY, bool selected);
+/* Initialize the chess board to have appropriate starting values */
+void InitializeBoard(GameState *game);
 
-/* Helper for geometric validation of specific piece types */
-void MoveValidation(int CellX, int CellY, PieceType type, Team team, bool moved);
+/* Initialize the DeadPieces to have appropriate starting values */
+void InitializeDeadPieces(GameState *game);
 
-/* Filters primary moves to ensure they don't leave the King in check */
-void FinalValidation(int CellX, int CellY, bool selected);
+/* Run after the game finishes or you want a new game to prevent memory leaks and flush the board */
+void UnloadBoard(GameState *game);
 
-/* Scans all enemy pieces to mark squares they attack (vulnerable) */
-void ScanEnemyMoves();
+/* Plays a legal move through the core MakeMove and records it (promotions wait for PromotePawn) */
+void MovePiece(GameState *game, int initialRow, int initialCol, int finalRow, int finalCol);
 
-/* Checks if the current player's King is under attack */
-void CheckValidation();
+/* Clears a cell (and removes its piece from the bitboards and Zobrist key) */
+void SetEmptyCell(GameState *game, Cell *cell);
 
-/* Checks if a simulated move results in the King being under attack */
-void SimCheckValidation();
+/* Computes raw geometric moves for a piece (primary validation) */
+void PrimaryValidation(GameState *game, PieceType Piece, int CellX, int CellY, bool selected);
 
-/* Resets the 'isvalid' flag for all cells */
-void ResetValidation();
+/* Marks the geometric targets of a piece of the side to move */
+void MoveValidation(GameState *game, int CellX, int CellY, PieceType type, Team team);
 
-/* Resets the 'vulnerable' flag for all cells */
-void ResetVulnerable();
+/* Marks the legal moves (game->validSquares) of a piece from the cached legal move list */
+void FinalValidation(GameState *game, int CellX, int CellY, bool selected);
 
-/* Helper for sliding pieces (Rook, Bishop, Queen) */
-bool HandleLinearSquare(int row, int col, Team team);
+/* Returns true if the cached legal moves contain (fromRow,fromCol) -> (toRow,toCol) */
+bool IsLegalDestination(GameState *game, int fromRow, int fromCol, int toRow, int toCol);
 
-/* Helper for Pawn movement logic */
-void HandlePawnMove(int CellX, int CellY, Team team, bool moved);
+/* Updates game->attacks after the squares in changed were modified on game->bitboards */
+void RefreshAttackMap(GameState *game, Bitboard changed);
 
-/* Helper for Knight movement logic (single square) */
-void HandleKnightSquare(int row, int col, Team team);
+/* Returns true if the opponent of the side to move attacks (row,col) (reads game->attacks) */
+bool IsSquareVulnerable(GameState *game, int row, int col);
 
-/* Helper for Knight movement logic (all 8 squares) */
-void HandleKnightMove(int CellX, int CellY, Team team);
+/* Checks if the current player's King is under attack */
+void CheckValidation(GameState *game);
 
-/* Helper for King movement logic */
-void HandleKingMove(int CellX, int CellY, Team team);
+/* Clears game->validSquares */
+void ResetValidation(GameState *game);
 
-/* Simulates a move on the board (without graphics/sound) */
-void MoveSimulation(int CellX1, int CellY1, int CellX2, int CellY2, PieceType piece);
+/* Returns true if a player has no legal move (mate or stalemate) */
+bool CheckmateFlagCheck(GameState *game, Team playerTeam);
 
-/* Reverts a simulated move */
-void UndoSimulation(int CellX1, int CellY1, int CellX2, int CellY2, PieceType piece1, PieceType piece2, Team team2);
+/* Snapshot of the game state as a Position for the rule code (movegen.h) */
+Position CurrentPosition(GameState *game);
 
-/* Checks if a player has any legal moves to escape check */
-bool CheckmateFlagCheck(Team playerTeam);
+/* Writes a Position back into the game state (bitboards, cells, turn, rights, clocks, key) */
+void SetCurrentPosition(GameState *game, const Position *position);
 
 /* Validates if the game is in Checkmate */
-void CheckmateValidation();
+void CheckmateValidation(GameState *game);
 
 /* Validates if the game is in Stalemate */
-void StalemateValidation();
+void StalemateValidation(GameState *game);
 
 /* Scans all friendly pieces (unused) */
-void ScanFriendlyMoves();
-
-/* Resets the 'primaryValid' flag for all cells */
-void ResetPrimaryValidation();
+void ScanFriendlyMoves(GameState *game);
 
-/* Central routine to update game state after a move (turn flip, checks, etc.) */
-void ResetsAndValidations();
+/* Clears game->primaryValidSquares */
+void ResetPrimaryValidation(GameState *game);
 
-/* Resets the 'hasMoved' flag for all pieces */
-void ResetMovedStatus();
+/* Central routine to update game state after the position changed (legal moves, checks, etc.) */
+void ResetsAndValidations(GameState *game);
 
 /* Promotes a pawn to the selected piece type */
-void PromotePawn(PieceType selectedType);
+void PromotePawn(GameState *game, PieceType selectedType);
 
 /* Validates Castling moves */
-void PrimaryCastlingValidation();
+void PrimaryCastlingValidation(GameState *game);
 
 /* Validates En Passant moves */
-void PrimaryEnpassantValidation(int row, int col);
-
-/* Resets the 'JustMoved' flag (used for En Passant) */
-void ResetJustMoved();
+void PrimaryEnpassantValidation(GameState *game, int row, int col);
 
 /* Undoes the last move */
-void UndoMove(void);
+void UndoMove(GameState *game);
 
 /*Redo the last move*/
-void RedoMove(void);
+void RedoMove(GameState *game);
+
+/* Number of plies of the game line (Undo plus Redo stack) */
+size_t GameLength(GameState *game);
+
+/* Shows the position after ply moves of the game line (one checkpoint copy plus a few replays, one validation) */
+void JumpToPly(GameState *game, size_t ply);
+
+/* Plays the first ply of count recorded moves from the current position; the rest go to the Redo stack */
+void ReplayHistory(GameState *game, const ChessMove *moves, int count, int ply);
 
 #endif
\ No newline at end of file
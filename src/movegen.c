@@ -0,0 +1,417 @@
+/**
+ * movegen.c
+ *
+ * Responsibilities:
+ * - Generate the legal moves of a Position into a MoveList.
+ *
+ * Implementation Details:
+ * - Everything that makes a move illegal is computed once per position instead of
+ *   simulating each candidate:
+ *     - king danger: squares attacked by the enemy with our king removed from the
+ *       occupancy (so the king cannot step back along a slider's ray);
+ *     - checkers: enemy pieces attacking our king;
+ *     - check mask: squares a non-king move must land on (checker + blocking squares);
+ *     - pins: friendly pieces between our king and an enemy slider, each with the ray
+ *       it is allowed to move along.
+ * - En passant is the one case these masks cannot express (two pieces leave the same
+ *   rank at once), so it is verified with a slider lookup on the resulting occupancy.
+ */
+
+#include "movegen.h"
+#include "bitboard.h"
+#include "piece.h"
+#include "position.h"
+#include "settings.h"
+#include "zobrist.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+// Local prototypes
+static void AddMove(MoveList *list, int from, int to, MoveFlag flag);
+static void AddPawnMoves(MoveList *list, int from, Bitboard targets, Bitboard enemies, Team us);
+static Bitboard KingDanger(const Bitboards *bb, Team them, Bitboard occupied);
+static void AddEnPassant(const Position *pos, MoveList *list, int king, Bitboard checkers, Bitboard checkMask);
+static void AddCastling(const Position *pos, MoveList *list, int king, Bitboard danger);
+
+/**
+ * GenerateLegalMoves
+ *
+ * Parameters:
+ *  - pos:  position to generate for (pos->side moves).
+ *  - list: output; overwritten.
+ *
+ * Returns:
+ *  - Number of legal moves (0 means checkmate or stalemate).
+ *
+ * Notes:
+ *  - Positions without a king for the side to move (hand-made FEN strings) are accepted;
+ *    there is then nothing to protect, so every pseudo-legal move is emitted.
+ */
+int GenerateLegalMoves(const Position *pos, MoveList *list)
+{
+    const Bitboards *bb = &pos->bitboards;
+    Team us = pos->side;
+    Team them = (us == TEAM_WHITE) ? TEAM_BLACK : TEAM_WHITE;
+    Bitboard friends = bb->teams[us];
+    Bitboard enemies = bb->teams[them];
+    Bitboard occupied = bb->occupied;
+    int king = KingSquare(bb, us);
+
+    Bitboard checkers = 0;
+    Bitboard checkMask = ~(Bitboard)0;
+    Bitboard pinned = 0;
+    Bitboard pinRays[SQUARE_COUNT];
+    Bitboard danger = 0;
+
+    list->count = 0;
+
+    if (king != -1)
+    {
+        danger = KingDanger(bb, them, occupied & ~SQUARE_BIT(king));
+        checkers = AttackersTo(bb, king, occupied) & enemies;
+
+        Bitboard kingTargets = KingAttackTable[king] & ~friends & ~danger;
+        while (kingTargets)
+        {
+            int to = PopLowestSquare(&kingTargets);
+            AddMove(list, king, to, (enemies & SQUARE_BIT(to)) ? MOVE_CAPTURE : MOVE_QUIET);
+        }
+
+        // Double check: only the king can move
+        if (BitCount(checkers) > 1)
+        {
+            return list->count;
+        }
+
+        if (checkers)
+        {
+            int checker = LowestSquare(checkers);
+            checkMask = BetweenTable[king][checker] | checkers;
+        }
+
+        // An enemy slider that would see our king through exactly one friendly piece pins it
+        Bitboard snipers = (RookAttacks(king, enemies) & (bb->pieces[them][PIECE_ROOK] | bb->pieces[them][PIECE_QUEEN])) |
+                           (BishopAttacks(king, enemies) & (bb->pieces[them][PIECE_BISHOP] | bb->pieces[them][PIECE_QUEEN]));
+        while (snipers)
+        {
+            int sniper = PopLowestSquare(&snipers);
+            Bitboard blockers = BetweenTable[king][sniper] & occupied;
+
+            if (BitCount(blockers) == 1 && (blockers & friends))
+            {
+                pinned |= blockers;
+                pinRays[LowestSquare(blockers)] = BetweenTable[king][sniper] | SQUARE_BIT(sniper);
+            }
+        }
+    }
+
+    for (int type = PIECE_QUEEN; type < PIECE_TYPE_COUNT; type++)
+    {
+        Bitboard pieces = bb->pieces[us][type];
+        while (pieces)
+        {
+            int from = PopLowestSquare(&pieces);
+            Bitboard targets = PieceTargets(bb, from, (PieceType)type, us) & checkMask;
+
+            if (pinned & SQUARE_BIT(from))
+            {
+                targets &= pinRays[from];
+            }
+
+            if (type == PIECE_PAWN)
+            {
+                AddPawnMoves(list, from, targets, enemies, us);
+                continue;
+            }
+
+            while (targets)
+            {
+                int to = PopLowestSquare(&targets);
+                AddMove(list, from, to, (enemies & SQUARE_BIT(to)) ? MOVE_CAPTURE : MOVE_QUIET);
+            }
+        }
+    }
+
+    AddEnPassant(pos, list, king, checkers, checkMask);
+
+    if (king != -1 && !checkers)
+    {
+        AddCastling(pos, list, king, danger);
+    }
+
+    return list->count;
+}
+
+/**
+ * BuildLegalMoveCache
+ *
+ * Generate the legal moves of pos and regroup them by source square (counting sort).
+ *
+ * Parameters:
+ *  - pos:   position to generate for.
+ *  - cache: output; fully overwritten.
+ */
+void BuildLegalMoveCache(const Position *pos, LegalMoveCache *cache)
+{
+    MoveList moves;
+    uint16_t next[SQUARE_COUNT];
+    int count = GenerateLegalMoves(pos, &moves);
+
+    memset(cache->start, 0, sizeof(cache->start));
+    memset(cache->targets, 0, sizeof(cache->targets));
+
+    for (int i = 0; i < count; i++)
+    {
+        cache->start[MOVE_FROM(moves.moves[i]) + 1]++;
+        cache->targets[MOVE_FROM(moves.moves[i])] |= SQUARE_BIT(MOVE_TO(moves.moves[i]));
+    }
+
+    for (int square = 0; square < SQUARE_COUNT; square++)
+    {
+        cache->start[square + 1] += cache->start[square];
+        next[square] = cache->start[square];
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        cache->list.moves[next[MOVE_FROM(moves.moves[i])]++] = moves.moves[i];
+    }
+
+    cache->list.count = count;
+}
+
+/**
+ * IsInCheck
+ *
+ * Returns true if the king of the side to move is attacked.
+ */
+bool IsInCheck(const Position *pos)
+{
+    int king = KingSquare(&pos->bitboards, pos->side);
+    return king != -1 && IsSquareAttacked(&pos->bitboards, king, (pos->side == TEAM_WHITE) ? TEAM_BLACK : TEAM_WHITE);
+}
+
+/**
+ * IsInsufficientMaterial
+ *
+ * Checks if the remaining pieces are insufficient for either side to force a checkmate.
+ *
+ * Scenarios detected:
+ * 1. King vs King.
+ * 2. King + Minor Piece (Bishop/Knight) vs King.
+ * 3. King + Bishop vs King + Bishop (where both bishops are on the same color square).
+ */
+bool IsInsufficientMaterial(const Bitboards *bb)
+{
+    // If there is a Queen, Rook, or Pawn, checkmate is possible.
+    for (int team = TEAM_WHITE; team < TEAM_COUNT; team++)
+    {
+        if (bb->pieces[team][PIECE_QUEEN] | bb->pieces[team][PIECE_ROOK] | bb->pieces[team][PIECE_PAWN])
+        {
+            return false;
+        }
+    }
+
+    Bitboard whiteBishops = bb->pieces[TEAM_WHITE][PIECE_BISHOP];
+    Bitboard blackBishops = bb->pieces[TEAM_BLACK][PIECE_BISHOP];
+    int whiteMinorPieces = BitCount(whiteBishops | bb->pieces[TEAM_WHITE][PIECE_KNIGHT]);
+    int blackMinorPieces = BitCount(blackBishops | bb->pieces[TEAM_BLACK][PIECE_KNIGHT]);
+
+    // SCENARIO 1 and 2: King vs King, or King + Minor vs King
+    if (whiteMinorPieces + blackMinorPieces <= 1)
+    {
+        return true;
+    }
+
+    // SCENARIO 3: King + Bishop vs King + Bishop (Same color)
+    // Each side has exactly 1 minor piece, that piece is a Bishop, and both stand on the same square color.
+    if (whiteMinorPieces == 1 && blackMinorPieces == 1 && whiteBishops && blackBishops)
+    {
+        bool whiteOnDark = (DARK_SQUARES & whiteBishops) != 0;
+        bool blackOnDark = (DARK_SQUARES & blackBishops) != 0;
+        return whiteOnDark == blackOnDark;
+    }
+
+    return false;
+}
+
+/**
+ * MovePromotionType
+ *
+ * Decode the promotion piece of a move.
+ *
+ * Returns:
+ *  - PIECE_KNIGHT/BISHOP/ROOK/QUEEN for promotions, PIECE_NONE otherwise.
+ */
+PieceType MovePromotionType(ChessMove move)
+{
+    if (!MOVE_IS_PROMOTION(move))
+    {
+        return PIECE_NONE;
+    }
+
+    static const PieceType promotions[4] = {PIECE_KNIGHT, PIECE_BISHOP, PIECE_ROOK, PIECE_QUEEN};
+    return promotions[MOVE_FLAG(move) & 3];
+}
+
+/**
+ * AddMove (static)
+ *
+ * Append one encoded move to the list.
+ */
+static void AddMove(MoveList *list, int from, int to, MoveFlag flag)
+{
+    list->moves[list->count++] = ENCODE_MOVE(from, to, flag);
+}
+
+/**
+ * AddPawnMoves (static)
+ *
+ * Emit the pawn moves to the (already legal) target squares, expanding promotions
+ * into the four piece choices and tagging double pushes.
+ */
+static void AddPawnMoves(MoveList *list, int from, Bitboard targets, Bitboard enemies, Team us)
+{
+    int promotionRow = (us == TEAM_WHITE) ? 0 : BOARD_SIZE - 1;
+
+    while (targets)
+    {
+        int to = PopLowestSquare(&targets);
+        int capture = (enemies & SQUARE_BIT(to)) ? MOVE_FLAG_CAPTURE_BIT : 0;
+
+        if (SQUARE_ROW(to) == promotionRow)
+        {
+            for (int flag = MOVE_PROMOTE_KNIGHT; flag <= MOVE_PROMOTE_QUEEN; flag++)
+            {
+                AddMove(list, from, to, (MoveFlag)(flag | capture));
+            }
+        }
+        else if (capture)
+        {
+            AddMove(list, from, to, MOVE_CAPTURE);
+        }
+        else
+        {
+            int distance = SQUARE_ROW(to) - SQUARE_ROW(from);
+            AddMove(list, from, to, (distance == 2 || distance == -2) ? MOVE_DOUBLE_PUSH : MOVE_QUIET);
+        }
+    }
+}
+
+/**
+ * KingDanger (static)
+ *
+ * Every square attacked by them, using the given occupancy (our king removed).
+ */
+static Bitboard KingDanger(const Bitboards *bb, Team them, Bitboard occupied)
+{
+    Bitboard attacks = 0;
+
+    for (int type = PIECE_KING; type < PIECE_TYPE_COUNT; type++)
+    {
+        Bitboard pieces = bb->pieces[them][type];
+        while (pieces)
+        {
+            attacks |= PieceAttacks((PieceType)type, them, PopLowestSquare(&pieces), occupied);
+        }
+    }
+
+    return attacks;
+}
+
+/**
+ * AddEnPassant (static)
+ *
+ * Emit the en passant captures available on pos->enPassantCol.
+ *
+ * Behavior:
+ *  - When in check, the capture must either remove the checking pawn or block the check.
+ *  - The capture is tried on the resulting occupancy: if an enemy rook, bishop or queen
+ *    then sees our king, it is illegal (this covers both the diagonal pin of the capturing
+ *    pawn and the rank pin where both pawns leave the king's rank together).
+ */
+static void AddEnPassant(const Position *pos, MoveList *list, int king, Bitboard checkers, Bitboard checkMask)
+{
+    if (pos->enPassantCol < 0 || pos->enPassantCol >= BOARD_SIZE)
+    {
+        return;
+    }
+
+    const Bitboards *bb = &pos->bitboards;
+    Team us = pos->side;
+    Team them = (us == TEAM_WHITE) ? TEAM_BLACK : TEAM_WHITE;
+    int target = SQUARE_INDEX((us == TEAM_WHITE) ? 2 : 5, pos->enPassantCol);
+    int victim = SQUARE_INDEX((us == TEAM_WHITE) ? 3 : 4, pos->enPassantCol);
+
+    if (!(bb->pieces[them][PIECE_PAWN] & SQUARE_BIT(victim)) || (bb->occupied & SQUARE_BIT(target)))
+    {
+        return;
+    }
+
+    if (checkers && !(checkers & SQUARE_BIT(victim)) && !(checkMask & SQUARE_BIT(target)))
+    {
+        return;
+    }
+
+    Bitboard rookLike = bb->pieces[them][PIECE_ROOK] | bb->pieces[them][PIECE_QUEEN];
+    Bitboard bishopLike = bb->pieces[them][PIECE_BISHOP] | bb->pieces[them][PIECE_QUEEN];
+    Bitboard capturers = PawnAttackTable[them][target] & bb->pieces[us][PIECE_PAWN];
+
+    while (capturers)
+    {
+        int from = PopLowestSquare(&capturers);
+        Bitboard occupied = (bb->occupied ^ SQUARE_BIT(from) ^ SQUARE_BIT(victim)) | SQUARE_BIT(target);
+
+        if (king != -1 && ((RookAttacks(king, occupied) & rookLike) || (BishopAttacks(king, occupied) & bishopLike)))
+        {
+            continue;
+        }
+
+        AddMove(list, from, target, MOVE_EN_PASSANT);
+    }
+}
+
+/**
+ * AddCastling (static)
+ *
+ * Emit the castling moves allowed by pos->castlingRights.
+ *
+ * Conditions checked for each side (the caller guarantees we are not in check):
+ *  - The right is still set and king and rook stand on their starting squares.
+ *  - The squares between them are empty.
+ *  - The king does not pass through or land on an attacked square.
+ */
+static void AddCastling(const Position *pos, MoveList *list, int king, Bitboard danger)
+{
+    const Bitboards *bb = &pos->bitboards;
+    Team us = pos->side;
+    int rank = (us == TEAM_WHITE) ? WHITE_BACK_RANK : BLACK_BACK_RANK;
+    int kingSideRight = (us == TEAM_WHITE) ? CASTLE_WHITE_KING_SIDE : CASTLE_BLACK_KING_SIDE;
+    int queenSideRight = (us == TEAM_WHITE) ? CASTLE_WHITE_QUEEN_SIDE : CASTLE_BLACK_QUEEN_SIDE;
+    Bitboard rooks = bb->pieces[us][PIECE_ROOK];
+
+    if (king != SQUARE_INDEX(rank, KING_START_COL))
+    {
+        return;
+    }
+
+    if ((pos->castlingRights & kingSideRight) && (rooks & SQUARE_BIT(SQUARE_INDEX(rank, ROOK_KS_COL))))
+    {
+        Bitboard path = SQUARE_BIT(SQUARE_INDEX(rank, CASTLE_KS_ROOK_COL)) | SQUARE_BIT(SQUARE_INDEX(rank, CASTLE_KS_KING_COL));
+        if (!(bb->occupied & path) && !(danger & path))
+        {
+            AddMove(list, king, SQUARE_INDEX(rank, CASTLE_KS_KING_COL), MOVE_CASTLE_KING_SIDE);
+        }
+    }
+
+    if ((pos->castlingRights & queenSideRight) && (rooks & SQUARE_BIT(SQUARE_INDEX(rank, ROOK_QS_COL))))
+    {
+        Bitboard path = BetweenTable[king][SQUARE_INDEX(rank, ROOK_QS_COL)];
+        Bitboard kingPath = SQUARE_BIT(SQUARE_INDEX(rank, CASTLE_QS_ROOK_COL)) | SQUARE_BIT(SQUARE_INDEX(rank, CASTLE_QS_KING_COL));
+        if (!(bb->occupied & path) && !(danger & kingPath))
+        {
+            AddMove(list, king, SQUARE_INDEX(rank, CASTLE_QS_KING_COL), MOVE_CASTLE_QUEEN_SIDE);
+        }
+    }
+}
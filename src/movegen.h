@@ -0,0 +1,106 @@
+/**
+ * movegen.h
+ *
+ * Responsibilities:
+ * - Define the compact move encoding and the fixed-capacity MoveList.
+ * - Export the legal move generator.
+ *
+ * Move encoding (16 bits):
+ *   bits  0-5  : from square (0..63, a8 = 0)
+ *   bits  6-11 : to square
+ *   bits 12-15 : MoveFlag
+ *
+ * Notes:
+ * - Only legal moves are emitted, so callers never have to test for self-check.
+ * - This module does not include raylib.
+ */
+
+#ifndef MOVEGEN_H
+#define MOVEGEN_H
+
+#include "bitboard.h"
+#include "piece.h"
+#include "position.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/* No legal chess position has more than 218 moves */
+#define MAX_MOVES 256
+
+typedef uint16_t ChessMove;
+
+/* MoveFlag
+ * - Bit 2 marks captures, bit 3 marks promotions; the low two bits of a promotion
+ *   select the piece (knight, bishop, rook, queen).
+ */
+typedef enum
+{
+    MOVE_QUIET = 0,
+    MOVE_DOUBLE_PUSH = 1,
+    MOVE_CASTLE_KING_SIDE = 2,
+    MOVE_CASTLE_QUEEN_SIDE = 3,
+    MOVE_CAPTURE = 4,
+    MOVE_EN_PASSANT = 5,
+    MOVE_PROMOTE_KNIGHT = 8,
+    MOVE_PROMOTE_BISHOP = 9,
+    MOVE_PROMOTE_ROOK = 10,
+    MOVE_PROMOTE_QUEEN = 11,
+    MOVE_PROMOTE_KNIGHT_CAPTURE = 12,
+    MOVE_PROMOTE_BISHOP_CAPTURE = 13,
+    MOVE_PROMOTE_ROOK_CAPTURE = 14,
+    MOVE_PROMOTE_QUEEN_CAPTURE = 15
+} MoveFlag;
+
+#define MOVE_FLAG_CAPTURE_BIT 4
+#define MOVE_FLAG_PROMOTION_BIT 8
+
+#define ENCODE_MOVE(from, to, flag) ((ChessMove)((from) | ((to) << 6) | ((flag) << 12)))
+#define MOVE_FROM(move) ((int)((move) & 0x3F))
+#define MOVE_TO(move) ((int)(((move) >> 6) & 0x3F))
+#define MOVE_FLAG(move) ((MoveFlag)((move) >> 12))
+#define MOVE_IS_CAPTURE(move) ((MOVE_FLAG(move) & MOVE_FLAG_CAPTURE_BIT) != 0)
+#define MOVE_IS_PROMOTION(move) ((MOVE_FLAG(move) & MOVE_FLAG_PROMOTION_BIT) != 0)
+
+/**
+ * MoveList
+ *
+ * Fixed-capacity list filled by GenerateLegalMoves; lives on the stack, no allocation.
+ */
+typedef struct MoveList
+{
+    ChessMove moves[MAX_MOVES];
+    int count;
+} MoveList;
+
+/**
+ * LegalMoveCache
+ *
+ * The legal moves of one position grouped by source square.
+ *
+ * - list:    every legal move, sorted so moves from the same square are contiguous;
+ *            the moves from square s are list.moves[start[s] .. start[s + 1]).
+ * - targets: destination squares per source square, for O(1) "can this piece go there".
+ */
+typedef struct LegalMoveCache
+{
+    MoveList list;
+    uint16_t start[SQUARE_COUNT + 1];
+    Bitboard targets[SQUARE_COUNT];
+} LegalMoveCache;
+
+/* Fills list with every legal move of pos->side and returns the count */
+int GenerateLegalMoves(const Position *pos, MoveList *list);
+
+/* Generates the legal moves of pos once and stores them grouped by source square */
+void BuildLegalMoveCache(const Position *pos, LegalMoveCache *cache);
+
+/* Returns true if the side to move is in check */
+bool IsInCheck(const Position *pos);
+
+/* Returns true if neither side has enough material left to checkmate (K v K, K+minor v K, K+B v K+B on one color) */
+bool IsInsufficientMaterial(const Bitboards *bb);
+
+/* PieceType a promotion move promotes to (PIECE_NONE for other moves) */
+PieceType MovePromotionType(ChessMove move);
+
+#endif /* MOVEGEN_H */
@@ -0,0 +1,558 @@
+/**
+ * nnue.c
+ *
+ * Responsibilities:
+ * - Load NNUE network files (LoadNnue).
+ * - Build, update and evaluate first-layer accumulators (RefreshAccumulator,
+ *   UpdateAccumulator, EvaluateNnue).
+ * - Provide the vector kernels and pick one set at startup (InitNnue).
+ *
+ * Implementation Details:
+ * - A move changes at most four features per perspective (castling: king and rook each
+ *   leave one square and reach another; a capture removes the mover from its square and
+ *   the victim, and adds the mover or its promotion), so a child accumulator is its
+ *   parent plus at most two weight rows minus at most two, done in one pass.
+ * - Two kernels do all the work: Update (out = in + sum of added rows - sum of removed
+ *   rows) and Output (clipped dot product of both halves with the output weights). Each
+ *   exists as portable C and per instruction set; InitNnue stores the best supported pair
+ *   in function pointers. The x86 versions are compiled with target attributes, so the
+ *   library itself still builds for the baseline CPU and only calls them after
+ *   __builtin_cpu_supports confirms the instructions are there.
+ * - The 128-bit x86 kernels only need SSE2 (16-bit add/sub/min/max and madd), which every
+ *   x86-64 CPU has; they are used when AVX2 is missing.
+ * - The accumulators are not assumed to be aligned (workers are allocated with calloc),
+ *   so every vector load and store is unaligned; on current CPUs this costs nothing when
+ *   the data happens to be aligned.
+ * - The file is decoded value by value, so it loads the same on big-endian machines.
+ */
+
+#include "nnue.h"
+#include "bitboard.h"
+#include "movegen.h"
+#include "piece.h"
+#include "position.h"
+#include "settings.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define NNUE_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define NNUE_NEON 1
+#include <arm_neon.h>
+#endif
+
+/* Rows a refresh passes to one Update call */
+#define MAX_ROWS 32
+
+/* Largest score EvaluateNnue returns, well clear of the mate scores of the search */
+#define NNUE_MAX_SCORE 20000
+
+/* Bytes before the weights: magic, version, hidden size */
+#define NNUE_HEADER_SIZE 12
+
+/* Feature kind of each PieceType (pawn 0 .. king 5) */
+static const int FeatureKinds[PIECE_TYPE_COUNT] = {0, 5, 4, 3, 2, 1, 0};
+
+typedef void (*UpdateKernel)(int16_t *out, const int16_t *in, const int16_t *const *added, int addedCount, const int16_t *const *removed, int removedCount);
+typedef int32_t (*OutputKernel)(const int16_t *us, const int16_t *them, const int16_t *weights);
+
+// Local prototypes
+static void UpdateScalar(int16_t *out, const int16_t *in, const int16_t *const *added, int addedCount, const int16_t *const *removed, int removedCount);
+static int32_t OutputScalar(const int16_t *us, const int16_t *them, const int16_t *weights);
+#if defined(NNUE_X86)
+static void UpdateSse2(int16_t *out, const int16_t *in, const int16_t *const *added, int addedCount, const int16_t *const *removed, int removedCount);
+static int32_t OutputSse2(const int16_t *us, const int16_t *them, const int16_t *weights);
+static void UpdateAvx2(int16_t *out, const int16_t *in, const int16_t *const *added, int addedCount, const int16_t *const *removed, int removedCount);
+static int32_t OutputAvx2(const int16_t *us, const int16_t *them, const int16_t *weights);
+#elif defined(NNUE_NEON)
+static void UpdateNeon(int16_t *out, const int16_t *in, const int16_t *const *added, int addedCount, const int16_t *const *removed, int removedCount);
+static int32_t OutputNeon(const int16_t *us, const int16_t *them, const int16_t *weights);
+#endif
+static int FeatureIndex(Team perspective, Team team, PieceType type, int square);
+static PieceType TeamPieceOn(const Bitboards *bb, int square, Team team);
+static int16_t ReadInt16(const unsigned char *bytes);
+static uint32_t ReadUint32(const unsigned char *bytes);
+
+static UpdateKernel Update = UpdateScalar;
+static OutputKernel Output = OutputScalar;
+static const char *KernelName = "scalar";
+
+/**
+ * InitNnue
+ *
+ * Pick the kernels. Until it runs the portable ones are used, so calling it is only
+ * needed for speed.
+ *
+ * Notes:
+ *  - Not thread-safe; call it from the main thread before starting any search.
+ */
+void InitNnue(void)
+{
+#if defined(NNUE_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        Update = UpdateAvx2;
+        Output = OutputAvx2;
+        KernelName = "avx2";
+    }
+    else if (__builtin_cpu_supports("sse2"))
+    {
+        Update = UpdateSse2;
+        Output = OutputSse2;
+        KernelName = "sse2";
+    }
+#elif defined(NNUE_NEON)
+    Update = UpdateNeon;
+    Output = OutputNeon;
+    KernelName = "neon";
+#endif
+}
+
+/**
+ * NnueKernelName
+ */
+const char *NnueKernelName(void)
+{
+    return KernelName;
+}
+
+/**
+ * LoadNnue
+ *
+ * Parameters:
+ *  - path: network file (format in nnue.h).
+ *
+ * Returns:
+ *  - The network (free it with FreeNnue), or NULL if the file cannot be read, has the
+ *    wrong magic, version or hidden size, or is not exactly as long as the format says.
+ */
+NnueNetwork *LoadNnue(const char *path)
+{
+    const size_t valueCount = (size_t)NNUE_FEATURES * NNUE_HIDDEN + NNUE_HIDDEN + 2 * NNUE_HIDDEN + 1;
+    const size_t fileSize = NNUE_HEADER_SIZE + 2 * valueCount;
+
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        return NULL;
+    }
+
+    // One byte more than expected so a longer file is noticed
+    unsigned char *bytes = malloc(fileSize + 1);
+    NnueNetwork *network = malloc(sizeof *network);
+    size_t size = (bytes != NULL) ? fread(bytes, 1, fileSize + 1, file) : 0;
+    fclose(file);
+
+    if (bytes == NULL || network == NULL || size != fileSize || memcmp(bytes, "CNUE", 4) != 0 ||
+        ReadUint32(bytes + 4) != NNUE_FILE_VERSION || ReadUint32(bytes + 8) != NNUE_HIDDEN)
+    {
+        free(bytes);
+        free(network);
+        return NULL;
+    }
+
+    const unsigned char *cursor = bytes + NNUE_HEADER_SIZE;
+    for (int feature = 0; feature < NNUE_FEATURES; feature++)
+    {
+        for (int i = 0; i < NNUE_HIDDEN; i++, cursor += 2)
+        {
+            network->featureWeights[feature][i] = ReadInt16(cursor);
+        }
+    }
+    for (int i = 0; i < NNUE_HIDDEN; i++, cursor += 2)
+    {
+        network->featureBiases[i] = ReadInt16(cursor);
+    }
+    for (int i = 0; i < 2 * NNUE_HIDDEN; i++, cursor += 2)
+    {
+        network->outputWeights[i] = ReadInt16(cursor);
+    }
+    network->outputBias = ReadInt16(cursor);
+
+    free(bytes);
+    return network;
+}
+
+/**
+ * FreeNnue
+ */
+void FreeNnue(NnueNetwork *network)
+{
+    free(network);
+}
+
+/**
+ * RefreshAccumulator
+ *
+ * Behavior:
+ *  - Each perspective starts from the biases and adds the weight row of every piece,
+ *    MAX_ROWS rows per kernel call.
+ */
+void RefreshAccumulator(const NnueNetwork *network, const Position *pos, NnueAccumulator *accumulator)
+{
+    for (int perspective = 0; perspective < TEAM_COUNT; perspective++)
+    {
+        int16_t *values = accumulator->values[perspective];
+        const int16_t *rows[MAX_ROWS];
+        int count = 0;
+
+        memcpy(values, network->featureBiases, sizeof network->featureBiases);
+
+        for (int team = 0; team < TEAM_COUNT; team++)
+        {
+            for (int type = PIECE_KING; type < PIECE_TYPE_COUNT; type++)
+            {
+                Bitboard pieces = pos->bitboards.pieces[team][type];
+                while (pieces)
+                {
+                    int square = PopLowestSquare(&pieces);
+                    rows[count++] = network->featureWeights[FeatureIndex((Team)perspective, (Team)team, (PieceType)type, square)];
+                    if (count == MAX_ROWS)
+                    {
+                        Update(values, values, rows, count, NULL, 0);
+                        count = 0;
+                    }
+                }
+            }
+        }
+
+        Update(values, values, rows, count, NULL, 0);
+    }
+}
+
+/**
+ * UpdateAccumulator
+ *
+ * Parameters:
+ *  - parent: accumulator of the position before the move.
+ *  - child:  receives the accumulator of pos (may not be parent).
+ *  - pos:    the position after MakeMove(before, move, undo).
+ *  - move, undo: the move just played and the UndoInfo MakeMove filled.
+ */
+void UpdateAccumulator(const NnueNetwork *network, const NnueAccumulator *parent, NnueAccumulator *child, const Position *pos, uint16_t move, const UndoInfo *undo)
+{
+    Team them = pos->side;
+    Team us = (them == TEAM_WHITE) ? TEAM_BLACK : TEAM_WHITE;
+    int from = MOVE_FROM(move);
+    int to = MOVE_TO(move);
+    MoveFlag flag = MOVE_FLAG(move);
+    PieceType landed = TeamPieceOn(&pos->bitboards, to, us);
+    PieceType moved = MOVE_IS_PROMOTION(move) ? PIECE_PAWN : landed;
+
+    for (int perspective = 0; perspective < TEAM_COUNT; perspective++)
+    {
+        Team view = (Team)perspective;
+        const int16_t *added[2];
+        const int16_t *removed[2];
+        int addedCount = 0;
+        int removedCount = 0;
+
+        removed[removedCount++] = network->featureWeights[FeatureIndex(view, us, moved, from)];
+        added[addedCount++] = network->featureWeights[FeatureIndex(view, us, landed, to)];
+
+        if (flag == MOVE_EN_PASSANT)
+        {
+            int captureSquare = (us == TEAM_WHITE) ? to + BOARD_SIZE : to - BOARD_SIZE;
+            removed[removedCount++] = network->featureWeights[FeatureIndex(view, them, PIECE_PAWN, captureSquare)];
+        }
+        else if (undo->captured != PIECE_NONE)
+        {
+            removed[removedCount++] = network->featureWeights[FeatureIndex(view, them, undo->captured, to)];
+        }
+        else if (flag == MOVE_CASTLE_KING_SIDE || flag == MOVE_CASTLE_QUEEN_SIDE)
+        {
+            int row = SQUARE_ROW(from);
+            bool kingSide = (flag == MOVE_CASTLE_KING_SIDE);
+            removed[removedCount++] = network->featureWeights[FeatureIndex(view, us, PIECE_ROOK, SQUARE_INDEX(row, kingSide ? ROOK_KS_COL : ROOK_QS_COL))];
+            added[addedCount++] = network->featureWeights[FeatureIndex(view, us, PIECE_ROOK, SQUARE_INDEX(row, kingSide ? CASTLE_KS_ROOK_COL : CASTLE_QS_ROOK_COL))];
+        }
+
+        Update(child->values[perspective], parent->values[perspective], added, addedCount, removed, removedCount);
+    }
+}
+
+/**
+ * EvaluateNnue
+ *
+ * Returns:
+ *  - The network output in centipawns for side, clamped to +-NNUE_MAX_SCORE.
+ */
+int EvaluateNnue(const NnueNetwork *network, const NnueAccumulator *accumulator, Team side)
+{
+    Team other = (side == TEAM_WHITE) ? TEAM_BLACK : TEAM_WHITE;
+    int64_t sum = (int64_t)Output(accumulator->values[side], accumulator->values[other], network->outputWeights) + network->outputBias;
+    int64_t score = sum * NNUE_SCALE / (NNUE_QA * NNUE_QB);
+
+    if (score > NNUE_MAX_SCORE)
+    {
+        return NNUE_MAX_SCORE;
+    }
+    if (score < -NNUE_MAX_SCORE)
+    {
+        return -NNUE_MAX_SCORE;
+    }
+    return (int)score;
+}
+
+/**
+ * UpdateScalar (static)
+ *
+ * Portable Update kernel: out = in + added rows - removed rows (16-bit wrapping, like
+ * the vector kernels).
+ */
+static void UpdateScalar(int16_t *out, const int16_t *in, const int16_t *const *added, int addedCount, const int16_t *const *removed, int removedCount)
+{
+    for (int i = 0; i < NNUE_HIDDEN; i++)
+    {
+        uint16_t value = (uint16_t)in[i];
+
+        for (int row = 0; row < addedCount; row++)
+        {
+            value = (uint16_t)(value + (uint16_t)added[row][i]);
+        }
+        for (int row = 0; row < removedCount; row++)
+        {
+            value = (uint16_t)(value - (uint16_t)removed[row][i]);
+        }
+
+        out[i] = (int16_t)value;
+    }
+}
+
+/**
+ * OutputScalar (static)
+ *
+ * Portable Output kernel: sum of clamp(us[i], 0, QA) * weights[i] plus the same for them
+ * with the second half of the weights.
+ */
+static int32_t OutputScalar(const int16_t *us, const int16_t *them, const int16_t *weights)
+{
+    int32_t sum = 0;
+
+    for (int i = 0; i < NNUE_HIDDEN; i++)
+    {
+        int ours = (us[i] < 0) ? 0 : (us[i] > NNUE_QA) ? NNUE_QA : us[i];
+        int theirs = (them[i] < 0) ? 0 : (them[i] > NNUE_QA) ? NNUE_QA : them[i];
+
+        sum += ours * weights[i] + theirs * weights[NNUE_HIDDEN + i];
+    }
+
+    return sum;
+}
+
+#if defined(NNUE_X86)
+
+/**
+ * UpdateSse2 (static)
+ *
+ * Update kernel on 8 neurons per instruction.
+ */
+__attribute__((target("sse2"))) static void UpdateSse2(int16_t *out, const int16_t *in, const int16_t *const *added, int addedCount, const int16_t *const *removed, int removedCount)
+{
+    for (int i = 0; i < NNUE_HIDDEN; i += 8)
+    {
+        __m128i value = _mm_loadu_si128((const __m128i *)(in + i));
+
+        for (int row = 0; row < addedCount; row++)
+        {
+            value = _mm_add_epi16(value, _mm_loadu_si128((const __m128i *)(added[row] + i)));
+        }
+        for (int row = 0; row < removedCount; row++)
+        {
+            value = _mm_sub_epi16(value, _mm_loadu_si128((const __m128i *)(removed[row] + i)));
+        }
+
+        _mm_storeu_si128((__m128i *)(out + i), value);
+    }
+}
+
+/**
+ * OutputSse2 (static)
+ *
+ * Output kernel: clamp with min/max, then madd multiplies neighbouring pairs and adds
+ * them into 32-bit lanes.
+ */
+__attribute__((target("sse2"))) static int32_t OutputSse2(const int16_t *us, const int16_t *them, const int16_t *weights)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i limit = _mm_set1_epi16(NNUE_QA);
+    __m128i sum = _mm_setzero_si128();
+
+    for (int i = 0; i < NNUE_HIDDEN; i += 8)
+    {
+        __m128i ours = _mm_min_epi16(_mm_max_epi16(_mm_loadu_si128((const __m128i *)(us + i)), zero), limit);
+        __m128i theirs = _mm_min_epi16(_mm_max_epi16(_mm_loadu_si128((const __m128i *)(them + i)), zero), limit);
+
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(ours, _mm_loadu_si128((const __m128i *)(weights + i))));
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(theirs, _mm_loadu_si128((const __m128i *)(weights + NNUE_HIDDEN + i))));
+    }
+
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+    return _mm_cvtsi128_si32(sum);
+}
+
+/**
+ * UpdateAvx2 (static)
+ *
+ * Update kernel on 16 neurons per instruction.
+ */
+__attribute__((target("avx2"))) static void UpdateAvx2(int16_t *out, const int16_t *in, const int16_t *const *added, int addedCount, const int16_t *const *removed, int removedCount)
+{
+    for (int i = 0; i < NNUE_HIDDEN; i += 16)
+    {
+        __m256i value = _mm256_loadu_si256((const __m256i *)(in + i));
+
+        for (int row = 0; row < addedCount; row++)
+        {
+            value = _mm256_add_epi16(value, _mm256_loadu_si256((const __m256i *)(added[row] + i)));
+        }
+        for (int row = 0; row < removedCount; row++)
+        {
+            value = _mm256_sub_epi16(value, _mm256_loadu_si256((const __m256i *)(removed[row] + i)));
+        }
+
+        _mm256_storeu_si256((__m256i *)(out + i), value);
+    }
+}
+
+/**
+ * OutputAvx2 (static)
+ *
+ * OutputSse2 on 256-bit vectors; the two halves are folded before the final reduction.
+ */
+__attribute__((target("avx2"))) static int32_t OutputAvx2(const int16_t *us, const int16_t *them, const int16_t *weights)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i limit = _mm256_set1_epi16(NNUE_QA);
+    __m256i sum = _mm256_setzero_si256();
+
+    for (int i = 0; i < NNUE_HIDDEN; i += 16)
+    {
+        __m256i ours = _mm256_min_epi16(_mm256_max_epi16(_mm256_loadu_si256((const __m256i *)(us + i)), zero), limit);
+        __m256i theirs = _mm256_min_epi16(_mm256_max_epi16(_mm256_loadu_si256((const __m256i *)(them + i)), zero), limit);
+
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(ours, _mm256_loadu_si256((const __m256i *)(weights + i))));
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(theirs, _mm256_loadu_si256((const __m256i *)(weights + NNUE_HIDDEN + i))));
+    }
+
+    __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xB1));
+    return _mm_cvtsi128_si32(half);
+}
+
+#elif defined(NNUE_NEON)
+
+/**
+ * UpdateNeon (static)
+ *
+ * Update kernel on 8 neurons per instruction.
+ */
+static void UpdateNeon(int16_t *out, const int16_t *in, const int16_t *const *added, int addedCount, const int16_t *const *removed, int removedCount)
+{
+    for (int i = 0; i < NNUE_HIDDEN; i += 8)
+    {
+        int16x8_t value = vld1q_s16(in + i);
+
+        for (int row = 0; row < addedCount; row++)
+        {
+            value = vaddq_s16(value, vld1q_s16(added[row] + i));
+        }
+        for (int row = 0; row < removedCount; row++)
+        {
+            value = vsubq_s16(value, vld1q_s16(removed[row] + i));
+        }
+
+        vst1q_s16(out + i, value);
+    }
+}
+
+/**
+ * OutputNeon (static)
+ *
+ * Output kernel: clamp, then widening multiply-accumulate of each half into 32-bit lanes.
+ */
+static int32_t OutputNeon(const int16_t *us, const int16_t *them, const int16_t *weights)
+{
+    const int16x8_t zero = vdupq_n_s16(0);
+    const int16x8_t limit = vdupq_n_s16(NNUE_QA);
+    int32x4_t sum = vdupq_n_s32(0);
+
+    for (int i = 0; i < NNUE_HIDDEN; i += 8)
+    {
+        int16x8_t ours = vminq_s16(vmaxq_s16(vld1q_s16(us + i), zero), limit);
+        int16x8_t theirs = vminq_s16(vmaxq_s16(vld1q_s16(them + i), zero), limit);
+        int16x8_t ourWeights = vld1q_s16(weights + i);
+        int16x8_t theirWeights = vld1q_s16(weights + NNUE_HIDDEN + i);
+
+        sum = vmlal_s16(sum, vget_low_s16(ours), vget_low_s16(ourWeights));
+        sum = vmlal_high_s16(sum, ours, ourWeights);
+        sum = vmlal_s16(sum, vget_low_s16(theirs), vget_low_s16(theirWeights));
+        sum = vmlal_high_s16(sum, theirs, theirWeights);
+    }
+
+    return vaddvq_s32(sum);
+}
+
+#endif
+
+/**
+ * FeatureIndex (static)
+ *
+ * Input feature of a piece seen from perspective (see nnue.h).
+ */
+static int FeatureIndex(Team perspective, Team team, PieceType type, int square)
+{
+    // Our squares count from a8; White's perspective counts from a1, Black's is mirrored
+    int relative = (perspective == TEAM_WHITE) ? (square ^ 56) : square;
+
+    return 384 * (team != perspective) + 64 * FeatureKinds[type] + relative;
+}
+
+/**
+ * TeamPieceOn (static)
+ *
+ * Type of the piece of team on square (PIECE_NONE if that team has nothing there).
+ */
+static PieceType TeamPieceOn(const Bitboards *bb, int square, Team team)
+{
+    Bitboard bit = SQUARE_BIT(square);
+
+    for (int type = PIECE_KING; type < PIECE_TYPE_COUNT; type++)
+    {
+        if (bb->pieces[team][type] & bit)
+        {
+            return (PieceType)type;
+        }
+    }
+
+    return PIECE_NONE;
+}
+
+/**
+ * ReadInt16 (static)
+ *
+ * Little-endian signed 16-bit value.
+ */
+static int16_t ReadInt16(const unsigned char *bytes)
+{
+    return (int16_t)(uint16_t)(bytes[0] | (bytes[1] << 8));
+}
+
+/**
+ * ReadUint32 (static)
+ *
+ * Little-endian unsigned 32-bit value.
+ */
+static uint32_t ReadUint32(const unsigned char *bytes)
+{
+    return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
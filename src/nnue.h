@@ -0,0 +1,94 @@
+/**
+ * nnue.h
+ *
+ * Responsibilities:
+ * - Define the small efficiently updatable network (NNUE) the search can evaluate with
+ *   instead of the piece-square evaluation (eval.h), and its first-layer accumulator.
+ * - Export loading a network from a file, refreshing an accumulator from a position,
+ *   updating it for one move and evaluating it.
+ *
+ * Network:
+ * - Input: 768 features per perspective, one per (piece colour, piece kind, square)
+ *   seen from that side: for White's perspective "ours" is White and squares count from
+ *   a1 (0) to h8 (63); for Black's perspective colours are swapped and the board is
+ *   mirrored vertically. Feature = 384 * (0 ours, 1 theirs) + 64 * kind + square, with
+ *   kinds pawn, knight, bishop, rook, queen, king (0..5).
+ * - Hidden layer: NNUE_HIDDEN int16 neurons per perspective (the accumulator), clipped
+ *   to 0..NNUE_QA (CReLU).
+ * - Output: the side to move's half dotted with outputWeights[0..H), the other half with
+ *   outputWeights[H..2H), plus the bias (quantized by QA * QB), scaled to centipawns by
+ *   NNUE_SCALE / (QA * QB).
+ *
+ * File format (little-endian): magic "CNUE", uint32 version (NNUE_FILE_VERSION), uint32
+ * hidden size (must be NNUE_HIDDEN), then int16 feature weights [768][H] (feature-major),
+ * int16 feature biases [H], int16 output weights [2H] and one int16 output bias.
+ *
+ * Notes:
+ * - A network is read-only once loaded; any number of search threads may share one.
+ * - The kernels (accumulator update, output layer) are picked once by InitNnue: AVX2 on
+ *   x86 CPUs that have it and SSE2 on the others, NEON on ARM64, portable C otherwise.
+ * - Part of libchesscore; this header does not include raylib.
+ */
+
+#ifndef NNUE_H
+#define NNUE_H
+
+#include "piece.h"
+#include "position.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define NNUE_FEATURES 768
+#define NNUE_HIDDEN 256
+#define NNUE_FILE_VERSION 1
+
+/* Quantization: hidden activations are clipped to 0..QA, output weights are scaled by QB */
+#define NNUE_QA 255
+#define NNUE_QB 64
+#define NNUE_SCALE 400
+
+/**
+ * NnueNetwork
+ *
+ * Quantized weights, laid out as in the file.
+ */
+typedef struct NnueNetwork
+{
+    int16_t featureWeights[NNUE_FEATURES][NNUE_HIDDEN];
+    int16_t featureBiases[NNUE_HIDDEN];
+    int16_t outputWeights[2 * NNUE_HIDDEN];
+    int16_t outputBias;
+} NnueNetwork;
+
+/**
+ * NnueAccumulator
+ *
+ * First-layer sums of one position, one row per perspective (indexed by Team).
+ */
+typedef struct NnueAccumulator
+{
+    int16_t values[TEAM_COUNT][NNUE_HIDDEN];
+} NnueAccumulator;
+
+/* Picks the fastest kernels the CPU supports. Call once at startup (InitChessCore does it) */
+void InitNnue(void);
+
+/* Name of the kernels InitNnue picked ("avx2", "sse2", "neon" or "scalar") */
+const char *NnueKernelName(void);
+
+/* Reads a network file. Returns NULL if it cannot be read, is not a network of this format or memory runs out */
+NnueNetwork *LoadNnue(const char *path);
+
+/* Frees a network from LoadNnue. Safe to pass NULL */
+void FreeNnue(NnueNetwork *network);
+
+/* Computes the accumulator of pos from scratch */
+void RefreshAccumulator(const NnueNetwork *network, const Position *pos, NnueAccumulator *accumulator);
+
+/* Derives the accumulator of pos (position right after MakeMove(parent position, move, undo)) from the parent's */
+void UpdateAccumulator(const NnueNetwork *network, const NnueAccumulator *parent, NnueAccumulator *child, const Position *pos, uint16_t move, const UndoInfo *undo);
+
+/* Score in centipawns for side (the side to move) of the position the accumulator describes */
+int EvaluateNnue(const NnueNetwork *network, const NnueAccumulator *accumulator, Team side);
+
+#endif /* NNUE_H */
@@ -0,0 +1,459 @@
+/**
+ * opponent.c
+ *
+ * Responsibilities:
+ * - Own the Engine used by the "play vs engine" mode.
+ * - Run its search on a background thread so the main loop keeps drawing and handling
+ *   input while the engine thinks.
+ * - Turn the engine's ChessMove into MovePiece/PromotePawn calls so every GUI side effect
+ *   (history, sounds, captured pieces, check and mate flags) happens as for a human move.
+ * - Own the Polyglot opening book (OPENING_BOOK_PATH, optional): the engine plays a book
+ *   move instantly instead of searching, and the board shows the book moves of a selected
+ *   piece (BookTargets).
+ *
+ * Notes:
+ * - The engine searches with AvailableCores() - 1 threads (one core is left to the render
+ *   loop) unless ENGINE_THREADS sets a count, for ENGINE_MOVE_TIME_MS per move.
+ * - The engine is reset (transposition table cleared) whenever the mode is switched on.
+ *
+ * Implementation Details:
+ * - The search thread only touches its own copies (SearchRoot, SearchHistory) and writes
+ *   SearchOutput; GameState is only read and changed on the main thread. The main thread
+ *   polls SearchFinished once per frame and joins the thread when it is set.
+ * - A finished search is only played if the board still shows the position it searched
+ *   (the user may have restarted or loaded a game meanwhile). Undo/redo and switching the
+ *   mode off stop a running search first; the stop takes effect within a few thousand nodes.
+ */
+
+#include "opponent.h"
+#include "bitboard.h"
+#include "book.h"
+#include "draw.h"
+#include "hash.h"
+#include "main.h"
+#include "move.h"
+#include "movegen.h"
+#include "position.h"
+#include "raylib.h"
+#include "search.h"
+#include "settings.h"
+#include "stack.h"
+#include "utils.h"
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+static Engine OpponentEngine;
+static bool EngineReady = false;
+static SearchResult LastResult = {0};
+
+/* Background search (see Implementation Details) */
+static pthread_t SearchThread;
+static bool SearchRunning = false; /* main thread only */
+static atomic_bool SearchFinished;
+static atomic_bool SearchStop; /* per-search stop flag (SearchLimits.stop) */
+static Position SearchRoot;
+static uint64_t SearchHistory[MAX_REPETITION_WINDOW];
+static int SearchHistoryCount = 0;
+static SearchResult SearchOutput;
+static bool SearchFoundMove = false;
+
+/* Opening book, and the book moves of the last position asked about (by Zobrist key) */
+static OpeningBook Book;
+static bool BookOpen = false;
+static bool BookCacheValid = false;
+static uint64_t BookCacheKey = 0;
+static int BookCacheCount = 0;
+static Bitboard BookCacheTargets[SQUARE_COUNT];
+
+// Local prototypes
+static void RefreshBookCache(void);
+static bool PlayBookMove(void);
+static void StartEngineSearch(void);
+static void *SearchThreadMain(void *arg);
+static void CancelEngineSearch(void);
+static void PlayEngineMove(ChessMove move);
+
+/**
+ * InitializeOpponent
+ *
+ * Returns:
+ *  - false if the engine could not be allocated (the mode then stays unavailable).
+ */
+bool InitializeOpponent(void)
+{
+    // The book is optional and also serves the overlay, so it is opened even without an engine
+    BookOpen = OpenOpeningBook(&Book, OPENING_BOOK_PATH);
+    if (BookOpen)
+    {
+        TraceLog(LOG_INFO, "Opening book: %zu entries (%s)", Book.entryCount, OPENING_BOOK_PATH);
+    }
+
+    EngineReady = InitializeEngine(&OpponentEngine, ENGINE_TT_MEGABYTES);
+
+    if (!EngineReady)
+    {
+        TraceLog(LOG_WARNING, "Failed to allocate the engine's transposition table");
+        return false;
+    }
+
+    int threads = (ENGINE_THREADS > 0) ? ENGINE_THREADS : AvailableCores() - 1;
+    if (!SetEngineThreads(&OpponentEngine, threads))
+    {
+        TraceLog(LOG_WARNING, "Engine: could not start %d search threads", threads);
+    }
+    TraceLog(LOG_INFO, "Engine: %d search thread(s)", OpponentEngine.threadCount);
+
+    return true;
+}
+
+/**
+ * FreeOpponent
+ */
+void FreeOpponent(void)
+{
+    if (EngineReady)
+    {
+        CancelEngineSearch();
+        FreeEngine(&OpponentEngine);
+        EngineReady = false;
+    }
+
+    CloseOpeningBook(&Book);
+    BookOpen = false;
+    BookCacheValid = false;
+}
+
+/**
+ * ToggleEngineOpponent
+ *
+ * Switch the mode on (the engine plays the side not to move, so the user keeps the
+ * move they were about to make) or off.
+ */
+void ToggleEngineOpponent(void)
+{
+    if (!EngineReady)
+    {
+        return;
+    }
+
+    CancelEngineSearch();
+    state.vsEngine = !state.vsEngine;
+
+    if (state.vsEngine)
+    {
+        state.engineTeam = (Turn == TEAM_WHITE) ? TEAM_BLACK : TEAM_WHITE;
+        ResetEngine(&OpponentEngine);
+        LastResult = (SearchResult){0};
+    }
+
+    TraceLog(LOG_INFO, "Engine opponent %s", state.vsEngine ? (state.engineTeam == TEAM_WHITE ? "plays White" : "plays Black") : "off");
+}
+
+/**
+ * UpdateEngineOpponent
+ *
+ * Behavior:
+ *  - While a search runs: returns at once until it has finished, then plays its move if
+ *    the board still shows the searched position and it is still the engine's turn.
+ *  - Otherwise, if the mode is on, it is the engine's turn, the game is not over, no popup
+ *    holds the input and no promotion choice is pending: plays a book move at once if the
+ *    position is in the opening book, else starts a search.
+ */
+void UpdateEngineOpponent(void)
+{
+    if (SearchRunning)
+    {
+        if (!atomic_load(&SearchFinished))
+        {
+            return;
+        }
+
+        pthread_join(SearchThread, NULL);
+        SearchRunning = false;
+        LastResult = SearchOutput;
+
+        if (SearchFoundMove && state.vsEngine && Turn == state.engineTeam && !state.isPromoting && CurrentPosition(&state).key == SearchRoot.key)
+        {
+            PlayEngineMove(LastResult.bestMove);
+        }
+        return;
+    }
+
+    if (!EngineReady || !state.vsEngine || Turn != state.engineTeam || state.isPromoting || state.isInputLocked || IsGameOver(&state))
+    {
+        return;
+    }
+
+    if (PlayBookMove())
+    {
+        return;
+    }
+
+    StartEngineSearch();
+}
+
+/**
+ * IsEngineThinking
+ */
+bool IsEngineThinking(void)
+{
+    return SearchRunning;
+}
+
+/**
+ * UndoPlayerMove
+ *
+ * Undo wrapper for the toolbar and Ctrl+Z: against the engine, undoing only one ply would
+ * hand the move straight back to the engine, which would replay it on the next frame.
+ * A search in progress is abandoned (undoing then takes back the user's last move).
+ */
+void UndoPlayerMove(void)
+{
+    CancelEngineSearch();
+    UndoMove(&state);
+
+    if (state.vsEngine && Turn == state.engineTeam && StackSize(state.undoStack) > 0)
+    {
+        UndoMove(&state);
+    }
+}
+
+/**
+ * RedoPlayerMove
+ *
+ * Redo wrapper for the toolbar and Ctrl+Shift+Z, mirroring UndoPlayerMove.
+ */
+void RedoPlayerMove(void)
+{
+    CancelEngineSearch();
+    RedoMove(&state);
+
+    if (state.vsEngine && Turn == state.engineTeam && StackSize(state.redoStack) > 0)
+    {
+        RedoMove(&state);
+    }
+}
+
+/**
+ * JumpPlayerToPly
+ *
+ * JumpToPly wrapper for the history scrubber. Against the engine, a ply where the engine
+ * is to move would make it play at once and drop the rest of the line, so the jump
+ * lands one ply earlier instead (the side to move alternates with the ply, so this is
+ * known before jumping and the rule checks still run once).
+ */
+void JumpPlayerToPly(size_t ply)
+{
+    CancelEngineSearch();
+
+    size_t current = StackSize(state.undoStack);
+    size_t distance = (ply > current) ? ply - current : current - ply;
+    Team side = (distance % 2 == 0) ? Turn : ((Turn == TEAM_WHITE) ? TEAM_BLACK : TEAM_WHITE);
+
+    if (state.vsEngine && side == state.engineTeam && ply > 0)
+    {
+        ply--;
+    }
+
+    // Dragging the scrubber over an engine ply asks for the same ply every frame
+    if (ply != current)
+    {
+        JumpToPly(&state, ply);
+    }
+}
+
+/**
+ * LastEngineSearch
+ */
+const SearchResult *LastEngineSearch(void)
+{
+    return &LastResult;
+}
+
+/**
+ * BookTargets
+ *
+ * Returns:
+ *  - The destinations of the book moves of the piece on square in the current position
+ *    (0 without a book or out of book).
+ *
+ * Notes:
+ *  - The book is probed once per position (the result is cached by Zobrist key), so the
+ *    overlay can ask every frame.
+ */
+Bitboard BookTargets(int square)
+{
+    RefreshBookCache();
+
+    return (square >= 0 && square < SQUARE_COUNT) ? BookCacheTargets[square] : 0;
+}
+
+/**
+ * BookMoveCount
+ *
+ * Returns:
+ *  - The number of book moves of the current position, or -1 if no book is open.
+ */
+int BookMoveCount(void)
+{
+    RefreshBookCache();
+
+    return BookOpen ? BookCacheCount : -1;
+}
+
+/**
+ * RefreshBookCache (static)
+ *
+ * Probe the book for the current position unless the cache already holds it.
+ */
+static void RefreshBookCache(void)
+{
+    if (!BookOpen || (BookCacheValid && BookCacheKey == state.zobristKey))
+    {
+        return;
+    }
+
+    Position position = CurrentPosition(&state);
+    BookMove moves[MAX_BOOK_MOVES];
+    int count = ProbeOpeningBook(&Book, &position, moves, MAX_BOOK_MOVES);
+
+    memset(BookCacheTargets, 0, sizeof BookCacheTargets);
+    for (int i = 0; i < count; i++)
+    {
+        BookCacheTargets[MOVE_FROM(moves[i].move)] |= SQUARE_BIT(MOVE_TO(moves[i].move));
+    }
+
+    BookCacheCount = count;
+    BookCacheKey = state.zobristKey;
+    BookCacheValid = true;
+}
+
+/**
+ * PlayBookMove (static)
+ *
+ * Play a book move of the current position, picked by weight.
+ *
+ * Returns:
+ *  - false if there is no book or the position is not in it (the engine then searches).
+ */
+static bool PlayBookMove(void)
+{
+    if (!BookOpen)
+    {
+        return false;
+    }
+
+    Position position = CurrentPosition(&state);
+    BookMove moves[MAX_BOOK_MOVES];
+    int count = ProbeOpeningBook(&Book, &position, moves, MAX_BOOK_MOVES);
+    if (count == 0)
+    {
+        return false;
+    }
+
+    // GetRandomValue yields 31 bits per call
+    uint64_t random = ((uint64_t)GetRandomValue(0, INT_MAX) << 31) ^ (uint64_t)GetRandomValue(0, INT_MAX);
+    ChessMove move = PickBookMove(moves, count, random);
+
+    LastResult = (SearchResult){.bestMove = move};
+    TraceLog(LOG_DEBUG, "Engine: book move (%d in book)", count);
+    PlayEngineMove(move);
+    return true;
+}
+
+/**
+ * StartEngineSearch (static)
+ *
+ * Copy the current position and the repetition history for the search thread and start it.
+ * If the thread cannot be created the mode is switched off.
+ */
+static void StartEngineSearch(void)
+{
+    SearchRoot = CurrentPosition(&state);
+
+    // The DHA ends with the current position; the search wants only the positions before it
+    int count = (int)state.DHA->size;
+    if (count > 0 && state.DHA->hashArray[count - 1] == SearchRoot.key)
+    {
+        count--;
+    }
+
+    SearchHistoryCount = (count > MAX_REPETITION_WINDOW) ? MAX_REPETITION_WINDOW : count;
+    memcpy(SearchHistory, state.DHA->hashArray + (count - SearchHistoryCount), sizeof(uint64_t) * (size_t)SearchHistoryCount);
+
+    atomic_store(&SearchFinished, false);
+    atomic_store(&SearchStop, false);
+    if (pthread_create(&SearchThread, NULL, SearchThreadMain, NULL) != 0)
+    {
+        TraceLog(LOG_WARNING, "Engine: could not start the search thread, engine opponent off");
+        state.vsEngine = false;
+        return;
+    }
+
+    SearchRunning = true;
+}
+
+/**
+ * SearchThreadMain (static)
+ *
+ * Body of the search thread: one Search under ENGINE_MOVE_TIME_MS.
+ */
+static void *SearchThreadMain(void *arg)
+{
+    (void)arg;
+    SearchLimits limits = {.timeMs = ENGINE_MOVE_TIME_MS, .stop = &SearchStop};
+
+    SearchFoundMove = Search(&OpponentEngine, &SearchRoot, SearchHistory, SearchHistoryCount, &limits, &SearchOutput);
+    atomic_store(&SearchFinished, true);
+
+    return NULL;
+}
+
+/**
+ * CancelEngineSearch (static)
+ *
+ * Stop a running search and wait for its thread; its result is dropped.
+ *
+ * Notes:
+ *  - Uses the search's own stop flag rather than StopSearch: the thread may already be
+ *    past Search, and an engine-wide stop raised then would cut the next search short.
+ */
+static void CancelEngineSearch(void)
+{
+    if (!SearchRunning)
+    {
+        return;
+    }
+
+    atomic_store(&SearchStop, true);
+    pthread_join(SearchThread, NULL);
+    SearchRunning = false;
+}
+
+/**
+ * PlayEngineMove (static)
+ *
+ * Play move through MovePiece (answering the promotion prompt with the engine's piece)
+ * and highlight it like a move made with the mouse.
+ */
+static void PlayEngineMove(ChessMove move)
+{
+    int fromRow = SQUARE_ROW(MOVE_FROM(move));
+    int fromCol = SQUARE_COL(MOVE_FROM(move));
+    int toRow = SQUARE_ROW(MOVE_TO(move));
+    int toCol = SQUARE_COL(MOVE_TO(move));
+
+    TraceLog(LOG_DEBUG, "Engine: depth %d score %d nodes %llu in %.3f s", LastResult.depth, LastResult.score, (unsigned long long)LastResult.nodes, LastResult.seconds);
+
+    MovePiece(&state, fromRow, fromCol, toRow, toCol);
+    if (state.isPromoting)
+    {
+        PromotePawn(&state, MovePromotionType(move));
+    }
+    UpdateLastMoveHighlight(toRow, toCol);
+}
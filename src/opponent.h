@@ -0,0 +1,50 @@
+/**
+ * opponent.h
+ *
+ * Responsibilities:
+ * - Export the "play vs engine" mode: the search engine (search.h) plays one side and
+ *   its moves go through MovePiece/PromotePawn exactly like a human's.
+ * - The search runs on a background thread; every function here is called from the main loop.
+ */
+
+#ifndef OPPONENT_H
+#define OPPONENT_H
+
+#include "bitboard.h"
+#include "search.h"
+#include <stdbool.h>
+
+/* Allocates the engine. Returns false if its transposition table could not be allocated */
+bool InitializeOpponent(void);
+
+/* Frees the engine */
+void FreeOpponent(void);
+
+/* Toggles the mode; when turned on the engine takes the side that is not to move */
+void ToggleEngineOpponent(void);
+
+/* Starts the engine's search when it is its turn and plays the move once it is done (call once per frame) */
+void UpdateEngineOpponent(void);
+
+/* Returns true while the engine is searching on its background thread */
+bool IsEngineThinking(void);
+
+/* Undoes the last move; in engine mode also the engine's reply so the user is to move again */
+void UndoPlayerMove(void);
+
+/* Redoes the last undone move; in engine mode also the engine's reply */
+void RedoPlayerMove(void);
+
+/* Jumps to a ply of the game (history scrubber); in engine mode lands on a ply where the user is to move */
+void JumpPlayerToPly(size_t ply);
+
+/* Result of the engine's last search (depth 0 if it has not moved yet or played a book move) */
+const SearchResult *LastEngineSearch(void);
+
+/* Destinations of the opening book moves of the piece on square in the current position */
+Bitboard BookTargets(int square);
+
+/* Number of book moves of the current position, -1 if no opening book is open */
+int BookMoveCount(void);
+
+#endif /* OPPONENT_H */
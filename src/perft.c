@@ -0,0 +1,295 @@
+/**
+ * perft.c
+ *
+ * Responsibilities:
+ * - Command-line perft tool built on libchesscore (no window, no audio).
+ * - Count the leaf nodes of the legal move tree to a given depth, optionally split per
+ *   root move (divide), and report the throughput in nodes per second.
+ * - Run the standard perft suite and compare against the published node counts.
+ *
+ * Usage:
+ *   perft <depth> [fen]          count nodes (defaults to the starting position)
+ *   perft divide <depth> [fen]   also print the node count below every root move
+ *   perft suite [depth]          run the standard positions (optionally capped at depth)
+ *
+ * Notes:
+ * - The FEN may be passed quoted or as separate arguments.
+ * - Exit status is 0 when every count is correct, 1 on a mismatch or bad input, so the
+ *   suite can gate any performance change.
+ * - Depth 1 is bulk-counted (the size of the legal move list) like most perft tools,
+ *   so the reported nodes/sec measure generation plus make/unmake, not leaf visits.
+ */
+
+#include "chesscore.h"
+#include "movegen.h"
+#include "pgn.h"
+#include "position.h"
+#include "settings.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Deepest level listed for any suite position */
+#define MAX_SUITE_DEPTH 6
+
+/**
+ * PerftCase
+ *
+ * One standard position and its known node counts (expected[d - 1] is the count at depth d,
+ * for d = 1..depth). A full suite run visits about 626M nodes.
+ */
+typedef struct PerftCase
+{
+    const char *name;
+    const char *fen;
+    int depth;
+    uint64_t expected[MAX_SUITE_DEPTH];
+} PerftCase;
+
+/* Positions and counts from the Chess Programming Wiki "Perft Results" page */
+static const PerftCase PerftSuite[] = {
+    {"startpos", STARTING_FEN, 6, {20, 400, 8902, 197281, 4865609, 119060324}},
+    {"kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 5, {48, 2039, 97862, 4085603, 193690690}},
+    {"position3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 6, {14, 191, 2812, 43238, 674624, 11030083}},
+    {"position4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 5, {6, 264, 9467, 422333, 15833292}},
+    {"position4-mirrored", "r2q1rk1/pP1p2pp/Q4n2/bbp1p3/Np6/1B3NBn/pPPP1PPP/R3K2R b KQ - 0 1", 5, {6, 264, 9467, 422333, 15833292}},
+    {"position5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 5, {44, 1486, 62379, 2103487, 89941194}},
+    {"position6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 5, {46, 2079, 89890, 3894594, 164075551}},
+};
+
+#define PERFT_SUITE_SIZE ((int)(sizeof PerftSuite / sizeof PerftSuite[0]))
+
+// Local prototypes
+static uint64_t Perft(Position *pos, int depth);
+static uint64_t Divide(Position *pos, int depth);
+static bool ParseDepth(const char *text, int *depth);
+static bool ReadPosition(Position *pos, int argc, char **argv);
+static int RunSingle(Position *pos, int depth, bool divide);
+static int RunSuite(int depthCap);
+static void PrintUsage(const char *program);
+
+int main(int argc, char **argv)
+{
+    Position pos;
+    int depth = 0;
+
+    InitChessCore();
+
+    if (argc >= 2 && strcmp(argv[1], "suite") == 0)
+    {
+        if (argc >= 3 && !ParseDepth(argv[2], &depth))
+        {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+        return RunSuite(depth);
+    }
+
+    bool divide = (argc >= 2 && strcmp(argv[1], "divide") == 0);
+    int first = divide ? 2 : 1;
+
+    if (argc <= first || !ParseDepth(argv[first], &depth))
+    {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    if (!ReadPosition(&pos, argc - first - 1, argv + first + 1))
+    {
+        fprintf(stderr, "Invalid FEN\n");
+        return 1;
+    }
+
+    return RunSingle(&pos, depth, divide);
+}
+
+/**
+ * Perft (static)
+ *
+ * Number of leaf nodes depth plies below pos. pos is restored before returning.
+ */
+static uint64_t Perft(Position *pos, int depth)
+{
+    MoveList list;
+    uint64_t nodes = 0;
+
+    int count = GenerateLegalMoves(pos, &list);
+
+    if (depth <= 1)
+    {
+        return (depth == 1) ? (uint64_t)count : 1;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        UndoInfo undo;
+        MakeMove(pos, list.moves[i], &undo);
+        nodes += Perft(pos, depth - 1);
+        UnmakeMove(pos, list.moves[i], &undo);
+    }
+
+    return nodes;
+}
+
+/**
+ * Divide (static)
+ *
+ * Like Perft, but prints "<move>: <nodes>" for every root move (UCI notation), the format
+ * other engines use, so a wrong total can be bisected move by move.
+ */
+static uint64_t Divide(Position *pos, int depth)
+{
+    MoveList list;
+    uint64_t total = 0;
+
+    int count = GenerateLegalMoves(pos, &list);
+
+    for (int i = 0; i < count; i++)
+    {
+        UndoInfo undo;
+        MakeMove(pos, list.moves[i], &undo);
+        uint64_t nodes = Perft(pos, depth - 1);
+        UnmakeMove(pos, list.moves[i], &undo);
+
+        char uci[MAX_UCI_MOVE_LENGTH];
+        MoveToUci(list.moves[i], uci);
+        printf("%s: %llu\n", uci, (unsigned long long)nodes);
+        total += nodes;
+    }
+
+    printf("\nMoves: %d\n", count);
+    return total;
+}
+
+/**
+ * ParseDepth (static)
+ *
+ * Read a depth argument in 1..20. Returns false for anything else.
+ */
+static bool ParseDepth(const char *text, int *depth)
+{
+    char *end = NULL;
+    long value = strtol(text, &end, 10);
+
+    if (end == text || *end != '\0' || value < 1 || value > 20)
+    {
+        return false;
+    }
+
+    *depth = (int)value;
+    return true;
+}
+
+/**
+ * ReadPosition (static)
+ *
+ * Build the position from the remaining arguments: none means the starting position,
+ * otherwise the arguments are joined with spaces and parsed as one FEN.
+ */
+static bool ReadPosition(Position *pos, int argc, char **argv)
+{
+    char fen[MAX_FEN_BUFFER_SIZE + 1] = "";
+    size_t length = 0;
+
+    if (argc <= 0)
+    {
+        return PositionFromFEN(pos, STARTING_FEN);
+    }
+
+    for (int i = 0; i < argc; i++)
+    {
+        int written = snprintf(fen + length, sizeof fen - length, "%s%s", (i > 0) ? " " : "", argv[i]);
+        if (written < 0 || (size_t)written >= sizeof fen - length)
+        {
+            return false;
+        }
+        length += (size_t)written;
+    }
+
+    return PositionFromFEN(pos, fen);
+}
+
+/**
+ * RunSingle (static)
+ *
+ * Perft (or divide) one position and print nodes, time and nodes/sec.
+ */
+static int RunSingle(Position *pos, int depth, bool divide)
+{
+    double start = MonotonicSeconds();
+    uint64_t nodes = divide ? Divide(pos, depth) : Perft(pos, depth);
+    double elapsed = MonotonicSeconds() - start;
+
+    printf("Nodes: %llu\n", (unsigned long long)nodes);
+    printf("Time: %.3f s\n", elapsed);
+    printf("NPS: %.0f\n", elapsed > 0 ? (double)nodes / elapsed : 0.0);
+    return 0;
+}
+
+/**
+ * RunSuite (static)
+ *
+ * Run every suite position from depth 1 to its deepest known count (or to depthCap if it
+ * is lower) and compare each count with the expected one.
+ *
+ * Returns:
+ *  - 0 if every count matched, 1 otherwise.
+ */
+static int RunSuite(int depthCap)
+{
+    uint64_t totalNodes = 0;
+    double totalTime = 0;
+    int failures = 0;
+
+    for (int i = 0; i < PERFT_SUITE_SIZE; i++)
+    {
+        const PerftCase *test = &PerftSuite[i];
+        int maxDepth = (depthCap > 0 && depthCap < test->depth) ? depthCap : test->depth;
+        Position pos;
+
+        if (!PositionFromFEN(&pos, test->fen))
+        {
+            printf("%-20s FEN rejected\n", test->name);
+            failures++;
+            continue;
+        }
+
+        for (int depth = 1; depth <= maxDepth; depth++)
+        {
+            double start = MonotonicSeconds();
+            uint64_t nodes = Perft(&pos, depth);
+            double elapsed = MonotonicSeconds() - start;
+            bool ok = (nodes == test->expected[depth - 1]);
+
+            printf("%-20s depth %d %12llu %s", test->name, depth, (unsigned long long)nodes, ok ? "ok  " : "FAIL");
+            if (!ok)
+            {
+                printf(" (expected %llu)", (unsigned long long)test->expected[depth - 1]);
+                failures++;
+            }
+            printf("  %8.3f s  %12.0f nps\n", elapsed, elapsed > 0 ? (double)nodes / elapsed : 0.0);
+
+            totalNodes += nodes;
+            totalTime += elapsed;
+        }
+    }
+
+    printf("\n%s: %llu nodes in %.3f s (%.0f nps), %d failure(s)\n", failures ? "FAILED" : "PASSED", (unsigned long long)totalNodes, totalTime, totalTime > 0 ? (double)totalNodes / totalTime : 0.0, failures);
+
+    return failures ? 1 : 0;
+}
+
+/**
+ * PrintUsage (static)
+ */
+static void PrintUsage(const char *program)
+{
+    fprintf(stderr,
+            "Usage:\n"
+            "  %s <depth> [fen]          count leaf nodes (default: starting position)\n"
+            "  %s divide <depth> [fen]   per-root-move counts\n"
+            "  %s suite [depth]          standard positions against known counts\n",
+            program, program, program);
+}
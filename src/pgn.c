@@ -0,0 +1,1063 @@
+/**
+ * pgn.c
+ *
+ * Responsibilities:
+ * - Convert moves to and from SAN (MoveToSAN, MoveFromSAN) and UCI long algebraic
+ *   notation (MoveToUci, MoveFromUci), the one copy the UCI engine, the server and the
+ *   tools share.
+ * - Read PGN databases game by game, replaying every move on a Position (ReadPgnGame).
+ * - Write a game as PGN (WritePGN).
+ *
+ * Notes:
+ * - Games are replayed with GenerateLegalMoves + MakeMove only; nothing here touches the
+ *   GUI, so importing does not pay for textures, sounds or the per-move rule checks of
+ *   MovePiece.
+ * - The reader is lenient where real databases are sloppy: "0-0" for castling, missing
+ *   results, a game that ends where the next tag section begins, annotations glued to
+ *   moves ("e4!?"). A move that is illegal or ambiguous ends the replay of its game
+ *   (PgnGame.error); the rest of the movetext is skipped and the next game is read.
+ *
+ * Implementation Details:
+ * - The input is consumed one character at a time out of the reader's fixed buffer, which
+ *   is refilled with fread. Only tag values and move tokens are copied (into small fixed
+ *   arrays); comments, variations and NAGs are skipped without being stored, so neither a
+ *   game nor a comment of any length needs more memory.
+ * - Move numbers, NAGs ($n), comments ({...} and ;...), "%" escape lines and recursive
+ *   variations are skipped. Variations are skipped whole, including comments inside them.
+ */
+
+#include "pgn.h"
+#include "bitboard.h"
+#include "movegen.h"
+#include "piece.h"
+#include "position.h"
+#include "settings.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* Longest move token or tag name read; longer ones are truncated (and never match) */
+#define MAX_PGN_TOKEN_LENGTH 32
+
+/* Movetext column the writer wraps at (the PGN standard asks for lines under 80 characters) */
+#define PGN_LINE_WIDTH 79
+
+#define PGN_EOF (-1)
+
+#define FILE_A_MASK 0x0101010101010101ULL
+#define RANK_8_MASK 0x00000000000000FFULL
+
+// Local prototypes
+static int PeekChar(PgnReader *reader);
+static void SkipChar(PgnReader *reader);
+static void SkipLine(PgnReader *reader);
+static void SkipSeparators(PgnReader *reader);
+static void SkipVariation(PgnReader *reader);
+static bool IsSymbolChar(int c);
+static size_t ReadSymbol(PgnReader *reader, char *token, size_t size);
+static void ReadTag(PgnReader *reader, PgnGame *game, bool *hasFen, char *fen, size_t fenSize);
+static bool IsResultToken(const char *token, size_t length);
+static void PlaySAN(PgnGame *game, const char *token, size_t length, uint64_t line);
+static Bitboard SANCandidates(const Position *pos, PieceType type, int to, bool pawnCapture);
+static ChessMove CandidateMove(const Position *pos, int from, int to, PieceType type, PieceType promotion);
+static PieceType PieceFromSANLetter(char letter);
+static char SANLetter(PieceType type);
+static void CopyTag(char *tag, const char *value);
+static void WriteTag(FILE *file, const char *name, const char *value);
+
+/**
+ * MoveToSAN
+ *
+ * Parameters:
+ *  - pos:    position the move is played from.
+ *  - move:   a legal move of pos (from GenerateLegalMoves).
+ *  - buffer: destination of the NUL-terminated SAN.
+ *  - size:   capacity of buffer (MAX_SAN_LENGTH always suffice).
+ *
+ * Returns:
+ *  - The length of the SAN; 0 if buffer is too small (it then holds an empty string).
+ *
+ * Behavior:
+ *  - Pieces are disambiguated by file, then rank, then both, only when another piece of
+ *    the same type can reach the same square; pawn captures always name their file.
+ *  - Appends '+' for a check and '#' for a mate (the move is played on a copy).
+ */
+size_t MoveToSAN(const Position *pos, ChessMove move, char *buffer, size_t size)
+{
+    char san[MAX_SAN_LENGTH];
+    size_t length = 0;
+    int from = MOVE_FROM(move);
+    int to = MOVE_TO(move);
+    MoveFlag flag = MOVE_FLAG(move);
+
+    if (flag == MOVE_CASTLE_KING_SIDE || flag == MOVE_CASTLE_QUEEN_SIDE)
+    {
+        const char *castle = (flag == MOVE_CASTLE_KING_SIDE) ? "O-O" : "O-O-O";
+        length = strlen(castle);
+        memcpy(san, castle, length);
+    }
+    else
+    {
+        Team team = pos->side;
+        PieceType type = PieceTypeAt(&pos->bitboards, from, &team);
+
+        if (type == PIECE_PAWN)
+        {
+            if (MOVE_IS_CAPTURE(move))
+            {
+                san[length++] = (char)('a' + SQUARE_COL(from));
+            }
+        }
+        else
+        {
+            MoveList list;
+            Bitboard same = pos->bitboards.pieces[pos->side][type] & ~SQUARE_BIT(from);
+            bool ambiguous = false;
+            bool sameFile = false;
+            bool sameRank = false;
+
+            GenerateLegalMoves(pos, &list);
+            for (int i = 0; i < list.count; i++)
+            {
+                int other = MOVE_FROM(list.moves[i]);
+
+                if (MOVE_TO(list.moves[i]) == to && (same & SQUARE_BIT(other)))
+                {
+                    ambiguous = true;
+                    sameFile = sameFile || SQUARE_COL(other) == SQUARE_COL(from);
+                    sameRank = sameRank || SQUARE_ROW(other) == SQUARE_ROW(from);
+                }
+            }
+
+            san[length++] = SANLetter(type);
+            if (ambiguous && (!sameFile || sameRank))
+            {
+                san[length++] = (char)('a' + SQUARE_COL(from));
+            }
+            if (ambiguous && sameFile)
+            {
+                san[length++] = (char)('8' - SQUARE_ROW(from));
+            }
+        }
+
+        if (MOVE_IS_CAPTURE(move))
+        {
+            san[length++] = 'x';
+        }
+        san[length++] = (char)('a' + SQUARE_COL(to));
+        san[length++] = (char)('8' - SQUARE_ROW(to));
+
+        if (MOVE_IS_PROMOTION(move))
+        {
+            san[length++] = '=';
+            san[length++] = SANLetter(MovePromotionType(move));
+        }
+    }
+
+    Position next = *pos;
+    UndoInfo undo;
+    MakeMove(&next, move, &undo);
+    if (IsInCheck(&next))
+    {
+        MoveList replies;
+        san[length++] = (GenerateLegalMoves(&next, &replies) == 0) ? '#' : '+';
+    }
+
+    if (length >= size)
+    {
+        if (size > 0)
+        {
+            buffer[0] = '\0';
+        }
+        return 0;
+    }
+
+    memcpy(buffer, san, length);
+    buffer[length] = '\0';
+    return length;
+}
+
+/**
+ * MoveFromSAN
+ *
+ * Parameters:
+ *  - pos:    position the move is played from.
+ *  - san:    the move text, e.g. "Nbd7", "exd6", "e8=Q+", "O-O" (also "0-0"); trailing
+ *            check marks and annotations ("+", "#", "!", "?") are ignored.
+ *  - length: characters of san.
+ *
+ * Returns:
+ *  - The legal ChessMove it names; 0 if it is malformed, names no legal move, or fits
+ *    more than one (insufficient disambiguation).
+ *
+ * Notes:
+ *  - Extra disambiguation is accepted ("Ng1f3", "Ng1-f3"), a missing one is not. A pawn
+ *    capture must name its file ("exd5") and castling is only read as O-O / O-O-O.
+ *  - This is the replay hot path, so it does not generate every legal move: the squares
+ *    a piece of that type could come from are found with the attack tables (attacks are
+ *    symmetric), and only those few candidates are played on a copy to see whether they
+ *    leave the king in check. Castling, rare enough, goes through GenerateLegalMoves.
+ */
+ChessMove MoveFromSAN(const Position *pos, const char *san, size_t length)
+{
+    while (length > 0 && (san[length - 1] == '+' || san[length - 1] == '#' || san[length - 1] == '!' || san[length - 1] == '?'))
+    {
+        length--;
+    }
+
+    if ((length == 3 && (memcmp(san, "O-O", 3) == 0 || memcmp(san, "0-0", 3) == 0)) ||
+        (length == 5 && (memcmp(san, "O-O-O", 5) == 0 || memcmp(san, "0-0-0", 5) == 0)))
+    {
+        MoveFlag castle = (length == 3) ? MOVE_CASTLE_KING_SIDE : MOVE_CASTLE_QUEEN_SIDE;
+        MoveList list;
+
+        GenerateLegalMoves(pos, &list);
+        for (int i = 0; i < list.count; i++)
+        {
+            if (MOVE_FLAG(list.moves[i]) == castle)
+            {
+                return list.moves[i];
+            }
+        }
+        return 0;
+    }
+
+    PieceType type = PIECE_PAWN;
+    size_t first = 0;
+    if (length > 0 && PieceFromSANLetter(san[0]) != PIECE_NONE)
+    {
+        type = PieceFromSANLetter(san[0]);
+        first = 1;
+    }
+
+    PieceType promotion = PIECE_NONE;
+    if (type == PIECE_PAWN && length >= 3 && PieceFromSANLetter(san[length - 1]) != PIECE_NONE)
+    {
+        promotion = PieceFromSANLetter(san[length - 1]);
+        length--;
+        if (san[length - 1] == '=')
+        {
+            length--;
+        }
+    }
+
+    if (length < first + 2 || san[length - 2] < 'a' || san[length - 2] > 'h' || san[length - 1] < '1' || san[length - 1] > '8')
+    {
+        return 0;
+    }
+    int to = SQUARE_INDEX('8' - san[length - 1], san[length - 2] - 'a');
+
+    int fromCol = -1;
+    int fromRow = -1;
+    for (size_t i = first; i < length - 2; i++)
+    {
+        char c = san[i];
+
+        if (c >= 'a' && c <= 'h')
+        {
+            fromCol = c - 'a';
+        }
+        else if (c >= '1' && c <= '8')
+        {
+            fromRow = '8' - c;
+        }
+        else if (c != 'x' && c != ':' && c != '-')
+        {
+            return 0;
+        }
+    }
+
+    Bitboard candidates = SANCandidates(pos, type, to, fromCol >= 0 && fromCol != SQUARE_COL(to));
+    ChessMove found = 0;
+
+    if (fromCol >= 0)
+    {
+        candidates &= FILE_A_MASK << fromCol;
+    }
+    if (fromRow >= 0)
+    {
+        candidates &= RANK_8_MASK << (fromRow * BOARD_SIZE);
+    }
+
+    while (candidates)
+    {
+        ChessMove move = CandidateMove(pos, PopLowestSquare(&candidates), to, type, promotion);
+
+        if (move == 0)
+        {
+            continue;
+        }
+
+        if (found != 0)
+        {
+            return 0;
+        }
+        found = move;
+    }
+
+    return found;
+}
+
+/**
+ * MoveToUci
+ *
+ * Parameters:
+ *  - buffer: at least MAX_UCI_MOVE_LENGTH bytes; receives e.g. "e2e4" or "e7e8q" (row 0
+ *    is rank 8, promotions in lowercase).
+ */
+size_t MoveToUci(ChessMove move, char *buffer)
+{
+    int from = MOVE_FROM(move);
+    int to = MOVE_TO(move);
+    size_t length = 0;
+
+    buffer[length++] = (char)('a' + SQUARE_COL(from));
+    buffer[length++] = (char)('0' + BOARD_SIZE - SQUARE_ROW(from));
+    buffer[length++] = (char)('a' + SQUARE_COL(to));
+    buffer[length++] = (char)('0' + BOARD_SIZE - SQUARE_ROW(to));
+    if (MOVE_IS_PROMOTION(move))
+    {
+        buffer[length++] = (char)(SANLetter(MovePromotionType(move)) - 'A' + 'a');
+    }
+    buffer[length] = '\0';
+
+    return length;
+}
+
+/**
+ * MoveFromUci
+ *
+ * Returns:
+ *  - The legal move of pos from the first to the second square, promoting to the piece of
+ *    the fifth letter (either case) if there is one; 0 if the text is malformed or no
+ *    legal move matches.
+ */
+ChessMove MoveFromUci(const Position *pos, const char *text, size_t length)
+{
+    if (length < 4 || length > 5 || text[0] < 'a' || text[0] > 'h' || text[1] < '1' || text[1] > '8' || text[2] < 'a' ||
+        text[2] > 'h' || text[3] < '1' || text[3] > '8')
+    {
+        return 0;
+    }
+
+    int from = SQUARE_INDEX(BOARD_SIZE - (text[1] - '0'), text[0] - 'a');
+    int to = SQUARE_INDEX(BOARD_SIZE - (text[3] - '0'), text[2] - 'a');
+    PieceType promotion = PIECE_NONE;
+    if (length == 5)
+    {
+        char letter = (text[4] >= 'a' && text[4] <= 'z') ? (char)(text[4] - 'a' + 'A') : text[4];
+
+        promotion = PieceFromSANLetter(letter);
+        if (promotion == PIECE_NONE)
+        {
+            return 0;
+        }
+    }
+
+    MoveList list;
+    GenerateLegalMoves(pos, &list);
+    for (int i = 0; i < list.count; i++)
+    {
+        ChessMove move = list.moves[i];
+
+        if (MOVE_FROM(move) == from && MOVE_TO(move) == to && MovePromotionType(move) == promotion)
+        {
+            return move;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * ClearPgnGame
+ */
+void ClearPgnGame(PgnGame *game)
+{
+    CopyTag(game->event, "?");
+    CopyTag(game->site, "?");
+    CopyTag(game->date, "????.??.??");
+    CopyTag(game->round, "?");
+    CopyTag(game->white, "?");
+    CopyTag(game->black, "?");
+    CopyTag(game->result, "*");
+
+    PositionFromFEN(&game->start, STARTING_FEN);
+    game->end = game->start;
+    game->plyCount = 0;
+    game->line = 0;
+    game->error = NULL;
+    game->errorLine = 0;
+}
+
+/**
+ * InitializePgnReader
+ */
+void InitializePgnReader(PgnReader *reader, FILE *file)
+{
+    reader->file = file;
+    reader->cursor = 0;
+    reader->length = 0;
+    reader->line = 1;
+    reader->bytes = 0;
+    reader->lineStart = true;
+}
+
+/**
+ * ReadPgnGame
+ *
+ * Parameters:
+ *  - reader: stream to read from (see InitializePgnReader).
+ *  - game:   receives the tags, the moves and the final position.
+ *
+ * Returns:
+ *  - true if a game was read, also when its movetext holds an illegal move (see
+ *    PgnGame.error); false once only whitespace and comments are left.
+ *
+ * Behavior:
+ *  - A FEN tag sets the start position (an invalid one is an error and no move is
+ *    replayed); otherwise the game starts from the standard position.
+ *  - The game ends at its result token, or just before the next '[' / the end of input.
+ *    A result token overrides the Result tag.
+ */
+bool ReadPgnGame(PgnReader *reader, PgnGame *game)
+{
+    char fen[MAX_PGN_TAG_LENGTH];
+    bool hasFen = false;
+
+    ClearPgnGame(game);
+    SkipSeparators(reader);
+    if (PeekChar(reader) == PGN_EOF)
+    {
+        return false;
+    }
+    game->line = reader->line;
+
+    while (PeekChar(reader) == '[')
+    {
+        ReadTag(reader, game, &hasFen, fen, sizeof fen);
+        SkipSeparators(reader);
+    }
+
+    if (hasFen && !PositionFromFEN(&game->start, fen))
+    {
+        game->error = "invalid FEN tag";
+        game->errorLine = game->line;
+    }
+    game->end = game->start;
+
+    for (;;)
+    {
+        SkipSeparators(reader);
+        int c = PeekChar(reader);
+
+        if (c == PGN_EOF || c == '[')
+        {
+            break;
+        }
+
+        if (c == '(')
+        {
+            SkipVariation(reader);
+        }
+        else if (c == '*')
+        {
+            SkipChar(reader);
+            CopyTag(game->result, "*");
+            break;
+        }
+        else if (IsSymbolChar(c))
+        {
+            char token[MAX_PGN_TOKEN_LENGTH];
+            uint64_t line = reader->line;
+            size_t length = ReadSymbol(reader, token, sizeof token);
+
+            if (IsResultToken(token, length))
+            {
+                CopyTag(game->result, token);
+                break;
+            }
+
+            // Move numbers ("12", the dots are skipped as separators) and NAG digits
+            size_t digits = 0;
+            while (digits < length && token[digits] >= '0' && token[digits] <= '9')
+            {
+                digits++;
+            }
+
+            if (digits < length && game->error == NULL)
+            {
+                PlaySAN(game, token, length, line);
+            }
+        }
+        else
+        {
+            // '.', '!', '?', '$' and anything else outside a token
+            SkipChar(reader);
+        }
+    }
+
+    return true;
+}
+
+/**
+ * WritePGN
+ *
+ * Parameters:
+ *  - file: open for writing.
+ *  - game: the tags, the start position and the moves to write (the moves must be legal
+ *          in sequence; end is not used).
+ *
+ * Returns:
+ *  - false if writing failed (ferror).
+ *
+ * Behavior:
+ *  - Writes the Seven Tag Roster, then SetUp/FEN when the game does not start from the
+ *    standard position, a blank line, the movetext wrapped at PGN_LINE_WIDTH columns and
+ *    the result, followed by a blank line.
+ */
+bool WritePGN(FILE *file, const PgnGame *game)
+{
+    char fen[MAX_POSITION_FEN_LENGTH];
+
+    WriteTag(file, "Event", game->event);
+    WriteTag(file, "Site", game->site);
+    WriteTag(file, "Date", game->date);
+    WriteTag(file, "Round", game->round);
+    WriteTag(file, "White", game->white);
+    WriteTag(file, "Black", game->black);
+    WriteTag(file, "Result", game->result);
+
+    PositionToFEN(&game->start, fen, sizeof fen);
+    if (strcmp(fen, STARTING_FEN) != 0)
+    {
+        WriteTag(file, "SetUp", "1");
+        WriteTag(file, "FEN", fen);
+    }
+    fputc('\n', file);
+
+    Position pos = game->start;
+    int column = 0;
+
+    for (int ply = 0; ply <= game->plyCount; ply++)
+    {
+        // Move number (before White's move, or before the first move when Black starts), then the move; the result last
+        char word[MAX_SAN_LENGTH + 16];
+        int length = 0;
+
+        if (ply == game->plyCount)
+        {
+            length = snprintf(word, sizeof word, "%s", game->result);
+        }
+        else
+        {
+            if (pos.side == TEAM_WHITE)
+            {
+                length = snprintf(word, sizeof word, "%d. ", pos.fullMoveNumber);
+            }
+            else if (ply == 0)
+            {
+                length = snprintf(word, sizeof word, "%d... ", pos.fullMoveNumber);
+            }
+
+            UndoInfo undo;
+            length += (int)MoveToSAN(&pos, game->moves[ply], word + length, sizeof word - (size_t)length);
+            MakeMove(&pos, game->moves[ply], &undo);
+        }
+
+        if (column > 0 && column + 1 + length > PGN_LINE_WIDTH)
+        {
+            fputc('\n', file);
+            column = 0;
+        }
+        else if (column > 0)
+        {
+            fputc(' ', file);
+            column++;
+        }
+
+        fputs(word, file);
+        column += length;
+    }
+
+    fputs("\n\n", file);
+    return !ferror(file);
+}
+
+/**
+ * PeekChar (static)
+ *
+ * The next character of the input (PGN_EOF at the end), refilling the buffer if needed.
+ */
+static int PeekChar(PgnReader *reader)
+{
+    if (reader->cursor == reader->length)
+    {
+        reader->length = fread(reader->buffer, 1, sizeof reader->buffer, reader->file);
+        reader->cursor = 0;
+        if (reader->length == 0)
+        {
+            return PGN_EOF;
+        }
+    }
+
+    return (unsigned char)reader->buffer[reader->cursor];
+}
+
+/**
+ * SkipChar (static)
+ *
+ * Consume the character PeekChar returned (line counting happens here).
+ */
+static void SkipChar(PgnReader *reader)
+{
+    if (reader->cursor < reader->length)
+    {
+        char c = reader->buffer[reader->cursor++];
+
+        reader->bytes++;
+        reader->lineStart = (c == '\n');
+        if (c == '\n')
+        {
+            reader->line++;
+        }
+    }
+}
+
+/**
+ * SkipLine (static)
+ *
+ * Consume everything up to and including the next newline.
+ */
+static void SkipLine(PgnReader *reader)
+{
+    int c;
+
+    while ((c = PeekChar(reader)) != PGN_EOF)
+    {
+        SkipChar(reader);
+        if (c == '\n')
+        {
+            break;
+        }
+    }
+}
+
+/**
+ * SkipSeparators (static)
+ *
+ * Consume whitespace, {brace} comments, ;rest-of-line comments and "%" escape lines.
+ */
+static void SkipSeparators(PgnReader *reader)
+{
+    for (;;)
+    {
+        int c = PeekChar(reader);
+
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
+        {
+            SkipChar(reader);
+        }
+        else if (c == '{')
+        {
+            while ((c = PeekChar(reader)) != PGN_EOF && c != '}')
+            {
+                SkipChar(reader);
+            }
+            SkipChar(reader);
+        }
+        else if (c == ';' || (c == '%' && reader->lineStart))
+        {
+            SkipLine(reader);
+        }
+        else
+        {
+            return;
+        }
+    }
+}
+
+/**
+ * SkipVariation (static)
+ *
+ * Consume a recursive annotation variation "( ... )", nested ones and comments included.
+ */
+static void SkipVariation(PgnReader *reader)
+{
+    int depth = 0;
+
+    do
+    {
+        SkipSeparators(reader);
+        int c = PeekChar(reader);
+
+        if (c == PGN_EOF)
+        {
+            return;
+        }
+
+        depth += (c == '(') - (c == ')');
+        SkipChar(reader);
+    } while (depth > 0);
+}
+
+/**
+ * IsSymbolChar (static)
+ *
+ * Characters of a PGN symbol token (moves, move numbers, results).
+ */
+static bool IsSymbolChar(int c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+           c == '-' || c == '/' || c == '=' || c == '+' || c == '#' || c == '_' || c == ':';
+}
+
+/**
+ * ReadSymbol (static)
+ *
+ * Consume a symbol token into token (truncated to size - 1 characters). Returns its length.
+ */
+static size_t ReadSymbol(PgnReader *reader, char *token, size_t size)
+{
+    size_t length = 0;
+    int c;
+
+    while ((c = PeekChar(reader)) != PGN_EOF && IsSymbolChar(c))
+    {
+        if (length + 1 < size)
+        {
+            token[length++] = (char)c;
+        }
+        SkipChar(reader);
+    }
+
+    token[length] = '\0';
+    return length;
+}
+
+/**
+ * ReadTag (static)
+ *
+ * Consume one tag pair '[Name "value"]' and store the value if the tag is one PgnGame
+ * keeps (the FEN tag goes to fen). A malformed tag is skipped up to its ']' or line end.
+ */
+static void ReadTag(PgnReader *reader, PgnGame *game, bool *hasFen, char *fen, size_t fenSize)
+{
+    char name[MAX_PGN_TOKEN_LENGTH];
+    char value[MAX_PGN_TAG_LENGTH];
+    size_t length = 0;
+    int c;
+
+    SkipChar(reader); // '['
+    while ((c = PeekChar(reader)) == ' ' || c == '\t')
+    {
+        SkipChar(reader);
+    }
+    ReadSymbol(reader, name, sizeof name);
+    while ((c = PeekChar(reader)) == ' ' || c == '\t')
+    {
+        SkipChar(reader);
+    }
+
+    if (c != '"')
+    {
+        while ((c = PeekChar(reader)) != PGN_EOF && c != ']' && c != '\n')
+        {
+            SkipChar(reader);
+        }
+        if (c == ']')
+        {
+            SkipChar(reader);
+        }
+        return;
+    }
+
+    SkipChar(reader);
+    while ((c = PeekChar(reader)) != PGN_EOF && c != '"' && c != '\n')
+    {
+        SkipChar(reader);
+        if (c == '\\' && ((c = PeekChar(reader)) == '"' || c == '\\'))
+        {
+            SkipChar(reader);
+        }
+        if (length + 1 < sizeof value)
+        {
+            value[length++] = (char)c;
+        }
+    }
+    value[length] = '\0';
+
+    while ((c = PeekChar(reader)) != PGN_EOF && c != ']' && c != '\n')
+    {
+        SkipChar(reader);
+    }
+    if (c == ']')
+    {
+        SkipChar(reader);
+    }
+
+    static const struct
+    {
+        const char *name;
+        size_t offset;
+    } KEPT_TAGS[] = {
+        {"Event", offsetof(PgnGame, event)},
+        {"Site", offsetof(PgnGame, site)},
+        {"Date", offsetof(PgnGame, date)},
+        {"Round", offsetof(PgnGame, round)},
+        {"White", offsetof(PgnGame, white)},
+        {"Black", offsetof(PgnGame, black)},
+        {"Result", offsetof(PgnGame, result)},
+    };
+
+    if (strcmp(name, "FEN") == 0)
+    {
+        *hasFen = true;
+        memcpy(fen, value, (length < fenSize) ? length + 1 : fenSize);
+        fen[fenSize - 1] = '\0';
+        return;
+    }
+
+    for (size_t i = 0; i < sizeof KEPT_TAGS / sizeof KEPT_TAGS[0]; i++)
+    {
+        if (strcmp(name, KEPT_TAGS[i].name) == 0)
+        {
+            CopyTag((char *)game + KEPT_TAGS[i].offset, value);
+            return;
+        }
+    }
+}
+
+/**
+ * IsResultToken (static)
+ */
+static bool IsResultToken(const char *token, size_t length)
+{
+    return (length == 3 && (strcmp(token, "1-0") == 0 || strcmp(token, "0-1") == 0)) ||
+           (length == 7 && strcmp(token, "1/2-1/2") == 0);
+}
+
+/**
+ * PlaySAN (static)
+ *
+ * Replay one move token on game->end and append it to game->moves; an illegal or
+ * ambiguous move (or one past MAX_PGN_PLIES) sets game->error instead.
+ */
+static void PlaySAN(PgnGame *game, const char *token, size_t length, uint64_t line)
+{
+    ChessMove move = MoveFromSAN(&game->end, token, length);
+
+    if (move == 0)
+    {
+        game->error = "illegal or ambiguous move";
+        game->errorLine = line;
+        return;
+    }
+
+    if (game->plyCount == MAX_PGN_PLIES)
+    {
+        game->error = "game too long";
+        game->errorLine = line;
+        return;
+    }
+
+    UndoInfo undo;
+    game->moves[game->plyCount++] = move;
+    MakeMove(&game->end, move, &undo);
+}
+
+/**
+ * SANCandidates (static)
+ *
+ * Squares holding a piece of type (of the side to move) that could move to to, ignoring
+ * pins and checks: the piece's attacks taken backwards from to, or for a pawn the square(s)
+ * behind to (pawnCapture selects the diagonal ones).
+ */
+static Bitboard SANCandidates(const Position *pos, PieceType type, int to, bool pawnCapture)
+{
+    const Bitboards *bb = &pos->bitboards;
+    Team side = pos->side;
+    Team enemy = (side == TEAM_WHITE) ? TEAM_BLACK : TEAM_WHITE;
+    Bitboard pieces = bb->pieces[side][type];
+
+    if (bb->teams[side] & SQUARE_BIT(to))
+    {
+        return 0;
+    }
+
+    if (type != PIECE_PAWN)
+    {
+        return PieceAttacks(type, side, to, bb->occupied) & pieces;
+    }
+
+    if (pawnCapture)
+    {
+        // The squares a pawn of side captures to from are those an enemy pawn on to attacks
+        return PawnAttackTable[enemy][to] & pieces;
+    }
+
+    // White pawns move towards row 0
+    int back = (side == TEAM_WHITE) ? BOARD_SIZE : -BOARD_SIZE;
+    int one = to + back;
+    int startRow = (side == TEAM_WHITE) ? BOARD_SIZE - 2 : 1;
+
+    if (one < 0 || one >= SQUARE_COUNT || (bb->occupied & SQUARE_BIT(to)))
+    {
+        return 0;
+    }
+    if (pieces & SQUARE_BIT(one))
+    {
+        return SQUARE_BIT(one);
+    }
+
+    int two = one + back;
+    if (!(bb->occupied & SQUARE_BIT(one)) && two >= 0 && two < SQUARE_COUNT && SQUARE_ROW(two) == startRow)
+    {
+        return pieces & SQUARE_BIT(two);
+    }
+
+    return 0;
+}
+
+/**
+ * CandidateMove (static)
+ *
+ * Encode the move of the piece on from to to (its flag follows from the board: capture,
+ * double push, en passant, promotion to promotion) and return it if it is legal, 0 if it
+ * is not (king left in check, pawn capture onto an empty square, promotion missing or
+ * misplaced).
+ */
+static ChessMove CandidateMove(const Position *pos, int from, int to, PieceType type, PieceType promotion)
+{
+    const Bitboards *bb = &pos->bitboards;
+    Team side = pos->side;
+    Team enemy = (side == TEAM_WHITE) ? TEAM_BLACK : TEAM_WHITE;
+    bool capture = (bb->teams[enemy] & SQUARE_BIT(to)) != 0;
+    MoveFlag flag = capture ? MOVE_CAPTURE : MOVE_QUIET;
+
+    if (type == PIECE_PAWN)
+    {
+        bool lastRow = SQUARE_ROW(to) == ((side == TEAM_WHITE) ? 0 : BOARD_SIZE - 1);
+
+        if (SQUARE_COL(from) != SQUARE_COL(to) && !capture)
+        {
+            int targetRow = (side == TEAM_WHITE) ? 2 : 5;
+            int victim = SQUARE_INDEX((side == TEAM_WHITE) ? 3 : 4, pos->enPassantCol);
+
+            if (pos->enPassantCol < 0 || to != SQUARE_INDEX(targetRow, pos->enPassantCol) || !(bb->pieces[enemy][PIECE_PAWN] & SQUARE_BIT(victim)))
+            {
+                return 0;
+            }
+            flag = MOVE_EN_PASSANT;
+        }
+        else if (from - to == 2 * BOARD_SIZE || to - from == 2 * BOARD_SIZE)
+        {
+            flag = MOVE_DOUBLE_PUSH;
+        }
+
+        if (lastRow != (promotion != PIECE_NONE))
+        {
+            return 0;
+        }
+        if (lastRow)
+        {
+            static const MoveFlag PROMOTIONS[PIECE_TYPE_COUNT] = {
+                [PIECE_QUEEN] = MOVE_PROMOTE_QUEEN,
+                [PIECE_ROOK] = MOVE_PROMOTE_ROOK,
+                [PIECE_BISHOP] = MOVE_PROMOTE_BISHOP,
+                [PIECE_KNIGHT] = MOVE_PROMOTE_KNIGHT,
+            };
+
+            if (PROMOTIONS[promotion] == 0)
+            {
+                return 0;
+            }
+            flag = PROMOTIONS[promotion] | (capture ? MOVE_FLAG_CAPTURE_BIT : 0);
+        }
+    }
+
+    ChessMove move = ENCODE_MOVE(from, to, flag);
+    Position next = *pos;
+    UndoInfo undo;
+
+    MakeMove(&next, move, &undo);
+    int king = KingSquare(&next.bitboards, side);
+    if (king >= 0 && IsSquareAttacked(&next.bitboards, king, enemy))
+    {
+        return 0;
+    }
+
+    return move;
+}
+
+/**
+ * PieceFromSANLetter (static)
+ *
+ * Piece of an uppercase SAN letter (K, Q, R, B, N), PIECE_NONE for anything else.
+ */
+static PieceType PieceFromSANLetter(char letter)
+{
+    switch (letter)
+    {
+    case 'K':
+        return PIECE_KING;
+    case 'Q':
+        return PIECE_QUEEN;
+    case 'R':
+        return PIECE_ROOK;
+    case 'B':
+        return PIECE_BISHOP;
+    case 'N':
+        return PIECE_KNIGHT;
+    default:
+        return PIECE_NONE;
+    }
+}
+
+/**
+ * SANLetter (static)
+ */
+static char SANLetter(PieceType type)
+{
+    static const char LETTERS[PIECE_TYPE_COUNT] = {'?', 'K', 'Q', 'R', 'B', 'N', 'P'};
+
+    return LETTERS[type];
+}
+
+/**
+ * CopyTag (static)
+ *
+ * Copy value into a MAX_PGN_TAG_LENGTH tag field, truncating it.
+ */
+static void CopyTag(char *tag, const char *value)
+{
+    size_t length = strlen(value);
+
+    if (length >= MAX_PGN_TAG_LENGTH)
+    {
+        length = MAX_PGN_TAG_LENGTH - 1;
+    }
+    memcpy(tag, value, length);
+    tag[length] = '\0';
+}
+
+/**
+ * WriteTag (static)
+ *
+ * Write '[Name "value"]' with '"' and '\' escaped.
+ */
+static void WriteTag(FILE *file, const char *name, const char *value)
+{
+    fprintf(file, "[%s \"", name);
+    for (const char *c = value; *c != '\0'; c++)
+    {
+        if (*c == '"' || *c == '\\')
+        {
+            fputc('\\', file);
+        }
+        fputc(*c, file);
+    }
+    fputs("\"]\n", file);
+}
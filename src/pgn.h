@@ -0,0 +1,113 @@
+/**
+ * pgn.h
+ *
+ * Responsibilities:
+ * - Export SAN (Standard Algebraic Notation) and UCI long algebraic (e2e4, e7e8q)
+ *   conversion of ChessMoves.
+ * - Export a streaming PGN reader that replays every game with MakeMove, and a PGN writer.
+ *
+ * Notes:
+ * - The reader holds one fixed read buffer and one game at a time, so its memory does not
+ *   depend on the size of the database it reads (files of several GB, or a pipe).
+ * - This module does not include raylib; it is part of libchesscore (see chesscore.h).
+ */
+
+#ifndef PGN_H
+#define PGN_H
+
+#include "movegen.h"
+#include "position.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/* Longest SAN MoveToSAN writes, including the terminator ("Qa1xb2#", "exd8=Q+") */
+#define MAX_SAN_LENGTH 8
+
+/* Longest UCI move MoveToUci writes, including the terminator ("e7e8q") */
+#define MAX_UCI_MOVE_LENGTH 6
+
+/* Longest game a PgnGame holds; a longer game is reported as an error */
+#define MAX_PGN_PLIES 16384
+
+/* Characters kept of a tag value, including the terminator (longer values are truncated) */
+#define MAX_PGN_TAG_LENGTH 128
+
+/* Bytes the reader reads from its file at once */
+#define PGN_READ_BUFFER_SIZE (64 * 1024)
+
+/**
+ * PgnGame
+ *
+ * One game: the Seven Tag Roster, the start position, the moves and the final position.
+ *
+ * - start:     position before the first move (FEN tag, or the standard start).
+ * - moves:     the plyCount moves, legal in sequence from start.
+ * - end:       position after the last move.
+ * - line:      line of the file the game starts on (set by ReadPgnGame).
+ * - error:     NULL if the whole game was replayed; otherwise why the movetext stopped
+ *              being replayed at errorLine (moves holds the plies before it).
+ */
+typedef struct PgnGame
+{
+    char event[MAX_PGN_TAG_LENGTH];
+    char site[MAX_PGN_TAG_LENGTH];
+    char date[MAX_PGN_TAG_LENGTH];
+    char round[MAX_PGN_TAG_LENGTH];
+    char white[MAX_PGN_TAG_LENGTH];
+    char black[MAX_PGN_TAG_LENGTH];
+    char result[MAX_PGN_TAG_LENGTH];
+
+    Position start;
+    Position end;
+    ChessMove moves[MAX_PGN_PLIES];
+    int plyCount;
+
+    uint64_t line;
+    const char *error;
+    uint64_t errorLine;
+} PgnGame;
+
+/**
+ * PgnReader
+ *
+ * State of a streaming read over one FILE (see InitializePgnReader). Large (the read
+ * buffer is inline): keep it static or on the heap rather than on a thread's stack.
+ */
+typedef struct PgnReader
+{
+    FILE *file;
+    size_t cursor;
+    size_t length;
+    uint64_t line;
+    uint64_t bytes;
+    bool lineStart;
+    char buffer[PGN_READ_BUFFER_SIZE];
+} PgnReader;
+
+/* Writes the SAN of move (legal in pos) with its check/mate suffix. Returns its length, 0 if buffer is too small */
+size_t MoveToSAN(const Position *pos, ChessMove move, char *buffer, size_t size);
+
+/* Returns the legal move of pos that san (length characters, no terminator needed) names, or 0 if none or ambiguous */
+ChessMove MoveFromSAN(const Position *pos, const char *san, size_t length);
+
+/* Writes move in UCI long algebraic notation (e2e4, e7e8q) into buffer (MAX_UCI_MOVE_LENGTH bytes). Returns its length */
+size_t MoveToUci(ChessMove move, char *buffer);
+
+/* Returns the legal move of pos that text (length characters, no terminator needed) writes in UCI notation, or 0 if none */
+ChessMove MoveFromUci(const Position *pos, const char *text, size_t length);
+
+/* Fills the Seven Tag Roster with the PGN placeholders ("?", "*") and sets the standard start, no moves */
+void ClearPgnGame(PgnGame *game);
+
+/* Prepares reader to read games from file (opened for reading; the reader does not close it) */
+void InitializePgnReader(PgnReader *reader, FILE *file);
+
+/* Reads and replays the next game into game. Returns false at the end of the input */
+bool ReadPgnGame(PgnReader *reader, PgnGame *game);
+
+/* Writes game as PGN (tags, SetUp/FEN for a non-standard start, wrapped movetext). Returns false on a write error */
+bool WritePGN(FILE *file, const PgnGame *game);
+
+#endif /* PGN_H */
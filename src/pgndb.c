@@ -0,0 +1,239 @@
+/**
+ * pgndb.c
+ *
+ * Responsibilities:
+ * - Command-line front end of the game database (gamedb.h) built on libchesscore (no
+ *   window, no audio): build a database from PGN files, query it by position and print
+ *   its summary.
+ *
+ * Usage:
+ *   pgndb build <out.cdb> <file.pgn | ->...
+ *   pgndb query <db.cdb> <fen> [--limit N]
+ *   pgndb info <db.cdb>
+ *
+ *   build           replay every game of the PGN files ("-" reads standard input) and
+ *                   store the complete ones; games with an error are skipped and counted
+ *   query           list the games reaching the position (game number, first ply,
+ *                   players, result, event); --limit caps the list (default 20)
+ *   info            games, indexed positions and file size
+ *
+ * Notes:
+ * - Exit status is 0 on success, 1 on bad arguments, unreadable input or a failed build
+ *   (a failed build removes the incomplete output file).
+ * - The query time printed covers the index lookup only, not the reading of the games.
+ */
+
+#include "chesscore.h"
+#include "gamedb.h"
+#include "pgn.h"
+#include "position.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Games listed by a query unless --limit says otherwise */
+#define DEFAULT_QUERY_LIMIT 20
+
+/* One reader and one game for the whole run (both too large for the stack) */
+static PgnReader Reader;
+static PgnGame Game;
+
+// Local prototypes
+static int BuildDatabase(const char *output, char **inputs, int inputCount);
+static int QueryDatabase(const char *path, const char *fen, size_t limit);
+static int PrintDatabaseInfo(const char *path);
+static void PrintUsage(const char *program);
+
+int main(int argc, char **argv)
+{
+    InitChessCore();
+
+    if (argc >= 4 && strcmp(argv[1], "build") == 0)
+    {
+        return BuildDatabase(argv[2], argv + 3, argc - 3);
+    }
+    if ((argc == 4 || argc == 6) && strcmp(argv[1], "query") == 0)
+    {
+        long limit = DEFAULT_QUERY_LIMIT;
+        if (argc == 6 && (strcmp(argv[4], "--limit") != 0 || (limit = strtol(argv[5], NULL, 10)) < 0))
+        {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+        return QueryDatabase(argv[2], argv[3], (size_t)limit);
+    }
+    if (argc == 3 && strcmp(argv[1], "info") == 0)
+    {
+        return PrintDatabaseInfo(argv[2]);
+    }
+
+    PrintUsage(argv[0]);
+    return 1;
+}
+
+/**
+ * BuildDatabase (static)
+ *
+ * Build the database output from every complete game of the input files.
+ *
+ * Returns:
+ *  - The exit status (0 if every input was read and the database written).
+ */
+static int BuildDatabase(const char *output, char **inputs, int inputCount)
+{
+    GameDatabaseWriter writer;
+    if (!BeginGameDatabase(&writer, output))
+    {
+        fprintf(stderr, "%s: cannot create\n", output);
+        return 1;
+    }
+
+    uint64_t games = 0;
+    uint64_t skipped = 0;
+    uint64_t plies = 0;
+    bool readable = true;
+    double start = MonotonicSeconds();
+
+    for (int i = 0; i < inputCount && readable; i++)
+    {
+        bool isStdin = strcmp(inputs[i], "-") == 0;
+        FILE *file = isStdin ? stdin : fopen(inputs[i], "rb");
+        if (file == NULL)
+        {
+            fprintf(stderr, "%s: cannot open\n", inputs[i]);
+            readable = false;
+            break;
+        }
+
+        InitializePgnReader(&Reader, file);
+        while (ReadPgnGame(&Reader, &Game))
+        {
+            if (Game.error != NULL)
+            {
+                skipped++;
+                continue;
+            }
+
+            if (!AddDatabaseGame(&writer, &Game))
+            {
+                break;
+            }
+            games++;
+            plies += (uint64_t)Game.plyCount;
+        }
+
+        if (ferror(file))
+        {
+            fprintf(stderr, "%s: read error\n", inputs[i]);
+            readable = false;
+        }
+        if (!isStdin)
+        {
+            fclose(file);
+        }
+    }
+
+    uint64_t positions = writer.positionCount;
+    if (!FinishGameDatabase(&writer) || !readable)
+    {
+        fprintf(stderr, "%s: database not written\n", output);
+        remove(output);
+        return 1;
+    }
+
+    double seconds = MonotonicSeconds() - start;
+    printf("%s: %llu games (%llu skipped with errors), %llu plies, %llu positions indexed\n", output, (unsigned long long)games,
+           (unsigned long long)skipped, (unsigned long long)plies, (unsigned long long)positions);
+    if (seconds > 0.0)
+    {
+        printf("%s: %.3f s, %.0f games/s, %.0f positions/s\n", output, seconds, (double)games / seconds, (double)positions / seconds);
+    }
+    return 0;
+}
+
+/**
+ * QueryDatabase (static)
+ *
+ * Print the games of the database at path that reach the FEN position, at most limit.
+ */
+static int QueryDatabase(const char *path, const char *fen, size_t limit)
+{
+    GameDatabase db;
+    Position pos;
+
+    if (!PositionFromFEN(&pos, fen))
+    {
+        fprintf(stderr, "invalid FEN: %s\n", fen);
+        return 1;
+    }
+    if (!OpenGameDatabase(&db, path))
+    {
+        fprintf(stderr, "%s: not a game database\n", path);
+        return 1;
+    }
+
+    GameDbHit *hits = (limit > 0) ? malloc(sizeof(GameDbHit) * limit) : NULL;
+    if (limit > 0 && hits == NULL)
+    {
+        CloseGameDatabase(&db);
+        return 1;
+    }
+
+    double start = MonotonicSeconds();
+    size_t total = FindPositionGames(&db, pos.key, hits, limit);
+    double seconds = MonotonicSeconds() - start;
+
+    printf("%zu games reach the position (lookup %.3f ms)\n", total, seconds * 1e3);
+    for (size_t i = 0; i < total && i < limit; i++)
+    {
+        if (ReadDatabaseGame(&db, hits[i].game, &Game))
+        {
+            printf("  #%u ply %u: %s - %s %s (%s)\n", hits[i].game, hits[i].ply, Game.white, Game.black, Game.result, Game.event);
+        }
+        else
+        {
+            printf("  #%u ply %u: damaged record\n", hits[i].game, hits[i].ply);
+        }
+    }
+
+    free(hits);
+    CloseGameDatabase(&db);
+    return 0;
+}
+
+/**
+ * PrintDatabaseInfo (static)
+ */
+static int PrintDatabaseInfo(const char *path)
+{
+    GameDatabase db;
+
+    if (!OpenGameDatabase(&db, path))
+    {
+        fprintf(stderr, "%s: not a game database\n", path);
+        return 1;
+    }
+
+    printf("%s: %u games, %llu positions indexed, %.1f MB\n", path, db.gameCount, (unsigned long long)db.positionCount,
+           (double)db.size / 1e6);
+    CloseGameDatabase(&db);
+    return 0;
+}
+
+/**
+ * PrintUsage (static)
+ */
+static void PrintUsage(const char *program)
+{
+    fprintf(stderr,
+            "Usage:\n"
+            "  %s build <out.cdb> <file.pgn | ->...\n"
+            "      build a game database from the complete games of the PGN files\n"
+            "  %s query <db.cdb> <fen> [--limit N]\n"
+            "      list the games reaching the position\n"
+            "  %s info <db.cdb>\n"
+            "      print the database summary\n",
+            program, program, program);
+}
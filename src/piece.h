@@ -0,0 +1,42 @@
+/**
+ * piece.h
+ *
+ * Responsibilities:
+ * - Define the PieceType and Team enumerations shared by every module.
+ *
+ * Notes:
+ * - This header is deliberately free of raylib so the rule logic (bitboard.c)
+ *   can use the same enums as the renderer without pulling in any GL types.
+ */
+
+#ifndef PIECE_H
+#define PIECE_H
+
+/* PieceType
+ * - PIECE_NONE == 0 so zero-initialized memory means "empty cell".
+ */
+typedef enum
+{
+    PIECE_NONE = 0, /* empty square */
+    PIECE_KING,
+    PIECE_QUEEN,
+    PIECE_ROOK,
+    PIECE_BISHOP,
+    PIECE_KNIGHT,
+    PIECE_PAWN
+} PieceType;
+
+/* Number of PieceType values including PIECE_NONE (used to size lookup tables) */
+#define PIECE_TYPE_COUNT 7
+
+/* Team (side/color) */
+typedef enum
+{
+    TEAM_WHITE = 0,
+    TEAM_BLACK
+} Team;
+
+/* Number of teams (used to size lookup tables) */
+#define TEAM_COUNT 2
+
+#endif /* PIECE_H */
@@ -0,0 +1,904 @@
+/**
+ * position.c
+ *
+ * Responsibilities:
+ * - Convert between Position and FEN records (and read EPD records).
+ * - Check that a parsed position is sound (ValidatePosition).
+ * - Play and take back moves on a Position (MakeMove/UnmakeMove).
+ *
+ * Implementation Details:
+ * - MakeMove updates the bitboards, the Zobrist key and the piece-square totals
+ *   incrementally (AddPiece/TakePiece); UnmakeMove restores the irreversible fields
+ *   (rights, en passant file, clock, key, totals) from the UndoInfo, so a
+ *   make/unmake pair leaves the Position bit-for-bit identical.
+ * - Castling rights are cleared through CastlingRightsLost: any move from or to a king or
+ *   rook home square drops the rights tied to that square.
+ * - The parsers work on (pointer, length) spans and never copy or allocate, so lines of a
+ *   memory-mapped file can be parsed in place; the NUL-terminated PositionFromFEN is a
+ *   wrapper over PositionFromFENSpan.
+ * - Part of libchesscore: no raylib, no globals, every function works on the Position it is given.
+ */
+
+#include "position.h"
+#include "bitboard.h"
+#include "movegen.h"
+#include "piece.h"
+#include "psqt.h"
+#include "settings.h"
+#include "zobrist.h"
+#include <ctype.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/* FEN letters indexed by PieceType (lowercase = black) */
+static const char PieceLetters[PIECE_TYPE_COUNT] = {'?', 'k', 'q', 'r', 'b', 'n', 'p'};
+
+/* Rights removed when a move starts or ends on a square */
+static const int CastlingRightsLost[SQUARE_COUNT] = {
+    [SQUARE_INDEX(WHITE_BACK_RANK, KING_START_COL)] = CASTLE_WHITE_KING_SIDE | CASTLE_WHITE_QUEEN_SIDE,
+    [SQUARE_INDEX(WHITE_BACK_RANK, ROOK_KS_COL)] = CASTLE_WHITE_KING_SIDE,
+    [SQUARE_INDEX(WHITE_BACK_RANK, ROOK_QS_COL)] = CASTLE_WHITE_QUEEN_SIDE,
+    [SQUARE_INDEX(BLACK_BACK_RANK, KING_START_COL)] = CASTLE_BLACK_KING_SIDE | CASTLE_BLACK_QUEEN_SIDE,
+    [SQUARE_INDEX(BLACK_BACK_RANK, ROOK_KS_COL)] = CASTLE_BLACK_KING_SIDE,
+    [SQUARE_INDEX(BLACK_BACK_RANK, ROOK_QS_COL)] = CASTLE_BLACK_QUEEN_SIDE,
+};
+
+/* Placement letters: PIECE_CODE(type, team), 0 for anything that is not a piece letter */
+#define PIECE_CODE(type, team) ((type) | ((team) << 3))
+static const unsigned char PlacementCodes[256] = {
+    ['K'] = PIECE_CODE(PIECE_KING, TEAM_WHITE),
+    ['Q'] = PIECE_CODE(PIECE_QUEEN, TEAM_WHITE),
+    ['R'] = PIECE_CODE(PIECE_ROOK, TEAM_WHITE),
+    ['B'] = PIECE_CODE(PIECE_BISHOP, TEAM_WHITE),
+    ['N'] = PIECE_CODE(PIECE_KNIGHT, TEAM_WHITE),
+    ['P'] = PIECE_CODE(PIECE_PAWN, TEAM_WHITE),
+    ['k'] = PIECE_CODE(PIECE_KING, TEAM_BLACK),
+    ['q'] = PIECE_CODE(PIECE_QUEEN, TEAM_BLACK),
+    ['r'] = PIECE_CODE(PIECE_ROOK, TEAM_BLACK),
+    ['b'] = PIECE_CODE(PIECE_BISHOP, TEAM_BLACK),
+    ['n'] = PIECE_CODE(PIECE_KNIGHT, TEAM_BLACK),
+    ['p'] = PIECE_CODE(PIECE_PAWN, TEAM_BLACK),
+};
+
+/* Rows 0 and 7, where no pawn can stand */
+#define BACK_RANKS 0xFF000000000000FFULL
+
+#define CASTLING_RIGHT_COUNT 4
+
+/* King and rook home squares behind each castling right (checked by ValidatePosition) */
+typedef struct CastlingHome
+{
+    int right;
+    Team team;
+    int kingSquare;
+    int rookSquare;
+} CastlingHome;
+
+static const CastlingHome CastlingHomes[CASTLING_RIGHT_COUNT] = {
+    {CASTLE_WHITE_KING_SIDE, TEAM_WHITE, SQUARE_INDEX(WHITE_BACK_RANK, KING_START_COL), SQUARE_INDEX(WHITE_BACK_RANK, ROOK_KS_COL)},
+    {CASTLE_WHITE_QUEEN_SIDE, TEAM_WHITE, SQUARE_INDEX(WHITE_BACK_RANK, KING_START_COL), SQUARE_INDEX(WHITE_BACK_RANK, ROOK_QS_COL)},
+    {CASTLE_BLACK_KING_SIDE, TEAM_BLACK, SQUARE_INDEX(BLACK_BACK_RANK, KING_START_COL), SQUARE_INDEX(BLACK_BACK_RANK, ROOK_KS_COL)},
+    {CASTLE_BLACK_QUEEN_SIDE, TEAM_BLACK, SQUARE_INDEX(BLACK_BACK_RANK, KING_START_COL), SQUARE_INDEX(BLACK_BACK_RANK, ROOK_QS_COL)},
+};
+
+// Local prototypes
+static PieceType TeamPieceAt(const Bitboards *bb, int square, Team team);
+static void AddPiece(Position *pos, int square, PieceType type, Team team);
+static void TakePiece(Position *pos, int square, PieceType type, Team team);
+static bool ReadBoardFields(Position *pos, const char **cursor, const char *end);
+static void AddStateKeys(Position *pos);
+static bool IsBlank(char chr);
+static const char *SkipBlanks(const char *text, const char *end);
+static const char *ReadCounter(const char *text, const char *end, int *value);
+static char *WriteCounter(char *out, int value);
+
+/**
+ * PositionFromFEN
+ *
+ * Parse the six FEN fields into a Position.
+ *
+ * Parameters:
+ *  - pos: output position.
+ *  - fen: NUL-terminated FEN record. The two move counters may be omitted
+ *         (they default to 0 and 1).
+ *
+ * Returns:
+ *  - true on success; false if the placement is not 8 ranks of 8 files, a field holds an
+ *    unknown character, a castling letter repeats, or a side lacks exactly one king.
+ *
+ * Notes:
+ *  - Castling rights are taken as written; they are not checked against the placement
+ *    (ValidatePosition does).
+ */
+bool PositionFromFEN(Position *pos, const char *fen)
+{
+    if (fen == NULL)
+    {
+        return false;
+    }
+
+    return PositionFromFENSpan(pos, fen, strlen(fen));
+}
+
+/**
+ * PositionFromFENSpan
+ *
+ * PositionFromFEN on the first length characters of fen, which need not be NUL-terminated
+ * (a line of a memory-mapped file, a token of a larger buffer). Nothing is copied.
+ *
+ * Notes:
+ *  - Blanks (space, tab, CR, LF) around and between the fields are ignored.
+ */
+bool PositionFromFENSpan(Position *pos, const char *fen, size_t length)
+{
+    if (pos == NULL || fen == NULL)
+    {
+        return false;
+    }
+
+    const char *end = fen + length;
+    if (!ReadBoardFields(pos, &fen, end))
+    {
+        return false;
+    }
+
+    // --- 5. MOVE COUNTERS (optional) ---
+    fen = SkipBlanks(fen, end);
+    if (fen < end)
+    {
+        fen = ReadCounter(fen, end, &pos->halfMoveClock);
+        if (fen == NULL)
+        {
+            return false;
+        }
+
+        fen = SkipBlanks(fen, end);
+        if (fen < end)
+        {
+            fen = ReadCounter(fen, end, &pos->fullMoveNumber);
+            if (fen == NULL)
+            {
+                return false;
+            }
+        }
+    }
+
+    if (SkipBlanks(fen, end) != end)
+    {
+        return false;
+    }
+
+    AddStateKeys(pos);
+    return true;
+}
+
+/**
+ * PositionFromEPD
+ *
+ * Parse an EPD record (the first four FEN fields followed by operations) without copying.
+ *
+ * Parameters:
+ *  - pos:    output position.
+ *  - epd:    start of the record (need not be NUL-terminated).
+ *  - length: number of characters in the record.
+ *
+ * Returns:
+ *  - false if the four position fields are malformed (as for PositionFromFEN), an "hmvc"
+ *    or "fmvn" operand is not a counter, or a quoted operand is not closed.
+ *
+ * Notes:
+ *  - Operations are "opcode operands;". Only hmvc (halfmove clock) and fmvn (fullmove
+ *    number) are interpreted; the counters default to 0 and 1 like a short FEN. A ';'
+ *    inside a quoted operand does not end the operation, and the last ';' may be missing.
+ */
+bool PositionFromEPD(Position *pos, const char *epd, size_t length)
+{
+    if (pos == NULL || epd == NULL)
+    {
+        return false;
+    }
+
+    const char *end = epd + length;
+    if (!ReadBoardFields(pos, &epd, end))
+    {
+        return false;
+    }
+
+    for (epd = SkipBlanks(epd, end); epd < end; epd = SkipBlanks(epd, end))
+    {
+        const char *opcode = epd;
+        while (epd < end && !IsBlank(*epd) && *epd != ';')
+        {
+            epd++;
+        }
+        size_t opcodeLength = (size_t)(epd - opcode);
+        int *counter = NULL;
+
+        if (opcodeLength == 4 && memcmp(opcode, "hmvc", 4) == 0)
+        {
+            counter = &pos->halfMoveClock;
+        }
+        else if (opcodeLength == 4 && memcmp(opcode, "fmvn", 4) == 0)
+        {
+            counter = &pos->fullMoveNumber;
+        }
+
+        if (counter != NULL)
+        {
+            epd = ReadCounter(SkipBlanks(epd, end), end, counter);
+            if (epd == NULL)
+            {
+                return false;
+            }
+        }
+
+        // Skip the (remaining) operands up to the terminating ';'
+        bool quoted = false;
+        while (epd < end && (quoted || *epd != ';'))
+        {
+            if (*epd == '"')
+            {
+                quoted = !quoted;
+            }
+            epd++;
+        }
+
+        if (quoted)
+        {
+            return false;
+        }
+        if (epd < end)
+        {
+            epd++;
+        }
+    }
+
+    AddStateKeys(pos);
+    return true;
+}
+
+/**
+ * ValidatePosition
+ *
+ * Check the rules a parsed position must satisfy to be reachable by legal play (beyond
+ * what the parsers already enforce: 8x8 placement, one king per side).
+ *
+ * Returns:
+ *  - NULL if the position is sound, otherwise a short description of the first problem.
+ */
+const char *ValidatePosition(const Position *pos)
+{
+    const Bitboards *bb = &pos->bitboards;
+    Team opponent = (pos->side == TEAM_WHITE) ? TEAM_BLACK : TEAM_WHITE;
+
+    for (int team = 0; team < TEAM_COUNT; team++)
+    {
+        if (BitCount(bb->teams[team]) > 2 * BOARD_SIZE || BitCount(bb->pieces[team][PIECE_PAWN]) > BOARD_SIZE)
+        {
+            return "more than 16 pieces or 8 pawns for one side";
+        }
+    }
+
+    if ((bb->pieces[TEAM_WHITE][PIECE_PAWN] | bb->pieces[TEAM_BLACK][PIECE_PAWN]) & BACK_RANKS)
+    {
+        return "pawn on the first or last rank";
+    }
+
+    if (IsSquareAttacked(bb, KingSquare(bb, opponent), pos->side))
+    {
+        return "the side not to move is in check";
+    }
+
+    for (int right = 0; right < CASTLING_RIGHT_COUNT; right++)
+    {
+        const CastlingHome *home = &CastlingHomes[right];
+
+        if ((pos->castlingRights & home->right) &&
+            (!(bb->pieces[home->team][PIECE_KING] & SQUARE_BIT(home->kingSquare)) || !(bb->pieces[home->team][PIECE_ROOK] & SQUARE_BIT(home->rookSquare))))
+        {
+            return "castling right without the king and rook on their home squares";
+        }
+    }
+
+    if (pos->enPassantCol >= 0)
+    {
+        // The pawn that just moved two squares stands on row 3 (black) or row 4 (white), the two squares behind it are empty
+        int pawnRow = (pos->side == TEAM_WHITE) ? 3 : 4;
+        int step = (pos->side == TEAM_WHITE) ? -1 : 1;
+        int pawnSquare = SQUARE_INDEX(pawnRow, pos->enPassantCol);
+        Bitboard passed = SQUARE_BIT(SQUARE_INDEX(pawnRow + step, pos->enPassantCol)) | SQUARE_BIT(SQUARE_INDEX(pawnRow + (2 * step), pos->enPassantCol));
+
+        if (!(bb->pieces[opponent][PIECE_PAWN] & SQUARE_BIT(pawnSquare)) || (bb->occupied & passed))
+        {
+            return "en passant square without a pawn that just moved two squares";
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * PositionToFEN
+ *
+ * Serialize a Position into a full six-field FEN record.
+ *
+ * Parameters:
+ *  - pos:    position to write.
+ *  - buffer: destination; MAX_POSITION_FEN_LENGTH bytes always suffice.
+ *  - size:   capacity of buffer in bytes.
+ *
+ * Returns:
+ *  - Length of the record (terminator excluded); 0 if it did not fit (buffer then holds
+ *    an empty string).
+ *
+ * Notes:
+ *  - No allocation and no printf: bulk exporters call this millions of times. The length
+ *    lets them append records back to back (p += PositionToFEN(&pos, p, end - p)).
+ *  - With a buffer of MAX_POSITION_FEN_LENGTH bytes or more the record is written in
+ *    place; smaller buffers go through a scratch copy so they are never overrun.
+ */
+size_t PositionToFEN(const Position *pos, char *buffer, size_t size)
+{
+    char scratch[MAX_POSITION_FEN_LENGTH];
+    char board[SQUARE_COUNT] = {0};
+
+    if (pos == NULL || buffer == NULL || size == 0)
+    {
+        return 0;
+    }
+
+    char *out = (size >= MAX_POSITION_FEN_LENGTH) ? buffer : scratch;
+    char *write = out;
+
+    // One pass over the bitboards instead of a PieceTypeAt lookup per square
+    for (int team = 0; team < TEAM_COUNT; team++)
+    {
+        for (int type = PIECE_NONE + 1; type < PIECE_TYPE_COUNT; type++)
+        {
+            Bitboard pieces = pos->bitboards.pieces[team][type];
+            char letter = (team == TEAM_WHITE) ? (char)toupper((unsigned char)PieceLetters[type]) : PieceLetters[type];
+
+            while (pieces)
+            {
+                board[PopLowestSquare(&pieces)] = letter;
+            }
+        }
+    }
+
+    for (int row = 0; row < BOARD_SIZE; row++)
+    {
+        int empty = 0;
+
+        for (int col = 0; col < BOARD_SIZE; col++)
+        {
+            char letter = board[SQUARE_INDEX(row, col)];
+
+            if (letter == 0)
+            {
+                empty++;
+                continue;
+            }
+
+            if (empty > 0)
+            {
+                *write++ = (char)('0' + empty);
+                empty = 0;
+            }
+            *write++ = letter;
+        }
+
+        if (empty > 0)
+        {
+            *write++ = (char)('0' + empty);
+        }
+
+        if (row < BOARD_SIZE - 1)
+        {
+            *write++ = '/';
+        }
+    }
+
+    *write++ = ' ';
+    *write++ = (pos->side == TEAM_WHITE) ? 'w' : 'b';
+    *write++ = ' ';
+
+    char *rights = write;
+    if (pos->castlingRights & CASTLE_WHITE_KING_SIDE)
+    {
+        *write++ = 'K';
+    }
+    if (pos->castlingRights & CASTLE_WHITE_QUEEN_SIDE)
+    {
+        *write++ = 'Q';
+    }
+    if (pos->castlingRights & CASTLE_BLACK_KING_SIDE)
+    {
+        *write++ = 'k';
+    }
+    if (pos->castlingRights & CASTLE_BLACK_QUEEN_SIDE)
+    {
+        *write++ = 'q';
+    }
+    if (write == rights)
+    {
+        *write++ = '-';
+    }
+
+    *write++ = ' ';
+    if (pos->enPassantCol >= 0 && pos->enPassantCol < BOARD_SIZE)
+    {
+        // The target square sits behind the pawn that just moved: rank 6 if White is to move, rank 3 otherwise
+        *write++ = (char)('a' + pos->enPassantCol);
+        *write++ = (pos->side == TEAM_WHITE) ? '6' : '3';
+    }
+    else
+    {
+        *write++ = '-';
+    }
+
+    *write++ = ' ';
+    write = WriteCounter(write, pos->halfMoveClock);
+    *write++ = ' ';
+    write = WriteCounter(write, pos->fullMoveNumber);
+    *write = '\0';
+
+    size_t length = (size_t)(write - out);
+    if (out == scratch)
+    {
+        if (length >= size)
+        {
+            buffer[0] = '\0';
+            return 0;
+        }
+        memcpy(buffer, scratch, length + 1);
+    }
+
+    return length;
+}
+
+/**
+ * MakeMove
+ *
+ * Play a move on pos.
+ *
+ * Parameters:
+ *  - pos:  position to update; the move must be legal in it (e.g. taken from GenerateLegalMoves).
+ *  - move: ChessMove to play.
+ *  - undo: receives the state UnmakeMove needs.
+ *
+ * Behavior:
+ *  - Moves the piece (promoting it if requested), removes the captured piece (including
+ *    en passant), moves the rook when castling.
+ *  - Updates castling rights, en passant file, half-move clock, full-move number,
+ *    side to move, the Zobrist key and the piece-square totals.
+ */
+void MakeMove(Position *pos, uint16_t move, UndoInfo *undo)
+{
+    Team us = pos->side;
+    Team them = (us == TEAM_WHITE) ? TEAM_BLACK : TEAM_WHITE;
+    int from = MOVE_FROM(move);
+    int to = MOVE_TO(move);
+    MoveFlag flag = MOVE_FLAG(move);
+    PieceType moving = TeamPieceAt(&pos->bitboards, from, us);
+
+    undo->captured = PIECE_NONE;
+    undo->castlingRights = pos->castlingRights;
+    undo->enPassantCol = pos->enPassantCol;
+    undo->halfMoveClock = pos->halfMoveClock;
+    undo->key = pos->key;
+    undo->psqtMidgame = pos->psqtMidgame;
+    undo->psqtEndgame = pos->psqtEndgame;
+    undo->phase = pos->phase;
+
+    // Take the old rights out of the key; the new ones are added back at the end
+    pos->key ^= ZobristRightsKey(pos->castlingRights, pos->enPassantCol);
+
+    if (flag == MOVE_EN_PASSANT)
+    {
+        // The captured pawn stands beside the mover, i.e. one row behind the destination
+        int captureSquare = (us == TEAM_WHITE) ? to + BOARD_SIZE : to - BOARD_SIZE;
+        TakePiece(pos, captureSquare, PIECE_PAWN, them);
+        undo->captured = PIECE_PAWN;
+    }
+    else if (MOVE_IS_CAPTURE(move))
+    {
+        undo->captured = TeamPieceAt(&pos->bitboards, to, them);
+        TakePiece(pos, to, undo->captured, them);
+    }
+
+    TakePiece(pos, from, moving, us);
+    AddPiece(pos, to, MOVE_IS_PROMOTION(move) ? MovePromotionType(move) : moving, us);
+
+    if (flag == MOVE_CASTLE_KING_SIDE || flag == MOVE_CASTLE_QUEEN_SIDE)
+    {
+        int row = SQUARE_ROW(from);
+        bool kingSide = (flag == MOVE_CASTLE_KING_SIDE);
+        TakePiece(pos, SQUARE_INDEX(row, kingSide ? ROOK_KS_COL : ROOK_QS_COL), PIECE_ROOK, us);
+        AddPiece(pos, SQUARE_INDEX(row, kingSide ? CASTLE_KS_ROOK_COL : CASTLE_QS_ROOK_COL), PIECE_ROOK, us);
+    }
+
+    pos->castlingRights &= ~(CastlingRightsLost[from] | CastlingRightsLost[to]);
+    pos->enPassantCol = (flag == MOVE_DOUBLE_PUSH) ? SQUARE_COL(to) : -1;
+    pos->halfMoveClock = (moving == PIECE_PAWN || undo->captured != PIECE_NONE) ? 0 : pos->halfMoveClock + 1;
+    if (us == TEAM_BLACK)
+    {
+        pos->fullMoveNumber++;
+    }
+    pos->side = them;
+
+    pos->key ^= ZobristRightsKey(pos->castlingRights, pos->enPassantCol) ^ ZobristSideKey;
+}
+
+/**
+ * UnmakeMove
+ *
+ * Take back a move played with MakeMove.
+ *
+ * Parameters:
+ *  - pos:  position right after MakeMove(pos, move, undo).
+ *  - move: the same move.
+ *  - undo: the UndoInfo MakeMove filled.
+ */
+void UnmakeMove(Position *pos, uint16_t move, const UndoInfo *undo)
+{
+    Team them = pos->side;
+    Team us = (them == TEAM_WHITE) ? TEAM_BLACK : TEAM_WHITE;
+    int from = MOVE_FROM(move);
+    int to = MOVE_TO(move);
+    MoveFlag flag = MOVE_FLAG(move);
+    PieceType landed = TeamPieceAt(&pos->bitboards, to, us);
+
+    RemovePieceBB(&pos->bitboards, to, landed, us);
+    PlacePieceBB(&pos->bitboards, from, MOVE_IS_PROMOTION(move) ? PIECE_PAWN : landed, us);
+
+    if (flag == MOVE_EN_PASSANT)
+    {
+        PlacePieceBB(&pos->bitboards, (us == TEAM_WHITE) ? to + BOARD_SIZE : to - BOARD_SIZE, PIECE_PAWN, them);
+    }
+    else if (undo->captured != PIECE_NONE)
+    {
+        PlacePieceBB(&pos->bitboards, to, undo->captured, them);
+    }
+
+    if (flag == MOVE_CASTLE_KING_SIDE || flag == MOVE_CASTLE_QUEEN_SIDE)
+    {
+        int row = SQUARE_ROW(from);
+        bool kingSide = (flag == MOVE_CASTLE_KING_SIDE);
+        RemovePieceBB(&pos->bitboards, SQUARE_INDEX(row, kingSide ? CASTLE_KS_ROOK_COL : CASTLE_QS_ROOK_COL), PIECE_ROOK, us);
+        PlacePieceBB(&pos->bitboards, SQUARE_INDEX(row, kingSide ? ROOK_KS_COL : ROOK_QS_COL), PIECE_ROOK, us);
+    }
+
+    if (us == TEAM_BLACK)
+    {
+        pos->fullMoveNumber--;
+    }
+    pos->side = us;
+    pos->castlingRights = undo->castlingRights;
+    pos->enPassantCol = undo->enPassantCol;
+    pos->halfMoveClock = undo->halfMoveClock;
+    pos->key = undo->key;
+    pos->psqtMidgame = undo->psqtMidgame;
+    pos->psqtEndgame = undo->psqtEndgame;
+    pos->phase = undo->phase;
+}
+
+/**
+ * TeamPieceAt (static)
+ *
+ * Type of the piece of a known team on square (PIECE_NONE if that team has nothing there).
+ */
+static PieceType TeamPieceAt(const Bitboards *bb, int square, Team team)
+{
+    Bitboard bit = SQUARE_BIT(square);
+
+    for (int type = PIECE_KING; type < PIECE_TYPE_COUNT; type++)
+    {
+        if (bb->pieces[team][type] & bit)
+        {
+            return (PieceType)type;
+        }
+    }
+
+    return PIECE_NONE;
+}
+
+/**
+ * AddPiece (static)
+ *
+ * Place a piece on the bitboards, XOR it into the key and add its piece-square terms.
+ */
+static void AddPiece(Position *pos, int square, PieceType type, Team team)
+{
+    PlacePieceBB(&pos->bitboards, square, type, team);
+    pos->key ^= ZobristPieceKeys[team][type][square];
+    pos->psqtMidgame += PsqtMidgame[team][type][square];
+    pos->psqtEndgame += PsqtEndgame[team][type][square];
+    pos->phase += PhaseWeights[type];
+}
+
+/**
+ * TakePiece (static)
+ *
+ * Remove a piece from the bitboards, XOR it out of the key and subtract its piece-square terms.
+ */
+static void TakePiece(Position *pos, int square, PieceType type, Team team)
+{
+    RemovePieceBB(&pos->bitboards, square, type, team);
+    pos->key ^= ZobristPieceKeys[team][type][square];
+    pos->psqtMidgame -= PsqtMidgame[team][type][square];
+    pos->psqtEndgame -= PsqtEndgame[team][type][square];
+    pos->phase -= PhaseWeights[type];
+}
+
+/**
+ * ReadBoardFields (static)
+ *
+ * Parse the four position fields shared by FEN and EPD (placement, side, castling,
+ * en passant) from *text up to end and advance *text past them. The counters are set
+ * to their defaults (0 and 1). pos->key only holds the piece terms (XORed in while
+ * placing); the caller completes it with AddStateKeys once the record is accepted. The
+ * piece-square totals are complete as soon as the placement is read.
+ *
+ * Returns:
+ *  - false on a malformed field (see PositionFromFEN).
+ */
+static bool ReadBoardFields(Position *pos, const char **cursor, const char *end)
+{
+    const char *text = *cursor;
+    int row = 0;
+    int col = 0;
+
+    memset(pos, 0, sizeof *pos);
+
+    // --- 1. PIECE PLACEMENT ---
+    for (text = SkipBlanks(text, end); text < end && !IsBlank(*text); text++)
+    {
+        char chr = *text;
+
+        if (chr == '/')
+        {
+            if (col != BOARD_SIZE || ++row >= BOARD_SIZE)
+            {
+                return false;
+            }
+            col = 0;
+        }
+        else if (chr >= '1' && chr <= '8')
+        {
+            col += chr - '0';
+            if (col > BOARD_SIZE)
+            {
+                return false;
+            }
+        }
+        else
+        {
+            // Table lookup and inline bit set: this loop dominates bulk parsing
+            unsigned char code = PlacementCodes[(unsigned char)chr];
+            if (code == 0 || col >= BOARD_SIZE)
+            {
+                return false;
+            }
+
+            int square = SQUARE_INDEX(row, col);
+            pos->bitboards.pieces[code >> 3][code & 7] |= SQUARE_BIT(square);
+            pos->key ^= ZobristPieceKeys[code >> 3][code & 7][square];
+            pos->psqtMidgame += PsqtMidgame[code >> 3][code & 7][square];
+            pos->psqtEndgame += PsqtEndgame[code >> 3][code & 7][square];
+            pos->phase += PhaseWeights[code & 7];
+            col++;
+        }
+    }
+
+    if (row != BOARD_SIZE - 1 || col != BOARD_SIZE)
+    {
+        return false;
+    }
+
+    for (int team = 0; team < TEAM_COUNT; team++)
+    {
+        for (int type = PIECE_KING; type < PIECE_TYPE_COUNT; type++)
+        {
+            pos->bitboards.teams[team] |= pos->bitboards.pieces[team][type];
+        }
+    }
+    pos->bitboards.occupied = pos->bitboards.teams[TEAM_WHITE] | pos->bitboards.teams[TEAM_BLACK];
+
+    if (BitCount(pos->bitboards.pieces[TEAM_WHITE][PIECE_KING]) != 1 || BitCount(pos->bitboards.pieces[TEAM_BLACK][PIECE_KING]) != 1)
+    {
+        return false;
+    }
+
+    // --- 2. ACTIVE COLOR ---
+    text = SkipBlanks(text, end);
+    if (text < end && *text == 'w')
+    {
+        pos->side = TEAM_WHITE;
+    }
+    else if (text < end && *text == 'b')
+    {
+        pos->side = TEAM_BLACK;
+    }
+    else
+    {
+        return false;
+    }
+    text++;
+
+    // --- 3. CASTLING RIGHTS ---
+    text = SkipBlanks(text, end);
+    if (text < end && *text == '-')
+    {
+        text++;
+    }
+    else
+    {
+        for (; text < end && !IsBlank(*text); text++)
+        {
+            int right;
+            switch (*text)
+            {
+            case 'K':
+                right = CASTLE_WHITE_KING_SIDE;
+                break;
+            case 'Q':
+                right = CASTLE_WHITE_QUEEN_SIDE;
+                break;
+            case 'k':
+                right = CASTLE_BLACK_KING_SIDE;
+                break;
+            case 'q':
+                right = CASTLE_BLACK_QUEEN_SIDE;
+                break;
+            default:
+                return false;
+            }
+
+            // Each letter at most once ("KKkq" is malformed)
+            if (pos->castlingRights & right)
+            {
+                return false;
+            }
+            pos->castlingRights |= right;
+        }
+
+        if (pos->castlingRights == 0)
+        {
+            return false;
+        }
+    }
+
+    // --- 4. EN PASSANT ---
+    text = SkipBlanks(text, end);
+    pos->enPassantCol = -1;
+    if (text < end && *text == '-')
+    {
+        text++;
+    }
+    else if (end - text >= 2 && text[0] >= 'a' && text[0] <= 'h' && (text[1] == '3' || text[1] == '6'))
+    {
+        pos->enPassantCol = text[0] - 'a';
+        text += 2;
+    }
+    else
+    {
+        return false;
+    }
+
+    if (text < end && !IsBlank(*text))
+    {
+        return false;
+    }
+
+    pos->halfMoveClock = 0;
+    pos->fullMoveNumber = 1;
+    *cursor = text;
+    return true;
+}
+
+/**
+ * AddStateKeys (static)
+ *
+ * Complete a key holding only the piece terms with the side, castling and en passant
+ * terms, giving the same key as ComputeZobristKey.
+ */
+static void AddStateKeys(Position *pos)
+{
+    pos->key ^= ZobristRightsKey(pos->castlingRights, pos->enPassantCol);
+    if (pos->side == TEAM_BLACK)
+    {
+        pos->key ^= ZobristSideKey;
+    }
+}
+
+/**
+ * IsBlank (static)
+ *
+ * Field separators of FEN/EPD records: space and tab, plus CR and LF so a record taken
+ * straight from a text file may keep its line ending.
+ */
+static bool IsBlank(char chr)
+{
+    return chr == ' ' || chr == '\t' || chr == '\r' || chr == '\n';
+}
+
+/**
+ * SkipBlanks (static)
+ *
+ * Returns the first character of text (before end) that is not a blank, or end.
+ */
+static const char *SkipBlanks(const char *text, const char *end)
+{
+    while (text < end && IsBlank(*text))
+    {
+        text++;
+    }
+
+    return text;
+}
+
+/**
+ * ReadCounter (static)
+ *
+ * Parse a non-negative decimal counter ending at a blank, ';' or end.
+ *
+ * Returns:
+ *  - Pointer just past the digits, or NULL if text does not start with a digit or
+ *    the number is unreasonably large.
+ */
+static const char *ReadCounter(const char *text, const char *end, int *value)
+{
+    int number = 0;
+
+    if (text >= end || !isdigit((unsigned char)*text))
+    {
+        return NULL;
+    }
+
+    for (; text < end && isdigit((unsigned char)*text); text++)
+    {
+        number = number * 10 + (*text - '0');
+        if (number > 1000000)
+        {
+            return NULL;
+        }
+    }
+
+    *value = number;
+    return text;
+}
+
+/**
+ * WriteCounter (static)
+ *
+ * Write value in decimal at out (no terminator).
+ *
+ * Returns:
+ *  - The position just after the last digit.
+ */
+static char *WriteCounter(char *out, int value)
+{
+    char digits[MAX_COUNTER_DIGITS];
+    int count = 0;
+    unsigned int magnitude = (value < 0) ? 0U - (unsigned int)value : (unsigned int)value;
+
+    if (value < 0)
+    {
+        *out++ = '-';
+    }
+
+    do
+    {
+        digits[count++] = (char)('0' + (magnitude % 10));
+        magnitude /= 10;
+    } while (magnitude != 0);
+
+    while (count > 0)
+    {
+        *out++ = digits[--count];
+    }
+
+    return out;
+}
@@ -0,0 +1,100 @@
+/**
+ * position.h
+ *
+ * Responsibilities:
+ * - Define Position: the complete logical state of a chess position, independent of
+ *   any rendering data (no textures, no highlight flags).
+ * - Export the core position API: FEN in/out, EPD in, validation and MakeMove/UnmakeMove
+ *   (position.c).
+ *
+ * Notes:
+ * - The GUI keeps its own GameState; move.c builds a Position snapshot from it
+ *   (CurrentPosition) whenever the rule code needs one.
+ * - This header does not include raylib; it is part of libchesscore (see chesscore.h).
+ */
+
+#ifndef POSITION_H
+#define POSITION_H
+
+#include "bitboard.h"
+#include "piece.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Position
+ *
+ * - bitboards:      piece placement.
+ * - side:           team to move.
+ * - castlingRights: CASTLE_* mask (see zobrist.h).
+ * - enPassantCol:   file of a pawn that just moved two squares, or -1.
+ * - halfMoveClock / fullMoveNumber: FEN move counters.
+ * - key:            Zobrist key of the position.
+ * - psqtMidgame / psqtEndgame / phase: piece-square totals and game phase (see psqt.h),
+ *   kept up to date like the key.
+ */
+typedef struct Position
+{
+    Bitboards bitboards;
+    Team side;
+    int castlingRights;
+    int enPassantCol;
+    int halfMoveClock;
+    int fullMoveNumber;
+    uint64_t key;
+    int psqtMidgame;
+    int psqtEndgame;
+    int phase;
+} Position;
+
+/**
+ * UndoInfo
+ *
+ * Everything MakeMove destroys and UnmakeMove needs back. Lives on the caller's stack.
+ *
+ * - captured: type of the piece taken by the move (PIECE_NONE for non-captures).
+ * - castlingRights / enPassantCol / halfMoveClock / key / psqt*, phase: values before the move.
+ */
+typedef struct UndoInfo
+{
+    PieceType captured;
+    int castlingRights;
+    int enPassantCol;
+    int halfMoveClock;
+    uint64_t key;
+    int psqtMidgame;
+    int psqtEndgame;
+    int phase;
+} UndoInfo;
+
+/* Digits of the longest move counter PositionToFEN writes (a negative 32-bit int) */
+#define MAX_COUNTER_DIGITS 11
+
+/* Longest FEN PositionToFEN can produce, including the terminator:
+   71 placement, " w", " KQkq", " e3", two " <counter>", NUL */
+#define MAX_POSITION_FEN_LENGTH (71 + 2 + 5 + 3 + (2 * (1 + MAX_COUNTER_DIGITS)) + 1)
+
+/* Parses a full FEN record into pos. Returns false (pos unspecified) if the FEN is malformed */
+bool PositionFromFEN(Position *pos, const char *fen);
+
+/* PositionFromFEN on length characters that need not be NUL-terminated (nothing is copied) */
+bool PositionFromFENSpan(Position *pos, const char *fen, size_t length);
+
+/* Parses an EPD record (four FEN fields, then operations; hmvc/fmvn set the counters) without copying */
+bool PositionFromEPD(Position *pos, const char *epd, size_t length);
+
+/* Returns NULL if pos could arise in a legal game as far as cheap checks tell, otherwise what is wrong */
+const char *ValidatePosition(const Position *pos);
+
+/* Writes the FEN record of pos into buffer without allocating. Returns its length, 0 if buffer is too small */
+size_t PositionToFEN(const Position *pos, char *buffer, size_t size);
+
+/* Plays a legal move (a ChessMove from GenerateLegalMoves) and records what is needed to take it back.
+ * The move is typed uint16_t here because movegen.h, which defines ChessMove, includes this header. */
+void MakeMove(Position *pos, uint16_t move, UndoInfo *undo);
+
+/* Takes back the last move played with MakeMove */
+void UnmakeMove(Position *pos, uint16_t move, const UndoInfo *undo);
+
+#endif /* POSITION_H */
@@ -0,0 +1,264 @@
+/**
+ * profile.c
+ *
+ * Responsibilities:
+ * - Accumulate the time and call count of every ProfileZone during a frame.
+ * - Keep the last PROFILE_WINDOW_FRAMES frames and summarise a zone over them for the
+ *   debug overlay (draw.c).
+ * - Write one CSV row per frame while recording is switched on (F6).
+ *
+ * Notes:
+ * - Compiled to nothing unless PROFILE is defined (see profile.h).
+ * - A CSV row holds the frame number, then the nanoseconds and the call count of each
+ *   zone in ProfileZone order; the header names the columns.
+ *
+ * Implementation Details:
+ * - Statistics are computed on request (only while the overlay is shown): the frames a
+ *   zone ran in are copied out of the ring buffer and sorted for the 99th percentile.
+ */
+
+#include "profile.h"
+
+#ifdef PROFILE
+
+#include "chesscore.h"
+#include "raylib.h"
+#include "settings.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* One frame of samples */
+typedef struct ProfileFrame
+{
+    uint64_t ns[PROFILE_ZONE_COUNT];
+    uint32_t calls[PROFILE_ZONE_COUNT];
+} ProfileFrame;
+
+static const char *ZONE_NAMES[PROFILE_ZONE_COUNT] = {
+    [PROFILE_FRAME] = "Frame",
+    [PROFILE_PRESENT] = "EndDrawing",
+    [PROFILE_DRAW_BOARD] = "DrawBoard",
+    [PROFILE_RESETS_AND_VALIDATIONS] = "ResetsAndValidations",
+    [PROFILE_UPDATE_ATTACK_MAP] = "RefreshAttackMap",
+    [PROFILE_FINAL_VALIDATION] = "FinalValidation",
+    [PROFILE_CHECKMATE_CHECK] = "CheckmateCheck",
+    [PROFILE_CURRENT_POSITION] = "CurrentPosition",
+    [PROFILE_LOAD_PIECE] = "LoadPiece",
+};
+
+static ProfileFrame CurrentFrame = {0};
+static ProfileFrame Window[PROFILE_WINDOW_FRAMES];
+static int WindowNext = 0;  // slot the next frame is stored in
+static int WindowCount = 0; // filled slots
+static uint64_t FrameNumber = 0;
+static FILE *CsvFile = NULL;
+
+// Local prototypes
+static int CompareSamples(const void *a, const void *b);
+static void WriteCsvHeader(void);
+static void WriteCsvRow(const ProfileFrame *frame);
+
+/**
+ * ProfileNow
+ *
+ * Returns:
+ *  - the CLOCK_MONOTONIC time in nanoseconds (see MonotonicNanoseconds in chesscore.h).
+ */
+uint64_t ProfileNow(void)
+{
+    return MonotonicNanoseconds();
+}
+
+/**
+ * ProfileAdd
+ *
+ * Parameters:
+ *  - zone: the timed section.
+ *  - ns: duration of one call, nanoseconds.
+ */
+void ProfileAdd(ProfileZone zone, uint64_t ns)
+{
+    CurrentFrame.ns[zone] += ns;
+    CurrentFrame.calls[zone]++;
+}
+
+/**
+ * ProfileEndFrame
+ *
+ * Behavior:
+ *  - Stores the frame in the rolling window (overwriting the oldest one once full),
+ *    writes it to the CSV if recording, and starts an empty frame.
+ */
+void ProfileEndFrame(void)
+{
+    Window[WindowNext] = CurrentFrame;
+    WindowNext = (WindowNext + 1) % PROFILE_WINDOW_FRAMES;
+    if (WindowCount < PROFILE_WINDOW_FRAMES)
+    {
+        WindowCount++;
+    }
+
+    if (CsvFile != NULL)
+    {
+        WriteCsvRow(&CurrentFrame);
+    }
+
+    FrameNumber++;
+    CurrentFrame = (ProfileFrame){0};
+}
+
+/**
+ * GetProfileStats
+ *
+ * Parameters:
+ *  - zone: the zone to summarise.
+ *  - stats: receives the summary (see ProfileStats).
+ *
+ * Behavior:
+ *  - p99 is the smallest sample that at least 99% of the frames the zone ran in do not
+ *    exceed (the maximum while fewer than 100 frames are available).
+ */
+void GetProfileStats(ProfileZone zone, ProfileStats *stats)
+{
+    uint64_t samples[PROFILE_WINDOW_FRAMES];
+    uint64_t total = 0;
+    uint64_t calls = 0;
+    int count = 0;
+
+    for (int i = 0; i < WindowCount; i++)
+    {
+        if (Window[i].calls[zone] == 0)
+        {
+            continue;
+        }
+        samples[count++] = Window[i].ns[zone];
+        total += Window[i].ns[zone];
+        calls += Window[i].calls[zone];
+    }
+
+    *stats = (ProfileStats){0};
+    if (count == 0)
+    {
+        return;
+    }
+
+    qsort(samples, (size_t)count, sizeof samples[0], CompareSamples);
+
+    int p99Index = (count * 99 + 99) / 100 - 1; // ceil(0.99 * count) - 1
+    stats->frames = count;
+    stats->minMs = samples[0] / 1e6;
+    stats->avgMs = (double)total / count / 1e6;
+    stats->p99Ms = samples[p99Index] / 1e6;
+    stats->callsPerFrame = (double)calls / count;
+}
+
+/**
+ * ProfileZoneName
+ */
+const char *ProfileZoneName(ProfileZone zone)
+{
+    return ZONE_NAMES[zone];
+}
+
+/**
+ * ToggleProfileCsv
+ *
+ * Behavior:
+ *  - Starting truncates PROFILE_CSV_PATH and writes the header; stopping closes the file.
+ *
+ * Returns:
+ *  - false if the file could not be opened (recording stays off).
+ */
+bool ToggleProfileCsv(void)
+{
+    if (CsvFile != NULL)
+    {
+        CloseProfile();
+        return true;
+    }
+
+    CsvFile = fopen(PROFILE_CSV_PATH, "w");
+    if (CsvFile == NULL)
+    {
+        TraceLog(LOG_WARNING, "Profile: could not open %s", PROFILE_CSV_PATH);
+        return false;
+    }
+
+    WriteCsvHeader();
+    TraceLog(LOG_INFO, "Profile: recording frames to %s", PROFILE_CSV_PATH);
+    return true;
+}
+
+/**
+ * IsProfileCsvRecording
+ */
+bool IsProfileCsvRecording(void)
+{
+    return CsvFile != NULL;
+}
+
+/**
+ * CloseProfile
+ */
+void CloseProfile(void)
+{
+    if (CsvFile == NULL)
+    {
+        return;
+    }
+
+    if (fclose(CsvFile) != 0)
+    {
+        TraceLog(LOG_WARNING, "Profile: failed to write %s", PROFILE_CSV_PATH);
+    }
+    else
+    {
+        TraceLog(LOG_INFO, "Profile: stopped recording to %s", PROFILE_CSV_PATH);
+    }
+    CsvFile = NULL;
+}
+
+/**
+ * CompareSamples (static)
+ *
+ * qsort comparator for uint64_t samples (ascending).
+ */
+static int CompareSamples(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * WriteCsvHeader (static)
+ *
+ * Writes "frame,<zone>_ns,<zone>_calls,..." in ProfileZone order.
+ */
+static void WriteCsvHeader(void)
+{
+    fputs("frame", CsvFile);
+    for (int zone = 0; zone < PROFILE_ZONE_COUNT; zone++)
+    {
+        fprintf(CsvFile, ",%s_ns,%s_calls", ZONE_NAMES[zone], ZONE_NAMES[zone]);
+    }
+    fputc('\n', CsvFile);
+}
+
+/**
+ * WriteCsvRow (static)
+ */
+static void WriteCsvRow(const ProfileFrame *frame)
+{
+    fprintf(CsvFile, "%llu", (unsigned long long)FrameNumber);
+    for (int zone = 0; zone < PROFILE_ZONE_COUNT; zone++)
+    {
+        fprintf(CsvFile, ",%llu,%u", (unsigned long long)frame->ns[zone], (unsigned)frame->calls[zone]);
+    }
+    fputc('\n', CsvFile);
+}
+
+#endif /* PROFILE */
@@ -0,0 +1,121 @@
+/**
+ * profile.h
+ *
+ * Responsibilities:
+ * - Export the hot-path profiler: scoped timers and call counters around the functions
+ *   every move or frame goes through, a rolling window of per-frame samples summarised
+ *   (min/avg/p99) by the F5 debug overlay, and a CSV dump of every frame (F6).
+ *
+ * Notes:
+ * - The profiler only exists when PROFILE is defined: automatically in Debug builds,
+ *   on request in Release builds (make PROFILE=1, or cmake -DCHESS_PROFILE=ON). Without
+ *   it every macro below expands to nothing and the timed functions carry no overhead.
+ * - Zones are inclusive: a zone timed inside another one (CurrentPosition inside
+ *   ResetsAndValidations) is counted in both.
+ * - Main thread only; the engine and analysis threads are not timed.
+ */
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#if defined(DEBUG) && !defined(PROFILE)
+#define PROFILE
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * ProfileZone
+ *
+ * The timed sections. PROFILE_FRAME is the CPU work of one main-loop iteration (input,
+ * drawing, UI, engine/analysis updates); PROFILE_PRESENT is EndDrawing (buffer swap,
+ * frame limiter and idle waiting), kept apart so it does not hide the frame's own cost.
+ */
+typedef enum ProfileZone
+{
+    PROFILE_FRAME,
+    PROFILE_PRESENT,
+    PROFILE_DRAW_BOARD,
+    PROFILE_RESETS_AND_VALIDATIONS,
+    PROFILE_UPDATE_ATTACK_MAP,
+    PROFILE_FINAL_VALIDATION,
+    PROFILE_CHECKMATE_CHECK,
+    PROFILE_CURRENT_POSITION,
+    PROFILE_LOAD_PIECE,
+    PROFILE_ZONE_COUNT
+} ProfileZone;
+
+/**
+ * ProfileStats
+ *
+ * Summary of one zone over the rolling window, counting only the frames it ran in.
+ *
+ * - frames: frames of the window the zone ran in (0: the other fields are 0).
+ * - minMs, avgMs, p99Ms: time spent in the zone per frame, milliseconds.
+ * - callsPerFrame: average number of calls in those frames.
+ */
+typedef struct ProfileStats
+{
+    int frames;
+    double minMs, avgMs, p99Ms;
+    double callsPerFrame;
+} ProfileStats;
+
+#ifdef PROFILE
+
+/* Monotonic clock in nanoseconds (MonotonicNanoseconds), so a zone never measures a negative time */
+uint64_t ProfileNow(void);
+
+/* Adds one call of ns nanoseconds to zone in the current frame */
+void ProfileAdd(ProfileZone zone, uint64_t ns);
+
+/* Closes the current frame: stores it in the rolling window and writes it to the CSV if one is recording */
+void ProfileEndFrame(void);
+
+/* Writes the summary of zone over the rolling window to stats */
+void GetProfileStats(ProfileZone zone, ProfileStats *stats);
+
+/* Returns the display name of zone */
+const char *ProfileZoneName(ProfileZone zone);
+
+/* Starts or stops writing every frame to PROFILE_CSV_PATH. Returns false if the file could not be opened */
+bool ToggleProfileCsv(void);
+
+/* Returns true while frames are written to the CSV */
+bool IsProfileCsvRecording(void);
+
+/* Closes a CSV that is still recording */
+void CloseProfile(void);
+
+/* Timer of one PROFILE_SCOPE, stopped by ProfileScopeEnd when it goes out of scope */
+typedef struct ProfileScope
+{
+    ProfileZone zone;
+    uint64_t start;
+} ProfileScope;
+
+static inline void ProfileScopeEnd(ProfileScope *scope)
+{
+    ProfileAdd(scope->zone, ProfileNow() - scope->start);
+}
+
+/* Times the rest of the enclosing block, early returns included (GCC/Clang cleanup attribute) */
+#define PROFILE_SCOPE(zone) \
+    ProfileScope profileScope __attribute__((cleanup(ProfileScopeEnd))) = {(zone), ProfileNow()}
+
+/* Time a section of a block: PROFILE_BEGIN(name); ... PROFILE_END(name, zone); */
+#define PROFILE_BEGIN(name) uint64_t profileStart_##name = ProfileNow()
+#define PROFILE_END(name, zone) ProfileAdd((zone), ProfileNow() - profileStart_##name)
+#define PROFILE_END_FRAME() ProfileEndFrame()
+
+#else
+
+#define PROFILE_SCOPE(zone) ((void)0)
+#define PROFILE_BEGIN(name) ((void)0)
+#define PROFILE_END(name, zone) ((void)0)
+#define PROFILE_END_FRAME() ((void)0)
+
+#endif /* PROFILE */
+
+#endif /* PROFILE_H */
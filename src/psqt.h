@@ -0,0 +1,40 @@
+/**
+ * psqt.h
+ *
+ * Responsibilities:
+ * - Export the tapered piece-square tables (material included) and the game phase
+ *   weights the static evaluation is built from.
+ * - Export a helper to compute the piece-square totals of a position from scratch.
+ *
+ * Notes:
+ * - Every entry is signed from White's point of view: a white piece adds its value, a
+ *   black piece subtracts the value of the mirrored square. Summing the entries of all
+ *   pieces gives White's score minus Black's directly.
+ * - Like the Zobrist key, Position keeps these sums up to date in MakeMove/UnmakeMove
+ *   (Position.psqtMidgame/psqtEndgame/phase); Evaluate blends them by the phase.
+ * - Part of libchesscore; this header does not include raylib.
+ */
+
+#ifndef PSQT_H
+#define PSQT_H
+
+#include "bitboard.h"
+#include "piece.h"
+#include "settings.h"
+
+/* Phase of a position with all its pieces (the phase drops towards 0 as pieces come off) */
+#define PHASE_MAX 24
+
+extern int PsqtMidgame[TEAM_COUNT][PIECE_TYPE_COUNT][SQUARE_COUNT];
+extern int PsqtEndgame[TEAM_COUNT][PIECE_TYPE_COUNT][SQUARE_COUNT];
+
+/* Contribution of each PieceType to the game phase (kings and pawns count 0) */
+extern const int PhaseWeights[PIECE_TYPE_COUNT];
+
+/* Fills the tables. Call once at startup (InitChessCore does it) */
+void InitPsqt(void);
+
+/* Piece-square totals of bb, computed from scratch (for positions not built through MakeMove or the FEN parsers) */
+void ComputePsqt(const Bitboards *bb, int *midgame, int *endgame, int *phase);
+
+#endif /* PSQT_H */
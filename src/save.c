@@ -7,10 +7,16 @@
  *   and move clocks.
  *
  * Notes:
- * - The board is read from the global `state` variable (declared in main.c).
+ * - The game state is read through CurrentPosition (move.c) and written by the core
+ *   PositionToFEN (position.c), so the GUI and libchesscore produce identical records.
+ * - SaveFENInto writes into a caller buffer and never allocates; every path in the GUI
+ *   uses it with a stack buffer of MAX_POSITION_FEN_LENGTH bytes.
  * - SaveFEN allocates a heap buffer containing the FEN string.
  *   The caller is responsible for freeing the returned buffer with free().
- * - On allocation failure or invalid piece type, the function returns NULL.
+ *   On allocation failure the function returns NULL.
+ * - BuildPGN recovers the game's first position by taking every Undo stack move back on
+ *   a Position copy (the UndoInfo of each move is stored with it); SavePGN hands the start
+ *   and the moves to the core WritePGN, which produces the SAN.
  *
  * FEN format details:
  * - Ranks are serialized from top (row 0) to bottom (row 7).
@@ -23,14 +29,50 @@
  * - Fullmove number: The number of the full move (starts at 1, increments after Black moves).
  */
 
+#define NO_GLOBAL_GAME_STATE
+
 #include "save.h"
 #include "main.h"
+#include "move.h"
+#include "pgn.h"
+#include "position.h"
 #include "raylib.h"
-#include "settings.h"
-#include <ctype.h>
+#include "stack.h"
+#include "utils.h"
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Local prototypes
+static const char *GameResultTag(GameState *game);
+
+/**
+ * SaveFENInto
+ *
+ * Generates a FEN string representing the current game state into a caller buffer.
+ *
+ * Parameters:
+ *  - buffer: destination of the NUL-terminated record.
+ *  - size:   capacity of buffer in bytes (MAX_POSITION_FEN_LENGTH always suffice).
+ *
+ * Returns:
+ *  - true on success; false if buffer is too small (it then holds an empty string).
+ */
+bool SaveFENInto(GameState *game, char *buffer, size_t size)
+{
+    Position position = CurrentPosition(game);
+
+    if (PositionToFEN(&position, buffer, size) == 0)
+    {
+        TraceLog(LOG_WARNING, "FEN buffer of %zu bytes is too small", size);
+        return false;
+    }
+
+    return true;
+}
 
 /**
  * SaveFEN
@@ -39,178 +81,148 @@
  *
  * Returns:
  *  - A pointer to a null-terminated string containing the FEN.
- *  - NULL if memory allocation fails or an internal error occurs.
+ *  - NULL if memory allocation fails.
  *
  * Memory Management:
  *  - The returned string is allocated on the heap.
  *  - The caller MUST free this memory using free().
  */
-unsigned char *SaveFEN(void)
+unsigned char *SaveFEN(GameState *game)
 {
-    // Big initial buffer size
-    unsigned char *out = malloc((MAX_FEN_BUFFER_SIZE + 1) * sizeof(unsigned char));
-    if (out == NULL)
+    char fen[MAX_POSITION_FEN_LENGTH];
+
+    if (!SaveFENInto(game, fen, sizeof fen))
     {
-        TraceLog(LOG_WARNING, "Couldn't allocate space for the FEN string");
         return NULL;
     }
 
-    int consecutiveEmptyCells = 0;
-    unsigned char currentPiece;
-    int counter = 0;
-
-    // --- 1. PIECE PLACEMENT ---
-    for (int row = 0; row < BOARD_SIZE; row++)
+    size_t length = strlen(fen);
+    unsigned char *out = malloc(length + 1);
+    if (out == NULL)
     {
-        for (int col = 0; col < BOARD_SIZE; col++)
-        {
-            PieceType type = GameBoard[row][col].piece.type;
-            Team team = GameBoard[row][col].piece.team;
-
-            if (type != PIECE_NONE)
-            {
-                if (consecutiveEmptyCells != 0)
-                {
-                    out[counter++] = '0' + consecutiveEmptyCells;
-                    consecutiveEmptyCells = 0; /* reset after flushing */
-                }
-
-                switch (type)
-                {
-                case PIECE_BISHOP:
-                    currentPiece = 'b';
-                    break;
-                case PIECE_KING:
-                    currentPiece = 'k';
-                    break;
-                case PIECE_KNIGHT:
-                    currentPiece = 'n';
-                    break;
-                case PIECE_PAWN:
-                    currentPiece = 'p';
-                    break;
-                case PIECE_QUEEN:
-                    currentPiece = 'q';
-                    break;
-                case PIECE_ROOK:
-                    currentPiece = 'r';
-                    break;
-                default:
-                    TraceLog(LOG_WARNING, "invalid character %c for piece type", type);
-                    free(out);
-                    return NULL;
-                }
-
-                currentPiece = (team == TEAM_BLACK ? currentPiece : toupper(currentPiece));
-
-                out[counter++] = currentPiece;
-            }
-            else
-            {
-                consecutiveEmptyCells++;
-            }
-        }
-
-        /* flush any remaining empty count at end of rank */
-        if (consecutiveEmptyCells != 0)
-        {
-            out[counter++] = '0' + consecutiveEmptyCells;
-            consecutiveEmptyCells = 0;
-        }
-
-        /* add rank separator except after the last rank */
-        if (row < BOARD_SIZE - 1)
-        {
-            out[counter++] = '/';
-        }
+        TraceLog(LOG_WARNING, "Couldn't allocate space for the FEN string");
+        return NULL;
     }
 
-    // --- 2. ACTIVE COLOR ---
-
-    out[counter++] = ' '; // leave an empty space
-    out[counter++] = (state.turn == TEAM_WHITE) ? 'w' : 'b';
-
-    // --- 3. CASTLING RIGHTS ---
-
-    out[counter++] = ' '; // leave an empty space
-
-    bool noRights = true;
+    memcpy(out, fen, length + 1);
+    return out;
+}
 
-    if (state.whiteKingSide)
-    {
-        out[counter++] = 'K';
-        noRights = false;
-    }
+/**
+ * BuildPGN
+ *
+ * Parameters:
+ *  - pgn: filled in completely (about 33 KB: keep it on the heap).
+ *
+ * Returns:
+ *  - false if the history is longer than MAX_PGN_PLIES (a warning is logged).
+ *
+ * Behavior:
+ *  - Date is today; White/Black are "Player", or "Engine" for the side the engine plays.
+ *  - Result follows the game state: 1-0 / 0-1 after a mate, 1/2-1/2 after any draw the
+ *    game detects (stalemate, repetition, insufficient material, 50 moves), * otherwise.
+ */
+bool BuildPGN(GameState *game, PgnGame *pgn)
+{
+    size_t plies = StackSize(game->undoStack);
 
-    if (state.whiteQueenSide)
+    if (plies > MAX_PGN_PLIES)
     {
-        out[counter++] = 'Q';
-        noRights = false;
+        TraceLog(LOG_WARNING, "SavePGN: %zu plies do not fit in a PGN game", plies);
+        return false;
     }
 
-    if (state.blackKingSide)
+    Position position = CurrentPosition(game);
+    for (size_t i = plies; i > 0; i--)
     {
-        out[counter++] = 'k';
-        noRights = false;
+        const Move *record = &game->undoStack->data[i - 1];
+        UnmakeMove(&position, record->move, &record->undo);
     }
 
-    if (state.blackQueenSide)
+    ClearPgnGame(pgn);
+    pgn->start = position;
+    pgn->plyCount = (int)plies;
+    for (size_t i = 0; i < plies; i++)
     {
-        out[counter++] = 'q';
-        noRights = false;
+        pgn->moves[i] = game->undoStack->data[i].move;
     }
 
-    if (noRights)
+    time_t now = time(NULL);
+    struct tm *today = localtime(&now);
+    if (today != NULL)
     {
-        out[counter++] = '-';
+        strftime(pgn->date, sizeof pgn->date, "%Y.%m.%d", today);
     }
+    TextCopy(pgn->event, "Casual game");
+    TextCopy(pgn->white, (game->vsEngine && game->engineTeam == TEAM_WHITE) ? "Engine" : "Player");
+    TextCopy(pgn->black, (game->vsEngine && game->engineTeam == TEAM_BLACK) ? "Engine" : "Player");
+    TextCopy(pgn->result, GameResultTag(game));
 
-    // --- 4. EN PASSANT TARGET ---
-
-    out[counter++] = ' '; // leave an empty space
+    return true;
+}
 
-    if (state.enPassantCol != -1)
+/**
+ * SavePGN
+ *
+ * Parameters:
+ *  - path: file to create or overwrite.
+ *
+ * Returns:
+ *  - true on success; false if BuildPGN fails or the file could not be written (a
+ *    warning is logged).
+ *
+ * Notes:
+ *  - Writes on the calling thread; the GUI's Save button queues the game on the saves
+ *    I/O thread instead (QueueSave, saves.c).
+ */
+bool SavePGN(GameState *game, const char *path)
+{
+    // About 33 KB of moves and tags: on the heap, one per call instead of a shared buffer
+    PgnGame *pgn = malloc(sizeof(PgnGame));
+    if (pgn == NULL)
     {
-        out[counter++] = 'a' + state.enPassantCol;
-
-        // If it's White's turn, the target square is behind the black pawn (rank 6 in FEN, index 2)
-        // If it's Black's turn, the target square is behind the white pawn (rank 3 in FEN, index 5)
-        // Note: FEN ranks are 1-based from bottom (8..1).
-        // Our internal board is 0-based from top (0..7).
-        // Logic check:
-        // If state.turn == WHITE, it means Black just moved a pawn two squares.
-        // Black moved from rank 1 to 3 (internal). Target is rank 2 (internal) -> Rank 6 (FEN).
-        if (state.turn == TEAM_WHITE)
-        {
-            out[counter++] = '6';
-        }
-        else
-        {
-            out[counter++] = '3';
-        }
+        TraceLog(LOG_WARNING, "SavePGN: out of memory");
+        return false;
     }
-    else
+    if (!BuildPGN(game, pgn))
     {
-        out[counter++] = '-';
+        free(pgn);
+        return false;
     }
 
-    // --- 5. HALFMOVE CLOCK & FULLMOVE NUMBER ---
+    FILE *file = fopen(path, "w");
+    if (file == NULL)
+    {
+        TraceLog(LOG_WARNING, "SavePGN: cannot create %s", path);
+        free(pgn);
+        return false;
+    }
 
-    out[counter++] = ' '; // leave an empty space
+    bool written = WritePGN(file, pgn);
+    int plies = pgn->plyCount;
+    free(pgn);
+    if (fclose(file) != 0 || !written)
+    {
+        TraceLog(LOG_WARNING, "SavePGN: error writing %s", path);
+        return false;
+    }
 
-    counter += snprintf((char *)out + counter, (2 * MAX_HALF_FULL_MOVE_DIGITS) + 1, "%d %d", state.halfMoveClock, state.fullMoveNumber);
+    TraceLog(LOG_INFO, "Saved %d plies to %s", plies, path);
+    return true;
+}
 
-    /* ensure space for NUL terminator */
-    unsigned char *temp = realloc(out, counter + 1);
-    if (temp == NULL)
+/**
+ * GameResultTag (static)
+ *
+ * PGN result of the game on the board ("1-0", "0-1", "1/2-1/2" or "*" while it goes on).
+ */
+static const char *GameResultTag(GameState *game)
+{
+    if (game->isCheckmate)
     {
-        TraceLog(LOG_WARNING, "Failed to resize the buffer");
-        out[counter] = '\0';
-        return out;
+        // The side to move is the one that was mated
+        return (game->turn == TEAM_WHITE) ? "0-1" : "1-0";
     }
 
-    out = temp;
-    out[counter] = '\0';
-
-    return out;
+    return IsGameOver(game) ? "1/2-1/2" : "*";
 }
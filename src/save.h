@@ -3,11 +3,30 @@
  *
  * Responsibilities:
  * - Export the FEN generation functionality.
+ * - Export the PGN export of the whole game (move history included).
  */
 
 #ifndef SAVE_H
 #define SAVE_H
 
+#include "position.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct GameState GameState;
+typedef struct PgnGame PgnGame;
+
+/*
+ * SaveFENInto
+ *
+ * Serializes the current game state into buffer (size bytes; MAX_POSITION_FEN_LENGTH
+ * always suffice) without allocating.
+ *
+ * Returns: false if the record did not fit (buffer then holds an empty string).
+ */
+
+bool SaveFENInto(GameState *game, char *buffer, size_t size);
+
 /*
  * SaveFEN
  *
@@ -15,9 +34,31 @@
  *
  * Returns: A pointer to a string containing the FEN representation of the
  *          current game state. The caller is responsible for freeing the
- *          allocated memory.
+ *          allocated memory. Prefer SaveFENInto, which needs no allocation.
+ */
+
+unsigned char *SaveFEN(GameState *game);
+
+/*
+ * BuildPGN
+ *
+ * Fills pgn (tags included) with the game from its first position to the current one,
+ * i.e. every move on the Undo stack, without touching the disk.
+ *
+ * Returns: false if the history is longer than MAX_PGN_PLIES.
+ */
+
+bool BuildPGN(GameState *game, PgnGame *pgn);
+
+/*
+ * SavePGN
+ *
+ * Writes the game from its first position (the one loaded or set up) to the current one,
+ * i.e. every move on the Undo stack, as a PGN file at path.
+ *
+ * Returns: false if the file could not be written.
  */
 
-unsigned char *SaveFEN(void);
+bool SavePGN(GameState *game, const char *path);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,575 @@
+/**
+ * saves.c
+ *
+ * Responsibilities:
+ * - Keep an index of the saves directory (SAVES_DIRECTORY): every <name>.fen parsed once
+ *   into a SaveEntry, so the Load popup lists, previews and loads saves without touching
+ *   the disk.
+ * - Write the saves of the GUI (FEN and PGN) on the same background thread.
+ *
+ * Notes:
+ * - A scan lists the directory and stats every .fen file; only files that are new or whose
+ *   modification time or size changed are read and parsed again. The Load popup asks for
+ *   a scan when it opens and every SAVES_REFRESH_SECONDS while it stays open, so files
+ *   copied in or edited by hand show up without a restart.
+ * - Files larger than MAX_SAVE_FILE_SIZE are listed but not read (they cannot hold a FEN).
+ * - Queued saves are always written, FreeSaves included: closing the window right after a
+ *   save does not lose it.
+ *
+ * Implementation Details:
+ * - One I/O thread waits on a condition variable for queued saves or a scan request. It
+ *   writes the saves in order, updates their entries in its own index from the FEN it
+ *   wrote (no reading back), scans if asked to, and publishes a copy of the index.
+ * - Publishing hands a heap array to the main thread under IndexLock; UpdateSaves takes
+ *   it and frees the previous one. The copy is made on the I/O thread, so the render
+ *   thread only swaps a pointer, once per change.
+ * - PendingWork counts queued requests until their index is published; with
+ *   PublishedEntries still untaken it keeps IsSavesBusy true, so the idle frame logic
+ *   (main.c) does not sleep on a stale list.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "saves.h"
+#include "bitboard.h"
+#include "pgn.h"
+#include "position.h"
+#include "raylib.h"
+#include "settings.h"
+#include <dirent.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+/* "saves/" + name + ".fen" / ".pgn" */
+#define SAVE_PATH_LENGTH (sizeof SAVES_DIRECTORY + MAX_FILE_NAME_LENGTH + 5)
+
+/**
+ * SaveJob
+ *
+ * One queued save, allocated by QueueSave and freed by the I/O thread.
+ */
+typedef struct SaveJob
+{
+    struct SaveJob *next;
+    char name[MAX_FILE_NAME_LENGTH];
+    char fen[MAX_POSITION_FEN_LENGTH];
+    PgnGame *pgn;
+} SaveJob;
+
+/* Requests (main thread -> I/O thread), under QueueLock */
+static pthread_mutex_t QueueLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t QueueSignal = PTHREAD_COND_INITIALIZER;
+static SaveJob *QueueHead = NULL, *QueueTail = NULL;
+static bool ScanRequested = false;
+static bool QuitRequested = false;
+
+static pthread_t IoThread;
+static bool IoRunning = false;
+static atomic_int PendingWork;
+
+/* Index of the I/O thread, sorted by name */
+static SaveEntry *ScanEntries = NULL;
+static size_t ScanCount = 0;
+
+/* Latest published copy (I/O thread -> main thread), under IndexLock */
+static pthread_mutex_t IndexLock = PTHREAD_MUTEX_INITIALIZER;
+static SaveEntry *PublishedEntries = NULL;
+static size_t PublishedCount = 0;
+static atomic_bool Published;
+
+/* Index of the main thread */
+static SaveEntry *Entries = NULL;
+static size_t EntryCount = 0;
+
+// Local prototypes
+static void *IoThreadMain(void *arg);
+static void WriteSave(SaveJob *job);
+static void ScanDirectory(void);
+static void Publish(void);
+static void ReadSaveEntry(const char *path, SaveEntry *entry);
+static void ParseSaveEntry(const char *text, size_t length, SaveEntry *entry);
+static SaveEntry *FindEntry(SaveEntry *entries, size_t count, const char *name);
+static int CompareEntries(const void *a, const void *b);
+static int64_t ModifiedTime(const struct stat *info);
+
+/**
+ * InitializeSaves
+ *
+ * Returns:
+ *  - false if the I/O thread could not be started (the popup then lists no saves and
+ *    saving does nothing; a warning is logged).
+ */
+bool InitializeSaves(void)
+{
+    atomic_init(&PendingWork, 1);
+    atomic_init(&Published, false);
+    ScanRequested = true;
+
+    IoRunning = pthread_create(&IoThread, NULL, IoThreadMain, NULL) == 0;
+    if (!IoRunning)
+    {
+        atomic_store(&PendingWork, 0);
+        TraceLog(LOG_WARNING, "Saves: cannot start the I/O thread");
+    }
+    return IoRunning;
+}
+
+/**
+ * FreeSaves
+ *
+ * Blocks until the queued saves are on disk.
+ */
+void FreeSaves(void)
+{
+    if (IoRunning)
+    {
+        pthread_mutex_lock(&QueueLock);
+        QuitRequested = true;
+        pthread_cond_signal(&QueueSignal);
+        pthread_mutex_unlock(&QueueLock);
+
+        pthread_join(IoThread, NULL);
+        IoRunning = false;
+    }
+
+    free(ScanEntries);
+    free(PublishedEntries);
+    free(Entries);
+    ScanEntries = PublishedEntries = Entries = NULL;
+    ScanCount = PublishedCount = EntryCount = 0;
+}
+
+/**
+ * RefreshSaves
+ *
+ * Requests coalesce: a scan asked for while one is queued is the same scan.
+ */
+void RefreshSaves(void)
+{
+    if (!IoRunning)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&QueueLock);
+    if (!ScanRequested)
+    {
+        ScanRequested = true;
+        atomic_fetch_add(&PendingWork, 1);
+        pthread_cond_signal(&QueueSignal);
+    }
+    pthread_mutex_unlock(&QueueLock);
+}
+
+/**
+ * QueueSave
+ *
+ * Parameters:
+ *  - name: file name without extension (at most MAX_FILE_NAME_LENGTH - 1 bytes).
+ *  - pgn:  heap PgnGame (see BuildPGN) the I/O thread writes and frees; NULL for no PGN.
+ *
+ * Returns:
+ *  - false if the save could not be queued (pgn is freed all the same).
+ */
+bool QueueSave(const char *name, const char *fen, PgnGame *pgn)
+{
+    SaveJob *job = IoRunning ? calloc(1, sizeof(SaveJob)) : NULL;
+
+    if (job == NULL)
+    {
+        TraceLog(LOG_WARNING, "Saves: cannot queue %s", name);
+        free(pgn);
+        return false;
+    }
+    TextCopy(job->name, name);
+    TextCopy(job->fen, fen);
+    job->pgn = pgn;
+
+    pthread_mutex_lock(&QueueLock);
+    if (QueueTail != NULL)
+    {
+        QueueTail->next = job;
+    }
+    else
+    {
+        QueueHead = job;
+    }
+    QueueTail = job;
+    atomic_fetch_add(&PendingWork, 1);
+    pthread_cond_signal(&QueueSignal);
+    pthread_mutex_unlock(&QueueLock);
+
+    return true;
+}
+
+/**
+ * UpdateSaves
+ *
+ * Returns:
+ *  - true if a new index was taken (pointers from SaveEntries and FindSave are then
+ *    stale).
+ */
+bool UpdateSaves(void)
+{
+    if (!atomic_load_explicit(&Published, memory_order_acquire))
+    {
+        return false;
+    }
+
+    pthread_mutex_lock(&IndexLock);
+    free(Entries);
+    Entries = PublishedEntries;
+    EntryCount = PublishedCount;
+    PublishedEntries = NULL;
+    PublishedCount = 0;
+    atomic_store_explicit(&Published, false, memory_order_relaxed);
+    pthread_mutex_unlock(&IndexLock);
+
+    return true;
+}
+
+/**
+ * SaveEntries
+ */
+const SaveEntry *SaveEntries(size_t *count)
+{
+    *count = EntryCount;
+    return Entries;
+}
+
+/**
+ * FindSave
+ */
+const SaveEntry *FindSave(const char *name)
+{
+    return FindEntry(Entries, EntryCount, name);
+}
+
+/**
+ * IsSavesBusy
+ */
+bool IsSavesBusy(void)
+{
+    return atomic_load(&PendingWork) > 0 || atomic_load(&Published);
+}
+
+/**
+ * IoThreadMain (static)
+ *
+ * Saves first (in the order they were queued), then the scan, then one publication for
+ * everything done in the round.
+ */
+static void *IoThreadMain(void *arg)
+{
+    (void)arg;
+
+    for (;;)
+    {
+        pthread_mutex_lock(&QueueLock);
+        while (QueueHead == NULL && !ScanRequested && !QuitRequested)
+        {
+            pthread_cond_wait(&QueueSignal, &QueueLock);
+        }
+        SaveJob *jobs = QueueHead;
+        bool scan = ScanRequested;
+        bool quit = QuitRequested;
+        QueueHead = QueueTail = NULL;
+        ScanRequested = false;
+        pthread_mutex_unlock(&QueueLock);
+
+        int done = 0;
+        while (jobs != NULL)
+        {
+            SaveJob *next = jobs->next;
+            WriteSave(jobs);
+            free(jobs);
+            jobs = next;
+            done++;
+        }
+        if (quit)
+        {
+            break;
+        }
+
+        if (scan)
+        {
+            ScanDirectory();
+            done++;
+        }
+        Publish();
+        atomic_fetch_sub(&PendingWork, done);
+    }
+
+    return NULL;
+}
+
+/**
+ * WriteSave (static)
+ *
+ * Write the FEN and the PGN of a queued save and record the FEN in the index.
+ */
+static void WriteSave(SaveJob *job)
+{
+    char path[SAVE_PATH_LENGTH];
+
+    if (mkdir(SAVES_DIRECTORY, 0755) != 0 && errno != EEXIST)
+    {
+        TraceLog(LOG_WARNING, "Saves: cannot create %s/", SAVES_DIRECTORY);
+    }
+
+    if (job->pgn != NULL)
+    {
+        snprintf(path, sizeof path, "%s/%s.pgn", SAVES_DIRECTORY, job->name);
+        FILE *file = fopen(path, "w");
+        bool written = file != NULL && WritePGN(file, job->pgn);
+        if (file == NULL || fclose(file) != 0 || !written)
+        {
+            TraceLog(LOG_WARNING, "Saves: error writing %s", path);
+        }
+        free(job->pgn);
+    }
+
+    snprintf(path, sizeof path, "%s/%s.fen", SAVES_DIRECTORY, job->name);
+    FILE *file = fopen(path, "w");
+    bool written = file != NULL && fputs(job->fen, file) >= 0;
+    if (file == NULL || fclose(file) != 0 || !written)
+    {
+        TraceLog(LOG_WARNING, "Saves: error writing %s", path);
+        return;
+    }
+    TraceLog(LOG_INFO, "Saved %s", path);
+
+    struct stat info;
+    if (stat(path, &info) != 0)
+    {
+        return;
+    }
+
+    SaveEntry *entry = FindEntry(ScanEntries, ScanCount, job->name);
+    if (entry == NULL)
+    {
+        SaveEntry *grown = realloc(ScanEntries, (ScanCount + 1) * sizeof(SaveEntry));
+        if (grown == NULL)
+        {
+            return; // the next scan finds it
+        }
+        ScanEntries = grown;
+        entry = &ScanEntries[ScanCount++];
+        memset(entry, 0, sizeof *entry);
+        TextCopy(entry->name, job->name);
+    }
+    entry->modified = ModifiedTime(&info);
+    entry->size = (int64_t)info.st_size;
+    ParseSaveEntry(job->fen, strlen(job->fen), entry);
+
+    qsort(ScanEntries, ScanCount, sizeof(SaveEntry), CompareEntries);
+}
+
+/**
+ * ScanDirectory (static)
+ *
+ * Rebuild the I/O thread's index from the directory listing, reusing the entries of the
+ * files that have not changed.
+ */
+static void ScanDirectory(void)
+{
+    DIR *directory = opendir(SAVES_DIRECTORY);
+    if (directory == NULL)
+    {
+        free(ScanEntries);
+        ScanEntries = NULL;
+        ScanCount = 0;
+        return;
+    }
+
+    SaveEntry *entries = NULL;
+    size_t count = 0, capacity = 0;
+    struct dirent *file;
+
+    while ((file = readdir(directory)) != NULL)
+    {
+        size_t length = strlen(file->d_name);
+        if (length <= 4 || strcmp(file->d_name + length - 4, ".fen") != 0 || length - 4 >= MAX_FILE_NAME_LENGTH)
+        {
+            continue;
+        }
+
+        // length < MAX_FILE_NAME_LENGTH + 4 (checked above), so the path fits SAVE_PATH_LENGTH
+        char path[SAVE_PATH_LENGTH];
+        struct stat info;
+        memcpy(path, SAVES_DIRECTORY "/", sizeof SAVES_DIRECTORY);
+        memcpy(path + sizeof SAVES_DIRECTORY, file->d_name, length + 1);
+        if (stat(path, &info) != 0 || !S_ISREG(info.st_mode))
+        {
+            continue;
+        }
+
+        if (count == capacity)
+        {
+            capacity = (capacity > 0) ? capacity * 2 : 64;
+            SaveEntry *grown = realloc(entries, capacity * sizeof(SaveEntry));
+            if (grown == NULL)
+            {
+                TraceLog(LOG_WARNING, "Saves: out of memory listing %s/", SAVES_DIRECTORY);
+                break;
+            }
+            entries = grown;
+        }
+
+        SaveEntry *entry = &entries[count++];
+        char name[MAX_FILE_NAME_LENGTH];
+        memcpy(name, file->d_name, length - 4);
+        name[length - 4] = '\0';
+
+        const SaveEntry *known = FindEntry(ScanEntries, ScanCount, name);
+        if (known != NULL && known->modified == ModifiedTime(&info) && known->size == (int64_t)info.st_size)
+        {
+            *entry = *known;
+            continue;
+        }
+
+        memset(entry, 0, sizeof *entry);
+        TextCopy(entry->name, name);
+        entry->modified = ModifiedTime(&info);
+        entry->size = (int64_t)info.st_size;
+        ReadSaveEntry(path, entry);
+    }
+    closedir(directory);
+
+    qsort(entries, count, sizeof(SaveEntry), CompareEntries);
+    free(ScanEntries);
+    ScanEntries = entries;
+    ScanCount = count;
+}
+
+/**
+ * Publish (static)
+ *
+ * Hand a copy of the I/O thread's index to the main thread, replacing one it has not
+ * taken yet.
+ */
+static void Publish(void)
+{
+    SaveEntry *copy = NULL;
+
+    if (ScanCount > 0)
+    {
+        copy = malloc(ScanCount * sizeof(SaveEntry));
+        if (copy == NULL)
+        {
+            TraceLog(LOG_WARNING, "Saves: out of memory publishing the index");
+            return;
+        }
+        memcpy(copy, ScanEntries, ScanCount * sizeof(SaveEntry));
+    }
+
+    pthread_mutex_lock(&IndexLock);
+    free(PublishedEntries);
+    PublishedEntries = copy;
+    PublishedCount = ScanCount;
+    atomic_store_explicit(&Published, true, memory_order_release);
+    pthread_mutex_unlock(&IndexLock);
+}
+
+/**
+ * ReadSaveEntry (static)
+ *
+ * Read a save file (at most MAX_SAVE_FILE_SIZE bytes) and parse it into entry.
+ */
+static void ReadSaveEntry(const char *path, SaveEntry *entry)
+{
+    char text[MAX_SAVE_FILE_SIZE];
+
+    entry->valid = false;
+    if (entry->size > MAX_SAVE_FILE_SIZE)
+    {
+        return;
+    }
+
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        return;
+    }
+    size_t length = fread(text, 1, sizeof text, file);
+    fclose(file);
+
+    ParseSaveEntry(text, length, entry);
+}
+
+/**
+ * ParseSaveEntry (static)
+ *
+ * Fill the position fields of entry from the first line of a save file.
+ */
+static void ParseSaveEntry(const char *text, size_t length, SaveEntry *entry)
+{
+    size_t end = 0;
+    while (end < length && text[end] != '\n' && text[end] != '\r')
+    {
+        end++;
+    }
+
+    Position position;
+    entry->valid = end < MAX_POSITION_FEN_LENGTH && PositionFromFENSpan(&position, text, end);
+    if (!entry->valid)
+    {
+        return;
+    }
+
+    memcpy(entry->fen, text, end);
+    entry->fen[end] = '\0';
+    entry->side = position.side;
+    entry->fullMoveNumber = position.fullMoveNumber;
+
+    for (int square = 0; square < BOARD_SIZE * BOARD_SIZE; square++)
+    {
+        Team team;
+        PieceType type = PieceTypeAt(&position.bitboards, square, &team);
+        entry->preview[square] = (uint8_t)((type == PIECE_NONE) ? PIECE_NONE : (type | ((team == TEAM_BLACK) ? SAVE_PREVIEW_BLACK : 0)));
+    }
+}
+
+/**
+ * FindEntry (static)
+ *
+ * Returns:
+ *  - The entry named name in a sorted index, or NULL.
+ */
+static SaveEntry *FindEntry(SaveEntry *entries, size_t count, const char *name)
+{
+    SaveEntry key;
+
+    if (count == 0)
+    {
+        return NULL;
+    }
+    TextCopy(key.name, name);
+    return bsearch(&key, entries, count, sizeof(SaveEntry), CompareEntries);
+}
+
+/**
+ * CompareEntries (static)
+ */
+static int CompareEntries(const void *a, const void *b)
+{
+    return strcmp(((const SaveEntry *)a)->name, ((const SaveEntry *)b)->name);
+}
+
+/**
+ * ModifiedTime (static)
+ *
+ * Modification time in nanoseconds: two saves within the same second still differ.
+ */
+static int64_t ModifiedTime(const struct stat *info)
+{
+    return (int64_t)info->st_mtim.tv_sec * 1000000000 + (int64_t)info->st_mtim.tv_nsec;
+}
@@ -0,0 +1,77 @@
+/**
+ * saves.h
+ *
+ * Responsibilities:
+ * - Export the saves directory index: one entry per saves/<name>.fen with the parsed
+ *   position (FEN, side to move, move number) and a board preview, kept up to date by a
+ *   background I/O thread.
+ * - Export the queue of saves written by that thread (the FEN and the PGN of a game).
+ * - Every function here is called from the main thread; the render loop never reads,
+ *   writes or lists a file.
+ */
+
+#ifndef SAVES_H
+#define SAVES_H
+
+#include "piece.h"
+#include "position.h"
+#include "settings.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct PgnGame PgnGame;
+
+/* A preview square: PIECE_NONE, or the piece type with SAVE_PREVIEW_BLACK for Black */
+#define SAVE_PREVIEW_BLACK 0x10
+#define SAVE_PREVIEW_TYPE(square) ((PieceType)((square) & 0x0F))
+#define SAVE_PREVIEW_TEAM(square) (((square)&SAVE_PREVIEW_BLACK) ? TEAM_BLACK : TEAM_WHITE)
+
+/**
+ * SaveEntry
+ *
+ * One saved position as the last scan of the saves directory found it.
+ *
+ * - name:     file name without the .fen extension (what the Save popup asks for).
+ * - valid:    the file holds a FEN; fen, side, fullMoveNumber and preview are only set then.
+ * - preview:  the board, row 0 = rank 8 (see SAVE_PREVIEW_*).
+ * - modified / size: what the file looked like when it was parsed; a scan only parses the
+ *   files whose values changed.
+ */
+typedef struct SaveEntry
+{
+    char name[MAX_FILE_NAME_LENGTH];
+    bool valid;
+    char fen[MAX_POSITION_FEN_LENGTH];
+    Team side;
+    int fullMoveNumber;
+    uint8_t preview[BOARD_SIZE * BOARD_SIZE];
+    int64_t modified; /* nanoseconds since the epoch */
+    int64_t size;
+} SaveEntry;
+
+/* Starts the I/O thread and its first scan of the saves directory. Returns false if the thread cannot start */
+bool InitializeSaves(void);
+
+/* Writes the saves still queued, then stops the I/O thread and frees the index */
+void FreeSaves(void);
+
+/* Asks the I/O thread to check the saves directory for added, changed and removed files */
+void RefreshSaves(void);
+
+/* Queues a save as saves/<name>.fen (fen) and saves/<name>.pgn (pgn, freed by the I/O thread; may be NULL). Returns false if out of memory */
+bool QueueSave(const char *name, const char *fen, PgnGame *pgn);
+
+/* Takes the latest index from the I/O thread (call once per frame). Returns true if the index changed */
+bool UpdateSaves(void);
+
+/* Current index, sorted by name; count receives its length. Valid until the next UpdateSaves */
+const SaveEntry *SaveEntries(size_t *count);
+
+/* Entry of saves/<name>.fen, or NULL if the index has none */
+const SaveEntry *FindSave(const char *name);
+
+/* Returns true while the I/O thread has work queued or an index UpdateSaves has not taken yet */
+bool IsSavesBusy(void);
+
+#endif /* SAVES_H */
@@ -0,0 +1,1107 @@
+/**
+ * search.c
+ *
+ * Responsibilities:
+ * - Find the best move of a position within depth, time and node limits.
+ *
+ * Implementation Details:
+ * - Iterative deepening drives a negamax alpha-beta search (principal variation search:
+ *   the first move gets the full window, the others a null window and a re-search if
+ *   they beat alpha). Every iteration seeds the next through the transposition table.
+ * - Leaves are resolved by a quiescence search over captures and promotions (all moves
+ *   when in check) so the static evaluation is only trusted in quiet positions.
+ * - Move ordering: transposition table move, then captures by MVV-LVA (most valuable
+ *   victim, least valuable attacker), then the two killer moves of the ply, then quiet
+ *   moves by their history score.
+ * - Checks extend the search by one ply.
+ * - With a network (SetEngineNetwork) every worker keeps a stack of NNUE accumulators
+ *   along its current line: the root's is refreshed when the search starts and PlayMove
+ *   derives each child's from its parent's, so a leaf costs one output layer.
+ * - Draws: the fifty-move rule and any repetition of a position on the current path or in
+ *   the game history (within the half-move clock) score 0.
+ * - Endgames the Syzygy tables cover (see tablebase.h) are not searched: a node reached by
+ *   a capture or pawn move scores its WDL outcome (TablebaseScore), and a root plays the
+ *   DTZ move when the DTZ tables are there too.
+ * - The clock and the node budget are polled every STOP_CHECK_INTERVAL nodes; an
+ *   iteration interrupted by a limit is discarded and the previous one is reported.
+ * - Lazy SMP: helper threads run the same iterative deepening on their own worker, so
+ *   their killers and history diverge, and skip some depths (SkipSize/SkipPhase) so they
+ *   are usually an iteration ahead of the main thread. Their only output is what they
+ *   store in the shared transposition table; the main thread's result is reported and,
+ *   once it is done, it raises stopRequested to end the helpers' iterations.
+ * - Only the main thread reads the clock and the budgets. Workers publish their node
+ *   counts to Engine.totalNodes every STOP_CHECK_INTERVAL nodes, which is what the node
+ *   budget is measured against.
+ */
+
+#include "search.h"
+#include "bitboard.h"
+#include "chesscore.h"
+#include "eval.h"
+#include "hash.h"
+#include "movegen.h"
+#include "nnue.h"
+#include "piece.h"
+#include "position.h"
+#include "tablebase.h"
+#include "tt.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Nodes between two polls of the clock and the stop request */
+#define STOP_CHECK_INTERVAL 2048
+
+/* Move ordering bands */
+#define ORDER_TT_MOVE (1 << 30)
+#define ORDER_CAPTURE (1 << 24)
+#define ORDER_KILLER_1 (1 << 22)
+#define ORDER_KILLER_2 (ORDER_KILLER_1 - 1)
+/* History scores are halved once they pass this so they stay below the killer band */
+#define HISTORY_LIMIT (1 << 20)
+
+/* Depth skipping pattern of the helpers, by (id - 1) % SKIP_PATTERN_COUNT: helper i skips
+   the depths where ((depth + SkipPhase[i]) / SkipSize[i]) is odd */
+#define SKIP_PATTERN_COUNT 20
+static const int SkipSize[SKIP_PATTERN_COUNT] = {1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4};
+static const int SkipPhase[SKIP_PATTERN_COUNT] = {0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7};
+
+// Local prototypes
+static void IterativeDeepening(SearchWorker *worker, SearchResult *result);
+static void *HelperMain(void *arg);
+static void StartHelpers(Engine *engine);
+static void WaitForHelpers(Engine *engine);
+static void StopHelpers(Engine *engine);
+static bool SkipDepth(const SearchWorker *worker, int depth);
+static int AlphaBeta(SearchWorker *worker, int alpha, int beta, int depth, int ply);
+static int Quiescence(SearchWorker *worker, int alpha, int beta, int ply);
+static void ScoreMoves(const SearchWorker *worker, const MoveList *list, int *scores, ChessMove ttMove, int ply);
+static ChessMove PickMove(MoveList *list, int *scores, int index);
+static void PlayMove(SearchWorker *worker, ChessMove move, UndoInfo *undo);
+static void TakeBackMove(SearchWorker *worker, ChessMove move, const UndoInfo *undo);
+static int StaticEvaluation(const SearchWorker *worker);
+static bool IsRepetitionOrFiftyMoves(const SearchWorker *worker);
+static void UpdateQuietHeuristics(SearchWorker *worker, ChessMove move, int depth, int ply);
+static bool ShouldStop(SearchWorker *worker);
+static void PublishNodes(SearchWorker *worker);
+static int TablebaseScore(const TablebaseResult *tablebase, int ply);
+static int ScoreToTT(int score, int ply);
+static int ScoreFromTT(int score, int ply);
+
+/**
+ * InitializeEngine
+ *
+ * Parameters:
+ *  - engine:      engine to set up.
+ *  - ttMegabytes: transposition table size in MiB (DEFAULT_TT_MEGABYTES is a good default).
+ *
+ * Returns:
+ *  - false if the transposition table could not be allocated.
+ */
+bool InitializeEngine(Engine *engine, size_t ttMegabytes)
+{
+    memset(engine, 0, sizeof *engine);
+    pthread_mutex_init(&engine->lock, NULL);
+    pthread_cond_init(&engine->wake, NULL);
+    pthread_cond_init(&engine->idle, NULL);
+    atomic_init(&engine->stopRequested, false);
+    atomic_init(&engine->totalNodes, 0);
+
+    if (!InitializeTT(&engine->tt, ttMegabytes) || !SetEngineThreads(engine, 1))
+    {
+        FreeEngine(engine);
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * FreeEngine
+ */
+void FreeEngine(Engine *engine)
+{
+    StopHelpers(engine);
+    free(engine->workers);
+    engine->workers = NULL;
+    engine->threadCount = 0;
+
+    FreeTT(&engine->tt);
+    pthread_mutex_destroy(&engine->lock);
+    pthread_cond_destroy(&engine->wake);
+    pthread_cond_destroy(&engine->idle);
+}
+
+/**
+ * SetEngineHash
+ *
+ * Replace the transposition table with an empty one of ttMegabytes (not while searching).
+ *
+ * Returns:
+ *  - false if the new table could not be allocated (the engine keeps its previous table).
+ */
+bool SetEngineHash(Engine *engine, size_t ttMegabytes)
+{
+    TranspositionTable table;
+
+    if (!InitializeTT(&table, ttMegabytes))
+    {
+        return false;
+    }
+
+    FreeTT(&engine->tt);
+    engine->tt = table;
+    return true;
+}
+
+/**
+ * SetEngineNetwork
+ *
+ * Parameters:
+ *  - network: weights from LoadNnue, or NULL to go back to Evaluate (eval.h).
+ */
+void SetEngineNetwork(Engine *engine, const NnueNetwork *network)
+{
+    engine->network = network;
+}
+
+/**
+ * SetEngineThreads
+ *
+ * Replace the thread pool with threadCount workers (clamped to 1..MAX_SEARCH_THREADS):
+ * the calling thread plus threadCount - 1 helpers that sleep until a search starts.
+ *
+ * Returns:
+ *  - false if the workers could not be allocated (the engine keeps its previous pool) or
+ *    a helper failed to start (the engine runs with the helpers that did).
+ *
+ * Notes:
+ *  - The move ordering history of the old workers is lost.
+ */
+bool SetEngineThreads(Engine *engine, int threadCount)
+{
+    if (threadCount < 1)
+    {
+        threadCount = 1;
+    }
+    if (threadCount > MAX_SEARCH_THREADS)
+    {
+        threadCount = MAX_SEARCH_THREADS;
+    }
+
+    SearchWorker *workers = calloc((size_t)threadCount, sizeof(SearchWorker));
+    if (workers == NULL)
+    {
+        return false;
+    }
+
+    StopHelpers(engine);
+    free(engine->workers);
+    engine->workers = workers;
+    engine->threadCount = 1;
+    engine->quit = false;
+
+    for (int i = 0; i < threadCount; i++)
+    {
+        workers[i].engine = engine;
+        workers[i].id = i;
+        workers[i].searchId = engine->searchId;
+    }
+
+    for (int i = 1; i < threadCount; i++)
+    {
+        if (pthread_create(&workers[i].thread, NULL, HelperMain, &workers[i]) != 0)
+        {
+            return false;
+        }
+        engine->threadCount++;
+    }
+
+    return true;
+}
+
+/**
+ * AvailableCores
+ */
+int AvailableCores(void)
+{
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return (cores > 0) ? (int)cores : 1;
+}
+
+/**
+ * ResetEngine
+ *
+ * Clear the transposition table and the move ordering history.
+ */
+void ResetEngine(Engine *engine)
+{
+    ClearTT(&engine->tt);
+
+    for (int i = 0; i < engine->threadCount; i++)
+    {
+        memset(engine->workers[i].history, 0, sizeof engine->workers[i].history);
+        memset(engine->workers[i].killers, 0, sizeof engine->workers[i].killers);
+    }
+}
+
+/**
+ * SetSearchCallback
+ */
+void SetSearchCallback(Engine *engine, SearchInfoCallback callback, void *userData)
+{
+    engine->onIteration = callback;
+    engine->callbackData = userData;
+}
+
+/**
+ * Search
+ *
+ * Run iterative deepening from root.
+ *
+ * Parameters:
+ *  - engine:       engine state (transposition table is kept between calls).
+ *  - root:         position to search.
+ *  - history:      Zobrist keys of the game positions before root, oldest first (root
+ *                  excluded; NULL if unknown). Used to score repetitions as draws.
+ *  - historyCount: number of keys in history.
+ *  - limits:       depth/time/node limits (NULL or all zero: depth MAX_SEARCH_PLY - 1).
+ *  - result:       receives the best move of the last completed iteration.
+ *
+ * Returns:
+ *  - false if root has no legal move (result->bestMove is then 0).
+ *
+ * Notes:
+ *  - Depth 1 always completes, so a legal move is returned even with a tiny budget.
+ *  - The stop request is cleared when Search returns, not when it starts, so a StopSearch
+ *    racing with the start of the search still ends it after depth 1.
+ *  - A root the tablebase covers returns its tablebase move at once, reported as one
+ *    completed iteration of depth 1 (onIteration is called for it).
+ */
+bool Search(Engine *engine, const Position *root, const uint64_t *history, int historyCount, const SearchLimits *limits, SearchResult *result)
+{
+    SearchWorker *mainWorker = &engine->workers[0];
+    MoveList rootMoves;
+
+    memset(result, 0, sizeof *result);
+    if (GenerateLegalMoves(root, &rootMoves) == 0)
+    {
+        return false;
+    }
+
+    engine->limits = (limits != NULL) ? *limits : (SearchLimits){0};
+    if (engine->limits.depth <= 0 || engine->limits.depth >= MAX_SEARCH_PLY)
+    {
+        engine->limits.depth = MAX_SEARCH_PLY - 1;
+    }
+    atomic_store(&engine->totalNodes, 0);
+    engine->startTime = MonotonicSeconds();
+
+    // Perfect play is one probe away: no tree to search
+    TablebaseResult tablebase;
+    ChessMove tablebaseMove;
+    if (BitCount(root->bitboards.occupied) <= TablebaseMaxPieces() && ProbeTablebaseRoot(root, &tablebaseMove, &tablebase))
+    {
+        result->bestMove = tablebaseMove;
+        result->pv[0] = tablebaseMove;
+        result->pvLength = 1;
+        result->score = TablebaseScore(&tablebase, 0);
+        result->depth = 1;
+        result->seconds = MonotonicSeconds() - engine->startTime;
+        if (engine->onIteration != NULL)
+        {
+            engine->onIteration(result, engine->callbackData);
+        }
+        atomic_store(&engine->stopRequested, false);
+        return true;
+    }
+
+    // Only the last halfMoveClock positions can repeat the root
+    int window = root->halfMoveClock;
+    if (window > historyCount)
+    {
+        window = historyCount;
+    }
+    if (window > MAX_REPETITION_WINDOW)
+    {
+        window = MAX_REPETITION_WINDOW;
+    }
+    if (history == NULL)
+    {
+        window = 0;
+    }
+
+    for (int i = 0; i < engine->threadCount; i++)
+    {
+        SearchWorker *worker = &engine->workers[i];
+
+        worker->pos = *root;
+        worker->accumulatorCount = 1;
+        if (engine->network != NULL)
+        {
+            RefreshAccumulator(engine->network, root, &worker->accumulators[0]);
+        }
+        worker->keyCount = 0;
+        for (int k = historyCount - window; k < historyCount; k++)
+        {
+            worker->keys[worker->keyCount++] = history[k];
+        }
+        worker->keys[worker->keyCount++] = root->key;
+        worker->nodes = 0;
+        worker->reportedNodes = 0;
+        worker->completedDepth = 0;
+        worker->stopped = false;
+        memset(worker->killers, 0, sizeof worker->killers);
+    }
+
+    AgeTT(&engine->tt);
+
+    result->bestMove = rootMoves.moves[0];
+    result->pv[0] = rootMoves.moves[0];
+    result->pvLength = 1;
+
+    StartHelpers(engine);
+    IterativeDeepening(mainWorker, result);
+
+    // The main thread's result is final: end the helpers' iterations
+    atomic_store(&engine->stopRequested, true);
+    WaitForHelpers(engine);
+    atomic_store(&engine->stopRequested, false);
+
+    result->nodes = 0;
+    for (int i = 0; i < engine->threadCount; i++)
+    {
+        result->nodes += engine->workers[i].nodes;
+    }
+    result->seconds = MonotonicSeconds() - engine->startTime;
+    return true;
+}
+
+/**
+ * StopSearch
+ */
+void StopSearch(Engine *engine)
+{
+    atomic_store(&engine->stopRequested, true);
+}
+
+/**
+ * IterativeDeepening (static)
+ *
+ * Search the worker's root at increasing depths until a limit, the depth limit or a
+ * mate score ends it.
+ *
+ * Parameters:
+ *  - worker: workers[0] or a helper.
+ *  - result: updated after every completed iteration (NULL for helpers, which only
+ *            feed the transposition table and skip depths per SkipDepth).
+ */
+static void IterativeDeepening(SearchWorker *worker, SearchResult *result)
+{
+    Engine *engine = worker->engine;
+
+    for (int depth = 1; depth <= engine->limits.depth; depth++)
+    {
+        if (result == NULL && SkipDepth(worker, depth))
+        {
+            continue;
+        }
+
+        int score = AlphaBeta(worker, -INFINITE_SCORE, INFINITE_SCORE, depth, 0);
+
+        if (worker->stopped)
+        {
+            break;
+        }
+
+        worker->completedDepth = depth;
+
+        if (result != NULL)
+        {
+            result->score = score;
+            result->depth = depth;
+            result->pvLength = worker->pvLength[0];
+            memcpy(result->pv, worker->pv[0], sizeof(ChessMove) * (size_t)result->pvLength);
+            if (result->pvLength > 0)
+            {
+                result->bestMove = result->pv[0];
+            }
+            PublishNodes(worker);
+            result->nodes = atomic_load_explicit(&engine->totalNodes, memory_order_relaxed);
+            result->seconds = MonotonicSeconds() - engine->startTime;
+
+            if (engine->onIteration != NULL)
+            {
+                engine->onIteration(result, engine->callbackData);
+            }
+        }
+
+        // A forced mate was found within the depth searched: deeper iterations cannot improve it
+        if (score > MATE_BOUND || score < -MATE_BOUND)
+        {
+            break;
+        }
+    }
+
+    PublishNodes(worker);
+}
+
+/**
+ * HelperMain (static)
+ *
+ * Body of a helper thread: sleep until Search bumps searchId (or the pool shuts down),
+ * run iterative deepening on this worker, report back through activeHelpers.
+ */
+static void *HelperMain(void *arg)
+{
+    SearchWorker *worker = arg;
+    Engine *engine = worker->engine;
+
+    pthread_mutex_lock(&engine->lock);
+    for (;;)
+    {
+        while (!engine->quit && worker->searchId == engine->searchId)
+        {
+            pthread_cond_wait(&engine->wake, &engine->lock);
+        }
+        if (engine->quit)
+        {
+            break;
+        }
+        worker->searchId = engine->searchId;
+        pthread_mutex_unlock(&engine->lock);
+
+        IterativeDeepening(worker, NULL);
+
+        pthread_mutex_lock(&engine->lock);
+        engine->activeHelpers--;
+        if (engine->activeHelpers == 0)
+        {
+            pthread_cond_signal(&engine->idle);
+        }
+    }
+    pthread_mutex_unlock(&engine->lock);
+
+    return NULL;
+}
+
+/**
+ * StartHelpers (static)
+ *
+ * Wake every helper for the search Search has just set up.
+ */
+static void StartHelpers(Engine *engine)
+{
+    if (engine->threadCount < 2)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&engine->lock);
+    engine->searchId++;
+    engine->activeHelpers = engine->threadCount - 1;
+    pthread_cond_broadcast(&engine->wake);
+    pthread_mutex_unlock(&engine->lock);
+}
+
+/**
+ * WaitForHelpers (static)
+ *
+ * Block until every helper has left its search (stopRequested must already be set).
+ */
+static void WaitForHelpers(Engine *engine)
+{
+    pthread_mutex_lock(&engine->lock);
+    while (engine->activeHelpers > 0)
+    {
+        pthread_cond_wait(&engine->idle, &engine->lock);
+    }
+    pthread_mutex_unlock(&engine->lock);
+}
+
+/**
+ * StopHelpers (static)
+ *
+ * Shut the pool down: wake the sleeping helpers with quit set and join them.
+ */
+static void StopHelpers(Engine *engine)
+{
+    if (engine->threadCount < 2)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&engine->lock);
+    engine->quit = true;
+    pthread_cond_broadcast(&engine->wake);
+    pthread_mutex_unlock(&engine->lock);
+
+    for (int i = 1; i < engine->threadCount; i++)
+    {
+        pthread_join(engine->workers[i].thread, NULL);
+    }
+    engine->threadCount = 1;
+}
+
+/**
+ * SkipDepth (static)
+ *
+ * Returns:
+ *  - true if the helper should not search this iteration depth, so helpers spread over
+ *    different depths instead of all repeating the main thread's iteration.
+ */
+static bool SkipDepth(const SearchWorker *worker, int depth)
+{
+    int pattern = (worker->id - 1) % SKIP_PATTERN_COUNT;
+
+    return ((depth + SkipPhase[pattern]) / SkipSize[pattern]) % 2 != 0;
+}
+
+/**
+ * AlphaBeta (static)
+ *
+ * Negamax alpha-beta search of worker->pos.
+ *
+ * Parameters:
+ *  - alpha, beta: search window.
+ *  - depth:       remaining depth in plies (quiescence at 0).
+ *  - ply:         distance from the root.
+ *
+ * Returns:
+ *  - Score of the position (meaningless once worker->stopped is set).
+ */
+static int AlphaBeta(SearchWorker *worker, int alpha, int beta, int depth, int ply)
+{
+    Engine *engine = worker->engine;
+    Position *pos = &worker->pos;
+    bool root = (ply == 0);
+
+    worker->pvLength[ply] = 0;
+
+    if (!root)
+    {
+        if (IsRepetitionOrFiftyMoves(worker))
+        {
+            return 0;
+        }
+
+        // Mate distance pruning: no line from here can beat a mate already found closer to the root
+        if (alpha < -MATE_SCORE + ply)
+        {
+            alpha = -MATE_SCORE + ply;
+        }
+        if (beta > MATE_SCORE - ply - 1)
+        {
+            beta = MATE_SCORE - ply - 1;
+        }
+        if (alpha >= beta)
+        {
+            return alpha;
+        }
+
+        // Only right after a zeroing move is the WDL outcome exact under the fifty-move rule
+        TablebaseResult tablebase;
+        if (pos->halfMoveClock == 0 && BitCount(pos->bitboards.occupied) <= TablebaseMaxPieces() && ProbeTablebase(pos, &tablebase))
+        {
+            return TablebaseScore(&tablebase, ply);
+        }
+    }
+
+    bool inCheck = IsInCheck(pos);
+    if (inCheck)
+    {
+        depth++;
+    }
+
+    if (depth <= 0)
+    {
+        return Quiescence(worker, alpha, beta, ply);
+    }
+
+    if (ply >= MAX_SEARCH_PLY - 1)
+    {
+        return StaticEvaluation(worker);
+    }
+
+    worker->nodes++;
+    if (ShouldStop(worker))
+    {
+        return 0;
+    }
+
+    TTEntry entry;
+    ChessMove ttMove = 0;
+    if (ProbeTT(&engine->tt, pos->key, &entry))
+    {
+        ttMove = entry.move;
+
+        if (!root && entry.depth >= depth)
+        {
+            int ttScore = ScoreFromTT(entry.score, ply);
+
+            if (entry.bound == TT_BOUND_EXACT ||
+                (entry.bound == TT_BOUND_LOWER && ttScore >= beta) ||
+                (entry.bound == TT_BOUND_UPPER && ttScore <= alpha))
+            {
+                return ttScore;
+            }
+        }
+    }
+
+    MoveList list;
+    int scores[MAX_MOVES];
+    int count = GenerateLegalMoves(pos, &list);
+
+    if (count == 0)
+    {
+        return inCheck ? -MATE_SCORE + ply : 0;
+    }
+
+    ScoreMoves(worker, &list, scores, ttMove, ply);
+
+    int originalAlpha = alpha;
+    int bestScore = -INFINITE_SCORE;
+    ChessMove bestMove = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        ChessMove move = PickMove(&list, scores, i);
+        UndoInfo undo;
+        int score;
+
+        PlayMove(worker, move, &undo);
+        if (i == 0)
+        {
+            score = -AlphaBeta(worker, -beta, -alpha, depth - 1, ply + 1);
+        }
+        else
+        {
+            score = -AlphaBeta(worker, -alpha - 1, -alpha, depth - 1, ply + 1);
+            if (score > alpha && score < beta)
+            {
+                score = -AlphaBeta(worker, -beta, -alpha, depth - 1, ply + 1);
+            }
+        }
+        TakeBackMove(worker, move, &undo);
+
+        if (worker->stopped)
+        {
+            return 0;
+        }
+
+        if (score > bestScore)
+        {
+            bestScore = score;
+            bestMove = move;
+
+            if (score > alpha)
+            {
+                alpha = score;
+
+                // Triangular PV update: this move followed by the child's line
+                worker->pv[ply][0] = move;
+                memcpy(&worker->pv[ply][1], worker->pv[ply + 1], sizeof(ChessMove) * (size_t)worker->pvLength[ply + 1]);
+                worker->pvLength[ply] = worker->pvLength[ply + 1] + 1;
+
+                if (alpha >= beta)
+                {
+                    if (!MOVE_IS_CAPTURE(move) && !MOVE_IS_PROMOTION(move))
+                    {
+                        UpdateQuietHeuristics(worker, move, depth, ply);
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+    TTBound bound = (bestScore >= beta) ? TT_BOUND_LOWER : (bestScore > originalAlpha) ? TT_BOUND_EXACT : TT_BOUND_UPPER;
+    StoreTT(&engine->tt, pos->key, bestMove, ScoreToTT(bestScore, ply), depth, bound);
+
+    return bestScore;
+}
+
+/**
+ * Quiescence (static)
+ *
+ * Search only captures and promotions (every evasion when in check) until the position
+ * is quiet, then trust the static evaluation ("stand pat").
+ */
+static int Quiescence(SearchWorker *worker, int alpha, int beta, int ply)
+{
+    Position *pos = &worker->pos;
+
+    worker->pvLength[ply] = 0;
+    worker->nodes++;
+
+    if (ShouldStop(worker))
+    {
+        return 0;
+    }
+
+    if (ply >= MAX_SEARCH_PLY - 1)
+    {
+        return StaticEvaluation(worker);
+    }
+
+    bool inCheck = IsInCheck(pos);
+    int bestScore = -INFINITE_SCORE;
+
+    if (!inCheck)
+    {
+        bestScore = StaticEvaluation(worker);
+        if (bestScore >= beta)
+        {
+            return bestScore;
+        }
+        if (bestScore > alpha)
+        {
+            alpha = bestScore;
+        }
+    }
+
+    MoveList list;
+    int scores[MAX_MOVES];
+    int count = GenerateLegalMoves(pos, &list);
+
+    if (count == 0)
+    {
+        return inCheck ? -MATE_SCORE + ply : 0;
+    }
+
+    ScoreMoves(worker, &list, scores, 0, ply);
+
+    for (int i = 0; i < count; i++)
+    {
+        ChessMove move = PickMove(&list, scores, i);
+
+        if (!inCheck && !MOVE_IS_CAPTURE(move) && !MOVE_IS_PROMOTION(move))
+        {
+            continue;
+        }
+
+        UndoInfo undo;
+        PlayMove(worker, move, &undo);
+        int score = -Quiescence(worker, -beta, -alpha, ply + 1);
+        TakeBackMove(worker, move, &undo);
+
+        if (worker->stopped)
+        {
+            return 0;
+        }
+
+        if (score > bestScore)
+        {
+            bestScore = score;
+            if (score > alpha)
+            {
+                alpha = score;
+                if (alpha >= beta)
+                {
+                    break;
+                }
+            }
+        }
+    }
+
+    return bestScore;
+}
+
+/**
+ * ScoreMoves (static)
+ *
+ * Give every move an ordering score (higher is searched first). See the bands above.
+ */
+static void ScoreMoves(const SearchWorker *worker, const MoveList *list, int *scores, ChessMove ttMove, int ply)
+{
+    const Bitboards *bb = &worker->pos.bitboards;
+    Team us = worker->pos.side;
+
+    for (int i = 0; i < list->count; i++)
+    {
+        ChessMove move = list->moves[i];
+        int from = MOVE_FROM(move);
+        int to = MOVE_TO(move);
+
+        if (move == ttMove)
+        {
+            scores[i] = ORDER_TT_MOVE;
+        }
+        else if (MOVE_IS_CAPTURE(move) || MOVE_IS_PROMOTION(move))
+        {
+            PieceType victim = (MOVE_FLAG(move) == MOVE_EN_PASSANT) ? PIECE_PAWN : PieceTypeAt(bb, to, NULL);
+            PieceType attacker = PieceTypeAt(bb, from, NULL);
+
+            scores[i] = ORDER_CAPTURE + PieceValues[victim] * 16 - PieceValues[attacker] / 16;
+            if (MOVE_IS_PROMOTION(move))
+            {
+                scores[i] += PieceValues[MovePromotionType(move)] * 16;
+            }
+        }
+        else if (move == worker->killers[ply][0])
+        {
+            scores[i] = ORDER_KILLER_1;
+        }
+        else if (move == worker->killers[ply][1])
+        {
+            scores[i] = ORDER_KILLER_2;
+        }
+        else
+        {
+            scores[i] = worker->history[us][from][to];
+        }
+    }
+}
+
+/**
+ * PickMove (static)
+ *
+ * Selection step of a lazy selection sort: swap the best remaining move into index and
+ * return it. Cheaper than a full sort because most nodes cut off after a few moves.
+ */
+static ChessMove PickMove(MoveList *list, int *scores, int index)
+{
+    int best = index;
+
+    for (int i = index + 1; i < list->count; i++)
+    {
+        if (scores[i] > scores[best])
+        {
+            best = i;
+        }
+    }
+
+    if (best != index)
+    {
+        ChessMove move = list->moves[index];
+        int score = scores[index];
+        list->moves[index] = list->moves[best];
+        scores[index] = scores[best];
+        list->moves[best] = move;
+        scores[best] = score;
+    }
+
+    return list->moves[index];
+}
+
+/**
+ * PlayMove (static)
+ *
+ * MakeMove plus pushing the new key on the repetition path and, with a network, the
+ * child's accumulator.
+ */
+static void PlayMove(SearchWorker *worker, ChessMove move, UndoInfo *undo)
+{
+    const NnueNetwork *network = worker->engine->network;
+
+    MakeMove(&worker->pos, move, undo);
+    worker->keys[worker->keyCount++] = worker->pos.key;
+
+    if (network != NULL)
+    {
+        NnueAccumulator *parent = &worker->accumulators[worker->accumulatorCount - 1];
+        UpdateAccumulator(network, parent, parent + 1, &worker->pos, move, undo);
+    }
+    worker->accumulatorCount++;
+}
+
+/**
+ * TakeBackMove (static)
+ */
+static void TakeBackMove(SearchWorker *worker, ChessMove move, const UndoInfo *undo)
+{
+    worker->keyCount--;
+    worker->accumulatorCount--;
+    UnmakeMove(&worker->pos, move, undo);
+}
+
+/**
+ * StaticEvaluation (static)
+ *
+ * Score of the worker's position for the side to move: the network when the engine has
+ * one, Evaluate otherwise.
+ */
+static int StaticEvaluation(const SearchWorker *worker)
+{
+    const NnueNetwork *network = worker->engine->network;
+
+    if (network != NULL)
+    {
+        return EvaluateNnue(network, &worker->accumulators[worker->accumulatorCount - 1], worker->pos.side);
+    }
+
+    return Evaluate(&worker->pos);
+}
+
+/**
+ * IsRepetitionOrFiftyMoves (static)
+ *
+ * Returns:
+ *  - true if the fifty-move rule applies or the current key already appears among the
+ *    last halfMoveClock positions with the same side to move.
+ */
+static bool IsRepetitionOrFiftyMoves(const SearchWorker *worker)
+{
+    const Position *pos = &worker->pos;
+
+    if (pos->halfMoveClock >= 100)
+    {
+        return true;
+    }
+
+    return CountRepetitions(worker->keys, (size_t)worker->keyCount, pos->halfMoveClock, 1) > 0;
+}
+
+/**
+ * UpdateQuietHeuristics (static)
+ *
+ * A quiet move caused a beta cutoff: remember it as a killer for this ply and raise its
+ * history score (depth squared, so cutoffs near the root weigh more).
+ */
+static void UpdateQuietHeuristics(SearchWorker *worker, ChessMove move, int depth, int ply)
+{
+    if (worker->killers[ply][0] != move)
+    {
+        worker->killers[ply][1] = worker->killers[ply][0];
+        worker->killers[ply][0] = move;
+    }
+
+    int *entry = &worker->history[worker->pos.side][MOVE_FROM(move)][MOVE_TO(move)];
+    *entry += depth * depth;
+
+    if (*entry > HISTORY_LIMIT)
+    {
+        for (int team = 0; team < TEAM_COUNT; team++)
+        {
+            for (int from = 0; from < SQUARE_COUNT; from++)
+            {
+                for (int to = 0; to < SQUARE_COUNT; to++)
+                {
+                    worker->history[team][from][to] /= 2;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * ShouldStop (static)
+ *
+ * Poll the stop request every STOP_CHECK_INTERVAL nodes; the main thread also polls the
+ * clock and the node budget of all threads. Once a limit is hit worker->stopped stays set
+ * until the next Search. Nothing stops the main thread's first iteration, so a search
+ * always has a complete depth 1 result to report; helpers stop as soon as asked.
+ */
+static bool ShouldStop(SearchWorker *worker)
+{
+    Engine *engine = worker->engine;
+
+    if (worker->stopped)
+    {
+        return true;
+    }
+
+    if ((worker->nodes & (STOP_CHECK_INTERVAL - 1)) != 0)
+    {
+        return false;
+    }
+
+    PublishNodes(worker);
+
+    if (worker->id != 0)
+    {
+        worker->stopped = atomic_load_explicit(&engine->stopRequested, memory_order_relaxed);
+        return worker->stopped;
+    }
+
+    if (worker->completedDepth == 0)
+    {
+        return false;
+    }
+
+    if (atomic_load_explicit(&engine->stopRequested, memory_order_relaxed) ||
+        (engine->limits.stop != NULL && atomic_load_explicit(engine->limits.stop, memory_order_relaxed)) ||
+        (engine->limits.nodes > 0 && atomic_load_explicit(&engine->totalNodes, memory_order_relaxed) >= engine->limits.nodes) ||
+        (engine->limits.timeMs > 0 && (MonotonicSeconds() - engine->startTime) * 1000.0 >= (double)engine->limits.timeMs))
+    {
+        worker->stopped = true;
+    }
+
+    return worker->stopped;
+}
+
+/**
+ * PublishNodes (static)
+ *
+ * Add the nodes counted since the last call to the engine-wide total.
+ */
+static void PublishNodes(SearchWorker *worker)
+{
+    atomic_fetch_add_explicit(&worker->engine->totalNodes, worker->nodes - worker->reportedNodes, memory_order_relaxed);
+    worker->reportedNodes = worker->nodes;
+}
+
+/**
+ * TablebaseScore (static)
+ *
+ * Search score of a tablebase outcome at ply: a win scores just below MATE_BOUND (less the
+ * further from the root, so the search heads for the nearest one) and is never taken for
+ * a mate; a cursed win or blessed loss scores one point either side of a draw.
+ */
+static int TablebaseScore(const TablebaseResult *tablebase, int ply)
+{
+    switch (tablebase->wdl)
+    {
+    case TABLEBASE_WIN:
+        return MATE_BOUND - MAX_SEARCH_PLY - ply;
+    case TABLEBASE_LOSS:
+        return -(MATE_BOUND - MAX_SEARCH_PLY - ply);
+    case TABLEBASE_CURSED_WIN:
+        return 1;
+    case TABLEBASE_BLESSED_LOSS:
+        return -1;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * ScoreToTT (static)
+ *
+ * Mate scores are stored relative to the node (mate in n from here) instead of the root,
+ * so the entry stays valid when the position is reached at another ply.
+ */
+static int ScoreToTT(int score, int ply)
+{
+    if (score > MATE_BOUND)
+    {
+        return score + ply;
+    }
+    if (score < -MATE_BOUND)
+    {
+        return score - ply;
+    }
+    return score;
+}
+
+/**
+ * ScoreFromTT (static)
+ */
+static int ScoreFromTT(int score, int ply)
+{
+    if (score > MATE_BOUND)
+    {
+        return score - ply;
+    }
+    if (score < -MATE_BOUND)
+    {
+        return score + ply;
+    }
+    return score;
+}
@@ -0,0 +1,179 @@
+/**
+ * search.h
+ *
+ * Responsibilities:
+ * - Export the search engine: iterative deepening negamax alpha-beta with quiescence
+ *   search, move ordering and a transposition table.
+ * - Define the limits a search runs under and the result it reports.
+ * - Own the pool of helper threads used for multi-threaded (Lazy SMP) search.
+ *
+ * Notes:
+ * - Scores are centipawns from the side to move's point of view. A mate in n plies is
+ *   reported as MATE_SCORE - n (or -(MATE_SCORE - n) when being mated).
+ * - Lazy SMP: every thread searches the same root independently and they cooperate only
+ *   through the shared, lock-free transposition table. The thread that calls Search does
+ *   the reported search; helpers skip some depths so they run ahead and fill the table.
+ * - Leaves are scored by Evaluate (eval.h) or, once SetEngineNetwork gave the engine a
+ *   network, by NNUE (nnue.h) from accumulators the workers update move by move.
+ * - Part of libchesscore; this header does not include raylib. Threads are POSIX threads.
+ */
+
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include "movegen.h"
+#include "nnue.h"
+#include "position.h"
+#include "tt.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Deepest ply the search can reach (iterations, check extensions and quiescence included) */
+#define MAX_SEARCH_PLY 64
+
+/* Game positions before the root that are kept for repetition detection */
+#define MAX_REPETITION_WINDOW 128
+
+#define MATE_SCORE 32000
+#define INFINITE_SCORE 32001
+/* Scores beyond this are mate scores */
+#define MATE_BOUND (MATE_SCORE - MAX_SEARCH_PLY)
+
+/* Default transposition table size in MiB */
+#define DEFAULT_TT_MEGABYTES 32
+
+/* Most threads a single engine can search with (the calling thread included) */
+#define MAX_SEARCH_THREADS 256
+
+/**
+ * SearchLimits
+ *
+ * Any field left at 0 (or NULL) means "no limit". Only depth limits are exact; time and
+ * node limits and the stop flag are checked every few thousand nodes.
+ *
+ * - stop: a flag owned by the caller; the search ends once it is set (like StopSearch).
+ *   Unlike the engine's own stop request it is never cleared by the search, so a caller
+ *   that gives every search a fresh flag cannot have a late stop leak into the next one.
+ */
+typedef struct SearchLimits
+{
+    int depth;          /* deepest iteration to run */
+    int64_t timeMs;     /* wall-clock budget in milliseconds */
+    uint64_t nodes;     /* node budget */
+    atomic_bool *stop;  /* external stop flag */
+} SearchLimits;
+
+/**
+ * SearchResult
+ *
+ * State of the search after its last completed iteration.
+ */
+typedef struct SearchResult
+{
+    ChessMove bestMove;
+    int score;
+    int depth;                     /* last completed iteration */
+    uint64_t nodes;                /* nodes visited so far by all threads (main and quiescence search) */
+    double seconds;                /* time spent so far */
+    ChessMove pv[MAX_SEARCH_PLY];  /* principal variation, starting with bestMove */
+    int pvLength;
+} SearchResult;
+
+/* Called (on the thread that called Search) after every completed iteration with the result so far */
+typedef void (*SearchInfoCallback)(const SearchResult *result, void *userData);
+
+struct Engine;
+
+/**
+ * SearchWorker
+ *
+ * Per-thread scratch state: the position being searched, the key path for repetition
+ * detection, the move ordering heuristics and the principal variation table.
+ */
+typedef struct SearchWorker
+{
+    struct Engine *engine;
+    int id;               /* 0 for the thread calling Search, 1.. for helpers */
+    unsigned searchId;    /* last search a helper has started */
+    pthread_t thread;     /* helpers only */
+    Position pos;
+    NnueAccumulator accumulators[MAX_SEARCH_PLY]; /* accumulators[accumulatorCount - 1] is pos's (NNUE only) */
+    int accumulatorCount;
+    uint64_t keys[MAX_REPETITION_WINDOW + MAX_SEARCH_PLY + 1];
+    int keyCount;
+    ChessMove killers[MAX_SEARCH_PLY][2];
+    int history[TEAM_COUNT][SQUARE_COUNT][SQUARE_COUNT];
+    ChessMove pv[MAX_SEARCH_PLY][MAX_SEARCH_PLY];
+    int pvLength[MAX_SEARCH_PLY];
+    uint64_t nodes;
+    uint64_t reportedNodes; /* part of nodes already added to Engine.totalNodes */
+    int completedDepth;     /* limits are only enforced once depth 1 is done */
+    bool stopped;
+} SearchWorker;
+
+/**
+ * Engine
+ *
+ * Everything that survives between searches: the transposition table, the workers and
+ * their helper threads, the stop request and the limits/clock of the running search.
+ *
+ * - The helper threads sleep on wake between searches; Search bumps searchId to start
+ *   them and waits on idle until activeHelpers drops back to 0.
+ * - stopRequested and totalNodes are read by every thread while a search runs.
+ */
+typedef struct Engine
+{
+    TranspositionTable tt;
+    const NnueNetwork *network; /* NULL: piece-square evaluation */
+    SearchWorker *workers; /* threadCount workers; workers[0] runs on the calling thread */
+    int threadCount;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t idle;
+    unsigned searchId;
+    int activeHelpers;
+    bool quit;
+    atomic_bool stopRequested;
+    _Atomic uint64_t totalNodes;
+    SearchLimits limits;
+    double startTime;
+    SearchInfoCallback onIteration;
+    void *callbackData;
+} Engine;
+
+/* Allocates the transposition table and one worker (single-threaded). Returns false on allocation failure */
+bool InitializeEngine(Engine *engine, size_t ttMegabytes);
+
+/* Stops the helper threads and frees the workers and the transposition table */
+void FreeEngine(Engine *engine);
+
+/* Replaces the transposition table with an empty one of ttMegabytes (not while searching). Returns false on allocation failure */
+bool SetEngineHash(Engine *engine, size_t ttMegabytes);
+
+/* Evaluates with network from the next search on (NULL for the piece-square evaluation; not while searching).
+   The network must outlive its use by the engine */
+void SetEngineNetwork(Engine *engine, const NnueNetwork *network);
+
+/* Resizes the thread pool (not while searching). Returns false if fewer threads than asked could be started */
+bool SetEngineThreads(Engine *engine, int threadCount);
+
+/* Number of processors online (at least 1) */
+int AvailableCores(void);
+
+/* Forgets everything learned so far (call when a new game starts) */
+void ResetEngine(Engine *engine);
+
+/* Sets a function called after every completed iteration (NULL to disable) */
+void SetSearchCallback(Engine *engine, SearchInfoCallback callback, void *userData);
+
+/* Searches root under limits with every thread of the pool and writes the best move found.
+   Blocks until done. Returns false if root has no legal move */
+bool Search(Engine *engine, const Position *root, const uint64_t *history, int historyCount, const SearchLimits *limits, SearchResult *result);
+
+/* Asks a running search (or one about to start) to return as soon as possible (safe to call from another thread) */
+void StopSearch(Engine *engine);
+
+#endif /* SEARCH_H */
@@ -0,0 +1,1036 @@
+/**
+ * selfplay.c
+ *
+ * Responsibilities:
+ * - Command-line engine-vs-engine match runner built on libchesscore (no window, no
+ *   audio): play many games at once between two engine configurations from a list of
+ *   openings, write them as PGN and report the score, the Elo difference and (optionally)
+ *   a sequential probability ratio test, so an engine change can be accepted or rejected.
+ *
+ * Usage:
+ *   selfplay [options]
+ *
+ *   --games N                   games to play (default SELFPLAY_DEFAULT_GAMES)
+ *   --concurrency N             games played at once, one thread each (default: one per core)
+ *   --openings FILE             start positions, one FEN or EPD record per line (EPD for
+ *                               files ending in ".epd"); default: the standard start
+ *   --engine1 SPEC / --engine2 SPEC
+ *                               comma-separated key=value list:
+ *                                 name=NAME      name in the PGN and the report
+ *                                 depth=N        iterations per move
+ *                                 nodes=N        node budget per move
+ *                                 movetime=MS    time per move, milliseconds
+ *                                 tc=BASE+INC    clock in seconds (e.g. 10+0.1); a side whose
+ *                                                clock runs out loses
+ *                                 hash=MB        transposition table (default SELFPLAY_DEFAULT_HASH_MB)
+ *                                 nnue=FILE      evaluate with this NNUE network (nnue.h)
+ *                                                instead of the piece-square evaluation
+ *                               a side with no limit searches SELFPLAY_DEFAULT_NODES nodes per move
+ *   --sprt ELO0,ELO1[,ALPHA,BETA]
+ *                               stop as soon as the SPRT accepts H0 (engine1 is ELO0 stronger)
+ *                               or H1 (ELO1 stronger); alpha and beta default to 0.05
+ *   --pgn FILE                  where the games go (default selfplay.pgn, "-" for standard
+ *                               output; the report then goes to standard error)
+ *
+ * Notes:
+ * - Each opening is played twice with colors swapped (games 2k and 2k+1, engine1 White
+ *   first), cycling through the openings when there are fewer than half as many as games.
+ * - Games are adjudicated by the rules only: checkmate, stalemate, threefold repetition,
+ *   the fifty-move rule, insufficient material (IsInsufficientMaterial, shared with the
+ *   GUI) and, with a clock, time forfeit.
+ * - Scores are from engine1's point of view. The Elo estimate uses the logistic model;
+ *   the SPRT is the usual trinomial (win/draw/loss) approximation of the log-likelihood
+ *   ratio, so it tolerates an early stop after every game.
+ * - Exit status is 0 when the match ran (whatever its result), 1 on bad arguments,
+ *   unreadable openings or a PGN write error.
+ *
+ * Implementation Details:
+ * - A worker thread owns two single-threaded engines and one key history, and takes the
+ *   next game index from an atomic counter until the games run out or the SPRT stops
+ *   the match; nothing is shared between games but the result totals and the PGN file,
+ *   which are updated under one mutex when a game ends. Games in progress when the SPRT
+ *   decides are finished and counted.
+ * - Node limits with single-threaded engines make every game reproducible; time limits
+ *   do not, and with more concurrent games than cores the clocks also measure waiting
+ *   for a core (time forfeits).
+ */
+
+#include "chesscore.h"
+#include "hash.h"
+#include "movegen.h"
+#include "nnue.h"
+#include "pgn.h"
+#include "position.h"
+#include "search.h"
+#include "settings.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SELFPLAY_DEFAULT_GAMES 100
+#define SELFPLAY_DEFAULT_NODES 20000
+#define SELFPLAY_DEFAULT_HASH_MB 8
+#define SELFPLAY_DEFAULT_PGN "selfplay.pgn"
+
+/* A progress line is printed every this many finished games */
+#define SELFPLAY_REPORT_INTERVAL 100
+
+/* With a clock, a move gets the remaining time divided by this, plus the increment */
+#define SELFPLAY_MOVES_TO_GO 30
+
+/* Longest input line read from an openings file */
+#define MAX_OPENING_LINE 1024
+
+#define MAX_ENGINE_NAME 32
+
+/* Longest value in an engine spec (a network path) */
+#define MAX_SPEC_VALUE 256
+
+/**
+ * EngineConfig
+ *
+ * One side of the match. Limits left at 0 are not used; baseMs > 0 means a clock.
+ */
+typedef struct EngineConfig
+{
+    char name[MAX_ENGINE_NAME];
+    int depth;
+    uint64_t nodes;
+    int64_t moveTimeMs;
+    int64_t baseMs;
+    int64_t incrementMs;
+    int hashMegabytes;
+    char nnuePath[MAX_SPEC_VALUE]; /* empty: piece-square evaluation */
+    NnueNetwork *network;          /* loaded from nnuePath, shared by every game */
+} EngineConfig;
+
+typedef enum Termination
+{
+    TERMINATION_CHECKMATE,
+    TERMINATION_STALEMATE,
+    TERMINATION_REPETITION,
+    TERMINATION_FIFTY_MOVES,
+    TERMINATION_INSUFFICIENT_MATERIAL,
+    TERMINATION_TIME_FORFEIT,
+    TERMINATION_MAX_LENGTH,
+    TERMINATION_COUNT
+} Termination;
+
+static const char *TerminationNames[TERMINATION_COUNT] = {
+    [TERMINATION_CHECKMATE] = "checkmate",
+    [TERMINATION_STALEMATE] = "stalemate",
+    [TERMINATION_REPETITION] = "repetition",
+    [TERMINATION_FIFTY_MOVES] = "fifty moves",
+    [TERMINATION_INSUFFICIENT_MATERIAL] = "insufficient material",
+    [TERMINATION_TIME_FORFEIT] = "time forfeit",
+    [TERMINATION_MAX_LENGTH] = "max length",
+};
+
+/**
+ * Sprt
+ *
+ * Hypotheses (Elo of engine1 over engine2) and error rates; the bounds follow from them.
+ */
+typedef struct Sprt
+{
+    bool enabled;
+    double elo0, elo1;
+    double alpha, beta;
+} Sprt;
+
+/**
+ * Match
+ *
+ * Everything the workers share. The fields after lock are only touched under it.
+ */
+typedef struct Match
+{
+    EngineConfig engines[2];
+    const Position *openings;
+    int openingCount;
+    int games;
+    Sprt sprt;
+    FILE *pgn;
+    FILE *report;
+    char date[MAX_PGN_TAG_LENGTH];
+    double startTime;
+
+    atomic_int nextGame;
+    atomic_bool stop; /* the SPRT accepted a hypothesis: start no new game */
+
+    pthread_mutex_t lock;
+    uint64_t wins, draws, losses; /* engine1's point of view */
+    uint64_t terminations[TERMINATION_COUNT];
+    uint64_t plies;
+    uint64_t nodes;
+    int finished;
+    bool pgnError;
+    const char *sprtDecision; /* NULL while undecided */
+} Match;
+
+/**
+ * SelfPlayWorker
+ *
+ * One thread: its engines (index 0 plays engine1), its key history and the game it is
+ * playing (a PgnGame is too large for a thread's stack).
+ */
+typedef struct SelfPlayWorker
+{
+    Match *match;
+    pthread_t thread;
+    Engine engines[2];
+    int enginesReady;
+    DynamicHashArray *keys;
+    PgnGame game;
+} SelfPlayWorker;
+
+// Local prototypes
+static bool ParseEngineSpec(const char *spec, EngineConfig *config);
+static bool ParseSprt(const char *text, Sprt *sprt);
+static bool ParseCount(const char *text, long max, int *value);
+static Position *LoadOpenings(const char *path, int *count);
+static void *WorkerMain(void *arg);
+static Termination PlayGame(SelfPlayWorker *worker, int index, double *firstScore, uint64_t *nodes);
+static void RecordGame(SelfPlayWorker *worker, Termination termination, double firstScore, uint64_t nodes);
+static void PrintProgress(const Match *match);
+static void PrintSummary(const Match *match, double seconds);
+static double ScoreToElo(double score);
+static double EloToScore(double elo);
+static double SprtLlr(const Match *match);
+static void SprtBounds(const Sprt *sprt, double *lower, double *upper);
+static void PrintUsage(const char *program);
+
+int main(int argc, char **argv)
+{
+    static Match match = {
+        .engines = {{.name = "engine1"}, {.name = "engine2"}},
+        .games = SELFPLAY_DEFAULT_GAMES,
+    };
+    int concurrency = AvailableCores();
+    const char *openingsPath = NULL;
+    const char *pgnPath = SELFPLAY_DEFAULT_PGN;
+
+    InitChessCore();
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        bool ok = value != NULL;
+
+        if (ok && strcmp(argv[i], "--games") == 0)
+        {
+            ok = ParseCount(value, 100000000, &match.games);
+        }
+        else if (ok && strcmp(argv[i], "--concurrency") == 0)
+        {
+            ok = ParseCount(value, 4096, &concurrency);
+        }
+        else if (ok && strcmp(argv[i], "--openings") == 0)
+        {
+            openingsPath = value;
+        }
+        else if (ok && strcmp(argv[i], "--engine1") == 0)
+        {
+            ok = ParseEngineSpec(value, &match.engines[0]);
+        }
+        else if (ok && strcmp(argv[i], "--engine2") == 0)
+        {
+            ok = ParseEngineSpec(value, &match.engines[1]);
+        }
+        else if (ok && strcmp(argv[i], "--sprt") == 0)
+        {
+            ok = ParseSprt(value, &match.sprt);
+        }
+        else if (ok && strcmp(argv[i], "--pgn") == 0)
+        {
+            pgnPath = value;
+        }
+        else
+        {
+            ok = false;
+        }
+
+        if (!ok)
+        {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+        i++;
+    }
+
+    for (int side = 0; side < 2; side++)
+    {
+        EngineConfig *config = &match.engines[side];
+
+        if (config->depth == 0 && config->nodes == 0 && config->moveTimeMs == 0 && config->baseMs == 0)
+        {
+            config->nodes = SELFPLAY_DEFAULT_NODES;
+        }
+        if (config->hashMegabytes == 0)
+        {
+            config->hashMegabytes = SELFPLAY_DEFAULT_HASH_MB;
+        }
+        if (config->nnuePath[0] != '\0')
+        {
+            config->network = LoadNnue(config->nnuePath);
+            if (config->network == NULL)
+            {
+                fprintf(stderr, "%s: cannot load the network\n", config->nnuePath);
+                FreeNnue(match.engines[0].network);
+                return 1;
+            }
+        }
+    }
+
+    static Position standardStart;
+    if (openingsPath != NULL)
+    {
+        match.openings = LoadOpenings(openingsPath, &match.openingCount);
+        if (match.openings == NULL)
+        {
+            return 1;
+        }
+    }
+    else
+    {
+        PositionFromFEN(&standardStart, STARTING_FEN);
+        match.openings = &standardStart;
+        match.openingCount = 1;
+    }
+
+    match.pgn = (strcmp(pgnPath, "-") == 0) ? stdout : fopen(pgnPath, "w");
+    match.report = (match.pgn == stdout) ? stderr : stdout;
+    if (match.pgn == NULL)
+    {
+        fprintf(stderr, "%s: cannot open for writing\n", pgnPath);
+        return 1;
+    }
+
+    time_t now = time(NULL);
+    struct tm *today = localtime(&now);
+    strftime(match.date, sizeof match.date, "%Y.%m.%d", today);
+
+    if (concurrency > match.games)
+    {
+        concurrency = match.games;
+    }
+
+    SelfPlayWorker *workers = calloc((size_t)concurrency, sizeof *workers);
+    if (workers == NULL)
+    {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    pthread_mutex_init(&match.lock, NULL);
+    atomic_init(&match.nextGame, 0);
+    atomic_init(&match.stop, false);
+
+    fprintf(match.report, "%s vs %s: %d games, %d openings, %d concurrent\n", match.engines[0].name, match.engines[1].name, match.games,
+            match.openingCount, concurrency);
+    fflush(match.report);
+
+    // Every worker is set up before the first game starts, so a failure leaves nothing running
+    bool ready = true;
+    for (int i = 0; i < concurrency && ready; i++)
+    {
+        SelfPlayWorker *worker = &workers[i];
+
+        worker->match = &match;
+        worker->keys = InitializeDHA(256);
+        ready = worker->keys != NULL;
+        for (int side = 0; side < 2 && ready; side++)
+        {
+            ready = InitializeEngine(&worker->engines[side], (size_t)match.engines[side].hashMegabytes);
+            worker->enginesReady += ready ? 1 : 0;
+            if (ready)
+            {
+                SetEngineNetwork(&worker->engines[side], match.engines[side].network);
+            }
+        }
+    }
+
+    int started = 0;
+    if (ready)
+    {
+        match.startTime = MonotonicSeconds();
+        for (int i = 1; i < concurrency; i++)
+        {
+            if (pthread_create(&workers[i].thread, NULL, WorkerMain, &workers[i]) != 0)
+            {
+                break;
+            }
+            started++;
+        }
+
+        // Workers without a thread (creation failed) are simply not used
+        WorkerMain(&workers[0]);
+        for (int i = 1; i <= started; i++)
+        {
+            pthread_join(workers[i].thread, NULL);
+        }
+
+        PrintSummary(&match, MonotonicSeconds() - match.startTime);
+    }
+    else
+    {
+        fprintf(stderr, "Failed to allocate the engines (%d MiB + %d MiB per concurrent game)\n", match.engines[0].hashMegabytes,
+                match.engines[1].hashMegabytes);
+    }
+
+    for (int i = 0; i < concurrency; i++)
+    {
+        for (int side = 0; side < workers[i].enginesReady; side++)
+        {
+            FreeEngine(&workers[i].engines[side]);
+        }
+        FreeDHA(workers[i].keys);
+    }
+    free(workers);
+    FreeNnue(match.engines[0].network);
+    FreeNnue(match.engines[1].network);
+    pthread_mutex_destroy(&match.lock);
+
+    if (match.openings != &standardStart)
+    {
+        free((void *)match.openings);
+    }
+
+    bool written = !match.pgnError && fflush(match.pgn) == 0;
+    if (match.pgn != stdout && fclose(match.pgn) != 0)
+    {
+        written = false;
+    }
+    if (!written)
+    {
+        fprintf(stderr, "%s: write error\n", pgnPath);
+    }
+
+    return (ready && written) ? 0 : 1;
+}
+
+/**
+ * ParseEngineSpec (static)
+ *
+ * Parse "key=value,key=value,..." into config (see Usage). Keys not given keep their value.
+ *
+ * Returns:
+ *  - false on an unknown key or a bad value.
+ */
+static bool ParseEngineSpec(const char *spec, EngineConfig *config)
+{
+    const char *cursor = spec;
+
+    while (*cursor != '\0')
+    {
+        const char *end = strchr(cursor, ',');
+        const char *equals = strchr(cursor, '=');
+        size_t length = (end != NULL) ? (size_t)(end - cursor) : strlen(cursor);
+
+        if (equals == NULL || equals >= cursor + length)
+        {
+            return false;
+        }
+
+        size_t keyLength = (size_t)(equals - cursor);
+        const char *value = equals + 1;
+        size_t valueLength = length - keyLength - 1;
+        char text[MAX_SPEC_VALUE];
+        char *parsedEnd = NULL;
+
+        if (valueLength == 0 || valueLength >= sizeof text)
+        {
+            return false;
+        }
+        memcpy(text, value, valueLength);
+        text[valueLength] = '\0';
+
+        if (keyLength == 4 && strncmp(cursor, "name", 4) == 0)
+        {
+            if (valueLength >= sizeof config->name)
+            {
+                return false;
+            }
+            memcpy(config->name, text, valueLength + 1);
+            parsedEnd = text + valueLength;
+        }
+        else if (keyLength == 5 && strncmp(cursor, "depth", 5) == 0)
+        {
+            long depth = strtol(text, &parsedEnd, 10);
+            if (depth < 1 || depth >= MAX_SEARCH_PLY)
+            {
+                return false;
+            }
+            config->depth = (int)depth;
+        }
+        else if (keyLength == 5 && strncmp(cursor, "nodes", 5) == 0)
+        {
+            config->nodes = strtoull(text, &parsedEnd, 10);
+        }
+        else if (keyLength == 8 && strncmp(cursor, "movetime", 8) == 0)
+        {
+            config->moveTimeMs = strtoll(text, &parsedEnd, 10);
+            if (config->moveTimeMs < 1)
+            {
+                return false;
+            }
+        }
+        else if (keyLength == 2 && strncmp(cursor, "tc", 2) == 0)
+        {
+            double base = strtod(text, &parsedEnd);
+            double increment = 0;
+
+            if (*parsedEnd == '+')
+            {
+                increment = strtod(parsedEnd + 1, &parsedEnd);
+            }
+            if (base <= 0 || increment < 0)
+            {
+                return false;
+            }
+            config->baseMs = (int64_t)(base * 1000.0);
+            config->incrementMs = (int64_t)(increment * 1000.0);
+        }
+        else if (keyLength == 4 && strncmp(cursor, "hash", 4) == 0)
+        {
+            long megabytes = strtol(text, &parsedEnd, 10);
+            if (megabytes < 1 || megabytes > 65536)
+            {
+                return false;
+            }
+            config->hashMegabytes = (int)megabytes;
+        }
+        else if (keyLength == 4 && strncmp(cursor, "nnue", 4) == 0)
+        {
+            memcpy(config->nnuePath, text, valueLength + 1);
+            parsedEnd = text + valueLength;
+        }
+
+        if (parsedEnd == NULL || *parsedEnd != '\0')
+        {
+            return false;
+        }
+
+        cursor += length;
+        if (*cursor == ',')
+        {
+            cursor++;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * ParseSprt (static)
+ *
+ * Parse "ELO0,ELO1[,ALPHA,BETA]".
+ */
+static bool ParseSprt(const char *text, Sprt *sprt)
+{
+    char *end = NULL;
+
+    *sprt = (Sprt){.enabled = true, .alpha = 0.05, .beta = 0.05};
+    sprt->elo0 = strtod(text, &end);
+    if (*end != ',')
+    {
+        return false;
+    }
+    sprt->elo1 = strtod(end + 1, &end);
+    if (*end == ',')
+    {
+        sprt->alpha = strtod(end + 1, &end);
+        if (*end != ',')
+        {
+            return false;
+        }
+        sprt->beta = strtod(end + 1, &end);
+    }
+
+    return *end == '\0' && sprt->elo1 > sprt->elo0 && sprt->alpha > 0 && sprt->alpha < 0.5 && sprt->beta > 0 && sprt->beta < 0.5;
+}
+
+/**
+ * ParseCount (static)
+ *
+ * Parse a whole number in 1..max.
+ */
+static bool ParseCount(const char *text, long max, int *value)
+{
+    char *end = NULL;
+    long parsed = strtol(text, &end, 10);
+
+    if (end == text || *end != '\0' || parsed < 1 || parsed > max)
+    {
+        return false;
+    }
+
+    *value = (int)parsed;
+    return true;
+}
+
+/**
+ * LoadOpenings (static)
+ *
+ * Read every record of an openings file; blank lines and lines starting with '#' are
+ * skipped, malformed or unsound records are reported and skipped.
+ *
+ * Returns:
+ *  - A heap array of *count positions (free it), or NULL if the file cannot be read or
+ *    holds no usable position.
+ */
+static Position *LoadOpenings(const char *path, int *count)
+{
+    FILE *file = fopen(path, "r");
+    size_t pathLength = strlen(path);
+    bool epd = pathLength >= 4 && strcmp(path + pathLength - 4, ".epd") == 0;
+    Position *openings = NULL;
+    int capacity = 0;
+    int skipped = 0;
+    uint64_t lineNumber = 0;
+    char line[MAX_OPENING_LINE];
+
+    *count = 0;
+    if (file == NULL)
+    {
+        fprintf(stderr, "%s: cannot open\n", path);
+        return NULL;
+    }
+
+    while (fgets(line, sizeof line, file) != NULL)
+    {
+        size_t length = strlen(line);
+        size_t first = 0;
+
+        lineNumber++;
+        while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r'))
+        {
+            length--;
+        }
+        while (first < length && (line[first] == ' ' || line[first] == '\t'))
+        {
+            first++;
+        }
+        if (first == length || line[first] == '#')
+        {
+            continue;
+        }
+
+        Position pos;
+        bool parsed = epd ? PositionFromEPD(&pos, line, length) : PositionFromFENSpan(&pos, line, length);
+        const char *problem = parsed ? ValidatePosition(&pos) : "malformed record";
+        if (problem != NULL)
+        {
+            if (skipped++ < 10)
+            {
+                fprintf(stderr, "%s:%llu: %s, skipped\n", path, (unsigned long long)lineNumber, problem);
+            }
+            continue;
+        }
+
+        if (*count == capacity)
+        {
+            int grown = (capacity == 0) ? 64 : 2 * capacity;
+            Position *temp = realloc(openings, sizeof(Position) * (size_t)grown);
+            if (temp == NULL)
+            {
+                fprintf(stderr, "%s: out of memory\n", path);
+                free(openings);
+                fclose(file);
+                return NULL;
+            }
+            openings = temp;
+            capacity = grown;
+        }
+        openings[(*count)++] = pos;
+    }
+
+    fclose(file);
+    if (*count == 0)
+    {
+        fprintf(stderr, "%s: no usable position\n", path);
+        free(openings);
+        return NULL;
+    }
+
+    return openings;
+}
+
+/**
+ * WorkerMain (static)
+ *
+ * Worker body: play games until there are none left or the SPRT stopped the match.
+ */
+static void *WorkerMain(void *arg)
+{
+    SelfPlayWorker *worker = arg;
+    Match *match = worker->match;
+
+    while (!atomic_load(&match->stop))
+    {
+        int index = atomic_fetch_add(&match->nextGame, 1);
+        if (index >= match->games)
+        {
+            break;
+        }
+
+        double firstScore = 0;
+        uint64_t nodes = 0;
+        Termination termination = PlayGame(worker, index, &firstScore, &nodes);
+        RecordGame(worker, termination, firstScore, nodes);
+    }
+
+    return NULL;
+}
+
+/**
+ * PlayGame (static)
+ *
+ * Play game number index into worker->game.
+ *
+ * Parameters:
+ *  - firstScore: receives engine1's score (1, 0.5 or 0).
+ *  - nodes: receives the nodes searched by both engines.
+ *
+ * Behavior:
+ *  - Before each move the position is adjudicated: no legal move (mate or stalemate),
+ *    threefold repetition, the fifty-move rule and insufficient material end the game.
+ *  - The search gets the keys since the last irreversible move, so it sees repetitions.
+ *
+ * Returns:
+ *  - How the game ended.
+ */
+static Termination PlayGame(SelfPlayWorker *worker, int index, double *firstScore, uint64_t *nodes)
+{
+    const Match *match = worker->match;
+    PgnGame *game = &worker->game;
+    int firstWhite = (index % 2 == 0); /* engine1 plays White in even games */
+    Position pos = match->openings[(index / 2) % match->openingCount];
+    int64_t clocks[2] = {match->engines[0].baseMs, match->engines[1].baseMs};
+    bool repeated = false;
+    Termination termination;
+    int winner = -1; /* engine index (0: engine1), -1 for a draw */
+
+    ClearPgnGame(game);
+    snprintf(game->event, sizeof game->event, "Self-play %s vs %s", match->engines[0].name, match->engines[1].name);
+    snprintf(game->date, sizeof game->date, "%s", match->date);
+    snprintf(game->round, sizeof game->round, "%d", index + 1);
+    snprintf(game->white, sizeof game->white, "%s", match->engines[firstWhite ? 0 : 1].name);
+    snprintf(game->black, sizeof game->black, "%s", match->engines[firstWhite ? 1 : 0].name);
+    game->start = pos;
+
+    ResetEngine(&worker->engines[0]);
+    ResetEngine(&worker->engines[1]);
+    ClearDHA(worker->keys);
+    PushDHA(worker->keys, pos.key);
+    *nodes = 0;
+
+    for (;;)
+    {
+        MoveList legal;
+        int toMove = ((pos.side == TEAM_WHITE) == firstWhite) ? 0 : 1;
+
+        if (GenerateLegalMoves(&pos, &legal) == 0)
+        {
+            termination = IsInCheck(&pos) ? TERMINATION_CHECKMATE : TERMINATION_STALEMATE;
+            winner = IsInCheck(&pos) ? 1 - toMove : -1;
+            break;
+        }
+        if (repeated)
+        {
+            termination = TERMINATION_REPETITION;
+            break;
+        }
+        if (pos.halfMoveClock >= 100)
+        {
+            termination = TERMINATION_FIFTY_MOVES;
+            break;
+        }
+        if (IsInsufficientMaterial(&pos.bitboards))
+        {
+            termination = TERMINATION_INSUFFICIENT_MATERIAL;
+            break;
+        }
+        if (game->plyCount >= MAX_PGN_PLIES)
+        {
+            termination = TERMINATION_MAX_LENGTH;
+            break;
+        }
+
+        const EngineConfig *config = &match->engines[toMove];
+        SearchLimits limits = {.depth = config->depth, .nodes = config->nodes, .timeMs = config->moveTimeMs};
+        if (config->baseMs > 0)
+        {
+            int64_t budget = clocks[toMove] / SELFPLAY_MOVES_TO_GO + config->incrementMs;
+            if (budget > clocks[toMove] / 2)
+            {
+                budget = clocks[toMove] / 2;
+            }
+            limits.timeMs = (limits.timeMs > 0 && limits.timeMs < budget) ? limits.timeMs : (budget > 0 ? budget : 1);
+        }
+
+        // The history ends with the current position; the search wants only the positions before it
+        int historyCount = (int)worker->keys->size - 1;
+        int window = (historyCount > MAX_REPETITION_WINDOW) ? MAX_REPETITION_WINDOW : historyCount;
+        SearchResult result;
+
+        double start = MonotonicSeconds();
+        Search(&worker->engines[toMove], &pos, worker->keys->hashArray + (historyCount - window), window, &limits, &result);
+        *nodes += result.nodes;
+
+        if (config->baseMs > 0)
+        {
+            clocks[toMove] -= (int64_t)((MonotonicSeconds() - start) * 1000.0);
+            if (clocks[toMove] < 0)
+            {
+                termination = TERMINATION_TIME_FORFEIT;
+                winner = 1 - toMove;
+                break;
+            }
+            clocks[toMove] += config->incrementMs;
+        }
+
+        UndoInfo undo;
+        MakeMove(&pos, result.bestMove, &undo);
+        game->moves[game->plyCount++] = result.bestMove;
+
+        if (pos.halfMoveClock == 0)
+        {
+            ClearDHA(worker->keys);
+        }
+        PushDHA(worker->keys, pos.key);
+        repeated = IsRepeated3times(worker->keys, pos.halfMoveClock);
+    }
+
+    game->end = pos;
+    *firstScore = (winner == -1) ? 0.5 : (winner == 0) ? 1.0 : 0.0;
+
+    const char *result = "1/2-1/2";
+    if (winner != -1)
+    {
+        bool whiteWon = (winner == 0) == firstWhite;
+        result = whiteWon ? "1-0" : "0-1";
+    }
+    snprintf(game->result, sizeof game->result, "%s", result);
+
+    return termination;
+}
+
+/**
+ * RecordGame (static)
+ *
+ * Add a finished game to the totals, write it to the PGN, print progress and run the
+ * SPRT (under the match lock).
+ */
+static void RecordGame(SelfPlayWorker *worker, Termination termination, double firstScore, uint64_t nodes)
+{
+    Match *match = worker->match;
+
+    pthread_mutex_lock(&match->lock);
+
+    if (firstScore == 1.0)
+    {
+        match->wins++;
+    }
+    else if (firstScore == 0.0)
+    {
+        match->losses++;
+    }
+    else
+    {
+        match->draws++;
+    }
+    match->terminations[termination]++;
+    match->plies += (uint64_t)worker->game.plyCount;
+    match->nodes += nodes;
+    match->finished++;
+
+    if (!WritePGN(match->pgn, &worker->game))
+    {
+        match->pgnError = true;
+    }
+
+    if (match->sprt.enabled && match->sprtDecision == NULL)
+    {
+        double lower, upper;
+        double llr = SprtLlr(match);
+
+        SprtBounds(&match->sprt, &lower, &upper);
+        if (llr >= upper || llr <= lower)
+        {
+            match->sprtDecision = (llr >= upper) ? "H1 accepted" : "H0 accepted";
+            atomic_store(&match->stop, true);
+        }
+    }
+
+    if (match->finished % SELFPLAY_REPORT_INTERVAL == 0)
+    {
+        PrintProgress(match);
+    }
+
+    pthread_mutex_unlock(&match->lock);
+}
+
+/**
+ * PrintProgress (static)
+ *
+ * One line: games so far, W/D/L, Elo and (with --sprt) the LLR.
+ */
+static void PrintProgress(const Match *match)
+{
+    uint64_t games = match->wins + match->draws + match->losses;
+    double score = (match->wins + match->draws / 2.0) / (double)games;
+
+    fprintf(match->report, "%6d/%d  +%llu =%llu -%llu  %.1f%%  Elo %+.1f", match->finished, match->games, (unsigned long long)match->wins,
+            (unsigned long long)match->draws, (unsigned long long)match->losses, 100.0 * score, ScoreToElo(score));
+    if (match->sprt.enabled)
+    {
+        fprintf(match->report, "  LLR %.2f", SprtLlr(match));
+    }
+    fprintf(match->report, "  %.0f games/hour\n", match->finished / ((MonotonicSeconds() - match->startTime) / 3600.0));
+    fflush(match->report);
+}
+
+/**
+ * PrintSummary (static)
+ *
+ * Final report: throughput, score, Elo with its 95% interval, LOS, draw ratio, how the
+ * games ended and the SPRT state.
+ */
+static void PrintSummary(const Match *match, double seconds)
+{
+    FILE *out = match->report;
+    uint64_t games = match->wins + match->draws + match->losses;
+
+    fprintf(out, "\n%llu games in %.1f s: %.0f games/hour, %.0f plies/s, %.0f nodes/s\n", (unsigned long long)games, seconds,
+            seconds > 0 ? games / (seconds / 3600.0) : 0.0, seconds > 0 ? match->plies / seconds : 0.0,
+            seconds > 0 ? match->nodes / seconds : 0.0);
+    if (games == 0)
+    {
+        return;
+    }
+
+    double n = (double)games;
+    double score = (match->wins + match->draws / 2.0) / n;
+    double variance = (match->wins * (1 - score) * (1 - score) + match->draws * (0.5 - score) * (0.5 - score) + match->losses * score * score) / n;
+    double margin = 1.959964 * sqrt(variance / n);
+    double eloLow = ScoreToElo(score - margin);
+    double eloHigh = ScoreToElo(score + margin);
+    double decisive = (double)(match->wins + match->losses);
+    double los = (decisive > 0) ? 0.5 * (1.0 + erf(((double)match->wins - (double)match->losses) / sqrt(2.0 * decisive))) : 0.5;
+
+    fprintf(out, "%s vs %s: +%llu =%llu -%llu  score %.1f%%  draws %.1f%%\n", match->engines[0].name, match->engines[1].name,
+            (unsigned long long)match->wins, (unsigned long long)match->draws, (unsigned long long)match->losses, 100.0 * score,
+            100.0 * match->draws / n);
+    fprintf(out, "Elo %+.1f  (95%%: %+.1f .. %+.1f)  LOS %.1f%%\n", ScoreToElo(score), eloLow, eloHigh, 100.0 * los);
+
+    const char *separator = "Terminations: ";
+    for (int i = 0; i < TERMINATION_COUNT; i++)
+    {
+        if (match->terminations[i] > 0)
+        {
+            fprintf(out, "%s%s %llu", separator, TerminationNames[i], (unsigned long long)match->terminations[i]);
+            separator = ", ";
+        }
+    }
+    fputc('\n', out);
+
+    if (match->sprt.enabled)
+    {
+        double lower, upper;
+
+        SprtBounds(&match->sprt, &lower, &upper);
+        fprintf(out, "SPRT elo0 %.1f elo1 %.1f alpha %.3f beta %.3f: LLR %.2f [%.2f, %.2f], %s\n", match->sprt.elo0, match->sprt.elo1,
+                match->sprt.alpha, match->sprt.beta, SprtLlr(match), lower, upper,
+                (match->sprtDecision != NULL) ? match->sprtDecision : "inconclusive");
+    }
+    fflush(out);
+}
+
+/**
+ * ScoreToElo (static)
+ *
+ * Elo difference of an expected score under the logistic model (clamped to +-2000 at
+ * scores of 0 and 1).
+ */
+static double ScoreToElo(double score)
+{
+    if (score <= 0.0)
+    {
+        return -2000.0;
+    }
+    if (score >= 1.0)
+    {
+        return 2000.0;
+    }
+    return -400.0 * log10(1.0 / score - 1.0);
+}
+
+/**
+ * EloToScore (static)
+ */
+static double EloToScore(double elo)
+{
+    return 1.0 / (1.0 + pow(10.0, -elo / 400.0));
+}
+
+/**
+ * SprtLlr (static)
+ *
+ * Log-likelihood ratio of H1 over H0 for the games so far, from the mean score and its
+ * variance. Every outcome count gets a pseudo-count of one half, so a one-sided start
+ * (only wins, say) still has a variance and can end the test, while a single early game
+ * cannot.
+ */
+static double SprtLlr(const Match *match)
+{
+    double wins = match->wins + 0.5;
+    double draws = match->draws + 0.5;
+    double losses = match->losses + 0.5;
+    double n = wins + draws + losses;
+
+    if (match->wins + match->draws + match->losses == 0)
+    {
+        return 0.0;
+    }
+
+    double score = (wins + draws / 2.0) / n;
+    double variance = (wins * (1 - score) * (1 - score) + draws * (0.5 - score) * (0.5 - score) + losses * score * score) / n;
+    double s0 = EloToScore(match->sprt.elo0);
+    double s1 = EloToScore(match->sprt.elo1);
+
+    return (s1 - s0) * (2.0 * score - s0 - s1) / (2.0 * variance / n);
+}
+
+/**
+ * SprtBounds (static)
+ *
+ * Wald's stopping bounds: accept H0 at or below lower, H1 at or above upper.
+ */
+static void SprtBounds(const Sprt *sprt, double *lower, double *upper)
+{
+    *lower = log(sprt->beta / (1.0 - sprt->alpha));
+    *upper = log((1.0 - sprt->beta) / sprt->alpha);
+}
+
+/**
+ * PrintUsage (static)
+ */
+static void PrintUsage(const char *program)
+{
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  --games N                      games to play (default %d)\n"
+            "  --concurrency N                games at once, one thread each (default: one per core)\n"
+            "  --openings FILE                one FEN/EPD per line, each played with both colors\n"
+            "  --engine1 SPEC, --engine2 SPEC name=,depth=,nodes=,movetime=MS,tc=BASE+INC,hash=MB,nnue=FILE\n"
+            "  --sprt ELO0,ELO1[,ALPHA,BETA]  stop once the SPRT accepts a hypothesis\n"
+            "  --pgn FILE                     games output (default %s, - for stdout)\n",
+            program, SELFPLAY_DEFAULT_GAMES, SELFPLAY_DEFAULT_PGN);
+}
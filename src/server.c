@@ -0,0 +1,1639 @@
+/**
+ * server.c
+ *
+ * Responsibilities:
+ * - chess-server: a headless game server built on libchesscore (no window, no audio)
+ *   that hosts many games in one process. Clients connect over TCP, create or join
+ *   games, send moves, and every player and spectator of a game receives each move as
+ *   it is played.
+ *
+ * Usage:
+ *   chess-server [--address ADDR] [--port N] [--workers N] [--max-games N]
+ *
+ *   --address ADDR   IPv4 address to listen on (default SERVER_DEFAULT_ADDRESS)
+ *   --port N         TCP port (default SERVER_DEFAULT_PORT)
+ *   --workers N      event-loop threads (default: one per core)
+ *   --max-games N    games in progress at once (default SERVER_DEFAULT_MAX_GAMES)
+ *
+ * Protocol (one command or reply per line, '\n' terminated; "<id>" is a game id):
+ *   new [white|black] [fen <FEN>]   create a game (default White, standard start)
+ *                                   -> created <id> <color>, then the snapshot
+ *   join <id>                       take the free seat -> joined <id> <color>, then the
+ *                                   snapshot; the other player gets "opponent <id> joined"
+ *   watch <id>                      spectate -> watching <id>, then the snapshot
+ *   move <id> <move>                play a move (UCI long algebraic: e2e4, e7e8q, e1g1)
+ *   resign <id>                     lose the game
+ *   leave <id>                      stop playing or watching -> left <id>
+ *   stats                           -> stats workers W clients C games G finished F moves M
+ *   ping                            -> pong
+ *   quit                            close the connection
+ *
+ *   Sent to every player and spectator of a game:
+ *   game <id> position fen <FEN> moves <move>...  snapshot: start position and every move
+ *                                    so far, in UCI "position" syntax
+ *   move <id> <ply> <move>           the move that made the game <ply> plies long
+ *   end <id> <result> <reason>       1-0, 0-1, 1/2-1/2 or * (abandoned before it started);
+ *                                    reasons: checkmate, stalemate, repetition, fifty-moves,
+ *                                    insufficient-material, max-length, resignation, abandoned
+ *   Errors: error <id|-> <message>
+ *
+ * Notes:
+ * - A game is a core Position plus its 16-bit move log and the keys since the last
+ *   irreversible move (threefold repetition), a few hundred bytes in all next to the GUI's
+ *   GameState with its render cells, sounds and history stacks. The start position is
+ *   only stored when it is not the standard one.
+ * - Spectators get the position once (the snapshot) and then only the moves: one short
+ *   line per ply, numbered so a late or reconnecting client can tell where it stands.
+ * - Moves are checked against the legal move generator (movegen.c); the game is ended by
+ *   the rules (checkmate, stalemate, threefold repetition, fifty moves, insufficient
+ *   material), by a resignation, when a player leaves or disconnects (the opponent wins),
+ *   or as a draw after SERVER_MAX_PLIES plies. Finished games are freed at once.
+ * - The same connection may hold both seats of a game (analysis boards, bots) and play
+ *   or watch any number of games.
+ * - The server runs until it is killed. It uses epoll, so it builds on Linux only.
+ *
+ * Implementation Details:
+ * - The main thread accepts connections and hands them to the workers in turn. Each
+ *   worker is one thread with its own epoll set and owns its clients and the games whose
+ *   number - 1 is its index modulo the worker count, so no game or client is ever touched
+ *   by two threads and nothing needs a lock but the mailboxes.
+ * - Work for another worker (a command for one of its games, output for one of its
+ *   clients) goes through that worker's mailbox, a locked list woken by an eventfd.
+ *   Work for the worker's own games and clients is done in place.
+ * - Clients are named by a handle (slot, worker, generation), so output queued for a
+ *   connection that has closed meanwhile is recognised and dropped. Game ids likewise
+ *   carry the generation of their slot above the game number, so a command for a game
+ *   that has ended never reaches the next game in its slot.
+ * - Output is appended to the client's buffer and written once per event-loop round;
+ *   a client that lets more than SERVER_MAX_PENDING_OUTPUT bytes pile up is dropped.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "chesscore.h"
+#include "hash.h"
+#include "movegen.h"
+#include "pgn.h"
+#include "position.h"
+#include "search.h"
+#include "settings.h"
+#include <arpa/inet.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SERVER_DEFAULT_ADDRESS "127.0.0.1"
+#define SERVER_DEFAULT_PORT 7890
+#define SERVER_DEFAULT_MAX_GAMES 1000000
+
+/* Workers are 8 bits of a client handle */
+#define SERVER_MAX_WORKERS 256
+
+/* Longest command line (new with a FEN) */
+#define SERVER_MAX_LINE 1024
+
+/* Longest formatted reply (snapshots are built to size) */
+#define SERVER_MAX_REPLY 256
+
+/* Output a client may leave unread before it is dropped */
+#define SERVER_MAX_PENDING_OUTPUT (4 * 1024 * 1024)
+
+/* A game this long is drawn (the fifty-move rule alone does not bound a game) */
+#define SERVER_MAX_PLIES 2048
+
+#define SERVER_MAX_EVENTS 256
+#define SERVER_LISTEN_BACKLOG 1024
+
+/* Client handle: generation (32 bits) | worker (8 bits) | slot (24 bits); 0 is no client */
+typedef uint64_t ClientHandle;
+
+#define MAKE_HANDLE(worker, slot, generation) (((uint64_t)(generation) << 32) | ((uint64_t)(worker) << 24) | (uint64_t)(slot))
+#define HANDLE_WORKER(handle) ((int)(((handle) >> 24) & 0xFF))
+#define HANDLE_SLOT(handle) ((uint32_t)((handle)&0xFFFFFF))
+#define HANDLE_GENERATION(handle) ((uint32_t)((handle) >> 32))
+
+/* Game id: generation (32 bits) | number (32 bits, slot * workers + worker + 1); 0 is no game */
+typedef uint64_t GameId;
+
+#define MAKE_GAME_ID(number, generation) (((uint64_t)(generation) << 32) | (uint64_t)(number))
+#define GAME_NUMBER(id) ((uint32_t)((id)&0xFFFFFFFF))
+#define GAME_GENERATION(id) ((uint32_t)((id) >> 32))
+#define SERVER_MAX_CLIENT_SLOTS (1u << 24)
+
+/* epoll token of a worker's eventfd (no client has handle 0) */
+#define WAKE_TOKEN 0
+
+typedef enum GameCommand
+{
+    GAME_NEW,
+    GAME_JOIN,
+    GAME_WATCH,
+    GAME_MOVE,
+    GAME_RESIGN,
+    GAME_LEAVE,
+    GAME_DISCONNECT, /* the client closed: leave without a reply */
+} GameCommand;
+
+typedef enum MessageKind
+{
+    MESSAGE_ADOPT,  /* a new connection for the worker */
+    MESSAGE_GAME,   /* a command for one of the worker's games */
+    MESSAGE_OUTPUT, /* text for one of the worker's clients */
+} MessageKind;
+
+/**
+ * Message
+ *
+ * One item of a worker's mailbox, allocated by the sender and freed by the receiver.
+ */
+typedef struct Message
+{
+    struct Message *next;
+    MessageKind kind;
+    GameCommand command; /* MESSAGE_GAME */
+    ClientHandle client; /* who sent the command, or who the output is for */
+    GameId game;
+    int attach; /* MESSAGE_OUTPUT: +1 the client is now in game, -1 it no longer is */
+    int fd;     /* MESSAGE_ADOPT */
+    size_t length;
+    char text[]; /* command argument or output, terminated */
+} Message;
+
+/**
+ * Client
+ *
+ * One connection. The struct of a slot is reused by later connections (fd is -1 while
+ * the slot is free), so pointers to it stay valid; the generation tells them apart.
+ */
+typedef struct Client
+{
+    int fd;
+    uint32_t generation;
+    char input[SERVER_MAX_LINE];
+    size_t inputLength;
+    char *output; /* bytes outputStart..outputEnd are still to be written */
+    size_t outputStart, outputEnd, outputCapacity;
+    bool writing;  /* waiting for EPOLLOUT */
+    bool dirty;    /* in the worker's dirty list */
+    bool dropping; /* close once the round is over (quit, overflow, overlong line) */
+    GameId *games; /* games the client plays or watches (told about a disconnect) */
+    uint32_t gameCount, gameCapacity;
+} Client;
+
+/**
+ * ServerGame
+ *
+ * A game in progress: the position, the move log and who is in it.
+ */
+typedef struct ServerGame
+{
+    Position position;
+    ChessMove *moves;
+    uint32_t moveCount, moveCapacity;
+    DynamicHashArray *keys;         /* keys since the last irreversible move, current one last */
+    char *startFen;                 /* NULL: the standard start */
+    ClientHandle seats[TEAM_COUNT]; /* 0: free */
+    ClientHandle *watchers;
+    uint32_t watcherCount, watcherCapacity;
+} ServerGame;
+
+/**
+ * Worker
+ *
+ * One event-loop thread with its clients and games. Only inbox/inboxTail are shared.
+ */
+typedef struct Worker
+{
+    int index;
+    pthread_t thread;
+    int poll; /* epoll instance */
+    int wake; /* eventfd, readable while the inbox has mail */
+
+    pthread_mutex_t lock;
+    Message *inbox, *inboxTail;
+
+    Client **clients;
+    uint32_t clientCount, clientCapacity;
+    uint32_t *freeClients;
+    uint32_t freeClientCount, freeClientCapacity;
+
+    ServerGame **games; /* NULL: free slot */
+    uint32_t gameCount, gameCapacity;
+    uint32_t *gameGenerations; /* per slot: generation of its current or last game */
+    uint32_t gameGenerationCapacity;
+    uint32_t *freeGames;
+    uint32_t freeGameCount, freeGameCapacity;
+
+    ClientHandle *dirty; /* clients with output queued this round */
+    uint32_t dirtyCount, dirtyCapacity;
+} Worker;
+
+static Worker *Workers;
+static int WorkerCount;
+static unsigned long MaxGames = SERVER_DEFAULT_MAX_GAMES;
+
+static atomic_uint ActiveClients;
+static atomic_ulong ActiveGames;
+static atomic_ulong FinishedGames;
+static atomic_ulong MovesPlayed;
+
+static const char *TeamNames[TEAM_COUNT] = {[TEAM_WHITE] = "white", [TEAM_BLACK] = "black"};
+
+// Local prototypes
+static int OpenListener(const char *address, int port);
+static bool StartWorker(Worker *worker, int index);
+static void *WorkerMain(void *arg);
+static Message *NewMessage(MessageKind kind, size_t length);
+static void Post(Worker *target, Message *message);
+static void DrainInbox(Worker *worker);
+static void AdoptClient(Worker *worker, int fd);
+static Client *FindClient(Worker *worker, ClientHandle handle);
+static void ReadClient(Worker *worker, ClientHandle handle);
+static void HandleLine(Worker *worker, ClientHandle handle, char *line);
+static void RouteGameCommand(Worker *worker, ClientHandle client, GameCommand command, GameId id, const char *text);
+static void HandleGameCommand(Worker *worker, ClientHandle client, GameCommand command, GameId id, char *text);
+static void CreateGame(Worker *worker, ClientHandle client, char *text);
+static void JoinGame(Worker *worker, ClientHandle client, GameId id, ServerGame *game);
+static void WatchGame(Worker *worker, ClientHandle client, GameId id, ServerGame *game);
+static void PlayMove(Worker *worker, ClientHandle client, GameId id, ServerGame *game, char *text);
+static void LeaveGame(Worker *worker, ClientHandle client, GameId id, ServerGame *game, bool resign, bool silent);
+static void EndGame(Worker *worker, GameId id, const char *result, const char *reason);
+static ServerGame *FindGame(Worker *worker, GameId id);
+static void Broadcast(Worker *worker, const ServerGame *game, GameId id, int attach, const char *text, size_t length);
+static void SendSnapshot(Worker *worker, ClientHandle client, const ServerGame *game, GameId id);
+static void SendFormat(Worker *worker, ClientHandle client, GameId id, int attach, const char *format, ...);
+static void SendText(Worker *worker, ClientHandle client, GameId id, int attach, const char *text, size_t length);
+static void DeliverOutput(Worker *worker, ClientHandle handle, GameId id, int attach, const char *text, size_t length);
+static bool FlushClient(Worker *worker, Client *client, ClientHandle handle);
+static void FlushDirty(Worker *worker);
+static void CloseClient(Worker *worker, ClientHandle handle);
+static bool Reserve(void *array, uint32_t *capacity, uint32_t needed, size_t elementSize);
+static bool ParseNumber(const char *text, unsigned long max, unsigned long *value);
+static char *NextToken(char **cursor);
+static void PrintUsage(const char *program);
+
+int main(int argc, char **argv)
+{
+    const char *address = SERVER_DEFAULT_ADDRESS;
+    unsigned long port = SERVER_DEFAULT_PORT;
+    unsigned long workers = (unsigned long)AvailableCores();
+
+    InitChessCore();
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        bool ok = value != NULL;
+
+        if (ok && strcmp(argv[i], "--address") == 0)
+        {
+            address = value;
+        }
+        else if (ok && strcmp(argv[i], "--port") == 0)
+        {
+            ok = ParseNumber(value, 65535, &port);
+        }
+        else if (ok && strcmp(argv[i], "--workers") == 0)
+        {
+            ok = ParseNumber(value, SERVER_MAX_WORKERS, &workers);
+        }
+        else if (ok && strcmp(argv[i], "--max-games") == 0)
+        {
+            ok = ParseNumber(value, UINT32_MAX / 2, &MaxGames);
+        }
+        else
+        {
+            ok = false;
+        }
+
+        if (!ok)
+        {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+        i++;
+    }
+    if (workers > SERVER_MAX_WORKERS)
+    {
+        workers = SERVER_MAX_WORKERS;
+    }
+
+    int listener = OpenListener(address, (int)port);
+    if (listener < 0)
+    {
+        return 1;
+    }
+
+    WorkerCount = (int)workers;
+    Workers = calloc((size_t)WorkerCount, sizeof(Worker));
+    if (Workers == NULL)
+    {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    for (int i = 0; i < WorkerCount; i++)
+    {
+        if (!StartWorker(&Workers[i], i))
+        {
+            fprintf(stderr, "Cannot start worker %d: %s\n", i, strerror(errno));
+            return 1;
+        }
+    }
+
+    printf("chess-server listening on %s:%lu (%d workers)\n", address, port, WorkerCount);
+    fflush(stdout);
+
+    // Hand connections to the workers in turn
+    int next = 0;
+    for (;;)
+    {
+        int fd = accept(listener, NULL, NULL);
+        if (fd < 0)
+        {
+            if (errno == EMFILE || errno == ENFILE)
+            {
+                // Out of descriptors: give the workers time to close some
+                struct timespec pause = {.tv_sec = 0, .tv_nsec = 10 * 1000 * 1000};
+                nanosleep(&pause, NULL);
+            }
+            else if (errno != EINTR && errno != ECONNABORTED)
+            {
+                fprintf(stderr, "accept: %s\n", strerror(errno));
+            }
+            continue;
+        }
+
+        int one = 1;
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+
+        Message *message = NewMessage(MESSAGE_ADOPT, 0);
+        if (message == NULL)
+        {
+            close(fd);
+            continue;
+        }
+        message->fd = fd;
+        Post(&Workers[next], message);
+        next = (next + 1) % WorkerCount;
+    }
+}
+
+/**
+ * OpenListener (static)
+ *
+ * Returns:
+ *  - A listening TCP socket on address:port, or -1 (reported) if it cannot be opened.
+ */
+static int OpenListener(const char *address, int port)
+{
+    struct sockaddr_in endpoint = {.sin_family = AF_INET, .sin_port = htons((uint16_t)port)};
+
+    if (inet_pton(AF_INET, address, &endpoint.sin_addr) != 1)
+    {
+        fprintf(stderr, "%s: not an IPv4 address\n", address);
+        return -1;
+    }
+
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    if (listener < 0 || setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof one) != 0 ||
+        bind(listener, (struct sockaddr *)&endpoint, sizeof endpoint) != 0 || listen(listener, SERVER_LISTEN_BACKLOG) != 0)
+    {
+        fprintf(stderr, "Cannot listen on %s:%d: %s\n", address, port, strerror(errno));
+        if (listener >= 0)
+        {
+            close(listener);
+        }
+        return -1;
+    }
+
+    return listener;
+}
+
+/**
+ * StartWorker (static)
+ *
+ * Create the worker's epoll set and eventfd and start its thread.
+ *
+ * Returns:
+ *  - false if one of them cannot be created (errno tells why).
+ */
+static bool StartWorker(Worker *worker, int index)
+{
+    worker->index = index;
+    worker->poll = epoll_create1(0);
+    worker->wake = eventfd(0, EFD_NONBLOCK);
+    if (worker->poll < 0 || worker->wake < 0)
+    {
+        return false;
+    }
+
+    struct epoll_event event = {.events = EPOLLIN, .data.u64 = WAKE_TOKEN};
+    if (epoll_ctl(worker->poll, EPOLL_CTL_ADD, worker->wake, &event) != 0)
+    {
+        return false;
+    }
+
+    pthread_mutex_init(&worker->lock, NULL);
+    return pthread_create(&worker->thread, NULL, WorkerMain, worker) == 0;
+}
+
+/**
+ * WorkerMain (static)
+ *
+ * Event loop of one worker: mailbox, reads and writes, then the output of the round.
+ */
+static void *WorkerMain(void *arg)
+{
+    Worker *worker = arg;
+    struct epoll_event events[SERVER_MAX_EVENTS];
+
+    for (;;)
+    {
+        int count = epoll_wait(worker->poll, events, SERVER_MAX_EVENTS, -1);
+        if (count < 0)
+        {
+            if (errno != EINTR)
+            {
+                fprintf(stderr, "epoll_wait: %s\n", strerror(errno));
+            }
+            continue;
+        }
+
+        for (int i = 0; i < count; i++)
+        {
+            ClientHandle handle = events[i].data.u64;
+
+            if (handle == WAKE_TOKEN)
+            {
+                DrainInbox(worker);
+                continue;
+            }
+
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+            {
+                ReadClient(worker, handle);
+            }
+
+            Client *client = FindClient(worker, handle);
+            if (client != NULL && (events[i].events & EPOLLOUT) && !FlushClient(worker, client, handle))
+            {
+                CloseClient(worker, handle);
+            }
+        }
+
+        FlushDirty(worker);
+    }
+
+    return NULL;
+}
+
+/**
+ * NewMessage (static)
+ *
+ * Returns:
+ *  - A zeroed message with room for length bytes of text plus a terminator, or NULL if
+ *    memory runs out.
+ */
+static Message *NewMessage(MessageKind kind, size_t length)
+{
+    Message *message = calloc(1, sizeof(Message) + length + 1);
+
+    if (message != NULL)
+    {
+        message->kind = kind;
+        message->length = length;
+    }
+    return message;
+}
+
+/**
+ * Post (static)
+ *
+ * Append message to target's mailbox; the eventfd is only signalled when the mailbox
+ * was empty (the worker drains everything at once).
+ */
+static void Post(Worker *target, Message *message)
+{
+    pthread_mutex_lock(&target->lock);
+    bool wasEmpty = target->inbox == NULL;
+    if (wasEmpty)
+    {
+        target->inbox = message;
+    }
+    else
+    {
+        target->inboxTail->next = message;
+    }
+    target->inboxTail = message;
+    pthread_mutex_unlock(&target->lock);
+
+    if (wasEmpty)
+    {
+        uint64_t one = 1;
+        ssize_t written = write(target->wake, &one, sizeof one);
+        (void)written; // a full counter is still readable
+    }
+}
+
+/**
+ * DrainInbox (static)
+ *
+ * Take the whole mailbox and handle it in the order it was posted.
+ */
+static void DrainInbox(Worker *worker)
+{
+    uint64_t counter;
+    ssize_t got = read(worker->wake, &counter, sizeof counter);
+    (void)got;
+
+    pthread_mutex_lock(&worker->lock);
+    Message *message = worker->inbox;
+    worker->inbox = NULL;
+    worker->inboxTail = NULL;
+    pthread_mutex_unlock(&worker->lock);
+
+    while (message != NULL)
+    {
+        Message *next = message->next;
+
+        switch (message->kind)
+        {
+        case MESSAGE_ADOPT:
+            AdoptClient(worker, message->fd);
+            break;
+        case MESSAGE_GAME:
+            HandleGameCommand(worker, message->client, message->command, message->game, message->text);
+            break;
+        case MESSAGE_OUTPUT:
+            DeliverOutput(worker, message->client, message->game, message->attach, message->text, message->length);
+            break;
+        }
+
+        free(message);
+        message = next;
+    }
+}
+
+/**
+ * AdoptClient (static)
+ *
+ * Give a new connection a client slot and start reading it (closed if that fails).
+ */
+static void AdoptClient(Worker *worker, int fd)
+{
+    uint32_t slot;
+
+    if (worker->freeClientCount > 0)
+    {
+        slot = worker->freeClients[--worker->freeClientCount];
+    }
+    else
+    {
+        Client *client = calloc(1, sizeof(Client));
+        if (client == NULL || worker->clientCount >= SERVER_MAX_CLIENT_SLOTS ||
+            !Reserve(&worker->clients, &worker->clientCapacity, worker->clientCount + 1, sizeof(Client *)) ||
+            !Reserve(&worker->freeClients, &worker->freeClientCapacity, worker->clientCount + 1, sizeof(uint32_t)))
+        {
+            free(client);
+            close(fd);
+            return;
+        }
+        slot = worker->clientCount++;
+        worker->clients[slot] = client;
+    }
+
+    Client *client = worker->clients[slot];
+    client->fd = fd;
+    client->generation = (client->generation + 1 == 0) ? 1 : client->generation + 1;
+    client->inputLength = 0;
+    client->outputStart = client->outputEnd = 0;
+    client->writing = client->dirty = client->dropping = false;
+    client->gameCount = 0;
+
+    struct epoll_event event = {.events = EPOLLIN, .data.u64 = MAKE_HANDLE(worker->index, slot, client->generation)};
+    if (epoll_ctl(worker->poll, EPOLL_CTL_ADD, fd, &event) != 0)
+    {
+        close(fd);
+        client->fd = -1;
+        worker->freeClients[worker->freeClientCount++] = slot;
+        return;
+    }
+
+    atomic_fetch_add_explicit(&ActiveClients, 1, memory_order_relaxed);
+}
+
+/**
+ * FindClient (static)
+ *
+ * Returns:
+ *  - The worker's client named by handle, or NULL if that connection has closed.
+ */
+static Client *FindClient(Worker *worker, ClientHandle handle)
+{
+    uint32_t slot = HANDLE_SLOT(handle);
+
+    if (HANDLE_WORKER(handle) != worker->index || slot >= worker->clientCount)
+    {
+        return NULL;
+    }
+
+    Client *client = worker->clients[slot];
+    return (client->fd >= 0 && client->generation == HANDLE_GENERATION(handle)) ? client : NULL;
+}
+
+/**
+ * ReadClient (static)
+ *
+ * Read what the client sent and handle every complete line. End of stream or an error
+ * closes the client.
+ */
+static void ReadClient(Worker *worker, ClientHandle handle)
+{
+    Client *client = FindClient(worker, handle);
+    if (client == NULL)
+    {
+        return;
+    }
+
+    ssize_t got = recv(client->fd, client->input + client->inputLength, SERVER_MAX_LINE - client->inputLength, 0);
+    if (got <= 0)
+    {
+        if (got == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+        {
+            CloseClient(worker, handle);
+        }
+        return;
+    }
+    client->inputLength += (size_t)got;
+
+    size_t start = 0;
+    for (size_t i = client->inputLength - (size_t)got; i < client->inputLength; i++)
+    {
+        if (client->input[i] == '\n')
+        {
+            client->input[i] = '\0';
+            if (i > start && client->input[i - 1] == '\r')
+            {
+                client->input[i - 1] = '\0';
+            }
+            HandleLine(worker, handle, client->input + start);
+            start = i + 1;
+        }
+    }
+
+    client->inputLength -= start;
+    memmove(client->input, client->input + start, client->inputLength);
+
+    if (client->inputLength == SERVER_MAX_LINE)
+    {
+        SendFormat(worker, handle, 0, 0, "error - line longer than %d bytes", SERVER_MAX_LINE - 1);
+        client->dropping = true;
+    }
+}
+
+/**
+ * HandleLine (static)
+ *
+ * Run one command line of a client (modified in place). Game commands go to the worker
+ * that owns the game; "new" creates the game on the client's own worker.
+ */
+static void HandleLine(Worker *worker, ClientHandle handle, char *line)
+{
+    static const struct
+    {
+        const char *name;
+        GameCommand command;
+    } GameVerbs[] = {
+        {"join", GAME_JOIN},
+        {"watch", GAME_WATCH},
+        {"move", GAME_MOVE},
+        {"resign", GAME_RESIGN},
+        {"leave", GAME_LEAVE},
+    };
+    char *cursor = line;
+    char *verb = NextToken(&cursor);
+
+    if (verb == NULL)
+    {
+        return;
+    }
+
+    if (strcmp(verb, "new") == 0)
+    {
+        HandleGameCommand(worker, handle, GAME_NEW, 0, cursor);
+        return;
+    }
+    if (strcmp(verb, "ping") == 0)
+    {
+        SendFormat(worker, handle, 0, 0, "pong");
+        return;
+    }
+    if (strcmp(verb, "stats") == 0)
+    {
+        SendFormat(worker, handle, 0, 0, "stats workers %d clients %u games %lu finished %lu moves %lu", WorkerCount,
+                   atomic_load_explicit(&ActiveClients, memory_order_relaxed), atomic_load_explicit(&ActiveGames, memory_order_relaxed),
+                   atomic_load_explicit(&FinishedGames, memory_order_relaxed), atomic_load_explicit(&MovesPlayed, memory_order_relaxed));
+        return;
+    }
+    if (strcmp(verb, "quit") == 0)
+    {
+        Client *client = FindClient(worker, handle);
+        client->dropping = true;
+        if (!client->dirty && Reserve(&worker->dirty, &worker->dirtyCapacity, worker->dirtyCount + 1, sizeof(ClientHandle)))
+        {
+            client->dirty = true;
+            worker->dirty[worker->dirtyCount++] = handle;
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < sizeof GameVerbs / sizeof GameVerbs[0]; i++)
+    {
+        if (strcmp(verb, GameVerbs[i].name) == 0)
+        {
+            char *idText = NextToken(&cursor);
+            unsigned long id;
+
+            if (idText == NULL || !ParseNumber(idText, ULONG_MAX, &id))
+            {
+                SendFormat(worker, handle, 0, 0, "error - usage: %s <game>%s", verb, (GameVerbs[i].command == GAME_MOVE) ? " <move>" : "");
+                return;
+            }
+            RouteGameCommand(worker, handle, GameVerbs[i].command, (GameId)id, cursor);
+            return;
+        }
+    }
+
+    SendFormat(worker, handle, 0, 0, "error - unknown command %s", verb);
+}
+
+/**
+ * RouteGameCommand (static)
+ *
+ * Run a game command on the worker that owns the game: in place when that is this
+ * worker, through the owner's mailbox otherwise. text may be NULL (no argument).
+ */
+static void RouteGameCommand(Worker *worker, ClientHandle client, GameCommand command, GameId id, const char *text)
+{
+    int owner = (GAME_NUMBER(id) != 0) ? (int)((GAME_NUMBER(id) - 1) % (uint32_t)WorkerCount) : 0;
+    size_t length = (text != NULL) ? strlen(text) : 0;
+
+    Message *message = NewMessage(MESSAGE_GAME, length);
+    if (message == NULL)
+    {
+        return;
+    }
+    message->command = command;
+    message->client = client;
+    message->game = id;
+    memcpy(message->text, (text != NULL) ? text : "", length);
+
+    if (owner == worker->index)
+    {
+        HandleGameCommand(worker, client, command, id, message->text);
+        free(message);
+    }
+    else
+    {
+        Post(&Workers[owner], message);
+    }
+}
+
+/**
+ * HandleGameCommand (static)
+ *
+ * Run a command on one of this worker's games (or create one for GAME_NEW). text is
+ * the rest of the command line and may be modified.
+ */
+static void HandleGameCommand(Worker *worker, ClientHandle client, GameCommand command, GameId id, char *text)
+{
+    if (command == GAME_NEW)
+    {
+        CreateGame(worker, client, text);
+        return;
+    }
+
+    ServerGame *game = FindGame(worker, id);
+    if (game == NULL)
+    {
+        if (command != GAME_DISCONNECT)
+        {
+            SendFormat(worker, client, id, 0, "error %llu no such game", (unsigned long long)id);
+        }
+        return;
+    }
+
+    switch (command)
+    {
+    case GAME_JOIN:
+        JoinGame(worker, client, id, game);
+        break;
+    case GAME_WATCH:
+        WatchGame(worker, client, id, game);
+        break;
+    case GAME_MOVE:
+        PlayMove(worker, client, id, game, text);
+        break;
+    case GAME_RESIGN:
+        LeaveGame(worker, client, id, game, true, false);
+        break;
+    case GAME_LEAVE:
+        LeaveGame(worker, client, id, game, false, false);
+        break;
+    case GAME_DISCONNECT:
+        LeaveGame(worker, client, id, game, false, true);
+        break;
+    case GAME_NEW:
+        break;
+    }
+}
+
+/**
+ * CreateGame (static)
+ *
+ * "new [white|black] [fen <FEN>]": a game on this worker with the client in one seat.
+ */
+static void CreateGame(Worker *worker, ClientHandle client, char *text)
+{
+    char *cursor = text;
+    char *token = NextToken(&cursor);
+    Team seat = TEAM_WHITE;
+
+    if (token != NULL && (strcmp(token, "white") == 0 || strcmp(token, "black") == 0))
+    {
+        seat = (token[0] == 'w') ? TEAM_WHITE : TEAM_BLACK;
+        token = NextToken(&cursor);
+    }
+
+    Position start;
+    char fen[MAX_POSITION_FEN_LENGTH];
+    bool standard = token == NULL;
+    if (standard)
+    {
+        PositionFromFEN(&start, STARTING_FEN);
+    }
+    else
+    {
+        size_t length = strlen(cursor);
+        while (length > 0 && isspace((unsigned char)cursor[length - 1]))
+        {
+            length--;
+        }
+        if (strcmp(token, "fen") != 0 || !PositionFromFENSpan(&start, cursor, length))
+        {
+            SendFormat(worker, client, 0, 0, "error - usage: new [white|black] [fen <FEN>]");
+            return;
+        }
+
+        const char *problem = ValidatePosition(&start);
+        MoveList legal;
+        if (problem == NULL && GenerateLegalMoves(&start, &legal) == 0)
+        {
+            problem = "the game is already over";
+        }
+        if (problem != NULL)
+        {
+            SendFormat(worker, client, 0, 0, "error - %s", problem);
+            return;
+        }
+        PositionToFEN(&start, fen, sizeof fen);
+    }
+
+    if (atomic_fetch_add_explicit(&ActiveGames, 1, memory_order_relaxed) >= MaxGames)
+    {
+        atomic_fetch_sub_explicit(&ActiveGames, 1, memory_order_relaxed);
+        SendFormat(worker, client, 0, 0, "error - the server is full (%lu games)", MaxGames);
+        return;
+    }
+
+    ServerGame *game = calloc(1, sizeof(ServerGame));
+    uint32_t slot = (worker->freeGameCount > 0) ? worker->freeGames[worker->freeGameCount - 1] : worker->gameCount;
+    bool ready = game != NULL && (game->keys = InitializeDHA(8)) != NULL && PushDHA(game->keys, start.key) &&
+                 (standard || (game->startFen = malloc(strlen(fen) + 1)) != NULL) &&
+                 (uint64_t)slot * (uint64_t)WorkerCount + (uint64_t)worker->index < UINT32_MAX &&
+                 Reserve(&worker->games, &worker->gameCapacity, slot + 1, sizeof(ServerGame *)) &&
+                 Reserve(&worker->freeGames, &worker->freeGameCapacity, slot + 1, sizeof(uint32_t)) &&
+                 Reserve(&worker->gameGenerations, &worker->gameGenerationCapacity, slot + 1, sizeof(uint32_t));
+    if (!ready)
+    {
+        if (game != NULL)
+        {
+            FreeDHA(game->keys);
+            free(game->startFen);
+            free(game);
+        }
+        atomic_fetch_sub_explicit(&ActiveGames, 1, memory_order_relaxed);
+        SendFormat(worker, client, 0, 0, "error - out of memory");
+        return;
+    }
+
+    // A reused slot gets a new generation, so the ids of its earlier games stay dead
+    if (worker->freeGameCount > 0)
+    {
+        worker->freeGameCount--;
+        worker->gameGenerations[slot]++;
+    }
+    else
+    {
+        worker->gameCount++;
+        worker->gameGenerations[slot] = 0;
+    }
+    worker->games[slot] = game;
+
+    if (!standard)
+    {
+        memcpy(game->startFen, fen, strlen(fen) + 1);
+    }
+    game->position = start;
+    game->seats[seat] = client;
+
+    GameId id = MAKE_GAME_ID(slot * (uint32_t)WorkerCount + (uint32_t)worker->index + 1, worker->gameGenerations[slot]);
+    SendFormat(worker, client, id, +1, "created %llu %s", (unsigned long long)id, TeamNames[seat]);
+    SendSnapshot(worker, client, game, id);
+}
+
+/**
+ * JoinGame (static)
+ *
+ * Seat the client in the free seat; the player already seated is told.
+ */
+static void JoinGame(Worker *worker, ClientHandle client, GameId id, ServerGame *game)
+{
+    Team seat = (game->seats[TEAM_WHITE] == 0) ? TEAM_WHITE : TEAM_BLACK;
+
+    if (game->seats[seat] != 0)
+    {
+        SendFormat(worker, client, id, 0, "error %llu the game is full", (unsigned long long)id);
+        return;
+    }
+
+    ClientHandle opponent = game->seats[1 - seat];
+    game->seats[seat] = client;
+
+    SendFormat(worker, client, id, +1, "joined %llu %s", (unsigned long long)id, TeamNames[seat]);
+    SendSnapshot(worker, client, game, id);
+    if (opponent != client)
+    {
+        SendFormat(worker, opponent, id, 0, "opponent %llu joined", (unsigned long long)id);
+    }
+}
+
+/**
+ * WatchGame (static)
+ *
+ * Add the client to the spectators.
+ */
+static void WatchGame(Worker *worker, ClientHandle client, GameId id, ServerGame *game)
+{
+    bool present = game->seats[TEAM_WHITE] == client || game->seats[TEAM_BLACK] == client;
+
+    for (uint32_t i = 0; i < game->watcherCount && !present; i++)
+    {
+        present = game->watchers[i] == client;
+    }
+    if (present)
+    {
+        SendFormat(worker, client, id, 0, "error %llu already in the game", (unsigned long long)id);
+        return;
+    }
+
+    if (!Reserve(&game->watchers, &game->watcherCapacity, game->watcherCount + 1, sizeof(ClientHandle)))
+    {
+        SendFormat(worker, client, id, 0, "error %llu out of memory", (unsigned long long)id);
+        return;
+    }
+    game->watchers[game->watcherCount++] = client;
+
+    SendFormat(worker, client, id, +1, "watching %llu", (unsigned long long)id);
+    SendSnapshot(worker, client, game, id);
+}
+
+/**
+ * PlayMove (static)
+ *
+ * Check the move of the player to move against the legal moves, play it, send it to
+ * everyone in the game and end the game if the rules say so.
+ */
+static void PlayMove(Worker *worker, ClientHandle client, GameId id, ServerGame *game, char *text)
+{
+    char *cursor = text;
+    char *token = NextToken(&cursor);
+    Position *pos = &game->position;
+
+    if (token == NULL)
+    {
+        SendFormat(worker, client, id, 0, "error %llu usage: move <game> <move>", (unsigned long long)id);
+        return;
+    }
+    if (game->seats[pos->side] != client)
+    {
+        bool seated = game->seats[TEAM_WHITE] == client || game->seats[TEAM_BLACK] == client;
+        SendFormat(worker, client, id, 0, "error %llu %s", (unsigned long long)id, seated ? "not your turn" : "not a player of this game");
+        return;
+    }
+    if (game->seats[1 - pos->side] == 0)
+    {
+        SendFormat(worker, client, id, 0, "error %llu waiting for an opponent", (unsigned long long)id);
+        return;
+    }
+
+    ChessMove move = MoveFromUci(pos, token, strlen(token));
+    if (move == 0)
+    {
+        SendFormat(worker, client, id, 0, "error %llu illegal move %s", (unsigned long long)id, token);
+        return;
+    }
+    if (!Reserve(&game->moves, &game->moveCapacity, game->moveCount + 1, sizeof(ChessMove)))
+    {
+        SendFormat(worker, client, id, 0, "error %llu out of memory", (unsigned long long)id);
+        return;
+    }
+
+    UndoInfo undo;
+    MakeMove(pos, move, &undo);
+    game->moves[game->moveCount++] = move;
+    atomic_fetch_add_explicit(&MovesPlayed, 1, memory_order_relaxed);
+
+    // Older keys can never repeat: dropping them keeps the game compact
+    if (pos->halfMoveClock == 0)
+    {
+        ClearDHA(game->keys);
+    }
+    PushDHA(game->keys, pos->key);
+    bool repeated = IsRepeated3times(game->keys, pos->halfMoveClock);
+
+    char uci[MAX_UCI_MOVE_LENGTH];
+    char line[SERVER_MAX_REPLY];
+    MoveToUci(move, uci);
+    int length = snprintf(line, sizeof line, "move %llu %u %s\n", (unsigned long long)id, game->moveCount, uci);
+    Broadcast(worker, game, id, 0, line, (size_t)length);
+
+    MoveList legal;
+    if (GenerateLegalMoves(pos, &legal) == 0)
+    {
+        bool mate = IsInCheck(pos);
+        EndGame(worker, id, !mate ? "1/2-1/2" : (pos->side == TEAM_WHITE) ? "0-1" : "1-0", mate ? "checkmate" : "stalemate");
+    }
+    else if (repeated)
+    {
+        EndGame(worker, id, "1/2-1/2", "repetition");
+    }
+    else if (pos->halfMoveClock >= 100)
+    {
+        EndGame(worker, id, "1/2-1/2", "fifty-moves");
+    }
+    else if (IsInsufficientMaterial(&pos->bitboards))
+    {
+        EndGame(worker, id, "1/2-1/2", "insufficient-material");
+    }
+    else if (game->moveCount >= SERVER_MAX_PLIES)
+    {
+        EndGame(worker, id, "1/2-1/2", "max-length");
+    }
+}
+
+/**
+ * LeaveGame (static)
+ *
+ * The client stops watching or playing. A player leaving (or resigning) loses once the
+ * opponent is seated; before that the game is abandoned.
+ *
+ * Parameters:
+ *  - resign: "resign" (a spectator cannot); the player stays in the game until it ends.
+ *  - silent: the client has disconnected, nothing is sent to it.
+ */
+static void LeaveGame(Worker *worker, ClientHandle client, GameId id, ServerGame *game, bool resign, bool silent)
+{
+    bool seated[TEAM_COUNT] = {game->seats[TEAM_WHITE] == client, game->seats[TEAM_BLACK] == client};
+
+    if (resign && !seated[TEAM_WHITE] && !seated[TEAM_BLACK])
+    {
+        SendFormat(worker, client, id, 0, "error %llu not a player of this game", (unsigned long long)id);
+        return;
+    }
+
+    for (uint32_t i = 0; i < game->watcherCount; i++)
+    {
+        if (game->watchers[i] == client)
+        {
+            game->watchers[i] = game->watchers[--game->watcherCount];
+            break;
+        }
+    }
+    if (!resign)
+    {
+        for (int team = 0; team < TEAM_COUNT; team++)
+        {
+            if (seated[team])
+            {
+                game->seats[team] = 0;
+            }
+        }
+        if (!silent)
+        {
+            SendFormat(worker, client, id, -1, "left %llu", (unsigned long long)id);
+        }
+    }
+
+    if (!seated[TEAM_WHITE] && !seated[TEAM_BLACK])
+    {
+        return;
+    }
+
+    // One player alone (or in both seats) abandons the game; otherwise the other one wins
+    if (seated[TEAM_WHITE] == seated[TEAM_BLACK] || (game->seats[TEAM_WHITE] == 0 && game->seats[TEAM_BLACK] == 0 && !resign) ||
+        (resign && (game->seats[TEAM_WHITE] == 0 || game->seats[TEAM_BLACK] == 0)))
+    {
+        EndGame(worker, id, "*", "abandoned");
+    }
+    else
+    {
+        EndGame(worker, id, seated[TEAM_WHITE] ? "0-1" : "1-0", resign ? "resignation" : "abandoned");
+    }
+}
+
+/**
+ * EndGame (static)
+ *
+ * Tell everyone in the game the result and free it.
+ */
+static void EndGame(Worker *worker, GameId id, const char *result, const char *reason)
+{
+    ServerGame *game = FindGame(worker, id);
+    char line[SERVER_MAX_REPLY];
+    int length = snprintf(line, sizeof line, "end %llu %s %s\n", (unsigned long long)id, result, reason);
+
+    Broadcast(worker, game, id, -1, line, (size_t)length);
+
+    uint32_t slot = (GAME_NUMBER(id) - 1) / (uint32_t)WorkerCount;
+    worker->games[slot] = NULL;
+    worker->freeGames[worker->freeGameCount++] = slot;
+
+    FreeDHA(game->keys);
+    free(game->moves);
+    free(game->startFen);
+    free(game->watchers);
+    free(game);
+
+    atomic_fetch_sub_explicit(&ActiveGames, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&FinishedGames, 1, memory_order_relaxed);
+}
+
+/**
+ * FindGame (static)
+ *
+ * Returns:
+ *  - This worker's game with the given id, or NULL if there is none (or it has ended, even
+ *    if a newer game has its slot).
+ */
+static ServerGame *FindGame(Worker *worker, GameId id)
+{
+    uint32_t number = GAME_NUMBER(id);
+
+    if (number == 0 || (int)((number - 1) % (uint32_t)WorkerCount) != worker->index)
+    {
+        return NULL;
+    }
+
+    uint32_t slot = (number - 1) / (uint32_t)WorkerCount;
+    return (slot < worker->gameCount && worker->gameGenerations[slot] == GAME_GENERATION(id)) ? worker->games[slot] : NULL;
+}
+
+/**
+ * Broadcast (static)
+ *
+ * Send text to both players (once if one client holds both seats) and every spectator.
+ */
+static void Broadcast(Worker *worker, const ServerGame *game, GameId id, int attach, const char *text, size_t length)
+{
+    if (game->seats[TEAM_WHITE] != 0)
+    {
+        SendText(worker, game->seats[TEAM_WHITE], id, attach, text, length);
+    }
+    if (game->seats[TEAM_BLACK] != 0 && game->seats[TEAM_BLACK] != game->seats[TEAM_WHITE])
+    {
+        SendText(worker, game->seats[TEAM_BLACK], id, attach, text, length);
+    }
+    for (uint32_t i = 0; i < game->watcherCount; i++)
+    {
+        SendText(worker, game->watchers[i], id, attach, text, length);
+    }
+}
+
+/**
+ * SendSnapshot (static)
+ *
+ * Send the "game" line: start position and every move so far.
+ */
+static void SendSnapshot(Worker *worker, ClientHandle client, const ServerGame *game, GameId id)
+{
+    const char *start = (game->startFen != NULL) ? game->startFen : STARTING_FEN;
+    size_t capacity = SERVER_MAX_REPLY + strlen(start) + (size_t)game->moveCount * MAX_UCI_MOVE_LENGTH;
+    char *line = malloc(capacity);
+    if (line == NULL)
+    {
+        SendFormat(worker, client, id, 0, "error %llu out of memory", (unsigned long long)id);
+        return;
+    }
+
+    size_t length = (size_t)snprintf(line, capacity, "game %llu position fen %s moves", (unsigned long long)id, start);
+    for (uint32_t i = 0; i < game->moveCount; i++)
+    {
+        line[length++] = ' ';
+        MoveToUci(game->moves[i], line + length);
+        length += strlen(line + length);
+    }
+    line[length++] = '\n';
+
+    SendText(worker, client, id, 0, line, length);
+    free(line);
+}
+
+/**
+ * SendFormat (static)
+ *
+ * printf-style: send one line (the newline is added) to a client.
+ */
+static void SendFormat(Worker *worker, ClientHandle client, GameId id, int attach, const char *format, ...)
+{
+    char line[SERVER_MAX_REPLY];
+    va_list args;
+
+    va_start(args, format);
+    int length = vsnprintf(line, sizeof line - 1, format, args);
+    va_end(args);
+
+    if (length < 0)
+    {
+        return;
+    }
+    if (length > (int)sizeof line - 2)
+    {
+        length = (int)sizeof line - 2;
+    }
+    line[length++] = '\n';
+    SendText(worker, client, id, attach, line, (size_t)length);
+}
+
+/**
+ * SendText (static)
+ *
+ * Queue bytes for a client: in place when this worker owns it, through the owner's
+ * mailbox otherwise. attach tells the owner the client joined (+1) or left (-1) game id.
+ */
+static void SendText(Worker *worker, ClientHandle client, GameId id, int attach, const char *text, size_t length)
+{
+    int owner = HANDLE_WORKER(client);
+
+    if (owner == worker->index)
+    {
+        DeliverOutput(worker, client, id, attach, text, length);
+        return;
+    }
+
+    Message *message = NewMessage(MESSAGE_OUTPUT, length);
+    if (message == NULL)
+    {
+        return;
+    }
+    message->client = client;
+    message->game = id;
+    message->attach = attach;
+    memcpy(message->text, text, length);
+    Post(&Workers[owner], message);
+}
+
+/**
+ * DeliverOutput (static)
+ *
+ * Append output to one of this worker's clients and update its list of games.
+ *
+ * Behavior:
+ *  - Output for a closed connection is dropped; if it seated or added that connection
+ *    to a game, the game's owner is told it has gone (it closed before hearing of it).
+ *  - Nothing is written yet (FlushDirty does at the end of the round) and a client is
+ *    never closed here: this runs in the middle of game updates.
+ */
+static void DeliverOutput(Worker *worker, ClientHandle handle, GameId id, int attach, const char *text, size_t length)
+{
+    Client *client = FindClient(worker, handle);
+
+    if (client == NULL)
+    {
+        if (attach > 0)
+        {
+            RouteGameCommand(worker, handle, GAME_DISCONNECT, id, NULL);
+        }
+        return;
+    }
+    if (client->dropping)
+    {
+        return;
+    }
+
+    if (attach != 0)
+    {
+        uint32_t i = 0;
+        while (i < client->gameCount && client->games[i] != id)
+        {
+            i++;
+        }
+
+        if (attach < 0 && i < client->gameCount)
+        {
+            client->games[i] = client->games[--client->gameCount];
+        }
+        else if (attach > 0 && i == client->gameCount)
+        {
+            if (!Reserve(&client->games, &client->gameCapacity, client->gameCount + 1, sizeof(GameId)))
+            {
+                // The client could not be told about the game later: drop it
+                client->dropping = true;
+                RouteGameCommand(worker, handle, GAME_DISCONNECT, id, NULL);
+            }
+            else
+            {
+                client->games[client->gameCount++] = id;
+            }
+        }
+    }
+
+    size_t pending = client->outputEnd - client->outputStart;
+    if (!client->dropping && pending + length > SERVER_MAX_PENDING_OUTPUT)
+    {
+        client->dropping = true;
+    }
+    if (!client->dropping)
+    {
+        if (client->outputEnd + length > client->outputCapacity)
+        {
+            // Move the unsent bytes to the front first; grow only if that is not enough
+            memmove(client->output, client->output + client->outputStart, pending);
+            client->outputStart = 0;
+            client->outputEnd = pending;
+        }
+        if (client->outputEnd + length > client->outputCapacity)
+        {
+            size_t capacity = (client->outputCapacity > 0) ? client->outputCapacity : SERVER_MAX_REPLY;
+            while (capacity < client->outputEnd + length)
+            {
+                capacity *= 2;
+            }
+
+            char *output = realloc(client->output, capacity);
+            if (output == NULL)
+            {
+                client->dropping = true;
+            }
+            else
+            {
+                client->output = output;
+                client->outputCapacity = capacity;
+            }
+        }
+    }
+    if (!client->dropping)
+    {
+        memcpy(client->output + client->outputEnd, text, length);
+        client->outputEnd += length;
+    }
+
+    if (!client->dirty && Reserve(&worker->dirty, &worker->dirtyCapacity, worker->dirtyCount + 1, sizeof(ClientHandle)))
+    {
+        client->dirty = true;
+        worker->dirty[worker->dirtyCount++] = handle;
+    }
+}
+
+/**
+ * FlushClient (static)
+ *
+ * Write as much pending output as the socket takes; EPOLLOUT is armed while some is left.
+ *
+ * Returns:
+ *  - false if the connection failed or is being dropped and everything has been sent
+ *    (the caller closes it).
+ */
+static bool FlushClient(Worker *worker, Client *client, ClientHandle handle)
+{
+    while (client->outputStart < client->outputEnd)
+    {
+        ssize_t sent = send(client->fd, client->output + client->outputStart, client->outputEnd - client->outputStart, MSG_NOSIGNAL);
+        if (sent > 0)
+        {
+            client->outputStart += (size_t)sent;
+        }
+        else if (sent < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            break;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    bool drained = client->outputStart == client->outputEnd;
+    if (drained)
+    {
+        client->outputStart = client->outputEnd = 0;
+    }
+    if (drained == client->writing)
+    {
+        struct epoll_event event = {.events = drained ? EPOLLIN : (EPOLLIN | EPOLLOUT), .data.u64 = handle};
+        epoll_ctl(worker->poll, EPOLL_CTL_MOD, client->fd, &event);
+        client->writing = !drained;
+    }
+
+    return !(drained && client->dropping);
+}
+
+/**
+ * FlushDirty (static)
+ *
+ * Write the output queued this round and close the clients being dropped. Closing can
+ * end games and queue more output, which is handled in the same pass.
+ */
+static void FlushDirty(Worker *worker)
+{
+    for (uint32_t i = 0; i < worker->dirtyCount; i++)
+    {
+        ClientHandle handle = worker->dirty[i];
+        Client *client = FindClient(worker, handle);
+
+        if (client == NULL)
+        {
+            continue;
+        }
+        client->dirty = false;
+
+        // A dropped client gets its pending output if the socket takes it at once
+        if (!FlushClient(worker, client, handle) || client->dropping)
+        {
+            CloseClient(worker, handle);
+        }
+    }
+    worker->dirtyCount = 0;
+}
+
+/**
+ * CloseClient (static)
+ *
+ * Close a connection and free its slot; every game it was in hears it has gone.
+ */
+static void CloseClient(Worker *worker, ClientHandle handle)
+{
+    Client *client = FindClient(worker, handle);
+    if (client == NULL)
+    {
+        return;
+    }
+
+    // Retire the handle first so output the games produce for it below is dropped
+    GameId *games = client->games;
+    uint32_t gameCount = client->gameCount;
+    client->games = NULL;
+    client->gameCount = client->gameCapacity = 0;
+    close(client->fd);
+    client->fd = -1;
+    free(client->output);
+    client->output = NULL;
+    client->outputCapacity = 0;
+    worker->freeClients[worker->freeClientCount++] = HANDLE_SLOT(handle);
+    atomic_fetch_sub_explicit(&ActiveClients, 1, memory_order_relaxed);
+
+    for (uint32_t i = 0; i < gameCount; i++)
+    {
+        RouteGameCommand(worker, handle, GAME_DISCONNECT, games[i], NULL);
+    }
+    free(games);
+}
+
+/**
+ * Reserve (static)
+ *
+ * Grow the array *array (pointer to the array pointer) so it holds at least needed
+ * elements, doubling its capacity. Free lists are reserved as large as the table they
+ * serve, so pushing a freed slot never allocates.
+ *
+ * Returns:
+ *  - false if memory runs out (the array is left as it was).
+ */
+static bool Reserve(void *array, uint32_t *capacity, uint32_t needed, size_t elementSize)
+{
+    void **pointer = array;
+
+    if (needed <= *capacity && *pointer != NULL)
+    {
+        return true;
+    }
+
+    uint32_t grown = (*capacity > 0) ? *capacity : 8;
+    while (grown < needed)
+    {
+        grown *= 2;
+    }
+
+    void *resized = realloc(*pointer, (size_t)grown * elementSize);
+    if (resized == NULL)
+    {
+        return false;
+    }
+    *pointer = resized;
+    *capacity = grown;
+    return true;
+}
+
+/**
+ * ParseNumber (static)
+ *
+ * Parse a whole decimal number in 1..max.
+ */
+static bool ParseNumber(const char *text, unsigned long max, unsigned long *value)
+{
+    char *end = NULL;
+
+    if (!isdigit((unsigned char)text[0]))
+    {
+        return false;
+    }
+
+    errno = 0;
+    unsigned long parsed = strtoul(text, &end, 10);
+    if (errno != 0 || *end != '\0' || parsed < 1 || parsed > max)
+    {
+        return false;
+    }
+
+    *value = parsed;
+    return true;
+}
+
+/**
+ * NextToken (static)
+ *
+ * Split the next whitespace-separated token off *cursor, in place.
+ *
+ * Returns:
+ *  - The token (terminated), or NULL when the line is used up.
+ */
+static char *NextToken(char **cursor)
+{
+    char *start = *cursor;
+
+    while (*start == ' ' || *start == '\t')
+    {
+        start++;
+    }
+    if (*start == '\0')
+    {
+        *cursor = start;
+        return NULL;
+    }
+
+    char *end = start;
+    while (*end != '\0' && *end != ' ' && *end != '\t')
+    {
+        end++;
+    }
+
+    *cursor = (*end != '\0') ? end + 1 : end;
+    *end = '\0';
+    return start;
+}
+
+/**
+ * PrintUsage (static)
+ */
+static void PrintUsage(const char *program)
+{
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  --address ADDR   IPv4 address to listen on (default %s)\n"
+            "  --port N         TCP port (default %d)\n"
+            "  --workers N      event-loop threads (default: one per core)\n"
+            "  --max-games N    games in progress at once (default %d)\n",
+            program, SERVER_DEFAULT_ADDRESS, SERVER_DEFAULT_PORT, SERVER_DEFAULT_MAX_GAMES);
+}
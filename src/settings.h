@@ -30,7 +30,6 @@ enum settings
      CELL_BORDER_THICKNESS_COEFFICIENT = 15, // the bigger the number the smaller the thickness
      MAX_PIECE_NAME_BUFFER_SIZE = 63,        // the whole path counts not just the file name
      MAX_FEN_BUFFER_SIZE = 127,
-     MAX_HALF_FULL_MOVE_DIGITS = 10,
      HIGHLIGHT_COLOR_AMOUNT = 30,              // the bigger the number the more the highlight effect is visible
      MAX_VALID_COLOR = 255,                    // don't change this it's not customizable this is how colors work
      VALID_MOVE_CIRCLE_SQUARE_COEFFICIENT = 3, // the bigger the number the smaller the circle
@@ -42,7 +41,7 @@ enum settings
      SPACE_BETWEEN_DEBUG_LINES = 2,
      SPACE_BETWEEN_DEBUG_SECTIONS = 5,
      DEBUG_INFO_WINDOW_WIDTH = 300,
-     DEBUG_INFO_WINDOW_HEIGHT = 470,
+     DEBUG_INFO_WINDOW_HEIGHT = 625,
 
      /* Status bar settings */
      STATUS_MENU_FONT_SIZE = 30,
@@ -50,6 +49,12 @@ enum settings
 
      UI_FONT = 20,
 
+     /* Analysis hints (eval bar and best-move arrow) */
+     EVAL_BAR_WIDTH_COEFFICIENT = 5,     // the bigger the number the thinner the bar
+     EVAL_BAR_SCALE_CP = 400,            // centipawn lead at which about three quarters of the bar are filled
+     EVAL_BAR_FONT_SIZE = 10,
+     ANALYSIS_ARROW_THICKNESS_COEFFICIENT = 6, // the bigger the number the thinner the arrow
+
      // --- MOVE.C SETTINGS (Game Logic) ---
 
      /* Castling Ranks (0-7) */
@@ -69,6 +74,29 @@ enum settings
      CASTLE_KS_ROOK_COL = 5, // f-file
      CASTLE_QS_ROOK_COL = 3, // d-file
 
+     // --- OPPONENT.C SETTINGS (Engine opponent) ---
+     ENGINE_MOVE_TIME_MS = 1000, // thinking time per engine move
+     ENGINE_TT_MEGABYTES = 32,   // transposition table size
+     ENGINE_THREADS = 0,         // search threads; 0: one per core, minus one for the render loop
+
+     // --- ANALYSIS.C SETTINGS (Background analysis) ---
+     ANALYSIS_TT_MEGABYTES = 32, // transposition table of the analysis engine
+     ANALYSIS_THREADS = 0,       // search threads; 0: half of the cores (at least one)
+     ANALYSIS_MAX_DEPTH = 30,    // analysis of a position ends here instead of keeping the CPU busy
+
+     // --- PROFILE.C SETTINGS (Hot-path profiler, PROFILE builds only) ---
+     PROFILE_WINDOW_FRAMES = 240,  // frames the debug overlay's min/avg/p99 are computed over
+     PROFILE_OVERLAY_WIDTH = 560,  // drawn right of the debug info window
+     PROFILE_NAME_COLUMN = 230,    // width of the zone name column
+     PROFILE_VALUE_COLUMN = 80,    // width of each min/avg/p99/calls column
+
+     // --- SAVES.C SETTINGS (Saves index and I/O thread) ---
+     MAX_SAVE_FILE_SIZE = 4096,  // larger files in saves/ are listed but not read
+     SAVES_REFRESH_SECONDS = 2,  // the open Load popup checks saves/ for changes this often
+     SAVES_ROW_HEIGHT = 40,      // one row of the Load popup's saves list
+     SAVES_THUMBNAIL_SIZE = 32,  // board preview of a row (a multiple of BOARD_SIZE)
+     SAVES_SCROLLBAR_WIDTH = 10,
+
      // --- MAIN.C SETTINGS (Application & UI) ---
 
      /* Window defaults */
@@ -80,6 +108,8 @@ enum settings
      /* Memory allocation defaults */
      INITIAL_DYNAMIC_HASH_ARRAY_SIZE = 32,
      INITAL_UNDO_REDO_STACK_SIZE = 32,
+     INITIAL_HISTORY_SNAPSHOTS = 8,
+     HISTORY_SNAPSHOT_INTERVAL = 16, // JumpToPly replays at most this many plies minus one
      MAX_FILE_NAME_LENGTH = 64,
 
      /* Popup UI Dimensions */
@@ -91,7 +121,8 @@ enum settings
      POPUP_WRONG_FEN_HEIGHT = 100,
      POPUP_LOAD_WIDTH = 300,
      POPUP_LOAD_HEIGHT = 320,
-     MAX_LOAD_FILES_TOTAL_LENGTH = 4096,
+     MAX_LISTED_DATABASE_GAMES = 100,
+     DATABASE_LIST_ROW_LENGTH = 64,
      POPUP_FEN_WIDTH = 300,
      POPUP_FEN_HEIGHT = 125,
      POPUP_GAMEOVER_WIDTH = 300,
@@ -104,6 +135,24 @@ enum settings
 
 #define FADE_CONSTANT 0.75f
 
+/* Directory of the Save and Load popups (<name>.fen and <name>.pgn files) */
+#define SAVES_DIRECTORY "saves"
+
+/* Decoded assets (icon, piece atlas, sounds) written by the assetpack tool at build time, mapped at startup */
+#define ASSET_PACK_PATH "assets/assets.pack"
+
+/* Game database browsed by the Load popup (built with the pgndb tool), opened at startup if present */
+#define GAME_DATABASE_PATH "saves/games.cdb"
+
+/* Polyglot opening book used by the engine and the book-move overlay, opened at startup if present */
+#define OPENING_BOOK_PATH "assets/book.bin"
+
+/* Syzygy tablebase directories (':'-separated) probed by the engine and the GUI; tables are optional */
+#define TABLEBASE_PATH "assets/syzygy"
+
+/* Per-frame samples written by the profiler while CSV recording is on (F6, PROFILE builds only) */
+#define PROFILE_CSV_PATH "profile.csv"
+
 /* Standard Chess Starting Position (FEN) */
 #define STARTING_FEN "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
 
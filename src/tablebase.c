@@ -0,0 +1,1794 @@
+/**
+ * tablebase.c
+ *
+ * Responsibilities:
+ * - List the Syzygy tables of the tablebase path (SetTablebasePath), map each file the
+ *   first time its material is probed, and answer probes from the WDL and DTZ tables
+ *   (ProbeTablebase, ProbeTablebaseRoot).
+ *
+ * Syzygy conventions (differences from the rest of the core):
+ * - Squares count from a1 (0) to h8 (63), so a Syzygy square is our square ^ 56.
+ * - Piece codes: pawn 1, knight 2, bishop 3, rook 4, queen 5, king 6; Black adds 8.
+ * - A table is named after its material, stronger side first ("KRPvKR"). The side named
+ *   first is the table's White: a position with that material on Black's side is probed
+ *   with the colors swapped and the rows mirrored (square ^ 56).
+ * - WDL values 0..4 are loss, blessed loss, draw, cursed win and win for the side to
+ *   move. A WDL file stores both sides to move (one side when the material is the same
+ *   on both sides), a DTZ file only one: the other side is answered by a one-ply search.
+ * - DTZ values count moves or plies (per-table flags) to the next zeroing move, through
+ *   an optional value map per outcome.
+ *
+ * File layout (little-endian, after the 4-byte magic):
+ * - One header byte (bit 0: tables for both sides to move, bit 1: pawns), then per file
+ *   of the leading pawn (a-d, or a only without pawns): the group order nibbles and one
+ *   byte per piece (the piece codes of side 0 and side 1 in the low and high nibble).
+ * - Per table (file, side): its sizes and Huffman code (SetSizes); the DTZ value maps;
+ *   then the sparse indexes, the block lengths and, 64-byte aligned, the blocks.
+ *
+ * Implementation Details:
+ * - A position is turned into an index (ProbeTableValue): pieces are reordered into the
+ *   groups the table lists (leading pieces or pawns, then runs of equal pieces), the board
+ *   is mirrored until the leading piece stands in the a1-d1-d4 triangle (or the leading
+ *   pawn on files a-d), and each group's squares are ranked as a combination (Binomial)
+ *   of the squares the groups before it left free.
+ * - Values are Huffman-coded symbols that each expand into a run of values (recursive
+ *   pairing), in blocks of blockSize bytes. A sparse index gives the block of every
+ *   span-th value, and the block lengths lead from there to the block of the index.
+ * - The tables store "don't care" values where a capture decides the outcome (and DTZ
+ *   where a pawn move does), so every probe first plays the captures recursively
+ *   (SearchZeroing) and keeps the better of their results and the stored value.
+ * - Files are mapped under TableLock and published with a release store of their state,
+ *   so a probe of a mapped table takes no lock.
+ */
+
+#include "tablebase.h"
+#include "bitboard.h"
+#include "movegen.h"
+#include "piece.h"
+#include "position.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* First four bytes of a WDL and of a DTZ file */
+static const uint8_t WDL_MAGIC[4] = {0x71, 0xE8, 0x23, 0x5D};
+static const uint8_t DTZ_MAGIC[4] = {0xD7, 0x66, 0x0C, 0xA5};
+
+#define WDL_SUFFIX ".rtbw"
+#define DTZ_SUFFIX ".rtbz"
+
+/* Longest table name: every piece letter and the 'v' */
+#define MAX_TABLE_NAME_LENGTH (TABLEBASE_MAX_PIECES + 1)
+
+/* Longest file path tried when a table is mapped */
+#define MAX_TABLE_PATH_LENGTH 4096
+
+/* Separator of the directories of a tablebase path */
+#define PATH_SEPARATOR ':'
+
+/* Slots of the material key hash (every table is entered under both of its keys) */
+#define TABLE_SLOTS 8192
+
+/* Per-table flags (first byte of its sizes) */
+#define FLAG_STM 1
+#define FLAG_MAPPED 2
+#define FLAG_WIN_PLIES 4
+#define FLAG_LOSS_PLIES 8
+#define FLAG_WIDE 16
+#define FLAG_SINGLE_VALUE 128
+
+/* Longest Huffman code the decoder's 64-bit buffer can hold after a refill */
+#define MAX_SYMBOL_LENGTH 32
+
+/* Right symbol of a leaf of the pairing tree */
+#define LEAF_SYMBOL 0xFFF
+
+/* Header bits */
+#define HEADER_SPLIT 1
+#define HEADER_PAWNS 2
+
+/* Syzygy piece code of each PieceType (PIECE_NONE has none) */
+static const int SYZYGY_PIECE[PIECE_TYPE_COUNT] = {0, 6, 5, 4, 3, 2, 1};
+#define SYZYGY_BLACK 8
+
+/* Syzygy square of one of ours (a1 = 0) */
+#define SYZYGY_SQUARE(square) ((square) ^ 56)
+
+#define RANK_OF(square) ((square) >> 3)
+#define FILE_OF(square) ((square) & 7)
+
+/* Rank minus file: 0 on the a1-h8 diagonal, negative below it */
+#define OFF_DIAGONAL(square) (RANK_OF(square) - FILE_OF(square))
+
+typedef enum ProbeState
+{
+    PROBE_FAIL,
+    PROBE_OK,
+    PROBE_CHANGE_STM,       /* DTZ is stored for the other side to move */
+    PROBE_ZEROING_BEST_MOVE /* the best move is a capture or pawn move: DTZ is not stored */
+} ProbeState;
+
+typedef enum FileState
+{
+    FILE_UNMAPPED,
+    FILE_READY,
+    FILE_MISSING /* not found or damaged: never retried */
+} FileState;
+
+/**
+ * PairsData
+ *
+ * One compressed table: the values of one side to move and one leading pawn file.
+ *
+ * - flags:           FLAG_* bits.
+ * - minSymLength / maxSymLength: shortest and longest Huffman code in bits (with
+ *                    FLAG_SINGLE_VALUE, minSymLength is the value of every position).
+ * - lowestSym:       per code length, the first symbol of that length (uint16 each).
+ * - base64:          per code length, its first code left-aligned in 64 bits.
+ * - btree:           per symbol, the two symbols it expands into (12 bits each).
+ * - symLength:       per symbol, the number of values it expands into, minus one.
+ * - sparseIndex:     block (uint32) and offset in it (uint16) of value k * span + span / 2.
+ * - blockLength:     per block, the number of values it holds, minus one (uint16).
+ * - pieces:          piece codes in the order the index encodes them.
+ * - groupLength / groupIndex: pieces per group (zero-terminated) and the factor of each
+ *                    group's rank in the index; groupIndex[groups] is the table size.
+ * - mapOffset:       DTZ only: where the value map of each outcome (win, loss, cursed
+ *                    win, blessed loss) starts in the file's value maps.
+ */
+typedef struct PairsData
+{
+    uint8_t flags;
+    uint8_t minSymLength;
+    uint8_t maxSymLength;
+    uint32_t blockCount;
+    size_t blockSize;
+    size_t span;
+    const uint8_t *lowestSym;
+    uint64_t *base64;
+    const uint8_t *btree;
+    uint8_t *symLength;
+    int symbolCount;
+    const uint8_t *sparseIndex;
+    size_t sparseIndexSize;
+    const uint8_t *blockLength;
+    uint32_t blockLengthSize;
+    const uint8_t *data;
+    int pieces[TABLEBASE_MAX_PIECES];
+    int groupLength[TABLEBASE_MAX_PIECES + 1];
+    uint64_t groupIndex[TABLEBASE_MAX_PIECES + 1];
+    size_t mapOffset[4];
+} PairsData;
+
+/**
+ * TableFile
+ *
+ * The WDL or DTZ file of a table: its mapping and its tables per side to move (side 1
+ * only in WDL files of unequal material) and leading pawn file (file 0 only without
+ * pawns).
+ */
+typedef struct TableFile
+{
+    atomic_int state;
+    const uint8_t *map;
+    size_t mapSize;
+    const uint8_t *valueMap;
+    PairsData pairs[TEAM_COUNT][4];
+} TableFile;
+
+/**
+ * TableEntry
+ *
+ * - key / key2:      material key with the side named first as White / as Black.
+ * - pawnCount:       pawns of the leading color (the only side with pawns, else the
+ *                    one with fewer, White on a tie) and of the other color.
+ * - hasUniquePieces: a side has exactly one of some piece other than the king.
+ */
+typedef struct TableEntry
+{
+    uint64_t key;
+    uint64_t key2;
+    char name[MAX_TABLE_NAME_LENGTH + 1];
+    int pieceCount;
+    bool hasPawns;
+    bool hasUniquePieces;
+    int pawnCount[2];
+    TableFile wdl;
+    TableFile dtz;
+} TableEntry;
+
+static TableEntry *Tables;
+static int TableCount;
+static int TableCapacity;
+static int TableSlots[TABLE_SLOTS]; /* index + 1 into Tables, 0 for an empty slot */
+static char *TablePath;
+static int MaxPieces;
+static pthread_mutex_t TableLock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Encoding tables (InitTablebase), in Syzygy squares */
+static int MapB1H1H7[SQUARE_COUNT];
+static int MapA1D1D4[SQUARE_COUNT];
+static int MapKK[10][SQUARE_COUNT];
+static int Binomial[6][SQUARE_COUNT];
+static int MapPawns[SQUARE_COUNT];
+static int LeadPawnIdx[6][SQUARE_COUNT];
+static int LeadPawnsSize[6][4];
+
+static void FreeTables(void);
+static void ScanDirectory(const char *directory);
+static void RegisterTable(const char *name, size_t length);
+static TableEntry *FindTable(uint64_t key);
+static uint64_t PositionMaterialKey(const Bitboards *bb);
+static bool MapTable(TableEntry *entry, bool dtz);
+static bool OpenTableFile(const TableEntry *entry, TableFile *file, bool dtz);
+static bool ParseTableFile(const TableEntry *entry, TableFile *file, bool dtz);
+static void SetGroups(const TableEntry *entry, PairsData *d, const int order[2], int file);
+static const uint8_t *SetSizes(PairsData *d, const uint8_t *data, const uint8_t *end);
+static int SetSymbolLength(PairsData *d, int symbol, bool *visited);
+static const uint8_t *SetDtzMap(TableFile *file, const uint8_t *data, int maxFile);
+static int DecompressPairs(const PairsData *d, uint64_t index);
+static int ProbeTable(const Position *pos, bool dtz, TablebaseWdl wdl, ProbeState *state);
+static int ProbeTableValue(const Position *pos, const TableEntry *entry, uint64_t key, bool dtz, TablebaseWdl wdl, ProbeState *state);
+static int MapDtzValue(const TableFile *file, const PairsData *d, int value, TablebaseWdl wdl);
+static TablebaseWdl SearchZeroing(const Position *pos, bool pawnMoves, ProbeState *state);
+static int ProbeDtz(const Position *pos, ProbeState *state);
+static bool IsProbeable(const Position *pos);
+static bool IsMate(const Position *pos);
+static int MoveOutcome(TablebaseWdl wdl, int dtz, int halfMoveClock);
+
+/* Little-endian and big-endian reads (the files are not aligned for wider loads) */
+static inline uint32_t Read16(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8);
+}
+
+static inline uint32_t Read32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline uint32_t ReadBig32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+static inline int Sign(int value)
+{
+    return (value > 0) - (value < 0);
+}
+
+/**
+ * InitTablebase
+ *
+ * Fill the index tables of the Syzygy encoding.
+ *
+ * - MapB1H1H7: squares below the a1-h8 diagonal, 0..27.
+ * - MapA1D1D4: the a1-d1-d4 triangle, squares below the diagonal first (0..5), then the
+ *   diagonal (6..9).
+ * - MapKK: the 462 placements of two kings, the first in the triangle, not adjacent, the
+ *   second not above the diagonal when the first is on it; both on the diagonal last.
+ * - MapPawns: a2..h7 ranked from the edge files and the low ranks (47) inwards, so the
+ *   leading pawn (the one encoded first) is the one with the highest value and the rest
+ *   have MapPawns[lead] squares to choose from.
+ * - LeadPawnIdx / LeadPawnsSize: start of each leading pawn square's block of indexes
+ *   for 1..5 leading pawns, and the number of indexes per leading pawn file.
+ *
+ * Notes:
+ *  - Called by InitChessCore after InitBitboards (MapKK uses the king attack table).
+ */
+void InitTablebase(void)
+{
+    int code = 0;
+    for (int s = 0; s < SQUARE_COUNT; s++)
+    {
+        if (OFF_DIAGONAL(s) < 0)
+        {
+            MapB1H1H7[s] = code++;
+        }
+    }
+
+    int diagonal[4];
+    int diagonalCount = 0;
+    code = 0;
+    for (int s = 0; s <= 27; s++)
+    {
+        if (OFF_DIAGONAL(s) < 0 && FILE_OF(s) <= 3)
+        {
+            MapA1D1D4[s] = code++;
+        }
+        else if (OFF_DIAGONAL(s) == 0 && FILE_OF(s) <= 3)
+        {
+            diagonal[diagonalCount++] = s;
+        }
+    }
+    for (int i = 0; i < diagonalCount; i++)
+    {
+        MapA1D1D4[diagonal[i]] = code++;
+    }
+
+    int bothOnDiagonal[10 * SQUARE_COUNT][2];
+    int bothCount = 0;
+    code = 0;
+    for (int index = 0; index < 10; index++)
+    {
+        for (int s1 = 0; s1 <= 27; s1++)
+        {
+            // b1 is the triangle square mapped to 0
+            if (MapA1D1D4[s1] != index || (index == 0 && s1 != 1))
+            {
+                continue;
+            }
+            Bitboard near = KingAttackTable[SYZYGY_SQUARE(s1)] | SQUARE_BIT(SYZYGY_SQUARE(s1));
+            for (int s2 = 0; s2 < SQUARE_COUNT; s2++)
+            {
+                if (near & SQUARE_BIT(SYZYGY_SQUARE(s2)))
+                {
+                    continue;
+                }
+                if (OFF_DIAGONAL(s1) == 0 && OFF_DIAGONAL(s2) > 0)
+                {
+                    continue;
+                }
+                if (OFF_DIAGONAL(s1) == 0 && OFF_DIAGONAL(s2) == 0)
+                {
+                    bothOnDiagonal[bothCount][0] = index;
+                    bothOnDiagonal[bothCount++][1] = s2;
+                }
+                else
+                {
+                    MapKK[index][s2] = code++;
+                }
+            }
+        }
+    }
+    for (int i = 0; i < bothCount; i++)
+    {
+        MapKK[bothOnDiagonal[i][0]][bothOnDiagonal[i][1]] = code++;
+    }
+
+    // Pascal's rule: Binomial[k][n] ways to choose k squares among n
+    memset(Binomial, 0, sizeof Binomial);
+    Binomial[0][0] = 1;
+    for (int n = 1; n < SQUARE_COUNT; n++)
+    {
+        for (int k = 0; k < 6 && k <= n; k++)
+        {
+            Binomial[k][n] = ((k > 0) ? Binomial[k - 1][n - 1] : 0) + ((k < n) ? Binomial[k][n - 1] : 0);
+        }
+    }
+
+    int available = 47;
+    for (int file = 0; file < 4; file++)
+    {
+        for (int rank = 1; rank <= 6; rank++)
+        {
+            int s = rank * 8 + file;
+            MapPawns[s] = available--;
+            MapPawns[s ^ 7] = available--;
+        }
+    }
+    for (int leadPawns = 1; leadPawns <= 5; leadPawns++)
+    {
+        for (int file = 0; file < 4; file++)
+        {
+            int index = 0;
+            for (int rank = 1; rank <= 6; rank++)
+            {
+                int s = rank * 8 + file;
+                LeadPawnIdx[leadPawns][s] = index;
+                index += Binomial[leadPawns - 1][MapPawns[s]];
+            }
+            LeadPawnsSize[leadPawns][file] = index;
+        }
+    }
+}
+
+/**
+ * SetTablebasePath
+ *
+ * Parameters:
+ *  - path: directories holding Syzygy files, separated by ':'; NULL or "" for none.
+ *
+ * Returns:
+ *  - The number of WDL tables found (a table in several directories counts once).
+ *
+ * Behavior:
+ *  - Only the directories are listed: a file is opened the first time its material is
+ *    probed. The DTZ file of a table is looked for in every directory of the path.
+ *  - Tables mapped for the previous path are unmapped, so nothing may probe meanwhile.
+ */
+int SetTablebasePath(const char *path)
+{
+    FreeTables();
+
+    if (path == NULL || *path == '\0')
+    {
+        return 0;
+    }
+
+    size_t length = strlen(path);
+    TablePath = malloc(length + 1);
+    if (TablePath == NULL)
+    {
+        return 0;
+    }
+    memcpy(TablePath, path, length + 1);
+
+    char directory[MAX_TABLE_PATH_LENGTH];
+    for (const char *start = TablePath; *start != '\0';)
+    {
+        const char *end = strchr(start, PATH_SEPARATOR);
+        size_t size = (end != NULL) ? (size_t)(end - start) : strlen(start);
+        if (size > 0 && size < sizeof directory)
+        {
+            memcpy(directory, start, size);
+            directory[size] = '\0';
+            ScanDirectory(directory);
+        }
+        start += size + (end != NULL);
+    }
+
+    return TableCount;
+}
+
+/**
+ * TablebaseMaxPieces
+ */
+int TablebaseMaxPieces(void)
+{
+    return MaxPieces;
+}
+
+/**
+ * ProbeTablebase
+ *
+ * Parameters:
+ *  - pos:    position to probe.
+ *  - result: receives the outcome for pos->side (dtz 0; untouched when false is returned).
+ *
+ * Returns:
+ *  - false if pos has castling rights, not one king per side, more pieces than the
+ *    tables found, or if its table or the table of a position a capture reaches is
+ *    missing or damaged.
+ *
+ * Behavior:
+ *  - The outcome ignores pos->halfMoveClock: a win is a win if the clock starts now.
+ *  - K vs K is a draw without any table.
+ */
+bool ProbeTablebase(const Position *pos, TablebaseResult *result)
+{
+    if (!IsProbeable(pos))
+    {
+        return false;
+    }
+
+    ProbeState state = PROBE_OK;
+    TablebaseWdl wdl = SearchZeroing(pos, false, &state);
+    if (state == PROBE_FAIL)
+    {
+        return false;
+    }
+
+    *result = (TablebaseResult){wdl, 0};
+    return true;
+}
+
+/**
+ * ProbeTablebaseRoot
+ *
+ * Parameters:
+ *  - pos:    position to play from.
+ *  - move:   receives the move to play.
+ *  - result: receives the outcome of pos with move played and its DTZ from pos.
+ *
+ * Returns:
+ *  - false if pos has no legal move or cannot be probed (see ProbeTablebase), or if a
+ *    DTZ file it needs is missing.
+ *
+ * Behavior:
+ *  - Every move is played and its DTZ counted from pos: a capture or pawn move by the
+ *    winner zeroes (1 ply), other moves add one ply to the DTZ of the position reached,
+ *    and a mate is 1.
+ *  - A win or loss whose zeroing move comes after pos->halfMoveClock + DTZ > 100 plies is
+ *    a cursed win or blessed loss: the fifty-move rule draws it first.
+ *  - The move chosen has the best outcome, then among wins the smallest DTZ and among
+ *    losses the largest. Playing the smallest DTZ every move always makes progress: the
+ *    DTZ drops every two plies until a zeroing move starts a new count.
+ */
+bool ProbeTablebaseRoot(const Position *pos, ChessMove *move, TablebaseResult *result)
+{
+    MoveList list;
+    int count;
+
+    if (!IsProbeable(pos) || (count = GenerateLegalMoves(pos, &list)) == 0)
+    {
+        return false;
+    }
+
+    int bestOutcome = 0;
+    int bestDtz = 0;
+    for (int i = 0; i < count; i++)
+    {
+        Position child = *pos;
+        UndoInfo undo;
+        ProbeState state = PROBE_OK;
+        int dtz;
+
+        MakeMove(&child, list.moves[i], &undo);
+        if (child.halfMoveClock == 0)
+        {
+            // A zeroing move: only the outcome it leads to counts
+            TablebaseWdl wdl = (TablebaseWdl)-SearchZeroing(&child, false, &state);
+            dtz = (wdl == TABLEBASE_WIN) ? 1 : (wdl == TABLEBASE_CURSED_WIN) ? 101 : (wdl == TABLEBASE_BLESSED_LOSS) ? -101 : (wdl == TABLEBASE_LOSS) ? -1 : 0;
+        }
+        else
+        {
+            dtz = -ProbeDtz(&child, &state);
+            dtz += Sign(dtz);
+        }
+        if (state == PROBE_FAIL)
+        {
+            return false;
+        }
+        if (dtz == 2 && IsMate(&child))
+        {
+            dtz = 1;
+        }
+
+        int outcome = MoveOutcome((TablebaseWdl)(2 * Sign(dtz)), abs(dtz), pos->halfMoveClock);
+        bool better = (outcome != bestOutcome) ? outcome > bestOutcome : (outcome > 0 && abs(dtz) < bestDtz) || (outcome < 0 && abs(dtz) > bestDtz);
+        if (i == 0 || better)
+        {
+            *move = list.moves[i];
+            bestOutcome = outcome;
+            bestDtz = abs(dtz);
+        }
+    }
+
+    *result = (TablebaseResult){(TablebaseWdl)bestOutcome, (bestOutcome != TABLEBASE_DRAW) ? bestDtz : 0};
+    return true;
+}
+
+/**
+ * FreeTables (static)
+ *
+ * Unmap every file and forget the tables and the path.
+ */
+static void FreeTables(void)
+{
+    for (int i = 0; i < TableCount; i++)
+    {
+        TableFile *files[2] = {&Tables[i].wdl, &Tables[i].dtz};
+        for (int f = 0; f < 2; f++)
+        {
+            if (atomic_load_explicit(&files[f]->state, memory_order_relaxed) != FILE_READY)
+            {
+                continue;
+            }
+            for (int side = 0; side < TEAM_COUNT; side++)
+            {
+                for (int file = 0; file < 4; file++)
+                {
+                    free(files[f]->pairs[side][file].base64);
+                    free(files[f]->pairs[side][file].symLength);
+                }
+            }
+            munmap((void *)files[f]->map, files[f]->mapSize);
+        }
+    }
+
+    free(Tables);
+    free(TablePath);
+    Tables = NULL;
+    TablePath = NULL;
+    TableCount = 0;
+    TableCapacity = 0;
+    MaxPieces = 0;
+    memset(TableSlots, 0, sizeof TableSlots);
+}
+
+/**
+ * ScanDirectory (static)
+ *
+ * Register every WDL file of directory (a missing directory has none).
+ */
+static void ScanDirectory(const char *directory)
+{
+    DIR *dir = opendir(directory);
+    if (dir == NULL)
+    {
+        return;
+    }
+
+    const size_t suffixLength = sizeof WDL_SUFFIX - 1;
+    struct dirent *file;
+    while ((file = readdir(dir)) != NULL)
+    {
+        size_t length = strlen(file->d_name);
+        if (length > suffixLength && strcmp(file->d_name + length - suffixLength, WDL_SUFFIX) == 0)
+        {
+            RegisterTable(file->d_name, length - suffixLength);
+        }
+    }
+
+    closedir(dir);
+}
+
+/**
+ * RegisterTable (static)
+ *
+ * Add the table named by the length characters of name ("KQvKR") unless the name is not
+ * a material signature Syzygy tables exist for or the table is known already.
+ */
+static void RegisterTable(const char *name, size_t length)
+{
+    static const char LETTERS[] = "?KQRBNP"; /* indexed by PieceType */
+    int counts[TEAM_COUNT][PIECE_TYPE_COUNT] = {{0}};
+    int side = 0;
+    int pieceCount = 0;
+
+    if (length > MAX_TABLE_NAME_LENGTH || name[0] != 'K')
+    {
+        return;
+    }
+    for (size_t i = 0; i < length; i++)
+    {
+        if (name[i] == 'v' && side == 0 && i + 1 < length && name[i + 1] == 'K')
+        {
+            side = 1;
+            continue;
+        }
+        const char *letter = (name[i] != '\0' && name[i] != '?') ? strchr(LETTERS, name[i]) : NULL;
+        if (letter == NULL)
+        {
+            return;
+        }
+        counts[side][letter - LETTERS]++;
+        pieceCount++;
+    }
+    if (side == 0 || counts[0][PIECE_KING] != 1 || counts[1][PIECE_KING] != 1 || pieceCount < 3)
+    {
+        return;
+    }
+
+    int swapped[TEAM_COUNT][PIECE_TYPE_COUNT];
+    memcpy(swapped[0], counts[1], sizeof counts[1]);
+    memcpy(swapped[1], counts[0], sizeof counts[0]);
+
+    Bitboards material = {0};
+    uint64_t keys[2];
+    for (int k = 0; k < 2; k++)
+    {
+        for (int team = 0; team < TEAM_COUNT; team++)
+        {
+            for (int type = PIECE_QUEEN; type < PIECE_TYPE_COUNT; type++)
+            {
+                // One bit per piece is enough for the key: only the counts matter
+                int count = (k == 0) ? counts[team][type] : swapped[team][type];
+                material.pieces[team][type] = (count > 0) ? (((Bitboard)1 << count) - 1) : 0;
+            }
+        }
+        keys[k] = PositionMaterialKey(&material);
+    }
+    if (FindTable(keys[0]) != NULL)
+    {
+        return;
+    }
+
+    if (TableCount == TableCapacity)
+    {
+        int capacity = (TableCapacity > 0) ? 2 * TableCapacity : 64;
+        TableEntry *tables = realloc(Tables, sizeof *tables * (size_t)capacity);
+        if (tables == NULL)
+        {
+            return;
+        }
+        Tables = tables;
+        TableCapacity = capacity;
+    }
+
+    TableEntry *entry = &Tables[TableCount];
+    memset(entry, 0, sizeof *entry);
+    atomic_init(&entry->wdl.state, FILE_UNMAPPED);
+    atomic_init(&entry->dtz.state, FILE_UNMAPPED);
+    memcpy(entry->name, name, length);
+    entry->name[length] = '\0';
+    entry->key = keys[0];
+    entry->key2 = keys[1];
+    entry->pieceCount = pieceCount;
+
+    for (int team = 0; team < TEAM_COUNT; team++)
+    {
+        for (int type = PIECE_QUEEN; type < PIECE_TYPE_COUNT; type++)
+        {
+            entry->hasUniquePieces |= counts[team][type] == 1;
+        }
+    }
+    int whitePawns = counts[0][PIECE_PAWN];
+    int blackPawns = counts[1][PIECE_PAWN];
+    bool whiteLeads = blackPawns == 0 || (whitePawns > 0 && blackPawns >= whitePawns);
+    entry->hasPawns = whitePawns + blackPawns > 0;
+    entry->pawnCount[0] = whiteLeads ? whitePawns : blackPawns;
+    entry->pawnCount[1] = whiteLeads ? blackPawns : whitePawns;
+
+    // Entered under both keys: the material may stand either way round on the board
+    for (int k = 0; k < 2; k++)
+    {
+        size_t slot = (size_t)((keys[k] * 0x9E3779B97F4A7C15ULL) >> 51) & (TABLE_SLOTS - 1);
+        while (TableSlots[slot] != 0)
+        {
+            slot = (slot + 1) & (TABLE_SLOTS - 1);
+        }
+        TableSlots[slot] = TableCount + 1;
+        if (keys[1] == keys[0])
+        {
+            break;
+        }
+    }
+
+    TableCount++;
+    if (pieceCount > MaxPieces)
+    {
+        MaxPieces = pieceCount;
+    }
+}
+
+/**
+ * FindTable (static)
+ *
+ * Returns:
+ *  - The table of material key, or NULL if none was found.
+ */
+static TableEntry *FindTable(uint64_t key)
+{
+    if (TableCount == 0)
+    {
+        return NULL;
+    }
+
+    size_t slot = (size_t)((key * 0x9E3779B97F4A7C15ULL) >> 51) & (TABLE_SLOTS - 1);
+    while (TableSlots[slot] != 0)
+    {
+        TableEntry *entry = &Tables[TableSlots[slot] - 1];
+        if (entry->key == key || entry->key2 == key)
+        {
+            return entry;
+        }
+        slot = (slot + 1) & (TABLE_SLOTS - 1);
+    }
+    return NULL;
+}
+
+/**
+ * PositionMaterialKey (static)
+ *
+ * Four bits per piece count (kings excluded), White's then Black's.
+ */
+static uint64_t PositionMaterialKey(const Bitboards *bb)
+{
+    uint64_t key = 0;
+
+    for (int team = 0; team < TEAM_COUNT; team++)
+    {
+        for (int type = PIECE_QUEEN; type < PIECE_TYPE_COUNT; type++)
+        {
+            key |= (uint64_t)BitCount(bb->pieces[team][type]) << (4 * (team * PIECE_TYPE_COUNT + type));
+        }
+    }
+    return key;
+}
+
+/**
+ * MapTable (static)
+ *
+ * Returns:
+ *  - true if the WDL (dtz false) or DTZ file of entry is mapped, mapping it first if
+ *    this is its first probe.
+ */
+static bool MapTable(TableEntry *entry, bool dtz)
+{
+    TableFile *file = dtz ? &entry->dtz : &entry->wdl;
+
+    int state = atomic_load_explicit(&file->state, memory_order_acquire);
+    if (state != FILE_UNMAPPED)
+    {
+        return state == FILE_READY;
+    }
+
+    pthread_mutex_lock(&TableLock);
+    state = atomic_load_explicit(&file->state, memory_order_relaxed);
+    if (state == FILE_UNMAPPED)
+    {
+        state = OpenTableFile(entry, file, dtz) ? FILE_READY : FILE_MISSING;
+        atomic_store_explicit(&file->state, state, memory_order_release);
+    }
+    pthread_mutex_unlock(&TableLock);
+
+    return state == FILE_READY;
+}
+
+/**
+ * OpenTableFile (static)
+ *
+ * Map <directory>/<name>.rtbw (or .rtbz) from the first directory of the path that has
+ * it and parse its tables. Called with TableLock held.
+ *
+ * Returns:
+ *  - false if no directory has the file or it is damaged (size, magic or layout).
+ */
+static bool OpenTableFile(const TableEntry *entry, TableFile *file, bool dtz)
+{
+    char path[MAX_TABLE_PATH_LENGTH];
+
+    for (const char *start = TablePath; start != NULL && *start != '\0';)
+    {
+        const char *end = strchr(start, PATH_SEPARATOR);
+        int size = (end != NULL) ? (int)(end - start) : (int)strlen(start);
+        int length = snprintf(path, sizeof path, "%.*s/%s%s", size, start, entry->name, dtz ? DTZ_SUFFIX : WDL_SUFFIX);
+        start += size + (end != NULL);
+
+        int fd = (size > 0 && length > 0 && (size_t)length < sizeof path) ? open(path, O_RDONLY) : -1;
+        struct stat info;
+        if (fd < 0)
+        {
+            continue;
+        }
+        // The data of every table ends 64-byte aligned, plus a 16-byte checksum
+        if (fstat(fd, &info) != 0 || info.st_size < 64 || info.st_size % 64 != 16)
+        {
+            close(fd);
+            return false;
+        }
+
+        size_t mapSize = (size_t)info.st_size;
+        void *mapping = mmap(NULL, mapSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mapping == MAP_FAILED)
+        {
+            return false;
+        }
+
+        file->map = mapping;
+        file->mapSize = mapSize;
+        if (memcmp(file->map, dtz ? DTZ_MAGIC : WDL_MAGIC, 4) != 0 || !ParseTableFile(entry, file, dtz))
+        {
+            for (int side = 0; side < TEAM_COUNT; side++)
+            {
+                for (int f = 0; f < 4; f++)
+                {
+                    free(file->pairs[side][f].base64);
+                    free(file->pairs[side][f].symLength);
+                }
+            }
+            memset(file->pairs, 0, sizeof file->pairs);
+            munmap(mapping, mapSize);
+            file->map = NULL;
+            return false;
+        }
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * ParseTableFile (static)
+ *
+ * Read the header and locate the tables of a mapped file (see File layout).
+ *
+ * Returns:
+ *  - false if the header does not match the table's material or the tables run past
+ *    the end of the file.
+ */
+static bool ParseTableFile(const TableEntry *entry, TableFile *file, bool dtz)
+{
+    const uint8_t *data = file->map + 4;
+    const uint8_t *end = file->map + file->mapSize;
+    bool split = entry->key != entry->key2;
+
+    if (((*data & HEADER_PAWNS) != 0) != entry->hasPawns || (!dtz && ((*data & HEADER_SPLIT) != 0) != split))
+    {
+        return false;
+    }
+    data++;
+
+    int sides = (!dtz && split) ? 2 : 1;
+    int maxFile = entry->hasPawns ? 3 : 0;
+    bool bothPawns = entry->hasPawns && entry->pawnCount[1] > 0;
+
+    for (int f = 0; f <= maxFile; f++)
+    {
+        if (data + 1 + bothPawns + entry->pieceCount > end)
+        {
+            return false;
+        }
+        int order[2][2] = {{data[0] & 0xF, bothPawns ? (data[1] & 0xF) : 0xF}, {data[0] >> 4, bothPawns ? (data[1] >> 4) : 0xF}};
+        data += 1 + bothPawns;
+
+        for (int k = 0; k < entry->pieceCount; k++, data++)
+        {
+            for (int i = 0; i < sides; i++)
+            {
+                file->pairs[i][f].pieces[k] = i ? (*data >> 4) : (*data & 0xF);
+            }
+        }
+
+        for (int i = 0; i < sides; i++)
+        {
+            // The pieces must be the table's material, in whichever order
+            Bitboards material = {0};
+            for (int k = 0; k < entry->pieceCount; k++)
+            {
+                int piece = file->pairs[i][f].pieces[k];
+                int code = piece & 7;
+                if (code < 1 || code > 6)
+                {
+                    return false;
+                }
+                PieceType type = (PieceType)(PIECE_PAWN + 1 - code);
+                Bitboard *pieces = &material.pieces[(piece & SYZYGY_BLACK) ? TEAM_BLACK : TEAM_WHITE][type];
+                *pieces = (*pieces << 1) | 1;
+            }
+            if (PositionMaterialKey(&material) != entry->key)
+            {
+                return false;
+            }
+            SetGroups(entry, &file->pairs[i][f], order[i], f);
+        }
+    }
+    data += (uintptr_t)data & 1;
+
+    for (int f = 0; f <= maxFile; f++)
+    {
+        for (int i = 0; i < sides; i++)
+        {
+            if ((data = SetSizes(&file->pairs[i][f], data, end)) == NULL)
+            {
+                return false;
+            }
+        }
+    }
+
+    if (dtz)
+    {
+        data = SetDtzMap(file, data, maxFile);
+    }
+
+    for (int f = 0; f <= maxFile; f++)
+    {
+        for (int i = 0; i < sides; i++)
+        {
+            file->pairs[i][f].sparseIndex = data;
+            data += file->pairs[i][f].sparseIndexSize * 6;
+        }
+    }
+    for (int f = 0; f <= maxFile; f++)
+    {
+        for (int i = 0; i < sides; i++)
+        {
+            file->pairs[i][f].blockLength = data;
+            data += (size_t)file->pairs[i][f].blockLengthSize * 2;
+        }
+    }
+    for (int f = 0; f <= maxFile; f++)
+    {
+        for (int i = 0; i < sides; i++)
+        {
+            data = (const uint8_t *)(((uintptr_t)data + 0x3F) & ~(uintptr_t)0x3F);
+            file->pairs[i][f].data = data;
+            data += (size_t)file->pairs[i][f].blockCount * file->pairs[i][f].blockSize;
+        }
+    }
+
+    return data <= end;
+}
+
+/**
+ * SetGroups (static)
+ *
+ * Split the pieces of d into groups and work out the factor of each group in the index.
+ *
+ * Behavior:
+ *  - The first group is the leading pawns (all pawns of the leading color) or, without
+ *    pawns, the first three pieces when a piece is unique and the two kings otherwise;
+ *    every further group is a run of equal pieces (KRRvKN: leading, RR, N).
+ *  - order gives the position of the leading group and of the other color's pawns in
+ *    the index (0xF: none); the other groups fill the remaining places in sequence. A
+ *    group is ranked among the squares the groups before it in the piece order left.
+ */
+static void SetGroups(const TableEntry *entry, PairsData *d, const int order[2], int file)
+{
+    int n = 0;
+    int firstLength = entry->hasPawns ? 0 : entry->hasUniquePieces ? 3 : 2;
+
+    d->groupLength[n] = 1;
+    for (int i = 1; i < entry->pieceCount; i++)
+    {
+        if (--firstLength > 0 || d->pieces[i] == d->pieces[i - 1])
+        {
+            d->groupLength[n]++;
+        }
+        else
+        {
+            d->groupLength[++n] = 1;
+        }
+    }
+    d->groupLength[++n] = 0;
+
+    bool bothPawns = entry->hasPawns && entry->pawnCount[1] > 0;
+    int next = bothPawns ? 2 : 1;
+    int freeSquares = SQUARE_COUNT - d->groupLength[0] - (bothPawns ? d->groupLength[1] : 0);
+    uint64_t index = 1;
+
+    for (int k = 0; next < n || k == order[0] || k == order[1]; k++)
+    {
+        if (k == order[0])
+        {
+            d->groupIndex[0] = index;
+            index *= entry->hasPawns ? (uint64_t)LeadPawnsSize[d->groupLength[0]][file] : entry->hasUniquePieces ? 31332 : 462;
+        }
+        else if (k == order[1])
+        {
+            d->groupIndex[1] = index;
+            index *= (uint64_t)Binomial[d->groupLength[1]][48 - d->groupLength[0]];
+        }
+        else
+        {
+            d->groupIndex[next] = index;
+            index *= (uint64_t)Binomial[d->groupLength[next]][freeSquares];
+            freeSquares -= d->groupLength[next++];
+        }
+    }
+    d->groupIndex[n] = index;
+}
+
+/**
+ * SetSizes (static)
+ *
+ * Read the sizes and the Huffman code of d and build its decoding tables (base64 and
+ * symLength, allocated).
+ *
+ * Returns:
+ *  - The first byte after them, or NULL if they are damaged or memory is short.
+ *
+ * Behavior:
+ *  - Codes are canonical with longer codes numerically lower: the codes of one length are
+ *    consecutive from base64 of that length, and the first code one bit shorter follows
+ *    the last of these shifted right once.
+ */
+static const uint8_t *SetSizes(PairsData *d, const uint8_t *data, const uint8_t *end)
+{
+    if (data + 2 > end)
+    {
+        return NULL;
+    }
+
+    d->flags = *data++;
+    if (d->flags & FLAG_SINGLE_VALUE)
+    {
+        d->minSymLength = *data++;
+        return data;
+    }
+
+    int groups = 0;
+    while (d->groupLength[groups] != 0)
+    {
+        groups++;
+    }
+    uint64_t tableSize = d->groupIndex[groups];
+
+    if (data + 9 > end || data[0] >= 32 || data[1] >= 32)
+    {
+        return NULL;
+    }
+    d->blockSize = (size_t)1 << data[0];
+    d->span = (size_t)1 << data[1];
+    d->sparseIndexSize = (size_t)((tableSize + d->span - 1) / d->span);
+    int padding = data[2];
+    d->blockCount = Read32(data + 3);
+    d->blockLengthSize = d->blockCount + (uint32_t)padding;
+    d->maxSymLength = data[7];
+    d->minSymLength = data[8];
+    data += 9;
+
+    int lengths = d->maxSymLength - d->minSymLength + 1;
+    if (d->minSymLength < 1 || d->maxSymLength > MAX_SYMBOL_LENGTH || lengths < 1 || data + 2 * lengths + 2 > end)
+    {
+        return NULL;
+    }
+    d->lowestSym = data;
+    d->base64 = calloc((size_t)lengths, sizeof *d->base64);
+    if (d->base64 == NULL)
+    {
+        return NULL;
+    }
+    for (int i = lengths - 2; i >= 0; i--)
+    {
+        d->base64[i] = (d->base64[i + 1] + Read16(d->lowestSym + 2 * i) - Read16(d->lowestSym + 2 * (i + 1))) / 2;
+    }
+    for (int i = 0; i < lengths; i++)
+    {
+        d->base64[i] <<= 64 - i - d->minSymLength;
+    }
+    data += 2 * lengths;
+
+    d->symbolCount = (int)Read16(data);
+    data += 2;
+    if (d->symbolCount == 0 || data + 3 * d->symbolCount > end)
+    {
+        return NULL;
+    }
+    d->btree = data;
+    d->symLength = calloc((size_t)d->symbolCount, sizeof *d->symLength);
+    bool *visited = calloc((size_t)d->symbolCount, sizeof *visited);
+    if (d->symLength == NULL || visited == NULL)
+    {
+        free(visited);
+        return NULL;
+    }
+    for (int symbol = 0; symbol < d->symbolCount; symbol++)
+    {
+        if (!visited[symbol])
+        {
+            d->symLength[symbol] = (uint8_t)SetSymbolLength(d, symbol, visited);
+        }
+    }
+    free(visited);
+
+    return data + 3 * d->symbolCount + (d->symbolCount & 1);
+}
+
+/**
+ * SetSymbolLength (static)
+ *
+ * Returns:
+ *  - The number of values symbol expands into, minus one, after setting it for the
+ *    symbols it pairs. Symbols out of range count as leaves; a damaged tree with a cycle
+ *    reads 0 for the symbol being set, which DecompressPairs rejects.
+ */
+static int SetSymbolLength(PairsData *d, int symbol, bool *visited)
+{
+    const uint8_t *lr = d->btree + 3 * symbol;
+    int right = (lr[2] << 4) | (lr[1] >> 4);
+
+    visited[symbol] = true;
+    if (right == LEAF_SYMBOL)
+    {
+        return 0;
+    }
+
+    int left = ((lr[1] & 0xF) << 8) | lr[0];
+    if (left >= d->symbolCount || right >= d->symbolCount)
+    {
+        return 0;
+    }
+    if (!visited[left])
+    {
+        d->symLength[left] = (uint8_t)SetSymbolLength(d, left, visited);
+    }
+    if (!visited[right])
+    {
+        d->symLength[right] = (uint8_t)SetSymbolLength(d, right, visited);
+    }
+    return d->symLength[left] + d->symLength[right] + 1;
+}
+
+/**
+ * SetDtzMap (static)
+ *
+ * Locate the value maps of a DTZ file: for each table with FLAG_MAPPED, four maps (win,
+ * loss, cursed win, blessed loss), each a count followed by that many values (bytes, or
+ * uint16 with FLAG_WIDE).
+ *
+ * Returns:
+ *  - The first byte after the maps.
+ */
+static const uint8_t *SetDtzMap(TableFile *file, const uint8_t *data, int maxFile)
+{
+    file->valueMap = data;
+
+    for (int f = 0; f <= maxFile; f++)
+    {
+        PairsData *d = &file->pairs[0][f];
+        if (!(d->flags & FLAG_MAPPED))
+        {
+            continue;
+        }
+        if (d->flags & FLAG_WIDE)
+        {
+            data += (uintptr_t)data & 1;
+            for (int i = 0; i < 4; i++)
+            {
+                d->mapOffset[i] = (size_t)(data - file->valueMap) + 2;
+                data += 2 * Read16(data) + 2;
+            }
+        }
+        else
+        {
+            for (int i = 0; i < 4; i++)
+            {
+                d->mapOffset[i] = (size_t)(data - file->valueMap) + 1;
+                data += *data + 1;
+            }
+        }
+    }
+
+    return data + ((uintptr_t)data & 1);
+}
+
+/**
+ * DecompressPairs (static)
+ *
+ * Returns:
+ *  - The stored value of index in d, or -1 if the table is damaged there.
+ *
+ * Behavior:
+ *  - The sparse index entry of index's span gives a block and the offset of the span's
+ *    middle value in it; the block lengths move that to the block of index. The block's
+ *    codes are read (big-endian bit stream) until the symbol covering the offset, which
+ *    is then expanded down its pairing tree to the single value.
+ */
+static int DecompressPairs(const PairsData *d, uint64_t index)
+{
+    if (d->flags & FLAG_SINGLE_VALUE)
+    {
+        return d->minSymLength;
+    }
+
+    size_t k = (size_t)(index / d->span);
+    if (k >= d->sparseIndexSize)
+    {
+        return -1;
+    }
+    uint32_t block = Read32(d->sparseIndex + 6 * k);
+    long offset = (long)Read16(d->sparseIndex + 6 * k + 4);
+    offset += (long)(index % d->span) - (long)(d->span / 2);
+
+    while (offset < 0)
+    {
+        if (block == 0)
+        {
+            return -1;
+        }
+        offset += (long)Read16(d->blockLength + 2 * --block) + 1;
+    }
+    while (block < d->blockLengthSize && offset > (long)Read16(d->blockLength + 2 * block))
+    {
+        offset -= (long)Read16(d->blockLength + 2 * block++) + 1;
+    }
+    if (block >= d->blockCount)
+    {
+        return -1;
+    }
+
+    const uint8_t *ptr = d->data + (size_t)block * d->blockSize;
+    const uint8_t *blockEnd = ptr + d->blockSize;
+    uint64_t buffer = ((uint64_t)ReadBig32(ptr) << 32) | ReadBig32(ptr + 4);
+    int bufferBits = 64;
+    int symbol;
+    ptr += 8;
+
+    for (;;)
+    {
+        int length = 0;
+        while (buffer < d->base64[length])
+        {
+            length++;
+        }
+        symbol = (int)((buffer - d->base64[length]) >> (64 - length - d->minSymLength));
+        symbol += (int)Read16(d->lowestSym + 2 * length);
+        if (symbol >= d->symbolCount)
+        {
+            return -1;
+        }
+        if (offset < (long)d->symLength[symbol] + 1)
+        {
+            break;
+        }
+
+        offset -= (long)d->symLength[symbol] + 1;
+        length += d->minSymLength;
+        buffer <<= length;
+        bufferBits -= length;
+        if (bufferBits <= 32)
+        {
+            // A symbol never crosses the end of its block: past it, only a damaged block reads
+            bufferBits += 32;
+            if (ptr < blockEnd)
+            {
+                buffer |= (uint64_t)ReadBig32(ptr) << (64 - bufferBits);
+                ptr += 4;
+            }
+        }
+    }
+
+    // Paired symbols are adjacent runs: the left one covers the first symLength + 1 values
+    while (d->symLength[symbol] != 0)
+    {
+        const uint8_t *lr = d->btree + 3 * symbol;
+        int left = ((lr[1] & 0xF) << 8) | lr[0];
+        int next = left;
+        if (offset >= (long)d->symLength[left] + 1)
+        {
+            offset -= (long)d->symLength[left] + 1;
+            next = (lr[2] << 4) | (lr[1] >> 4);
+        }
+        // Each pair expands into more values than either half (a damaged tree may not)
+        if (next >= d->symbolCount || d->symLength[next] >= d->symLength[symbol])
+        {
+            return -1;
+        }
+        symbol = next;
+    }
+
+    const uint8_t *lr = d->btree + 3 * symbol;
+    return ((lr[1] & 0xF) << 8) | lr[0];
+}
+
+/**
+ * ProbeTable (static)
+ *
+ * Returns:
+ *  - The stored WDL outcome (dtz false) or DTZ of pos, without looking at captures; 0
+ *    for K vs K. Sets *state to PROBE_FAIL if the table is missing and PROBE_CHANGE_STM
+ *    if the DTZ file only has the other side to move.
+ */
+static int ProbeTable(const Position *pos, bool dtz, TablebaseWdl wdl, ProbeState *state)
+{
+    const Bitboards *bb = &pos->bitboards;
+
+    if (BitCount(bb->occupied) == 2)
+    {
+        return 0;
+    }
+
+    uint64_t key = PositionMaterialKey(bb);
+    TableEntry *entry = FindTable(key);
+    if (entry == NULL || !MapTable(entry, dtz))
+    {
+        *state = PROBE_FAIL;
+        return 0;
+    }
+
+    return ProbeTableValue(pos, entry, key, dtz, wdl, state);
+}
+
+/**
+ * ProbeTableValue (static)
+ *
+ * Encode pos as an index of its table (see Implementation Details) and read the value.
+ *
+ * Parameters:
+ *  - key: material key of pos.
+ *  - wdl: outcome of pos (DTZ only: selects the value map and the unit).
+ */
+static int ProbeTableValue(const Position *pos, const TableEntry *entry, uint64_t key, bool dtz, TablebaseWdl wdl, ProbeState *state)
+{
+    const Bitboards *bb = &pos->bitboards;
+    const TableFile *file = dtz ? &entry->dtz : &entry->wdl;
+    int squares[TABLEBASE_MAX_PIECES];
+    int pieces[TABLEBASE_MAX_PIECES];
+    int size = 0;
+    int leadPawnCount = 0;
+    int tbFile = 0;
+    Bitboard leadPawns = 0;
+    uint64_t index;
+
+    // The table's White is the side named first; a symmetric table only has White to move
+    bool flip = (entry->key == entry->key2 && pos->side == TEAM_BLACK) || key != entry->key;
+    int flipColor = flip ? SYZYGY_BLACK : 0;
+    int flipSquares = flip ? 56 : 0;
+    int stm = flip ^ (pos->side == TEAM_BLACK);
+
+    if (entry->hasPawns)
+    {
+        Team leadTeam = ((file->pairs[0][0].pieces[0] ^ flipColor) & SYZYGY_BLACK) ? TEAM_BLACK : TEAM_WHITE;
+        leadPawns = bb->pieces[leadTeam][PIECE_PAWN];
+        for (Bitboard b = leadPawns; b != 0;)
+        {
+            squares[size++] = SYZYGY_SQUARE(PopLowestSquare(&b)) ^ flipSquares;
+        }
+        leadPawnCount = size;
+
+        // The leading pawn is the one nearest the edge, then on the lowest rank
+        int lead = 0;
+        for (int i = 1; i < leadPawnCount; i++)
+        {
+            if (MapPawns[squares[i]] > MapPawns[squares[lead]])
+            {
+                lead = i;
+            }
+        }
+        int swap = squares[0];
+        squares[0] = squares[lead];
+        squares[lead] = swap;
+        tbFile = (FILE_OF(squares[0]) < 4) ? FILE_OF(squares[0]) : 7 - FILE_OF(squares[0]);
+    }
+
+    if (dtz && (file->pairs[0][tbFile].flags & FLAG_STM) != stm && !(entry->key == entry->key2 && !entry->hasPawns))
+    {
+        *state = PROBE_CHANGE_STM;
+        return 0;
+    }
+
+    for (int team = 0; team < TEAM_COUNT; team++)
+    {
+        for (int type = PIECE_KING; type < PIECE_TYPE_COUNT; type++)
+        {
+            for (Bitboard b = bb->pieces[team][type] & ~leadPawns; b != 0;)
+            {
+                squares[size] = SYZYGY_SQUARE(PopLowestSquare(&b)) ^ flipSquares;
+                pieces[size++] = (SYZYGY_PIECE[type] + ((team == TEAM_BLACK) ? SYZYGY_BLACK : 0)) ^ flipColor;
+            }
+        }
+    }
+
+    const PairsData *d = &file->pairs[dtz ? 0 : stm][tbFile];
+
+    // Same piece sequence as the table
+    for (int i = leadPawnCount; i < size - 1; i++)
+    {
+        for (int j = i + 1; j < size; j++)
+        {
+            if (d->pieces[i] == pieces[j])
+            {
+                int swap = pieces[i];
+                pieces[i] = pieces[j];
+                pieces[j] = swap;
+                swap = squares[i];
+                squares[i] = squares[j];
+                squares[j] = swap;
+                break;
+            }
+        }
+    }
+
+    // Leading piece to files a-d
+    if (FILE_OF(squares[0]) > 3)
+    {
+        for (int i = 0; i < size; i++)
+        {
+            squares[i] ^= 7;
+        }
+    }
+
+    if (entry->hasPawns)
+    {
+        index = (uint64_t)LeadPawnIdx[leadPawnCount][squares[0]];
+
+        // The other leading pawns in ascending MapPawns order
+        for (int i = 2; i < leadPawnCount; i++)
+        {
+            for (int j = i; j > 1 && MapPawns[squares[j - 1]] > MapPawns[squares[j]]; j--)
+            {
+                int swap = squares[j];
+                squares[j] = squares[j - 1];
+                squares[j - 1] = swap;
+            }
+        }
+        for (int i = 1; i < leadPawnCount; i++)
+        {
+            index += (uint64_t)Binomial[i][MapPawns[squares[i]]];
+        }
+    }
+    else
+    {
+        // Leading piece to ranks 1-4, then the first of its group off the diagonal below it
+        if (RANK_OF(squares[0]) > 3)
+        {
+            for (int i = 0; i < size; i++)
+            {
+                squares[i] ^= 56;
+            }
+        }
+        for (int i = 0; i < d->groupLength[0]; i++)
+        {
+            if (OFF_DIAGONAL(squares[i]) == 0)
+            {
+                continue;
+            }
+            if (OFF_DIAGONAL(squares[i]) > 0)
+            {
+                for (int j = i; j < size; j++)
+                {
+                    squares[j] = ((squares[j] >> 3) | (squares[j] << 3)) & 63;
+                }
+            }
+            break;
+        }
+
+        if (entry->hasUniquePieces)
+        {
+            int adjust1 = squares[1] > squares[0];
+            int adjust2 = (squares[2] > squares[0]) + (squares[2] > squares[1]);
+
+            if (OFF_DIAGONAL(squares[0]) != 0)
+            {
+                index = ((uint64_t)MapA1D1D4[squares[0]] * 63 + (uint64_t)(squares[1] - adjust1)) * 62 + (uint64_t)(squares[2] - adjust2);
+            }
+            else if (OFF_DIAGONAL(squares[1]) != 0)
+            {
+                index = (uint64_t)(6 * 63 + RANK_OF(squares[0]) * 28 + MapB1H1H7[squares[1]]) * 62 + (uint64_t)(squares[2] - adjust2);
+            }
+            else if (OFF_DIAGONAL(squares[2]) != 0)
+            {
+                index = (uint64_t)(6 * 63 * 62 + 4 * 28 * 62 + RANK_OF(squares[0]) * 7 * 28 + (RANK_OF(squares[1]) - adjust1) * 28 + MapB1H1H7[squares[2]]);
+            }
+            else
+            {
+                index = (uint64_t)(6 * 63 * 62 + 4 * 28 * 62 + 4 * 7 * 28 + RANK_OF(squares[0]) * 7 * 6 + (RANK_OF(squares[1]) - adjust1) * 6 + (RANK_OF(squares[2]) - adjust2));
+            }
+        }
+        else
+        {
+            index = (uint64_t)MapKK[MapA1D1D4[squares[0]]][squares[1]];
+        }
+    }
+
+    // The other groups, each as a combination of the squares the earlier groups left
+    index *= d->groupIndex[0];
+    int *groupSquares = squares + d->groupLength[0];
+    bool remainingPawns = entry->hasPawns && entry->pawnCount[1] > 0;
+    for (int next = 1; d->groupLength[next] != 0; next++)
+    {
+        int length = d->groupLength[next];
+        for (int i = 1; i < length; i++)
+        {
+            for (int j = i; j > 0 && groupSquares[j - 1] > groupSquares[j]; j--)
+            {
+                int swap = groupSquares[j];
+                groupSquares[j] = groupSquares[j - 1];
+                groupSquares[j - 1] = swap;
+            }
+        }
+
+        uint64_t n = 0;
+        for (int i = 0; i < length; i++)
+        {
+            int adjust = 0;
+            for (const int *s = squares; s < groupSquares; s++)
+            {
+                adjust += groupSquares[i] > *s;
+            }
+            n += (uint64_t)Binomial[i + 1][groupSquares[i] - adjust - (remainingPawns ? 8 : 0)];
+        }
+
+        remainingPawns = false;
+        index += n * d->groupIndex[next];
+        groupSquares += length;
+    }
+
+    int value = DecompressPairs(d, index);
+    if (value < 0)
+    {
+        *state = PROBE_FAIL;
+        return 0;
+    }
+    return dtz ? MapDtzValue(file, d, value, wdl) : value - 2;
+}
+
+/**
+ * MapDtzValue (static)
+ *
+ * Returns:
+ *  - The DTZ in plies (plus one) of a stored DTZ value of a position with outcome wdl.
+ */
+static int MapDtzValue(const TableFile *file, const PairsData *d, int value, TablebaseWdl wdl)
+{
+    // Value map per outcome: win, loss, cursed win, blessed loss (indexed by wdl + 2)
+    static const int WDL_MAP[5] = {1, 3, 0, 2, 0};
+
+    if (d->flags & FLAG_MAPPED)
+    {
+        size_t offset = d->mapOffset[WDL_MAP[wdl + 2]];
+        value = (d->flags & FLAG_WIDE) ? (int)Read16(file->valueMap + offset + 2 * (size_t)value) : file->valueMap[offset + (size_t)value];
+    }
+
+    // Stored in moves unless the flags say plies; cursed results always in moves
+    if ((wdl == TABLEBASE_WIN && !(d->flags & FLAG_WIN_PLIES)) || (wdl == TABLEBASE_LOSS && !(d->flags & FLAG_LOSS_PLIES)) ||
+        wdl == TABLEBASE_CURSED_WIN || wdl == TABLEBASE_BLESSED_LOSS)
+    {
+        value *= 2;
+    }
+    return value + 1;
+}
+
+/**
+ * SearchZeroing (static)
+ *
+ * WDL outcome of pos: the best of its captures (and with pawnMoves its pawn moves),
+ * searched recursively, and its stored value.
+ *
+ * Behavior:
+ *  - A winning capture ends the search (*state PROBE_ZEROING_BEST_MOVE).
+ *  - When every legal move was searched the stored value is not read: the tables do not
+ *    know en passant, and a position with captures only may store anything.
+ *  - *state is PROBE_ZEROING_BEST_MOVE when the outcome comes from a capture or pawn move
+ *    (so DTZ is not stored for it), PROBE_OK when it comes from the table.
+ */
+static TablebaseWdl SearchZeroing(const Position *pos, bool pawnMoves, ProbeState *state)
+{
+    MoveList list;
+    int total = GenerateLegalMoves(pos, &list);
+    int searched = 0;
+    TablebaseWdl best = TABLEBASE_LOSS;
+
+    for (int i = 0; i < total; i++)
+    {
+        ChessMove move = list.moves[i];
+        bool pawnMove = (pos->bitboards.pieces[pos->side][PIECE_PAWN] & SQUARE_BIT(MOVE_FROM(move))) != 0;
+        if (!MOVE_IS_CAPTURE(move) && (!pawnMoves || !pawnMove))
+        {
+            continue;
+        }
+        searched++;
+
+        Position child = *pos;
+        UndoInfo undo;
+        MakeMove(&child, move, &undo);
+        TablebaseWdl value = (TablebaseWdl)-SearchZeroing(&child, false, state);
+        if (*state == PROBE_FAIL)
+        {
+            return TABLEBASE_DRAW;
+        }
+        if (value > best)
+        {
+            best = value;
+            if (value >= TABLEBASE_WIN)
+            {
+                *state = PROBE_ZEROING_BEST_MOVE;
+                return value;
+            }
+        }
+    }
+
+    bool noMoreMoves = searched > 0 && searched == total;
+    TablebaseWdl value = best;
+    if (!noMoreMoves)
+    {
+        value = (TablebaseWdl)ProbeTable(pos, false, TABLEBASE_DRAW, state);
+        if (*state == PROBE_FAIL)
+        {
+            return TABLEBASE_DRAW;
+        }
+    }
+
+    if (best >= value)
+    {
+        *state = (best > TABLEBASE_DRAW || noMoreMoves) ? PROBE_ZEROING_BEST_MOVE : PROBE_OK;
+        return best;
+    }
+    *state = PROBE_OK;
+    return value;
+}
+
+/**
+ * ProbeDtz (static)
+ *
+ * Returns:
+ *  - The DTZ of pos in plies, positive when the side to move wins and negative when it
+ *    loses (beyond 100 for cursed results), 0 for a draw or a failed probe (*state
+ *    PROBE_FAIL).
+ *
+ * Behavior:
+ *  - A position whose best move zeroes is 1 ply from zeroing (101 when cursed).
+ *  - When the DTZ file only has the other side to move, every move is probed one ply
+ *    deeper: the fastest win, or the slowest loss, plus the move itself.
+ */
+static int ProbeDtz(const Position *pos, ProbeState *state)
+{
+    *state = PROBE_OK;
+    TablebaseWdl wdl = SearchZeroing(pos, true, state);
+    if (*state == PROBE_FAIL || wdl == TABLEBASE_DRAW)
+    {
+        return 0;
+    }
+    if (*state == PROBE_ZEROING_BEST_MOVE)
+    {
+        return (wdl == TABLEBASE_WIN || wdl == TABLEBASE_LOSS) ? Sign(wdl) : 101 * Sign(wdl);
+    }
+
+    int dtz = ProbeTable(pos, true, wdl, state);
+    if (*state == PROBE_FAIL)
+    {
+        return 0;
+    }
+    if (*state != PROBE_CHANGE_STM)
+    {
+        return (dtz + ((wdl == TABLEBASE_CURSED_WIN || wdl == TABLEBASE_BLESSED_LOSS) ? 100 : 0)) * Sign(wdl);
+    }
+
+    MoveList list;
+    int count = GenerateLegalMoves(pos, &list);
+    int minDtz = 0xFFFF;
+    for (int i = 0; i < count; i++)
+    {
+        ChessMove move = list.moves[i];
+        bool zeroing = MOVE_IS_CAPTURE(move) || (pos->bitboards.pieces[pos->side][PIECE_PAWN] & SQUARE_BIT(MOVE_FROM(move))) != 0;
+        Position child = *pos;
+        UndoInfo undo;
+
+        MakeMove(&child, move, &undo);
+        if (zeroing)
+        {
+            // The zeroing move itself is the ply counted: only the sign of its outcome matters
+            TablebaseWdl reply = SearchZeroing(&child, false, state);
+            dtz = (reply == TABLEBASE_WIN || reply == TABLEBASE_LOSS) ? -Sign(reply) : -101 * Sign(reply);
+        }
+        else
+        {
+            dtz = -ProbeDtz(&child, state);
+        }
+        if (*state == PROBE_FAIL)
+        {
+            return 0;
+        }
+
+        if (dtz == 1 && IsMate(&child))
+        {
+            minDtz = 1;
+        }
+        if (!zeroing)
+        {
+            dtz += Sign(dtz);
+        }
+        if (dtz < minDtz && Sign(dtz) == Sign(wdl))
+        {
+            minDtz = dtz;
+        }
+    }
+
+    // No legal move: mated
+    return (minDtz == 0xFFFF) ? -1 : minDtz;
+}
+
+/**
+ * IsProbeable (static)
+ *
+ * Returns:
+ *  - true if pos has one king per side, no castling rights and few enough pieces.
+ */
+static bool IsProbeable(const Position *pos)
+{
+    const Bitboards *bb = &pos->bitboards;
+    int pieceCount = BitCount(bb->occupied);
+
+    return pos->castlingRights == 0 && BitCount(bb->pieces[TEAM_WHITE][PIECE_KING]) == 1 && BitCount(bb->pieces[TEAM_BLACK][PIECE_KING]) == 1 &&
+           (pieceCount <= MaxPieces || pieceCount == 2);
+}
+
+/**
+ * IsMate (static)
+ */
+static bool IsMate(const Position *pos)
+{
+    MoveList list;
+
+    return IsInCheck(pos) && GenerateLegalMoves(pos, &list) == 0;
+}
+
+/**
+ * MoveOutcome (static)
+ *
+ * Returns:
+ *  - wdl (a win, loss or draw) as a TablebaseWdl value with the fifty-move rule applied:
+ *    a win or loss whose zeroing move falls after ply 100 of the clock is cursed or
+ *    blessed.
+ */
+static int MoveOutcome(TablebaseWdl wdl, int dtz, int halfMoveClock)
+{
+    if (wdl == TABLEBASE_DRAW || halfMoveClock + dtz <= 100)
+    {
+        return wdl;
+    }
+    return (wdl > 0) ? TABLEBASE_CURSED_WIN : TABLEBASE_BLESSED_LOSS;
+}
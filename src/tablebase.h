@@ -0,0 +1,75 @@
+/**
+ * tablebase.h
+ *
+ * Responsibilities:
+ * - Export Syzygy endgame tablebase probing: the exact outcome (win, draw or loss for the
+ *   side to move) of positions with few enough pieces from the WDL tables (.rtbw), and
+ *   the move that makes progress from the DTZ tables (.rtbz).
+ *
+ * Notes:
+ * - SetTablebasePath lists the tables of one or more directories; a table file is mapped
+ *   (read-only, shared by every thread) the first time a position of its material is
+ *   probed, and stays mapped until the path changes or the program exits.
+ * - Positions with castling rights are not answered (the tables have none). En passant
+ *   captures are searched before the table is read, so positions with one are answered.
+ * - Probing is thread-safe: the search workers, the analysis thread and the GUI may
+ *   probe at the same time. SetTablebasePath is not: call it while nothing probes.
+ * - This module does not include raylib; it is part of libchesscore (see chesscore.h).
+ */
+
+#ifndef TABLEBASE_H
+#define TABLEBASE_H
+
+#include "movegen.h"
+#include "position.h"
+#include <stdbool.h>
+
+/* Most pieces (kings included) a Syzygy table can hold */
+#define TABLEBASE_MAX_PIECES 7
+
+/**
+ * TablebaseWdl
+ *
+ * Outcome with best play for the side to move, as stored in the WDL tables. A cursed win
+ * is a win the fifty-move rule turns into a draw (the next capture or pawn move is more
+ * than 100 plies away), a blessed loss the loss it saves.
+ */
+typedef enum TablebaseWdl
+{
+    TABLEBASE_LOSS = -2,
+    TABLEBASE_BLESSED_LOSS = -1,
+    TABLEBASE_DRAW = 0,
+    TABLEBASE_CURSED_WIN = 1,
+    TABLEBASE_WIN = 2
+} TablebaseWdl;
+
+/**
+ * TablebaseResult
+ *
+ * - wdl: outcome for the side to move.
+ * - dtz: plies until the winner's next capture, pawn move or mate with best play on
+ *        both sides (the DTZ metric); 0 for a draw and when unknown (ProbeTablebase
+ *        reads the WDL tables only).
+ */
+typedef struct TablebaseResult
+{
+    TablebaseWdl wdl;
+    int dtz;
+} TablebaseResult;
+
+/* Builds the index tables of the Syzygy encoding (called by InitChessCore) */
+void InitTablebase(void);
+
+/* Unmaps the current tables and lists the *.rtbw files of path (directories separated by ':'; NULL or "" for none). Returns the number of tables found */
+int SetTablebasePath(const char *path);
+
+/* Returns the most pieces (kings included) of the tables found, 0 without tables */
+int TablebaseMaxPieces(void);
+
+/* Writes the WDL outcome of pos to result (dtz 0). Returns false if pos has castling rights, too many pieces or no table for its material or a capture's */
+bool ProbeTablebase(const Position *pos, TablebaseResult *result);
+
+/* Writes the move that keeps the best outcome and makes progress (fastest win, any draw, slowest loss by DTZ) and the outcome of pos, with the fifty-move rule applied from pos->halfMoveClock. Returns false if pos has no legal move or a table (DTZ included) is missing */
+bool ProbeTablebaseRoot(const Position *pos, ChessMove *move, TablebaseResult *result);
+
+#endif /* TABLEBASE_H */
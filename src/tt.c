@@ -0,0 +1,193 @@
+/**
+ * tt.c
+ *
+ * Responsibilities:
+ * - Allocate and maintain the transposition table.
+ *
+ * Implementation Details:
+ * - One entry per slot. A store replaces the slot when it holds the same position, an
+ *   entry from an older search, or a shallower result; otherwise the deeper result of
+ *   the current search is kept.
+ * - When a store for the same position carries no move, the previous best move is kept
+ *   so move ordering still gets a hint.
+ * - Lock-free sharing ("XOR trick"): a slot stores data and key ^ data as two relaxed
+ *   atomic words. Two threads storing into the same slot at once can leave one thread's
+ *   data next to the other's check word; the probe recomputes check ^ data, which then
+ *   no longer equals the probed key, so a torn slot is never returned. Relaxed ordering
+ *   is enough because each word is read and written whole and the pair is verified.
+ * - Packed data layout (bits): move 0-15, score 16-31, depth 32-39, bound 40-47,
+ *   age 48-55.
+ */
+
+#include "tt.h"
+#include "movegen.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Local prototypes
+static uint64_t PackEntry(ChessMove move, int score, int depth, TTBound bound, uint8_t age);
+static TTEntry UnpackEntry(uint64_t key, uint64_t data);
+
+/**
+ * InitializeTT
+ *
+ * Parameters:
+ *  - tt:        table to set up (any previous allocation is not freed).
+ *  - megabytes: size budget in MiB.
+ *
+ * Returns:
+ *  - true on success; false if the allocation failed (tt is then empty).
+ */
+bool InitializeTT(TranspositionTable *tt, size_t megabytes)
+{
+    size_t budget = megabytes * 1024 * 1024;
+    size_t count = 1;
+
+    while (count * 2 * sizeof(TTSlot) <= budget)
+    {
+        count *= 2;
+    }
+
+    // All-zero bytes are a valid empty slot (bound TT_BOUND_NONE)
+    tt->slots = calloc(count, sizeof(TTSlot));
+    tt->mask = 0;
+    tt->age = 0;
+
+    if (tt->slots == NULL)
+    {
+        return false;
+    }
+
+    tt->mask = count - 1;
+    return true;
+}
+
+/**
+ * FreeTT
+ */
+void FreeTT(TranspositionTable *tt)
+{
+    free(tt->slots);
+    tt->slots = NULL;
+    tt->mask = 0;
+}
+
+/**
+ * ClearTT
+ */
+void ClearTT(TranspositionTable *tt)
+{
+    if (tt->slots != NULL)
+    {
+        memset(tt->slots, 0, (tt->mask + 1) * sizeof(TTSlot));
+    }
+    tt->age = 0;
+}
+
+/**
+ * AgeTT
+ */
+void AgeTT(TranspositionTable *tt)
+{
+    tt->age++;
+}
+
+/**
+ * ProbeTT
+ *
+ * Returns:
+ *  - true and fills *entry if the slot of key holds that exact key and both of its words
+ *    come from the same store.
+ */
+bool ProbeTT(const TranspositionTable *tt, uint64_t key, TTEntry *entry)
+{
+    if (tt->slots == NULL)
+    {
+        return false;
+    }
+
+    TTSlot *slot = &tt->slots[key & tt->mask];
+    uint64_t data = atomic_load_explicit(&slot->data, memory_order_relaxed);
+    uint64_t check = atomic_load_explicit(&slot->check, memory_order_relaxed);
+
+    if ((check ^ data) != key)
+    {
+        return false;
+    }
+
+    *entry = UnpackEntry(key, data);
+    return entry->bound != TT_BOUND_NONE;
+}
+
+/**
+ * StoreTT
+ *
+ * Parameters:
+ *  - score: already adjusted by the caller for mate distance (see search.c).
+ *  - depth: remaining depth of the search that produced score.
+ *
+ * Notes:
+ *  - The replacement decision reads the slot without verifying it; a torn read only
+ *    makes it keep or replace an entry it otherwise would not have, never corrupts it.
+ */
+void StoreTT(TranspositionTable *tt, uint64_t key, ChessMove move, int score, int depth, TTBound bound)
+{
+    if (tt->slots == NULL)
+    {
+        return;
+    }
+
+    TTSlot *slot = &tt->slots[key & tt->mask];
+    uint64_t oldData = atomic_load_explicit(&slot->data, memory_order_relaxed);
+    uint64_t oldCheck = atomic_load_explicit(&slot->check, memory_order_relaxed);
+    TTEntry old = UnpackEntry(oldCheck ^ oldData, oldData);
+    bool samePosition = (old.key == key);
+
+    if (!samePosition && old.age == tt->age && old.depth > depth)
+    {
+        return;
+    }
+
+    if (samePosition && move == 0)
+    {
+        move = old.move;
+    }
+
+    uint64_t data = PackEntry(move, score, depth, bound, tt->age);
+    atomic_store_explicit(&slot->data, data, memory_order_relaxed);
+    atomic_store_explicit(&slot->check, key ^ data, memory_order_relaxed);
+}
+
+/**
+ * PackEntry (static)
+ *
+ * Fields into the data word (layout in the header comment).
+ */
+static uint64_t PackEntry(ChessMove move, int score, int depth, TTBound bound, uint8_t age)
+{
+    return (uint64_t)move |
+           ((uint64_t)(uint16_t)(int16_t)score << 16) |
+           ((uint64_t)(uint8_t)(int8_t)depth << 32) |
+           ((uint64_t)(uint8_t)bound << 40) |
+           ((uint64_t)age << 48);
+}
+
+/**
+ * UnpackEntry (static)
+ */
+static TTEntry UnpackEntry(uint64_t key, uint64_t data)
+{
+    TTEntry entry;
+
+    entry.key = key;
+    entry.move = (ChessMove)(data & 0xFFFF);
+    entry.score = (int16_t)(uint16_t)((data >> 16) & 0xFFFF);
+    entry.depth = (int8_t)(uint8_t)((data >> 32) & 0xFF);
+    entry.bound = (uint8_t)((data >> 40) & 0xFF);
+    entry.age = (uint8_t)((data >> 48) & 0xFF);
+    return entry;
+}
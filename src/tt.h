@@ -0,0 +1,95 @@
+/**
+ * tt.h
+ *
+ * Responsibilities:
+ * - Define the transposition table: a fixed-size hash table of search results indexed
+ *   by Zobrist key.
+ * - Export functions to size, clear, probe and fill it.
+ *
+ * Notes:
+ * - Slots are 16 bytes; the number of slots is the largest power of two that fits
+ *   in the requested size, so the index is key & mask.
+ * - The table is shared by every search thread without locks: a slot is two 64-bit
+ *   atomic words, the packed entry and the key XOR the packed entry. A probe that reads
+ *   the two halves of different writes does not verify and is treated as a miss.
+ * - Part of libchesscore; this header does not include raylib.
+ */
+
+#ifndef TT_H
+#define TT_H
+
+#include "movegen.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* What an entry's score means relative to the window it was searched with */
+typedef enum
+{
+    TT_BOUND_NONE = 0,
+    TT_BOUND_EXACT, /* score is exact */
+    TT_BOUND_LOWER, /* search failed high: real score >= score */
+    TT_BOUND_UPPER  /* search failed low: real score <= score */
+} TTBound;
+
+/**
+ * TTEntry
+ *
+ * Unpacked view of a slot, as returned by ProbeTT.
+ *
+ * - key:   full Zobrist key (guards against two positions sharing a slot).
+ * - move:  best move found (0 if none).
+ * - score: search score, with mate scores stored relative to the entry's position.
+ * - depth: remaining depth the score was searched to.
+ * - bound: TTBound.
+ * - age:   search generation that wrote the entry (older entries are replaced first).
+ */
+typedef struct TTEntry
+{
+    uint64_t key;
+    ChessMove move;
+    int16_t score;
+    int8_t depth;
+    uint8_t bound;
+    uint8_t age;
+} TTEntry;
+
+/**
+ * TTSlot
+ *
+ * Storage of one entry: data holds move, score, depth, bound and age packed into one
+ * word, check holds key ^ data (see tt.c).
+ */
+typedef struct TTSlot
+{
+    _Atomic uint64_t check;
+    _Atomic uint64_t data;
+} TTSlot;
+
+typedef struct TranspositionTable
+{
+    TTSlot *slots;
+    size_t mask; /* slot count - 1 */
+    uint8_t age; /* only changed between searches, while no thread probes */
+} TranspositionTable;
+
+/* Allocates a table of at most megabytes MiB (at least one entry). Returns false on allocation failure */
+bool InitializeTT(TranspositionTable *tt, size_t megabytes);
+
+/* Frees the entries */
+void FreeTT(TranspositionTable *tt);
+
+/* Empties every entry (e.g. for a new game). Not thread-safe: call between searches */
+void ClearTT(TranspositionTable *tt);
+
+/* Starts a new search generation so entries from earlier searches are replaced first */
+void AgeTT(TranspositionTable *tt);
+
+/* Copies the entry for key into *entry. Returns false if the slot holds another position */
+bool ProbeTT(const TranspositionTable *tt, uint64_t key, TTEntry *entry);
+
+/* Records a search result for key (safe to call from several threads at once) */
+void StoreTT(TranspositionTable *tt, uint64_t key, ChessMove move, int score, int depth, TTBound bound);
+
+#endif /* TT_H */
@@ -0,0 +1,821 @@
+/**
+ * uci.c
+ *
+ * Responsibilities:
+ * - chess-uci: the search engine behind the UCI protocol over standard input/output, so
+ *   UCI GUIs and tooling can use it as a persistent engine process (no window, no audio;
+ *   built on libchesscore only).
+ *
+ * Supported commands:
+ *   uci, isready, ucinewgame, quit
+ *   setoption name Hash value MB | name Threads value N | name Ponder value true/false
+ *             | name Clear Hash | name EvalFile value <path>|<empty>
+ *             | name SyzygyPath value <dir>[:<dir>...]|<empty>
+ *   position startpos | fen <FEN> [moves <move>...]
+ *   go [depth N] [nodes N] [movetime MS] [wtime MS] [btime MS] [winc MS] [binc MS]
+ *      [movestogo N] [infinite] [ponder]
+ *   stop, ponderhit
+ *
+ * Notes:
+ * - Positions are parsed by the same core routine as the GUI's ReadFEN
+ *   (PositionFromFENSpan); moves are UCI long algebraic (e2e4, e7e8q, castling as the
+ *   king's move e1g1) and must be legal: the first bad move is reported with
+ *   "info string" and the position stops before it.
+ * - With a clock, a move gets the remaining time divided by movestogo (default
+ *   UCI_MOVES_TO_GO) plus the increment, at most half the remaining time, minus
+ *   UCI_MOVE_OVERHEAD_MS for the GUI's own latency.
+ * - EvalFile loads an NNUE network (nnue.h) and the search evaluates with it; "<empty>"
+ *   (the default) goes back to the built-in piece-square evaluation.
+ * - SyzygyPath lists the Syzygy tablebases (tablebase.h) the search probes; "<empty>" (the
+ *   default) probes none.
+ * - "go infinite" and "go ponder" never send bestmove on their own: the search result is
+ *   held until "stop" (or, for ponder, "ponderhit", which starts the move's clock).
+ *
+ * Implementation Details:
+ * - The main thread reads commands; "go" starts one search thread that prints info
+ *   lines from the iteration callback and the bestmove at the end. Every search gets a
+ *   fresh stop flag (SearchLimits.stop), raised by "stop", by a command that needs the
+ *   engine idle (position, setoption, ucinewgame, go, quit) and, after a ponderhit, by a
+ *   timer thread once the move's time is up.
+ * - Output lines are written whole under one mutex, so info lines of the search thread
+ *   and replies of the main thread never interleave.
+ */
+
+// pthread_condattr_setclock and CLOCK_MONOTONIC are POSIX, not C17
+#define _POSIX_C_SOURCE 200809L
+
+#include "chesscore.h"
+#include "movegen.h"
+#include "nnue.h"
+#include "pgn.h"
+#include "position.h"
+#include "search.h"
+#include "settings.h"
+#include <ctype.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define UCI_ENGINE_NAME "Raylib Chess"
+#define UCI_ENGINE_AUTHOR "the Raylib Chess authors"
+
+/* With a clock and no movestogo, the remaining time is shared among this many moves */
+#define UCI_MOVES_TO_GO 30
+
+/* Time kept back from every clock budget for the GUI and the pipe */
+#define UCI_MOVE_OVERHEAD_MS 30
+
+/* Longest command line read (a position with a long game is one line) */
+#define UCI_MAX_LINE (64 * 1024)
+
+/* Longest output line (an info line with the whole PV) */
+#define UCI_MAX_OUTPUT 1024
+
+#define UCI_MAX_HASH_MB 65536
+
+static Engine UciEngine;
+static int HashMegabytes = DEFAULT_TT_MEGABYTES;
+static NnueNetwork *Network = NULL; /* EvalFile, NULL when unset */
+
+// Position set by the last "position": the root and the keys of the positions before it
+// since the last irreversible move (at most MAX_REPETITION_WINDOW, oldest first)
+static Position Root;
+static uint64_t RootHistory[MAX_REPETITION_WINDOW];
+static int RootHistoryCount = 0;
+
+// Search thread; SearchRunning, the limits and PonderBudgetMs belong to the main thread
+static pthread_t SearchThread;
+static bool SearchRunning = false;
+static SearchLimits Limits;
+static int64_t PonderBudgetMs = 0;
+static atomic_bool StopFlag;
+
+// Shared with the search and timer threads, under Lock (Wake is broadcast on every change)
+static pthread_mutex_t Lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t Wake; /* waits time out on CLOCK_MONOTONIC (main) */
+static bool Pondering = false;      /* go ponder, no ponderhit yet */
+static bool Infinite = false;       /* go infinite */
+static bool SearchFinished = false; /* Search returned (bestmove may be held) */
+static bool TimerCancelled = false;
+static struct timespec TimerDeadline; /* CLOCK_MONOTONIC */
+
+static pthread_t TimerThread;
+static bool TimerRunning = false;
+
+static pthread_mutex_t OutputLock = PTHREAD_MUTEX_INITIALIZER;
+
+// Local prototypes
+static void Send(const char *format, ...);
+static bool HandleCommand(char *line);
+static void HandleUci(void);
+static void HandleSetOption(char *args);
+static void HandlePosition(char *args);
+static void HandleGo(char *args);
+static void HandlePonderHit(void);
+static void StopAndWait(void);
+static void StartTimer(int64_t ms);
+static void *SearchThreadMain(void *arg);
+static void *TimerMain(void *arg);
+static void PrintInfo(const SearchResult *result, void *userData);
+static bool ParseInteger(const char *text, long long min, long long max, long long *value);
+static bool NamesEqual(const char *a, const char *b);
+static char *NextToken(char **cursor);
+
+int main(void)
+{
+    static char line[UCI_MAX_LINE];
+
+    InitChessCore();
+
+    // The timer's deadline must not move when the system time is set
+    pthread_condattr_t wakeAttributes;
+    pthread_condattr_init(&wakeAttributes);
+    pthread_condattr_setclock(&wakeAttributes, CLOCK_MONOTONIC);
+    pthread_cond_init(&Wake, &wakeAttributes);
+    pthread_condattr_destroy(&wakeAttributes);
+
+    if (!InitializeEngine(&UciEngine, (size_t)HashMegabytes))
+    {
+        fprintf(stderr, "Failed to allocate the transposition table\n");
+        return 1;
+    }
+    PositionFromFEN(&Root, STARTING_FEN);
+    SetSearchCallback(&UciEngine, PrintInfo, NULL);
+
+    while (fgets(line, sizeof line, stdin) != NULL)
+    {
+        line[strcspn(line, "\r\n")] = '\0';
+
+        if (!HandleCommand(line))
+        {
+            break;
+        }
+    }
+
+    // End of input counts as quit
+    StopAndWait();
+    FreeEngine(&UciEngine);
+    FreeNnue(Network);
+    return 0;
+}
+
+/**
+ * Send (static)
+ *
+ * printf-style: write one line (the newline is added) and flush it, atomically with
+ * respect to the other threads.
+ */
+static void Send(const char *format, ...)
+{
+    char buffer[UCI_MAX_OUTPUT];
+    va_list args;
+
+    va_start(args, format);
+    vsnprintf(buffer, sizeof buffer, format, args);
+    va_end(args);
+
+    pthread_mutex_lock(&OutputLock);
+    fputs(buffer, stdout);
+    fputc('\n', stdout);
+    fflush(stdout);
+    pthread_mutex_unlock(&OutputLock);
+}
+
+/**
+ * HandleCommand (static)
+ *
+ * Dispatch one input line. Unknown commands are ignored, as the protocol asks.
+ *
+ * Returns:
+ *  - false for "quit".
+ */
+static bool HandleCommand(char *line)
+{
+    char *cursor = line;
+    char *command = NextToken(&cursor);
+
+    if (command == NULL)
+    {
+        return true;
+    }
+
+    if (strcmp(command, "quit") == 0)
+    {
+        return false;
+    }
+    else if (strcmp(command, "uci") == 0)
+    {
+        HandleUci();
+    }
+    else if (strcmp(command, "isready") == 0)
+    {
+        Send("readyok");
+    }
+    else if (strcmp(command, "ucinewgame") == 0)
+    {
+        StopAndWait();
+        ResetEngine(&UciEngine);
+        PositionFromFEN(&Root, STARTING_FEN);
+        RootHistoryCount = 0;
+    }
+    else if (strcmp(command, "setoption") == 0)
+    {
+        HandleSetOption(cursor);
+    }
+    else if (strcmp(command, "position") == 0)
+    {
+        HandlePosition(cursor);
+    }
+    else if (strcmp(command, "go") == 0)
+    {
+        HandleGo(cursor);
+    }
+    else if (strcmp(command, "stop") == 0)
+    {
+        StopAndWait();
+    }
+    else if (strcmp(command, "ponderhit") == 0)
+    {
+        HandlePonderHit();
+    }
+
+    return true;
+}
+
+/**
+ * HandleUci (static)
+ *
+ * Identify the engine and list its options.
+ */
+static void HandleUci(void)
+{
+    Send("id name %s", UCI_ENGINE_NAME);
+    Send("id author %s", UCI_ENGINE_AUTHOR);
+    Send("option name Hash type spin default %d min 1 max %d", DEFAULT_TT_MEGABYTES, UCI_MAX_HASH_MB);
+    Send("option name Threads type spin default 1 min 1 max %d", MAX_SEARCH_THREADS);
+    Send("option name Ponder type check default false");
+    Send("option name Clear Hash type button");
+    Send("option name EvalFile type string default <empty>");
+    Send("option name SyzygyPath type string default <empty>");
+    Send("uciok");
+}
+
+/**
+ * HandleSetOption (static)
+ *
+ * "name <id> [value <x>]"; option names are case-insensitive and may contain spaces.
+ *
+ * Behavior:
+ *  - A new Hash size or thread count rebuilds the table or the pool (what was learned is
+ *    lost); a failed allocation keeps the previous one and is reported.
+ *  - EvalFile loads the network before replacing the current one, so a file that does
+ *    not load is reported and changes nothing.
+ *  - SyzygyPath replaces the tablebases once the search has stopped (nothing probes).
+ *  - Ponder only tells the engine the GUI may send "go ponder"; nothing to do.
+ */
+static void HandleSetOption(char *args)
+{
+    char name[64] = "";
+    char *value = NULL;
+    char *token = NextToken(&args);
+
+    if (token == NULL || strcmp(token, "name") != 0)
+    {
+        return;
+    }
+
+    while ((token = NextToken(&args)) != NULL && strcmp(token, "value") != 0)
+    {
+        size_t length = strlen(name);
+        snprintf(name + length, sizeof name - length, "%s%s", (length > 0) ? " " : "", token);
+    }
+    if (token != NULL)
+    {
+        // The value is the rest of the line: EvalFile paths may contain spaces
+        value = args + strspn(args, " \t");
+        size_t length = strlen(value);
+        while (length > 0 && (value[length - 1] == ' ' || value[length - 1] == '\t'))
+        {
+            value[--length] = '\0';
+        }
+        if (length == 0)
+        {
+            value = NULL;
+        }
+    }
+
+    StopAndWait();
+
+    long long number = 0;
+    if (NamesEqual(name, "Hash") && value != NULL && ParseInteger(value, 1, UCI_MAX_HASH_MB, &number))
+    {
+        if (SetEngineHash(&UciEngine, (size_t)number))
+        {
+            HashMegabytes = (int)number;
+        }
+        else
+        {
+            Send("info string cannot allocate %lld MiB, hash stays %d MiB", number, HashMegabytes);
+        }
+    }
+    else if (NamesEqual(name, "Threads") && value != NULL && ParseInteger(value, 1, MAX_SEARCH_THREADS, &number))
+    {
+        if (!SetEngineThreads(&UciEngine, (int)number))
+        {
+            Send("info string could not start %lld threads, searching with %d", number, UciEngine.threadCount);
+        }
+    }
+    else if (NamesEqual(name, "Clear Hash"))
+    {
+        ResetEngine(&UciEngine);
+    }
+    else if (NamesEqual(name, "EvalFile") && (value == NULL || strcmp(value, "<empty>") == 0))
+    {
+        SetEngineNetwork(&UciEngine, NULL);
+        FreeNnue(Network);
+        Network = NULL;
+    }
+    else if (NamesEqual(name, "EvalFile"))
+    {
+        NnueNetwork *network = LoadNnue(value);
+
+        if (network == NULL)
+        {
+            Send("info string cannot load network %s, evaluation unchanged", value);
+            return;
+        }
+
+        SetEngineNetwork(&UciEngine, network);
+        FreeNnue(Network);
+        Network = network;
+        Send("info string NNUE evaluation using %s (%s kernels)", value, NnueKernelName());
+    }
+    else if (NamesEqual(name, "SyzygyPath"))
+    {
+        bool none = value == NULL || strcmp(value, "<empty>") == 0;
+        int tables = SetTablebasePath(none ? NULL : value);
+        if (!none)
+        {
+            Send("info string found %d tablebases, up to %d pieces", tables, TablebaseMaxPieces());
+        }
+    }
+    else if (!NamesEqual(name, "Ponder"))
+    {
+        Send("info string unknown option or bad value: %s", name);
+    }
+}
+
+/**
+ * HandlePosition (static)
+ *
+ * "startpos | fen <FEN> [moves <move>...]": set Root and its repetition history.
+ *
+ * Behavior:
+ *  - A malformed FEN is reported and the previous position kept.
+ *  - Moves are played with MakeMove; the history restarts at every irreversible move and
+ *    keeps the last MAX_REPETITION_WINDOW positions.
+ */
+static void HandlePosition(char *args)
+{
+    char fen[MAX_FEN_BUFFER_SIZE + 1] = "";
+    Position pos;
+    char *token = NextToken(&args);
+
+    StopAndWait();
+
+    if (token != NULL && strcmp(token, "startpos") == 0)
+    {
+        PositionFromFEN(&pos, STARTING_FEN);
+        token = NextToken(&args);
+    }
+    else if (token != NULL && strcmp(token, "fen") == 0)
+    {
+        while ((token = NextToken(&args)) != NULL && strcmp(token, "moves") != 0)
+        {
+            size_t length = strlen(fen);
+            snprintf(fen + length, sizeof fen - length, "%s%s", (length > 0) ? " " : "", token);
+        }
+
+        if (!PositionFromFENSpan(&pos, fen, strlen(fen)))
+        {
+            Send("info string invalid fen: %s", fen);
+            return;
+        }
+    }
+    else
+    {
+        return;
+    }
+
+    Root = pos;
+    RootHistoryCount = 0;
+
+    if (token == NULL || strcmp(token, "moves") != 0)
+    {
+        return;
+    }
+
+    while ((token = NextToken(&args)) != NULL)
+    {
+        ChessMove move = MoveFromUci(&Root, token, strlen(token));
+        UndoInfo undo;
+
+        if (move == 0)
+        {
+            Send("info string illegal move %s, position set before it", token);
+            return;
+        }
+
+        if (RootHistoryCount == MAX_REPETITION_WINDOW)
+        {
+            memmove(RootHistory, RootHistory + 1, sizeof(uint64_t) * (MAX_REPETITION_WINDOW - 1));
+            RootHistoryCount--;
+        }
+        RootHistory[RootHistoryCount++] = Root.key;
+
+        MakeMove(&Root, move, &undo);
+        if (Root.halfMoveClock == 0)
+        {
+            RootHistoryCount = 0;
+        }
+    }
+}
+
+/**
+ * HandleGo (static)
+ *
+ * Parse the limits and start the search thread on Root.
+ *
+ * Behavior:
+ *  - movetime wins over the clock; depth and nodes apply on top of either.
+ *  - "ponder" searches without a time limit and keeps the clock budget for ponderhit;
+ *    "infinite" ignores every limit.
+ */
+static void HandleGo(char *args)
+{
+    long long depth = 0, nodes = 0, moveTime = 0, movesToGo = 0;
+    long long times[TEAM_COUNT] = {0, 0};
+    long long increments[TEAM_COUNT] = {0, 0};
+    bool infinite = false;
+    bool ponder = false;
+    char *token;
+
+    StopAndWait();
+
+    while ((token = NextToken(&args)) != NULL)
+    {
+        char *value = NULL;
+        long long *target = NULL;
+
+        if (strcmp(token, "infinite") == 0)
+        {
+            infinite = true;
+            continue;
+        }
+        if (strcmp(token, "ponder") == 0)
+        {
+            ponder = true;
+            continue;
+        }
+
+        if (strcmp(token, "depth") == 0)
+        {
+            target = &depth;
+        }
+        else if (strcmp(token, "nodes") == 0)
+        {
+            target = &nodes;
+        }
+        else if (strcmp(token, "movetime") == 0)
+        {
+            target = &moveTime;
+        }
+        else if (strcmp(token, "movestogo") == 0)
+        {
+            target = &movesToGo;
+        }
+        else if (strcmp(token, "wtime") == 0)
+        {
+            target = &times[TEAM_WHITE];
+        }
+        else if (strcmp(token, "btime") == 0)
+        {
+            target = &times[TEAM_BLACK];
+        }
+        else if (strcmp(token, "winc") == 0)
+        {
+            target = &increments[TEAM_WHITE];
+        }
+        else if (strcmp(token, "binc") == 0)
+        {
+            target = &increments[TEAM_BLACK];
+        }
+
+        // A negative clock (the GUI's latency ate it) still means "move now"
+        if (target != NULL && (value = NextToken(&args)) != NULL && !ParseInteger(value, -1000000000LL, 1000000000000LL, target))
+        {
+            Send("info string bad value for %s: %s", token, value);
+        }
+    }
+
+    int64_t budget = 0;
+    if (moveTime > 0)
+    {
+        budget = moveTime;
+    }
+    else if (times[Root.side] != 0 || increments[Root.side] > 0)
+    {
+        long long left = times[Root.side];
+        long long share = left / ((movesToGo > 0) ? movesToGo : UCI_MOVES_TO_GO) + increments[Root.side];
+
+        if (share > left / 2)
+        {
+            share = left / 2;
+        }
+        share -= UCI_MOVE_OVERHEAD_MS;
+        budget = (share > 1) ? share : 1;
+    }
+
+    Limits = (SearchLimits){.stop = &StopFlag};
+    if (!infinite)
+    {
+        Limits.depth = (depth > 0 && depth < MAX_SEARCH_PLY) ? (int)depth : 0;
+        Limits.nodes = (nodes > 0) ? (uint64_t)nodes : 0;
+        Limits.timeMs = ponder ? 0 : budget;
+    }
+    PonderBudgetMs = ponder ? budget : 0;
+
+    pthread_mutex_lock(&Lock);
+    Pondering = ponder;
+    Infinite = infinite;
+    SearchFinished = false;
+    TimerCancelled = false;
+    pthread_mutex_unlock(&Lock);
+    atomic_store(&StopFlag, false);
+
+    if (pthread_create(&SearchThread, NULL, SearchThreadMain, NULL) != 0)
+    {
+        Send("info string could not start the search thread");
+        Send("bestmove 0000");
+        return;
+    }
+    SearchRunning = true;
+}
+
+/**
+ * HandlePonderHit (static)
+ *
+ * The opponent played the expected move: the ponder search becomes the real one. A
+ * finished search sends its bestmove now; a running one gets the clock budget of the
+ * "go ponder" command from now on.
+ */
+static void HandlePonderHit(void)
+{
+    pthread_mutex_lock(&Lock);
+    bool wasPondering = Pondering;
+    bool finished = SearchFinished;
+    Pondering = false;
+    pthread_cond_broadcast(&Wake);
+    pthread_mutex_unlock(&Lock);
+
+    if (wasPondering && !finished && PonderBudgetMs > 0)
+    {
+        StartTimer(PonderBudgetMs);
+    }
+}
+
+/**
+ * StopAndWait (static)
+ *
+ * Stop the search (if any), let it send its bestmove and join it and the timer.
+ */
+static void StopAndWait(void)
+{
+    if (!SearchRunning)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&Lock);
+    atomic_store(&StopFlag, true);
+    TimerCancelled = true;
+    pthread_cond_broadcast(&Wake);
+    pthread_mutex_unlock(&Lock);
+
+    pthread_join(SearchThread, NULL);
+    SearchRunning = false;
+
+    if (TimerRunning)
+    {
+        pthread_join(TimerThread, NULL);
+        TimerRunning = false;
+    }
+}
+
+/**
+ * StartTimer (static)
+ *
+ * Start the timer thread: it raises the stop flag ms milliseconds from now unless the
+ * search is stopped first.
+ */
+static void StartTimer(int64_t ms)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    long long nanoseconds = (long long)now.tv_nsec + (ms % 1000) * 1000000LL;
+
+    pthread_mutex_lock(&Lock);
+    TimerDeadline.tv_sec = now.tv_sec + (time_t)(ms / 1000) + (time_t)(nanoseconds / 1000000000LL);
+    TimerDeadline.tv_nsec = (long)(nanoseconds % 1000000000LL);
+    pthread_mutex_unlock(&Lock);
+
+    if (pthread_create(&TimerThread, NULL, TimerMain, NULL) != 0)
+    {
+        // Without a timer the search still ends at its depth/node limit or on "stop"
+        Send("info string could not start the timer thread");
+        return;
+    }
+    TimerRunning = true;
+}
+
+/**
+ * SearchThreadMain (static)
+ *
+ * Body of the search thread: search Root, hold the result while pondering or searching
+ * infinitely, then send "bestmove <move> [ponder <move>]".
+ */
+static void *SearchThreadMain(void *arg)
+{
+    (void)arg;
+    SearchResult result;
+    bool found = Search(&UciEngine, &Root, RootHistory, RootHistoryCount, &Limits, &result);
+
+    pthread_mutex_lock(&Lock);
+    SearchFinished = true;
+    while ((Pondering || Infinite) && !atomic_load(&StopFlag))
+    {
+        pthread_cond_wait(&Wake, &Lock);
+    }
+    pthread_mutex_unlock(&Lock);
+
+    if (!found)
+    {
+        Send("bestmove 0000");
+        return NULL;
+    }
+
+    char best[MAX_UCI_MOVE_LENGTH];
+    char reply[MAX_UCI_MOVE_LENGTH];
+
+    MoveToUci(result.bestMove, best);
+    if (result.pvLength >= 2)
+    {
+        MoveToUci(result.pv[1], reply);
+        Send("bestmove %s ponder %s", best, reply);
+    }
+    else
+    {
+        Send("bestmove %s", best);
+    }
+
+    return NULL;
+}
+
+/**
+ * TimerMain (static)
+ *
+ * Body of the timer thread: wait for TimerDeadline, then raise the stop flag.
+ */
+static void *TimerMain(void *arg)
+{
+    (void)arg;
+
+    pthread_mutex_lock(&Lock);
+    while (!TimerCancelled)
+    {
+        if (pthread_cond_timedwait(&Wake, &Lock, &TimerDeadline) == ETIMEDOUT)
+        {
+            atomic_store(&StopFlag, true);
+            pthread_cond_broadcast(&Wake);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&Lock);
+
+    return NULL;
+}
+
+/**
+ * PrintInfo (static)
+ *
+ * Search callback: "info depth .. score cp|mate .. nodes .. nps .. time .. pv ..".
+ */
+static void PrintInfo(const SearchResult *result, void *userData)
+{
+    (void)userData;
+    char line[UCI_MAX_OUTPUT];
+    char score[32];
+    long long ms = (long long)(result->seconds * 1000.0);
+
+    if (result->score > MATE_BOUND)
+    {
+        snprintf(score, sizeof score, "mate %d", (MATE_SCORE - result->score + 1) / 2);
+    }
+    else if (result->score < -MATE_BOUND)
+    {
+        snprintf(score, sizeof score, "mate -%d", (MATE_SCORE + result->score) / 2);
+    }
+    else
+    {
+        snprintf(score, sizeof score, "cp %d", result->score);
+    }
+
+    int length = snprintf(line, sizeof line, "info depth %d score %s nodes %llu nps %llu time %lld pv", result->depth, score,
+                          (unsigned long long)result->nodes,
+                          (unsigned long long)(result->seconds > 0 ? (double)result->nodes / result->seconds : 0.0), ms);
+
+    for (int i = 0; i < result->pvLength && length + MAX_UCI_MOVE_LENGTH < (int)sizeof line; i++)
+    {
+        char move[MAX_UCI_MOVE_LENGTH];
+
+        MoveToUci(result->pv[i], move);
+        length += snprintf(line + length, sizeof line - (size_t)length, " %s", move);
+    }
+
+    Send("%s", line);
+}
+
+/**
+ * ParseInteger (static)
+ *
+ * Parse a whole decimal number in min..max.
+ */
+static bool ParseInteger(const char *text, long long min, long long max, long long *value)
+{
+    char *end = NULL;
+    long long parsed = strtoll(text, &end, 10);
+
+    if (end == text || *end != '\0' || parsed < min || parsed > max)
+    {
+        return false;
+    }
+
+    *value = parsed;
+    return true;
+}
+
+/**
+ * NamesEqual (static)
+ *
+ * Case-insensitive comparison of option names.
+ */
+static bool NamesEqual(const char *a, const char *b)
+{
+    while (*a != '\0' && tolower((unsigned char)*a) == tolower((unsigned char)*b))
+    {
+        a++;
+        b++;
+    }
+    return *a == '\0' && *b == '\0';
+}
+
+/**
+ * NextToken (static)
+ *
+ * Split the next whitespace-separated token off *cursor, in place.
+ *
+ * Returns:
+ *  - The token (terminated), or NULL when the line is used up.
+ */
+static char *NextToken(char **cursor)
+{
+    char *start = *cursor;
+
+    while (*start == ' ' || *start == '\t')
+    {
+        start++;
+    }
+    if (*start == '\0')
+    {
+        *cursor = start;
+        return NULL;
+    }
+
+    char *end = start;
+    while (*end != '\0' && *end != ' ' && *end != '\t')
+    {
+        end++;
+    }
+
+    *cursor = (*end != '\0') ? end + 1 : end;
+    *end = '\0';
+    return start;
+}
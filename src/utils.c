@@ -3,104 +3,146 @@
  *
  * Responsibilities:
  * - Provide high-level game management utilities.
- * - Handle game restarts and loading specific game states from FEN strings.
+ * - Handle game restarts and loading specific game states from FEN strings or recorded
+ *   games (start position plus moves).
  * - Coordinate the resetting of various subsystems (board, stacks, visuals, flags)
  *   during state transitions.
+ * - Create and destroy GameState instances (InitializeGame/FreeGame).
+ *
+ * Notes:
+ * - Every function works on the game it is passed. Only a game with isOnScreen set (the
+ *   GUI's state) cancels the background analysis and resets the highlights on a reset.
  */
 
+#define NO_GLOBAL_GAME_STATE
+
 #include "utils.h"
+#include "analysis.h"
 #include "draw.h"
+#include "hash.h"
+#include "history.h"
 #include "load.h"
 #include "main.h"
 #include "move.h"
+#include "position.h"
+#include "raylib.h"
 #include "settings.h"
 #include "stack.h"
 #include <stdbool.h>
 #include <stddef.h>
-#include <stdlib.h> // For malloc/free
 #include <string.h>
 
+// Local prototypes
+static void ResetGame(GameState *game, const Position *position);
+
+/**
+ * InitializeGame
+ *
+ * Sets up a game at the standard starting position.
+ *
+ * Parameters:
+ *  - game: the GameState to initialize (its previous contents are ignored).
+ *
+ * Returns:
+ *  - true on success; false if memory runs out (game is then left freed, as after FreeGame).
+ *
+ * Behavior:
+ *  - Clears every field (so isOnScreen, vsEngine and the sounds start unset), lays out the
+ *    board cells and dead-piece slots, and allocates the repetition history, the
+ *    Undo/Redo stacks and the history checkpoints before calling RestartGame.
+ */
+bool InitializeGame(GameState *game)
+{
+    memset(game, 0, sizeof(*game));
+
+    InitializeBoard(game);
+    InitializeDeadPieces(game);
+
+    game->DHA = InitializeDHA(INITIAL_DYNAMIC_HASH_ARRAY_SIZE);
+    game->undoStack = InitializeStack(INITAL_UNDO_REDO_STACK_SIZE);
+    game->redoStack = InitializeStack(INITAL_UNDO_REDO_STACK_SIZE);
+    game->snapshots = InitializeSnapshots(INITIAL_HISTORY_SNAPSHOTS);
+
+    if (game->DHA == NULL || game->undoStack == NULL || game->redoStack == NULL || game->snapshots == NULL)
+    {
+        TraceLog(LOG_WARNING, "InitializeGame: out of memory");
+        FreeGame(game);
+        return false;
+    }
+
+    RestartGame(game);
+    return true;
+}
+
+/**
+ * FreeGame
+ *
+ * Releases the memory a game from InitializeGame owns and empties its board. Safe to call
+ * twice; the sounds belong to the caller that loaded them.
+ */
+void FreeGame(GameState *game)
+{
+    UnloadBoard(game);
+
+    FreeDHA(game->DHA);
+    FreeStack(game->undoStack);
+    FreeStack(game->redoStack);
+    FreeSnapshots(game->snapshots);
+
+    game->DHA = NULL;
+    game->undoStack = NULL;
+    game->redoStack = NULL;
+    game->snapshots = NULL;
+}
+
 /**
  * LoadGameFromFEN
  *
  * Resets the entire game state and initializes the board based on a FEN string.
  *
  * Parameters:
- *  - fen: A null-terminated string containing the FEN record to load.
- *         If NULL, behavior is undefined (though likely safe due to checks in ReadFEN).
+ *  - fen: A null-terminated string containing the FEN record to load (read in place).
  *
  * Behavior:
- * 1. Resets meta-game flags (Checkmate, Stalemate, Promotion, etc.).
- * 2. Clears Undo/Redo history stacks.
- * 3. Resets dead piece counters and arrays.
- * 4. Resets visual state (highlights, selections).
- * 5. Unloads current textures and clears the board.
- * 6. Parses the FEN string to populate the board and game state (Turn, Castling, etc.).
- * 7. Runs initial validation (ResetsAndValidations) to calculate legal moves for the loaded state.
- *
- * Notes:
- * - Temporarily flips the turn before calling ResetsAndValidations because that function
- *   expects to flip the turn *before* calculating moves for the new player.
+ * 1. Parses the FEN string into a Position; if it is NULL or invalid, a warning is logged
+ *    and the current game is left untouched.
+ * 2. Resets the game and loads the position (ResetGame).
+ * 3. Runs initial validation (ResetsAndValidations) to calculate legal moves for the loaded state.
  */
-void LoadGameFromFEN(const char *fen)
+void LoadGameFromFEN(GameState *game, const char *fen)
 {
-    // 1. Reset Meta-Game Flags
-    state.isCheckmate = false;
-    state.isStalemate = false;
-    state.isRepeated3times = false;
-    state.isInsufficientMaterial = false;
-
-    state.isPromoting = false;
-    state.promotionRow = -1;
-    state.promotionCol = -1;
-    state.promotionType = PIECE_NONE;
-
-    state.whitePlayer.Checked = false;
-    state.whitePlayer.Checkmated = false;
-    state.whitePlayer.SimChecked = false;
-
-    state.blackPlayer.Checked = false;
-    state.blackPlayer.Checkmated = false;
-    state.blackPlayer.SimChecked = false;
-
-    // 2. Clear History Stacks
-    ClearStack(state.undoStack);
-    ClearStack(state.redoStack);
-
-    // 3. Reset Dead Pieces
-    deadWhiteCounter = 0;
-    deadBlackCounter = 0;
-    InitializeDeadPieces();
-
-    // 4. Reset Visuals
-    ResetJustMoved();
-    UpdateLastMoveHighlight(-1, -1);
-    ResetSelectedPiece();
-
-    UnloadBoard();
-
-    // 5. Reload Board
-    // We make a copy because ReadFEN might modify the string or expects char*
-    if (fen)
+    Position position;
+
+    // 1. Parse first so a bad record cannot leave a half-reset game behind
+    if (!PositionFromFEN(&position, fen))
     {
-        size_t len = strlen(fen);
-        char *fenCopy = (char *)malloc(len + 1);
-        if (fenCopy)
-        {
-            strcpy(fenCopy, fen);
-            ReadFEN(fenCopy, len, false);
-            free(fenCopy);
-
-            // Adjust Turn because ResetsAndValidations flips it.
-            // We want ResetsAndValidations to calculate moves for the CURRENT turn in FEN.
-            // Since it flips the turn at the start, we must set it to the OPPONENT first.
-            Turn = (Turn == TEAM_WHITE) ? TEAM_BLACK : TEAM_WHITE;
-            state.turn = Turn;
-        }
+        TraceLog(LOG_WARNING, "LoadGameFromFEN: invalid FEN, game left unchanged");
+        return;
     }
 
-    // 6. Initial Validation
-    ResetsAndValidations();
+    ResetGame(game, &position);
+
+    ResetsAndValidations(game);
+}
+
+/**
+ * LoadGameFromHistory
+ *
+ * Resets the game state to a recorded game (e.g. one from the game database) and moves
+ * to one of its positions.
+ *
+ * Parameters:
+ *  - start: position before the first move.
+ *  - moves: the count moves of the game, legal in sequence from start.
+ *  - ply:   number of moves to play (clamped to 0..count); Undo goes back towards start,
+ *           Redo forward through the rest of the game.
+ */
+void LoadGameFromHistory(GameState *game, const Position *start, const ChessMove *moves, int count, int ply)
+{
+    ply = (ply < 0) ? 0 : (ply > count) ? count : ply;
+
+    ResetGame(game, start);
+    ReplayHistory(game, moves, count, ply);
 }
 
 /**
@@ -111,7 +153,90 @@ void LoadGameFromFEN(const char *fen)
  * Behavior:
  * - Calls LoadGameFromFEN with the standard start FEN string defined in settings.h.
  */
-void RestartGame(void)
+void RestartGame(GameState *game)
+{
+    LoadGameFromFEN(game, STARTING_FEN);
+}
+
+/**
+ * IsGameOver
+ *
+ * Returns:
+ *  - true if the game ended by checkmate, stalemate, threefold repetition, insufficient
+ *    material or the fifty-move rule.
+ */
+bool IsGameOver(GameState *game)
 {
-    LoadGameFromFEN(STARTING_FEN);
+    return game->isCheckmate ||
+           game->isStalemate ||
+           game->isRepeated3times ||
+           game->isInsufficientMaterial ||
+           (game->halfMoveClock >= 100);
+}
+
+/**
+ * ResetGame (static)
+ *
+ * Shared reset of LoadGameFromFEN and LoadGameFromHistory; the rule checks are left to
+ * the caller.
+ *
+ * Behavior:
+ * 1. Tells a background analysis of the previous position to stop (without waiting).
+ * 2. Resets meta-game flags (Checkmate, Stalemate, Promotion, etc.).
+ * 3. Clears Undo/Redo history stacks.
+ * 4. Resets dead piece counters and arrays.
+ * 5. Resets visual state (highlights, selections).
+ * 6. Clears the board and loads position (LoadPosition).
+ * 7. Restarts the history checkpoints from position.
+ */
+static void ResetGame(GameState *game, const Position *position)
+{
+    if (game->isOnScreen)
+    {
+        CancelAnalysis();
+    }
+
+    // 2. Reset Meta-Game Flags
+    game->isCheckmate = false;
+    game->isStalemate = false;
+    game->isRepeated3times = false;
+    game->isInsufficientMaterial = false;
+
+    game->isPromoting = false;
+    game->promotionRow = -1;
+    game->promotionCol = -1;
+    game->promotionType = PIECE_NONE;
+
+    game->whitePlayer.Checked = false;
+    game->whitePlayer.Checkmated = false;
+
+    game->blackPlayer.Checked = false;
+    game->blackPlayer.Checkmated = false;
+
+    // 3. Clear History Stacks
+    ClearStack(game->undoStack);
+    ClearStack(game->redoStack);
+
+    // 4. Reset Dead Pieces
+    game->deadWhiteCounter = 0;
+    game->deadBlackCounter = 0;
+    InitializeDeadPieces(game);
+
+    // 5. Reset Visuals
+    if (game->isOnScreen)
+    {
+        UpdateLastMoveHighlight(-1, -1);
+        ResetSelectedPiece();
+    }
+
+    // 6. Reload Board
+    UnloadBoard(game);
+    LoadPosition(game, position);
+
+    // 7. Checkpoint of ply 0 (JumpToPly restores the start position from it)
+    if (game->snapshots != NULL)
+    {
+        ClearSnapshots(game->snapshots);
+        RecordSnapshot(game->snapshots, 0, position, 0, 0);
+    }
 }
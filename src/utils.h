@@ -3,15 +3,34 @@
  *
  * Responsibilities:
  * - Export high-level game management functions.
+ * - Export the constructor/destructor of a GameState (any number of games may exist).
  */
 
 #ifndef UTILS_H
 #define UTILS_H
 
+#include "movegen.h"
+#include "position.h"
+#include <stdbool.h>
+
+typedef struct GameState GameState;
+
+/* Sets up game at the starting position (allocates its history). Returns false if memory runs out */
+bool InitializeGame(GameState *game);
+
+/* Releases what InitializeGame allocated */
+void FreeGame(GameState *game);
+
 /* Resets the game to the standard starting position */
-void RestartGame(void);
+void RestartGame(GameState *game);
 
 /* Helper to reset state and load a specific FEN */
-void LoadGameFromFEN(const char *fen);
+void LoadGameFromFEN(GameState *game, const char *fen);
+
+/* Resets state to a recorded game and plays its first ply moves (the rest stay on the Redo stack) */
+void LoadGameFromHistory(GameState *game, const Position *start, const ChessMove *moves, int count, int ply);
+
+/* Returns true once the game has ended (mate, stalemate or any draw rule) */
+bool IsGameOver(GameState *game);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,162 @@
+/**
+ * zobrist.c
+ *
+ * Responsibilities:
+ * - Generate the Zobrist key tables.
+ * - Compute full position keys (used when a position is loaded from FEN).
+ *
+ * Implementation Details:
+ * - Keys come from a fixed-seed xorshift64* generator, so a position always hashes to the
+ *   same value across runs (handy when comparing logs or saved keys).
+ * - PIECE_NONE entries are left at zero so XORing an empty square is a no-op.
+ */
+
+#include "zobrist.h"
+#include "bitboard.h"
+#include "piece.h"
+#include "settings.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Fixed seed so every run produces the same keys */
+#define ZOBRIST_SEED 0x9E3779B97F4A7C15ULL
+
+uint64_t ZobristPieceKeys[TEAM_COUNT][PIECE_TYPE_COUNT][SQUARE_COUNT];
+uint64_t ZobristCastlingKeys[CASTLING_RIGHTS_COUNT];
+uint64_t ZobristEnPassantKeys[BOARD_SIZE];
+uint64_t ZobristSideKey;
+
+// Local prototypes
+static uint64_t NextRandom(uint64_t *seed);
+
+/**
+ * InitZobrist
+ *
+ * Fill every key table. Must run once before any key is computed (main() does it at startup).
+ *
+ * Behavior:
+ *  - One random key per (team, piece type, square), skipping PIECE_NONE.
+ *  - One key per individual castling right; ZobristCastlingKeys[mask] is the XOR of the
+ *    keys of the rights set in mask, so losing one right changes exactly one term.
+ *  - One key per en passant file and one for "Black to move".
+ */
+void InitZobrist(void)
+{
+    uint64_t seed = ZOBRIST_SEED;
+
+    for (int team = 0; team < TEAM_COUNT; team++)
+    {
+        for (int type = PIECE_KING; type < PIECE_TYPE_COUNT; type++)
+        {
+            for (int square = 0; square < SQUARE_COUNT; square++)
+            {
+                ZobristPieceKeys[team][type][square] = NextRandom(&seed);
+            }
+        }
+    }
+
+    uint64_t rightKeys[4];
+    for (int i = 0; i < 4; i++)
+    {
+        rightKeys[i] = NextRandom(&seed);
+    }
+
+    for (int mask = 0; mask < CASTLING_RIGHTS_COUNT; mask++)
+    {
+        ZobristCastlingKeys[mask] = 0;
+        for (int i = 0; i < 4; i++)
+        {
+            if (mask & (1 << i))
+            {
+                ZobristCastlingKeys[mask] ^= rightKeys[i];
+            }
+        }
+    }
+
+    for (int col = 0; col < BOARD_SIZE; col++)
+    {
+        ZobristEnPassantKeys[col] = NextRandom(&seed);
+    }
+
+    ZobristSideKey = NextRandom(&seed);
+}
+
+/**
+ * CastlingRightsMask
+ *
+ * Returns:
+ *  - The CASTLE_* bits of the rights that are still available.
+ */
+int CastlingRightsMask(bool whiteKingSide, bool whiteQueenSide, bool blackKingSide, bool blackQueenSide)
+{
+    return (whiteKingSide ? CASTLE_WHITE_KING_SIDE : 0) |
+           (whiteQueenSide ? CASTLE_WHITE_QUEEN_SIDE : 0) |
+           (blackKingSide ? CASTLE_BLACK_KING_SIDE : 0) |
+           (blackQueenSide ? CASTLE_BLACK_QUEEN_SIDE : 0);
+}
+
+/**
+ * ZobristRightsKey
+ *
+ * The part of a key that depends on castling rights and the en passant file.
+ *
+ * Parameters:
+ *  - castlingRights: CASTLE_* mask
+ *  - enPassantCol:   file of the pawn that just moved two squares, or -1
+ */
+uint64_t ZobristRightsKey(int castlingRights, int enPassantCol)
+{
+    uint64_t key = ZobristCastlingKeys[castlingRights & (CASTLING_RIGHTS_COUNT - 1)];
+
+    if (enPassantCol >= 0 && enPassantCol < BOARD_SIZE)
+    {
+        key ^= ZobristEnPassantKeys[enPassantCol];
+    }
+
+    return key;
+}
+
+/**
+ * ComputeZobristKey
+ *
+ * Build a key from scratch by visiting every piece on the bitboards.
+ *
+ * Returns:
+ *  - The key that incremental updates must reproduce for the same position.
+ */
+uint64_t ComputeZobristKey(const Bitboards *bb, Team side, int castlingRights, int enPassantCol)
+{
+    uint64_t key = ZobristRightsKey(castlingRights, enPassantCol);
+
+    for (int team = 0; team < TEAM_COUNT; team++)
+    {
+        for (int type = PIECE_KING; type < PIECE_TYPE_COUNT; type++)
+        {
+            Bitboard pieces = bb->pieces[team][type];
+            while (pieces)
+            {
+                key ^= ZobristPieceKeys[team][type][PopLowestSquare(&pieces)];
+            }
+        }
+    }
+
+    if (side == TEAM_BLACK)
+    {
+        key ^= ZobristSideKey;
+    }
+
+    return key;
+}
+
+/**
+ * NextRandom (static)
+ *
+ * xorshift64* step.
+ */
+static uint64_t NextRandom(uint64_t *seed)
+{
+    *seed ^= *seed >> 12;
+    *seed ^= *seed << 25;
+    *seed ^= *seed >> 27;
+    return *seed * 0x2545F4914F6CDD1DULL;
+}
@@ -0,0 +1,49 @@
+/**
+ * zobrist.h
+ *
+ * Responsibilities:
+ * - Export the Zobrist key tables (piece/square, castling rights, en passant file, side to move).
+ * - Export helpers to build a position key from scratch.
+ *
+ * Notes:
+ * - A position key is the XOR of one table entry per piece on its square, the entry for the
+ *   current castling rights, the en passant file (if any) and ZobristSideKey when Black is to move.
+ * - Because XOR is its own inverse, moving a piece is two XORs; GameState.zobristKey is kept
+ *   up to date this way instead of being recomputed after every move.
+ * - This module does not include raylib.
+ */
+
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include "bitboard.h"
+#include "piece.h"
+#include "settings.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Castling rights packed as a 4-bit mask (index into ZobristCastlingKeys) */
+#define CASTLE_WHITE_KING_SIDE 1
+#define CASTLE_WHITE_QUEEN_SIDE 2
+#define CASTLE_BLACK_KING_SIDE 4
+#define CASTLE_BLACK_QUEEN_SIDE 8
+#define CASTLING_RIGHTS_COUNT 16
+
+extern uint64_t ZobristPieceKeys[TEAM_COUNT][PIECE_TYPE_COUNT][SQUARE_COUNT];
+extern uint64_t ZobristCastlingKeys[CASTLING_RIGHTS_COUNT];
+extern uint64_t ZobristEnPassantKeys[BOARD_SIZE];
+extern uint64_t ZobristSideKey;
+
+/* Fills the key tables from a fixed seed. Call once at startup */
+void InitZobrist(void);
+
+/* Packs the four castling flags into a CASTLE_* mask */
+int CastlingRightsMask(bool whiteKingSide, bool whiteQueenSide, bool blackKingSide, bool blackQueenSide);
+
+/* Castling + en passant part of a key (enPassantCol == -1 means no en passant file) */
+uint64_t ZobristRightsKey(int castlingRights, int enPassantCol);
+
+/* Full key of a position, computed from scratch */
+uint64_t ComputeZobristKey(const Bitboards *bb, Team side, int castlingRights, int enPassantCol);
+
+#endif /* ZOBRIST_H */